@@ -71,6 +71,7 @@ class GComponent:
 
     def newpin(self, *a, **kw): return GPin(_hal.component.newpin(self.comp, *a, **kw))
     def getpin(self, *a, **kw): return GPin(_hal.component.getpin(self.comp, *a, **kw))
+    def newgroup(self, *a, **kw): return _hal.component.newgroup(self.comp, *a, **kw)
 
     def exit(self, *a, **kw): return self.comp.exit(*a, **kw)
 
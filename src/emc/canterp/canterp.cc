@@ -47,6 +47,11 @@
   which typically come out of one of Tom Kramer's interpreters.
   The first two columns are ignored, the rest is converted to
   equivalent canonical calls.
+
+  It also replays the binary recordings of canonical calls that
+  'rs274 -R' and [TASK]CANON_RECORD make (see canon_record.hh).  Those
+  carry every argument exactly as the interpreter made it, line numbers
+  included, and are read straight from the mapped file.
 */
 
 #include <stdio.h>		// FILE, fopen(), fclose()
@@ -57,6 +62,7 @@
 #include "config.h"
 #include "emc/nml_intf/interp_return.hh"
 #include "emc/nml_intf/canon.hh"
+#include "emc/nml_intf/canon_record.hh"
 #include "emc/rs274ngc/interp_base.hh"
 #include "modal_state.hh"
 
@@ -66,7 +72,7 @@ static char the_command_args[LINELEN] = { 0 };	// just the args part
 
 class Canterp : public InterpBase {
 public:
-    Canterp () : f(0) {}
+    Canterp () : f(0), replaying(false) {}
     char *error_text(int errcode, char *buf, size_t buflen);
     char *stack_name(int index, char *buf, size_t buflen);
     char *line_text(char *buf, size_t buflen);
@@ -103,6 +109,8 @@ public:
     void set_loop_on_main_m99(bool state);
     FILE *f;
     char filename[PATH_MAX];
+    CanonReplay replay;
+    bool replaying;		// the last read() was of a recorded call
 };
 
 char *Canterp::error_text(int errcode, char *buf, size_t buflen) {
@@ -243,16 +251,355 @@ static int canterp_parse(char *buffer)
 }
 
 int Canterp::read(const char *line) {
+    replaying = false;
     return canterp_parse((char *) line);
 }
 
 int Canterp::read() {
     char buf[LINELEN];
+    if(replay.is_open()) {
+	int res = replay.next();
+	replaying = res > 0;
+	if(res < 0) return INTERP_ERROR;
+	return res ? INTERP_OK : INTERP_ENDFILE;
+    }
     if(!f) return INTERP_ERROR;
     if(!fgets(buf, sizeof(buf), f)) return INTERP_ENDFILE;
     return canterp_parse(buf);
 }
 
+/*
+  Make the canonical call of a recorded record.  The argument counts are
+  checked against what each call takes, but not the values.
+ */
+static int canterp_replay(CanonReplay const &replay)
+{
+    CanonRecordHeader const &h = replay.header();
+    const double *d = replay.doubles();
+    const int32_t *i = replay.ints();
+    int ln = h.line_number;
+    char s1[LINELEN];
+
+#define ARGS(nd, ni) \
+    if (h.ndoubles != (nd) || h.nints != (ni)) return INTERP_ERROR
+
+    switch (h.op) {
+    case CANON_REC_INIT_CANON:
+	INIT_CANON();
+	break;
+    case CANON_REC_SET_G5X_OFFSET:
+	ARGS(9, 1);
+	SET_G5X_OFFSET(i[0], d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8]);
+	break;
+    case CANON_REC_SET_G92_OFFSET:
+	ARGS(9, 0);
+	SET_G92_OFFSET(d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8]);
+	break;
+    case CANON_REC_SET_XY_ROTATION:
+	ARGS(1, 0);
+	SET_XY_ROTATION(d[0]);
+	break;
+    case CANON_REC_USE_LENGTH_UNITS:
+	ARGS(0, 1);
+	USE_LENGTH_UNITS((CANON_UNITS) i[0]);
+	break;
+    case CANON_REC_SELECT_PLANE:
+	ARGS(0, 1);
+	SELECT_PLANE((CANON_PLANE) i[0]);
+	break;
+    case CANON_REC_SET_TRAVERSE_RATE:
+	ARGS(1, 0);
+	SET_TRAVERSE_RATE(d[0]);
+	break;
+    case CANON_REC_STRAIGHT_TRAVERSE:
+	ARGS(9, 0);
+	STRAIGHT_TRAVERSE(ln, d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8]);
+	break;
+    case CANON_REC_SET_FEED_RATE:
+	ARGS(1, 0);
+	SET_FEED_RATE(d[0]);
+	break;
+    case CANON_REC_SET_FEED_REFERENCE:
+	ARGS(0, 1);
+	SET_FEED_REFERENCE((CANON_FEED_REFERENCE) i[0]);
+	break;
+    case CANON_REC_SET_FEED_MODE:
+	ARGS(0, 2);
+	SET_FEED_MODE(i[0], i[1]);
+	break;
+    case CANON_REC_SET_MOTION_CONTROL_MODE:
+	ARGS(1, 1);
+	SET_MOTION_CONTROL_MODE((CANON_MOTION_MODE) i[0], d[0]);
+	break;
+    case CANON_REC_SET_NAIVECAM_TOLERANCE:
+	ARGS(1, 0);
+	SET_NAIVECAM_TOLERANCE(d[0]);
+	break;
+    case CANON_REC_START_SPEED_FEED_SYNCH:
+	ARGS(1, 2);
+	START_SPEED_FEED_SYNCH(i[0], d[0], i[1]);
+	break;
+    case CANON_REC_STOP_SPEED_FEED_SYNCH:
+	STOP_SPEED_FEED_SYNCH();
+	break;
+    case CANON_REC_ARC_FEED:
+	ARGS(11, 1);
+	ARC_FEED(ln, d[0], d[1], d[2], d[3], i[0], d[4],
+		d[5], d[6], d[7], d[8], d[9], d[10]);
+	break;
+    case CANON_REC_STRAIGHT_FEED:
+	ARGS(9, 0);
+	STRAIGHT_FEED(ln, d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8]);
+	break;
+    case CANON_REC_NURBS_FEED: {
+	std::vector<CONTROL_POINT> points(h.ndoubles / 3);
+	if (h.ndoubles % 3 || h.nints != 1) return INTERP_ERROR;
+	for (size_t n = 0; n < points.size(); n++) {
+	    points[n].X = d[3 * n];
+	    points[n].Y = d[3 * n + 1];
+	    points[n].W = d[3 * n + 2];
+	}
+	NURBS_FEED(ln, points, i[0]);
+	break;
+    }
+    case CANON_REC_RIGID_TAP:
+	ARGS(4, 0);
+	RIGID_TAP(ln, d[0], d[1], d[2], d[3]);
+	break;
+    case CANON_REC_STRAIGHT_PROBE:
+	ARGS(9, 1);
+	STRAIGHT_PROBE(ln, d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8],
+		i[0]);
+	break;
+    case CANON_REC_DWELL:
+	ARGS(1, 0);
+	DWELL(d[0]);
+	break;
+    case CANON_REC_SET_SPINDLE_MODE:
+	ARGS(1, 1);
+	SET_SPINDLE_MODE(i[0], d[0]);
+	break;
+    case CANON_REC_START_SPINDLE_CLOCKWISE:
+	ARGS(0, 2);
+	START_SPINDLE_CLOCKWISE(i[0], i[1]);
+	break;
+    case CANON_REC_START_SPINDLE_COUNTERCLOCKWISE:
+	ARGS(0, 2);
+	START_SPINDLE_COUNTERCLOCKWISE(i[0], i[1]);
+	break;
+    case CANON_REC_SET_SPINDLE_SPEED:
+	ARGS(1, 1);
+	SET_SPINDLE_SPEED(i[0], d[0]);
+	break;
+    case CANON_REC_STOP_SPINDLE_TURNING:
+	ARGS(0, 1);
+	STOP_SPINDLE_TURNING(i[0]);
+	break;
+    case CANON_REC_ORIENT_SPINDLE:
+	ARGS(1, 2);
+	ORIENT_SPINDLE(i[0], d[0], i[1]);
+	break;
+    case CANON_REC_WAIT_SPINDLE_ORIENT_COMPLETE:
+	ARGS(1, 1);
+	WAIT_SPINDLE_ORIENT_COMPLETE(i[0], d[0]);
+	break;
+    case CANON_REC_USE_TOOL_LENGTH_OFFSET: {
+	EmcPose offset;
+	ARGS(9, 0);
+	offset.tran.x = d[0];
+	offset.tran.y = d[1];
+	offset.tran.z = d[2];
+	offset.a = d[3];
+	offset.b = d[4];
+	offset.c = d[5];
+	offset.u = d[6];
+	offset.v = d[7];
+	offset.w = d[8];
+	USE_TOOL_LENGTH_OFFSET(offset);
+	break;
+    }
+    case CANON_REC_START_CHANGE:
+	START_CHANGE();
+	break;
+    case CANON_REC_CHANGE_TOOL:
+	ARGS(0, 1);
+	CHANGE_TOOL(i[0]);
+	break;
+    case CANON_REC_SELECT_TOOL:
+	ARGS(0, 1);
+	SELECT_TOOL(i[0]);
+	break;
+    case CANON_REC_CHANGE_TOOL_NUMBER:
+	ARGS(0, 1);
+	CHANGE_TOOL_NUMBER(i[0]);
+	break;
+    case CANON_REC_COMMENT:
+	COMMENT(replay.string());
+	break;
+    case CANON_REC_MESSAGE:
+	// MESSAGE() may write to its argument, and the recording is read only
+	snprintf(s1, sizeof(s1), "%s", replay.string());
+	MESSAGE(s1);
+	break;
+    case CANON_REC_DISABLE_FEED_OVERRIDE:
+	DISABLE_FEED_OVERRIDE();
+	break;
+    case CANON_REC_ENABLE_FEED_OVERRIDE:
+	ENABLE_FEED_OVERRIDE();
+	break;
+    case CANON_REC_DISABLE_SPEED_OVERRIDE:
+	ARGS(0, 1);
+	DISABLE_SPEED_OVERRIDE(i[0]);
+	break;
+    case CANON_REC_ENABLE_SPEED_OVERRIDE:
+	ARGS(0, 1);
+	ENABLE_SPEED_OVERRIDE(i[0]);
+	break;
+    case CANON_REC_DISABLE_ADAPTIVE_FEED:
+	DISABLE_ADAPTIVE_FEED();
+	break;
+    case CANON_REC_ENABLE_ADAPTIVE_FEED:
+	ENABLE_ADAPTIVE_FEED();
+	break;
+    case CANON_REC_DISABLE_FEED_HOLD:
+	DISABLE_FEED_HOLD();
+	break;
+    case CANON_REC_ENABLE_FEED_HOLD:
+	ENABLE_FEED_HOLD();
+	break;
+    case CANON_REC_FLOOD_OFF:
+	FLOOD_OFF();
+	break;
+    case CANON_REC_FLOOD_ON:
+	FLOOD_ON();
+	break;
+    case CANON_REC_MIST_OFF:
+	MIST_OFF();
+	break;
+    case CANON_REC_MIST_ON:
+	MIST_ON();
+	break;
+    case CANON_REC_PALLET_SHUTTLE:
+	PALLET_SHUTTLE();
+	break;
+    case CANON_REC_TURN_PROBE_OFF:
+	TURN_PROBE_OFF();
+	break;
+    case CANON_REC_TURN_PROBE_ON:
+	TURN_PROBE_ON();
+	break;
+    case CANON_REC_SET_MOTION_OUTPUT_BIT:
+	ARGS(0, 1);
+	SET_MOTION_OUTPUT_BIT(i[0]);
+	break;
+    case CANON_REC_CLEAR_MOTION_OUTPUT_BIT:
+	ARGS(0, 1);
+	CLEAR_MOTION_OUTPUT_BIT(i[0]);
+	break;
+    case CANON_REC_SET_AUX_OUTPUT_BIT:
+	ARGS(0, 1);
+	SET_AUX_OUTPUT_BIT(i[0]);
+	break;
+    case CANON_REC_CLEAR_AUX_OUTPUT_BIT:
+	ARGS(0, 1);
+	CLEAR_AUX_OUTPUT_BIT(i[0]);
+	break;
+    case CANON_REC_SET_MOTION_OUTPUT_VALUE:
+	ARGS(1, 1);
+	SET_MOTION_OUTPUT_VALUE(i[0], d[0]);
+	break;
+    case CANON_REC_SET_AUX_OUTPUT_VALUE:
+	ARGS(1, 1);
+	SET_AUX_OUTPUT_VALUE(i[0], d[0]);
+	break;
+    case CANON_REC_PROGRAM_STOP:
+	PROGRAM_STOP();
+	break;
+    case CANON_REC_OPTIONAL_PROGRAM_STOP:
+	OPTIONAL_PROGRAM_STOP();
+	break;
+    case CANON_REC_PROGRAM_END:
+	PROGRAM_END();
+	break;
+    case CANON_REC_UPDATE_TAG: {
+	state_tag_t tag;
+	ARGS(GM_FIELD_FLOAT_MAX_FIELDS, GM_FIELD_MAX_FIELDS + 2);
+	for (int n = 0; n < GM_FIELD_FLOAT_MAX_FIELDS; n++) {
+	    tag.fields_float[n] = d[n];
+	}
+	for (int n = 0; n < GM_FIELD_MAX_FIELDS; n++) {
+	    tag.fields[n] = i[n];
+	}
+	tag.packed_flags = (uint32_t) i[GM_FIELD_MAX_FIELDS]
+	    | (unsigned long long) (uint32_t) i[GM_FIELD_MAX_FIELDS + 1] << 32;
+	UPDATE_TAG(StateTag(tag));
+	break;
+    }
+    case CANON_REC_WAIT:
+	ARGS(1, 3);
+	WAIT(i[0], i[1], i[2], d[0]);
+	break;
+    case CANON_REC_UNLOCK_ROTARY:
+	ARGS(0, 1);
+	UNLOCK_ROTARY(ln, i[0]);
+	break;
+    case CANON_REC_LOCK_ROTARY:
+	ARGS(0, 1);
+	LOCK_ROTARY(ln, i[0]);
+	break;
+    case CANON_REC_SET_TOOL_TABLE_ENTRY: {
+	EmcPose offset;
+	ARGS(12, 3);
+	offset.tran.x = d[0];
+	offset.tran.y = d[1];
+	offset.tran.z = d[2];
+	offset.a = d[3];
+	offset.b = d[4];
+	offset.c = d[5];
+	offset.u = d[6];
+	offset.v = d[7];
+	offset.w = d[8];
+	SET_TOOL_TABLE_ENTRY(i[0], i[1], offset, d[9], d[10], d[11], i[2]);
+	break;
+    }
+    case CANON_REC_USE_SPINDLE_FORCE:
+	USE_SPINDLE_FORCE();
+	break;
+    case CANON_REC_USE_NO_SPINDLE_FORCE:
+	USE_NO_SPINDLE_FORCE();
+	break;
+    case CANON_REC_SPINDLE_RETRACT:
+	SPINDLE_RETRACT();
+	break;
+    case CANON_REC_SPINDLE_RETRACT_TRAVERSE:
+	SPINDLE_RETRACT_TRAVERSE();
+	break;
+    case CANON_REC_PLUGIN_CALL:
+	// the call is a pickle and may hold nuls, so pass on its length
+	PLUGIN_CALL(h.nchars ? h.nchars - 1 : 0, replay.string());
+	break;
+    case CANON_REC_IO_PLUGIN_CALL:
+	IO_PLUGIN_CALL(h.nchars ? h.nchars - 1 : 0, replay.string());
+	break;
+    case CANON_REC_SET_BLOCK_DELETE:
+	ARGS(0, 1);
+	SET_BLOCK_DELETE(i[0]);
+	break;
+    case CANON_REC_SET_OPTIONAL_PROGRAM_STOP:
+	ARGS(0, 1);
+	SET_OPTIONAL_PROGRAM_STOP(i[0]);
+	break;
+    case CANON_REC_ON_RESET:
+	ON_RESET();
+	break;
+    default:
+	fprintf(stderr, "canterp: unrecognized recorded call %d\n", h.op);
+	return INTERP_ERROR;
+    }
+#undef ARGS
+    return INTERP_OK;
+}
+
 int Canterp::execute(const char *line) {
     int retval;
     double d1 = 0, d2 = 0, d3 = 0, d4 = 0, d5 = 0, d6 = 0, d7 = 0, d8 = 0, d9 = 0, d10 = 0, d11 = 0;
@@ -260,9 +607,12 @@ int Canterp::execute(const char *line) {
     char s1[256];
 
     if (line) {
+	replaying = false;
 	retval = canterp_parse((char *) line);
 	if (retval)
 	    return retval;
+    } else if (replaying) {
+	return canterp_replay(replay);
     }
 
     // a blank line
@@ -698,19 +1048,27 @@ int Canterp::execute() {
 
 int Canterp::open(const char *newfilename) {
     if(f) fclose(f);
+    f = 0;
+    replaying = false;
+    if(replay.open(newfilename) == 0) {
+	snprintf(filename, sizeof(filename), "%s", newfilename);
+	return INTERP_OK;
+    }
     f = fopen(newfilename, "r");
     if(f) snprintf(filename, sizeof(filename), "%s", newfilename);
     return f ? INTERP_OK : INTERP_ERROR;
 }
 
 int Canterp::close() {
+    replay.close();
+    replaying = false;
     return INTERP_OK;
 }
 
 int Canterp::exit() { return 0; }
 int Canterp::synch() { return 0; }
 int Canterp::reset() { return 0; }
-int Canterp::line() { return 0; }
+int Canterp::line() { return replaying ? replay.header().line_number : 0; }
 int Canterp::call_level() { return 0; }
 
 char *Canterp::line_text(char *buf, size_t bufsize) {
@@ -69,6 +69,7 @@
 #include "timer.hh"
 #include "rcs_print.hh"
 #include "tool_parse.h"
+#include "toolstore.hh"
 #include <rtapi_string.h>
 
 static RCS_CMD_CHANNEL *emcioCommandBuffer = 0;
@@ -78,6 +79,7 @@ static EMC_IO_STAT emcioStatus;
 static NML *emcErrorBuffer = 0;
 
 static char *ttcomments[CANON_POCKETS_MAX];
+static ToolIndexCache toolIndex;
 static int random_toolchanger = 0;
 
 
@@ -524,18 +526,10 @@ int read_hal_inputs(void)
 }
 
 void load_tool(int pocket) {
+    toolIndex.clear();
     if(random_toolchanger) {
         // swap the tools between the desired pocket and the spindle pocket
-        CANON_TOOL_TABLE temp;
-        char *comment_temp;
-
-        temp = emcioStatus.tool.toolTable[0];
-        emcioStatus.tool.toolTable[0] = emcioStatus.tool.toolTable[pocket];
-        emcioStatus.tool.toolTable[pocket] = temp;
-
-        comment_temp = ttcomments[0];
-        ttcomments[0] = ttcomments[pocket];
-        ttcomments[pocket] = comment_temp;
+        tool_table_swap(emcioStatus.tool.toolTable, ttcomments, 0, pocket);
 
         if (0 != saveToolTable(tool_table_file, emcioStatus.tool.toolTable, ttcomments, random_toolchanger))
             emcioStatus.status = RCS_ERROR;
@@ -550,17 +544,16 @@ void load_tool(int pocket) {
         emcioStatus.tool.toolTable[0].orientation = 0;
     } else {
         // just copy the desired tool to the spindle
-        emcioStatus.tool.toolTable[0] = emcioStatus.tool.toolTable[pocket];
+        emcioStatus.tool.toolTable[0] = tool_table_get(emcioStatus.tool.toolTable, pocket);
     }
 }
 
 void reload_tool_number(int toolno) {
     if(random_toolchanger) return; // doesn't need special handling here
-    for(int i=1; i<CANON_POCKETS_MAX; i++) {
-        if(emcioStatus.tool.toolTable[i].toolno == toolno) {
-            load_tool(i);
-            break;
-        }
+    toolIndex.clear(); // the table was just reloaded
+    int i = toolIndex.find_first(emcioStatus.tool.toolTable, toolno);
+    if (i > 0) {
+        load_tool(i);
     }
 }
 
@@ -593,7 +586,7 @@ int read_tool_inputs(void)
             emcioStatus.tool.toolInSpindle = 0;
         } else {
             // the tool now in the spindle is the one that was prepared
-            emcioStatus.tool.toolInSpindle = emcioStatus.tool.toolTable[emcioStatus.tool.pocketPrepped].toolno; 
+            emcioStatus.tool.toolInSpindle = tool_table_get(emcioStatus.tool.toolTable, emcioStatus.tool.pocketPrepped).toolno;
         }
 	*(iocontrol_data->tool_number) = emcioStatus.tool.toolInSpindle; //likewise in HAL
 	load_tool(emcioStatus.tool.pocketPrepped);
@@ -701,6 +694,7 @@ int main(int argc, char *argv[])
 		ttcomments, random_toolchanger)) {
 	rcs_print_error("can't load tool table.\n");
     }
+    toolIndex.clear();
 
     done = 0;
 
@@ -773,6 +767,7 @@ int main(int argc, char *argv[])
 	    rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_INIT\n");
 	    loadToolTable(tool_table_file, emcioStatus.tool.toolTable,
 		    ttcomments, random_toolchanger);
+	    toolIndex.clear();
 	    reload_tool_number(emcioStatus.tool.toolInSpindle);
 	    break;
 
@@ -794,22 +789,20 @@ int main(int argc, char *argv[])
 
 	case EMC_TOOL_PREPARE_TYPE:
             {
-                int p = 0;
                 int t = ((EMC_TOOL_PREPARE*)emcioCommand)->tool;
-                for(int i = 0;i < CANON_POCKETS_MAX;i++){
-                    if(emcioStatus.tool.toolTable[i].toolno == t)
-                        p = i;
-                }
+                int p = toolIndex.find_last(emcioStatus.tool.toolTable, t);
+                if (p < 0) p = 0;
+                CANON_TOOL_TABLE tool = tool_table_get(emcioStatus.tool.toolTable, p);
                 rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_PREPARE tool=%d pocket=%d\n", t, p);
 
                 // Set HAL pins/params for tool number, pocket, and index.
                 iocontrol_data->tool_prep_index = p;
-                *(iocontrol_data->tool_prep_pocket) = random_toolchanger? p: emcioStatus.tool.toolTable[p].pocketno;
+                *(iocontrol_data->tool_prep_pocket) = random_toolchanger? p: tool.pocketno;
                 if(!random_toolchanger && p == 0) {//unload spindle
                     *(iocontrol_data->tool_prep_number) = 0;
 					*(iocontrol_data->tool_prep_pocket) = 0;
                 } else {
-                    *(iocontrol_data->tool_prep_number) = emcioStatus.tool.toolTable[p].toolno;
+                    *(iocontrol_data->tool_prep_number) = tool.toolno;
                 }
 
                 // it doesn't make sense to prep the spindle pocket
@@ -837,7 +830,7 @@ int main(int argc, char *argv[])
 
             // it's not necessary to load the tool already in the spindle
             if (!random_toolchanger && emcioStatus.tool.pocketPrepped > 0 &&
-                emcioStatus.tool.toolInSpindle == emcioStatus.tool.toolTable[emcioStatus.tool.pocketPrepped].toolno) {
+                emcioStatus.tool.toolInSpindle == tool_table_get(emcioStatus.tool.toolTable, emcioStatus.tool.pocketPrepped).toolno) {
                 break;
             }
 
@@ -865,6 +858,7 @@ int main(int argc, char *argv[])
 		    ((EMC_TOOL_LOAD_TOOL_TABLE *) emcioCommand)->file;
 		if(!strlen(filename)) filename = tool_table_file;
 		rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_LOAD_TOOL_TABLE\n");
+		toolIndex.clear();
 		if (0 != loadToolTable(filename, emcioStatus.tool.toolTable,
 				  ttcomments, random_toolchanger))
 		    emcioStatus.status = RCS_ERROR;
@@ -892,16 +886,19 @@ int main(int argc, char *argv[])
                                 " frontangle=%lf, backangle=%lf, orientation=%d\n",
                                 p, t, offs.tran.z, offs.tran.x, d, f, b, o);
 
-                emcioStatus.tool.toolTable[p].toolno = t;
-                emcioStatus.tool.toolTable[p].offset = offs;
-                emcioStatus.tool.toolTable[p].diameter = d;
-                emcioStatus.tool.toolTable[p].frontangle = f;
-                emcioStatus.tool.toolTable[p].backangle = b;
-                emcioStatus.tool.toolTable[p].orientation = o;
+                toolIndex.clear();
+                CANON_TOOL_TABLE tool = tool_table_get(emcioStatus.tool.toolTable, p);
+                tool.toolno = t;
+                tool.offset = offs;
+                tool.diameter = d;
+                tool.frontangle = f;
+                tool.backangle = b;
+                tool.orientation = o;
+                tool_table_put(emcioStatus.tool.toolTable, p, tool);
 
                 if (emcioStatus.tool.toolInSpindle == t) {
-                    emcioStatus.tool.toolTable[0] = emcioStatus.tool.toolTable[p];
-                }                    
+                    emcioStatus.tool.toolTable[0] = tool;
+                }
             }
 	    if (0 != saveToolTable(tool_table_file, emcioStatus.tool.toolTable, ttcomments, random_toolchanger))
 		emcioStatus.status = RCS_ERROR;
@@ -912,9 +909,9 @@ int main(int argc, char *argv[])
 		int pocket_number;
 		
 		pocket_number = ((EMC_TOOL_SET_NUMBER *) emcioCommand)->tool;
-		rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_SET_NUMBER old_loaded_tool=%d new_pocket_number=%d new_tool=%d\n", emcioStatus.tool.toolInSpindle, pocket_number, emcioStatus.tool.toolTable[pocket_number].toolno);
+		rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_SET_NUMBER old_loaded_tool=%d new_pocket_number=%d new_tool=%d\n", emcioStatus.tool.toolInSpindle, pocket_number, tool_table_get(emcioStatus.tool.toolTable, pocket_number).toolno);
                 load_tool(pocket_number);
-		emcioStatus.tool.toolInSpindle = emcioStatus.tool.toolTable[pocket_number].toolno;
+		emcioStatus.tool.toolInSpindle = tool_table_get(emcioStatus.tool.toolTable, pocket_number).toolno;
 		*(iocontrol_data->tool_number) = emcioStatus.tool.toolInSpindle; //likewise in HAL
 	    }
 	    break;
@@ -70,6 +70,7 @@
 #include "timer.hh"
 #include "rcs_print.hh"
 #include "tool_parse.h"
+#include "toolstore.hh"
 #include <rtapi_string.h>
 
 static RCS_CMD_CHANNEL *emcioCommandBuffer = 0;
@@ -79,6 +80,7 @@ static EMC_IO_STAT emcioStatus;
 static NML *emcErrorBuffer = 0;
 
 static char *ttcomments[CANON_POCKETS_MAX];
+static ToolIndexCache toolIndex;
 static int random_toolchanger = 0;
 static int support_start_change = 0;
 static const char *progname;
@@ -493,18 +495,10 @@ void hal_init_pins(void)
 }
 
 void load_tool(int pocket) {
+    toolIndex.clear();
     if(random_toolchanger) {
 	// swap the tools between the desired pocket and the spindle pocket
-	CANON_TOOL_TABLE temp;
-	char *comment_temp;
-
-	temp = emcioStatus.tool.toolTable[0];
-	emcioStatus.tool.toolTable[0] = emcioStatus.tool.toolTable[pocket];
-	emcioStatus.tool.toolTable[pocket] = temp;
-
-	comment_temp = ttcomments[0];
-	ttcomments[0] = ttcomments[pocket];
-	ttcomments[pocket] = comment_temp;
+	tool_table_swap(emcioStatus.tool.toolTable, ttcomments, 0, pocket);
 
 	if (0 != saveToolTable(tool_table_file, emcioStatus.tool.toolTable, ttcomments, random_toolchanger))
 	    emcioStatus.status = RCS_ERROR;
@@ -518,17 +512,16 @@ void load_tool(int pocket) {
 	emcioStatus.tool.toolTable[0].orientation = 0;
     } else {
 	// just copy the desired tool to the spindle
-	emcioStatus.tool.toolTable[0] = emcioStatus.tool.toolTable[pocket];
+	emcioStatus.tool.toolTable[0] = tool_table_get(emcioStatus.tool.toolTable, pocket);
     }
 }
 
 void reload_tool_number(int toolno) {
     if(random_toolchanger) return; // doesn't need special handling here
-    for(int i=1; i<CANON_POCKETS_MAX; i++) {
-	if(emcioStatus.tool.toolTable[i].toolno == toolno) {
-	    load_tool(i);
-	    break;
-	}
+    toolIndex.clear(); // the table was just reloaded
+    int i = toolIndex.find_first(emcioStatus.tool.toolTable, toolno);
+    if (i > 0) {
+	load_tool(i);
     }
 }
 
@@ -686,7 +679,7 @@ int read_inputs(void)
 		emcioStatus.tool.toolInSpindle = 0;
 	    } else {
 		// the tool now in the spindle is the one that was prepared
-		emcioStatus.tool.toolInSpindle = emcioStatus.tool.toolTable[emcioStatus.tool.pocketPrepped].toolno;
+		emcioStatus.tool.toolInSpindle = tool_table_get(emcioStatus.tool.toolTable, emcioStatus.tool.pocketPrepped).toolno;
 	    }
 	    *(iocontrol_data->tool_number) = emcioStatus.tool.toolInSpindle; // likewise in HAL
 	    load_tool(emcioStatus.tool.pocketPrepped);
@@ -819,6 +812,7 @@ int main(int argc, char *argv[])
 			   ttcomments, random_toolchanger)) {
 	rcs_print_error("%s: can't load tool table.\n",progname);
     }
+    toolIndex.clear();
 
     done = 0;
 
@@ -920,6 +914,7 @@ int main(int argc, char *argv[])
 	    rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_INIT\n");
 	    loadToolTable(tool_table_file, emcioStatus.tool.toolTable,
 			  ttcomments, random_toolchanger);
+	    toolIndex.clear();
 	    reload_tool_number(emcioStatus.tool.toolInSpindle);
 	    break;
 
@@ -955,12 +950,10 @@ int main(int argc, char *argv[])
 
 	case EMC_TOOL_PREPARE_TYPE:
 	{
-        int p = 0;
 	    int t = ((EMC_TOOL_PREPARE*)emcioCommand)->tool;
-        for(int i = 0;i < CANON_POCKETS_MAX;i++){
-            if(emcioStatus.tool.toolTable[i].toolno == t)
-            p = i;
-		}
+	    int p = toolIndex.find_last(emcioStatus.tool.toolTable, t);
+	    if (p < 0) p = 0;
+	    CANON_TOOL_TABLE tool = tool_table_get(emcioStatus.tool.toolTable, p);
 	    rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_PREPARE tool=%d pocket=%d\n", t, p);
 
 	    // it doesn't make sense to prep the spindle pocket
@@ -969,15 +962,15 @@ int main(int argc, char *argv[])
 
 	    /* set tool number first */
             iocontrol_data->tool_prep_index = p;
-            *(iocontrol_data->tool_prep_pocket) = random_toolchanger? p: emcioStatus.tool.toolTable[p].pocketno;
+            *(iocontrol_data->tool_prep_pocket) = random_toolchanger? p: tool.pocketno;
 	    if (!random_toolchanger && p == 0) {
 			*(iocontrol_data->tool_prep_number) = 0;
 			*(iocontrol_data->tool_prep_pocket) = 0;
 	    } else {
-		*(iocontrol_data->tool_prep_number) = emcioStatus.tool.toolTable[p].toolno;
-		if (emcioStatus.tool.toolTable[p].toolno != t) // sanity check
+		*(iocontrol_data->tool_prep_number) = tool.toolno;
+		if (tool.toolno != t) // sanity check
 		    rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_PREPARE: mismatch: tooltable[%d]=%d, got %d\n", 
-				    p, emcioStatus.tool.toolTable[p].toolno, t);
+				    p, tool.toolno, t);
 	    }
 
 	    if ((proto > V1) && *(iocontrol_data->toolchanger_faulted)) { // informational
@@ -1006,7 +999,7 @@ int main(int argc, char *argv[])
 
 	    // it's not necessary to load the tool already in the spindle
 	    if (!random_toolchanger && emcioStatus.tool.pocketPrepped > 0 &&
-		emcioStatus.tool.toolInSpindle == emcioStatus.tool.toolTable[emcioStatus.tool.pocketPrepped].toolno) {
+		emcioStatus.tool.toolInSpindle == tool_table_get(emcioStatus.tool.toolTable, emcioStatus.tool.pocketPrepped).toolno) {
 		break;
 	    }
 
@@ -1046,6 +1039,7 @@ int main(int argc, char *argv[])
 		((EMC_TOOL_LOAD_TOOL_TABLE *) emcioCommand)->file;
 	    if (!strlen(filename)) filename = tool_table_file;
 	    rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_LOAD_TOOL_TABLE\n");
+	    toolIndex.clear();
 	    if (0 != loadToolTable(filename, emcioStatus.tool.toolTable,
 				   ttcomments, random_toolchanger))
 		emcioStatus.status = RCS_ERROR;
@@ -1073,15 +1067,18 @@ int main(int argc, char *argv[])
 			    " frontangle=%lf, backangle=%lf, orientation=%d\n",
 			    p, t, offs.tran.z, offs.tran.x, d, f, b, o);
 
-	    emcioStatus.tool.toolTable[p].toolno = t;
-	    emcioStatus.tool.toolTable[p].offset = offs;
-	    emcioStatus.tool.toolTable[p].diameter = d;
-	    emcioStatus.tool.toolTable[p].frontangle = f;
-	    emcioStatus.tool.toolTable[p].backangle = b;
-	    emcioStatus.tool.toolTable[p].orientation = o;
+	    toolIndex.clear();
+	    CANON_TOOL_TABLE tool = tool_table_get(emcioStatus.tool.toolTable, p);
+	    tool.toolno = t;
+	    tool.offset = offs;
+	    tool.diameter = d;
+	    tool.frontangle = f;
+	    tool.backangle = b;
+	    tool.orientation = o;
+	    tool_table_put(emcioStatus.tool.toolTable, p, tool);
 
 	    if (emcioStatus.tool.toolInSpindle == t) {
-		emcioStatus.tool.toolTable[0] = emcioStatus.tool.toolTable[p];
+		emcioStatus.tool.toolTable[0] = tool;
 	    }
 	}
 	if (0 != saveToolTable(tool_table_file, emcioStatus.tool.toolTable, ttcomments, random_toolchanger))
@@ -1097,8 +1094,8 @@ int main(int argc, char *argv[])
 	    number = ((EMC_TOOL_SET_NUMBER *) emcioCommand)->tool;
 	    rtapi_print_msg(RTAPI_MSG_DBG, "EMC_TOOL_SET_NUMBER pocket=%d old_loaded=%d new_number=%d\n",
 			    number, emcioStatus.tool.toolInSpindle,
-			    emcioStatus.tool.toolTable[number].toolno);
-	    emcioStatus.tool.toolInSpindle = emcioStatus.tool.toolTable[number].toolno;
+			    tool_table_get(emcioStatus.tool.toolTable, number).toolno);
+	    emcioStatus.tool.toolInSpindle = tool_table_get(emcioStatus.tool.toolTable, number).toolno;
 	    load_tool(number);
 	    *(iocontrol_data->tool_number) = emcioStatus.tool.toolInSpindle; //likewise in HAL
 	}
@@ -110,6 +110,7 @@
 #include "genhexkins.h"
 #include "kinematics.h"             /* these decls, KINEMATICS_FORWARD_FLAGS */
 #include "hal.h"
+#include "rtapi_string.h"
 
 struct haldata {
     hal_float_t basex[NUM_STRUTS];
@@ -300,12 +301,23 @@ int StrutLengthCorrection(const PmCartesian * StrutVectUnit,
 }
 
 
-/**************************** kinematicsForward() ***************************/
+/**************************** genhex_forward() *****************************/
 
-int kinematicsForward(const double * joints,
-                      EmcPose * pos,
-                      const KINEMATICS_FORWARD_FLAGS * fflags,
-                      KINEMATICS_INVERSE_FLAGS * iflags)
+/* Newton-Raphson solution of the forward kinematics, starting from the
+   pose already in *pos.  The caller refreshes the geometry from the hal
+   pins first.
+
+   When jac is not NULL the inverted Jacobian is kept in it and reused by
+   later calls as long as each iteration at least halves the error, so a
+   run of nearby poses mostly skips the 6x6 matrix inversion. */
+
+struct genhex_jacobian {
+  double J[NUM_STRUTS][NUM_STRUTS];
+  int valid;
+};
+
+static int genhex_forward(const double * joints, EmcPose * pos,
+                          struct genhex_jacobian * jac)
 {
 
   PmCartesian aw;
@@ -317,6 +329,7 @@ int kinematicsForward(const double * joints,
   double InvKinStrutLength, StrutLengthDiff[NUM_STRUTS];
   double delta[NUM_STRUTS];
   double conv_err = 1.0;
+  double last_err = 0.0;
   double corr;
 
   PmRotationMatrix RMatrix;
@@ -326,8 +339,6 @@ int kinematicsForward(const double * joints,
   int i;
   int iteration = 0;
 
-  genhexkins_read_hal_pins();
-
   /* abort on obvious problems, like joints <= 0 */
   /* FIXME-- should check against triangle inequality, so that joints
      are never too short to span shared base and platform sides */
@@ -404,8 +415,22 @@ int kinematicsForward(const double * joints,
       InverseJacobian[i][5] = RMatrix_a_cross_Strut.z;
     }
 
-    /* invert Inverse Jacobian */
-    MatInvert(InverseJacobian, Jacobian);
+    if (jac) {
+      /* keep the cached Jacobian while it still converges quickly */
+      double err = 0.0;
+      for (i = 0; i < NUM_STRUTS; i++) {
+        err += fabs(StrutLengthDiff[i]);
+      }
+      if (!jac->valid || (iteration > 1 && err > 0.5 * last_err)) {
+        MatInvert(InverseJacobian, jac->J);
+        jac->valid = 1;
+      }
+      last_err = err;
+      memcpy(Jacobian, jac->J, sizeof(Jacobian));
+    } else {
+      /* invert Inverse Jacobian */
+      MatInvert(InverseJacobian, Jacobian);
+    }
 
     /* multiply Jacobian by LegLengthDiff */
     MatMult(Jacobian, StrutLengthDiff, delta);
@@ -452,6 +477,65 @@ int kinematicsForward(const double * joints,
 }
 
 
+/**************************** kinematicsForward() ***************************/
+
+int kinematicsForward(const double * joints,
+                      EmcPose * pos,
+                      const KINEMATICS_FORWARD_FLAGS * fflags,
+                      KINEMATICS_INVERSE_FLAGS * iflags)
+{
+  genhexkins_read_hal_pins();
+
+  return genhex_forward(joints, pos, NULL);
+}
+
+
+/************************* kinematicsForwardBatch() *************************/
+
+/* The iteration for each pose starts from the solution of the previous
+   pose, which for the closely spaced poses of a toolpath converges in a
+   couple of iterations, and the inverted Jacobian is carried over from
+   pose to pose.  The geometry is read from the hal pins once per batch. */
+
+int kinematicsForwardBatch(KINEMATICS_BATCH * batch,
+                           const KINEMATICS_FORWARD_FLAGS * fflags,
+                           KINEMATICS_INVERSE_FLAGS * iflags)
+{
+  double joints[NUM_STRUTS];
+  EmcPose pos = {{0.0, 0.0, 0.0}, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  struct genhex_jacobian jac;
+  int i, t, result, failed = 0;
+
+  for (t = 0; t < NUM_STRUTS; t++) {
+    if (!batch->joint[t]) {
+      return batch->n;
+    }
+  }
+
+  genhexkins_read_hal_pins();
+  jac.valid = 0;
+
+  if (batch->n > 0) {
+    kinematicsBatchGetPose(batch, 0, &pos);
+  }
+  for (i = 0; i < batch->n; i++) {
+    for (t = 0; t < NUM_STRUTS; t++) {
+      joints[t] = batch->joint[t][i];
+    }
+    result = genhex_forward(joints, &pos, &jac);
+    if (result) {
+      failed++;
+    }
+    if (batch->status) {
+      batch->status[i] = result;
+    }
+    kinematicsBatchSetPose(batch, i, &pos);
+  }
+
+  return failed;
+}
+
+
 /************************ kinematicsInverse() ********************************/
 /* the inverse kinematics take world coordinates and determine joint values,
    given the inverse kinematics flags to resolve any ambiguities. The forward
@@ -509,6 +593,99 @@ int kinematicsInverse(const EmcPose * pos,
 }
 
 
+/************************* kinematicsInverseBatch() *************************/
+
+/* Without strut length correction the inverse is a closed form that is
+   the same for every pose, so it is evaluated a block of poses at a time
+   with the rotation matrices and strut vectors kept in arrays indexed by
+   pose.  The inner loops have no calls and no branches and are left to
+   the compiler to vectorize. */
+
+#define GENHEX_BATCH_BLOCK 64
+
+int kinematicsInverseBatch(KINEMATICS_BATCH * batch,
+                           const KINEMATICS_INVERSE_FLAGS * iflags,
+                           KINEMATICS_FORWARD_FLAGS * fflags)
+{
+  double rxx[GENHEX_BATCH_BLOCK], rxy[GENHEX_BATCH_BLOCK], rxz[GENHEX_BATCH_BLOCK];
+  double ryx[GENHEX_BATCH_BLOCK], ryy[GENHEX_BATCH_BLOCK], ryz[GENHEX_BATCH_BLOCK];
+  double rzx[GENHEX_BATCH_BLOCK], rzy[GENHEX_BATCH_BLOCK], rzz[GENHEX_BATCH_BLOCK];
+  double * const *w = batch->world;
+  int i, k, m, t;
+
+  for (t = 0; t < NUM_STRUTS; t++) {
+    if (!batch->joint[t]) {
+      return batch->n;
+    }
+  }
+  for (t = 0; t < 6; t++) {
+    if (!w[t]) {
+      return batch->n;
+    }
+  }
+
+  genhexkins_read_hal_pins();
+
+  if (haldata->screw_lead != 0.0) {
+    /* the correction needs the joint axes of every strut, use the
+       single pose code */
+    return kinematicsInverseBatchLoop(kinematicsInverse, batch, iflags, fflags);
+  }
+
+  for (k = 0; k < batch->n; k += GENHEX_BATCH_BLOCK) {
+    m = batch->n - k;
+    if (m > GENHEX_BATCH_BLOCK) {
+      m = GENHEX_BATCH_BLOCK;
+    }
+
+    /* rotation matrices, as in pmRpyMatConvert() */
+    for (i = 0; i < m; i++) {
+      double sa, sb, sg, ca, cb, cg;
+
+      sg = sin(w[3][k + i] * PM_PI / 180.0);
+      cg = cos(w[3][k + i] * PM_PI / 180.0);
+      sb = sin(w[4][k + i] * PM_PI / 180.0);
+      cb = cos(w[4][k + i] * PM_PI / 180.0);
+      sa = sin(w[5][k + i] * PM_PI / 180.0);
+      ca = cos(w[5][k + i] * PM_PI / 180.0);
+
+      rxx[i] = ca * cb;
+      ryx[i] = ca * sb * sg - sa * cg;
+      rzx[i] = ca * sb * cg + sa * sg;
+      rxy[i] = sa * cb;
+      ryy[i] = sa * sb * sg + ca * cg;
+      rzy[i] = sa * sb * cg - ca * sg;
+      rxz[i] = -sb;
+      ryz[i] = cb * sg;
+      rzz[i] = cb * cg;
+    }
+
+    /* strut lengths */
+    for (t = 0; t < NUM_STRUTS; t++) {
+      const double ax = a[t].x, ay = a[t].y, az = a[t].z;
+      const double bx = b[t].x, by = b[t].y, bz = b[t].z;
+      const double *x = w[0] + k, *y = w[1] + k, *z = w[2] + k;
+      double *joint = batch->joint[t] + k;
+
+      for (i = 0; i < m; i++) {
+        double dx = x[i] + rxx[i] * ax + ryx[i] * ay + rzx[i] * az - bx;
+        double dy = y[i] + rxy[i] * ax + ryy[i] * ay + rzy[i] * az - by;
+        double dz = z[i] + rxz[i] * ax + ryz[i] * ay + rzz[i] * az - bz;
+        joint[i] = sqrt(dx * dx + dy * dy + dz * dz);
+      }
+    }
+  }
+
+  if (batch->status) {
+    for (i = 0; i < batch->n; i++) {
+      batch->status[i] = 0;
+    }
+  }
+
+  return 0;
+}
+
+
 KINEMATICS_TYPE kinematicsType()
 {
   return KINEMATICS_BOTH;
@@ -521,6 +698,8 @@ KINEMATICS_TYPE kinematicsType()
 EXPORT_SYMBOL(kinematicsType);
 EXPORT_SYMBOL(kinematicsForward);
 EXPORT_SYMBOL(kinematicsInverse);
+EXPORT_SYMBOL(kinematicsForwardBatch);
+EXPORT_SYMBOL(kinematicsInverseBatch);
 
 MODULE_LICENSE("GPL");
 
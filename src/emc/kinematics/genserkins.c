@@ -369,6 +369,127 @@ int kinematicsForward(const double *joint,
     return 0;
 }
 
+/* Forward kinematics for a batch of poses.  The link transforms are
+   chained a block of poses at a time, with the rotation and translation
+   of each pose kept in arrays indexed by pose, so the inner loops are
+   plain arithmetic the compiler can vectorize.  Only the final conversion
+   to roll, pitch, yaw is done pose by pose. */
+
+#define GENSER_BATCH_BLOCK 64
+
+int kinematicsForwardBatch(KINEMATICS_BATCH * batch,
+			   const KINEMATICS_FORWARD_FLAGS * fflags,
+			   KINEMATICS_INVERSE_FLAGS * iflags)
+{
+    genser_struct *genser = KINS_PTR;
+    /* rotation r[col][row] and translation t[row] of the pose so far */
+    double r[3][3][GENSER_BATCH_BLOCK], t[3][GENSER_BATCH_BLOCK];
+    double q[GENSER_MAX_JOINTS][GENSER_BATCH_BLOCK];
+    double * const *w = batch->world;
+    int i, k, m, link, col, row;
+    go_mat mat;
+    go_rpy rpy;
+
+    for (link = 0; link < 6; link++) {
+	if (!batch->joint[link] || !w[link])
+	    return batch->n;
+    }
+
+    genser_kin_init();
+
+    for (k = 0; k < batch->n; k += GENSER_BATCH_BLOCK) {
+	m = batch->n - k;
+	if (m > GENSER_BATCH_BLOCK)
+	    m = GENSER_BATCH_BLOCK;
+
+	/* joint values in radians, as in kinematicsForward() */
+	for (link = 0; link < 6; link++) {
+	    const double *joint = batch->joint[link] + k;
+	    for (i = 0; i < m; i++)
+		q[link][i] = joint[i] * PM_PI / 180;
+	    if (link && haldata->unrotate[link]) {
+		for (i = 0; i < m; i++)
+		    q[link][i] -= haldata->unrotate[link] * q[link - 1][i];
+	    }
+	}
+
+	for (col = 0; col < 3; col++) {
+	    for (row = 0; row < 3; row++) {
+		for (i = 0; i < m; i++)
+		    r[col][row][i] = (col == row);
+	    }
+	    for (i = 0; i < m; i++)
+		t[col][i] = 0;
+	}
+
+	/* pose = pose * link, with the link pose as in go_dh_pose_convert() */
+	for (link = 0; link < genser->link_num; link++) {
+	    const go_dh *dh = &genser->links[link].u.dh;
+	    const int prismatic =
+		GO_QUANTITY_LENGTH == genser->links[link].quantity;
+	    double sal, cal;
+
+	    sal = sin(dh->alpha);
+	    cal = cos(dh->alpha);
+
+	    for (i = 0; i < m; i++) {
+		double theta = prismatic ? dh->theta : q[link][i];
+		double d = prismatic ? q[link][i] : dh->d;
+		double sth = sin(theta), cth = cos(theta);
+		/* link rotation columns and translation */
+		double lx[3] = { cth, sth * cal, sth * sal };
+		double ly[3] = { -sth, cth * cal, cth * sal };
+		double lz[3] = { 0.0, -sal, cal };
+		double lt[3] = { dh->a, -sal * d, cal * d };
+		double rx[3], ry[3], rz[3];
+
+		for (row = 0; row < 3; row++) {
+		    t[row][i] += r[0][row][i] * lt[0] + r[1][row][i] * lt[1]
+			+ r[2][row][i] * lt[2];
+		    rx[row] = r[0][row][i] * lx[0] + r[1][row][i] * lx[1]
+			+ r[2][row][i] * lx[2];
+		    ry[row] = r[0][row][i] * ly[0] + r[1][row][i] * ly[1]
+			+ r[2][row][i] * ly[2];
+		    rz[row] = r[0][row][i] * lz[0] + r[1][row][i] * lz[1]
+			+ r[2][row][i] * lz[2];
+		}
+		for (row = 0; row < 3; row++) {
+		    r[0][row][i] = rx[row];
+		    r[1][row][i] = ry[row];
+		    r[2][row][i] = rz[row];
+		}
+	    }
+	}
+
+	for (i = 0; i < m; i++) {
+	    mat.x.x = r[0][0][i], mat.x.y = r[0][1][i], mat.x.z = r[0][2][i];
+	    mat.y.x = r[1][0][i], mat.y.y = r[1][1][i], mat.y.z = r[1][2][i];
+	    mat.z.x = r[2][0][i], mat.z.y = r[2][1][i], mat.z.z = r[2][2][i];
+	    go_mat_rpy_convert(&mat, &rpy);
+
+	    w[0][k + i] = t[0][i];
+	    w[1][k + i] = t[1][i];
+	    w[2][k + i] = t[2][i];
+	    w[3][k + i] = rpy.r * 180 / PM_PI;
+	    w[4][k + i] = rpy.p * 180 / PM_PI;
+	    w[5][k + i] = rpy.y * 180 / PM_PI;
+	}
+	//pass through unused axis
+	for (link = 6; link < 9; link++) {
+	    if (w[link] && batch->joint[link]) {
+		for (i = 0; i < m; i++)
+		    w[link][k + i] = batch->joint[link][k + i];
+	    }
+	}
+    }
+
+    if (batch->status) {
+	for (i = 0; i < batch->n; i++)
+	    batch->status[i] = 0;
+    }
+    return 0;
+}
+
 int genser_kin_fwd(void *kins, const go_real * joints, go_pose * pos)
 {
     genser_struct *genser = kins;
@@ -532,6 +653,17 @@ int kinematicsInverse(const EmcPose * world,
     return GO_RESULT_ERROR;
 }
 
+/* The inverse is a Newton iteration with a Jacobian that depends on the
+   joint values, so the batch version solves pose by pose.  Each pose is
+   started from the solution of the previous one, which for the closely
+   spaced poses of a toolpath needs only a few iterations. */
+int kinematicsInverseBatch(KINEMATICS_BATCH * batch,
+			   const KINEMATICS_INVERSE_FLAGS * iflags,
+			   KINEMATICS_FORWARD_FLAGS * fflags)
+{
+    return kinematicsInverseBatchLoop(kinematicsInverse, batch, iflags, fflags);
+}
+
 /*
   Extras, not callable using go_kin_ wrapper but if you know you have
   linked in these kinematics, go ahead and call these for your ad hoc
@@ -577,6 +709,8 @@ KINEMATICS_TYPE kinematicsType()
 EXPORT_SYMBOL(kinematicsType);
 EXPORT_SYMBOL(kinematicsForward);
 EXPORT_SYMBOL(kinematicsInverse);
+EXPORT_SYMBOL(kinematicsForwardBatch);
+EXPORT_SYMBOL(kinematicsInverseBatch);
 MODULE_LICENSE("GPL");
 
 int comp_id;
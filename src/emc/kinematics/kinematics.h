@@ -102,6 +102,57 @@ extern int kinematicsHome(struct EmcPose * world,
 
 extern KINEMATICS_TYPE kinematicsType(void);
 
+/* Batch kinematics.
+
+   Preview, soft limit checking and offline simulation evaluate the
+   kinematics for thousands of poses at a time.  A kinematics module may
+   export kinematicsForwardBatch() and kinematicsInverseBatch() to handle
+   a whole block of poses per call.  They are optional; callers that find
+   them missing can use the kinematicsForwardBatchLoop() and
+   kinematicsInverseBatchLoop() helpers with the single pose functions.
+
+   The poses are passed as a structure of arrays so that each coordinate
+   is contiguous in memory and the per-pose arithmetic can be vectorized:
+   world[axis][i] is coordinate axis (0:x,1:y,2:z,3:a,...,8:w) of pose i,
+   and joint[jno][i] is joint jno of pose i.  Arrays the kinematics does
+   not use may be NULL.  When status is not NULL, status[i] receives what
+   the single pose function would have returned for pose i.
+
+   Like the single pose functions the output arrays are also inputs: the
+   values for pose 0 on entry are the initial estimate for iterative
+   kinematics, and pose i+1 is started from the solution of pose i.
+
+   The batch functions return the number of poses that failed.
+*/
+#define KINEMATICS_BATCH_AXES       9
+#define KINEMATICS_BATCH_MAX_JOINTS 16
+
+typedef struct {
+    int n;			/* number of poses */
+    double *world[KINEMATICS_BATCH_AXES];
+    double *joint[KINEMATICS_BATCH_MAX_JOINTS];
+    int *status;		/* per pose result, may be NULL */
+} KINEMATICS_BATCH;
+
+extern int kinematicsForwardBatch(KINEMATICS_BATCH * batch,
+				  const KINEMATICS_FORWARD_FLAGS * fflags,
+				  KINEMATICS_INVERSE_FLAGS * iflags);
+
+extern int kinematicsInverseBatch(KINEMATICS_BATCH * batch,
+				  const KINEMATICS_INVERSE_FLAGS * iflags,
+				  KINEMATICS_FORWARD_FLAGS * fflags);
+
+/* copy pose i of a batch to or from its array of structures form;
+   coordinates or joints whose arrays are NULL are left untouched */
+extern void kinematicsBatchGetPose(const KINEMATICS_BATCH * batch, int i,
+				   struct EmcPose * world);
+extern void kinematicsBatchSetPose(KINEMATICS_BATCH * batch, int i,
+				   const struct EmcPose * world);
+extern void kinematicsBatchGetJoints(const KINEMATICS_BATCH * batch, int i,
+				     double *joint);
+extern void kinematicsBatchSetJoints(KINEMATICS_BATCH * batch, int i,
+				     const double *joint);
+
 /* map letters in a coordinates string to joint numbers
 ** sequentially.  Axis indices are 0:x,1:y,...,etc
 ** Example: coordinates=XYZYAC
@@ -133,11 +184,30 @@ typedef int (* vtk_kinematicsHome_t)(struct EmcPose * world,
 
 typedef KINEMATICS_TYPE  (*vtk_kinematicsType_t)(void);
 
+typedef int (*vtk_kinematicsForwardBatch_t)(KINEMATICS_BATCH * batch,
+				     const KINEMATICS_FORWARD_FLAGS * fflags,
+				     KINEMATICS_INVERSE_FLAGS * iflags);
+typedef int (*vtk_kinematicsInverseBatch_t)(KINEMATICS_BATCH * batch,
+				     const KINEMATICS_INVERSE_FLAGS * iflags,
+				     KINEMATICS_FORWARD_FLAGS * fflags);
+
 typedef struct {
     vtk_kinematicsForward_t kinematicsForward;
     vtk_kinematicsInverse_t kinematicsInverse;
     vtk_kinematicsHome_t    kinematicsHome; // used by drawbotkins
     vtk_kinematicsType_t    kinematicsType;
+    vtk_kinematicsForwardBatch_t kinematicsForwardBatch; // optional
+    vtk_kinematicsInverseBatch_t kinematicsInverseBatch; // optional
 } vtkins_t;
 
+/* pose by pose fallbacks for kinematics without batch functions */
+extern int kinematicsForwardBatchLoop(vtk_kinematicsForward_t forward,
+				      KINEMATICS_BATCH * batch,
+				      const KINEMATICS_FORWARD_FLAGS * fflags,
+				      KINEMATICS_INVERSE_FLAGS * iflags);
+extern int kinematicsInverseBatchLoop(vtk_kinematicsInverse_t inverse,
+				      KINEMATICS_BATCH * batch,
+				      const KINEMATICS_INVERSE_FLAGS * iflags,
+				      KINEMATICS_FORWARD_FLAGS * fflags);
+
 #endif
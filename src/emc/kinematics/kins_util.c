@@ -1,5 +1,6 @@
 #include "rtapi.h"
 #include "motion.h"
+#include "kinematics.h"
 
 /* Utility routines for kinematics modules
 **
@@ -95,3 +96,103 @@ int map_coordinates_to_jnumbers(char *coordinates,
     }
     return 0;
 } //map_coordinates_to_jnumbers()
+
+/* Batch helpers
+**
+** kinematicsBatchGetPose() etc. move one pose of a KINEMATICS_BATCH
+** between the structure of arrays layout and the EmcPose/joint array
+** layout of the single pose functions.
+**
+** kinematicsForwardBatchLoop() and kinematicsInverseBatchLoop() provide
+** the batch semantics for kinematics that only have single pose
+** functions: the output of pose i is the initial estimate for pose i+1.
+*/
+void kinematicsBatchGetPose(const KINEMATICS_BATCH *batch, int i,
+                            EmcPose *world)
+{
+    double * const *w = batch->world;
+
+    if (w[0]) world->tran.x = w[0][i];
+    if (w[1]) world->tran.y = w[1][i];
+    if (w[2]) world->tran.z = w[2][i];
+    if (w[3]) world->a = w[3][i];
+    if (w[4]) world->b = w[4][i];
+    if (w[5]) world->c = w[5][i];
+    if (w[6]) world->u = w[6][i];
+    if (w[7]) world->v = w[7][i];
+    if (w[8]) world->w = w[8][i];
+}
+
+void kinematicsBatchSetPose(KINEMATICS_BATCH *batch, int i,
+                            const EmcPose *world)
+{
+    double **w = batch->world;
+
+    if (w[0]) w[0][i] = world->tran.x;
+    if (w[1]) w[1][i] = world->tran.y;
+    if (w[2]) w[2][i] = world->tran.z;
+    if (w[3]) w[3][i] = world->a;
+    if (w[4]) w[4][i] = world->b;
+    if (w[5]) w[5][i] = world->c;
+    if (w[6]) w[6][i] = world->u;
+    if (w[7]) w[7][i] = world->v;
+    if (w[8]) w[8][i] = world->w;
+}
+
+void kinematicsBatchGetJoints(const KINEMATICS_BATCH *batch, int i,
+                              double *joint)
+{
+    int jno;
+    for (jno=0; jno<KINEMATICS_BATCH_MAX_JOINTS; jno++) {
+        if (batch->joint[jno]) { joint[jno] = batch->joint[jno][i]; }
+    }
+}
+
+void kinematicsBatchSetJoints(KINEMATICS_BATCH *batch, int i,
+                              const double *joint)
+{
+    int jno;
+    for (jno=0; jno<KINEMATICS_BATCH_MAX_JOINTS; jno++) {
+        if (batch->joint[jno]) { batch->joint[jno][i] = joint[jno]; }
+    }
+}
+
+int kinematicsForwardBatchLoop(vtk_kinematicsForward_t forward,
+                               KINEMATICS_BATCH *batch,
+                               const KINEMATICS_FORWARD_FLAGS *fflags,
+                               KINEMATICS_INVERSE_FLAGS *iflags)
+{
+    double joint[KINEMATICS_BATCH_MAX_JOINTS] = {0};
+    EmcPose world = {{0,0,0},0,0,0,0,0,0};
+    int i, r, failed = 0;
+
+    if (batch->n > 0) { kinematicsBatchGetPose(batch, 0, &world); }
+    for (i=0; i<batch->n; i++) {
+        kinematicsBatchGetJoints(batch, i, joint);
+        r = forward(joint, &world, fflags, iflags);
+        if (r) { failed++; }
+        if (batch->status) { batch->status[i] = r; }
+        kinematicsBatchSetPose(batch, i, &world);
+    }
+    return failed;
+}
+
+int kinematicsInverseBatchLoop(vtk_kinematicsInverse_t inverse,
+                               KINEMATICS_BATCH *batch,
+                               const KINEMATICS_INVERSE_FLAGS *iflags,
+                               KINEMATICS_FORWARD_FLAGS *fflags)
+{
+    double joint[KINEMATICS_BATCH_MAX_JOINTS] = {0};
+    EmcPose world = {{0,0,0},0,0,0,0,0,0};
+    int i, r, failed = 0;
+
+    if (batch->n > 0) { kinematicsBatchGetJoints(batch, 0, joint); }
+    for (i=0; i<batch->n; i++) {
+        kinematicsBatchGetPose(batch, i, &world);
+        r = inverse(&world, joint, iflags, fflags);
+        if (r) { failed++; }
+        if (batch->status) { batch->status[i] = r; }
+        kinematicsBatchSetJoints(batch, i, joint);
+    }
+    return failed;
+}
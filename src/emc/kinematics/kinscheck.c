@@ -0,0 +1,947 @@
+/********************************************************************
+* Description: kinscheck.c
+*   Offline soft limit and reachability check of a program through
+*   the machine's kinematics.
+*
+*   Reads the canonical machining commands printed by
+*   'rs274 -g -N' (or runs rs274 itself when given a .ngc file),
+*   samples every move in machine coordinates, runs the samples
+*   through the inverse kinematics of the real kinematics module and
+*   reports joint position limit violations, joint velocity
+*   violations and singular or unreachable poses by source line.
+*
+*   The kinematics module is loaded from EMC2_RTLIB_DIR the same way
+*   rtapi_app loads it.  Its pins and parameters live in a small
+*   in-process HAL provided by this program, so no realtime session
+*   is needed and pins can be set with -P.  Kinematics modules keep
+*   their state in module globals and are not reentrant, so the
+*   program is divided between forked worker processes instead of
+*   threads.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2026 All rights reserved.
+********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "config.h"
+#include "rtapi.h"
+#include "hal.h"
+#include "emcpos.h"
+#include "kinematics.h"
+#include "inifile.h"
+
+#define KC_MAX_ITEMS     512
+#define KC_MAX_ARGS      32
+#define KC_LINELEN       1024
+#define KC_DEFAULT_RES   0.1	/* machine units between samples */
+#define KC_DEFAULT_ARES  0.5	/* degrees between samples */
+#define KC_DEFAULT_GAIN  100.0	/* joint units per machine unit */
+
+/***********************************************************************
+*                        IN PROCESS HAL                                *
+************************************************************************/
+
+/* every pin and parameter the module creates, so that -P can set them */
+typedef struct {
+    char name[HAL_NAME_LEN + 1];
+    hal_type_t type;
+    void *addr;
+} kc_item;
+
+static kc_item items[KC_MAX_ITEMS];
+static int n_items;
+
+static int kc_register(hal_type_t type, void *addr, const char *fmt,
+		       va_list ap)
+{
+    if (n_items == KC_MAX_ITEMS) {
+	fprintf(stderr, "kinscheck: too many pins and parameters\n");
+	return -ENOMEM;
+    }
+    vsnprintf(items[n_items].name, sizeof(items[n_items].name), fmt, ap);
+    items[n_items].type = type;
+    items[n_items].addr = addr;
+    n_items++;
+    return 0;
+}
+
+int hal_init(const char *name) { return 1; }
+int hal_ready(int comp_id) { return 0; }
+int hal_exit(int comp_id) { return 0; }
+
+void *hal_malloc(long int size)
+{
+    return calloc(1, size);
+}
+
+int hal_export_vtable(const char *name, int version, void *vtable, int comp_id)
+{
+    return 1;
+}
+
+int hal_remove_vtable(int vtable_id) { return 0; }
+
+#define KC_PIN(type, htype) \
+int hal_pin_##type##_newf(hal_pin_dir_t dir, \
+    hal_##type##_t ** data_ptr_addr, int comp_id, const char *fmt, ...) \
+{ \
+    va_list ap; \
+    int r; \
+    if (!(*data_ptr_addr = calloc(1, sizeof(hal_##type##_t)))) \
+	return -ENOMEM; \
+    va_start(ap, fmt); \
+    r = kc_register(htype, (void *) *data_ptr_addr, fmt, ap); \
+    va_end(ap); \
+    return r; \
+} \
+int hal_pin_##type##_new(const char *name, hal_pin_dir_t dir, \
+    hal_##type##_t ** data_ptr_addr, int comp_id) \
+{ \
+    return hal_pin_##type##_newf(dir, data_ptr_addr, comp_id, "%s", name); \
+}
+
+#define KC_PARAM(type, htype) \
+int hal_param_##type##_newf(hal_param_dir_t dir, \
+    hal_##type##_t * data_addr, int comp_id, const char *fmt, ...) \
+{ \
+    va_list ap; \
+    int r; \
+    va_start(ap, fmt); \
+    r = kc_register(htype, (void *) data_addr, fmt, ap); \
+    va_end(ap); \
+    return r; \
+} \
+int hal_param_##type##_new(const char *name, hal_param_dir_t dir, \
+    hal_##type##_t * data_addr, int comp_id) \
+{ \
+    return hal_param_##type##_newf(dir, data_addr, comp_id, "%s", name); \
+}
+
+KC_PIN(bit, HAL_BIT)
+KC_PIN(float, HAL_FLOAT)
+KC_PIN(u32, HAL_U32)
+KC_PIN(s32, HAL_S32)
+KC_PARAM(bit, HAL_BIT)
+KC_PARAM(float, HAL_FLOAT)
+KC_PARAM(u32, HAL_U32)
+KC_PARAM(s32, HAL_S32)
+
+static int msg_level = RTAPI_MSG_ERR;
+
+void rtapi_print(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+void rtapi_print_msg(msg_level_t level, const char *fmt, ...)
+{
+    va_list args;
+
+    if (level > msg_level) return;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+/* name=value, like setp */
+static int kc_setp(const char *arg)
+{
+    const char *eq = strchr(arg, '=');
+    char *endp;
+    int i;
+
+    if (!eq) {
+	fprintf(stderr, "kinscheck: -P %s: expected name=value\n", arg);
+	return -1;
+    }
+    for (i = 0; i < n_items; i++) {
+	if (strlen(items[i].name) != (size_t)(eq - arg)
+	    || strncmp(items[i].name, arg, eq - arg)) continue;
+	switch (items[i].type) {
+	case HAL_BIT:
+	    *(hal_bit_t *)items[i].addr = strtol(eq + 1, &endp, 0) != 0;
+	    break;
+	case HAL_FLOAT:
+	    *(hal_float_t *)items[i].addr = strtod(eq + 1, &endp);
+	    break;
+	case HAL_U32:
+	    *(hal_u32_t *)items[i].addr = strtoul(eq + 1, &endp, 0);
+	    break;
+	case HAL_S32:
+	    *(hal_s32_t *)items[i].addr = strtol(eq + 1, &endp, 0);
+	    break;
+	default:
+	    endp = "?";
+	}
+	if (*endp || endp == eq + 1) {
+	    fprintf(stderr, "kinscheck: -P %s: invalid value\n", arg);
+	    return -1;
+	}
+	return 0;
+    }
+    fprintf(stderr, "kinscheck: -P %s: no such pin or parameter\n", arg);
+    return -1;
+}
+
+/***********************************************************************
+*                        KINEMATICS MODULE                             *
+************************************************************************/
+
+static vtk_kinematicsInverse_t kins_inverse;
+static vtk_kinematicsInverseBatch_t kins_inverse_batch;
+
+/* one module argument name=value[,value...] as in do_comp_args() */
+static int kc_module_arg(void *module, const char *arg)
+{
+    char name[KC_LINELEN], value[KC_LINELEN];
+    char sym[KC_LINELEN + sizeof("rtapi_info_address_")];
+    const char *eq = strchr(arg, '=');
+    void *item;
+    char **type;
+    int *max_size, i = 0;
+    char *tok, *save, *endp;
+
+    if (!eq || (size_t)(eq - arg) >= sizeof(name)) {
+	fprintf(stderr, "kinscheck: invalid module argument '%s'\n", arg);
+	return -1;
+    }
+    snprintf(name, sizeof(name), "%.*s", (int)(eq - arg), arg);
+    snprintf(value, sizeof(value), "%s", eq + 1);
+
+    snprintf(sym, sizeof(sym), "rtapi_info_address_%s", name);
+    item = dlsym(module, sym);
+    snprintf(sym, sizeof(sym), "rtapi_info_type_%s", name);
+    type = dlsym(module, sym);
+    snprintf(sym, sizeof(sym), "rtapi_info_size_%s", name);
+    max_size = dlsym(module, sym);
+    if (!item || !type || !*type) {
+	fprintf(stderr, "kinscheck: unknown module argument '%s'\n", arg);
+	return -1;
+    }
+
+    for (tok = strtok_r(value, max_size ? "," : "", &save); tok;
+	 tok = strtok_r(NULL, max_size ? "," : "", &save), i++) {
+	if (max_size && i == *max_size) {
+	    fprintf(stderr, "kinscheck: %s: can only take %d arguments\n",
+		    arg, *max_size);
+	    return -1;
+	}
+	switch (**type) {
+	case 'l':
+	    (*(long **)item)[i] = strtol(tok, &endp, 0);
+	    break;
+	case 'i':
+	    (*(int **)item)[i] = strtol(tok, &endp, 0);
+	    break;
+	case 's':
+	    (*(char ***)item)[i] = strdup(tok);
+	    endp = "";
+	    break;
+	default:
+	    endp = "?";
+	}
+	if (*endp) {
+	    fprintf(stderr, "kinscheck: '%s' invalid for argument '%s'\n",
+		    tok, name);
+	    return -1;
+	}
+    }
+    return 0;
+}
+
+static int kc_load_kins(char *const *args, int nargs)
+{
+    char path[KC_LINELEN];
+    void *module;
+    int (*app_main)(void);
+    int i;
+
+    if (strchr(args[0], '/'))
+	snprintf(path, sizeof(path), "%s", args[0]);
+    else
+	snprintf(path, sizeof(path), "%s/%s.so", EMC2_RTLIB_DIR, args[0]);
+
+    module = dlopen(path, RTLD_GLOBAL | RTLD_NOW);
+    if (!module) {
+	fprintf(stderr, "kinscheck: %s: dlopen: %s\n", args[0], dlerror());
+	return -1;
+    }
+    for (i = 1; i < nargs; i++) {
+	if (kc_module_arg(module, args[i])) return -1;
+    }
+    app_main = (int (*)(void)) dlsym(module, "rtapi_app_main");
+    kins_inverse = (vtk_kinematicsInverse_t) dlsym(module, "kinematicsInverse");
+    kins_inverse_batch =
+	(vtk_kinematicsInverseBatch_t) dlsym(module, "kinematicsInverseBatch");
+    if (!app_main || !kins_inverse) {
+	fprintf(stderr, "kinscheck: %s is not a kinematics module\n", args[0]);
+	return -1;
+    }
+    if (app_main() < 0) {
+	fprintf(stderr, "kinscheck: %s: rtapi_app_main failed\n", args[0]);
+	return -1;
+    }
+    return 0;
+}
+
+/***********************************************************************
+*                        MACHINE CONFIGURATION                         *
+************************************************************************/
+
+static struct {
+    int joints;
+    double min_limit[KINEMATICS_BATCH_MAX_JOINTS];
+    double max_limit[KINEMATICS_BATCH_MAX_JOINTS];
+    double max_velocity[KINEMATICS_BATCH_MAX_JOINTS];	/* 0 = unchecked */
+    double home[KINEMATICS_BATCH_MAX_JOINTS];
+    double units_per_mm;	/* machine length units */
+    double rapid;		/* machine units / s, 0 = unchecked */
+} machine = { .joints = 6, .units_per_mm = 1.0 };
+
+static int kc_read_ini(const char *filename, char *kins, size_t kins_size)
+{
+    FILE *fp = fopen(filename, "r");
+    const char *s;
+    char section[32];
+    int j, joints;
+
+    if (!fp) {
+	fprintf(stderr, "kinscheck: can't open %s: %s\n", filename,
+		strerror(errno));
+	return -1;
+    }
+    if (kins && (s = iniFind(fp, "KINEMATICS", "KINS")))
+	snprintf(kins, kins_size, "%s", s);
+    if (iniFindInt(fp, "JOINTS", "KINS", &joints) == 0)
+	machine.joints = joints;
+    if (machine.joints < 1 || machine.joints > KINEMATICS_BATCH_MAX_JOINTS) {
+	fprintf(stderr, "kinscheck: [KINS]JOINTS must be 1..%d\n",
+		KINEMATICS_BATCH_MAX_JOINTS);
+	fclose(fp);
+	return -1;
+    }
+    if ((s = iniFind(fp, "LINEAR_UNITS", "TRAJ"))) {
+	if (!strcmp(s, "inch") || !strcmp(s, "imperial"))
+	    machine.units_per_mm = 1 / 25.4;
+	else if (!strcmp(s, "mm") || !strcmp(s, "metric"))
+	    machine.units_per_mm = 1.0;
+	else if (atof(s) > 0)
+	    machine.units_per_mm = 1 / atof(s);
+    }
+    iniFindDouble(fp, "MAX_LINEAR_VELOCITY", "TRAJ", &machine.rapid);
+
+    for (j = 0; j < machine.joints; j++) {
+	snprintf(section, sizeof(section), "JOINT_%d", j);
+	iniFindDouble(fp, "MIN_LIMIT", section, &machine.min_limit[j]);
+	iniFindDouble(fp, "MAX_LIMIT", section, &machine.max_limit[j]);
+	iniFindDouble(fp, "MAX_VELOCITY", section, &machine.max_velocity[j]);
+	iniFindDouble(fp, "HOME", section, &machine.home[j]);
+    }
+    fclose(fp);
+    return 0;
+}
+
+/***********************************************************************
+*                        PROGRAM                                       *
+************************************************************************/
+
+enum { KC_TRAVERSE, KC_FEED, KC_ARC };
+enum { KC_PLANE_XY, KC_PLANE_YZ, KC_PLANE_XZ };
+
+/* offsets in effect for a run of segments, all in mm and degrees */
+typedef struct {
+    double g5x[6], g92[6], tool[6];
+    double xy_rotation;		/* degrees */
+} kc_frame;
+
+/* one move in program coordinates (mm and degrees) */
+typedef struct {
+    int line;
+    int kind;
+    int frame;
+    int plane, rotation;	/* arcs */
+    int samples;		/* intervals the move is divided into */
+    double start[6], end[6];
+    double center[2];		/* arcs, first and second axis of plane */
+    double rate;		/* machine units / s, 0 = unchecked */
+    double length;		/* machine units (or degrees) */
+} kc_segment;
+
+static kc_frame *frames;
+static int n_frames, frames_size;
+static kc_segment *segs;
+static int n_segs, segs_size;
+
+static double resolution = KC_DEFAULT_RES;
+static double angular_resolution = KC_DEFAULT_ARES;
+static double max_gain = KC_DEFAULT_GAIN;
+
+static void *kc_grow(void *p, int *size, size_t elem)
+{
+    *size = *size ? *size * 2 : 1024;
+    p = realloc(p, *size * elem);
+    if (!p) {
+	perror("kinscheck: realloc");
+	exit(2);
+    }
+    return p;
+}
+
+/* which of x, y, z are the first, second and normal axis of the plane */
+static const int plane_axes[3][3] = {
+    {0, 1, 2},			/* XY */
+    {1, 2, 0},			/* YZ */
+    {2, 0, 1},			/* XZ */
+};
+
+/* arc sweep in radians, signed by direction */
+static double kc_arc_sweep(const kc_segment *s)
+{
+    const int *ax = plane_axes[s->plane];
+    double a0 = atan2(s->start[ax[1]] - s->center[1],
+		      s->start[ax[0]] - s->center[0]);
+    double a1 = atan2(s->end[ax[1]] - s->center[1],
+		      s->end[ax[0]] - s->center[0]);
+    double d = a1 - a0;
+
+    if (s->rotation > 0) {
+	while (d <= 1e-12) d += 2 * M_PI;
+	d += 2 * M_PI * (s->rotation - 1);
+    } else {
+	while (d >= -1e-12) d -= 2 * M_PI;
+	d -= 2 * M_PI * (-s->rotation - 1);
+    }
+    return d;
+}
+
+/* program position at fraction t of a segment */
+static void kc_point(const kc_segment *s, double sweep, double t, double *p)
+{
+    int i;
+
+    for (i = 0; i < 6; i++)
+	p[i] = s->start[i] + t * (s->end[i] - s->start[i]);
+    if (s->kind == KC_ARC) {
+	const int *ax = plane_axes[s->plane];
+	double r0 = hypot(s->start[ax[0]] - s->center[0],
+			  s->start[ax[1]] - s->center[1]);
+	double r1 = hypot(s->end[ax[0]] - s->center[0],
+			  s->end[ax[1]] - s->center[1]);
+	double a0 = atan2(s->start[ax[1]] - s->center[1],
+			  s->start[ax[0]] - s->center[0]);
+	double r = r0 + t * (r1 - r0), a = a0 + t * sweep;
+
+	p[ax[0]] = s->center[0] + r * cos(a);
+	p[ax[1]] = s->center[1] + r * sin(a);
+    }
+}
+
+/* program position to machine position, as emccanon does it */
+static void kc_to_machine(const kc_frame *f, const double *p, double *m)
+{
+    double x = p[0] + f->g92[0], y = p[1] + f->g92[1];
+    double s = sin(f->xy_rotation * M_PI / 180);
+    double c = cos(f->xy_rotation * M_PI / 180);
+    int i;
+
+    m[0] = x * c - y * s;
+    m[1] = x * s + y * c;
+    m[2] = p[2] + f->g92[2];
+    for (i = 3; i < 6; i++) m[i] = p[i] + f->g92[i];
+    for (i = 0; i < 6; i++) {
+	m[i] += f->g5x[i] + f->tool[i];
+	if (i < 3) m[i] *= machine.units_per_mm;
+    }
+}
+
+static void kc_add_segment(kc_segment *s)
+{
+    double sweep = 0, lin, ang;
+    int i, n;
+
+    if (s->kind == KC_ARC) {
+	const int *ax = plane_axes[s->plane];
+	double r = hypot(s->start[ax[0]] - s->center[0],
+			 s->start[ax[1]] - s->center[1]);
+	sweep = kc_arc_sweep(s);
+	lin = hypot(fabs(sweep) * r, s->end[ax[2]] - s->start[ax[2]]);
+    } else {
+	lin = sqrt(pow(s->end[0] - s->start[0], 2) +
+		   pow(s->end[1] - s->start[1], 2) +
+		   pow(s->end[2] - s->start[2], 2));
+    }
+    lin *= machine.units_per_mm;
+    for (ang = 0, i = 3; i < 6; i++)
+	ang += pow(s->end[i] - s->start[i], 2);
+    ang = sqrt(ang);
+
+    /* feed applies to the linear axes unless the move is rotary only */
+    s->length = lin > 1e-9 ? lin : ang;
+    n = (int) ceil(lin / resolution);
+    if ((int) ceil(ang / angular_resolution) > n)
+	n = (int) ceil(ang / angular_resolution);
+    if (n < 1) n = 1;
+    s->samples = n;
+
+    if (n_segs == segs_size)
+	segs = kc_grow(segs, &segs_size, sizeof(*segs));
+    s->frame = n_frames - 1;
+    segs[n_segs++] = *s;
+}
+
+static kc_frame *kc_new_frame(void)
+{
+    if (n_frames == frames_size)
+	frames = kc_grow(frames, &frames_size, sizeof(*frames));
+    if (n_frames) frames[n_frames] = frames[n_frames - 1];
+    else memset(&frames[0], 0, sizeof(frames[0]));
+    return &frames[n_frames++];
+}
+
+/* parse the canon text from rs274 */
+static int kc_read_canon(FILE *in)
+{
+    char buf[KC_LINELEN], name[64];
+    double pos[6] = {0}, v[10];
+    double units = 1.0;		/* mm per program unit */
+    double feed = 0;		/* program units / min */
+    int feed_mode = 0, plane = KC_PLANE_XY;
+    int seq, line, i, n;
+    kc_frame *f;
+
+    kc_new_frame();
+    while (fgets(buf, sizeof(buf), in)) {
+	char *p, *args;
+	kc_segment s;
+
+	if (sscanf(buf, "%d N", &seq) != 1) continue;
+	if (!(p = strchr(buf, 'N'))) continue;
+	line = isdigit((unsigned char) p[1]) ? atoi(p + 1) : seq;
+	p += strcspn(p, " ");
+	p += strspn(p, " ");
+	if (!(args = strchr(p, '(')) || args - p >= (int) sizeof(name))
+	    continue;
+	snprintf(name, sizeof(name), "%.*s", (int)(args - p), p);
+	args++;
+
+	memset(&s, 0, sizeof(s));
+	s.line = line;
+	if (!strcmp(name, "STRAIGHT_TRAVERSE") || !strcmp(name, "STRAIGHT_FEED")
+	    || !strcmp(name, "STRAIGHT_PROBE")) {
+	    if (sscanf(args, "%lf, %lf, %lf, %lf, %lf, %lf",
+		       &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 6)
+		continue;
+	    s.kind = name[9] == 'T' ? KC_TRAVERSE : KC_FEED;
+	    for (i = 0; i < 6; i++)
+		s.end[i] = i < 3 ? v[i] * units : v[i];
+	} else if (!strcmp(name, "ARC_FEED")) {
+	    const int *ax = plane_axes[plane];
+	    if (sscanf(args, "%lf, %lf, %lf, %lf, %d, %lf, %lf, %lf, %lf",
+		       &v[0], &v[1], &v[2], &v[3], &n, &v[4], &v[5], &v[6],
+		       &v[7]) != 9)
+		continue;
+	    s.kind = KC_ARC;
+	    s.plane = plane;
+	    s.rotation = n;
+	    s.end[ax[0]] = v[0] * units;
+	    s.end[ax[1]] = v[1] * units;
+	    s.end[ax[2]] = v[4] * units;
+	    s.center[0] = v[2] * units;
+	    s.center[1] = v[3] * units;
+	    for (i = 3; i < 6; i++) s.end[i] = v[i + 2];
+	} else {
+	    if (!strcmp(name, "USE_LENGTH_UNITS")) {
+		units = strstr(args, "INCHES") ? 25.4 :
+		    strstr(args, "CM") ? 10.0 : 1.0;
+	    } else if (!strcmp(name, "SELECT_PLANE")) {
+		plane = strstr(args, "YZ") ? KC_PLANE_YZ :
+		    strstr(args, "XZ") ? KC_PLANE_XZ : KC_PLANE_XY;
+	    } else if (!strcmp(name, "SET_FEED_RATE")) {
+		feed = atof(args);
+	    } else if (!strcmp(name, "SET_FEED_MODE")) {
+		sscanf(args, "%d, %d", &i, &feed_mode);
+	    } else if (!strcmp(name, "SET_XY_ROTATION")) {
+		kc_new_frame()->xy_rotation = atof(args);
+	    } else if (!strcmp(name, "SET_G5X_OFFSET")) {
+		if (sscanf(args, "%d, %lf, %lf, %lf, %lf, %lf, %lf", &n,
+			   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 7)
+		    continue;
+		f = kc_new_frame();
+		for (i = 0; i < 6; i++)
+		    f->g5x[i] = i < 3 ? v[i] * units : v[i];
+	    } else if (!strcmp(name, "SET_G92_OFFSET")) {
+		if (sscanf(args, "%lf, %lf, %lf, %lf, %lf, %lf",
+			   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 6)
+		    continue;
+		f = kc_new_frame();
+		for (i = 0; i < 6; i++)
+		    f->g92[i] = i < 3 ? v[i] * units : v[i];
+	    } else if (!strcmp(name, "USE_TOOL_LENGTH_OFFSET")) {
+		if (sscanf(args, "%lf %lf %lf, %lf %lf %lf",
+			   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 6)
+		    continue;
+		f = kc_new_frame();
+		for (i = 0; i < 6; i++)
+		    f->tool[i] = i < 3 ? v[i] * units : v[i];
+	    }
+	    continue;
+	}
+
+	memcpy(s.start, pos, sizeof(pos));
+	if (s.kind == KC_TRAVERSE)
+	    s.rate = machine.rapid;
+	else if (feed_mode == 0)
+	    s.rate = feed / 60 * (units * machine.units_per_mm);
+	kc_add_segment(&s);
+	memcpy(pos, s.end, sizeof(pos));
+    }
+    return 0;
+}
+
+/***********************************************************************
+*                        CHECKING                                      *
+************************************************************************/
+
+enum { KC_MIN_LIMIT, KC_MAX_LIMIT, KC_VELOCITY, KC_SINGULAR, KC_UNREACHABLE };
+
+typedef struct {
+    int segment;
+    int joint;			/* -1 for unreachable poses */
+    int kind;
+    double value, limit;
+} kc_violation;
+
+typedef struct {
+    KINEMATICS_BATCH batch;
+    int capacity;
+    double seed[KINEMATICS_BATCH_MAX_JOINTS];
+    long points;
+} kc_worker;
+
+static void kc_reserve(kc_worker *w, int n)
+{
+    int c;
+
+    if (n <= w->capacity) return;
+    w->capacity = n;
+    for (c = 0; c < KINEMATICS_BATCH_AXES; c++)
+	w->batch.world[c] = realloc(w->batch.world[c], n * sizeof(double));
+    for (c = 0; c < machine.joints; c++)
+	w->batch.joint[c] = realloc(w->batch.joint[c], n * sizeof(double));
+    w->batch.status = realloc(w->batch.status, n * sizeof(int));
+    for (c = 0; c < KINEMATICS_BATCH_AXES; c++) {
+	if (!w->batch.world[c]) goto nomem;
+	/* u, v and w are not in the canon output */
+	if (c >= 6) memset(w->batch.world[c], 0, n * sizeof(double));
+    }
+    for (c = 0; c < machine.joints; c++)
+	if (!w->batch.joint[c]) goto nomem;
+    if (w->batch.status) return;
+nomem:
+    perror("kinscheck: realloc");
+    exit(2);
+}
+
+/* keep the worst value for each joint and kind of violation */
+static void kc_note(kc_violation *worst, int seg, int joint, int kind,
+		    double value, double limit)
+{
+    kc_violation *v = &worst[(joint + 1) * 5 + kind];
+    double excess = kind == KC_MIN_LIMIT ? limit - value : value - limit;
+
+    if (v->segment < 0
+	|| excess > (kind == KC_MIN_LIMIT ? v->limit - v->value
+		     : v->value - v->limit)) {
+	v->segment = seg;
+	v->joint = joint;
+	v->kind = kind;
+	v->value = value;
+	v->limit = limit;
+    }
+}
+
+static void kc_check_segment(kc_worker *w, int seg, FILE *out)
+{
+    const kc_segment *s = &segs[seg];
+    KINEMATICS_BATCH *b = &w->batch;
+    KINEMATICS_INVERSE_FLAGS iflags = 0;
+    KINEMATICS_FORWARD_FLAGS fflags = 0;
+    kc_violation worst[(KINEMATICS_BATCH_MAX_JOINTS + 1) * 5];
+    double sweep = s->kind == KC_ARC ? kc_arc_sweep(s) : 0;
+    double p[6], m[6], ds = s->length / s->samples;
+    int n = s->samples + 1, i, j, c;
+
+    kc_reserve(w, n);
+    b->n = n;
+    for (i = 0; i < n; i++) {
+	kc_point(s, sweep, (double) i / s->samples, p);
+	kc_to_machine(&frames[s->frame], p, m);
+	for (c = 0; c < 6; c++) b->world[c][i] = m[c];
+    }
+    for (j = 0; j < machine.joints; j++) b->joint[j][0] = w->seed[j];
+
+    if (kins_inverse_batch)
+	kins_inverse_batch(b, &iflags, &fflags);
+    else
+	kinematicsInverseBatchLoop(kins_inverse, b, &iflags, &fflags);
+    w->points += n;
+
+    for (i = 0; i < (int)(sizeof(worst) / sizeof(worst[0])); i++)
+	worst[i].segment = -1;
+    for (i = 0; i < n; i++) {
+	if (b->status[i]) {
+	    kc_note(worst, seg, -1, KC_UNREACHABLE, i, 0);
+	    continue;
+	}
+	for (j = 0; j < machine.joints; j++) {
+	    double q = b->joint[j][i], dq;
+
+	    if (q < machine.min_limit[j])
+		kc_note(worst, seg, j, KC_MIN_LIMIT, q, machine.min_limit[j]);
+	    if (q > machine.max_limit[j])
+		kc_note(worst, seg, j, KC_MAX_LIMIT, q, machine.max_limit[j]);
+	    if (i == 0 || b->status[i - 1] || ds <= 0) continue;
+	    dq = fabs(q - b->joint[j][i - 1]);
+	    if (dq / ds > max_gain)
+		kc_note(worst, seg, j, KC_SINGULAR, dq / ds, max_gain);
+	    if (s->rate > 0 && machine.max_velocity[j] > 0
+		&& dq / ds * s->rate > machine.max_velocity[j])
+		kc_note(worst, seg, j, KC_VELOCITY, dq / ds * s->rate,
+			machine.max_velocity[j]);
+	}
+    }
+    /* the next segment starts where this one ended */
+    if (!b->status[n - 1])
+	for (j = 0; j < machine.joints; j++) w->seed[j] = b->joint[j][n - 1];
+
+    for (i = 0; i < (int)(sizeof(worst) / sizeof(worst[0])); i++)
+	if (worst[i].segment >= 0) fwrite(&worst[i], sizeof(worst[i]), 1, out);
+}
+
+static void kc_check_range(int first, int last, FILE *out)
+{
+    kc_worker w;
+    int seg;
+
+    memset(&w, 0, sizeof(w));
+    memcpy(w.seed, machine.home, sizeof(w.seed));
+    for (seg = first; seg < last; seg++)
+	kc_check_segment(&w, seg, out);
+    fwrite(&w.points, sizeof(w.points), 1, out);
+}
+
+static void kc_report(const kc_violation *v)
+{
+    static const char *what[] = {
+	"below MIN_LIMIT", "above MAX_LIMIT", "exceeds MAX_VELOCITY",
+	"near a singularity", "unreachable",
+    };
+    const kc_segment *s = &segs[v->segment];
+
+    if (v->kind == KC_UNREACHABLE)
+	printf("line %d: %s %s\n", s->line,
+	       s->kind == KC_TRAVERSE ? "traverse" : "move", what[v->kind]);
+    else
+	printf("line %d: joint %d %s: %.4f (limit %.4f)\n", s->line, v->joint,
+	       what[v->kind], v->value, v->limit);
+}
+
+/* divide the segments between the workers by number of samples, run
+   them and print the results in program order */
+static int kc_check(int jobs)
+{
+    FILE *out[jobs];
+    pid_t pid[jobs];
+    int first[jobs + 1];
+    long total = 0, sum = 0, points = 0, violations = 0;
+    int i, k, status, failed = 0;
+
+    for (i = 0; i < n_segs; i++) total += segs[i].samples + 1;
+    first[0] = 0;
+    for (i = 0, k = 1; i < n_segs && k < jobs; i++) {
+	sum += segs[i].samples + 1;
+	if (sum >= total * k / jobs) first[k++] = i + 1;
+    }
+    while (k <= jobs) first[k++] = n_segs;
+
+    for (k = 0; k < jobs; k++) {
+	if (!(out[k] = tmpfile())) {
+	    perror("kinscheck: tmpfile");
+	    return -1;
+	}
+	fflush(stdout);
+	pid[k] = fork();
+	if (pid[k] < 0) {
+	    perror("kinscheck: fork");
+	    return -1;
+	}
+	if (pid[k] == 0) {
+	    kc_check_range(first[k], first[k + 1], out[k]);
+	    fflush(out[k]);
+	    _exit(ferror(out[k]) ? 2 : 0);
+	}
+    }
+
+    for (k = 0; k < jobs; k++) {
+	kc_violation v;
+	long pos, end;
+
+	if (waitpid(pid[k], &status, 0) < 0 || !WIFEXITED(status)
+	    || WEXITSTATUS(status)) {
+	    fprintf(stderr, "kinscheck: worker %d failed\n", k);
+	    failed = 1;
+	    continue;
+	}
+	fseek(out[k], 0, SEEK_END);
+	end = ftell(out[k]) - sizeof(long);
+	rewind(out[k]);
+	for (pos = 0; pos < end; pos += sizeof(v)) {
+	    if (fread(&v, sizeof(v), 1, out[k]) != 1) break;
+	    kc_report(&v);
+	    violations++;
+	}
+	if (fread(&sum, sizeof(sum), 1, out[k]) == 1) points += sum;
+	fclose(out[k]);
+    }
+
+    fprintf(stderr, "kinscheck: %d moves, %ld points, %ld violations\n",
+	    n_segs, points, violations);
+    if (failed) return -1;
+    return violations ? 1 : 0;
+}
+
+/***********************************************************************
+*                        MAIN                                          *
+************************************************************************/
+
+/* run rs274 on a g-code file and return its canon output */
+static FILE *kc_run_rs274(const char *ini, const char *ngc)
+{
+    int fd[2];
+    pid_t pid;
+
+    if (pipe(fd) < 0) return NULL;
+    pid = fork();
+    if (pid < 0) return NULL;
+    if (pid == 0) {
+	dup2(fd[1], 1);
+	close(fd[0]);
+	close(fd[1]);
+	if (ini)
+	    execl(EMC2_BIN_DIR "/rs274", "rs274", "-g", "-N", "-i", ini, ngc,
+		  (char *) NULL);
+	else
+	    execl(EMC2_BIN_DIR "/rs274", "rs274", "-g", "-N", ngc,
+		  (char *) NULL);
+	perror("kinscheck: rs274");
+	_exit(2);
+    }
+    close(fd[1]);
+    return fdopen(fd[0], "r");
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+	"usage: kinscheck [-i inifile] [-k \"kins args\"] [-P name=value]\n"
+	"                 [-r resolution] [-a degrees] [-g gain] [-j jobs]\n"
+	"                 [-v] [file.ngc|canon.txt]\n"
+	"    -i: read kinematics, joints and limits from the ini file\n"
+	"    -k: kinematics module and its arguments, overrides [KINS]KINEMATICS\n"
+	"    -P: set a pin or parameter of the kinematics module\n"
+	"    -r: machine units between samples (default %g)\n"
+	"    -a: degrees between samples of rotary axes (default %g)\n"
+	"    -g: joint motion per unit of tool motion reported as singular (default %g)\n"
+	"    -j: number of worker processes (default: number of cpus)\n"
+	"    -v: print module messages\n",
+	KC_DEFAULT_RES, KC_DEFAULT_ARES, KC_DEFAULT_GAIN);
+}
+
+int main(int argc, char **argv)
+{
+    char kins[KC_LINELEN] = "", *kargs[KC_MAX_ARGS], *tok, *save;
+    const char *ini = NULL, *setp[KC_MAX_ARGS];
+    int nsetp = 0, nkargs = 0, jobs = 0, opt, i, result;
+    FILE *in = stdin;
+
+    for (i = 0; i < KINEMATICS_BATCH_MAX_JOINTS; i++) {
+	machine.min_limit[i] = -1e99;
+	machine.max_limit[i] = 1e99;
+    }
+    while ((opt = getopt(argc, argv, "i:k:P:r:a:g:j:vh")) != -1) {
+	switch (opt) {
+	case 'i': ini = optarg; break;
+	case 'k': snprintf(kins, sizeof(kins), "%s", optarg); break;
+	case 'P':
+	    if (nsetp == KC_MAX_ARGS) { usage(); return 2; }
+	    setp[nsetp++] = optarg;
+	    break;
+	case 'r': resolution = atof(optarg); break;
+	case 'a': angular_resolution = atof(optarg); break;
+	case 'g': max_gain = atof(optarg); break;
+	case 'j': jobs = atoi(optarg); break;
+	case 'v': msg_level = RTAPI_MSG_ALL; break;
+	default: usage(); return 2;
+	}
+    }
+    if (optind < argc - 1 || resolution <= 0 || angular_resolution <= 0
+	|| max_gain <= 0) {
+	usage();
+	return 2;
+    }
+    if (ini && kc_read_ini(ini, kins[0] ? NULL : kins, sizeof(kins)))
+	return 2;
+    if (!kins[0]) {
+	fprintf(stderr, "kinscheck: no kinematics, use -i or -k\n");
+	return 2;
+    }
+    if (jobs <= 0) jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (jobs <= 0) jobs = 1;
+
+    for (tok = strtok_r(kins, " \t", &save); tok && nkargs < KC_MAX_ARGS;
+	 tok = strtok_r(NULL, " \t", &save))
+	kargs[nkargs++] = tok;
+    if (kc_load_kins(kargs, nkargs)) return 2;
+    for (i = 0; i < nsetp; i++)
+	if (kc_setp(setp[i])) return 2;
+
+    if (optind < argc) {
+	const char *file = argv[optind];
+	const char *dot = strrchr(file, '.');
+
+	if (dot && (!strcasecmp(dot, ".ngc") || !strcasecmp(dot, ".nc")))
+	    in = kc_run_rs274(ini, file);
+	else
+	    in = fopen(file, "r");
+	if (!in) {
+	    fprintf(stderr, "kinscheck: can't open %s: %s\n", file,
+		    strerror(errno));
+	    return 2;
+	}
+    }
+    kc_read_canon(in);
+    if (in != stdin) fclose(in);
+    while (wait(NULL) > 0);	/* rs274 */
+
+    if (jobs > n_segs) jobs = n_segs ? n_segs : 1;
+    result = kc_check(jobs);
+    return result < 0 ? 2 : result;
+}
@@ -75,6 +75,46 @@ int kinematicsInverse(const EmcPose * pos,
     return 0;
 }
 
+/* the batch versions move whole columns: each joint array is a copy of
+   the array of the coordinate it is mapped to */
+int kinematicsForwardBatch(KINEMATICS_BATCH * batch,
+                           const KINEMATICS_FORWARD_FLAGS * fflags,
+                           KINEMATICS_INVERSE_FLAGS * iflags)
+{
+    int i, axis;
+
+    for(i = 0; i < EMCMOT_MAX_JOINTS; i++) {
+        axis = axis_idx_for_jno[i];
+        if (axis < 0 || !batch->joint[i] || !batch->world[axis]) continue;
+        memcpy(batch->world[axis], batch->joint[i],
+               batch->n * sizeof(double));
+    }
+    if (batch->status) {
+        memset(batch->status, 0, batch->n * sizeof(int));
+    }
+
+    return 0;
+}
+
+int kinematicsInverseBatch(KINEMATICS_BATCH * batch,
+                           const KINEMATICS_INVERSE_FLAGS * iflags,
+                           KINEMATICS_FORWARD_FLAGS * fflags)
+{
+    int i, axis;
+
+    for(i = 0; i < EMCMOT_MAX_JOINTS; i++) {
+        axis = axis_idx_for_jno[i];
+        if (axis < 0 || !batch->joint[i] || !batch->world[axis]) continue;
+        memcpy(batch->joint[i], batch->world[axis],
+               batch->n * sizeof(double));
+    }
+    if (batch->status) {
+        memset(batch->status, 0, batch->n * sizeof(int));
+    }
+
+    return 0;
+}
+
 /* implemented for these kinematics as giving joints preference */
 int kinematicsHome(EmcPose * world,
                    double *joint,
@@ -98,7 +138,9 @@ static vtkins_t vtk = {
     .kinematicsForward = kinematicsForward,
     .kinematicsInverse  = kinematicsInverse,
     // .kinematicsHome = kinematicsHome,
-    .kinematicsType = kinematicsType
+    .kinematicsType = kinematicsType,
+    .kinematicsForwardBatch = kinematicsForwardBatch,
+    .kinematicsInverseBatch = kinematicsInverseBatch
 };
 
 #define TRIVKINS_DEFAULT_COORDINATES "XYZABCUVW"
@@ -111,6 +153,8 @@ RTAPI_MP_STRING(kinstype, "Kinematics Type (Identity,Both)");
 EXPORT_SYMBOL(kinematicsType);
 EXPORT_SYMBOL(kinematicsForward);
 EXPORT_SYMBOL(kinematicsInverse);
+EXPORT_SYMBOL(kinematicsForwardBatch);
+EXPORT_SYMBOL(kinematicsInverseBatch);
 MODULE_LICENSE("GPL");
 
 static int comp_id;
@@ -74,7 +74,7 @@ void emcmot_config_change(void) {
 
 
 static int init_comm_buffers(void) {
-    int joint_num, axis_num, n;
+    int joint_num, axis_num;
     emcmot_joint_t *joint;
     emcmot_axis_t *axis;
     int retval;
@@ -150,23 +150,6 @@ static int init_comm_buffers(void) {
 	joint->min_ferror = 0.01;
 	joint->max_ferror = 1.0;
 
-	joint->comp.entry = &(joint->comp.array[0]);
-	/* the compensation code has -DBL_MAX at one end of the table
-	   and +DBL_MAX at the other so _all_ commanded positions are
-	   guaranteed to be covered by the table */
-	joint->comp.array[0].nominal = -DBL_MAX;
-	joint->comp.array[0].fwd_trim = 0.0;
-	joint->comp.array[0].rev_trim = 0.0;
-	joint->comp.array[0].fwd_slope = 0.0;
-	joint->comp.array[0].rev_slope = 0.0;
-	for ( n = 1 ; n < EMCMOT_COMP_SIZE+2 ; n++ ) {
-	    joint->comp.array[n].nominal = DBL_MAX;
-	    joint->comp.array[n].fwd_trim = 0.0;
-	    joint->comp.array[n].rev_trim = 0.0;
-	    joint->comp.array[n].fwd_slope = 0.0;
-	    joint->comp.array[n].rev_slope = 0.0;
-	}
-
 	/* init status info */
 	joint->ferror_limit = joint->min_ferror;
 
@@ -196,6 +179,7 @@ static int init_comm_buffers(void) {
     }
 
     emcmotDebug->start_time = time(NULL);
+    emcmotStatusPublish(&emcmotStruct->status_buffers, emcmotStatus);
 
     rtapi_print_msg(RTAPI_MSG_INFO, "MOTION: init_comm_buffers() complete\n");
     return 0;
@@ -491,6 +475,25 @@ int main(int argc, char* argv[]) {
                 );
                 break;
 
+            case EMCMOT_SET_SPLINE:
+                log_print("SET_SPLINE:\n");
+                log_print(
+                    "    pos: x=%.6f, y=%.6f, z=%.6f, a=%.6f, b=%.6f, c=%.6f, u=%.6f, v=%.6f, w=%.6f\n",
+                    c->pos.tran.x, c->pos.tran.y, c->pos.tran.z,
+                    c->pos.a, c->pos.b, c->pos.c,
+                    c->pos.u, c->pos.v, c->pos.w
+                );
+                for (int i = 0; i <= c->turn && i < EMCMOT_MAX_SPLINE_POINTS; i++) {
+                    log_print("    ctrl: x=%.6f, y=%.6f, z=%.6f, weight=%.6f\n",
+                        c->ctrl[i].x, c->ctrl[i].y, c->ctrl[i].z, c->weight[i]);
+                }
+                log_print("    id=%d, motion_type=%d, vel=%.6f, ini_maxvel=%.6f, acc=%.6f, degree=%d\n",
+                    c->id, c->motion_type,
+                    c->vel, c->ini_maxvel,
+                    c->acc, c->turn
+                );
+                break;
+
             case EMCMOT_SET_TELEOP_VECTOR:
                 log_print("SET_TELEOP_VECTOR\n");
                 break;
@@ -701,6 +704,7 @@ int main(int argc, char* argv[]) {
         emcmotStatus->commandNumEcho = c->commandNum;
         emcmotStatus->commandStatus = EMCMOT_COMMAND_OK;
         emcmotStatus->tail = emcmotStatus->head;
+        emcmotStatusPublish(&emcmotStruct->status_buffers, emcmotStatus);
     }
 
     return 0;
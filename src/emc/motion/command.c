@@ -401,6 +401,39 @@ STATIC int is_feed_type(int motion_type)
     }
 }
 
+/*! \function coord_move_added()
+
+  finishes a circle or spline command after tpAddCircle() or
+  tpAddSpline() returned result: aborts on an error, puts back the
+  at-speed wait on a non-fatal one, and clears the error flag otherwise.
+  message takes the line number and the error code.
+
+*/
+STATIC void coord_move_added(int result, const char *message,
+    char issue_atspeed)
+{
+    if (result < 0) {
+        reportError(message, emcmotCommand->id, result);
+        emcmotStatus->commandStatus = EMCMOT_COMMAND_BAD_EXEC;
+        tpAbort(&emcmotDebug->coord_tp);
+        SET_MOTION_ERROR_FLAG(1);
+    } else if (result != 0) {
+        //FIXME! This is a band-aid for a single issue, but there may be
+        //other consequences of non-fatal errors from AddXXX functions. We
+        //either need to fix the root cause (subtle position error after
+        //homing), or have a full restore here.
+        if (issue_atspeed) {
+            emcmotStatus->atspeed_next_feed = 1;
+        }
+    } else {
+        SET_MOTION_ERROR_FLAG(0);
+        /* set flag that indicates all joints need rehoming, if any
+           joint is moved in joint mode, for machines with no forward
+           kins */
+        rehomeAll = 1;
+    }
+}
+
 /*
   emcmotCommandHandler() is called each main cycle to read the
   shared memory buffer
@@ -413,6 +446,7 @@ void emcmotCommandHandler(void *arg, long period)
     emcmot_axis_t *axis;
     double tmp1;
     emcmot_comp_entry_t *comp_entry;
+    emcmot_comp_t *comp;
     char issue_atspeed = 0;
     int abort = 0;
     char* emsg = "";
@@ -1198,28 +1232,47 @@ void emcmotCommandHandler(void *arg, long period)
                             emcmotCommand->vel, emcmotCommand->ini_maxvel,
                             emcmotCommand->acc, emcmotStatus->enables_new,
 			    issue_atspeed, emcmotCommand->tag);
-        if (res_addcircle < 0) {
-            reportError(_("can't add circular move at line %d, error code %d"),
-                    emcmotCommand->id, res_addcircle);
-		emcmotStatus->commandStatus = EMCMOT_COMMAND_BAD_EXEC;
+        coord_move_added(res_addcircle,
+            _("can't add circular move at line %d, error code %d"),
+            issue_atspeed);
+	    break;
+
+	case EMCMOT_SET_SPLINE:
+	    /* emcmotDebug->coord_tp up a spline move */
+	    /* requires coordinated mode, enable on, not on limits */
+	    rtapi_print_msg(RTAPI_MSG_DBG, "SET_SPLINE");
+	    if (!GET_MOTION_COORD_FLAG() || !GET_MOTION_ENABLE_FLAG()) {
+		reportError(_("need to be enabled, in coord mode for spline move"));
+		emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_COMMAND;
+		SET_MOTION_ERROR_FLAG(1);
+		break;
+	    } else if (!inRange(emcmotCommand->pos, emcmotCommand->id, "Spline")) {
+		emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_PARAMS;
+		tpAbort(&emcmotDebug->coord_tp);
+		SET_MOTION_ERROR_FLAG(1);
+		break;
+	    } else if (!limits_ok()) {
+		reportError(_("can't do spline move with limits exceeded"));
+		emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_PARAMS;
 		tpAbort(&emcmotDebug->coord_tp);
 		SET_MOTION_ERROR_FLAG(1);
 		break;
-        } else if (res_addcircle != 0) {
-            //FIXME! This is a band-aid for a single issue, but there may be
-            //other consequences of non-fatal errors from AddXXX functions. We
-            //either need to fix the root cause (subtle position error after
-            //homing), or have a full restore here.
-            if (issue_atspeed) {
-                emcmotStatus->atspeed_next_feed = 1;
-            }
-        } else {
-		SET_MOTION_ERROR_FLAG(0);
-		/* set flag that indicates all joints need rehoming, if any
-		   joint is moved in joint mode, for machines with no forward
-		   kins */
-		rehomeAll = 1;
 	    }
+            if(emcmotStatus->atspeed_next_feed) {
+                issue_atspeed = 1;
+                emcmotStatus->atspeed_next_feed = 0;
+            }
+	    /* append it to the emcmotDebug->coord_tp */
+	    tpSetId(&emcmotDebug->coord_tp, emcmotCommand->id);
+	    int res_addspline = tpAddSpline(&emcmotDebug->coord_tp, emcmotCommand->pos,
+                            emcmotCommand->ctrl, emcmotCommand->weight,
+                            emcmotCommand->turn, emcmotCommand->motion_type,
+                            emcmotCommand->vel, emcmotCommand->ini_maxvel,
+                            emcmotCommand->acc, emcmotStatus->enables_new,
+			    issue_atspeed, emcmotCommand->tag);
+        coord_move_added(res_addspline,
+            _("can't add spline move at line %d, error code %d"),
+            issue_atspeed);
 	    break;
 
 	case EMCMOT_SET_VEL:
@@ -1962,12 +2015,13 @@ void emcmotCommandHandler(void *arg, long period)
 	    if (joint == 0) {
 		break;
 	    }
-	    if (joint->comp.entries >= EMCMOT_COMP_SIZE) {
+	    comp = &joint_comp[joint_num];
+	    if (comp->entries >= EMCMOT_COMP_SIZE) {
 		reportError(_("joint %d: too many compensation entries"), joint_num);
 		break;
 	    }
 	    /* point to last entry */
-	    comp_entry = &(joint->comp.array[joint->comp.entries]);
+	    comp_entry = &(comp->array[comp->entries]);
 	    if (emcmotCommand->comp_nominal <= comp_entry[0].nominal) {
 		reportError(_("joint %d: compensation values must increase"), joint_num);
 		break;
@@ -1989,7 +2043,7 @@ void emcmotCommandHandler(void *arg, long period)
 		comp_entry[0].fwd_trim = comp_entry[1].fwd_trim;
 		comp_entry[0].rev_trim = comp_entry[1].rev_trim;
 	    }
-	    joint->comp.entries++;
+	    comp->entries++;
 	    break;
 
         case EMCMOT_SET_OFFSET:
@@ -261,6 +261,8 @@ void emcmotController(void *arg, long period)
     emcmotStatus->heartbeat++;
     /* set tail to head, to indicate work complete */
     emcmotStatus->tail = emcmotStatus->head;
+    /* make this period's status visible to user space */
+    emcmotStatusPublish(emcmotStatusBuffers, emcmotStatus);
 /* end of controller function */
 }
 
@@ -1662,7 +1664,7 @@ static void compute_screw_comp(void)
 	    continue;
 	}
 	/* point to compensation data */
-	comp = &(joint->comp);
+	comp = &joint_comp[joint_num];
 	if ( comp->entries > 0 ) {
 	    /* there is data in the comp table, use it */
 	    /* first make sure we're in the right spot in the table */
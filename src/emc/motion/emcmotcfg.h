@@ -34,6 +34,10 @@
 #define EMCMOT_MAX_DIO 64
 #define EMCMOT_MAX_AIO 64
 
+/* control points of a spline move, which is a rational Bezier curve of
+   degree up to one less than this */
+#define EMCMOT_MAX_SPLINE_POINTS 4
+
 #if (EMCMOT_MAX_DIO > 64) || (EMCMOT_MAX_AIO > 64)
 #error A 64 bit bitmask is used in the planner.  Don't increase these until that's fixed.
 #endif
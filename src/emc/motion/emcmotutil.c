@@ -85,3 +85,75 @@ int emcmotErrorGet(emcmot_error_t * errlog, char *error)
 
     return 0;
 }
+
+void emcmotStatusPublish(emcmot_status_buffers_t * bufs,
+			 const emcmot_status_t * s)
+{
+    unsigned int next = (bufs->published + 1) % EMCMOT_STATUS_BUFFERS;
+
+    bufs->seq[next]++;
+    __sync_synchronize();
+    memcpy(&bufs->buf[next], s, sizeof(emcmot_status_t));
+    __sync_synchronize();
+    bufs->seq[next]++;
+    __sync_synchronize();
+    bufs->published = next;
+}
+
+/* copy the bytes of one member range of the status */
+static void status_copy(emcmot_status_t * dst, const emcmot_status_t * src,
+			const void *from, const void *to)
+{
+    size_t start = (const char *) from - (const char *) src;
+
+    memcpy((char *) dst + start, from, (const char *) to - (const char *) from);
+}
+
+/* Copies the parts of the newest published status to s.  Returns the
+   number of retries it took, or -1 if the status was being rewritten
+   on every one of 'tries' attempts. */
+int emcmotStatusRead(const emcmot_status_buffers_t * bufs,
+		     emcmot_status_t * s, int parts, int tries)
+{
+    const emcmot_status_t *src;
+    unsigned int n, seq;
+    int retries;
+
+    for (retries = 0; retries < tries; retries++) {
+	n = bufs->published;
+	__sync_synchronize();
+	seq = bufs->seq[n];
+	if (seq & 1) {
+	    continue;
+	}
+	__sync_synchronize();
+	src = &bufs->buf[n];
+	if (parts == EMCMOT_STATUS_ALL) {
+	    memcpy(s, src, sizeof(emcmot_status_t));
+	} else {
+	    if (parts & EMCMOT_STATUS_TRAJ) {
+		status_copy(s, src, src, &src->joint_status[0]);
+		status_copy(s, src, &src->spindleSync, &src->spindle_status[0]);
+		status_copy(s, src, &src->spindle_status[EMCMOT_MAX_SPINDLES],
+			    src + 1);
+	    }
+	    if (parts & EMCMOT_STATUS_JOINTS) {
+		status_copy(s, src, &src->joint_status[0],
+			    &src->joint_status[EMCMOT_MAX_JOINTS]);
+	    }
+	    if (parts & EMCMOT_STATUS_AXES) {
+		status_copy(s, src, &src->axis_status[0],
+			    &src->axis_status[EMCMOT_MAX_AXIS]);
+	    }
+	    if (parts & EMCMOT_STATUS_SPINDLES) {
+		status_copy(s, src, &src->spindle_status[0],
+			    &src->spindle_status[EMCMOT_MAX_SPINDLES]);
+	    }
+	}
+	__sync_synchronize();
+	if (bufs->seq[n] == seq) {
+	    return retries;
+	}
+    }
+    return -1;
+}
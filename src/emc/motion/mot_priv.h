@@ -224,6 +224,11 @@ extern emcmot_hal_data_t *emcmot_hal_data;
    determined by the init code in motion.c */
 extern emcmot_joint_t *joints;
 
+/* pointer to array of leadscrew compensation tables, one per joint.
+   They are kept apart from the joint structs so that the servo
+   period does not have to skip over them */
+extern emcmot_comp_t *joint_comp;
+
 /* pointer to array of axis structs with all axis data */
 extern emcmot_axis_t *axes;
 
@@ -237,6 +242,7 @@ extern double servo_freq;
 extern struct emcmot_struct_t *emcmotStruct;
 extern struct emcmot_command_t *emcmotCommand;
 extern struct emcmot_status_t *emcmotStatus;
+extern struct emcmot_status_buffers_t *emcmotStatusBuffers;
 extern struct emcmot_config_t *emcmotConfig;
 extern struct emcmot_debug_t *emcmotDebug;
 extern struct emcmot_error_t *emcmotError;
@@ -75,9 +75,14 @@ emcmot_joint_t *joints = 0;
 /* pointer to axis data */
 emcmot_axis_t *axes = 0;
 
+/* pointer to joint compensation tables */
+emcmot_comp_t *joint_comp = 0;
+
 #ifndef STRUCTS_IN_SHMEM
 /* allocate array for joint data */
 emcmot_joint_t joint_array[EMCMOT_MAX_JOINTS];
+/* allocate array for joint compensation tables */
+emcmot_comp_t joint_comp_array[EMCMOT_MAX_JOINTS];
 /* allocate array for axis data */
 emcmot_axis_t axis_array[EMCMOT_MAX_AXIS];
 #endif
@@ -98,6 +103,7 @@ emcmot_struct_t *emcmotStruct = 0;
 /* ptrs to either buffered copies or direct memory for command and status */
 struct emcmot_command_t *emcmotCommand = 0;
 struct emcmot_status_t *emcmotStatus = 0;
+struct emcmot_status_buffers_t *emcmotStatusBuffers = 0;	/* published status */
 struct emcmot_config_t *emcmotConfig = 0;
 struct emcmot_debug_t *emcmotDebug = 0;
 struct emcmot_error_t *emcmotError = 0;	/* unused for RT_FIFO */
@@ -701,6 +707,7 @@ static int init_comm_buffers(void)
 {
     int joint_num, axis_num, spindle_num, n;
     emcmot_joint_t *joint;
+    emcmot_comp_t *comp;
     int retval;
 
     rtapi_print_msg(RTAPI_MSG_INFO, "MOTION: init_comm_buffers() starting...\n");
@@ -708,6 +715,7 @@ static int init_comm_buffers(void)
     emcmotStruct = 0;
     emcmotDebug = 0;
     emcmotStatus = 0;
+    emcmotStatusBuffers = 0;
     emcmotCommand = 0;
     emcmotConfig = 0;
 
@@ -731,6 +739,7 @@ static int init_comm_buffers(void)
     /* we'll reference emcmotStruct directly */
     emcmotCommand = &emcmotStruct->command;
     emcmotStatus = &emcmotStruct->status;
+    emcmotStatusBuffers = &emcmotStruct->status_buffers;
     emcmotConfig = &emcmotStruct->config;
     emcmotDebug = &emcmotStruct->debug;
     emcmotError = &emcmotStruct->error;
@@ -796,9 +805,11 @@ static int init_comm_buffers(void)
 #ifdef STRUCTS_IN_SHMEM
     joints = &(emcmotDebug->joints[0]);
     axes = &(emcmotDebug->axes[0]);
+    joint_comp = &(emcmotDebug->joint_comp[0]);
 #else
     joints = &(joint_array[0]);
     axes = &(axis_array[0]);
+    joint_comp = &(joint_comp_array[0]);
 #endif
 
     for (spindle_num = 0; spindle_num < EMCMOT_MAX_SPINDLES; spindle_num++){
@@ -826,22 +837,23 @@ static int init_comm_buffers(void)
 	joint->max_ferror = 1.0;
 	joint->backlash = 0.0;
 
-	joint->comp.entries = 0;
-	joint->comp.entry = &(joint->comp.array[0]);
+	comp = &joint_comp[joint_num];
+	comp->entries = 0;
+	comp->entry = &(comp->array[0]);
 	/* the compensation code has -DBL_MAX at one end of the table
 	   and +DBL_MAX at the other so _all_ commanded positions are
 	   guaranteed to be covered by the table */
-	joint->comp.array[0].nominal = -DBL_MAX;
-	joint->comp.array[0].fwd_trim = 0.0;
-	joint->comp.array[0].rev_trim = 0.0;
-	joint->comp.array[0].fwd_slope = 0.0;
-	joint->comp.array[0].rev_slope = 0.0;
+	comp->array[0].nominal = -DBL_MAX;
+	comp->array[0].fwd_trim = 0.0;
+	comp->array[0].rev_trim = 0.0;
+	comp->array[0].fwd_slope = 0.0;
+	comp->array[0].rev_slope = 0.0;
 	for ( n = 1 ; n < EMCMOT_COMP_SIZE+2 ; n++ ) {
-	    joint->comp.array[n].nominal = DBL_MAX;
-	    joint->comp.array[n].fwd_trim = 0.0;
-	    joint->comp.array[n].rev_trim = 0.0;
-	    joint->comp.array[n].fwd_slope = 0.0;
-	    joint->comp.array[n].rev_slope = 0.0;
+	    comp->array[n].nominal = DBL_MAX;
+	    comp->array[n].fwd_trim = 0.0;
+	    comp->array[n].rev_trim = 0.0;
+	    comp->array[n].fwd_slope = 0.0;
+	    comp->array[n].rev_slope = 0.0;
 	}
 
 	/* init joint flags */
@@ -889,6 +901,7 @@ static int init_comm_buffers(void)
     tpSetAmax(&emcmotDebug->coord_tp, emcmotStatus->acc);
 
     emcmotStatus->tail = 0;
+    emcmotStatusPublish(emcmotStatusBuffers, emcmotStatus);
 
     rtapi_print_msg(RTAPI_MSG_INFO, "MOTION: init_comm_buffers() complete\n");
     return 0;
@@ -127,6 +127,7 @@ extern "C" {
 
 	EMCMOT_SET_LINE,	/* queue up a linear move */
 	EMCMOT_SET_CIRCLE,	/* queue up a circular move */
+	EMCMOT_SET_SPLINE,	/* queue up a spline move */
 	EMCMOT_SET_TELEOP_VECTOR,	/* Move at a given velocity but in
 					   world cartesian coordinates, not
 					   in joint space like EMCMOT_JOG_* */
@@ -223,7 +224,9 @@ extern "C" {
 	EmcPose pos;		/* line/circle endpt, or teleop vector */
 	PmCartesian center;	/* center for circle */
 	PmCartesian normal;	/* normal vec for circle */
-	int turn;		/* turns for circle or joint number for a locking indexer*/
+	int turn;		/* turns for circle, degree for spline, or joint number for a locking indexer*/
+	PmCartesian ctrl[EMCMOT_MAX_SPLINE_POINTS];	/* control points for spline */
+	double weight[EMCMOT_MAX_SPLINE_POINTS];	/* their weights */
 	double vel;		/* max velocity */
         double ini_maxvel;      /* max velocity allowed by machine
                                    constraints (the ini file) */
@@ -450,27 +453,26 @@ Suggestion: Split this in to an Error and a Status flag register..
    copied to a much smaller struct called emcmot_joint_status_t
    which is located in shared memory.
 
+   The servo thread walks all joints several times per period, so
+   the fields it touches every period come first and configuration
+   that only commands use comes last.  The leadscrew compensation
+   table is much larger than all of the rest and only one entry of
+   it is used per period; it is kept in a separate array (see
+   joint_comp in mot_priv.h).  unit_tests/motion/bench_joints
+   measures the per-period passes over this layout.
 */
-    typedef struct {
 
-	/* configuration info - changes rarely */
-	int type;		/* 0 = linear, 1 = rotary */
-	double max_pos_limit;	/* upper soft limit on joint pos */
-	double min_pos_limit;	/* lower soft limit on joint pos */
-	double max_jog_limit;	/* jog limits change when not homed */
-	double min_jog_limit;
-	double vel_limit;	/* upper limit of joint speed */
-	double acc_limit;	/* upper limit of joint accel */
-	double min_ferror;	/* zero speed following error limit */
-	double max_ferror;	/* max speed following error limit */
-	double backlash;	/* amount of backlash */
-	emcmot_comp_t comp;	/* leadscrew correction data */
+    typedef struct {
 
-	/* status info - changes regularly */
-	/* many of these need to be made available to higher levels */
-	/* they can either be copied to the status struct, or an array of
-	   joint structs can be made part of the status */
+	/* servo period state - read and written every servo period by
+	   process_inputs(), handle_jjogwheels(), get_pos_cmds(),
+	   compute_screw_comp() and output_to_hal() */
 	EMCMOT_JOINT_FLAG flag;	/* see above for bit details */
+	int on_pos_limit;	/* non-zero if on limit */
+	int on_neg_limit;	/* non-zero if on limit */
+	int kb_jjog_active;	/* non-zero during a keyboard jog */
+	int wheel_jjog_active;	/* non-zero during a wheel jog */
+	int old_jjog_counts;	/* prior value, used for deltas */
 	double coarse_pos;	/* trajectory point, before interp */
 	double pos_cmd;		/* commanded joint position */
 	double vel_cmd;		/* comanded joint velocity */
@@ -481,24 +483,30 @@ Suggestion: Split this in to an Error and a Status flag register..
 	double motor_pos_cmd;	/* commanded position, with comp */
 	double motor_pos_fb;	/* position feedback, with comp */
 	double pos_fb;		/* position feedback, comp removed */
+	double motor_offset;	/* diff between internal and motor pos, used
+				   to set position to zero during homing */
 	double ferror;		/* following error */
 	double ferror_limit;	/* limit depends on speed */
 	double ferror_high_mark;	/* max following error */
-	simple_tp_t free_tp;	/* planner for free mode motion */
-	int kb_jjog_active;	/* non-zero during a keyboard jog */
-	int wheel_jjog_active;	/* non-zero during a wheel jog */
 
-	/* internal info - changes regularly, not usually accessed from user
-	   space */
-	CUBIC_STRUCT cubic;	/* cubic interpolator data */
+	/* configuration that is checked every servo period */
+	double max_pos_limit;	/* upper soft limit on joint pos */
+	double min_pos_limit;	/* lower soft limit on joint pos */
+	double vel_limit;	/* upper limit of joint speed */
+	double acc_limit;	/* upper limit of joint accel */
+	double min_ferror;	/* zero speed following error limit */
+	double max_ferror;	/* max speed following error limit */
+	double backlash;	/* amount of backlash */
+	double big_vel;		/* used for "debouncing" velocity */
 
-	int on_pos_limit;	/* non-zero if on limit */
-	int on_neg_limit;	/* non-zero if on limit */
+	/* interpolators - used every period in the mode that owns them */
+	CUBIC_STRUCT cubic;	/* cubic interpolator data */
+	simple_tp_t free_tp;	/* planner for free mode motion */
 
-	double motor_offset;	/* diff between internal and motor pos, used
-				   to set position to zero during homing */
-	int old_jjog_counts;	/* prior value, used for deltas */
-	double big_vel;		/* used for "debouncing" velocity */
+	/* configuration - changes rarely */
+	int type;		/* 0 = linear, 1 = rotary */
+	double max_jog_limit;	/* jog limits change when not homed */
+	double min_jog_limit;
     } emcmot_joint_t;
 
 /* This structure contains only the "status" data associated with
@@ -683,6 +691,36 @@ Suggestion: Split this in to an Error and a Status flag register..
 	int numExtraJoints;
     } emcmot_status_t;
 
+/* Published copies of the status structure.
+
+   Motion updates emcmotStatus in place all through the servo period,
+   so a direct copy of it can mix two periods.  At the end of each
+   period the controller copies it into the next of
+   EMCMOT_STATUS_BUFFERS buffers and then publishes the index of that
+   buffer.  Each buffer has a sequence count that is odd while it is
+   being written.  A reader copies from the published buffer and only
+   has to retry if the count changed while it was copying, which
+   takes the controller going all the way around the buffers during
+   one read.  Readers that don't need the whole status can copy just
+   the parts they use.
+*/
+#define EMCMOT_STATUS_BUFFERS 3
+#define EMCMOT_STATUS_READ_TRIES 3
+
+/* parts of the status for emcmotStatusRead() */
+#define EMCMOT_STATUS_TRAJ     0x01	/* everything not in the arrays below */
+#define EMCMOT_STATUS_JOINTS   0x02	/* joint_status[] */
+#define EMCMOT_STATUS_AXES     0x04	/* axis_status[] */
+#define EMCMOT_STATUS_SPINDLES 0x08	/* spindle_status[] */
+#define EMCMOT_STATUS_ALL      0x0f
+
+    typedef struct emcmot_status_buffers_t {
+	volatile unsigned int published;	/* newest complete buffer */
+	volatile unsigned int seq[EMCMOT_STATUS_BUFFERS];	/* odd while
+						   being written */
+	emcmot_status_t buf[EMCMOT_STATUS_BUFFERS];
+    } emcmot_status_buffers_t;
+
 /*********************************
         CONFIG STRUCTURE
 *********************************/
@@ -792,6 +830,12 @@ Suggestion: Split this in to an Error and a Status flag register..
     extern int emcmotErrorPutf(emcmot_error_t * errlog, const char *fmt, ...);
     extern int emcmotErrorGet(emcmot_error_t * errlog, char *error);
 
+/* status publication, see emcmot_status_buffers_t */
+    extern void emcmotStatusPublish(emcmot_status_buffers_t * bufs,
+				    const emcmot_status_t * s);
+    extern int emcmotStatusRead(const emcmot_status_buffers_t * bufs,
+				emcmot_status_t * s, int parts, int tries);
+
 #ifdef __cplusplus
 }
 #endif
@@ -67,6 +67,7 @@ typedef struct emcmot_debug_t {
 #ifdef STRUCTS_IN_SHMEM
 	emcmot_joint_t joints[EMCMOT_MAX_JOINTS];	/* joint data */
 	emcmot_axis_t axes[EMCMOT_MAX_AXIS];	        /* axis data */
+	emcmot_comp_t joint_comp[EMCMOT_MAX_JOINTS];	/* leadscrew comp */
 #endif
 
 	double start_time;
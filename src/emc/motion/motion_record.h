@@ -0,0 +1,64 @@
+/********************************************************************
+* Description: motion_record.h
+*   Format of a recording of the commands task sends to motion, with
+*   samples of the motion status taken while they ran
+*
+* License: GPL Version 2
+* System: Linux
+*
+********************************************************************/
+#ifndef MOTION_RECORD_H
+#define MOTION_RECORD_H
+
+#include <stdint.h>
+#include "emcpos.h"		/* EmcPose */
+
+/*
+  A recording is a motion_record_file_t followed by records, each a
+  motion_record_header_t and then, for a command, the emcmot_command_t
+  as task wrote it, or for a sample, a motion_record_sample_t.  Times
+  are in seconds from the start of the recording.  Commands are copied
+  bit for bit, so a recording can only be replayed by programs built
+  from the same motion.h, which command_size checks.
+*/
+
+#define MOTION_RECORD_MAGIC "LCNCMOTR"
+#define MOTION_RECORD_VERSION 1
+
+/* status is sampled no more often than this, in seconds */
+#define MOTION_RECORD_SAMPLE_INTERVAL 0.005
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t command_size;	/* sizeof(emcmot_command_t) */
+    uint32_t sample_size;	/* sizeof(motion_record_sample_t) */
+    uint32_t reserved;
+} motion_record_file_t;
+
+enum {
+    MOTION_RECORD_COMMAND = 1,	/* accepted by motion */
+    MOTION_RECORD_SAMPLE,
+};
+
+typedef struct {
+    uint32_t type;
+    uint32_t size;		/* of what follows this header */
+    double time;
+} motion_record_header_t;
+
+/* the part of emcmot_status_t a replay is compared with */
+typedef struct {
+    int32_t motion_state;
+    int32_t id;
+    int32_t depth;
+    int32_t activeDepth;
+    int32_t paused;
+    int32_t reserved;
+    double current_vel;
+    double requested_vel;
+    double net_feed_scale;
+    EmcPose carte_pos_cmd;
+} motion_record_sample_t;
+
+#endif				/* MOTION_RECORD_H */
@@ -17,6 +17,8 @@
 	struct emcmot_command_t command;	/* struct used to pass commands/data
 					   to the RT module from usr space */
 	struct emcmot_status_t status;	/* Struct used to store RT status */
+	struct emcmot_status_buffers_t status_buffers;	/* copies of status
+					   published to user space */
 	struct emcmot_config_t config;	/* Struct used to store RT config */
 	struct emcmot_internal_t internal;	/*! \todo FIXME - doesn't need to be in
 					   shared memory */
@@ -24,6 +24,7 @@
 #include "emcmotcfg.h"		/* EMCMOT_ERROR_NUM,LEN */
 #include "emcmotglb.h"		/* SHMEM_KEY */
 #include "usrmotintf.h"		/* these decls */
+#include "motion_record.h"	/* motion_record_file_t */
 #include "_timer.h"
 #include "rcs_print.hh"
 
@@ -40,13 +41,24 @@
 static int inited = 0;		/* flag if inited */
 
 static emcmot_command_t *emcmotCommand = 0;
-static emcmot_status_t *emcmotStatus = 0;
+static emcmot_status_buffers_t *emcmotStatusBuffers = 0;
 static emcmot_config_t *emcmotConfig = 0;
 static emcmot_debug_t *emcmotDebug = 0;
 static emcmot_error_t *emcmotError = 0;
 static emcmot_struct_t *emcmotStruct = 0;
 
-/* usrmotIniLoad() loads params (SHMEM_KEY, COMM_TIMEOUT)
+/* status read statistics, see usrmotGetStatusReadStats() */
+static unsigned long statusReads = 0;
+static unsigned long statusRetries = 0;
+static unsigned long statusFailures = 0;
+
+/* recording of commands and status, see usrmotRecordCommands() */
+static FILE *recordFile = 0;
+static double recordStart = 0.0;
+static double recordLastSample = 0.0;
+static double recordLastFlush = 0.0;
+
+/* usrmotIniLoad() loads params (SHMEM_KEY, COMM_TIMEOUT, COMMAND_RECORD)
    from named ini file */
 int usrmotIniLoad(const char *filename)
 {
@@ -68,6 +80,84 @@ int usrmotIniLoad(const char *filename)
 	return -1;
     }
 
+    /* this is loaded again for each joint and axis; keep the first */
+    const char *record = inifile.Find("COMMAND_RECORD", "EMCMOT");
+    if (record && !recordFile && usrmotRecordCommands(record) != 0) {
+	rcs_print("can't write [EMCMOT] COMMAND_RECORD file %s\n", record);
+    }
+
+    return 0;
+}
+
+static void recordWrite(uint32_t type, double time, const void *data,
+			uint32_t size)
+{
+    motion_record_header_t h;
+
+    h.type = type;
+    h.size = size;
+    h.time = time - recordStart;
+    fwrite(&h, sizeof(h), 1, recordFile);
+    fwrite(data, size, 1, recordFile);
+}
+
+/* record a sample of s if the last was long enough ago */
+static void recordSample(const emcmot_status_t * s)
+{
+    motion_record_sample_t r;
+    double now = etime();
+
+    if (now - recordLastSample < MOTION_RECORD_SAMPLE_INTERVAL) {
+	return;
+    }
+    recordLastSample = now;
+    memset(&r, 0, sizeof(r));
+    r.motion_state = s->motion_state;
+    r.id = s->id;
+    r.depth = s->depth;
+    r.activeDepth = s->activeDepth;
+    r.paused = s->paused;
+    r.current_vel = s->current_vel;
+    r.requested_vel = s->requested_vel;
+    r.net_feed_scale = s->net_feed_scale;
+    r.carte_pos_cmd = s->carte_pos_cmd;
+    recordWrite(MOTION_RECORD_SAMPLE, now, &r, sizeof(r));
+
+    /* leave most of the recording behind if task is killed */
+    if (now - recordLastFlush > 1.0) {
+	fflush(recordFile);
+	recordLastFlush = now;
+    }
+}
+
+int usrmotRecordCommands(const char *file)
+{
+    motion_record_file_t h;
+
+    if (recordFile) {
+	fclose(recordFile);
+	recordFile = 0;
+    }
+    if (!file) {
+	return 0;
+    }
+    recordFile = fopen(file, "wb");
+    if (!recordFile) {
+	return -1;
+    }
+    setvbuf(recordFile, NULL, _IOFBF, 1 << 20);
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MOTION_RECORD_MAGIC, sizeof(h.magic));
+    h.version = MOTION_RECORD_VERSION;
+    h.command_size = sizeof(emcmot_command_t);
+    h.sample_size = sizeof(motion_record_sample_t);
+    if (fwrite(&h, sizeof(h), 1, recordFile) != 1) {
+	fclose(recordFile);
+	recordFile = 0;
+	return -1;
+    }
+    recordStart = recordLastFlush = etime();
+    recordLastSample = 0.0;
     return 0;
 }
 
@@ -77,7 +167,7 @@ int usrmotWriteEmcmotCommand(emcmot_command_t * c)
     emcmot_status_t s;
     static int commandNum = 0;
     static unsigned char headCount = 0;
-    double end;
+    double sent, end;
 
     if (!MOTION_ID_VALID(c->id)) {
         rcs_print("USRMOT: ERROR: invalid motion id: %d\n",c->id);
@@ -96,13 +186,18 @@ int usrmotWriteEmcmotCommand(emcmot_command_t * c)
     *emcmotCommand = *c;
     /* poll for receipt of command */
     /* set timeout for comm failure, now + timeout */
-    end = etime() + EMCMOT_COMM_TIMEOUT;
+    sent = etime();
+    end = sent + EMCMOT_COMM_TIMEOUT;
     /* now check to see if it got it */
     while (etime() < end) {
 	/* update status */
-	if (( usrmotReadEmcmotStatus(&s) == 0 ) && ( s.commandNumEcho == commandNum )) {
+	if (( usrmotReadEmcmotStatusParts(&s, EMCMOT_STATUS_TRAJ) == 0 )
+	    && ( s.commandNumEcho == commandNum )) {
 	    /* now check emcmot status flag */
 	    if (s.commandStatus == EMCMOT_COMMAND_OK) {
+		if (recordFile) {
+		    recordWrite(MOTION_RECORD_COMMAND, sent, c, sizeof(*c));
+		}
 		return EMCMOT_COMM_OK;
 	    } else {
                 rcs_print("USRMOT: ERROR: invalid command\n");
@@ -118,24 +213,39 @@ int usrmotWriteEmcmotCommand(emcmot_command_t * c)
 /* copies status to s */
 int usrmotReadEmcmotStatus(emcmot_status_t * s)
 {
-    int split_read_count;
-    
+    return usrmotReadEmcmotStatusParts(s, EMCMOT_STATUS_ALL);
+}
+
+/* copies the selected parts of the status to s */
+int usrmotReadEmcmotStatusParts(emcmot_status_t * s, int parts)
+{
+    int retries;
+
     /* check for shmem still around */
-    if (0 == emcmotStatus) {
+    if (0 == emcmotStatusBuffers) {
 	return EMCMOT_COMM_ERROR_CONNECT;
     }
-    split_read_count = 0;
-    do {
-	/* copy status struct from shmem to local memory */
-	memcpy(s, emcmotStatus, sizeof(emcmot_status_t));
-	/* got it, now check head-tail matche */
-	if (s->head == s->tail) {
-	    /* head and tail match, done */
-	    return EMCMOT_COMM_OK;
-	}
-	/* inc counter and try again, max three times */
-    } while ( ++split_read_count < 3 );
-    return EMCMOT_COMM_SPLIT_READ_TIMEOUT;
+    retries = emcmotStatusRead(emcmotStatusBuffers, s, parts,
+			       EMCMOT_STATUS_READ_TRIES);
+    statusReads++;
+    if (retries < 0) {
+	statusRetries += EMCMOT_STATUS_READ_TRIES;
+	statusFailures++;
+	return EMCMOT_COMM_SPLIT_READ_TIMEOUT;
+    }
+    statusRetries += retries;
+    if (recordFile && (parts & EMCMOT_STATUS_TRAJ)) {
+	recordSample(s);
+    }
+    return EMCMOT_COMM_OK;
+}
+
+void usrmotGetStatusReadStats(unsigned long *reads, unsigned long *retries,
+			      unsigned long *failures)
+{
+    *reads = statusReads;
+    *retries = statusRetries;
+    *failures = statusFailures;
 }
 
 /* copies config to s */
@@ -664,7 +774,7 @@ int usrmotInit(const char *modname)
     }
     /* got it */
     emcmotCommand = &(emcmotStruct->command);
-    emcmotStatus = &(emcmotStruct->status);
+    emcmotStatusBuffers = &(emcmotStruct->status_buffers);
     emcmotDebug = &(emcmotStruct->debug);
     emcmotConfig = &(emcmotStruct->config);
     emcmotError = &(emcmotStruct->error);
@@ -676,6 +786,7 @@ int usrmotInit(const char *modname)
 
 int usrmotExit(void)
 {
+    usrmotRecordCommands(NULL);
     if (NULL != emcmotStruct) {
 	rtapi_shmem_delete(shmem_id, module_id);
 	rtapi_exit(module_id);
@@ -683,7 +794,7 @@ int usrmotExit(void)
 
     emcmotStruct = 0;
     emcmotCommand = 0;
-    emcmotStatus = 0;
+    emcmotStatusBuffers = 0;
     emcmotError = 0;
 /*! \todo Another #if 0 */
 #if 0
@@ -33,6 +33,19 @@ extern "C" {
    the emcmot controller and puts it in arg */
     extern int usrmotReadEmcmotStatus(emcmot_status_t * s);
 
+/* usrmotReadEmcmotStatusParts() is usrmotReadEmcmotStatus() for
+   readers that only need some of the status.  parts is a mask of
+   EMCMOT_STATUS_TRAJ, _JOINTS, _AXES and _SPINDLES; the rest of s is
+   left as it was */
+    extern int usrmotReadEmcmotStatusParts(emcmot_status_t * s, int parts);
+
+/* usrmotGetStatusReadStats() reports how many status reads were made,
+   how many times a read had to be retried because motion was
+   publishing the buffer being read, and how many reads gave up */
+    extern void usrmotGetStatusReadStats(unsigned long *reads,
+					 unsigned long *retries,
+					 unsigned long *failures);
+
 /* usrmotReadEmcmotConfig() gets the config info out of
    the emcmot controller and puts it in arg */
     extern int usrmotReadEmcmotConfig(emcmot_config_t * s);
@@ -70,6 +83,12 @@ extern "C" {
    Return values are as per the #defines above */
     extern int usrmotWriteEmcmotCommand(emcmot_command_t * c);
 
+/* usrmotRecordCommands() starts recording the commands accepted by
+   motion to file, with samples of the status read back, in the format
+   of motion_record.h.  A null file stops recording.  Returns 0, or -1
+   if file cannot be written */
+    extern int usrmotRecordCommands(const char *file);
+
 /* usrmotInit() initializes communication with the emcmot process */
     extern int usrmotInit(const char *name);
 
@@ -0,0 +1,207 @@
+/********************************************************************
+ * Description: canon_record.cc
+ *
+ *   Binary recording of canonical calls, and reading a recording back
+ *   for canterp to replay
+ *
+ * License: GPL Version 2
+ * System: Linux
+ *
+ ********************************************************************/
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "canon_record.hh"
+#include "state_tag.h"
+
+CanonRecorder canonRecorder;
+
+static size_t padded(size_t n)
+{
+    return (n + 7) & ~(size_t) 7;
+}
+
+int CanonRecorder::open(const char *filename)
+{
+    CanonRecordFileHeader h;
+
+    close();
+    f = fopen(filename, "wb");
+    if (!f) {
+	return -1;
+    }
+    // Records are small; write them out in large blocks
+    setvbuf(f, NULL, _IOFBF, 1 << 20);
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CANON_RECORD_MAGIC, sizeof(h.magic));
+    h.version = CANON_RECORD_VERSION;
+    h.byte_order = CANON_RECORD_BYTE_ORDER;
+    if (fwrite(&h, sizeof(h), 1, f) != 1) {
+	close();
+	return -1;
+    }
+    return 0;
+}
+
+void CanonRecorder::close()
+{
+    if (f) {
+	fclose(f);
+	f = 0;
+    }
+}
+
+void CanonRecorder::record(CanonRecordOp op, int line_number,
+	const double *doubles, size_t ndoubles,
+	const int *ints, size_t nints, const char *s, size_t len)
+{
+    static const char zeros[8] = { 0 };
+    static bool warned;
+    CanonRecordHeader h;
+    size_t nchars = s ? (len == (size_t) -1 ? strlen(s) : len) + 1 : 0;
+
+    if (!f) {
+	return;
+    }
+    if (nchars > UINT16_MAX) {
+	if (!warned) {
+	    fprintf(stderr, "canon recording: argument of call %d cut to %d bytes\n",
+		    op, UINT16_MAX - 1);
+	    warned = true;
+	}
+	nchars = UINT16_MAX;
+    }
+    h.op = op;
+    h.ndoubles = ndoubles;
+    h.nints = nints;
+    h.nchars = nchars;
+    h.line_number = line_number;
+    h.size = sizeof(h) + ndoubles * sizeof(double)
+	+ padded(nints * sizeof(int32_t)) + padded(nchars);
+
+    fwrite(&h, sizeof(h), 1, f);
+    fwrite(doubles, sizeof(double), ndoubles, f);
+    for (size_t i = 0; i < nints; i++) {
+	int32_t v = ints[i];
+	fwrite(&v, sizeof(v), 1, f);
+    }
+    fwrite(zeros, 1, padded(nints * sizeof(int32_t)) - nints * sizeof(int32_t), f);
+    if (nchars) {
+	fwrite(s, 1, nchars - 1, f);
+	fwrite(zeros, 1, 1 + padded(nchars) - nchars, f);
+    }
+
+    // Leave a usable recording behind if the program is stopped after it
+    if (op == CANON_REC_PROGRAM_END) {
+	fflush(f);
+    }
+}
+
+void CanonRecorder::record_tag(state_tag_t const &tag)
+{
+    double d[GM_FIELD_FLOAT_MAX_FIELDS];
+    int i[GM_FIELD_MAX_FIELDS + 2];
+    unsigned long long flags = tag.packed_flags;
+
+    for (int n = 0; n < GM_FIELD_FLOAT_MAX_FIELDS; n++) {
+	d[n] = tag.fields_float[n];
+    }
+    for (int n = 0; n < GM_FIELD_MAX_FIELDS; n++) {
+	i[n] = tag.fields[n];
+    }
+    i[GM_FIELD_MAX_FIELDS] = (uint32_t) flags;
+    i[GM_FIELD_MAX_FIELDS + 1] = (uint32_t) (flags >> 32);
+    record(CANON_REC_UPDATE_TAG, tag.fields[GM_FIELD_LINE_NUMBER],
+	    d, GM_FIELD_FLOAT_MAX_FIELDS, i, GM_FIELD_MAX_FIELDS + 2, 0);
+}
+
+int CanonReplay::open(const char *filename)
+{
+    CanonRecordFileHeader const *h;
+    struct stat st;
+    void *map;
+    int fd;
+
+    close();
+    fd = ::open(filename, O_RDONLY);
+    if (fd < 0) {
+	return -1;
+    }
+    if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(*h)) {
+	::close(fd);
+	return -1;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+	return -1;
+    }
+
+    h = (CanonRecordFileHeader const *) map;
+    if (memcmp(h->magic, CANON_RECORD_MAGIC, sizeof(h->magic))
+	    || h->version != CANON_RECORD_VERSION
+	    || h->byte_order != CANON_RECORD_BYTE_ORDER) {
+	munmap(map, st.st_size);
+	return -1;
+    }
+    // The whole file is read front to back once
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    base = (const char *) map;
+    length = st.st_size;
+    pos = sizeof(*h);
+    cur = 0;
+    return 0;
+}
+
+void CanonReplay::close()
+{
+    if (base) {
+	munmap((void *) base, length);
+	base = 0;
+    }
+    cur = 0;
+}
+
+int CanonReplay::next()
+{
+    CanonRecordHeader const *h;
+
+    if (!base || pos == length) {
+	return 0;
+    }
+    h = (CanonRecordHeader const *) (base + pos);
+    if (length - pos < sizeof(*h) || h->size > length - pos
+	    || h->size < sizeof(*h) + h->ndoubles * sizeof(double)
+		+ padded(h->nints * sizeof(int32_t)) + padded(h->nchars)) {
+	return -1;
+    }
+    cur = h;
+    if (h->nchars && string()[h->nchars - 1]) {
+	cur = 0;
+	return -1;
+    }
+    pos += h->size;
+    return 1;
+}
+
+const double *CanonReplay::doubles() const
+{
+    return (const double *) (cur + 1);
+}
+
+const int32_t *CanonReplay::ints() const
+{
+    return (const int32_t *) (doubles() + cur->ndoubles);
+}
+
+const char *CanonReplay::string() const
+{
+    if (!cur->nchars) {
+	return "";
+    }
+    return (const char *) ints() + padded(cur->nints * sizeof(int32_t));
+}
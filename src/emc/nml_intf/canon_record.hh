@@ -0,0 +1,199 @@
+/********************************************************************
+ * Description: canon_record.hh
+ *
+ *   Binary recording of canonical calls, and reading a recording back
+ *   for canterp to replay
+ *
+ * License: GPL Version 2
+ * System: Linux
+ *
+ ********************************************************************/
+
+#ifndef CANON_RECORD_HH
+#define CANON_RECORD_HH
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <initializer_list>
+
+struct state_tag_t;
+
+/*
+  A recording is a CanonRecordFileHeader followed by records, each a
+  CanonRecordHeader and then its ndoubles doubles, nints 32 bit ints and
+  nchars characters of string, including the terminating nul.  Every part
+  is padded to 8 bytes, so a reader can use the values in place.  Values
+  are in the byte order of the machine that made the recording, which
+  byte_order shows; doubles are copied bit for bit, so a replay passes on
+  exactly the values the interpreter made.
+*/
+
+#define CANON_RECORD_MAGIC "LCNCCANB"
+#define CANON_RECORD_VERSION 1
+#define CANON_RECORD_BYTE_ORDER 0x01020304u
+
+struct CanonRecordFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+};
+
+struct CanonRecordHeader {
+    uint16_t op;		// CanonRecordOp
+    uint16_t ndoubles;
+    uint16_t nints;
+    uint16_t nchars;
+    int32_t line_number;	// 0 for calls that do not take one
+    uint32_t size;		// of the whole record, this header included
+};
+
+/* Numbers are part of the format; add new calls at the end */
+enum CanonRecordOp {
+    CANON_REC_INIT_CANON = 1,
+    CANON_REC_SET_G5X_OFFSET,		// i: origin; d: xyzabcuvw
+    CANON_REC_SET_G92_OFFSET,		// d: xyzabcuvw
+    CANON_REC_SET_XY_ROTATION,		// d: t
+    CANON_REC_USE_LENGTH_UNITS,		// i: units
+    CANON_REC_SELECT_PLANE,		// i: plane
+    CANON_REC_SET_TRAVERSE_RATE,	// d: rate
+    CANON_REC_STRAIGHT_TRAVERSE,	// d: xyzabcuvw
+    CANON_REC_SET_FEED_RATE,		// d: rate
+    CANON_REC_SET_FEED_REFERENCE,	// i: reference
+    CANON_REC_SET_FEED_MODE,		// i: spindle, mode
+    CANON_REC_SET_MOTION_CONTROL_MODE,	// i: mode; d: tolerance
+    CANON_REC_SET_NAIVECAM_TOLERANCE,	// d: tolerance
+    CANON_REC_START_SPEED_FEED_SYNCH,	// i: spindle, velocity_mode; d: feed_per_revolution
+    CANON_REC_STOP_SPEED_FEED_SYNCH,
+    CANON_REC_ARC_FEED,			// i: rotation; d: first_end, second_end,
+					// first_axis, second_axis, axis_end_point, abcuvw
+    CANON_REC_STRAIGHT_FEED,		// d: xyzabcuvw
+    CANON_REC_NURBS_FEED,		// i: k; d: X, Y, W of each control point
+    CANON_REC_RIGID_TAP,		// d: x, y, z, scale
+    CANON_REC_STRAIGHT_PROBE,		// i: probe_type; d: xyzabcuvw
+    CANON_REC_DWELL,			// d: seconds
+    CANON_REC_SET_SPINDLE_MODE,		// i: spindle; d: mode
+    CANON_REC_START_SPINDLE_CLOCKWISE,	// i: spindle, wait_for_atspeed
+    CANON_REC_START_SPINDLE_COUNTERCLOCKWISE,	// i: spindle, wait_for_atspeed
+    CANON_REC_SET_SPINDLE_SPEED,	// i: spindle; d: speed
+    CANON_REC_STOP_SPINDLE_TURNING,	// i: spindle
+    CANON_REC_ORIENT_SPINDLE,		// i: spindle, mode; d: orientation
+    CANON_REC_WAIT_SPINDLE_ORIENT_COMPLETE,	// i: spindle; d: timeout
+    CANON_REC_USE_TOOL_LENGTH_OFFSET,	// d: xyzabcuvw
+    CANON_REC_START_CHANGE,
+    CANON_REC_CHANGE_TOOL,		// i: slot
+    CANON_REC_SELECT_TOOL,		// i: tool
+    CANON_REC_CHANGE_TOOL_NUMBER,	// i: number
+    CANON_REC_COMMENT,			// s
+    CANON_REC_MESSAGE,			// s
+    CANON_REC_DISABLE_FEED_OVERRIDE,
+    CANON_REC_ENABLE_FEED_OVERRIDE,
+    CANON_REC_DISABLE_SPEED_OVERRIDE,	// i: spindle
+    CANON_REC_ENABLE_SPEED_OVERRIDE,	// i: spindle
+    CANON_REC_DISABLE_ADAPTIVE_FEED,
+    CANON_REC_ENABLE_ADAPTIVE_FEED,
+    CANON_REC_DISABLE_FEED_HOLD,
+    CANON_REC_ENABLE_FEED_HOLD,
+    CANON_REC_FLOOD_OFF,
+    CANON_REC_FLOOD_ON,
+    CANON_REC_MIST_OFF,
+    CANON_REC_MIST_ON,
+    CANON_REC_PALLET_SHUTTLE,
+    CANON_REC_TURN_PROBE_OFF,
+    CANON_REC_TURN_PROBE_ON,
+    CANON_REC_SET_MOTION_OUTPUT_BIT,	// i: index
+    CANON_REC_CLEAR_MOTION_OUTPUT_BIT,	// i: index
+    CANON_REC_SET_AUX_OUTPUT_BIT,	// i: index
+    CANON_REC_CLEAR_AUX_OUTPUT_BIT,	// i: index
+    CANON_REC_SET_MOTION_OUTPUT_VALUE,	// i: index; d: value
+    CANON_REC_SET_AUX_OUTPUT_VALUE,	// i: index; d: value
+    CANON_REC_PROGRAM_STOP,
+    CANON_REC_OPTIONAL_PROGRAM_STOP,
+    CANON_REC_PROGRAM_END,
+    CANON_REC_UPDATE_TAG,		// i: fields, packed_flags low and high 32 bits;
+					// d: fields_float
+    CANON_REC_WAIT,			// i: index, input_type, wait_type; d: timeout
+    CANON_REC_UNLOCK_ROTARY,		// i: joint_num
+    CANON_REC_LOCK_ROTARY,		// i: joint_num
+    CANON_REC_SET_TOOL_TABLE_ENTRY,	// i: pocket, toolno, orientation; d: offset
+					// xyzabcuvw, diameter, frontangle, backangle
+    CANON_REC_USE_SPINDLE_FORCE,
+    CANON_REC_USE_NO_SPINDLE_FORCE,
+    CANON_REC_SPINDLE_RETRACT,
+    CANON_REC_SPINDLE_RETRACT_TRAVERSE,
+    CANON_REC_PLUGIN_CALL,		// s: call, nchars - 1 bytes of it
+    CANON_REC_IO_PLUGIN_CALL,		// s: call, nchars - 1 bytes of it
+    CANON_REC_SET_BLOCK_DELETE,		// i: state
+    CANON_REC_SET_OPTIONAL_PROGRAM_STOP,	// i: state
+    CANON_REC_ON_RESET,
+};
+
+class CanonRecorder {
+public:
+    CanonRecorder() : f(0) {}
+    ~CanonRecorder() { close(); }
+
+    /* Start a new recording in filename; returns 0, or -1 if it cannot
+       be written */
+    int open(const char *filename);
+    void close();
+    bool active() const { return f != 0; }
+
+    /* s is recorded up to its nul, or len bytes of it when len is given,
+       for calls that may carry nuls */
+    void record(CanonRecordOp op, int line_number,
+	    std::initializer_list<double> doubles = {},
+	    std::initializer_list<int> ints = {}, const char *s = 0,
+	    size_t len = (size_t) -1) {
+	record(op, line_number, doubles.begin(), doubles.size(),
+		ints.begin(), ints.size(), s, len);
+    }
+    void record(CanonRecordOp op, int line_number,
+	    const double *doubles, size_t ndoubles,
+	    const int *ints, size_t nints, const char *s,
+	    size_t len = (size_t) -1);
+    /* Record UPDATE_TAG(tag) */
+    void record_tag(state_tag_t const &tag);
+
+private:
+    FILE *f;
+};
+
+/* The recording made by this program, if it makes one */
+extern CanonRecorder canonRecorder;
+
+/* Record a call if recording is on, with the arguments of
+   CanonRecorder::record() */
+#define CANON_RECORD(...) do { \
+    if (canonRecorder.active()) canonRecorder.record(__VA_ARGS__); \
+} while (0)
+
+/* A recording mapped into memory, read a record at a time */
+class CanonReplay {
+public:
+    CanonReplay() : base(0), length(0), pos(0), cur(0) {}
+    ~CanonReplay() { close(); }
+
+    /* Returns 0, or -1 if filename cannot be read or is not a recording
+       made on a machine of the same byte order */
+    int open(const char *filename);
+    void close();
+    bool is_open() const { return base != 0; }
+
+    /* Move to the next record; returns 1, 0 at the end of the recording
+       or -1 if the record there is cut short */
+    int next();
+
+    CanonRecordHeader const &header() const { return *cur; }
+    const double *doubles() const;
+    const int32_t *ints() const;
+    const char *string() const;
+
+private:
+    const char *base;
+    size_t length;
+    size_t pos;
+    CanonRecordHeader const *cur;
+};
+
+#endif
@@ -870,6 +870,25 @@ class EMC_TRAJ_CIRCULAR_MOVE:public EMC_TRAJ_CMD_MSG {
     int feed_mode;
 };
 
+class EMC_TRAJ_SPLINE_MOVE:public EMC_TRAJ_CMD_MSG {
+  public:
+    EMC_TRAJ_SPLINE_MOVE():EMC_TRAJ_CMD_MSG(EMC_TRAJ_SPLINE_MOVE_TYPE,
+					    sizeof(EMC_TRAJ_SPLINE_MOVE)) {
+    };
+
+    // For internal NML/CMS use only.
+    void update(CMS * cms);
+
+    EmcPose end;
+    // rational Bezier curve in xyz from the start of the move to end
+    PM_CARTESIAN ctrl[EMCMOT_MAX_SPLINE_POINTS];
+    double weight[EMCMOT_MAX_SPLINE_POINTS];
+    int degree;
+    int type;
+    double vel, ini_maxvel, acc;
+    int feed_mode;
+};
+
 class EMC_TRAJ_SET_TERM_COND:public EMC_TRAJ_CMD_MSG {
   public:
     EMC_TRAJ_SET_TERM_COND():EMC_TRAJ_CMD_MSG(EMC_TRAJ_SET_TERM_COND_TYPE,
@@ -1229,6 +1248,10 @@ class EMC_MOTION_STAT:public EMC_MOTION_STAT_MSG {
     int external_offsets_applied;
     EmcPose eoffset_pose;
     int numExtraJoints;
+    // status reads by task since it started, see usrmotGetStatusReadStats()
+    unsigned long status_reads;
+    unsigned long status_retries;	// torn reads that were read again
+    unsigned long status_failures;	// reads that stayed torn
 };
 
 // declarations for EMC_TASK classes
@@ -1517,6 +1540,9 @@ class EMC_TASK_STAT:public EMC_TASK_STAT_MSG {
     int task_paused;		// non-zero means task is paused
     double delayLeft;           // delay time left of G4, M66..
     int queuedMDIcommands;      // current length of MDI input queue
+    double cycleTime;           // length of the last task cycle, seconds
+    double cycleWorkTime;       // part of cycleTime not spent waiting
+    int motionStarvations;      // times motion's queue ran dry mid-program
 };
 
 // declarations for EMC_TOOL classes
@@ -32,6 +32,8 @@ double emc_io_cycle_time = DEFAULT_EMC_IO_CYCLE_TIME;
 
 int emc_task_interp_max_len = DEFAULT_EMC_TASK_INTERP_MAX_LEN;
 
+int emc_task_arc_fit = 1;
+
 char tool_table_file[LINELEN] = DEFAULT_TOOL_TABLE_FILE;
 
 EmcPose tool_change_position;	/* no defaults */
@@ -48,6 +48,9 @@ extern "C" {
 
     extern int emc_task_interp_max_len;
 
+    /* [TASK] ARC_FIT: also join G64 Q feed moves into arcs */
+    extern int emc_task_arc_fit;
+
     extern char tool_table_file[LINELEN];
 
     extern struct EmcPose tool_change_position;
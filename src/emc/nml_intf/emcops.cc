@@ -110,6 +110,9 @@ EMC_MOTION_STAT_MSG(EMC_MOTION_STAT_TYPE, sizeof(EMC_MOTION_STAT))
     }
 
     debug = 0;
+    status_reads = 0;
+    status_retries = 0;
+    status_failures = 0;
 };
 
 EMC_TASK_STAT::EMC_TASK_STAT():
@@ -150,6 +153,9 @@ EMC_TASK_STAT_MSG(EMC_TASK_STAT_TYPE, sizeof(EMC_TASK_STAT))
     task_paused = 0;
     delayLeft = 0.0;
     queuedMDIcommands = 0;
+    cycleTime = 0.0;
+    cycleWorkTime = 0.0;
+    motionStarvations = 0;
 }
 
 EMC_TOOL_STAT::EMC_TOOL_STAT():
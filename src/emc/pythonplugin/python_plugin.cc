@@ -77,6 +77,8 @@ int PythonPlugin::run_string(const char *cmd, bp::object &retval, bool as_file)
 	else
 	    retval = bp::exec(cmd, main_namespace, main_namespace);
 	status = PLUGIN_OK;
+	// it may have defined or replaced functions
+	callables.clear();
     }
     catch (bp::error_already_set &) {
 	if (PyErr_Occurred()) {
@@ -135,12 +137,10 @@ int PythonPlugin::call(const char *module, const char *callable,
 	return status;
 
     try {
-	if (module == NULL) {  // default to function in toplevel module
-	    function = main_namespace[callable];
-	} else {
-	    bp::object submod =  main_namespace[module];
-	    bp::object submod_namespace = submod.attr("__dict__");
-	    function = submod_namespace[callable];
+	function = find_callable(module, callable);
+	if (function.ptr() == Py_None) {
+	    PyErr_Format(PyExc_KeyError, "%s", callable);
+	    bp::throw_error_already_set();
 	}
 	// this wont work with boost-python1.34 - needs 1.40
 	//retval = function(*tupleargs, **kwargs);
@@ -173,18 +173,18 @@ int PythonPlugin::call(const char *module, const char *callable,
     return status;
 }
 
-bool PythonPlugin::is_callable(const char *module,
-			       const char *funcname)
+// look up [module.]funcname once; later calls get the object found then,
+// which saves the namespace lookups and the KeyError for names that
+// are not there, like NGC subs checked against the oword module
+bp::object PythonPlugin::find_callable(const char *module,
+				       const char *funcname)
 {
-    bool unexpected = false;
-    bool result = false;
+    std::string key = module ? std::string(module) + "." + funcname : funcname;
+    std::map<std::string, bp::object>::iterator it = callables.find(key);
     bp::object function;
 
-    reload();
-    if ((status != PLUGIN_OK) ||
-	(funcname == NULL)) {
-	return false;
-    }
+    if (it != callables.end())
+	return it->second;
     try {
 	if (module == NULL) {  // default to function in toplevel module
 	   function = main_namespace[funcname];
@@ -193,22 +193,38 @@ bool PythonPlugin::is_callable(const char *module,
 	    bp::object submod_namespace = submod.attr("__dict__");
 	    function = submod_namespace[funcname];
 	}
-	result = PyCallable_Check(function.ptr());
+	if (!PyCallable_Check(function.ptr()))
+	    function = bp::object();
     }
     catch (bp::error_already_set &) {
 	// KeyError expected if not callable
 	if (!PyErr_ExceptionMatches(PyExc_KeyError)) {
-	    // something else, strange
+	    // something else, strange; look again next time
 	    exception_msg = handle_pyerror();
-	    unexpected = true;
+	    logPP(0, "find_callable(%s%s%s): unexpected exception:\n%s",
+		  module ? module : "", module ? "." : "",
+		  funcname, exception_msg.c_str());
+	    PyErr_Clear();
+	    return bp::object();
 	}
-	result = false;
 	PyErr_Clear();
+	function = bp::object();
     }
-    if (unexpected)
-	logPP(0, "is_callable(%s%s%s): unexpected exception:\n%s",
-	      module ? module : "", module ? "." : "",
-	      funcname,exception_msg.c_str());
+    callables[key] = function;
+    return function;
+}
+
+bool PythonPlugin::is_callable(const char *module,
+			       const char *funcname)
+{
+    bool result;
+
+    reload();
+    if ((status != PLUGIN_OK) ||
+	(funcname == NULL)) {
+	return false;
+    }
+    result = find_callable(module, funcname).ptr() != Py_None;
 
     if (log_level)
 	logPP(4, "is_callable(%s%s%s) = %s",
@@ -265,6 +281,8 @@ int PythonPlugin::initialize()
 {
     std::string msg;
     if (Py_IsInitialized()) {
+	// the modules are about to be run again
+	callables.clear();
 	try {
 	    bp::object module = bp::import("__main__");
 	    main_namespace = module.attr("__dict__");
@@ -26,6 +26,7 @@
 
 #include <vector>
 #include <string>
+#include <map>
 #include <sys/types.h>
 
 
@@ -81,7 +82,11 @@ private:
     ~PythonPlugin() {};
 
     int reload();
+    boost::python::object find_callable(const char *module, const char *funcname);
     std::vector<std::string> inittab_entries;
+    // [module.]funcname -> the callable, or None; looked up on first use
+    // and kept until the next initialize()
+    std::map<std::string, boost::python::object> callables;
     int status;
     time_t module_mtime;                  // toplevel module - last modification time
     bool reload_on_change;                // auto-reload if toplevel module was changed
@@ -713,7 +713,7 @@ int Interp::find_tool_pocket(setup_pointer settings, int toolno, int *pocket)
         return INTERP_OK;
     }
     *pocket = -1;
-    for(int i=0; i<CANON_POCKETS_MAX; i++) {
+    for(size_t i=0; i<settings->tool_table.size(); i++) {
         if(settings->tool_table[i].toolno == toolno)
             *pocket = settings->tool_table[i].pocketno;
     }
@@ -729,7 +729,7 @@ int Interp::find_tool_index(setup_pointer settings, int toolno, int *index)
         return INTERP_OK;
     }
     *index = -1;
-    for(int i=0; i<CANON_POCKETS_MAX; i++) {
+    for(size_t i=0; i<settings->tool_table.size(); i++) {
         if(settings->tool_table[i].toolno == toolno)
             *index = i;
     }
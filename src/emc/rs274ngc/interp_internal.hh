@@ -20,6 +20,7 @@
 #include <set>
 #include <map>
 #include <bitset>
+#include <vector>
 #include "canon.hh"
 #include "emcpos.h"
 #include "libintl.h"
@@ -295,6 +296,10 @@ std::string toString(GCodes g);
 // name of parameter file for saving/restoring interpreter variables
 #define RS274NGC_PARAMETER_FILE_NAME_DEFAULT "rs274ngc.var"
 #define RS274NGC_PARAMETER_FILE_BACKUP_SUFFIX ".bak"
+// changes since the parameter file was last written are appended here
+#define RS274NGC_PARAMETER_JOURNAL_SUFFIX ".journal"
+// rewrite the parameter file once the journal has this many entries
+#define RS274NGC_PARAMETER_JOURNAL_MAX 1000
 
 // Subroutine parameters
 #define INTERP_SUB_PARAMS 30
@@ -403,6 +408,8 @@ struct remap_struct {
     const char *remap_py;    // Py function maybe  null, OR
     const char *remap_ngc;   // NGC file, maybe  null
     const char *epilog_func; // Py function or null
+    long calls;              // times the code was remapped
+    double py_time;          // seconds spent in its Python functions
 };
 
 
@@ -755,7 +762,8 @@ struct setup
   int stack_index;              // index into the stack
   EmcPose tool_offset;          // tool length offset
   int pockets_max;                 // number of pockets in carousel (including pocket 0, the spindle)
-  CANON_TOOL_TABLE tool_table[CANON_POCKETS_MAX];      // index is pocket number
+  // index is pocket number; pockets_max entries, at least CANON_POCKETS_MAX
+  std::vector<CANON_TOOL_TABLE> tool_table;
   double traverse_rate;         // rate for traverse motions
   double orient_offset;         // added to M19 R word, from [RS274NGC]ORIENT_OFFSET
 
@@ -819,6 +827,7 @@ struct setup
 #define FEATURE_OWORD_WARNONLY       0x00000020
 
     boost::python::object *pythis;  // boost::cref to 'this'
+    boost::python::object *pyself;  // the tuple (this,), the arguments of most handlers
     const char *on_abort_command;
     int_remap_map  g_remapped,m_remapped;
     remap_map remaps;
@@ -346,14 +346,10 @@ int Interp::find_named_param(
 	  CHP(lookup_named_param(nameBuf, pv->value, value));
 	  *status = 1;
       } else if (pv->attr & PA_PYTHON) {
-	  bp::object retval, tupleargs, kwargs;
-	  bp::list plist;
+	  bp::object retval;
 
-	  plist.append(*_setup.pythis); // self
-	  tupleargs = bp::tuple(plist);
-	  kwargs = bp::dict();
-
-	  python_plugin->call(NAMEDPARAMS_MODULE, nameBuf, tupleargs, kwargs, retval);
+	  python_plugin->call(NAMEDPARAMS_MODULE, nameBuf, *_setup.pyself,
+			      bp::dict(), retval);
 	  CHKS(python_plugin->plugin_status() == PLUGIN_EXCEPTION,
 	       "named param - pycall(%s):\n%s", nameBuf,
 	       python_plugin->last_exception().c_str());
@@ -186,7 +186,6 @@ int Interp::execute_call(setup_pointer settings,
 {
     int status = INTERP_OK;
     int i;
-    bp::list plist;
 
     context_pointer previous_frame = &settings->sub_context[settings->call_level-1];
 
@@ -290,10 +289,15 @@ int Interp::execute_call(setup_pointer settings,
 	    settings->value_returned = 0;
 	    previous_frame->sequence_number = settings->sequence_number;
 	    previous_frame->filename = strstore(settings->filename);
-	    plist.append(*settings->pythis); // self
-	    for(int i = 0; i < eblock->param_cnt; i++)
-		plist.append(eblock->params[i]); // positonal args
-	    current_frame->pystuff.impl->tupleargs = bp::tuple(plist);
+	    if (eblock->param_cnt == 0) {
+		current_frame->pystuff.impl->tupleargs = *settings->pyself;
+	    } else {
+		bp::list plist;
+		plist.append(*settings->pythis); // self
+		for(int i = 0; i < eblock->param_cnt; i++)
+		    plist.append(eblock->params[i]); // positonal args
+		current_frame->pystuff.impl->tupleargs = bp::tuple(plist);
+	    }
 	    current_frame->pystuff.impl->kwargs = bp::dict();
 
 	case CS_REEXEC_PYOSUB:
@@ -327,8 +331,7 @@ int Interp::execute_call(setup_pointer settings,
 	    if (remap->remap_py || remap->prolog_func || remap->epilog_func) {
 		CHKS(!PYUSABLE, "%s (remapped) uses Python functions, but the Python plugin is not available", 
 		     remap->name);
-		plist.append(*settings->pythis);   //self
-		current_frame->pystuff.impl->tupleargs = bp::tuple(plist);
+		current_frame->pystuff.impl->tupleargs = *settings->pyself;
 		current_frame->pystuff.impl->kwargs = bp::dict();
 	    }
 	    if (remap->argspec && (strchr(remap->argspec, '@') == NULL)) {
@@ -51,6 +51,7 @@ namespace bp = boost::python;
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <exception>
+#include <time.h>
 
 #include "rs274ngc.hh"
 #include "interp_return.hh"
@@ -98,6 +99,23 @@ std::string handle_pyerror()
     }
 }
 
+static double monotonic_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// charges the time until it goes out of scope to a remap's py_time
+class remap_timer {
+public:
+    remap_timer(remap_pointer r) : remap(r), start(r ? monotonic_time() : 0.0) {}
+    ~remap_timer() { if (remap) remap->py_time += monotonic_time() - start; }
+private:
+    remap_pointer remap;
+    double start;
+};
+
 int Interp::py_reload()
 {
     if (PYUSABLE) {
@@ -138,6 +156,9 @@ int Interp::pycall(setup_pointer settings,
     CHKS(!PYUSABLE, "pycall(%s): Pyhton plugin not initialized",funcname);
     frame->pystuff.impl->py_return_type = 0;
 
+    bool in_remap = calltype >= PY_PROLOG && calltype <= PY_FINISH_EPILOG;
+    remap_timer timer(in_remap ? CONTROLLING_BLOCK(_setup).executing_remap : NULL);
+
     switch (calltype) {
     case PY_EXECUTE: // just run a string
 	python_plugin->run_string(funcname, retval);
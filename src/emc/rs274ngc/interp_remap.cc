@@ -122,6 +122,7 @@ int Interp::convert_remapped_code(block_pointer block,
     // the controlling block holds all dynamic remap information.
     cblock = &CONTROLLING_BLOCK(*settings);
     cblock->executing_remap = remap; // the current descriptor
+    remap->calls++;
     cblock->param_cnt = 0;
 
     if (remap->argspec && (strchr(remap->argspec, '@') != NULL)) {
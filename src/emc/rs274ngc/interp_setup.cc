@@ -132,7 +132,7 @@ setup::setup() :
     stack_index(0),
     tool_offset{{0,0,0},0,0,0,0,0,0},
     pockets_max(0),
-    tool_table{},
+    tool_table(CANON_POCKETS_MAX),
     traverse_rate (0.0),
     orient_offset (0.0),
 
@@ -179,6 +179,7 @@ setup::setup() :
     loop_on_main_m99(false),
     disable_g92_persistence(0),
     pythis(),
+    pyself(),
     on_abort_command(NULL),
     init_once(CANON_STOPPED)
 {
@@ -187,6 +188,7 @@ setup::setup() :
 
 setup::~setup() {
     assert(!pythis || Py_IsInitialized());
+    if(pyself) delete pyself;
     if(pythis) delete pythis;
 }
 
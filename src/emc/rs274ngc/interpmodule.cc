@@ -23,6 +23,7 @@
 #define BOOST_PYTHON_MAX_ARITY 4
 #include <boost/python/class.hpp>
 #include <boost/python/def.hpp>
+#include <boost/python/dict.hpp>
 #include <boost/python/exception_translator.hpp>
 #include <boost/python/module.hpp>
 #include <boost/python/suite/indexing/map_indexing_suite.hpp>
@@ -75,7 +76,7 @@ static  parameters_array parameters_wrapper ( Interp & inst) {
 }
 
 static  tool_table_array tool_table_wrapper ( Interp & inst) {
-    return tool_table_array(inst._setup.tool_table);
+    return tool_table_array(inst._setup.tool_table.data());
 }
 
 static  sub_context_array sub_context_wrapper ( Interp & inst) {
@@ -233,6 +234,18 @@ static int wrap_interp_read(Interp &interp, const char *command)
 //     return interp._setup.remaps;
 // }
 
+// {code: (calls, seconds in Python)} for the remaps used so far
+static bp::dict remap_stats(Interp &interp)  {
+    bp::dict stats;
+    for (remap_map::iterator it = interp._setup.remaps.begin();
+	 it != interp._setup.remaps.end(); ++it) {
+	if (it->second.calls)
+	    stats[it->first] = bp::make_tuple(it->second.calls,
+					      it->second.py_time);
+    }
+    return stats;
+}
+
 // what a barren desert
 static inline EmcPose get_tool_offset (Interp &interp)  {
     return interp._setup.tool_offset;
@@ -868,6 +881,7 @@ BOOST_PYTHON_MODULE(interpreter) {
 
 	// until I know better
 	//.def_readwrite("remaps",  &wrap_remaps)
+	.def("remap_stats", &remap_stats)
 
 	.add_property("task", &get_task) // R/O
 	.add_property("filename", &get_filename) // R/O
@@ -98,6 +98,8 @@ void export_Internals()
 	.def_readwrite("remap_ngc",&remap::remap_ngc)
 	.def_readwrite("epilog_func",&remap::epilog_func)
 	.def_readwrite("motion_code",&remap::motion_code)
+	.def_readonly("calls",&remap::calls)
+	.def_readonly("py_time",&remap::py_time)
 	.def("__str__", &remap_str)
 
 	;
@@ -16,6 +16,8 @@
 
 #ifndef RS274NGC_INTERP_H
 #define RS274NGC_INTERP_H
+#include <string>
+#include <vector>
 #include "rs274ngc.hh"
 #include "interp_internal.hh"
 #include "interp_return.hh"
@@ -64,7 +66,8 @@ public:
 
 // save interpreter variables to file
  int save_parameters(const char *filename,
-                                    const double parameters[]);
+                                    const double parameters[],
+                                    bool compact = false);
 
 // synchronize your internal model with the external world
  int synch();
@@ -716,6 +719,15 @@ int read_inputs(setup_pointer settings);
 
  setup _setup;
 
+ // the parameter file as it is on disk, the .var file plus its journal;
+ // see Interp::save_parameters
+ int rewrite_parameters(const char *filename, const double parameters[]);
+ int replay_parameter_journal(const char *filename, double parameters[]);
+ std::string _var_file;
+ std::vector<double> _var_saved;
+ std::vector<bool> _var_persistent;
+ int _var_journal_entries = 0;
+
  enum {
      AXIS_MASK_X =   1, AXIS_MASK_Y =   2, AXIS_MASK_Z =   4,
      AXIS_MASK_A =   8, AXIS_MASK_B =  16, AXIS_MASK_C =  32,
@@ -81,6 +81,7 @@ include an option for suppressing superfluous commands.
 #include <ctype.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <stdarg.h>
 #include <sys/time.h>
 #include <time.h>
@@ -150,6 +151,7 @@ Interp::Interp()
     // wrapper instance on every init(), abandoning the old one and all user attributes
     // tacked onto it, so make sure this is done exactly once
     _setup.pythis = new boost::python::object(boost::cref(*this));
+    _setup.pyself = new boost::python::object(bp::make_tuple(*_setup.pythis));
 	
     // alias to 'interpreter.this' for the sake of ';py, .... ' comments
     // besides 'this', eventually use proper instance names to handle
@@ -769,9 +771,16 @@ int Interp::exit()
   save_parameters(((file_name[0] ==
                              0) ?
                             RS274NGC_PARAMETER_FILE_NAME_DEFAULT :
-                            file_name), _setup.parameters);
+                            file_name), _setup.parameters, true);
   reset();
 
+  for (remap_map::iterator it = _setup.remaps.begin();
+       it != _setup.remaps.end(); ++it) {
+      if (it->second.calls)
+	  logRemap("remap %s: %ld calls, %.3f s in Python", it->first,
+		   it->second.calls, it->second.py_time);
+  }
+
   // interpreter shutdown Python hook
   if (python_plugin->is_callable(NULL, DELETE_FUNC)) {
 
@@ -1307,10 +1316,7 @@ void Interp::set_loop_on_main_m99(bool state) {
 
 /*! Interp::load_tool_table
 
-Returned Value: int
-   If any of the following errors occur, this returns the error code shown.
-   Otherwise, this returns INTERP_OK.
-   1. _setup.tool_max is larger than CANON_TOOL_MAX: NCE_TOOL_MAX_TOO_LARGE
+Returned Value: int (INTERP_OK)
 
 Side Effects:
    _setup.tool_table[] is modified.
@@ -1322,8 +1328,8 @@ Called By:
 This function calls the canonical interface function GET_EXTERNAL_TOOL_TABLE
 to load the whole tool table into the _setup.
 
-The CANON_TOOL_MAX is an upper limit for this software. The
-_setup.tool_max is intended to be set for a particular machine.
+_setup.pockets_max comes from GET_EXTERNAL_POCKETS_MAX and may be more
+than CANON_POCKETS_MAX; the table is sized to fit.
 
 */
 
@@ -1331,11 +1337,12 @@ int Interp::load_tool_table()
 {
   int n;
 
-  CHKS((_setup.pockets_max > CANON_POCKETS_MAX), NCE_POCKET_MAX_TOO_LARGE);
+  // the Python tool_table array is CANON_POCKETS_MAX long
+  _setup.tool_table.resize(std::max(_setup.pockets_max, CANON_POCKETS_MAX));
   for (n = 0; n < _setup.pockets_max; n++) {
     _setup.tool_table[n] = GET_EXTERNAL_TOOL_TABLE(n);
   }
-  for (; n < CANON_POCKETS_MAX; n++) {
+  for (; n < (int)_setup.tool_table.size(); n++) {
     _setup.tool_table[n].toolno = -1;
     ZERO_EMC_POSE(_setup.tool_table[n].offset);
     _setup.tool_table[n].diameter = 0;
@@ -1828,6 +1835,9 @@ array. These are the axis offsets, the origin index (5220), and nine
 sets of origin offsets. Any parameter not given a value in the file
 has its value set to zero.
 
+Changes saved since the file was last rewritten are then read from the
+journal next to it, see Interp::save_parameters.
+
 */
 int Interp::restore_parameters(const char *filename)   //!< name of parameter file to read  
 {
@@ -1840,15 +1850,23 @@ int Interp::restore_parameters(const char *filename)   //!< name of parameter fi
   double *pars;                 // short name for _setup.parameters
   int k;
 
+  pars = _setup.parameters;
+  _var_file = filename;
+  _var_persistent.assign(RS274NGC_MAX_PARAMETERS, false);
+  for (index = 0; _required_parameters[index] != RS274NGC_MAX_PARAMETERS; index++)
+    _var_persistent[_required_parameters[index]] = true;
+
   // it's OK if the parameter file doesn't exist yet
   // it'll be created in due course with some default values
-  if(access(filename, F_OK) == -1)
+  if(access(filename, F_OK) == -1) {
+      CHP(replay_parameter_journal(filename, pars));
+      _var_saved.assign(pars, pars + RS274NGC_MAX_PARAMETERS);
       return INTERP_OK;
+  }
   // open original for reading
   infile = fopen(filename, "r");
   CHKS((infile == NULL), _("Unable to open parameter file: '%s'"), filename);
 
-  pars = _setup.parameters;
   k = 0;
   index = 0;
   required = _required_parameters[index++];
@@ -1867,6 +1885,7 @@ int Interp::restore_parameters(const char *filename)   //!< name of parameter fi
           ERS(NCE_PARAMETER_FILE_OUT_OF_ORDER);
         } else if (k == variable) {
           pars[k] = value;
+          _var_persistent[k] = true;
           if (k == required)
             required = _required_parameters[index++];
           k++;
@@ -1884,6 +1903,73 @@ int Interp::restore_parameters(const char *filename)   //!< name of parameter fi
   for (; k < RS274NGC_MAX_PARAMETERS; k++) {
     pars[k] = 0;
   }
+  CHP(replay_parameter_journal(filename, pars));
+  _var_saved.assign(pars, pars + RS274NGC_MAX_PARAMETERS);
+  return INTERP_OK;
+}
+
+/***********************************************************************/
+
+/*! Interp::replay_parameter_journal
+
+Returned Value: int (INTERP_OK)
+
+Side Effects: See below
+
+Called By: Interp::restore_parameters
+
+Applies the journal of the parameter file filename, if there is one, to
+parameters.  The journal is written by Interp::save_parameters as
+batches of
+
+<variable number> <value>
+
+lines, each batch followed by a line holding only a period.  A batch
+that was not finished when the controller stopped has no period after
+it, so it is ignored and cut off the journal, and the parameters come
+back as they were at the end of the last complete save.  Every variable in the journal is written
+to the parameter file the next time it is rewritten.
+
+*/
+int Interp::replay_parameter_journal(const char *filename,
+                                     double parameters[])
+{
+  std::string journal = std::string(filename)
+                            + RS274NGC_PARAMETER_JOURNAL_SUFFIX;
+  std::vector<std::pair<int, double> > batch;
+  char line[256];
+  int variable;
+  double value;
+  long complete = 0;             // length of the complete batches
+  FILE *infile;
+
+  _var_journal_entries = 0;
+  infile = fopen(journal.c_str(), "r");
+  if (infile == NULL)
+    return INTERP_OK;
+  while (fgets(line, sizeof(line), infile) != NULL) {
+    if (strcmp(line, ".\n") == 0) {
+      for (size_t i = 0; i < batch.size(); i++) {
+        parameters[batch[i].first] = batch[i].second;
+        _var_persistent[batch[i].first] = true;
+      }
+      _var_journal_entries += batch.size();
+      batch.clear();
+      complete = ftell(infile);
+    } else if (sscanf(line, "%d %lf", &variable, &value) == 2
+               && variable > 0 && variable < RS274NGC_MAX_PARAMETERS
+               && strchr(line, '\n')) {
+      batch.push_back(std::make_pair(variable, value));
+    }
+  }
+  // cut off the unfinished batch, or the next one would be appended to it
+  if (ftell(infile) != complete) {
+    fprintf(stderr, "%s: ignoring %d parameters from an unfinished save\n",
+            journal.c_str(), (int) batch.size());
+    if (truncate(journal.c_str(), complete) < 0)
+      perror("truncate (replaying variable journal)");
+  }
+  fclose(infile);
   return INTERP_OK;
 }
 
@@ -1891,20 +1977,101 @@ int Interp::restore_parameters(const char *filename)   //!< name of parameter fi
 
 /*! Interp::save_parameters
 
+Returned Value:
+  If any of the following errors occur, this returns the error code shown.
+  Otherwise it returns INTERP_OK.
+  1. The journal cannot be opened to append: NCE_CANNOT_OPEN_VARIABLE_FILE
+  2. The journal cannot be written or synced: NCE_CANNOT_WRITE_VARIABLE_FILE
+  3. Interp::rewrite_parameters fails: its error code
+
+Side Effects: See below
+
+Called By:
+   external programs
+   Interp::exit
+   Interp::synch
+
+Saves the parameters that are kept in the parameter file.  If filename
+is the file the parameters were restored from, the ones that changed
+since the last save are appended to its journal as one batch and the
+journal is synced to disk, so a save costs as much as the change and
+nothing at all when nothing changed.  A batch that cannot be written
+completely is cut off the journal again.  Interp::restore_parameters
+replays the journal, so the values survive a crash.
+
+When compact is set, when the journal grows past
+RS274NGC_PARAMETER_JOURNAL_MAX entries or when filename is some other
+file, the whole file is rewritten by Interp::rewrite_parameters and the
+journal is removed.
+
+*/
+int Interp::save_parameters(const char *filename,      //!< name of file to write
+                             const double parameters[], //!< parameters to save
+                             bool compact)             //!< also rewrite the file
+{
+  std::vector<int> changed;
+  int k;
+
+  if (_var_file != filename || _var_saved.empty()) {
+    CHP(rewrite_parameters(filename, parameters));
+    return INTERP_OK;
+  }
+
+  for (k = 1; k < RS274NGC_MAX_PARAMETERS; k++) {
+    if (_var_persistent[k] && parameters[k] != _var_saved[k])
+      changed.push_back(k);
+  }
+
+  if (!changed.empty()) {
+    std::string journal = std::string(filename)
+                              + RS274NGC_PARAMETER_JOURNAL_SUFFIX;
+    FILE *outfile = fopen(journal.c_str(), "a");
+    CHKS((outfile == NULL), NCE_CANNOT_OPEN_VARIABLE_FILE);
+    off_t start = lseek(fileno(outfile), 0, SEEK_END);
+    bool written = (start >= 0);
+    for (size_t i = 0; written && i < changed.size(); i++)
+      written = fprintf(outfile, "%d\t%f\n",
+                        changed[i], parameters[changed[i]]) > 0;
+    written = written && fputs(".\n", outfile) >= 0
+                      && fflush(outfile) == 0
+                      && fdatasync(fileno(outfile)) == 0;
+    if (!written) {
+      perror("writing variable journal");
+      // leave no partial batch behind; it is written again next time
+      if (start >= 0 && ftruncate(fileno(outfile), start) < 0)
+        perror("ftruncate (variable journal)");
+    }
+    if (fclose(outfile) != 0)
+      written = false;
+    CHKS(!written, NCE_CANNOT_WRITE_VARIABLE_FILE);
+    for (size_t i = 0; i < changed.size(); i++)
+      _var_saved[changed[i]] = parameters[changed[i]];
+    _var_journal_entries += changed.size();
+  }
+
+  if (compact || _var_journal_entries > RS274NGC_PARAMETER_JOURNAL_MAX)
+    CHP(rewrite_parameters(filename, parameters));
+  return INTERP_OK;
+}
+
+/***********************************************************************/
+
+/*! Interp::rewrite_parameters
+
 Returned Value:
   If any of the following errors occur, this returns the error code shown.
   Otherwise it returns INTERP_OK.
   1. The existing file cannot be renamed:  NCE_CANNOT_CREATE_BACKUP_FILE
   2. The renamed file cannot be opened to read: NCE_CANNOT_OPEN_BACKUP_FILE
   3. The new file cannot be opened to write: NCE_CANNOT_OPEN_VARIABLE_FILE
-  4. A parameter index is out of range: NCE_PARAMETER_NUMBER_OUT_OF_RANGE
-  5. The renamed file is out of order: NCE_PARAMETER_FILE_OUT_OF_ORDER
+  4. The new file cannot be written or synced: NCE_CANNOT_WRITE_VARIABLE_FILE
+  5. A parameter index is out of range: NCE_PARAMETER_NUMBER_OUT_OF_RANGE
+  6. The renamed file is out of order: NCE_PARAMETER_FILE_OUT_OF_ORDER
 
 Side Effects: See below
 
 Called By:
-   external programs
-   Interp::exit
+   Interp::save_parameters
 
 A file containing variable-value assignments is updated. The old
 version of the file is saved under a different name.  For each
@@ -1918,11 +2085,15 @@ e.g.
 5161 10.456
 
 If a required parameter is missing from the input file, this does not
-complain, but does write it in the output file.
+complain, but does write it in the output file.  Parameters that are
+only in the journal are written too, and the journal is removed once
+the new file is in place.  The new file is synced before it replaces the
+old one, and the directory after, so a crash leaves either the old file
+and its journal or the new file.
 
 */
-int Interp::save_parameters(const char *filename,      //!< name of file to write
-                             const double parameters[]) //!< parameters to save   
+int Interp::rewrite_parameters(const char *filename,      //!< name of file to write
+                                const double parameters[]) //!< parameters to save
 {
   FILE *infile;
   FILE *outfile;
@@ -1932,6 +2103,8 @@ int Interp::save_parameters(const char *filename,      //!< name of file to writ
   int required;                 // number of next required parameter
   int index;                    // index into _required_parameters
   int k;
+  // parameters that only made it into the journal are kept too
+  bool journaled = (_var_file == filename && !_var_persistent.empty());
 
   std::string tempfile = std::string(filename) + ".new";
   outfile = fopen(tempfile.c_str(), "w");
@@ -1970,6 +2143,9 @@ int Interp::save_parameters(const char *filename,      //!< name of file to writ
           snprintf(line, sizeof(line), "%d\t%f\n", k, parameters[k]);
           fputs(line, outfile);
           required = _required_parameters[index++];
+        } else if (journaled && _var_persistent[k]) {
+          snprintf(line, sizeof(line), "%d\t%f\n", k, parameters[k]);
+          fputs(line, outfile);
         }
       }
     }
@@ -1980,19 +2156,49 @@ int Interp::save_parameters(const char *filename,      //!< name of file to writ
       snprintf(line, sizeof(line), "%d\t%f\n", k, parameters[k]);
       fputs(line, outfile);
       required = _required_parameters[index++];
+    } else if (journaled && _var_persistent[k]) {
+      snprintf(line, sizeof(line), "%d\t%f\n", k, parameters[k]);
+      fputs(line, outfile);
     }
   }
 
-  fflush(outfile);
-  fdatasync(fileno(outfile));
-  fclose(outfile);
+  bool written = !ferror(outfile) && fflush(outfile) == 0
+                 && fsync(fileno(outfile)) == 0;
+  if (fclose(outfile) != 0)
+    written = false;
+  if (!written) {
+    perror("writing variable file");
+    unlink(tempfile.c_str());
+    ERS(NCE_CANNOT_WRITE_VARIABLE_FILE);
+  }
   std::string bakfile = std::string(filename)
                             + RS274NGC_PARAMETER_FILE_BACKUP_SUFFIX;
   unlink(bakfile.c_str());
   if(link(filename, bakfile.c_str()) < 0)
     perror("link (updating variable file)");
-  if(rename(tempfile.c_str(), filename) < 0)
+  if(rename(tempfile.c_str(), filename) < 0) {
     perror("rename (updating variable file)");
+    return INTERP_OK;
+  }
+
+  // the rename must be on disk before the journal goes away
+  std::string dir = std::string(filename);
+  size_t slash = dir.rfind('/');
+  dir = (slash == std::string::npos) ? "." : dir.substr(0, slash + 1);
+  int dirfd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (dirfd < 0 || fsync(dirfd) < 0)
+    perror("fsync (updating variable file)");
+  if (dirfd >= 0)
+    ::close(dirfd);
+
+  // everything in the journal is in the file now
+  std::string journal = std::string(filename)
+                            + RS274NGC_PARAMETER_JOURNAL_SUFFIX;
+  unlink(journal.c_str());
+  if (journaled) {
+    _var_saved.assign(parameters, parameters + RS274NGC_MAX_PARAMETERS);
+    _var_journal_entries = 0;
+  }
   return INTERP_OK;
 }
 
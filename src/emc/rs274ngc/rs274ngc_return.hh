@@ -67,6 +67,7 @@
 #define NCE_CANNOT_USE_G53_INCREMENTAL _("Cannot use g53 incremental")
 #define NCE_CANNOT_USE_G53_WITH_CUTTER_RADIUS_COMP _("Cannot use g53 with cutter radius comp")
 #define NCE_CANNOT_USE_TWO_G_CODES_THAT_BOTH_USE_AXIS_VALUES _("Cannot use two g codes that both use axis values")
+#define NCE_CANNOT_WRITE_VARIABLE_FILE _("Cannot write variable file")
 #define NCE_COMMAND_TOO_LONG _("Command too long")
 #define NCE_CURRENT_POINT_SAME_AS_END_POINT_OF_ARC _("Current point same as end point of arc")
 #define NCE_DWELL_TIME_MISSING_WITH_G4 _("Dwell time missing with g4")
@@ -19,6 +19,7 @@
 #include "emcglb.h"
 #include "emctool.h"
 #include "tool_parse.h"
+#include "toolstore.hh"
 #include <rtapi_string.h>
 
 
@@ -26,7 +27,9 @@
 *
 * Description: saveToolTable(const char *filename, CANON_TOOL_TABLE toolTable[])
 *		Saves the tool table from toolTable[] array into file filename.
-*		  Array is CANON_TOOL_MAX + 1 entries, since 0 is included.
+*		  Array is CANON_POCKETS_MAX entries, since 0 is included;
+*		  the entries past it are kept by the tool store.
+*		  A tool database only gets the entries that changed.
 *
 * Return Value: Zero on success or -1 if file not found.
 *
@@ -54,6 +57,9 @@ int saveToolTable(const char *filename,
 	name = filename;
     }
 
+    if (tool_store_is_db(name))
+	return tool_store_save(name, toolTable, ttcomments, random_toolchanger);
+
     // open tool table file
     if (NULL == (fp = fopen(name, "w"))) {
 	// can't open file
@@ -65,23 +71,25 @@ int saveToolTable(const char *filename,
     } else {
         start_pocket = 1;
     }
-    for (pocket = start_pocket; pocket < CANON_POCKETS_MAX; pocket++) {
-        if (toolTable[pocket].toolno != -1) {
-            fprintf(fp, "T%d P%d", toolTable[pocket].toolno, random_toolchanger? pocket: toolTable[pocket].pocketno);
-            if (toolTable[pocket].diameter) fprintf(fp, " D%f", toolTable[pocket].diameter);
-            if (toolTable[pocket].offset.tran.x) fprintf(fp, " X%+f", toolTable[pocket].offset.tran.x);
-            if (toolTable[pocket].offset.tran.y) fprintf(fp, " Y%+f", toolTable[pocket].offset.tran.y);
-            if (toolTable[pocket].offset.tran.z) fprintf(fp, " Z%+f", toolTable[pocket].offset.tran.z);
-            if (toolTable[pocket].offset.a) fprintf(fp, " A%+f", toolTable[pocket].offset.a);
-            if (toolTable[pocket].offset.b) fprintf(fp, " B%+f", toolTable[pocket].offset.b);
-            if (toolTable[pocket].offset.c) fprintf(fp, " C%+f", toolTable[pocket].offset.c);
-            if (toolTable[pocket].offset.u) fprintf(fp, " U%+f", toolTable[pocket].offset.u);
-            if (toolTable[pocket].offset.v) fprintf(fp, " V%+f", toolTable[pocket].offset.v);
-            if (toolTable[pocket].offset.w) fprintf(fp, " W%+f", toolTable[pocket].offset.w);
-            if (toolTable[pocket].frontangle) fprintf(fp, " I%+f", toolTable[pocket].frontangle);
-            if (toolTable[pocket].backangle) fprintf(fp, " J%+f", toolTable[pocket].backangle);
-            if (toolTable[pocket].orientation) fprintf(fp, " Q%d", toolTable[pocket].orientation);
-            fprintf(fp, " ;%s\n", ttcomments[pocket]);
+    for (pocket = start_pocket; pocket >= 0;
+         pocket = pocket + 1 < CANON_POCKETS_MAX ? pocket + 1 : tool_table_next(pocket)) {
+        CANON_TOOL_TABLE tool = tool_table_get(toolTable, pocket);
+        if (tool.toolno != -1) {
+            fprintf(fp, "T%d P%d", tool.toolno, random_toolchanger? pocket: tool.pocketno);
+            if (tool.diameter) fprintf(fp, " D%f", tool.diameter);
+            if (tool.offset.tran.x) fprintf(fp, " X%+f", tool.offset.tran.x);
+            if (tool.offset.tran.y) fprintf(fp, " Y%+f", tool.offset.tran.y);
+            if (tool.offset.tran.z) fprintf(fp, " Z%+f", tool.offset.tran.z);
+            if (tool.offset.a) fprintf(fp, " A%+f", tool.offset.a);
+            if (tool.offset.b) fprintf(fp, " B%+f", tool.offset.b);
+            if (tool.offset.c) fprintf(fp, " C%+f", tool.offset.c);
+            if (tool.offset.u) fprintf(fp, " U%+f", tool.offset.u);
+            if (tool.offset.v) fprintf(fp, " V%+f", tool.offset.v);
+            if (tool.offset.w) fprintf(fp, " W%+f", tool.offset.w);
+            if (tool.frontangle) fprintf(fp, " I%+f", tool.frontangle);
+            if (tool.backangle) fprintf(fp, " J%+f", tool.backangle);
+            if (tool.orientation) fprintf(fp, " Q%d", tool.orientation);
+            fprintf(fp, " ;%s\n", tool_table_comment(ttcomments, pocket));
         }
     }
 
@@ -104,6 +112,9 @@ int loadToolTable(const char *filename,
 
     if(!filename) return -1;
 
+    if (tool_store_is_db(filename))
+	return tool_store_load(filename, toolTable, ttcomments, random_toolchanger);
+
     // open tool table file
     if (NULL == (fp = fopen(filename, "r"))) {
 	// can't open file
@@ -120,6 +131,7 @@ int loadToolTable(const char *filename,
         toolTable[t].orientation = 0;
         if(ttcomments) ttcomments[t][0] = '\0';
     }
+    tool_table_clear_extra();
 
     /*
       Override 0's with codes from tool file
@@ -169,15 +181,10 @@ int loadToolTable(const char *filename,
                 realpocket = pocket;
                 if (!random_toolchanger) {
                     fakepocket++;
-                    if (fakepocket >= CANON_POCKETS_MAX) {
-                        printf("too many tools. skipping tool %d\n", toolno);
-                        valid = 0;
-                        break;
-                    }
                     pocket = fakepocket;
                 }
-                if (pocket < 0 || pocket >= CANON_POCKETS_MAX) {
-                    printf("max pocket number is %d. skipping tool %d\n", CANON_POCKETS_MAX - 1, toolno);
+                if (pocket < 0) {
+                    printf("pocket number %d is negative. skipping tool %d\n", pocket, toolno);
                     valid = 0;
                     break;
                 }
@@ -242,21 +249,23 @@ int loadToolTable(const char *filename,
             token = strtok(NULL, " ");
         }
         if (valid) {
-            toolTable[pocket].toolno = toolno;
-            toolTable[pocket].pocketno = realpocket;
-            toolTable[pocket].offset = offset;
-            toolTable[pocket].diameter = diameter;
-            toolTable[pocket].frontangle = frontangle;
-            toolTable[pocket].backangle = backangle;
-            toolTable[pocket].orientation = orientation;
+            CANON_TOOL_TABLE tool;
+            tool.toolno = toolno;
+            tool.pocketno = realpocket;
+            tool.offset = offset;
+            tool.diameter = diameter;
+            tool.frontangle = frontangle;
+            tool.backangle = backangle;
+            tool.orientation = orientation;
+            tool_table_put(toolTable, pocket, tool);
 
-            if (ttcomments && comment)
-                strcpy(ttcomments[pocket], comment);
+            if (comment)
+                tool_table_set_comment(ttcomments, pocket, comment);
         } else {
             fprintf(stderr, "Unrecognized line skipped: %s", orig_line);
         }
-        if (!random_toolchanger && toolTable[0].toolno == toolTable[pocket].toolno) {
-            toolTable[0] = toolTable[pocket];
+        if (!random_toolchanger && toolTable[0].toolno == tool_table_get(toolTable, pocket).toolno) {
+            toolTable[0] = tool_table_get(toolTable, pocket);
         }
     }
 
@@ -23,8 +23,10 @@
 #include "rs274ngc_return.hh"
 #include "inifile.hh"		// INIFILE
 #include "canon.hh"		// _parameter_file_name
+#include "canon_record.hh"
 #include "config.h"		// LINELEN
 #include "tool_parse.h"
+#include "toolstore.hh"
 #include <stdio.h>    /* gets, etc. */
 #include <stdlib.h>   /* exit       */
 #include <string.h>   /* strcpy     */
@@ -337,7 +339,9 @@ int read_tool_file(  /* ARGUMENTS         */
       tool_file_name = buffer;
     }
 
-  return loadToolTable(tool_file_name, _sai._tools, 0, 0);
+  if (loadToolTable(tool_file_name, _sai._tools, 0, 0)) return 1;
+  _sai._pockets_max = tool_table_size();
+  return 0;
 }
 
 /************************************************************************/
@@ -563,7 +567,7 @@ int main (int argc, char ** argv)
   go_flag = 0;
 
   while(1) {
-      int c = getopt(argc, argv, "p:t:v:bsn:gi:l:T");
+      int c = getopt(argc, argv, "p:t:v:bsn:gi:l:TNR:");
       if(c == -1) break;
 
       switch(c) {
@@ -577,6 +581,13 @@ int main (int argc, char ** argv)
           case 'g': go_flag = !go_flag; break;
           case 'i': inifile = optarg; break;
           case 'T': _task = 1; break;
+          case 'N': _print_source_lines = true; break;
+          case 'R':
+            if (canonRecorder.open(optarg) != 0) {
+              fprintf(stderr, "could not open recording file %s\n", optarg);
+              exit(1);
+            }
+            break;
           case '?': default: goto usage;
       }
   }
@@ -586,7 +597,7 @@ int main (int argc, char ** argv)
 usage:
       fprintf(stderr,
             "Usage: %s [-p interp.so] [-t tool.tbl] [-v var-file.var] [-n 0|1|2]\n"
-            "          [-b] [-s] [-g] [input file [output file]]\n"
+            "          [-b] [-s] [-g] [-N] [-R canon.bin] [input file [output file]]\n"
             "\n"
             "    -p: Specify the pluggable interpreter to use\n"
             "    -t: Specify the .tbl (tool table) file to use\n"
@@ -601,6 +612,8 @@ usage:
             "    -i: specify the .ini file (default: no ini file)\n"
             "    -T: call task_init()\n"
             "    -l: specify the log_level (default: -1)\n"
+            "    -N: print the source line number in the N column\n"
+            "    -R: also record the canonical calls in binary, for canterp\n"
             , argv[0]);
       exit(1);
     }
@@ -698,6 +711,7 @@ usage:
   active_m_codes(ems);   /* called to exercise the function */
   active_settings(sets); /* called to exercise the function */
   interp_exit(); /* saves parameters */
+  canonRecorder.close();
   exit(status);
 }
 
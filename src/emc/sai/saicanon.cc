@@ -41,6 +41,8 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <rtapi_string.h>
+#include "canon_record.hh"
+#include "toolstore.hh"
 
 StandaloneInterpInternals _sai = StandaloneInterpInternals();
 
@@ -48,6 +50,7 @@ char               _parameter_file_name[PARAMETER_FILE_NAME_LENGTH];
 
 /* where to print */
 FILE * _outfile=nullptr;      /* where to print, set in main */
+bool _print_source_lines=false; /* N field is the source line, set in main */
 static bool fo_enable=true, so_enable=true;
 
 /************************************************************************/
@@ -81,6 +84,12 @@ void print_nc_line_number()
       _outfile = stdout;
     }
 
+  if (_print_source_lines)
+    {
+      fprintf(_outfile, "N%-5d ", pinterp->sequence_number());
+      return;
+    }
+
   pinterp->line_text(text, 256);
   for (k = 0;
        ((k < 256) &&
@@ -113,6 +122,7 @@ void print_nc_line_number()
 /* Representation */
 
 void SET_XY_ROTATION(double t) {
+  CANON_RECORD(CANON_REC_SET_XY_ROTATION, 0, {t});
   ECHO_WITH_ARGS("%.4f", t);
 }
 
@@ -120,6 +130,8 @@ void SET_G5X_OFFSET(int index,
                     double x, double y, double z,
                     double a, double b, double c,
                     double u, double v, double w) {
+  CANON_RECORD(CANON_REC_SET_G5X_OFFSET, 0,
+          {x, y, z, a, b, c, u, v, w}, {index});
 
   ECHO_WITH_ARGS("%d, %.4f, %.4f, %.4f, %.4f, %.4f, %.4f",
           index, x, y, z, a, b, c);
@@ -141,6 +153,7 @@ void SET_G5X_OFFSET(int index,
 void SET_G92_OFFSET(double x, double y, double z,
                     double a, double b, double c,
                     double u, double v, double w) {
+  CANON_RECORD(CANON_REC_SET_G92_OFFSET, 0, {x, y, z, a, b, c, u, v, w});
   ECHO_WITH_ARGS("%.4f, %.4f, %.4f, %.4f, %.4f, %.4f",
                       x, y, z, a, b, c);
   _sai._program_position_x = _sai._program_position_x + _sai._g92_x - x;
@@ -160,6 +173,7 @@ void SET_G92_OFFSET(double x, double y, double z,
 
 void USE_LENGTH_UNITS(CANON_UNITS in_unit)
 {
+  CANON_RECORD(CANON_REC_USE_LENGTH_UNITS, 0, {}, {in_unit});
   if (in_unit == CANON_UNITS_INCHES)
     {
       PRINT("USE_LENGTH_UNITS(CANON_UNITS_INCHES)\n");
@@ -209,6 +223,7 @@ void USE_LENGTH_UNITS(CANON_UNITS in_unit)
 /* Free Space Motion */
 void SET_TRAVERSE_RATE(double rate)
 {
+  CANON_RECORD(CANON_REC_SET_TRAVERSE_RATE, 0, {rate});
   PRINT("SET_TRAVERSE_RATE(%.4f)\n", rate);
   _sai._traverse_rate = rate;
 }
@@ -221,6 +236,8 @@ void STRAIGHT_TRAVERSE( int line_number,
  , double u, double v, double w
 )
 {
+  CANON_RECORD(CANON_REC_STRAIGHT_TRAVERSE, line_number,
+          {x, y, z, a, b, c, u, v, w});
   ECHO_WITH_ARGS("%.4f, %.4f, %.4f"
          ", %.4f" /*AA*/
          ", %.4f" /*BB*/
@@ -241,23 +258,27 @@ void STRAIGHT_TRAVERSE( int line_number,
 /* Machining Attributes */
 void SET_FEED_MODE(int spindle, int mode)
 {
+  CANON_RECORD(CANON_REC_SET_FEED_MODE, 0, {}, {spindle, mode});
   PRINT("SET_FEED_MODE(%d, %d)\n", spindle, mode);
   _sai._feed_mode = mode;
 }
 void SET_FEED_RATE(double rate)
 {
+  CANON_RECORD(CANON_REC_SET_FEED_RATE, 0, {rate});
   PRINT("SET_FEED_RATE(%.4f)\n", rate);
   _sai._feed_rate = rate;
 }
 
 void SET_FEED_REFERENCE(CANON_FEED_REFERENCE reference)
 {
+  CANON_RECORD(CANON_REC_SET_FEED_REFERENCE, 0, {}, {reference});
   PRINT("SET_FEED_REFERENCE(%s)\n",
          (reference == CANON_WORKPIECE) ? "CANON_WORKPIECE" : "CANON_XYZ");
 }
 
 extern void SET_MOTION_CONTROL_MODE(CANON_MOTION_MODE mode, double tolerance)
 {
+  CANON_RECORD(CANON_REC_SET_MOTION_CONTROL_MODE, 0, {tolerance}, {mode});
   _sai.motion_tolerance = 0;
   if (mode == CANON_EXACT_STOP)
     {
@@ -281,12 +302,14 @@ extern void SET_MOTION_CONTROL_MODE(CANON_MOTION_MODE mode, double tolerance)
 
 extern void SET_NAIVECAM_TOLERANCE(double tolerance)
 {
+  CANON_RECORD(CANON_REC_SET_NAIVECAM_TOLERANCE, 0, {tolerance});
   _sai.naivecam_tolerance = tolerance;
   PRINT("SET_NAIVECAM_TOLERANCE(%.4f)\n", tolerance);
 }
 
 void SELECT_PLANE(CANON_PLANE in_plane)
 {
+  CANON_RECORD(CANON_REC_SELECT_PLANE, 0, {}, {in_plane});
   PRINT("SELECT_PLANE(CANON_PLANE_%s)\n",
          ((in_plane == CANON_PLANE_XY) ? "XY" :
           (in_plane == CANON_PLANE_YZ) ? "YZ" :
@@ -310,17 +333,34 @@ void START_SPEED_FEED_SYNCH()
 {PRINT ("START_SPEED_FEED_SYNCH()\n");}
 
 void STOP_SPEED_FEED_SYNCH()
-{PRINT ("STOP_SPEED_FEED_SYNCH()\n");}
+{
+  CANON_RECORD(CANON_REC_STOP_SPEED_FEED_SYNCH, 0);
+  PRINT ("STOP_SPEED_FEED_SYNCH()\n");
+}
 
 /* Machining Functions */
 
 void NURBS_FEED(int lineno,
 std::vector<CONTROL_POINT> nurbs_control_points, unsigned int k)
 {
-  ECHO_WITH_ARGS("%lu, ...", (unsigned long)nurbs_control_points.size());
+  if (canonRecorder.active()) {
+    std::vector<double> points;
+    int order = k;
+    for (auto const &p : nurbs_control_points) {
+      points.insert(points.end(), {p.X, p.Y, p.W});
+    }
+    canonRecorder.record(CANON_REC_NURBS_FEED, lineno,
+            points.data(), points.size(), &order, 1, 0);
+  }
+  // the number of points and the order, then X, Y and weight of each
+  PRINT("NURBS_FEED(%lu, %u", (unsigned long)nurbs_control_points.size(), k);
+  for (auto const &p : nurbs_control_points) {
+    fprintf(_outfile, ", %.4f, %.4f, %.4f", p.X, p.Y, p.W);
+  }
+  fprintf(_outfile, ")\n");
 
-  _sai._program_position_x = nurbs_control_points[nurbs_control_points.size()].X;
-  _sai._program_position_y = nurbs_control_points[nurbs_control_points.size()].Y;
+  _sai._program_position_x = nurbs_control_points.back().X;
+  _sai._program_position_y = nurbs_control_points.back().Y;
 }
 
 void ARC_FEED(int line_number,
@@ -332,6 +372,9 @@ void ARC_FEED(int line_number,
  , double u, double v, double w
 )
 {
+  CANON_RECORD(CANON_REC_ARC_FEED, line_number,
+          {first_end, second_end, first_axis, second_axis, axis_end_point, a,
+          b, c, u, v, w}, {rotation});
   ECHO_WITH_ARGS("%.4f, %.4f, %.4f, %.4f, %d, %.4f"
          ", %.4f" /*AA*/
          ", %.4f" /*BB*/
@@ -373,6 +416,8 @@ void STRAIGHT_FEED(int line_number,
  , double u, double v, double w
 )
 {
+  CANON_RECORD(CANON_REC_STRAIGHT_FEED, line_number,
+          {x, y, z, a, b, c, u, v, w});
   ECHO_WITH_ARGS("%.4f, %.4f, %.4f"
          ", %.4f" /*AA*/
          ", %.4f" /*BB*/
@@ -403,6 +448,8 @@ void STRAIGHT_PROBE(int line_number,
  , double u, double v, double w, unsigned char probe_type
 )
 {
+  CANON_RECORD(CANON_REC_STRAIGHT_PROBE, line_number,
+          {x, y, z, a, b, c, u, v, w}, {probe_type});
   double distance;
   double dx, dy, dz;
   double backoff;
@@ -442,25 +489,33 @@ void STRAIGHT_PROBE(int line_number,
 
 void RIGID_TAP(int line_number, double x, double y, double z, double scale)
 {
+    CANON_RECORD(CANON_REC_RIGID_TAP, line_number, {x, y, z, scale});
     ECHO_WITH_ARGS("%.4f, %.4f, %.4f", x, y, z);
 }
 
 
 void DWELL(double seconds)
 {
+  CANON_RECORD(CANON_REC_DWELL, 0, {seconds});
   ECHO_WITH_ARGS("%.4f", seconds);
 }
 
 /* Spindle Functions */
 void SPINDLE_RETRACT_TRAVERSE()
-{PRINT("SPINDLE_RETRACT_TRAVERSE()\n");}
+{
+  CANON_RECORD(CANON_REC_SPINDLE_RETRACT_TRAVERSE, 0);
+  PRINT("SPINDLE_RETRACT_TRAVERSE()\n");
+}
 
 void SET_SPINDLE_MODE(int spindle, double arg) {
+  CANON_RECORD(CANON_REC_SET_SPINDLE_MODE, 0, {arg}, {spindle});
   PRINT("SET_SPINDLE_MODE(%d %.4f)\n", spindle, arg);
 }
 
 void START_SPINDLE_CLOCKWISE(int spindle, int wait_for_atspeed)
 {
+  CANON_RECORD(CANON_REC_START_SPINDLE_CLOCKWISE, 0,
+          {}, {spindle, wait_for_atspeed});
   PRINT("START_SPINDLE_CLOCKWISE(%i)\n", spindle);
   _sai._spindle_turning[spindle] = ((_sai._spindle_speed[spindle] == 0) ? CANON_STOPPED :
                                                    CANON_CLOCKWISE);
@@ -468,6 +523,8 @@ void START_SPINDLE_CLOCKWISE(int spindle, int wait_for_atspeed)
 
 void START_SPINDLE_COUNTERCLOCKWISE(int spindle, int wait_for_atspeed)
 {
+  CANON_RECORD(CANON_REC_START_SPINDLE_COUNTERCLOCKWISE, 0,
+          {}, {spindle, wait_for_atspeed});
   PRINT("START_SPINDLE_COUNTERCLOCKWISE(%i)\n", spindle);
   _sai._spindle_turning[spindle] = ((_sai._spindle_speed[spindle] == 0) ? CANON_STOPPED :
                                                    CANON_COUNTERCLOCKWISE);
@@ -475,40 +532,64 @@ void START_SPINDLE_COUNTERCLOCKWISE(int spindle, int wait_for_atspeed)
 
 void SET_SPINDLE_SPEED(int spindle, double rpm)
 {
+  CANON_RECORD(CANON_REC_SET_SPINDLE_SPEED, 0, {rpm}, {spindle});
   PRINT("SET_SPINDLE_SPEED(%i, %.4f)\n", spindle, rpm);
   _sai._spindle_speed[spindle] = rpm;
 }
 
 void STOP_SPINDLE_TURNING(int spindle)
 {
+  CANON_RECORD(CANON_REC_STOP_SPINDLE_TURNING, 0, {}, {spindle});
   PRINT("STOP_SPINDLE_TURNING(%i)\n", spindle);
   _sai._spindle_turning[spindle] = CANON_STOPPED;
 }
 
 void SPINDLE_RETRACT()
-{PRINT("SPINDLE_RETRACT()\n");}
+{
+  CANON_RECORD(CANON_REC_SPINDLE_RETRACT, 0);
+  PRINT("SPINDLE_RETRACT()\n");
+}
 
 void ORIENT_SPINDLE(int spindle, double orientation, int mode)
-{PRINT("ORIENT_SPINDLE(%d, %.4f, %d)\n", spindle, orientation, mode);
+{
+  CANON_RECORD(CANON_REC_ORIENT_SPINDLE, 0, {orientation}, {spindle, mode});
+  PRINT("ORIENT_SPINDLE(%d, %.4f, %d)\n", spindle, orientation, mode);
 }
 
 void WAIT_SPINDLE_ORIENT_COMPLETE(int spindle, double timeout)
 {
+  CANON_RECORD(CANON_REC_WAIT_SPINDLE_ORIENT_COMPLETE, 0,
+          {timeout}, {spindle});
   PRINT("SPINDLE.%i.WAIT_ORIENT_COMPLETE(%.4f)\n", spindle, timeout);
 }
 
+void USE_SPINDLE_FORCE()
+{
+  CANON_RECORD(CANON_REC_USE_SPINDLE_FORCE, 0);
+  PRINT("USE_SPINDLE_FORCE()\n");
+}
+
 void USE_NO_SPINDLE_FORCE()
-{PRINT("USE_NO_SPINDLE_FORCE()\n");}
+{
+  CANON_RECORD(CANON_REC_USE_NO_SPINDLE_FORCE, 0);
+  PRINT("USE_NO_SPINDLE_FORCE()\n");
+}
 
 /* Tool Functions */
 void SET_TOOL_TABLE_ENTRY(int pocket, int toolno, EmcPose offset, double diameter,
                           double frontangle, double backangle, int orientation) {
-    _sai._tools[pocket].toolno = toolno;
-    _sai._tools[pocket].offset = offset;
-    _sai._tools[pocket].diameter = diameter;
-    _sai._tools[pocket].frontangle = frontangle;
-    _sai._tools[pocket].backangle = backangle;
-    _sai._tools[pocket].orientation = orientation;
+    CANON_RECORD(CANON_REC_SET_TOOL_TABLE_ENTRY, 0,
+            {offset.tran.x, offset.tran.y, offset.tran.z, offset.a, offset.b,
+            offset.c, offset.u, offset.v, offset.w, diameter, frontangle,
+            backangle}, {pocket, toolno, orientation});
+    CANON_TOOL_TABLE tool = tool_table_get(_sai._tools, pocket);
+    tool.toolno = toolno;
+    tool.offset = offset;
+    tool.diameter = diameter;
+    tool.frontangle = frontangle;
+    tool.backangle = backangle;
+    tool.orientation = orientation;
+    tool_table_put(_sai._tools, pocket, tool);
     ECHO_WITH_ARGS("%d, %d, %.4f %.4f %.4f %.4f %.4f %.4f %.4f %.4f %.4f, %.4f, %.4f, %d",
             pocket, toolno,
             offset.tran.x, offset.tran.y, offset.tran.z, offset.a, offset.b, offset.c, offset.u, offset.v, offset.w,
@@ -517,6 +598,9 @@ void SET_TOOL_TABLE_ENTRY(int pocket, int toolno, EmcPose offset, double diamete
 
 void USE_TOOL_LENGTH_OFFSET(EmcPose offset)
 {
+    CANON_RECORD(CANON_REC_USE_TOOL_LENGTH_OFFSET, 0,
+            {offset.tran.x, offset.tran.y, offset.tran.z, offset.a, offset.b,
+            offset.c, offset.u, offset.v, offset.w});
     _sai._tool_offset = offset;
     ECHO_WITH_ARGS("%.4f %.4f %.4f, %.4f %.4f %.4f, %.4f %.4f %.4f",
          offset.tran.x, offset.tran.y, offset.tran.z, offset.a, offset.b, offset.c, offset.u, offset.v, offset.w);
@@ -524,16 +608,21 @@ void USE_TOOL_LENGTH_OFFSET(EmcPose offset)
 
 void CHANGE_TOOL(int slot)
 {
+  CANON_RECORD(CANON_REC_CHANGE_TOOL, 0, {}, {slot});
   PRINT("CHANGE_TOOL(%d)\n", slot);
   _sai._active_slot = slot;
-  _sai._tools[0] = _sai._tools[slot];
+  _sai._tools[0] = tool_table_get(_sai._tools, slot);
 }
 
 void SELECT_TOOL(int tool)//TODO: fix slot number
-{PRINT("SELECT_TOOL(%d)\n", tool);}
+{
+  CANON_RECORD(CANON_REC_SELECT_TOOL, 0, {}, {tool});
+  PRINT("SELECT_TOOL(%d)\n", tool);
+}
 
 void CHANGE_TOOL_NUMBER(int tool)
 {
+  CANON_RECORD(CANON_REC_CHANGE_TOOL_NUMBER, 0, {}, {tool});
   PRINT("CHANGE_TOOL_NUMBER(%d)\n", tool);
   _sai._active_slot = tool;
 }
@@ -551,50 +640,87 @@ void CLAMP_AXIS(CANON_AXIS axis)
         (axis == CANON_AXIS_C) ? "CANON_AXIS_C" : "UNKNOWN");}
 
 void COMMENT(const char *s)
-{PRINT("COMMENT(\"%s\")\n", s);}
+{
+  CANON_RECORD(CANON_REC_COMMENT, 0, {}, {}, s);
+  PRINT("COMMENT(\"%s\")\n", s);
+}
 
 void DISABLE_ADAPTIVE_FEED()
-{PRINT("DISABLE_ADAPTIVE_FEED()\n");}
+{
+  CANON_RECORD(CANON_REC_DISABLE_ADAPTIVE_FEED, 0);
+  PRINT("DISABLE_ADAPTIVE_FEED()\n");
+}
 
 void DISABLE_FEED_HOLD()
-{PRINT("DISABLE_FEED_HOLD()\n");}
+{
+  CANON_RECORD(CANON_REC_DISABLE_FEED_HOLD, 0);
+  PRINT("DISABLE_FEED_HOLD()\n");
+}
 
 void DISABLE_FEED_OVERRIDE()
-{PRINT("DISABLE_FEED_OVERRIDE()\n"); fo_enable = false; }
+{
+  CANON_RECORD(CANON_REC_DISABLE_FEED_OVERRIDE, 0);
+  PRINT("DISABLE_FEED_OVERRIDE()\n");
+  fo_enable = false;
+}
 
 void DISABLE_SPEED_OVERRIDE(int spindle)
-{PRINT("DISABLE_SPEED_OVERRIDE(%i)\n", spindle); so_enable = false; }
+{
+  CANON_RECORD(CANON_REC_DISABLE_SPEED_OVERRIDE, 0, {}, {spindle});
+  PRINT("DISABLE_SPEED_OVERRIDE(%i)\n", spindle);
+  so_enable = false;
+}
 
 void ENABLE_ADAPTIVE_FEED()
-{PRINT("ENABLE_ADAPTIVE_FEED()\n");}
+{
+  CANON_RECORD(CANON_REC_ENABLE_ADAPTIVE_FEED, 0);
+  PRINT("ENABLE_ADAPTIVE_FEED()\n");
+}
 
 void ENABLE_FEED_HOLD()
-{PRINT("ENABLE_FEED_HOLD()\n");}
+{
+  CANON_RECORD(CANON_REC_ENABLE_FEED_HOLD, 0);
+  PRINT("ENABLE_FEED_HOLD()\n");
+}
 
 void ENABLE_FEED_OVERRIDE()
-{PRINT("ENABLE_FEED_OVERRIDE()\n"); fo_enable = true; }
+{
+  CANON_RECORD(CANON_REC_ENABLE_FEED_OVERRIDE, 0);
+  PRINT("ENABLE_FEED_OVERRIDE()\n");
+  fo_enable = true;
+}
 
 void ENABLE_SPEED_OVERRIDE(int spindle)
-{PRINT("ENABLE_SPEED_OVERRIDE(%i)\n", spindle); so_enable = true; }
+{
+  CANON_RECORD(CANON_REC_ENABLE_SPEED_OVERRIDE, 0, {}, {spindle});
+  PRINT("ENABLE_SPEED_OVERRIDE(%i)\n", spindle);
+  so_enable = true;
+}
 
 void FLOOD_OFF()
 {
+  CANON_RECORD(CANON_REC_FLOOD_OFF, 0);
   PRINT("FLOOD_OFF()\n");
   _sai._flood = 0;
 }
 
 void FLOOD_ON()
 {
+  CANON_RECORD(CANON_REC_FLOOD_ON, 0);
   PRINT("FLOOD_ON()\n");
   _sai._flood = 1;
 }
 
 void INIT_CANON()
 {
+  CANON_RECORD(CANON_REC_INIT_CANON, 0);
 }
 
 void MESSAGE(char *s)
-{PRINT("MESSAGE(\"%s\")\n", s);}
+{
+  CANON_RECORD(CANON_REC_MESSAGE, 0, {}, {}, s);
+  PRINT("MESSAGE(\"%s\")\n", s);
+}
 
 void LOG(char *s)
 {PRINT("LOG(\"%s\")\n", s);}
@@ -607,24 +733,35 @@ void LOGCLOSE()
 
 void MIST_OFF()
 {
+  CANON_RECORD(CANON_REC_MIST_OFF, 0);
   PRINT("MIST_OFF()\n");
   _sai._mist = 0;
 }
 
 void MIST_ON()
 {
+  CANON_RECORD(CANON_REC_MIST_ON, 0);
   PRINT("MIST_ON()\n");
   _sai._mist = 1;
 }
 
 void PALLET_SHUTTLE()
-{PRINT("PALLET_SHUTTLE()\n");}
+{
+  CANON_RECORD(CANON_REC_PALLET_SHUTTLE, 0);
+  PRINT("PALLET_SHUTTLE()\n");
+}
 
 void TURN_PROBE_OFF()
-{PRINT("TURN_PROBE_OFF()\n");}
+{
+  CANON_RECORD(CANON_REC_TURN_PROBE_OFF, 0);
+  PRINT("TURN_PROBE_OFF()\n");
+}
 
 void TURN_PROBE_ON()
-{PRINT("TURN_PROBE_ON()\n");}
+{
+  CANON_RECORD(CANON_REC_TURN_PROBE_ON, 0);
+  PRINT("TURN_PROBE_ON()\n");
+}
 
 void UNCLAMP_AXIS(CANON_AXIS axis)
 {PRINT("UNCLAMP_AXIS(%s)\n",
@@ -638,25 +775,40 @@ void UNCLAMP_AXIS(CANON_AXIS axis)
 /* Program Functions */
 
 void PROGRAM_STOP()
-{PRINT("PROGRAM_STOP()\n");}
+{
+  CANON_RECORD(CANON_REC_PROGRAM_STOP, 0);
+  PRINT("PROGRAM_STOP()\n");
+}
 
 void SET_BLOCK_DELETE(bool state)
-{_sai.block_delete = state;} //state == ON, means we don't interpret lines starting with "/"
+{
+  CANON_RECORD(CANON_REC_SET_BLOCK_DELETE, 0, {}, {state});
+  _sai.block_delete = state;
+} //state == ON, means we don't interpret lines starting with "/"
 
 bool GET_BLOCK_DELETE()
 {return _sai.block_delete;} //state == ON, means we  don't interpret lines starting with "/"
 
 void SET_OPTIONAL_PROGRAM_STOP(bool state)
-{_sai.optional_program_stop = state;} //state == ON, means we stop
+{
+  CANON_RECORD(CANON_REC_SET_OPTIONAL_PROGRAM_STOP, 0, {}, {state});
+  _sai.optional_program_stop = state;
+} //state == ON, means we stop
 
 bool GET_OPTIONAL_PROGRAM_STOP()
 {return _sai.optional_program_stop;} //state == ON, means we stop
 
 void OPTIONAL_PROGRAM_STOP()
-{PRINT("OPTIONAL_PROGRAM_STOP()\n");}
+{
+  CANON_RECORD(CANON_REC_OPTIONAL_PROGRAM_STOP, 0);
+  PRINT("OPTIONAL_PROGRAM_STOP()\n");
+}
 
 void PROGRAM_END()
-{PRINT("PROGRAM_END()\n");}
+{
+  CANON_RECORD(CANON_REC_PROGRAM_END, 0);
+  PRINT("PROGRAM_END()\n");
+}
 
 
 /*************************************************************************/
@@ -692,14 +844,26 @@ double GET_EXTERNAL_ANGLE_UNITS() {return 1.0;}
 int GET_EXTERNAL_SELECTED_TOOL_SLOT() { return 0; }
 int GET_EXTERNAL_SPINDLE_OVERRIDE_ENABLE(int spindle) {return so_enable;}
 void START_SPEED_FEED_SYNCH(int spindle, double sync, bool vel)
-{PRINT("START_SPEED_FEED_SYNC(%f,%d)\n", sync, vel);}
+{
+  CANON_RECORD(CANON_REC_START_SPEED_FEED_SYNCH, 0, {sync}, {spindle, vel});
+  PRINT("START_SPEED_FEED_SYNC(%f,%d)\n", sync, vel);
+}
 CANON_MOTION_MODE motion_mode;
 
 int GET_EXTERNAL_DIGITAL_INPUT(int index, int def) { return def; }
 double GET_EXTERNAL_ANALOG_INPUT(int index, double def) { return def; }
-int WAIT(int index, int input_type, int wait_type, double timeout) { return 0; }
-int UNLOCK_ROTARY(int line_no, int joint_num) {return 0;}
-int LOCK_ROTARY(int line_no, int joint_num) {return 0;}
+int WAIT(int index, int input_type, int wait_type, double timeout) {
+  CANON_RECORD(CANON_REC_WAIT, 0, {timeout}, {index, input_type, wait_type});
+  return 0;
+}
+int UNLOCK_ROTARY(int line_no, int joint_num) {
+  CANON_RECORD(CANON_REC_UNLOCK_ROTARY, line_no, {}, {joint_num});
+  return 0;
+}
+int LOCK_ROTARY(int line_no, int joint_num) {
+  CANON_RECORD(CANON_REC_LOCK_ROTARY, line_no, {}, {joint_num});
+  return 0;
+}
 
 /* Returns the system feed rate */
 double GET_EXTERNAL_FEED_RATE()
@@ -917,7 +1081,7 @@ int GET_EXTERNAL_POCKETS_MAX()
    in the given pocket */
 extern CANON_TOOL_TABLE GET_EXTERNAL_TOOL_TABLE(int pocket)
 {
-  return _sai._tools[pocket];
+  return tool_table_get(_sai._tools, pocket);
 }
 
 /* Returns the system traverse rate */
@@ -941,36 +1105,42 @@ int USER_DEFINED_FUNCTION_ADD(USER_DEFINED_FUNCTION_TYPE func, int num)
 
 void SET_MOTION_OUTPUT_BIT(int index)
 {
+    CANON_RECORD(CANON_REC_SET_MOTION_OUTPUT_BIT, 0, {}, {index});
     PRINT("SET_MOTION_OUTPUT_BIT(%d)\n", index);
     return;
 }
 
 void CLEAR_MOTION_OUTPUT_BIT(int index)
 {
+    CANON_RECORD(CANON_REC_CLEAR_MOTION_OUTPUT_BIT, 0, {}, {index});
     PRINT("CLEAR_MOTION_OUTPUT_BIT(%d)\n", index);
     return;
 }
 
 void SET_MOTION_OUTPUT_VALUE(int index, double value)
 {
+    CANON_RECORD(CANON_REC_SET_MOTION_OUTPUT_VALUE, 0, {value}, {index});
     PRINT("SET_MOTION_OUTPUT_VALUE(%d,%f)\n", index, value);
     return;
 }
 
 void SET_AUX_OUTPUT_BIT(int index)
 {
+    CANON_RECORD(CANON_REC_SET_AUX_OUTPUT_BIT, 0, {}, {index});
     PRINT("SET_AUX_OUTPUT_BIT(%d)\n", index);
     return;
 }
 
 void CLEAR_AUX_OUTPUT_BIT(int index)
 {
+    CANON_RECORD(CANON_REC_CLEAR_AUX_OUTPUT_BIT, 0, {}, {index});
     PRINT("CLEAR_AUX_OUTPUT_BIT(%d)\n", index);
     return;
 }
 
 void SET_AUX_OUTPUT_VALUE(int index, double value)
 {
+    CANON_RECORD(CANON_REC_SET_AUX_OUTPUT_VALUE, 0, {value}, {index});
     PRINT("SET_AUX_OUTPUT_VALUE(%d,%f)\n", index, value);
     return;
 }
@@ -1026,10 +1196,12 @@ void FINISH(void) {
 
 void ON_RESET(void)
 {
+    CANON_RECORD(CANON_REC_ON_RESET, 0);
     PRINT("ON_RESET()\n");
 }
 
 void START_CHANGE(void) {
+    CANON_RECORD(CANON_REC_START_CHANGE, 0);
     PRINT("START_CHANGE()\n");
 }
 
@@ -1086,11 +1258,13 @@ void CANON_ERROR(const char *fmt, ...)
 }
 void PLUGIN_CALL(int len, const char *call)
 {
+    CANON_RECORD(CANON_REC_PLUGIN_CALL, 0, {}, {}, call, len);
     printf("PLUGIN_CALL(%d)\n",len);
 }
 
 void IO_PLUGIN_CALL(int len, const char *call)
 {
+    CANON_RECORD(CANON_REC_IO_PLUGIN_CALL, 0, {}, {}, call, len);
     printf("IO_PLUGIN_CALL(%d)\n",len);
 }
 void reset_internals()
@@ -1152,5 +1326,5 @@ StandaloneInterpInternals::StandaloneInterpInternals() :
 {
 }
 void UPDATE_TAG(StateTag tag){
-    //Do nothing
+    if (canonRecorder.active()) canonRecorder.record_tag(tag.get_state_tag());
 }
@@ -12,6 +12,7 @@ class InterpBase;
 extern StandaloneInterpInternals _sai;
 extern InterpBase *pinterp;
 extern FILE *_outfile;
+extern bool _print_source_lines;
 extern char _parameter_file_name[PARAMETER_FILE_NAME_LENGTH];
 
 struct StandaloneInterpInternals
@@ -40,10 +40,13 @@
 #include "emc_nml.hh"
 #include "canon.hh"
 #include "canon_position.hh"		// data type for a machine position
+#include "canon_record.hh"
 #include "interpl.hh"		// interp_list
 #include "emcglb.h"		// TRAJ_MAX_VELOCITY
 #include <rtapi_string.h>
 #include "modal_state.hh"
+#include "toolstore.hh"		// tool table entries past the NML status
+#include "taskclass.hh"		// task_methods->random_toolchanger
 
 //#define EMCCANON_DEBUG
 
@@ -74,6 +77,7 @@ static int debug_velacc = 0;
 static StateTag _tag;
 
 void UPDATE_TAG(StateTag tag) {
+    if (canonRecorder.active()) canonRecorder.record_tag(tag.get_state_tag());
     canon_debug("--Got UPDATE_TAG: %d--\n",tag.fields[GM_FIELD_LINE_NUMBER]);
     _tag = tag;
 }
@@ -469,6 +473,7 @@ static void send_g92_msg(void) {
 }
 
 void SET_XY_ROTATION(double t) {
+    CANON_RECORD(CANON_REC_SET_XY_ROTATION, 0, {t});
     EMC_TRAJ_SET_ROTATION sr;
     sr.rotation = t;
     interp_list.append(sr);
@@ -481,6 +486,8 @@ void SET_G5X_OFFSET(int index,
                     double a, double b, double c,
                     double u, double v, double w)
 {
+    CANON_RECORD(CANON_REC_SET_G5X_OFFSET, 0,
+            {x, y, z, a, b, c, u, v, w}, {index});
     CANON_POSITION pos(x,y,z,a,b,c,u,v,w);
     from_prog(pos);
     /* convert to mm units */
@@ -492,6 +499,7 @@ void SET_G5X_OFFSET(int index,
 void SET_G92_OFFSET(double x, double y, double z,
                     double a, double b, double c,
                     double u, double v, double w) {
+    CANON_RECORD(CANON_REC_SET_G92_OFFSET, 0, {x, y, z, a, b, c, u, v, w});
     /* convert to mm units */
     CANON_POSITION pos(x,y,z,a,b,c,u,v,w);
     from_prog(pos);
@@ -503,6 +511,7 @@ void SET_G92_OFFSET(double x, double y, double z,
 
 void USE_LENGTH_UNITS(CANON_UNITS in_unit)
 {
+    CANON_RECORD(CANON_REC_USE_LENGTH_UNITS, 0, {}, {in_unit});
     canon.lengthUnits = in_unit;
 
     emcStatus->task.programUnits = in_unit;
@@ -511,10 +520,12 @@ void USE_LENGTH_UNITS(CANON_UNITS in_unit)
 /* Free Space Motion */
 void SET_TRAVERSE_RATE(double rate)
 {
+    CANON_RECORD(CANON_REC_SET_TRAVERSE_RATE, 0, {rate});
     // nothing need be done here
 }
 
 void SET_FEED_MODE(int spindle, int mode) {
+    CANON_RECORD(CANON_REC_SET_FEED_MODE, 0, {}, {spindle, mode});
     flush_segments();
     canon.feed_mode = mode;
     canon.spindle_num = spindle;
@@ -523,6 +534,7 @@ void SET_FEED_MODE(int spindle, int mode) {
 
 void SET_FEED_RATE(double rate)
 {
+    CANON_RECORD(CANON_REC_SET_FEED_RATE, 0, {rate});
 
     if(canon.feed_mode) {
 	START_SPEED_FEED_SYNCH(canon.spindle_num, rate, 1);
@@ -547,6 +559,7 @@ void SET_FEED_RATE(double rate)
 
 void SET_FEED_REFERENCE(CANON_FEED_REFERENCE reference)
 {
+    CANON_RECORD(CANON_REC_SET_FEED_REFERENCE, 0, {}, {reference});
     // nothing need be done here
 }
 
@@ -872,6 +885,8 @@ static VelData getStraightVelocity(CANON_POSITION pos)
 }
 
 #include <vector>
+#include "pathfit.h"
+#include "spline.h"
 struct pt {
     double x, y, z, a, b, c, u, v, w;
     int line_no;
@@ -879,9 +894,46 @@ struct pt {
 };
 
 static std::vector<struct pt> chained_points;
+// XYZ of the end point and the chained points, and the line or arc they fit
+static PathFitChain chained_path;
+// Direction of the last joined feed move where it ended
+static PmCartesian chained_tangent, chained_tangent_at;
+static bool chained_tangent_valid;
+// ...and that move was a line from a corner
+static bool chained_tangent_chord;
 
 static void drop_segments(void) {
     chained_points.clear();
+    chained_path.n = 0;
+}
+
+static void send_circle(int line_number, StateTag const &tag,
+                        CANON_POSITION endpt, PM_CARTESIAN center_cart,
+                        PM_CARTESIAN normal_cart, PM_CARTESIAN plane_x,
+                        PM_CARTESIAN plane_y, int rotation,
+                        double v_max_axes, double a_max_axes);
+
+static void flush_arc(void) {
+    struct pt &pos = chained_points.back();
+    CANON_POSITION endpt(pos.x, pos.y, pos.z, pos.a, pos.b, pos.c,
+                         pos.u, pos.v, pos.w);
+    PathFitArc const &arc = chained_path.arc;
+    PM_CARTESIAN center(arc.center.x, arc.center.y, arc.center.z);
+    PM_CARTESIAN normal(arc.normal.x, arc.normal.y, arc.normal.z);
+    PM_CARTESIAN plane_x = unit(canon.endPoint.xyz() - center);
+    PM_CARTESIAN plane_y = cross(normal, plane_x);
+
+    // The arc can lie in any plane; take the limits of every linear axis
+    // that moves in it
+    double v_max_axes = 1e99, a_max_axes = 1e99;
+    for(int i = 0; i < 3; i++) {
+        if(!axis_valid(i) || fabs(normal[i]) > 1 - 1e-9) continue;
+        v_max_axes = MIN(v_max_axes, FROM_EXT_LEN(emcAxisGetMaxVelocity(i)));
+        a_max_axes = MIN(a_max_axes, FROM_EXT_LEN(emcAxisGetMaxAcceleration(i)));
+    }
+
+    send_circle(pos.line_no, pos.tag, endpt, center, normal,
+                plane_x, plane_y, 1, v_max_axes, a_max_axes);
 }
 
 static void flush_segments(void) {
@@ -900,6 +952,19 @@ static void flush_segments(void) {
     printf("\n");
 #endif
 
+    int ended = pathFitChainEndTangent(&chained_path, &chained_tangent);
+    chained_tangent_valid = ended >= 0;
+    chained_tangent_chord = ended > 0;
+    chained_tangent_at.x = x;
+    chained_tangent_at.y = y;
+    chained_tangent_at.z = z;
+
+    if(chained_path.is_arc) {
+        flush_arc();
+        drop_segments();
+        return;
+    }
+
     VelData linedata = getStraightVelocity(x, y, z, a, b, c, u, v, w);
     double vel = linedata.vel;
 
@@ -972,8 +1037,6 @@ linkable(double x, double y, double z,
     struct pt &pos = chained_points.back();
     if(canon.motionMode != CANON_CONTINUOUS || canon.naivecamTolerance == 0)
         return false;
-    //FIXME make this length controlled elsewhere?
-    if(chained_points.size() > 100) return false;
 
     //If ABCUVW motion, then the tangent calculation fails?
     // TODO is there a fundamental reason that we can't handle 9D motion here?
@@ -984,21 +1047,25 @@ linkable(double x, double y, double z,
     if(v != pos.v) return false;
     if(w != pos.w) return false;
 
-    if(x==canon.endPoint.x && y==canon.endPoint.y && z==canon.endPoint.z) return false;
-    
-    for(std::vector<struct pt>::iterator it = chained_points.begin();
-            it != chained_points.end(); it++) {
-        PM_CARTESIAN M(x-canon.endPoint.x, y-canon.endPoint.y, z-canon.endPoint.z),
-                     B(canon.endPoint.x, canon.endPoint.y, canon.endPoint.z),
-                     P(it->x, it->y, it->z);
-        double t0 = dot(M, P-B) / dot(M, M);
-        if(t0 < 0) t0 = 0;
-        if(t0 > 1) t0 = 1;
+    // Adds the point to chained_path if it fits
+    PmCartesian P = {x, y, z};
+    return pathFitChainAdd(&chained_path, &P) == 0;
+}
 
-        double D = mag(P - (B + t0 * M));
-        if(D > canon.naivecamTolerance) return false;
-    }
-    return true;
+static void start_chain(double x, double y, double z) {
+    // Arcs fitted from here on start tangent to the feed move that
+    // ended here, if there was one
+    PmCartesian start = {canon.endPoint.x, canon.endPoint.y, canon.endPoint.z};
+    bool tangent = chained_tangent_valid
+        && chained_tangent_at.x == start.x
+        && chained_tangent_at.y == start.y
+        && chained_tangent_at.z == start.z;
+    PmCartesian P = {x, y, z};
+    chained_path.lines_only = !emc_task_arc_fit;
+    pathFitChainStart(&chained_path, &start,
+                      tangent ? &chained_tangent : NULL,
+                      chained_tangent_chord, canon.naivecamTolerance);
+    pathFitChainAdd(&chained_path, &P);
 }
 
 static void
@@ -1016,8 +1083,22 @@ see_segment(int line_number,
         || (w != canon.endPoint.w);
 
     if(!chained_points.empty() && !linkable(x, y, z, a, b, c, u, v, w)) {
+        // The planner cannot blend an arc into a move out of its plane,
+        // so end the arc a segment early and send that one as a line
+        PmCartesian P = {x, y, z};
+        if(pathFitChainLeavesPlane(&chained_path, &P)
+           && pathFitChainBackUp(&chained_path) == 0) {
+            struct pt last = chained_points.back();
+            chained_points.pop_back();
+            flush_segments();
+            start_chain(last.x, last.y, last.z);
+            chained_points.push_back(last);
+        }
         flush_segments();
     }
+    if(chained_points.empty()) {
+        start_chain(x, y, z);
+    }
     pt pos = {x, y, z, a, b, c, u, v, w, line_number, tag};
     chained_points.push_back(pos);
     if(changed_abc || changed_uvw) {
@@ -1030,6 +1111,7 @@ void FINISH() {
 }
 
 void ON_RESET() {
+    CANON_RECORD(CANON_REC_ON_RESET, 0);
     drop_segments();
 }
 
@@ -1039,6 +1121,8 @@ void STRAIGHT_TRAVERSE(int line_number,
 		       double a, double b, double c,
                        double u, double v, double w)
 {
+    CANON_RECORD(CANON_REC_STRAIGHT_TRAVERSE, line_number,
+            {x, y, z, a, b, c, u, v, w});
     double vel, acc;
 
     flush_segments();
@@ -1085,6 +1169,8 @@ void STRAIGHT_FEED(int line_number,
                    double a, double b, double c,
                    double u, double v, double w)
 {
+    CANON_RECORD(CANON_REC_STRAIGHT_FEED, line_number,
+            {x, y, z, a, b, c, u, v, w});
     EMC_TRAJ_LINEAR_MOVE linearMoveMsg;
     linearMoveMsg.feed_mode = canon.feed_mode;
 
@@ -1096,6 +1182,7 @@ void STRAIGHT_FEED(int line_number,
 
 void RIGID_TAP(int line_number, double x, double y, double z, double scale)
 {
+    CANON_RECORD(CANON_REC_RIGID_TAP, line_number, {x, y, z, scale});
     double ini_maxvel,acc;
     EMC_TRAJ_RIGID_TAP rigidTapMsg;
     double unused=0;
@@ -1143,6 +1230,8 @@ void STRAIGHT_PROBE(int line_number,
                     double u, double v, double w,
                     unsigned char probe_type)
 {
+    CANON_RECORD(CANON_REC_STRAIGHT_PROBE, line_number,
+            {x, y, z, a, b, c, u, v, w}, {probe_type});
     double ini_maxvel, vel, acc;
     EMC_TRAJ_PROBE probeMsg;
 
@@ -1191,6 +1280,7 @@ void STRAIGHT_PROBE(int line_number,
 
 void SET_MOTION_CONTROL_MODE(CANON_MOTION_MODE mode, double tolerance)
 {
+    CANON_RECORD(CANON_REC_SET_MOTION_CONTROL_MODE, 0, {tolerance}, {mode});
     EMC_TRAJ_SET_TERM_COND setTermCondMsg;
 
     flush_segments();
@@ -1218,11 +1308,13 @@ void SET_MOTION_CONTROL_MODE(CANON_MOTION_MODE mode, double tolerance)
 
 void SET_NAIVECAM_TOLERANCE(double tolerance)
 {
+    CANON_RECORD(CANON_REC_SET_NAIVECAM_TOLERANCE, 0, {tolerance});
     canon.naivecamTolerance =  FROM_PROG_LEN(tolerance);
 }
 
 void SELECT_PLANE(CANON_PLANE in_plane)
 {
+    CANON_RECORD(CANON_REC_SELECT_PLANE, 0, {}, {in_plane});
     canon.activePlane = in_plane;
 }
 
@@ -1245,6 +1337,8 @@ void STOP_CUTTER_RADIUS_COMPENSATION()
 
 void START_SPEED_FEED_SYNCH(int spindle, double feed_per_revolution, bool velocity_mode)
 {
+    CANON_RECORD(CANON_REC_START_SPEED_FEED_SYNCH, 0,
+            {feed_per_revolution}, {spindle, velocity_mode});
     flush_segments();
     EMC_TRAJ_SET_SPINDLESYNC spindlesyncMsg;
     spindlesyncMsg.spindle = spindle;
@@ -1256,6 +1350,7 @@ void START_SPEED_FEED_SYNCH(int spindle, double feed_per_revolution, bool veloci
 
 void STOP_SPEED_FEED_SYNCH()
 {
+    CANON_RECORD(CANON_REC_STOP_SPEED_FEED_SYNCH, 0);
     flush_segments();
     EMC_TRAJ_SET_SPINDLESYNC spindlesyncMsg;
     spindlesyncMsg.feed_per_revolution = 0.0;
@@ -1356,11 +1451,97 @@ biarc(int lineno, double p0x, double p0y, double tsx, double tsy,
 }
 
 
+/* Send one span of a NURBS, already in canon coordinates, as a spline
+   move.  Like an arc in the XY plane, the feed is limited by the slower
+   of X and Y; the planner adds the limit for the curvature. */
+static void send_spline(int line_number, StateTag const &tag,
+                        SplineSpan const &span, int degree)
+{
+    PmSpline spline;
+    if (splineInit(&spline, span.ctrl, span.weight, degree) != 0) {
+        return;
+    }
+
+    CANON_POSITION endpt = canon.endPoint;
+    endpt.x = span.ctrl[degree].x;
+    endpt.y = span.ctrl[degree].y;
+
+    double v_max = MIN(FROM_EXT_LEN(emcAxisGetMaxVelocity(0)),
+                       FROM_EXT_LEN(emcAxisGetMaxVelocity(1)));
+    double a_max = MIN(FROM_EXT_LEN(emcAxisGetMaxAcceleration(0)),
+                       FROM_EXT_LEN(emcAxisGetMaxAcceleration(1)));
+    double vel = MIN(canon.linearFeedRate, v_max);
+
+    EMC_TRAJ_SPLINE_MOVE splineMoveMsg;
+    splineMoveMsg.feed_mode = canon.feed_mode;
+    splineMoveMsg.end = to_ext_pose(endpt);
+    for (int i = 0; i <= degree; i++) {
+        splineMoveMsg.ctrl[i] = to_ext_len(PM_CARTESIAN(
+                    span.ctrl[i].x, span.ctrl[i].y, span.ctrl[i].z));
+        splineMoveMsg.weight[i] = span.weight[i];
+    }
+    splineMoveMsg.degree = degree;
+    splineMoveMsg.type = EMC_MOTION_TYPE_ARC;
+    splineMoveMsg.vel = toExtVel(vel);
+    splineMoveMsg.ini_maxvel = toExtVel(v_max);
+    splineMoveMsg.acc = toExtAcc(a_max);
+
+    canon.cartesian_move = 1;
+    if (vel && a_max) {
+        interp_list.set_line_number(line_number);
+        tag_and_send(splineMoveMsg, tag);
+    }
+    canonUpdateEndPoint(endpt);
+
+    // Short moves after the spline can join on from its end direction
+    chained_tangent_valid =
+        splineTangent(&spline, spline.length, &chained_tangent) == 0;
+    chained_tangent_chord = false;
+    chained_tangent_at = span.ctrl[degree];
+}
+
 /* Canon calls */
 
 void NURBS_FEED(int lineno, std::vector<CONTROL_POINT> nurbs_control_points, unsigned int k) {
+    if (canonRecorder.active()) {
+        std::vector<double> points;
+        int order = k;
+        for (auto const &p : nurbs_control_points) {
+            points.insert(points.end(), {p.X, p.Y, p.W});
+        }
+        canonRecorder.record(CANON_REC_NURBS_FEED, lineno,
+                points.data(), points.size(), &order, 1, 0);
+    }
     flush_segments();
 
+    // A NURBS of low enough degree goes to the planner one span at a time,
+    // as a rational Bezier curve; higher degrees are cut into biarcs
+    if (k >= 2 && k <= EMCMOT_MAX_SPLINE_POINTS) {
+        int count = nurbs_control_points.size();
+        std::vector<PmCartesian> ctrl(count);
+        std::vector<double> weight(count);
+        double unused = 0;
+
+        for (int i = 0; i < count; i++) {
+            double x = FROM_PROG_LEN(nurbs_control_points[i].X);
+            double y = FROM_PROG_LEN(nurbs_control_points[i].Y);
+            rotate_and_offset_pos(x, y, unused, unused, unused, unused,
+                                  unused, unused, unused);
+            ctrl[i].x = x;
+            ctrl[i].y = y;
+            ctrl[i].z = canon.endPoint.z;
+            weight[i] = nurbs_control_points[i].W;
+        }
+        for (int i = 0; i + (int)k <= count; i++) {
+            SplineSpan span;
+            if (splineNurbsSpan(&ctrl[0], &weight[0], count, k, i, &span)) {
+                break;
+            }
+            send_spline(lineno, _tag, span, k - 1);
+        }
+        return;
+    }
+
     unsigned int n = nurbs_control_points.size() - 1;
     double umax = n - k + 2;
     unsigned int div = nurbs_control_points.size()*4;
@@ -1478,158 +1659,23 @@ static double axis_acc_time(const CANON_POSITION & start, const CANON_POSITION &
 }
 #endif
 
-void ARC_FEED(int line_number,
-              double first_end, double second_end,
-	      double first_axis, double second_axis, int rotation,
-	      double axis_end_point, 
-              double a, double b, double c,
-              double u, double v, double w)
+/* Queue an arc from the current end point to endpt.  The end point and
+   centre are in canon units, rotated and offset; plane_x and plane_y span
+   the plane of the arc and normal_cart is square to it.  rotation is as
+   for ARC_FEED(), and v_max_axes and a_max_axes are the limits of the
+   axes that move in the plane. */
+static void send_circle(int line_number, StateTag const &tag,
+                        CANON_POSITION endpt, PM_CARTESIAN center_cart,
+                        PM_CARTESIAN normal_cart, PM_CARTESIAN plane_x,
+                        PM_CARTESIAN plane_y, int rotation,
+                        double v_max_axes, double a_max_axes)
 {
-
     EMC_TRAJ_CIRCULAR_MOVE circularMoveMsg;
     EMC_TRAJ_LINEAR_MOVE linearMoveMsg;
 
-    canon_debug("line = %d\n", line_number);
-    canon_debug("first_end = %f, second_end = %f\n", first_end,second_end);
-
-    if( canon.activePlane == CANON_PLANE_XY && canon.motionMode == CANON_CONTINUOUS) {
-        double mx, my;
-        double lx, ly, lz;
-        double unused = 0;
-
-        get_last_pos(lx, ly, lz);
-
-        double fe=FROM_PROG_LEN(first_end), se=FROM_PROG_LEN(second_end), ae=FROM_PROG_LEN(axis_end_point);
-        double fa=FROM_PROG_LEN(first_axis), sa=FROM_PROG_LEN(second_axis);
-        rotate_and_offset_pos(fe, se, ae, unused, unused, unused, unused, unused, unused);
-        rotate_and_offset_pos(fa, sa, unused, unused, unused, unused, unused, unused, unused);
-        if (chord_deviation(lx, ly, fe, se, fa, sa, rotation, mx, my) < canon.naivecamTolerance) {
-            a = FROM_PROG_ANG(a);
-            b = FROM_PROG_ANG(b);
-            c = FROM_PROG_ANG(c);
-            u = FROM_PROG_LEN(u);
-            v = FROM_PROG_LEN(v);
-            w = FROM_PROG_LEN(w);
-
-            rotate_and_offset_pos(unused, unused, unused, a, b, c, u, v, w);
-            see_segment(line_number, _tag, mx, my,
-                        (lz + ae)/2, 
-                        (canon.endPoint.a + a)/2, 
-                        (canon.endPoint.b + b)/2, 
-                        (canon.endPoint.c + c)/2, 
-                        (canon.endPoint.u + u)/2, 
-                        (canon.endPoint.v + v)/2, 
-                        (canon.endPoint.w + w)/2);
-            see_segment(line_number, _tag, fe, se, ae, a, b, c, u, v, w);
-            return;
-        }
-    }
-
     linearMoveMsg.feed_mode = canon.feed_mode;
     circularMoveMsg.feed_mode = canon.feed_mode;
-    flush_segments();
-
-    // Start by defining 3D points for the motion end and center.
-    PM_CARTESIAN end_cart(first_end, second_end, axis_end_point);
-    PM_CARTESIAN center_cart(first_axis, second_axis, axis_end_point);
-    PM_CARTESIAN normal_cart(0.0,0.0,1.0);
-    PM_CARTESIAN plane_x(1.0,0.0,0.0);
-    PM_CARTESIAN plane_y(0.0,1.0,0.0);
-
-
-    canon_debug("start = %f %f %f\n",
-            canon.endPoint.x,
-            canon.endPoint.y,
-            canon.endPoint.z);
-    canon_debug("end = %f %f %f\n",
-            end_cart.x,
-            end_cart.y,
-            end_cart.z);
-    canon_debug("center = %f %f %f\n",
-            center_cart.x,
-            center_cart.y,
-            center_cart.z);
-
-    // Rearrange the X Y Z coordinates in the correct order based on the active plane (XY, YZ, or XZ)
-    // KLUDGE CANON_PLANE is 1-indexed, hence the subtraction here to make a 0-index value
-    int shift_ind = 0;
-    switch(canon.activePlane) {
-        case CANON_PLANE_XY:
-            shift_ind = 0;
-            break;
-        case CANON_PLANE_XZ:
-            shift_ind = -2;
-            break;
-        case CANON_PLANE_YZ:
-            shift_ind = -1;
-            break;
-        case CANON_PLANE_UV:
-        case CANON_PLANE_VW:
-        case CANON_PLANE_UW:
-            CANON_ERROR("Can't set plane in UVW axes, assuming XY");
-            break;
-    }
-
-    canon_debug("active plane is %d, shift_ind is %d\n",canon.activePlane,shift_ind);
-    end_cart = circshift(end_cart, shift_ind);
-    center_cart = circshift(center_cart, shift_ind);
-    normal_cart = circshift(normal_cart, shift_ind);
-    plane_x = circshift(plane_x, shift_ind);
-    plane_y = circshift(plane_y, shift_ind);
-
-    canon_debug("normal = %f %f %f\n",
-            normal_cart.x,
-            normal_cart.y,
-            normal_cart.z);
-
-    canon_debug("plane_x = %f %f %f\n",
-            plane_x.x,
-            plane_x.y,
-            plane_x.z);
-
-    canon_debug("plane_y = %f %f %f\n",
-            plane_y.x,
-            plane_y.y,
-            plane_y.z);
-    // Define end point in PROGRAM units and convert to CANON
-    CANON_POSITION endpt(0,0,0,a,b,c,u,v,w);
-    from_prog(endpt);
-
-    // Store permuted XYZ end position
-    from_prog_len(end_cart);
-    endpt.set_xyz(end_cart);
-
-    // Convert to CANON units
-    from_prog_len(center_cart);
-
-    // Rotate and offset the new end point to be in the same coordinate system as the current end point
-    rotate_and_offset(endpt);
-    rotate_and_offset_xyz(center_cart);
-    rotate_and_offset_xyz(end_cart);
-    // Also rotate the basis vectors
-    to_rotated(plane_x);
-    to_rotated(plane_y);
-    to_rotated(normal_cart);
-
-    canon_debug("end = %f %f %f\n",
-            end_cart.x,
-            end_cart.y,
-            end_cart.z);
-
-    canon_debug("endpt = %f %f %f\n",
-            endpt.x,
-            endpt.y,
-            endpt.z);
-    canon_debug("center = %f %f %f\n",
-            center_cart.x,
-            center_cart.y,
-            center_cart.z);
-
-    canon_debug("normal = %f %f %f\n",
-            normal_cart.x,
-            normal_cart.y,
-            normal_cart.z);
-    // Note that the "start" point is already rotated and offset
+    PM_CARTESIAN end_cart = endpt.xyz();
 
     // Define displacement vectors from center to end and center to start (3D)
     PM_CARTESIAN end_rel = end_cart - center_cart;
@@ -1702,38 +1748,6 @@ void ARC_FEED(int line_number,
     double min_radius = fmin(start_radius, end_radius);
     double effective_radius = sqrt(dr*dr + min_radius*min_radius);
 
-    // KLUDGE: assumes 0,1,2 for X Y Z
-    // Find normal axis
-    int norm_axis_ind = (2 - shift_ind) % 3;
-    // Find maximum velocities and accelerations for planar axes
-    int axis1 = (norm_axis_ind + 1) % 3;
-    int axis2 = (norm_axis_ind + 2) % 3;
-
-    canon_debug("axis1 = %d, axis2 = %d\n",axis1, axis2);
-
-    // Get planar velocity bounds
-    double v1 = FROM_EXT_LEN(emcAxisGetMaxVelocity(axis1));
-    double v2 = FROM_EXT_LEN(emcAxisGetMaxVelocity(axis2));
-
-    // Get planar acceleration bounds
-    double a1 = FROM_EXT_LEN(emcAxisGetMaxAcceleration(axis1));
-    double a2 = FROM_EXT_LEN(emcAxisGetMaxAcceleration(axis2));
-    double v_max_axes = MIN(v1, v2);
-    double a_max_axes = MIN(a1, a2);
-
-    if(canon.xy_rotation && canon.activePlane != CANON_PLANE_XY) {
-        // also consider the third plane's constraint, which may get
-        // involved since we're rotated.
-
-        int axis3 = (norm_axis_ind + 3) % 3;
-        if (axis_valid(axis3)) {
-            double v3 = FROM_EXT_LEN(emcAxisGetMaxVelocity(axis3));
-            double a3 = FROM_EXT_LEN(emcAxisGetMaxAcceleration(axis3));
-            v_max_axes = MIN(v3, v_max_axes);
-            a_max_axes = MIN(a3, a_max_axes);
-        }
-    }
-
     //FIXME allow tangential acceleration like in TP
     double a_max_normal = a_max_axes * sqrt(3.0)/2.0;
     canon_debug("a_max_axes = %f\n", a_max_axes);
@@ -1811,7 +1825,7 @@ void ARC_FEED(int line_number,
         linearMoveMsg.indexer_jnum = -1;
         if(vel && a_max){
             interp_list.set_line_number(line_number);
-            tag_and_send(linearMoveMsg, _tag);
+            tag_and_send(linearMoveMsg, tag);
         }
     } else {
         circularMoveMsg.end = to_ext_pose(endpt);
@@ -1837,16 +1851,204 @@ void ARC_FEED(int line_number,
         // seems to be a crude way to indicate a zero length segment?
         if(vel && a_max) {
             interp_list.set_line_number(line_number);
-            tag_and_send(circularMoveMsg, _tag);
+            tag_and_send(circularMoveMsg, tag);
         }
     }
     // update the end point
     canonUpdateEndPoint(endpt);
 }
 
+void ARC_FEED(int line_number,
+              double first_end, double second_end,
+	      double first_axis, double second_axis, int rotation,
+	      double axis_end_point, 
+              double a, double b, double c,
+              double u, double v, double w)
+{
+    CANON_RECORD(CANON_REC_ARC_FEED, line_number,
+            {first_end, second_end, first_axis, second_axis, axis_end_point, a,
+            b, c, u, v, w}, {rotation});
+
+    canon_debug("line = %d\n", line_number);
+    canon_debug("first_end = %f, second_end = %f\n", first_end,second_end);
+
+    if( canon.activePlane == CANON_PLANE_XY && canon.motionMode == CANON_CONTINUOUS) {
+        double mx, my;
+        double lx, ly, lz;
+        double unused = 0;
+
+        get_last_pos(lx, ly, lz);
+
+        double fe=FROM_PROG_LEN(first_end), se=FROM_PROG_LEN(second_end), ae=FROM_PROG_LEN(axis_end_point);
+        double fa=FROM_PROG_LEN(first_axis), sa=FROM_PROG_LEN(second_axis);
+        rotate_and_offset_pos(fe, se, ae, unused, unused, unused, unused, unused, unused);
+        rotate_and_offset_pos(fa, sa, unused, unused, unused, unused, unused, unused, unused);
+        if (chord_deviation(lx, ly, fe, se, fa, sa, rotation, mx, my) < canon.naivecamTolerance) {
+            a = FROM_PROG_ANG(a);
+            b = FROM_PROG_ANG(b);
+            c = FROM_PROG_ANG(c);
+            u = FROM_PROG_LEN(u);
+            v = FROM_PROG_LEN(v);
+            w = FROM_PROG_LEN(w);
+
+            rotate_and_offset_pos(unused, unused, unused, a, b, c, u, v, w);
+            see_segment(line_number, _tag, mx, my,
+                        (lz + ae)/2, 
+                        (canon.endPoint.a + a)/2, 
+                        (canon.endPoint.b + b)/2, 
+                        (canon.endPoint.c + c)/2, 
+                        (canon.endPoint.u + u)/2, 
+                        (canon.endPoint.v + v)/2, 
+                        (canon.endPoint.w + w)/2);
+            see_segment(line_number, _tag, fe, se, ae, a, b, c, u, v, w);
+            return;
+        }
+    }
+
+    flush_segments();
+
+    // Start by defining 3D points for the motion end and center.
+    PM_CARTESIAN end_cart(first_end, second_end, axis_end_point);
+    PM_CARTESIAN center_cart(first_axis, second_axis, axis_end_point);
+    PM_CARTESIAN normal_cart(0.0,0.0,1.0);
+    PM_CARTESIAN plane_x(1.0,0.0,0.0);
+    PM_CARTESIAN plane_y(0.0,1.0,0.0);
+
+
+    canon_debug("start = %f %f %f\n",
+            canon.endPoint.x,
+            canon.endPoint.y,
+            canon.endPoint.z);
+    canon_debug("end = %f %f %f\n",
+            end_cart.x,
+            end_cart.y,
+            end_cart.z);
+    canon_debug("center = %f %f %f\n",
+            center_cart.x,
+            center_cart.y,
+            center_cart.z);
+
+    // Rearrange the X Y Z coordinates in the correct order based on the active plane (XY, YZ, or XZ)
+    // KLUDGE CANON_PLANE is 1-indexed, hence the subtraction here to make a 0-index value
+    int shift_ind = 0;
+    switch(canon.activePlane) {
+        case CANON_PLANE_XY:
+            shift_ind = 0;
+            break;
+        case CANON_PLANE_XZ:
+            shift_ind = -2;
+            break;
+        case CANON_PLANE_YZ:
+            shift_ind = -1;
+            break;
+        case CANON_PLANE_UV:
+        case CANON_PLANE_VW:
+        case CANON_PLANE_UW:
+            CANON_ERROR("Can't set plane in UVW axes, assuming XY");
+            break;
+    }
+
+    canon_debug("active plane is %d, shift_ind is %d\n",canon.activePlane,shift_ind);
+    end_cart = circshift(end_cart, shift_ind);
+    center_cart = circshift(center_cart, shift_ind);
+    normal_cart = circshift(normal_cart, shift_ind);
+    plane_x = circshift(plane_x, shift_ind);
+    plane_y = circshift(plane_y, shift_ind);
+
+    canon_debug("normal = %f %f %f\n",
+            normal_cart.x,
+            normal_cart.y,
+            normal_cart.z);
+
+    canon_debug("plane_x = %f %f %f\n",
+            plane_x.x,
+            plane_x.y,
+            plane_x.z);
+
+    canon_debug("plane_y = %f %f %f\n",
+            plane_y.x,
+            plane_y.y,
+            plane_y.z);
+    // Define end point in PROGRAM units and convert to CANON
+    CANON_POSITION endpt(0,0,0,a,b,c,u,v,w);
+    from_prog(endpt);
+
+    // Store permuted XYZ end position
+    from_prog_len(end_cart);
+    endpt.set_xyz(end_cart);
+
+    // Convert to CANON units
+    from_prog_len(center_cart);
+
+    // Rotate and offset the new end point to be in the same coordinate system as the current end point
+    rotate_and_offset(endpt);
+    rotate_and_offset_xyz(center_cart);
+    rotate_and_offset_xyz(end_cart);
+    // Also rotate the basis vectors
+    to_rotated(plane_x);
+    to_rotated(plane_y);
+    to_rotated(normal_cart);
+
+    canon_debug("end = %f %f %f\n",
+            end_cart.x,
+            end_cart.y,
+            end_cart.z);
+
+    canon_debug("endpt = %f %f %f\n",
+            endpt.x,
+            endpt.y,
+            endpt.z);
+    canon_debug("center = %f %f %f\n",
+            center_cart.x,
+            center_cart.y,
+            center_cart.z);
+
+    canon_debug("normal = %f %f %f\n",
+            normal_cart.x,
+            normal_cart.y,
+            normal_cart.z);
+    // Note that the "start" point is already rotated and offset
+
+    // KLUDGE: assumes 0,1,2 for X Y Z
+    // Find normal axis
+    int norm_axis_ind = (2 - shift_ind) % 3;
+    // Find maximum velocities and accelerations for planar axes
+    int axis1 = (norm_axis_ind + 1) % 3;
+    int axis2 = (norm_axis_ind + 2) % 3;
+
+    canon_debug("axis1 = %d, axis2 = %d\n",axis1, axis2);
+
+    // Get planar velocity bounds
+    double v1 = FROM_EXT_LEN(emcAxisGetMaxVelocity(axis1));
+    double v2 = FROM_EXT_LEN(emcAxisGetMaxVelocity(axis2));
+
+    // Get planar acceleration bounds
+    double a1 = FROM_EXT_LEN(emcAxisGetMaxAcceleration(axis1));
+    double a2 = FROM_EXT_LEN(emcAxisGetMaxAcceleration(axis2));
+    double v_max_axes = MIN(v1, v2);
+    double a_max_axes = MIN(a1, a2);
+
+    if(canon.xy_rotation && canon.activePlane != CANON_PLANE_XY) {
+        // also consider the third plane's constraint, which may get
+        // involved since we're rotated.
+
+        int axis3 = (norm_axis_ind + 3) % 3;
+        if (axis_valid(axis3)) {
+            double v3 = FROM_EXT_LEN(emcAxisGetMaxVelocity(axis3));
+            double a3 = FROM_EXT_LEN(emcAxisGetMaxAcceleration(axis3));
+            v_max_axes = MIN(v3, v_max_axes);
+            a_max_axes = MIN(a3, a_max_axes);
+        }
+    }
+
+    send_circle(line_number, _tag, endpt, center_cart, normal_cart,
+                plane_x, plane_y, rotation, v_max_axes, a_max_axes);
+}
+
 
 void DWELL(double seconds)
 {
+    CANON_RECORD(CANON_REC_DWELL, 0, {seconds});
     EMC_TRAJ_DELAY delayMsg;
 
     flush_segments();
@@ -1859,15 +2061,19 @@ void DWELL(double seconds)
 /* Spindle Functions */
 void SPINDLE_RETRACT_TRAVERSE()
 {
+    CANON_RECORD(CANON_REC_SPINDLE_RETRACT_TRAVERSE, 0);
     /*! \todo FIXME-- unimplemented */
 }
 
 void SET_SPINDLE_MODE(int spindle, double css_max) {
+   CANON_RECORD(CANON_REC_SET_SPINDLE_MODE, 0, {css_max}, {spindle});
    canon.spindle[spindle].css_maximum = fabs(css_max);
 }
 
 void START_SPINDLE_CLOCKWISE(int s, int wait_for_atspeed)
 {
+    CANON_RECORD(CANON_REC_START_SPINDLE_CLOCKWISE, 0,
+            {}, {s, wait_for_atspeed});
     EMC_SPINDLE_ON emc_spindle_on_msg;
 
     flush_segments();
@@ -1892,6 +2098,8 @@ void START_SPINDLE_CLOCKWISE(int s, int wait_for_atspeed)
 
 void START_SPINDLE_COUNTERCLOCKWISE(int s, int wait_for_atspeed)
 {
+    CANON_RECORD(CANON_REC_START_SPINDLE_COUNTERCLOCKWISE, 0,
+            {}, {s, wait_for_atspeed});
     EMC_SPINDLE_ON emc_spindle_on_msg;
 
     flush_segments();
@@ -1916,6 +2124,7 @@ void START_SPINDLE_COUNTERCLOCKWISE(int s, int wait_for_atspeed)
 
 void SET_SPINDLE_SPEED(int s, double r)
 {
+    CANON_RECORD(CANON_REC_SET_SPINDLE_SPEED, 0, {r}, {s});
     // speed is in RPMs everywhere
 
 	canon.spindle[s].speed = fabs(r); // interp will never send negative anyway ...
@@ -1943,6 +2152,7 @@ void SET_SPINDLE_SPEED(int s, double r)
 
 void STOP_SPINDLE_TURNING(int s)
 {
+    CANON_RECORD(CANON_REC_STOP_SPINDLE_TURNING, 0, {}, {s});
     EMC_SPINDLE_OFF emc_spindle_off_msg;
 
     flush_segments();
@@ -1954,11 +2164,13 @@ void STOP_SPINDLE_TURNING(int s)
 
 void SPINDLE_RETRACT()
 {
+    CANON_RECORD(CANON_REC_SPINDLE_RETRACT, 0);
     /*! \todo FIXME-- unimplemented */
 }
 
 void ORIENT_SPINDLE(int s, double orientation, int mode)
 {
+    CANON_RECORD(CANON_REC_ORIENT_SPINDLE, 0, {orientation}, {s, mode});
     EMC_SPINDLE_ORIENT o;
 
     flush_segments();
@@ -1970,6 +2182,7 @@ void ORIENT_SPINDLE(int s, double orientation, int mode)
 
 void WAIT_SPINDLE_ORIENT_COMPLETE(int s, double timeout)
 {
+    CANON_RECORD(CANON_REC_WAIT_SPINDLE_ORIENT_COMPLETE, 0, {timeout}, {s});
     EMC_SPINDLE_WAIT_ORIENT_COMPLETE o;
 
     flush_segments();
@@ -1980,6 +2193,7 @@ void WAIT_SPINDLE_ORIENT_COMPLETE(int s, double timeout)
 
 void USE_SPINDLE_FORCE(void)
 {
+    CANON_RECORD(CANON_REC_USE_SPINDLE_FORCE, 0);
     /*! \todo FIXME-- unimplemented */
 }
 
@@ -1990,6 +2204,7 @@ void LOCK_SPINDLE_Z(void)
 
 void USE_NO_SPINDLE_FORCE(void)
 {
+    CANON_RECORD(CANON_REC_USE_NO_SPINDLE_FORCE, 0);
     /*! \todo FIXME-- unimplemented */
 }
 
@@ -1998,6 +2213,10 @@ void USE_NO_SPINDLE_FORCE(void)
 /* this is called with distances in external (machine) units */
 void SET_TOOL_TABLE_ENTRY(int pocket, int toolno, EmcPose offset, double diameter,
                           double frontangle, double backangle, int orientation) {
+    CANON_RECORD(CANON_REC_SET_TOOL_TABLE_ENTRY, 0,
+            {offset.tran.x, offset.tran.y, offset.tran.z, offset.a, offset.b,
+            offset.c, offset.u, offset.v, offset.w, diameter, frontangle,
+            backangle}, {pocket, toolno, orientation});
     EMC_TOOL_SET_OFFSET o;
     flush_segments();
     o.pocket = pocket;
@@ -2016,6 +2235,9 @@ void SET_TOOL_TABLE_ENTRY(int pocket, int toolno, EmcPose offset, double diamete
   */
 void USE_TOOL_LENGTH_OFFSET(EmcPose offset)
 {
+    CANON_RECORD(CANON_REC_USE_TOOL_LENGTH_OFFSET, 0,
+            {offset.tran.x, offset.tran.y, offset.tran.z, offset.a, offset.b,
+            offset.c, offset.u, offset.v, offset.w});
     EMC_TRAJ_SET_OFFSET set_offset_msg;
 
     flush_segments();
@@ -2054,6 +2276,7 @@ void USE_TOOL_LENGTH_OFFSET(EmcPose offset)
 /* issued at very start of an M6 command. Notification. */
 void START_CHANGE()
 {
+    CANON_RECORD(CANON_REC_START_CHANGE, 0);
     EMC_TOOL_START_CHANGE emc_start_change_msg;
 
     flush_segments();
@@ -2064,6 +2287,7 @@ void START_CHANGE()
 /* CHANGE_TOOL results from M6 */
 void CHANGE_TOOL(int slot)
 {
+    CANON_RECORD(CANON_REC_CHANGE_TOOL, 0, {}, {slot});
     EMC_TRAJ_LINEAR_MOVE linearMoveMsg;
     linearMoveMsg.feed_mode = canon.feed_mode;
     EMC_TOOL_LOAD load_tool_msg;
@@ -2137,6 +2361,7 @@ void CHANGE_TOOL(int slot)
 /* SELECT_TOOL results from Tn */
 void SELECT_TOOL(int tool)
 {
+    CANON_RECORD(CANON_REC_SELECT_TOOL, 0, {}, {tool});
     EMC_TOOL_PREPARE prep_for_tool_msg;
 
     prep_for_tool_msg.tool = tool;
@@ -2147,6 +2372,7 @@ void SELECT_TOOL(int tool)
 /* CHANGE_TOOL_NUMBER results from M61 */
 void CHANGE_TOOL_NUMBER(int pocket_number)
 {
+    CANON_RECORD(CANON_REC_CHANGE_TOOL_NUMBER, 0, {}, {pocket_number});
     EMC_TOOL_SET_NUMBER emc_tool_set_number_msg;
     
     emc_tool_set_number_msg.tool = pocket_number;
@@ -2203,6 +2429,7 @@ static FILE *probefile = NULL;
 
 void COMMENT(const char *comment)
 {
+    CANON_RECORD(CANON_REC_COMMENT, 0, {}, {}, comment);
     // nothing need be done here, but you can play tricks with hot comments
 
     char msg[LINELEN];
@@ -2259,6 +2486,7 @@ void COMMENT(const char *comment)
 // refers to feed rate
 void DISABLE_FEED_OVERRIDE()
 {
+    CANON_RECORD(CANON_REC_DISABLE_FEED_OVERRIDE, 0);
     EMC_TRAJ_SET_FO_ENABLE set_fo_enable_msg;
     flush_segments();
     
@@ -2268,6 +2496,7 @@ void DISABLE_FEED_OVERRIDE()
 
 void ENABLE_FEED_OVERRIDE()
 {
+    CANON_RECORD(CANON_REC_ENABLE_FEED_OVERRIDE, 0);
     EMC_TRAJ_SET_FO_ENABLE set_fo_enable_msg;
     flush_segments();
     
@@ -2279,6 +2508,7 @@ void ENABLE_FEED_OVERRIDE()
 //refers to adaptive feed override (HAL input, useful for EDM for example)
 void DISABLE_ADAPTIVE_FEED()
 {
+    CANON_RECORD(CANON_REC_DISABLE_ADAPTIVE_FEED, 0);
     EMC_MOTION_ADAPTIVE emcmotAdaptiveMsg;
     flush_segments();
 
@@ -2288,6 +2518,7 @@ void DISABLE_ADAPTIVE_FEED()
 
 void ENABLE_ADAPTIVE_FEED()
 {
+    CANON_RECORD(CANON_REC_ENABLE_ADAPTIVE_FEED, 0);
     EMC_MOTION_ADAPTIVE emcmotAdaptiveMsg;
     flush_segments();
 
@@ -2298,6 +2529,7 @@ void ENABLE_ADAPTIVE_FEED()
 //refers to spindle speed
 void DISABLE_SPEED_OVERRIDE(int spindle)
 {
+    CANON_RECORD(CANON_REC_DISABLE_SPEED_OVERRIDE, 0, {}, {spindle});
     EMC_TRAJ_SET_SO_ENABLE set_so_enable_msg;
     flush_segments();
     
@@ -2309,6 +2541,7 @@ void DISABLE_SPEED_OVERRIDE(int spindle)
 
 void ENABLE_SPEED_OVERRIDE(int spindle)
 {
+    CANON_RECORD(CANON_REC_ENABLE_SPEED_OVERRIDE, 0, {}, {spindle});
     EMC_TRAJ_SET_SO_ENABLE set_so_enable_msg;
     flush_segments();
     
@@ -2319,6 +2552,7 @@ void ENABLE_SPEED_OVERRIDE(int spindle)
 
 void ENABLE_FEED_HOLD()
 {
+    CANON_RECORD(CANON_REC_ENABLE_FEED_HOLD, 0);
     EMC_TRAJ_SET_FH_ENABLE set_feed_hold_msg;
     flush_segments();
     
@@ -2328,6 +2562,7 @@ void ENABLE_FEED_HOLD()
 
 void DISABLE_FEED_HOLD()
 {
+    CANON_RECORD(CANON_REC_DISABLE_FEED_HOLD, 0);
     EMC_TRAJ_SET_FH_ENABLE set_feed_hold_msg;
     flush_segments();
     
@@ -2337,6 +2572,7 @@ void DISABLE_FEED_HOLD()
 
 void FLOOD_OFF()
 {
+    CANON_RECORD(CANON_REC_FLOOD_OFF, 0);
     EMC_COOLANT_FLOOD_OFF flood_off_msg;
 
     flush_segments();
@@ -2346,6 +2582,7 @@ void FLOOD_OFF()
 
 void FLOOD_ON()
 {
+    CANON_RECORD(CANON_REC_FLOOD_ON, 0);
     EMC_COOLANT_FLOOD_ON flood_on_msg;
 
     flush_segments();
@@ -2355,6 +2592,7 @@ void FLOOD_ON()
 
 void MESSAGE(char *s)
 {
+    CANON_RECORD(CANON_REC_MESSAGE, 0, {}, {}, s);
     EMC_OPERATOR_DISPLAY operator_display_msg;
 
     flush_segments();
@@ -2394,6 +2632,7 @@ void LOGCLOSE() {
 
 void MIST_OFF()
 {
+    CANON_RECORD(CANON_REC_MIST_OFF, 0);
     EMC_COOLANT_MIST_OFF mist_off_msg;
 
     flush_segments();
@@ -2403,6 +2642,7 @@ void MIST_OFF()
 
 void MIST_ON()
 {
+    CANON_RECORD(CANON_REC_MIST_ON, 0);
     EMC_COOLANT_MIST_ON mist_on_msg;
 
     flush_segments();
@@ -2412,16 +2652,19 @@ void MIST_ON()
 
 void PALLET_SHUTTLE()
 {
+    CANON_RECORD(CANON_REC_PALLET_SHUTTLE, 0);
     /*! \todo FIXME-- unimplemented */
 }
 
 void TURN_PROBE_OFF()
 {
+    CANON_RECORD(CANON_REC_TURN_PROBE_OFF, 0);
     // don't do anything-- this is called when the probing is done
 }
 
 void TURN_PROBE_ON()
 {
+    CANON_RECORD(CANON_REC_TURN_PROBE_ON, 0);
     EMC_TRAJ_CLEAR_PROBE_TRIPPED_FLAG clearMsg;
 
     interp_list.append(clearMsg);
@@ -2436,6 +2679,7 @@ void UNCLAMP_AXIS(CANON_AXIS axis)
 
 void PROGRAM_STOP()
 {
+    CANON_RECORD(CANON_REC_PROGRAM_STOP, 0);
     /* 
        implement this as a pause. A resume will cause motion to proceed. */
     EMC_TASK_PLAN_PAUSE pauseMsg;
@@ -2447,6 +2691,7 @@ void PROGRAM_STOP()
 
 void SET_BLOCK_DELETE(bool state)
 {
+    CANON_RECORD(CANON_REC_SET_BLOCK_DELETE, 0, {}, {state});
     canon.block_delete = state; //state == ON, means we don't interpret lines starting with "/"
 }
 
@@ -2458,6 +2703,7 @@ bool GET_BLOCK_DELETE()
 
 void SET_OPTIONAL_PROGRAM_STOP(bool state)
 {
+    CANON_RECORD(CANON_REC_SET_OPTIONAL_PROGRAM_STOP, 0, {}, {state});
     canon.optional_program_stop = state; //state == ON, means we stop
 }
 
@@ -2468,6 +2714,7 @@ bool GET_OPTIONAL_PROGRAM_STOP()
 
 void OPTIONAL_PROGRAM_STOP()
 {
+    CANON_RECORD(CANON_REC_OPTIONAL_PROGRAM_STOP, 0);
     EMC_TASK_PLAN_OPTIONAL_STOP stopMsg;
 
     flush_segments();
@@ -2477,6 +2724,7 @@ void OPTIONAL_PROGRAM_STOP()
 
 void PROGRAM_END()
 {
+    CANON_RECORD(CANON_REC_PROGRAM_END, 0);
     flush_segments();
 
     EMC_TASK_PLAN_END endMsg;
@@ -2535,6 +2783,7 @@ double GET_EXTERNAL_TOOL_LENGTH_WOFFSET()
   */
 void INIT_CANON()
 {
+    CANON_RECORD(CANON_REC_INIT_CANON, 0);
     double units;
 
     chained_points.clear();
@@ -2619,7 +2868,10 @@ void CANON_ERROR(const char *fmt, ...)
   GET_EXTERNAL_TOOL_TABLE(int pocket)
 
   Returns the tool table structure associated with pocket. Note that
-  pocket can run from 0 (by definition, the spindle), to pocket CANON_POCKETS_MAX - 1.
+  pocket can run from 0 (by definition, the spindle), to
+  GET_EXTERNAL_POCKETS_MAX() - 1.  The pockets below CANON_POCKETS_MAX
+  come from iocontrol's status, the rest from the tool table file as
+  iocontrol last saved it.
 
   Tool table is always in machine units.
 
@@ -2628,7 +2880,7 @@ CANON_TOOL_TABLE GET_EXTERNAL_TOOL_TABLE(int pocket)
 {
     CANON_TOOL_TABLE retval;
 
-    if (pocket < 0 || pocket >= CANON_POCKETS_MAX) {
+    if (pocket < 0) {
 	retval.toolno = -1;
         ZERO_EMC_POSE(retval.offset);
         retval.frontangle = 0.0;
@@ -2636,7 +2888,7 @@ CANON_TOOL_TABLE GET_EXTERNAL_TOOL_TABLE(int pocket)
 	retval.diameter = 0.0;
         retval.orientation = 0;
     } else {
-	retval = emcStatus->io.tool.toolTable[pocket];
+	retval = tool_table_get(emcStatus->io.tool.toolTable, pocket);
     }
 
     return retval;
@@ -2819,9 +3071,12 @@ CANON_DIRECTION GET_EXTERNAL_SPINDLE(int spindle)
     return CANON_COUNTERCLOCKWISE;
 }
 
+// called by the interpreter's synch before it reads the tool table, so
+// this is where the entries past the NML status are brought up to date
 int GET_EXTERNAL_POCKETS_MAX()
 {
-    return CANON_POCKETS_MAX;
+    tool_table_refresh(tool_table_file, task_methods->random_toolchanger);
+    return tool_table_size();
 }
 
 static char _parameter_file_name[LINELEN];
@@ -3015,6 +3270,11 @@ int GET_EXTERNAL_TOOL_SLOT()
             return pocket;
         }
     }
+    for (pocket = CANON_POCKETS_MAX - 1; (pocket = tool_table_next(pocket)) >= 0; ) {
+        if (tool_table_get(emcStatus->io.tool.toolTable, pocket).toolno == toolno) {
+            return pocket;
+        }
+    }
 
     return 0;  // no tool in spindle
 }
@@ -3134,6 +3394,7 @@ int USER_DEFINED_FUNCTION_ADD(USER_DEFINED_FUNCTION_TYPE func, int num)
 */
 void SET_MOTION_OUTPUT_BIT(int index)
 {
+  CANON_RECORD(CANON_REC_SET_MOTION_OUTPUT_BIT, 0, {}, {index});
   EMC_MOTION_SET_DOUT dout_msg;
 
   flush_segments();
@@ -3162,6 +3423,7 @@ void SET_MOTION_OUTPUT_BIT(int index)
 */
 void CLEAR_MOTION_OUTPUT_BIT(int index)
 {
+  CANON_RECORD(CANON_REC_CLEAR_MOTION_OUTPUT_BIT, 0, {}, {index});
   EMC_MOTION_SET_DOUT dout_msg;
 
   flush_segments();
@@ -3187,6 +3449,7 @@ void CLEAR_MOTION_OUTPUT_BIT(int index)
 */
 void SET_AUX_OUTPUT_BIT(int index)
 {
+  CANON_RECORD(CANON_REC_SET_AUX_OUTPUT_BIT, 0, {}, {index});
 
   EMC_MOTION_SET_DOUT dout_msg;
 
@@ -3213,6 +3476,7 @@ void SET_AUX_OUTPUT_BIT(int index)
 */
 void CLEAR_AUX_OUTPUT_BIT(int index)
 {
+  CANON_RECORD(CANON_REC_CLEAR_AUX_OUTPUT_BIT, 0, {}, {index});
   EMC_MOTION_SET_DOUT dout_msg;
 
   flush_segments();
@@ -3234,6 +3498,7 @@ void CLEAR_AUX_OUTPUT_BIT(int index)
 */
 void SET_MOTION_OUTPUT_VALUE(int index, double value)
 {
+  CANON_RECORD(CANON_REC_SET_MOTION_OUTPUT_VALUE, 0, {value}, {index});
   EMC_MOTION_SET_AOUT aout_msg;
 
   flush_segments();
@@ -3255,6 +3520,7 @@ void SET_MOTION_OUTPUT_VALUE(int index, double value)
 */
 void SET_AUX_OUTPUT_VALUE(int index, double value)
 {
+  CANON_RECORD(CANON_REC_SET_AUX_OUTPUT_VALUE, 0, {value}, {index});
   EMC_MOTION_SET_AOUT aout_msg;
 
   flush_segments();
@@ -3279,6 +3545,7 @@ int WAIT(int index, /* index of the motion exported input */
 	 int wait_type,  /* 0 - immediate, 1 - rise, 2 - fall, 3 - be high, 4 - be low */
 	 double timeout) /* time to wait [in seconds], if the input didn't change the value -1 is returned */
 {
+  CANON_RECORD(CANON_REC_WAIT, 0, {timeout}, {index, input_type, wait_type});
   if (input_type == DIGITAL_INPUT) {
     if ((index < 0) || (index >= EMCMOT_MAX_DIO))
 	return -1;
@@ -3301,6 +3568,7 @@ int WAIT(int index, /* index of the motion exported input */
 }
 
 int UNLOCK_ROTARY(int line_number, int joint_num) {
+    CANON_RECORD(CANON_REC_UNLOCK_ROTARY, line_number, {}, {joint_num});
     EMC_TRAJ_LINEAR_MOVE m;
     // first, set up a zero length move to interrupt blending and get to final position
     m.type = EMC_MOTION_TYPE_TRAVERSE;
@@ -3327,6 +3595,7 @@ int UNLOCK_ROTARY(int line_number, int joint_num) {
 }
 
 int LOCK_ROTARY(int line_number, int joint_num) {
+    CANON_RECORD(CANON_REC_LOCK_ROTARY, line_number, {}, {joint_num});
     canon.rotary_unlock_for_traverse = -1;
     return 0;
 }
@@ -3337,6 +3606,7 @@ int LOCK_ROTARY(int line_number, int joint_num) {
  */
 void PLUGIN_CALL(int len, const char *call)
 {
+    CANON_RECORD(CANON_REC_PLUGIN_CALL, 0, {}, {}, call, len);
     EMC_EXEC_PLUGIN_CALL call_msg;
     if (len > (int) sizeof(call_msg.call)) {
 	// really should call it quits here, this is going to fail
@@ -3353,6 +3623,7 @@ void PLUGIN_CALL(int len, const char *call)
 
 void IO_PLUGIN_CALL(int len, const char *call)
 {
+    CANON_RECORD(CANON_REC_IO_PLUGIN_CALL, 0, {}, {}, call, len);
     EMC_IO_PLUGIN_CALL call_msg;
     if (len > (int) sizeof(call_msg.call)) {
 	// really should call it quits here, this is going to fail
@@ -46,6 +46,7 @@
   issued.
   */
 
+#include <Python.h>		// PyGILState_Ensure()
 #include <stdio.h>		// vsprintf()
 #include <string.h>		// strcpy()
 #include <stdarg.h>		// va_start()
@@ -56,6 +57,9 @@
 #include <unistd.h>		// fork()
 #include <sys/wait.h>		// waitpid(), WNOHANG, WIFEXITED
 #include <ctype.h>		// isspace()
+#include <pthread.h>		// pthread_create()
+#include <time.h>		// clock_gettime()
+#include <atomic>
 #include <libintl.h>
 #include <locale.h>
 #include "usrmotintf.h"
@@ -71,6 +75,7 @@ fpu_control_t __fpu_control = _FPU_IEEE & ~(_FPU_MASK_IM | _FPU_MASK_ZM | _FPU_M
 #include "emc.hh"		// EMC NML
 #include "emc_nml.hh"
 #include "canon.hh"		// CANON_TOOL_TABLE stuff
+#include "canon_record.hh"	// canonRecorder
 #include "inifile.hh"		// INIFILE
 #include "interpl.hh"		// NML_INTERP_LIST, interp_list
 #include "emcglb.h"		// EMC_INIFILE,NMLFILE, EMC_TASK_CYCLE_TIME
@@ -103,8 +108,53 @@ static RCS_CMD_MSG *emcCommand = 0;
 // global EMC status
 EMC_STAT *emcStatus = 0;
 
-// timer stuff
-static RCS_TIMER *timer = 0;
+// adaptive cycle: the main loop starts a new cycle emc_task_cycle_time
+// after the last one started, but polls every task_poll_interval while
+// it waits and starts early when a command arrives, or when a program
+// is being read and motion has run its queue down below
+// task_queue_low_water segments.  When the last cycle left nothing in
+// progress it sleeps the whole cycle instead, so an idle task does not
+// wake every task_poll_interval.
+static double task_poll_interval = 0.001;	// [TASK] POLL_INTERVAL
+static int task_queue_low_water = 20;	// [TASK] QUEUE_LOW_WATER, 0 disables
+static double task_readahead_time = 0.0;	// [TASK] READAHEAD_TIME, 0 = half the cycle
+static int task_last_depth = 0;	// motion queue depth at end of last cycle
+static int task_command_waiting = 0;	// wait ended on a new command
+static int task_busy = 0;	// the last cycle ended with work in progress
+// kept outside emcStatus, which the main loop only touches under
+// task_mutex, and copied in at the start of each locked cycle
+static int task_motion_starvations = 0;
+static double task_cycle_time = 0.0;
+static double task_cycle_work_time = 0.0;
+
+// The interpreter reads ahead in its own thread, so that a slow line
+// (a Python remap, a long o-word loop) does not hold up commands and
+// status.  task_mutex guards the interpreter, interp_list and
+// emcStatus->task: the main loop holds it for the whole of each cycle,
+// and the reader holds it while it reads.  The reader only runs after
+// a cycle in which emcTaskPlan() would have read ahead itself, so
+// aborts, pauses and synchs are seen before any more is read.
+//
+// While the reader holds task_mutex past the start of a cycle, the main
+// loop may not touch emcStatus or the interpreter.  It publishes status
+// from reader_status instead, a copy of emcStatus->task and ->motion
+// taken under the lock at the end of the last cycle with motion and io
+// brought up to date, and it stops motion and the spindles at once on
+// an abort or estop, leaving the rest of it to the next locked cycle.
+static pthread_t reader_thread;
+static int reader_started = 0;
+static pthread_mutex_t task_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reader_cond = PTHREAD_COND_INITIALIZER;
+static int readahead_wanted = 0;	// set by emcTaskPlan() this cycle
+static int reader_go = 0;		// reader may run until the next cycle
+static int program_reading = 0;	// reader_go as of the end of the cycle
+static std::atomic<int> reader_yield(0);	// a command is waiting
+static EMC_STAT *reader_status = NULL;	// published while the reader holds the lock
+static int reader_status_used = 0;	// published since the last locked cycle
+// the main thread's Python state while it is not holding task_mutex,
+// or NULL if there is no Python
+static PyThreadState *main_python_state = NULL;
+static PyGILState_STATE main_gil;
 
 // flag signifying that ini file [TASK] CYCLE_TIME is <= 0.0, so
 // we should not delay at all between cycles. This means also that
@@ -158,6 +208,17 @@ void emctask_quit(int sig)
     signal(sig, emctask_quit);
 }
 
+// the error channel is written from the main loop and the reader thread
+static pthread_mutex_t error_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+template <class T> static int emcErrorBufferWrite(T &msg)
+{
+    pthread_mutex_lock(&error_mutex);
+    int retval = emcErrorBuffer->write(msg);
+    pthread_mutex_unlock(&error_mutex);
+    return retval;
+}
+
 /* make sure at least space bytes are available on
  * error channel; wait a bit to drain if needed
  */
@@ -222,7 +283,7 @@ int emcOperatorError(int id, const char *fmt, ...)
 
     // write it
     rcs_print("%s\n", error_msg.error);
-    return emcErrorBuffer->write(error_msg);
+    return emcErrorBufferWrite(error_msg);
 }
 
 int emcOperatorText(int id, const char *fmt, ...)
@@ -242,7 +303,7 @@ int emcOperatorText(int id, const char *fmt, ...)
     text_msg.text[LINELEN - 1] = 0;
 
     // write it
-    return emcErrorBuffer->write(text_msg);
+    return emcErrorBufferWrite(text_msg);
 }
 
 int emcOperatorDisplay(int id, const char *fmt, ...)
@@ -262,7 +323,7 @@ int emcOperatorDisplay(int id, const char *fmt, ...)
     display_msg.display[LINELEN - 1] = 0;
 
     // write it
-    return emcErrorBuffer->write(display_msg);
+    return emcErrorBufferWrite(display_msg);
 }
 
 /*
@@ -380,6 +441,7 @@ static EMC_TRAJ_SET_VELOCITY *emcTrajSetVelocityMsg;
 static EMC_TRAJ_SET_ACCELERATION *emcTrajSetAccelerationMsg;
 static EMC_TRAJ_LINEAR_MOVE *emcTrajLinearMoveMsg;
 static EMC_TRAJ_CIRCULAR_MOVE *emcTrajCircularMoveMsg;
+static EMC_TRAJ_SPLINE_MOVE *emcTrajSplineMoveMsg;
 static EMC_TRAJ_DELAY *emcTrajDelayMsg;
 static EMC_TRAJ_SET_TERM_COND *emcTrajSetTermCondMsg;
 static EMC_TRAJ_SET_SPINDLESYNC *emcTrajSetSpindlesyncMsg;
@@ -477,6 +539,9 @@ static int checkInterpList(NML_INTERP_LIST * il, EMC_STAT * stat)
 	case EMC_TRAJ_CIRCULAR_MOVE_TYPE:
 	    break;
 
+	case EMC_TRAJ_SPLINE_MOVE_TYPE:
+	    break;
+
 	default:
 	    break;
 	}
@@ -491,10 +556,79 @@ static int checkInterpList(NML_INTERP_LIST * il, EMC_STAT * stat)
 }
 extern int emcTaskMopup();
 
+// true while a program is running and the interpreter is free to read
+// ahead, which is when motion's queue should be kept from running dry
+static int reading_program(void)
+{
+    return emcStatus->task.mode == EMC_TASK_MODE_AUTO &&
+	emcStatus->task.interpState == EMC_TASK_INTERP_READING &&
+	!emcTaskPlanIsWait();
+}
+
+// count the times motion's queue empties while the interpreter should
+// have been keeping it full
+static void note_motion_depth(int depth, int reading)
+{
+    static int was_empty = 1;
+
+    if (depth == 0 && !was_empty && reading) {
+	task_motion_starvations++;
+    }
+    was_empty = (depth == 0);
+}
+
+// true when a running program needs more segments queued now rather
+// than at the end of the cycle.  Only once motion has used up some of
+// what was queued, so a stalled queue does not keep task spinning.
+// Called without task_mutex, so it goes by program_reading rather than
+// emcStatus->task.
+static int motion_needs_segments(void)
+{
+    static emcmot_status_t s;
+
+    if (task_queue_low_water <= 0 || !program_reading) {
+	return 0;
+    }
+    if (usrmotReadEmcmotStatusParts(&s, EMCMOT_STATUS_TRAJ) != EMCMOT_COMM_OK) {
+	return 0;
+    }
+    note_motion_depth(s.depth, 1);
+    return s.depth < task_queue_low_water && s.depth < task_last_depth;
+}
+
+// wait for the next cycle, which is due emc_task_cycle_time after
+// cycle_start unless a reason to start it early shows up first
+static void emctask_wait(double cycle_start)
+{
+    double deadline = cycle_start + emc_task_cycle_time;
+    double now;
+
+    while (!done && (now = etime()) < deadline) {
+	double slice = deadline - now;
+	if (task_busy && slice > task_poll_interval) {
+	    slice = task_poll_interval;
+	}
+	esleep(slice);
+	if (emcCommandBuffer->peek() > 0) {
+	    // peek() marks the message as seen, so the read() at the
+	    // top of the loop will not report it as new
+	    task_command_waiting = 1;
+	    return;
+	}
+	if (motion_needs_segments()) {
+	    return;
+	}
+    }
+}
+
 void readahead_reading(void)
 {
     int readRetval;
     int execRetval;
+    double burst = task_readahead_time > 0.0 ? task_readahead_time
+	: emc_task_cycle_time / 2.0;
+    // no bound when running without a cycle time
+    double burst_end = burst > 0.0 ? etime() + burst : DBL_MAX;
 
 		if (interp_list.len() <= emc_task_interp_max_len) {
                     int count = 0;
@@ -617,7 +751,9 @@ interpret_again:
 
                             if (count++ < emc_task_interp_max_len
                                     && emcStatus->task.interpState == EMC_TASK_INTERP_READING
-                                    && interp_list.len() <= emc_task_interp_max_len * 2/3) {
+                                    && interp_list.len() <= emc_task_interp_max_len * 2/3
+                                    && etime() < burst_end
+                                    && !reader_yield) {
                                 goto interpret_again;
                             }
 
@@ -626,6 +762,156 @@ interpret_again:
 		}		// if interp len is less than max
 }
 
+// take task_mutex for a cycle, giving up after budget seconds if the
+// reader is still busy with a line.  The Python GIL goes with it.
+static int task_lock(double budget)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    if (budget < task_poll_interval) {
+	budget = task_poll_interval;
+    }
+    ts.tv_sec += (time_t) budget;
+    ts.tv_nsec += (long) ((budget - (time_t) budget) * 1e9);
+    if (ts.tv_nsec >= 1000000000L) {
+	ts.tv_sec++;
+	ts.tv_nsec -= 1000000000L;
+    }
+    if (0 != pthread_mutex_timedlock(&task_mutex, &ts)) {
+	return -1;
+    }
+    if (main_python_state) {
+	main_gil = PyGILState_Ensure();
+    }
+    return 0;
+}
+
+static void task_unlock(void)
+{
+    if (main_python_state) {
+	PyGILState_Release(main_gil);
+    }
+    pthread_mutex_unlock(&task_mutex);
+}
+
+static void *reader_main(void *)
+{
+    pthread_mutex_lock(&task_mutex);
+    while (!done) {
+	if (!reader_go) {
+	    pthread_cond_wait(&reader_cond, &task_mutex);
+	    continue;
+	}
+	reader_go = 0;
+	PyGILState_STATE gil = PyGILState_UNLOCKED;
+	if (main_python_state) {
+	    gil = PyGILState_Ensure();
+	}
+	readahead_reading();
+	if (main_python_state) {
+	    PyGILState_Release(gil);
+	}
+    }
+    pthread_mutex_unlock(&task_mutex);
+    return NULL;
+}
+
+// start the reader; from here on the main loop has to hold task_mutex
+// to touch the interpreter
+static int reader_start(void)
+{
+    reader_status = new EMC_STAT;
+    if (Py_IsInitialized()) {
+	main_python_state = PyEval_SaveThread();
+    }
+    if (0 != pthread_create(&reader_thread, NULL, reader_main, NULL)) {
+	rcs_print_error("can't start interpreter reader thread\n");
+	if (main_python_state) {
+	    PyEval_RestoreThread(main_python_state);
+	    main_python_state = NULL;
+	}
+	return -1;
+    }
+    reader_started = 1;
+    return 0;
+}
+
+static void reader_stop(void)
+{
+    if (reader_started) {
+	pthread_mutex_lock(&task_mutex);
+	done = 1;
+	pthread_cond_signal(&reader_cond);
+	pthread_mutex_unlock(&task_mutex);
+	pthread_join(reader_thread, NULL);
+	reader_started = 0;
+    }
+    if (main_python_state) {
+	PyEval_RestoreThread(main_python_state);
+	main_python_state = NULL;
+    }
+    delete reader_status;
+    reader_status = NULL;
+}
+
+// keep the status that goes out while the reader holds task_mutex;
+// io is left out, it is read fresh each time
+static void reader_status_save(void)
+{
+    reader_status->task = emcStatus->task;
+    reader_status->motion = emcStatus->motion;
+    reader_status->status = emcStatus->status;
+    reader_status->command_type = emcStatus->command_type;
+    reader_status->echo_serial_number = emcStatus->echo_serial_number;
+    reader_status->debug = emcStatus->debug;
+}
+
+// a cycle without task_mutex: publish reader_status, and stop the
+// machine if an abort or estop cannot wait for the reader's line
+static void reader_busy_cycle(void)
+{
+    static int stopped_serial = -1;
+    static int stopped_estop = 0;
+    int stop = 0;
+
+    emcIoUpdate(&reader_status->io);
+    emcMotionUpdate(&reader_status->motion);
+    reader_status->task.heartbeat++;
+    reader_status_used = 1;
+    emcStatusBuffer->write(reader_status);
+
+    if (!reader_status->io.aux.estop) {
+	stopped_estop = 0;
+    } else if (!stopped_estop && reader_status->motion.traj.enabled) {
+	stopped_estop = 1;
+	stop = 1;
+    }
+    if (task_command_waiting &&
+	stopped_serial != emcCommand->serial_number) {
+	// the command was peeked, emcCommand holds it
+	if (emcCommand->type == EMC_TASK_ABORT_TYPE) {
+	    stop = 1;
+	} else if (emcCommand->type == EMC_TASK_SET_STATE_TYPE) {
+	    EMC_TASK_STATE_ENUM state =
+		((EMC_TASK_SET_STATE *) emcCommand)->state;
+	    if (state == EMC_TASK_STATE_ESTOP ||
+		state == EMC_TASK_STATE_OFF) {
+		stop = 1;
+	    }
+	}
+	stopped_serial = emcCommand->serial_number;
+    }
+    if (stop) {
+	// the locked cycle does the full abort; emcTrajDisable() is
+	// left to it since it goes by motion.traj.enabled
+	emcMotionAbort();
+	for (int s = 0; s < reader_status->motion.traj.spindles; s++) {
+	    emcSpindleAbort(s);
+	}
+    }
+}
+
 static void mdi_execute_abort(void)
 {
     int queued_mdi_commands;
@@ -1170,8 +1456,9 @@ static int emcTaskPlan(void)
 
 		}		// switch (type) in ON, AUTO, READING
 
-               // handle interp readahead logic
-                readahead_reading();
+               // handle interp readahead logic, in the reader
+                // thread once this cycle is over
+                readahead_wanted = 1;
                 
 		break;		// EMC_TASK_INTERP_READING
 
@@ -1499,6 +1786,7 @@ static int emcTaskCheckPreconditions(NMLmsg * cmd)
 
     case EMC_TRAJ_LINEAR_MOVE_TYPE:
     case EMC_TRAJ_CIRCULAR_MOVE_TYPE:
+    case EMC_TRAJ_SPLINE_MOVE_TYPE:
     case EMC_TRAJ_SET_VELOCITY_TYPE:
     case EMC_TRAJ_SET_ACCELERATION_TYPE:
     case EMC_TRAJ_SET_TERM_COND_TYPE:
@@ -1839,6 +2127,17 @@ static int emcTaskIssueCommand(NMLmsg * cmd)
                 emcTrajCircularMoveMsg->acc);
 	break;
 
+    case EMC_TRAJ_SPLINE_MOVE_TYPE:
+	emcTrajUpdateTag(((EMC_TRAJ_SPLINE_MOVE *) cmd)->tag);
+	emcTrajSplineMoveMsg = (EMC_TRAJ_SPLINE_MOVE *) cmd;
+        retval = emcTrajSplineMove(emcTrajSplineMoveMsg->end,
+                emcTrajSplineMoveMsg->ctrl, emcTrajSplineMoveMsg->weight,
+                emcTrajSplineMoveMsg->degree, emcTrajSplineMoveMsg->type,
+                emcTrajSplineMoveMsg->vel,
+                emcTrajSplineMoveMsg->ini_maxvel,
+                emcTrajSplineMoveMsg->acc);
+	break;
+
     case EMC_TRAJ_PAUSE_TYPE:
 	emcStatus->task.task_paused = 1;
 	retval = emcTrajPause();
@@ -2426,6 +2725,7 @@ static int emcTaskCheckPostconditions(NMLmsg * cmd)
 
     case EMC_TRAJ_LINEAR_MOVE_TYPE:
     case EMC_TRAJ_CIRCULAR_MOVE_TYPE:
+    case EMC_TRAJ_SPLINE_MOVE_TYPE:
     case EMC_TRAJ_SET_VELOCITY_TYPE:
     case EMC_TRAJ_SET_ACCELERATION_TYPE:
     case EMC_TRAJ_SET_TERM_COND_TYPE:
@@ -2967,10 +3267,6 @@ static int emctask_startup()
 	rcs_print_error("can't get emcError buffer\n");
 	return -1;
     }
-    // get the timer
-    if (!emcTaskNoDelay) {
-	timer = new RCS_TIMER(emc_task_cycle_time, "", "");
-    }
     // initialize the subsystems
 
     // IO first
@@ -3096,11 +3392,7 @@ static int emctask_shutdown(void)
 	emcMotionHalt();
 	emcIoHalt();
     }
-    // delete the timer
-    if (0 != timer) {
-	delete timer;
-	timer = 0;
-    }
+    canonRecorder.close();
     // delete the NML channels
 
     if (0 != emcErrorBuffer) {
@@ -3228,6 +3520,48 @@ static int iniLoad(const char *filename)
     }
 
 
+    saveDouble = task_poll_interval;
+    if (NULL != (inistring = inifile.Find("POLL_INTERVAL", "TASK"))) {
+	if (1 != sscanf(inistring, "%lf", &task_poll_interval) ||
+	    task_poll_interval <= 0.0) {
+	    task_poll_interval = saveDouble;
+	    rcs_print
+		("invalid [TASK] POLL_INTERVAL in %s (%s); using default %f\n",
+		 filename, inistring, task_poll_interval);
+	}
+    }
+
+    saveInt = task_queue_low_water;
+    if (NULL != (inistring = inifile.Find("QUEUE_LOW_WATER", "TASK"))) {
+	if (1 != sscanf(inistring, "%d", &task_queue_low_water) ||
+	    task_queue_low_water < 0) {
+	    task_queue_low_water = saveInt;
+	    rcs_print
+		("invalid [TASK] QUEUE_LOW_WATER in %s (%s); using default %d\n",
+		 filename, inistring, task_queue_low_water);
+	}
+    }
+
+    saveDouble = task_readahead_time;
+    if (NULL != (inistring = inifile.Find("READAHEAD_TIME", "TASK"))) {
+	if (1 != sscanf(inistring, "%lf", &task_readahead_time) ||
+	    task_readahead_time < 0.0) {
+	    task_readahead_time = saveDouble;
+	    rcs_print
+		("invalid [TASK] READAHEAD_TIME in %s (%s); using default %f\n",
+		 filename, inistring, task_readahead_time);
+	}
+    }
+
+    if (NULL != (inistring = inifile.Find("ARC_FIT", "TASK"))) {
+	if (1 != sscanf(inistring, "%d", &emc_task_arc_fit)) {
+	    emc_task_arc_fit = 1;
+	    rcs_print
+		("invalid [TASK] ARC_FIT in %s (%s); using default %d\n",
+		 filename, inistring, emc_task_arc_fit);
+	}
+    }
+
     if (NULL != (inistring = inifile.Find("NO_FORCE_HOMING", "TRAJ"))) {
 	if (1 == sscanf(inistring, "%d", &no_force_homing)) {
 	    // found it
@@ -3257,6 +3591,13 @@ static int iniLoad(const char *filename)
 	max_mdi_queued_commands = atoi(inistring);
     }
 
+    // record the canonical calls the interpreter makes, for canterp
+    if (NULL != (inistring = inifile.Find("CANON_RECORD", "TASK"))) {
+	if (0 != canonRecorder.open(inistring)) {
+	    rcs_print("can't write [TASK] CANON_RECORD file %s\n", inistring);
+	}
+    }
+
     // close it
     inifile.Close();
 
@@ -3368,11 +3709,34 @@ int main(int argc, char *argv[])
     if (0 != usrmotReadEmcmotConfig(&emcmotConfig)) {
         rcs_print("%s failed usrmotReadEmcmotconfig()\n",__FILE__);
     }
+    reader_start();
     while (!done) {
         static int gave_soft_limit_message = 0;
+	double cycleStart = etime();
+	// a new command makes the reader stop at the end of its line
+	if (task_command_waiting || emcCommandBuffer->peek() > 0) {
+	    task_command_waiting = 1;
+	    reader_yield = 1;
+	}
+	if (0 != task_lock(emc_task_cycle_time)) {
+	    // the reader is still on one line; keep the heartbeat and
+	    // motion status going, and leave commands until it is done
+	    reader_busy_cycle();
+	    continue;
+	}
+	reader_yield = 0;
+	if (reader_status_used) {
+	    // carry on counting from what went out
+	    emcStatus->task.heartbeat = reader_status->task.heartbeat;
+	    reader_status_used = 0;
+	}
+	emcStatus->task.motionStarvations = task_motion_starvations;
+	emcStatus->task.cycleTime = task_cycle_time;
+	emcStatus->task.cycleWorkTime = task_cycle_work_time;
         check_ini_hal_items(emcStatus->motion.traj.joints);
 	// read command
-	if (0 != emcCommandBuffer->read()) {
+	if (0 != emcCommandBuffer->read() || task_command_waiting) {
+	    task_command_waiting = 0;
 	    // got a new command, so clear out errors
 	    taskPlanError = 0;
 	    taskExecuteError = 0;
@@ -3549,11 +3913,27 @@ int main(int argc, char *argv[])
 	// no need to call the individual functions on all WM items.
 	emcStatusBuffer->write(emcStatus);
 
-	// wait on timer cycle, if specified, or calculate actual
+	task_last_depth = emcStatus->motion.traj.queue;
+	note_motion_depth(task_last_depth, reading_program());
+	reader_go = program_reading = readahead_wanted;
+	readahead_wanted = 0;
+	task_busy = program_reading || emcStatus->status != RCS_DONE;
+	if (!reader_started && reader_go) {
+	    readahead_reading();
+	} else if (reader_go) {
+	    reader_status_save();
+	    pthread_cond_signal(&reader_cond);
+	}
+	task_unlock();
+
+	// wait for the next cycle, if specified, or calculate actual
 	// interval if ini file says to run full out via
 	// [TASK] CYCLE_TIME <= 0.0d
 	// emcTaskEager = 0;
         endTime = etime();
+        // reported with the next status write
+        task_cycle_time = endTime - startTime;
+        task_cycle_work_time = endTime - cycleStart;
         deltaTime = endTime - startTime;
         if (deltaTime < minTime)
             minTime = deltaTime;
@@ -3570,10 +3950,11 @@ int main(int argc, char *argv[])
 	if ((emcTaskNoDelay) || (emcTaskEager)) {
 	    emcTaskEager = 0;
 	} else {
-	    timer->wait();
+	    emctask_wait(cycleStart);
 	}
     }
     // end of while (! done)
+    reader_stop();
 
     rcs_print(
         "task: %u cycles, min=%.6f, max=%.6f, avg=%.6f, %u latency excursions (> %dx expected cycle time of %.6fs)\n",
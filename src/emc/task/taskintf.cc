@@ -1452,6 +1452,45 @@ int emcTrajCircularMove(EmcPose end, PM_CARTESIAN center,
     return usrmotWriteEmcmotCommand(&emcmotCommand);
 }
 
+int emcTrajSplineMove(EmcPose end, const PM_CARTESIAN ctrl[],
+		      const double weight[], int degree, int type, double vel,
+		      double ini_maxvel, double acc)
+{
+    if (degree < 1 || degree >= EMCMOT_MAX_SPLINE_POINTS) {
+	return -1;
+    }
+#ifdef ISNAN_TRAP
+    if (std::isnan(end.tran.x) || std::isnan(end.tran.y) || std::isnan(end.tran.z) ||
+	std::isnan(end.a) || std::isnan(end.b) || std::isnan(end.c) ||
+	std::isnan(end.u) || std::isnan(end.v) || std::isnan(end.w)) {
+	printf("std::isnan error in emcTrajSplineMove()\n");
+	return 0;		// ignore it for now, just don't send it
+    }
+#endif
+
+    emcmotCommand.command = EMCMOT_SET_SPLINE;
+
+    emcmotCommand.pos = end;
+    emcmotCommand.motion_type = type;
+
+    for (int i = 0; i <= degree; i++) {
+	emcmotCommand.ctrl[i].x = ctrl[i].x;
+	emcmotCommand.ctrl[i].y = ctrl[i].y;
+	emcmotCommand.ctrl[i].z = ctrl[i].z;
+	emcmotCommand.weight[i] = weight[i];
+    }
+
+    emcmotCommand.turn = degree;
+    emcmotCommand.id = TrajConfig.MotionId;
+    emcmotCommand.tag = localEmcTrajTag;
+
+    emcmotCommand.vel = vel;
+    emcmotCommand.ini_maxvel = ini_maxvel;
+    emcmotCommand.acc = acc;
+
+    return usrmotWriteEmcmotCommand(&emcmotCommand);
+}
+
 int emcTrajClearProbeTrippedFlag()
 {
     emcmotCommand.command = EMCMOT_CLEAR_PROBE_FLAGS;
@@ -1989,6 +2028,8 @@ int emcMotionUpdate(EMC_MOTION_STAT * stat)
     }
 
     stat->numExtraJoints=emcmotStatus.numExtraJoints;
+    usrmotGetStatusReadStats(&stat->status_reads, &stat->status_retries,
+			     &stat->status_failures);
 
     // set the status flag
     error = 0;
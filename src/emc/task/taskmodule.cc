@@ -468,6 +468,9 @@ BOOST_PYTHON_MODULE(emctask) {
 	.def_readwrite("interpreter_errcode", &EMC_TASK_STAT::interpreter_errcode)
 	.def_readwrite("task_paused", &EMC_TASK_STAT::task_paused)
 	.def_readwrite("delayLeft", &EMC_TASK_STAT::delayLeft)
+	.def_readwrite("cycleTime", &EMC_TASK_STAT::cycleTime)
+	.def_readwrite("cycleWorkTime", &EMC_TASK_STAT::cycleWorkTime)
+	.def_readwrite("motionStarvations", &EMC_TASK_STAT::motionStarvations)
 	;
 
     class_ <EMC_TOOL_STAT, noncopyable>("EMC_TOOL_STAT",no_init)
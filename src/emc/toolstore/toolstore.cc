@@ -0,0 +1,528 @@
+/*    This is a component of LinuxCNC
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <string>
+#include <map>
+#include "emctool.h"
+#include "toolstore.hh"
+#include "tool_parse.h"
+#include <rtapi_string.h>
+
+// an entry of the tool table past the array
+struct tool_entry {
+    CANON_TOOL_TABLE tool;
+    std::string comment;
+};
+
+static std::map<int, tool_entry> extra;
+
+static CANON_TOOL_TABLE empty_tool(void)
+{
+    CANON_TOOL_TABLE tool;
+
+    tool.toolno = -1;
+    tool.pocketno = -1;
+    ZERO_EMC_POSE(tool.offset);
+    tool.diameter = 0.0;
+    tool.frontangle = 0.0;
+    tool.backangle = 0.0;
+    tool.orientation = 0;
+    return tool;
+}
+
+int tool_table_size(void)
+{
+    return extra.empty() ? CANON_POCKETS_MAX : extra.rbegin()->first + 1;
+}
+
+CANON_TOOL_TABLE tool_table_get(const CANON_TOOL_TABLE table[], int index)
+{
+    std::map<int, tool_entry>::const_iterator it;
+
+    if (index >= 0 && index < CANON_POCKETS_MAX)
+        return table[index];
+    if ((it = extra.find(index)) != extra.end())
+        return it->second.tool;
+    return empty_tool();
+}
+
+void tool_table_put(CANON_TOOL_TABLE table[], int index,
+	const CANON_TOOL_TABLE &tool)
+{
+    if (index < 0)
+        return;
+    if (index < CANON_POCKETS_MAX)
+        table[index] = tool;
+    else if (tool.toolno == -1)
+        extra.erase(index);
+    else
+        extra[index].tool = tool;
+}
+
+const char *tool_table_comment(char *const ttcomments[], int index)
+{
+    std::map<int, tool_entry>::const_iterator it;
+
+    if (index >= 0 && index < CANON_POCKETS_MAX)
+        return ttcomments ? ttcomments[index] : "";
+    if ((it = extra.find(index)) != extra.end())
+        return it->second.comment.c_str();
+    return "";
+}
+
+void tool_table_set_comment(char *ttcomments[], int index,
+	const char *comment)
+{
+    std::map<int, tool_entry>::iterator it;
+
+    if (index >= 0 && index < CANON_POCKETS_MAX) {
+        if (ttcomments)
+            rtapi_strlcpy(ttcomments[index], comment, CANON_TOOL_ENTRY_LEN);
+    } else if ((it = extra.find(index)) != extra.end()) {
+        it->second.comment = comment;
+    }
+}
+
+void tool_table_swap(CANON_TOOL_TABLE table[], char *ttcomments[],
+	int a, int b)
+{
+    CANON_TOOL_TABLE tool_a = tool_table_get(table, a);
+    CANON_TOOL_TABLE tool_b = tool_table_get(table, b);
+    std::string comment_a = tool_table_comment(ttcomments, a);
+    std::string comment_b = tool_table_comment(ttcomments, b);
+
+    tool_table_put(table, a, tool_b);
+    tool_table_put(table, b, tool_a);
+    tool_table_set_comment(ttcomments, a, comment_b.c_str());
+    tool_table_set_comment(ttcomments, b, comment_a.c_str());
+}
+
+int tool_table_next(int index)
+{
+    std::map<int, tool_entry>::const_iterator it = extra.upper_bound(index);
+
+    return it == extra.end() ? -1 : it->first;
+}
+
+void tool_table_clear_extra(void)
+{
+    extra.clear();
+}
+
+int tool_table_refresh(const char *filename, int random_toolchanger)
+{
+    // what was loaded last, to tell whether a text file has changed
+    static std::string loaded_name;
+    static struct stat loaded_st;
+    static CANON_TOOL_TABLE *scratch;
+    struct stat st;
+
+    if (!filename || !filename[0])
+        return -1;
+    if (tool_store_is_db(filename)) {
+        if (loaded_name == filename && !tool_store_changed(filename))
+            return 0;
+    } else {
+        if (stat(filename, &st) != 0)
+            return -1;
+        if (loaded_name == filename
+            && st.st_ino == loaded_st.st_ino && st.st_size == loaded_st.st_size
+            && st.st_mtim.tv_sec == loaded_st.st_mtim.tv_sec
+            && st.st_mtim.tv_nsec == loaded_st.st_mtim.tv_nsec)
+            return 0;
+        loaded_st = st;
+    }
+    // the array part comes from the caller's copy, only the rest is kept
+    if (!scratch)
+        scratch = new CANON_TOOL_TABLE[CANON_POCKETS_MAX];
+    loaded_name = filename;
+    return loadToolTable(filename, scratch, NULL, random_toolchanger);
+}
+
+int tool_store_is_db(const char *filename)
+{
+    const char *ext;
+
+    if (!filename || !(ext = strrchr(filename, '.')))
+        return 0;
+    return !strcasecmp(ext, ".db") || !strcasecmp(ext, ".sqlite")
+        || !strcasecmp(ext, ".sqlite3");
+}
+
+#ifdef HAVE_SQLITE3
+#include <sqlite3.h>
+
+/* Same tools table as sql/schema-simple.sql, so a database made from
+   that file can be used as it is, plus an index for looking tools up by
+   pocket.  toolno is the rowid, so lookups by tool number are indexed
+   already. */
+static const char *schema =
+    "PRAGMA journal_mode = WAL;"
+    "CREATE TABLE IF NOT EXISTS tools ("
+    "    toolno INTEGER PRIMARY KEY,"
+    "    pocket INTEGER,"
+    "    diameter REAL DEFAULT (0.0),"
+    "    backangle REAL DEFAULT (0.0),"
+    "    frontangle REAL DEFAULT (0.0),"
+    "    orientation INTEGER DEFAULT (0.0),"
+    "    comment TEXT DEFAULT (NULL),"
+    "    x_offset REAL DEFAULT (0.0),"
+    "    y_offset REAL DEFAULT (0.0),"
+    "    z_offset REAL DEFAULT (0.0),"
+    "    a_offset REAL DEFAULT (0.0),"
+    "    b_offset REAL DEFAULT (0.0),"
+    "    c_offset REAL DEFAULT (0.0),"
+    "    u_offset REAL DEFAULT (0.0),"
+    "    v_offset REAL DEFAULT (0.0),"
+    "    w_offset REAL DEFAULT (0.0));"
+    "CREATE INDEX IF NOT EXISTS tools_pocket ON tools (pocket);";
+
+#define TOOL_COLUMNS "toolno, pocket, diameter, backangle, frontangle, " \
+    "orientation, comment, x_offset, y_offset, z_offset, a_offset, " \
+    "b_offset, c_offset, u_offset, v_offset, w_offset"
+
+// one row of the tools table, as last read from or written to the database
+struct tool_row {
+    CANON_TOOL_TABLE tool;	// pocketno holds the row's pocket
+    std::string comment;
+    bool loaded;		// the row is in the machine's tool table
+};
+
+static struct {
+    sqlite3 *db;
+    std::string name;
+    sqlite3_stmt *select_tools, *upsert_tool, *delete_tool, *data_version;
+    std::map<int, tool_row> rows;
+    int version;		// data_version as of the last load or save
+} store;
+
+static int store_error(const char *what)
+{
+    fprintf(stderr, "tool store %s: %s: %s\n", store.name.c_str(), what,
+            store.db ? sqlite3_errmsg(store.db) : "out of memory");
+    return -1;
+}
+
+static void store_close(void)
+{
+    sqlite3_finalize(store.select_tools);
+    sqlite3_finalize(store.upsert_tool);
+    sqlite3_finalize(store.delete_tool);
+    sqlite3_finalize(store.data_version);
+    sqlite3_close(store.db);
+    store.db = NULL;
+    store.select_tools = store.upsert_tool = store.delete_tool = NULL;
+    store.data_version = NULL;
+    store.name.clear();
+    store.rows.clear();
+}
+
+// open filename unless it is already open, creating the tables if needed
+static int store_open(const char *filename)
+{
+    if (store.db && store.name == filename)
+        return 0;
+    store_close();
+    store.name = filename;
+
+    if (sqlite3_open_v2(filename, &store.db,
+            SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK) {
+        store_error("open");
+        store_close();
+        return -1;
+    }
+    // wait for a GUI that is reading the table instead of failing
+    sqlite3_busy_timeout(store.db, 1000);
+
+    if (sqlite3_exec(store.db, schema, NULL, NULL, NULL) != SQLITE_OK
+        || sqlite3_prepare_v2(store.db,
+            "SELECT " TOOL_COLUMNS " FROM tools ORDER BY toolno", -1,
+            &store.select_tools, NULL) != SQLITE_OK
+        || sqlite3_prepare_v2(store.db,
+            "INSERT OR REPLACE INTO tools (" TOOL_COLUMNS ") VALUES "
+            "(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)", -1,
+            &store.upsert_tool, NULL) != SQLITE_OK
+        || sqlite3_prepare_v2(store.db,
+            "DELETE FROM tools WHERE toolno = ?", -1,
+            &store.delete_tool, NULL) != SQLITE_OK
+        || sqlite3_prepare_v2(store.db, "PRAGMA data_version", -1,
+            &store.data_version, NULL) != SQLITE_OK) {
+        store_error("open");
+        store_close();
+        return -1;
+    }
+    return 0;
+}
+
+static int store_exec(const char *sql)
+{
+    if (sqlite3_exec(store.db, sql, NULL, NULL, NULL) != SQLITE_OK)
+        return store_error(sql);
+    return 0;
+}
+
+// run a statement that returns no rows
+static int store_step(sqlite3_stmt *stmt, const char *what)
+{
+    int rc = sqlite3_step(stmt);
+
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    if (rc != SQLITE_DONE)
+        return store_error(what);
+    return 0;
+}
+
+// changes when another connection commits to the database
+static int data_version(void)
+{
+    int version = -1;
+
+    if (sqlite3_step(store.data_version) == SQLITE_ROW)
+        version = sqlite3_column_int(store.data_version, 0);
+    sqlite3_reset(store.data_version);
+    return version;
+}
+
+int tool_store_changed(const char *filename)
+{
+    if (!store.db || store.name != filename)
+        return 1;
+    return data_version() != store.version;
+}
+
+static bool same_row(const tool_row &a, const tool_row &b)
+{
+    return a.tool.pocketno == b.tool.pocketno
+        && a.tool.diameter == b.tool.diameter
+        && a.tool.backangle == b.tool.backangle
+        && a.tool.frontangle == b.tool.frontangle
+        && a.tool.orientation == b.tool.orientation
+        && a.tool.offset.tran.x == b.tool.offset.tran.x
+        && a.tool.offset.tran.y == b.tool.offset.tran.y
+        && a.tool.offset.tran.z == b.tool.offset.tran.z
+        && a.tool.offset.a == b.tool.offset.a
+        && a.tool.offset.b == b.tool.offset.b
+        && a.tool.offset.c == b.tool.offset.c
+        && a.tool.offset.u == b.tool.offset.u
+        && a.tool.offset.v == b.tool.offset.v
+        && a.tool.offset.w == b.tool.offset.w
+        && a.comment == b.comment;
+}
+
+static int write_row(int toolno, const tool_row &row)
+{
+    sqlite3_stmt *s = store.upsert_tool;
+    const CANON_TOOL_TABLE &t = row.tool;
+
+    sqlite3_bind_int(s, 1, toolno);
+    sqlite3_bind_int(s, 2, t.pocketno);
+    sqlite3_bind_double(s, 3, t.diameter);
+    sqlite3_bind_double(s, 4, t.backangle);
+    sqlite3_bind_double(s, 5, t.frontangle);
+    sqlite3_bind_int(s, 6, t.orientation);
+    sqlite3_bind_text(s, 7, row.comment.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(s, 8, t.offset.tran.x);
+    sqlite3_bind_double(s, 9, t.offset.tran.y);
+    sqlite3_bind_double(s, 10, t.offset.tran.z);
+    sqlite3_bind_double(s, 11, t.offset.a);
+    sqlite3_bind_double(s, 12, t.offset.b);
+    sqlite3_bind_double(s, 13, t.offset.c);
+    sqlite3_bind_double(s, 14, t.offset.u);
+    sqlite3_bind_double(s, 15, t.offset.v);
+    sqlite3_bind_double(s, 16, t.offset.w);
+    return store_step(s, "write tool");
+}
+
+int tool_store_load(const char *filename,
+	CANON_TOOL_TABLE toolTable[],
+	char *ttcomments[],
+	int random_toolchanger)
+{
+    sqlite3_stmt *s;
+    int fakepocket = 0, rc;
+    int t;
+
+    if (store_open(filename))
+        return -1;
+
+    // clear out tool table
+    for (t = random_toolchanger? 0: 1; t < CANON_POCKETS_MAX; t++) {
+        toolTable[t].toolno = -1;
+        toolTable[t].pocketno = -1;
+        ZERO_EMC_POSE(toolTable[t].offset);
+        toolTable[t].diameter = 0.0;
+        toolTable[t].frontangle = 0.0;
+        toolTable[t].backangle = 0.0;
+        toolTable[t].orientation = 0;
+        if(ttcomments) ttcomments[t][0] = '\0';
+    }
+    tool_table_clear_extra();
+    store.rows.clear();
+
+    s = store.select_tools;
+    while ((rc = sqlite3_step(s)) == SQLITE_ROW) {
+        int toolno = sqlite3_column_int(s, 0);
+        const unsigned char *comment = sqlite3_column_text(s, 6);
+        tool_row &row = store.rows[toolno];
+        int pocket;
+
+        row.tool.toolno = toolno;
+        row.tool.pocketno = sqlite3_column_int(s, 1);
+        row.tool.diameter = sqlite3_column_double(s, 2);
+        row.tool.backangle = sqlite3_column_double(s, 3);
+        row.tool.frontangle = sqlite3_column_double(s, 4);
+        row.tool.orientation = sqlite3_column_int(s, 5);
+        row.comment = comment ? (const char *)comment : "";
+        row.tool.offset.tran.x = sqlite3_column_double(s, 7);
+        row.tool.offset.tran.y = sqlite3_column_double(s, 8);
+        row.tool.offset.tran.z = sqlite3_column_double(s, 9);
+        row.tool.offset.a = sqlite3_column_double(s, 10);
+        row.tool.offset.b = sqlite3_column_double(s, 11);
+        row.tool.offset.c = sqlite3_column_double(s, 12);
+        row.tool.offset.u = sqlite3_column_double(s, 13);
+        row.tool.offset.v = sqlite3_column_double(s, 14);
+        row.tool.offset.w = sqlite3_column_double(s, 15);
+        row.loaded = false;
+
+        // for nonrandom machines, just read the tools into pockets 1..n
+        // in tool number order; the spindle pocket 0 is left alone
+        if (random_toolchanger) {
+            pocket = row.tool.pocketno;
+            if (pocket < 0) {
+                printf("pocket number %d is negative. skipping tool %d\n", pocket, toolno);
+                continue;
+            }
+            int other = tool_table_get(toolTable, pocket).toolno;
+            if (other != -1) {
+                printf("pocket %d holds tool %d and %d. skipping tool %d\n",
+                       pocket, other, toolno, other);
+                store.rows[other].loaded = false;
+            }
+        } else {
+            pocket = ++fakepocket;
+        }
+
+        tool_table_put(toolTable, pocket, row.tool);
+        tool_table_set_comment(ttcomments, pocket, row.comment.c_str());
+        row.loaded = true;
+
+        if (!random_toolchanger && toolTable[0].toolno == toolno) {
+            toolTable[0] = row.tool;
+        }
+    }
+    sqlite3_reset(s);
+    if (rc != SQLITE_DONE) {
+        store.rows.clear();
+        return store_error("read tools");
+    }
+    store.version = data_version();
+    return 0;
+}
+
+int tool_store_save(const char *filename,
+	CANON_TOOL_TABLE toolTable[],
+	char *ttcomments[],
+	int random_toolchanger)
+{
+    std::map<int, tool_row> now;
+    std::map<int, tool_row>::iterator it;
+    int pocket;
+    int failed = 0;
+
+    if (store_open(filename))
+        return -1;
+
+    for (pocket = random_toolchanger? 0: 1; pocket >= 0;
+         pocket = pocket + 1 < CANON_POCKETS_MAX ? pocket + 1 : tool_table_next(pocket)) {
+        CANON_TOOL_TABLE tool = tool_table_get(toolTable, pocket);
+        if (tool.toolno == -1)
+            continue;
+        tool_row &row = now[tool.toolno];
+        row.tool = tool;
+        if (random_toolchanger)
+            row.tool.pocketno = pocket;
+        if (ttcomments || pocket >= CANON_POCKETS_MAX) {
+            row.comment = tool_table_comment(ttcomments, pocket);
+        } else if ((it = store.rows.find(row.tool.toolno)) != store.rows.end()) {
+            row.comment = it->second.comment;
+        }
+        row.loaded = true;
+    }
+
+    if (store_exec("BEGIN"))
+        return -1;
+    for (it = now.begin(); !failed && it != now.end(); ++it) {
+        std::map<int, tool_row>::iterator old = store.rows.find(it->first);
+        if (old == store.rows.end() || !same_row(old->second, it->second))
+            failed = write_row(it->first, it->second);
+    }
+    for (it = store.rows.begin(); !failed && it != store.rows.end(); ++it) {
+        if (!it->second.loaded || now.count(it->first))
+            continue;
+        sqlite3_bind_int(store.delete_tool, 1, it->first);
+        failed = store_step(store.delete_tool, "delete tool");
+    }
+    if (failed || store_exec("COMMIT")) {
+        store_exec("ROLLBACK");
+        return -1;
+    }
+
+    // remember what is in the database now; rows that were never loaded
+    // into the tool table were not touched
+    for (it = store.rows.begin(); it != store.rows.end(); ) {
+        if (it->second.loaded)
+            store.rows.erase(it++);
+        else
+            ++it;
+    }
+    for (it = now.begin(); it != now.end(); ++it)
+        store.rows[it->first] = it->second;
+    store.version = data_version();
+    return 0;
+}
+
+#else
+
+int tool_store_changed(const char *filename)
+{
+    return 0;
+}
+
+int tool_store_load(const char *filename,
+	CANON_TOOL_TABLE toolTable[],
+	char *ttcomments[],
+	int random_toolchanger)
+{
+    fprintf(stderr, "%s: built without SQLite, tool databases are not supported\n", filename);
+    return -1;
+}
+
+int tool_store_save(const char *filename,
+	CANON_TOOL_TABLE toolTable[],
+	char *ttcomments[],
+	int random_toolchanger)
+{
+    fprintf(stderr, "%s: built without SQLite, tool databases are not supported\n", filename);
+    return -1;
+}
+
+#endif
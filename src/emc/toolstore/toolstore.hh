@@ -0,0 +1,164 @@
+/*    This is a component of LinuxCNC
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef TOOLSTORE_HH
+#define TOOLSTORE_HH
+
+#include <map>
+#include "emctool.h"
+
+/* Tool table.
+ *
+ * The tool table a machine runs from starts with an array of
+ * CANON_POCKETS_MAX entries, the one in the NML status that GUIs show,
+ * and goes on for as many entries as the tool table file or database
+ * holds.  loadToolTable() fills the array and keeps the entries past it
+ * here; saveToolTable() writes both parts back.  For a nonrandom
+ * toolchanger the entries past the array are the tools after the first
+ * CANON_POCKETS_MAX - 1 in file order, for a random one the pockets
+ * numbered CANON_POCKETS_MAX and up.
+ *
+ * tool_table_get() and tool_table_put() reach an entry in either part,
+ * and tool_table_size() is one past the highest index in use.  A process
+ * that only reads the table another one keeps (task, reading what
+ * iocontrol changes) calls tool_table_refresh() to reload the entries
+ * past the array when the file or database has changed.
+ */
+
+int tool_table_size(void);
+
+CANON_TOOL_TABLE tool_table_get(const CANON_TOOL_TABLE table[], int index);
+
+void tool_table_put(CANON_TOOL_TABLE table[], int index,
+	const CANON_TOOL_TABLE &tool);
+
+const char *tool_table_comment(char *const ttcomments[], int index);
+
+void tool_table_set_comment(char *ttcomments[], int index,
+	const char *comment);
+
+void tool_table_swap(CANON_TOOL_TABLE table[], char *ttcomments[],
+	int a, int b);
+
+/* the next index past the array holding a tool after index, or -1 */
+int tool_table_next(int index);
+
+/* empties the part past the array; the loaders call it */
+void tool_table_clear_extra(void);
+
+int tool_table_refresh(const char *filename, int random_toolchanger);
+
+/* SQLite tool store.
+ *
+ * A TOOL_TABLE whose name ends in .db, .sqlite or .sqlite3 is kept in an
+ * SQLite database with the layout of toolstore/sql/schema-simple.sql
+ * instead of a text file.  loadToolTable() and saveToolTable() hand such
+ * names to the functions below, so callers do not need to know which
+ * kind of table they have.
+ *
+ * The store keeps a copy of every row as last read or written.  A save
+ * compares the table against it and only updates, inserts or deletes the
+ * rows that changed, in one transaction, so setting one tool's offset
+ * costs one row no matter how many tools there are.
+ *
+ * The database can hold any number of tools and any pocket numbers; all
+ * of them are loaded, ordered by tool number.
+ */
+
+int tool_store_is_db(const char *filename);
+
+int tool_store_load(const char *filename,
+	CANON_TOOL_TABLE toolTable[],
+	char *ttcomments[],
+	int random_toolchanger);
+
+int tool_store_save(const char *filename,
+	CANON_TOOL_TABLE toolTable[],
+	char *ttcomments[],
+	int random_toolchanger);
+
+/* true when another process committed to the database since it was
+   last loaded or saved here */
+int tool_store_changed(const char *filename);
+
+/* Remembers where each tool number sits in a tool table, so looking a
+ * tool up does not scan every entry each time.  An entry is checked
+ * against the table before it is used and the table is scanned again
+ * when it does not match; call clear() after changing the table, since
+ * a change can also move the first or last place of a tool that still
+ * matches.
+ */
+class ToolIndexCache {
+public:
+    /* the highest index holding toolno, or -1 */
+    int find_last(const CANON_TOOL_TABLE table[], int toolno) {
+	const where *w = lookup(table, toolno);
+	return w ? w->last : -1;
+    }
+
+    /* the lowest index from 1 up holding toolno, or -1 */
+    int find_first(const CANON_TOOL_TABLE table[], int toolno) {
+	const where *w = lookup(table, toolno);
+	return w ? w->first : -1;
+    }
+
+    void clear() { index.clear(); }
+
+private:
+    struct where {
+	int first, last;	// first is -1 if toolno is only in 0
+    };
+
+    bool holds(const CANON_TOOL_TABLE table[], int i, int toolno) {
+	return i < 0 || tool_table_get(table, i).toolno == toolno;
+    }
+
+    const where *lookup(const CANON_TOOL_TABLE table[], int toolno) {
+	std::map<int, where>::const_iterator it = index.find(toolno);
+	if (it == index.end() || !holds(table, it->second.first, toolno)
+	    || !holds(table, it->second.last, toolno)) {
+	    rebuild(table);
+	    it = index.find(toolno);
+	}
+	return it == index.end() ? NULL : &it->second;
+    }
+
+    void record(int toolno, int i) {
+	std::map<int, where>::iterator it = index.find(toolno);
+	if (it == index.end()) {
+	    where w = { i > 0 ? i : -1, i };
+	    index[toolno] = w;
+	    return;
+	}
+	if (it->second.first < 0 && i > 0)
+	    it->second.first = i;
+	it->second.last = i;
+    }
+
+    void rebuild(const CANON_TOOL_TABLE table[]) {
+	index.clear();
+	for (int i = 0; i < CANON_POCKETS_MAX; i++) {
+	    if (table[i].toolno != -1)
+		record(table[i].toolno, i);
+	}
+	for (int i = CANON_POCKETS_MAX - 1; (i = tool_table_next(i)) >= 0; )
+	    record(tool_table_get(table, i).toolno, i);
+    }
+
+    std::map<int, where> index;
+};
+
+#endif
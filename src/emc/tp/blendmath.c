@@ -1637,13 +1637,16 @@ double pmCartAbsMax(PmCartesian const * const v)
 }
 
 
-PmCircleLimits pmCircleActualMaxVel(PmCircle const * circle,
+/**
+ * Velocity limit and tangential acceleration ratio on a path whose
+ * tightest bend has radius eff_radius.
+ */
+static PmCircleLimits pmBendActualMaxVel(double eff_radius,
         double v_max,
         double a_max)
 {
     double a_n_max_cutoff = BLEND_ACC_RATIO_NORMAL * a_max;
 
-    double eff_radius = pmCircleEffectiveMinRadius(circle);
     // Find the acceleration necessary to reach the maximum velocity
     double a_n_vmax = pmSq(v_max) / fmax(eff_radius, DOUBLE_FUZZ);
     // Find the maximum velocity that still obeys our desired tangential / total acceleration ratio
@@ -1658,7 +1661,7 @@ PmCircleLimits pmCircleActualMaxVel(PmCircle const * circle,
         acc_ratio_tan = pmSqrt(1.0 - pmSq(a_n_vmax / a_max));
     }
 
-    tp_debug_json_start(pmCircleActualMaxVel);
+    tp_debug_json_start(pmBendActualMaxVel);
     tp_debug_json_double(eff_radius);
     tp_debug_json_double(v_max);
     tp_debug_json_double(v_max_cutoff);
@@ -1676,6 +1679,27 @@ PmCircleLimits pmCircleActualMaxVel(PmCircle const * circle,
 }
 
 
+PmCircleLimits pmCircleActualMaxVel(PmCircle const * circle,
+        double v_max,
+        double a_max)
+{
+    return pmBendActualMaxVel(pmCircleEffectiveMinRadius(circle),
+            v_max, a_max);
+}
+
+
+PmCircleLimits pmSplineActualMaxVel(PmSpline const * spline,
+        double v_max,
+        double a_max)
+{
+    if (spline->max_curvature <= 0.0) {
+        PmCircleLimits limits = { v_max, 1.0 };
+        return limits;
+    }
+    return pmBendActualMaxVel(1.0 / spline->max_curvature, v_max, a_max);
+}
+
+
 /** @section spiralfuncs Functions to approximate spiral arc length */
 
 /**
@@ -1793,6 +1817,13 @@ int findSpiralArcLengthFit(PmCircle const * const circle,
     fit->total_planar_length = fit->b0 * pmSq(circle->angle) + fit->b1 * circle->angle;
     printSpiralArcLengthFit(fit);
 
+    double h2;
+    pmCartMagSq(&circle->rHelix, &h2);
+    fit->total_length = pmSqrt(pmSq(fit->total_planar_length) + h2);
+    fit->inv_b1 = 1.0 / fit->b1;
+    fit->inv_angle = 1.0 / circle->angle;
+    fit->spiral_rate = circle->spiral * fit->inv_angle / circle->radius;
+
     // Check against start and end angle
     double angle_end_chk = 0.0;
     int res_angle = pmCircleAngleFromParam(circle, fit, 1.0, &angle_end_chk);
@@ -1835,6 +1866,78 @@ int pmCircleAngleFromProgress(PmCircle const * const circle,
 }
 
 
+/**
+ * Find the point at a given progress along a circular segment, for use
+ * once per servo cycle.
+ *
+ * Gives the same result as pmCircleAngleFromProgress() followed by
+ * pmCirclePoint(), but uses the constants stored in the fit by
+ * findSpiralArcLengthFit() instead of recomputing lengths, and skips the
+ * quadratic for plain circles and helices. The cos and sin of the angle
+ * are carried in the cursor: when the angle has moved less than
+ * TP_CIRCLE_STEP_MAX since the last call, they are rotated forward by a
+ * short Taylor series and renormalized, so the common case needs no trig
+ * or square roots at all. They are recomputed exactly on large jumps and
+ * every TP_CIRCLE_RESYNC_STEPS calls so rounding can't build up.
+ */
+int pmCircleFastPoint(PmCircle const * const circle,
+        SpiralArcLengthFit const * const fit,
+        PmCircleCursor * const cursor,
+        double progress,
+        PmCartesian * const point)
+{
+    double angle;
+    double t = progress / fit->total_length;
+    if (fit->b0 != 0.0) {
+        int res = pmCircleAngleFromParam(circle, fit, t, &angle);
+        if (res != TP_ERR_OK) {
+            return res;
+        }
+    } else if (fit->spiral_in) {
+        angle = circle->angle - (1.0 - t) * fit->total_planar_length * fit->inv_b1;
+    } else {
+        angle = t * fit->total_planar_length * fit->inv_b1;
+    }
+
+    double c, s;
+    double d = angle - cursor->angle;
+    if (!cursor->valid || fabs(d) > TP_CIRCLE_STEP_MAX ||
+            cursor->steps >= TP_CIRCLE_RESYNC_STEPS) {
+        c = cos(angle);
+        s = sin(angle);
+        cursor->steps = 0;
+        cursor->valid = 1;
+    } else {
+        // Error of the truncated series is below 1e-16 for |d| <= 0.05
+        double d2 = d * d;
+        double cd = 1.0 - d2 * (0.5 - d2 * (1.0 / 24.0 - d2 / 720.0));
+        double sd = d * (1.0 - d2 * (1.0 / 6.0 - d2 * (1.0 / 120.0 - d2 / 5040.0)));
+        c = cursor->cos_angle * cd - cursor->sin_angle * sd;
+        s = cursor->sin_angle * cd + cursor->cos_angle * sd;
+        // One Newton step back onto the unit circle
+        double k = 1.5 - 0.5 * (c * c + s * s);
+        c *= k;
+        s *= k;
+        cursor->steps++;
+    }
+    cursor->angle = angle;
+    cursor->cos_angle = c;
+    cursor->sin_angle = s;
+
+    // rTan and rPerp are orthogonal with length radius, so the spiral
+    // term is a scale on the radius vector rather than a unit vector
+    double scale = angle * fit->inv_angle;
+    double radial = 1.0 + angle * fit->spiral_rate;
+    point->x = circle->center.x + (circle->rTan.x * c + circle->rPerp.x * s) * radial
+        + circle->rHelix.x * scale;
+    point->y = circle->center.y + (circle->rTan.y * c + circle->rPerp.y * s) * radial
+        + circle->rHelix.y * scale;
+    point->z = circle->center.z + (circle->rTan.z * c + circle->rPerp.z * s) * radial
+        + circle->rHelix.z * scale;
+    return TP_ERR_OK;
+}
+
+
 /**
  * Find the effective minimum radius for acceleration calculations.
  * The radius of curvature of a spiral is larger than the circle of the same
@@ -251,12 +251,21 @@ PmCircleLimits pmCircleActualMaxVel(const PmCircle *circle,
         double v_max_nominal,
         double a_max_nominal);
 
+PmCircleLimits pmSplineActualMaxVel(PmSpline const * spline,
+        double v_max_nominal,
+        double a_max_nominal);
+
 int findSpiralArcLengthFit(PmCircle const * const circle,
         SpiralArcLengthFit * const fit);
 int pmCircleAngleFromProgress(PmCircle const * const circle,
         SpiralArcLengthFit const * const fit,
         double progress,
         double * const angle);
+int pmCircleFastPoint(PmCircle const * const circle,
+        SpiralArcLengthFit const * const fit,
+        PmCircleCursor * const cursor,
+        double progress,
+        PmCartesian * const point);
 double pmCircleEffectiveMinRadius(const PmCircle *circle);
 
 static inline double findVPeak(double a_t_max, double distance)
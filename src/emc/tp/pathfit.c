@@ -0,0 +1,673 @@
+/********************************************************************
+ * Description: pathfit.c
+ *
+ * Joining of runs of short line segments into longer lines and arcs.
+ *
+ * License: GPL Version 2
+ * System: Linux
+ *
+ ********************************************************************/
+
+#include "posemath.h"
+#include "pathfit.h"
+#include "rtapi_math.h"
+
+int pathFitLine(PmCartesian const * const pts, int n, double tol)
+{
+    PmCartesian M;
+    double len_sq;
+    int i;
+
+    if (n < 2) {
+        return -1;
+    }
+    pmCartCartSub(&pts[n - 1], &pts[0], &M);
+    pmCartMagSq(&M, &len_sq);
+    if (len_sq == 0.0) {
+        return -1;
+    }
+
+    // Distance from each point to the nearest point on the segment
+    for (i = 1; i < n - 1; i++) {
+        PmCartesian d, nearest;
+        double t, dist;
+
+        pmCartCartSub(&pts[i], &pts[0], &d);
+        pmCartCartDot(&M, &d, &t);
+        t /= len_sq;
+        if (t < 0.0) t = 0.0;
+        if (t > 1.0) t = 1.0;
+        pmCartScalMult(&M, t, &nearest);
+        pmCartCartSubEq(&d, &nearest);
+        pmCartMag(&d, &dist);
+        if (dist > tol) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Circle through the first, the middle and the last point */
+static int arcThroughPoints(PmCartesian const * const pts, int n,
+        PathFitArc * const fit)
+{
+    PmCartesian u, v, w, vw, wu;
+    double u_sq, v_sq, w_sq, w_mag;
+
+    pmCartCartSub(&pts[n / 2], &pts[0], &u);
+    pmCartCartSub(&pts[n - 1], &pts[0], &v);
+    pmCartCartCross(&u, &v, &w);
+    pmCartMagSq(&u, &u_sq);
+    pmCartMagSq(&v, &v_sq);
+    pmCartMagSq(&w, &w_sq);
+    w_mag = sqrt(w_sq);
+    if (w_mag <= 1e-9 * sqrt(u_sq * v_sq)) {
+        return -1;
+    }
+
+    pmCartCartCross(&v, &w, &vw);
+    pmCartCartCross(&w, &u, &wu);
+    pmCartScalMultEq(&vw, u_sq);
+    pmCartScalMultEq(&wu, v_sq);
+    pmCartCartAdd(&vw, &wu, &fit->center);
+    pmCartScalMultEq(&fit->center, 0.5 / w_sq);
+    pmCartCartAddEq(&fit->center, &pts[0]);
+    pmCartScalMult(&w, 1.0 / w_mag, &fit->normal);
+    return 0;
+}
+
+/* Circle leaving the first point along tangent and through the last */
+static int arcFromTangent(PmCartesian const * const pts, int n,
+        PmCartesian const * const tangent, PathFitArc * const fit)
+{
+    PmCartesian d, w, toward;
+    double d_sq, d_mag, w_mag, along;
+
+    pmCartCartSub(&pts[n - 1], &pts[0], &d);
+    pmCartCartCross(tangent, &d, &w);
+    pmCartMagSq(&d, &d_sq);
+    d_mag = sqrt(d_sq);
+    pmCartMag(&w, &w_mag);
+    if (w_mag <= 1e-9 * d_mag) {
+        return -1;
+    }
+    pmCartScalMult(&w, 1.0 / w_mag, &fit->normal);
+
+    // The centre is square to the tangent, on the side the path turns to
+    pmCartCartCross(&fit->normal, tangent, &toward);
+    pmCartUnitEq(&toward);
+    pmCartCartDot(&d, &toward, &along);
+    if (along <= 0.0) {
+        return -1;
+    }
+    pmCartScalMult(&toward, d_sq / (2.0 * along), &fit->center);
+    pmCartCartAddEq(&fit->center, &pts[0]);
+    return 0;
+}
+
+int pathFitArc(PmCartesian const * const pts, int n,
+        PmCartesian const * const start_tangent, double tol,
+        PathFitArc * const arc)
+{
+    PathFitArc fit;
+    PmCartesian e1, e2, end_rel;
+    double last_theta = 0.0, last_err = 0.0;
+    int i;
+
+    if (n < 3) {
+        return -1;
+    }
+    if (start_tangent) {
+        if (arcFromTangent(pts, n, start_tangent, &fit)) {
+            return -1;
+        }
+    } else if (arcThroughPoints(pts, n, &fit)) {
+        return -1;
+    }
+
+    pmCartCartSub(&pts[0], &fit.center, &e1);
+    pmCartMag(&e1, &fit.radius);
+    if (fit.radius < PATHFIT_MIN_RADIUS) {
+        return -1;
+    }
+    pmCartScalMultEq(&e1, 1.0 / fit.radius);
+    pmCartCartCross(&fit.normal, &e1, &e2);
+
+    fit.angle = 0.0;
+    for (i = 1; i < n; i++) {
+        PmCartesian d;
+        double h, x, y, err, theta, step;
+
+        pmCartCartSub(&pts[i], &fit.center, &d);
+        pmCartCartDot(&d, &fit.normal, &h);
+        pmCartCartDot(&d, &e1, &x);
+        pmCartCartDot(&d, &e2, &y);
+        err = hypot(h, hypot(x, y) - fit.radius);
+        if (err > tol) {
+            return -1;
+        }
+
+        theta = atan2(y, x);
+        step = theta - last_theta;
+        if (step <= -PM_PI) step += PM_2_PI;
+        if (step > PM_PI) step -= PM_2_PI;
+        last_theta = theta;
+
+        // Each segment must go forward, and the arc between its ends must
+        // stay within tol of it even where the ends are off the circle
+        if (step < 0.0 || fit.radius * (1.0 - cos(step / 2.0))
+                + fmax(err, last_err) > tol) {
+            return -1;
+        }
+        last_err = err;
+        fit.angle += step;
+        if (fit.angle > PATHFIT_MAX_ANGLE) {
+            return -1;
+        }
+    }
+
+    pmCartCartSub(&pts[n - 1], &fit.center, &end_rel);
+    pmCartCartCross(&fit.normal, &end_rel, &fit.end_tangent);
+    if (pmCartUnitEq(&fit.end_tangent)) {
+        return -1;
+    }
+    *arc = fit;
+    return 0;
+}
+
+/* Share of tol a fitted arc leaves for points to stray from its plane;
+ * the rest is for straying from the circle within the plane */
+#define PLANE_SHARE 0.25
+/* Smallest radius of an arc fitted to a run, in multiples of tol.  With
+ * it, and each segment spanning at most 60 degrees of the arc, the
+ * length of the run tells how far around the arc it goes. */
+#define MIN_RADIUS_TOLS 10.0
+/* Largest component along the normal of an arc that a move leaving it
+ * may have and still lie in its plane */
+#define PLANE_EPSILON 1e-6
+
+static double wrapAngle(double angle)
+{
+    if (angle <= -PM_PI) angle += PM_2_PI;
+    if (angle > PM_PI) angle -= PM_2_PI;
+    return angle;
+}
+
+/* Narrow the line bounds to the directions that also pass within tol of
+ * q, keeping them a cone inside both; returns -1 if none are left */
+static int lineBoundsAdd(PathFitLineBounds * const bounds,
+        PmCartesian const * const start, PmCartesian const * const q,
+        double tol)
+{
+    PmCartesian d, cross, w;
+    double r, beta, alpha = bounds->angle, gamma, c, s, turn;
+
+    pmCartCartSub(q, start, &d);
+    pmCartMag(&d, &r);
+    if (r <= tol) {
+        // Any line from start passes within tol of q
+        return 0;
+    }
+    pmCartScalMultEq(&d, 1.0 / r);
+    beta = asin(tol / r);
+    bounds->reach = fmax(bounds->reach, r);
+    if (alpha < 0.0) {
+        bounds->axis = d;
+        bounds->angle = beta;
+        return 0;
+    }
+
+    pmCartCartCross(&bounds->axis, &d, &cross);
+    pmCartMag(&cross, &s);
+    pmCartCartDot(&bounds->axis, &d, &c);
+    gamma = atan2(s, c);
+    if (gamma > alpha + beta) {
+        return -1;
+    }
+    if (gamma + beta <= alpha) {
+        bounds->axis = d;
+        bounds->angle = beta;
+        return 0;
+    }
+    if (gamma + alpha <= beta) {
+        return 0;
+    }
+    // The cones overlap along the great circle through both axes; take
+    // the cone about the middle of the overlap
+    pmCartScalMult(&bounds->axis, c, &w);
+    pmCartCartSub(&d, &w, &w);
+    pmCartScalMultEq(&w, 1.0 / s);
+    turn = (alpha + gamma - beta) / 2.0;
+    pmCartScalMultEq(&bounds->axis, cos(turn));
+    pmCartScalMultEq(&w, sin(turn));
+    pmCartCartAddEq(&bounds->axis, &w);
+    pmCartUnitEq(&bounds->axis);
+    bounds->angle = (alpha + beta - gamma) / 2.0;
+    return 0;
+}
+
+/* 0 if the line from start to e passes within tol of every point so far */
+static int lineBoundsFit(PathFitLineBounds const * const bounds,
+        PmCartesian const * const start, PmCartesian const * const e)
+{
+    PmCartesian d;
+    double len, c;
+
+    pmCartCartSub(e, start, &d);
+    pmCartMag(&d, &len);
+    if (bounds->dead || len == 0.0 || len < bounds->reach) {
+        return -1;
+    }
+    if (bounds->angle < 0.0) {
+        return 0;
+    }
+    pmCartCartDot(&d, &bounds->axis, &c);
+    return acos(fmax(-1.0, fmin(1.0, c / len))) <= bounds->angle ? 0 : -1;
+}
+
+static void arcBoundsStart(PathFitArcBounds * const bounds,
+        PmCartesian const * const tangent, double tol)
+{
+    bounds->t = *tangent;
+    PmCartesian ref = {1.0, 0.0, 0.0};
+    double along;
+
+    // Any two axes square to the tangent
+    if (fabs(tangent->x) > 0.6) {
+        ref.x = 0.0;
+        ref.y = 1.0;
+    }
+    pmCartCartDot(&ref, tangent, &along);
+    pmCartScalMult(tangent, along, &bounds->p);
+    pmCartCartSub(&ref, &bounds->p, &bounds->p);
+    pmCartUnitEq(&bounds->p);
+    pmCartCartCross(tangent, &bounds->p, &bounds->s);
+
+    bounds->psi_any = 1;
+    bounds->psi_ref = bounds->psi_lo = bounds->psi_hi = 0.0;
+    bounds->k_lo = 0.0;
+    bounds->k_hi = 1.0 / (MIN_RADIUS_TOLS * tol);
+    bounds->a = bounds->b = 0.0;
+    bounds->dead = 0;
+}
+
+/* Where q lies from start: a along the tangent, and m off it at angle
+ * psi about it */
+static void arcLocal(PathFitArcBounds const * const bounds,
+        PmCartesian const * const start, PmCartesian const * const q,
+        double * const a, double * const m, double * const psi)
+{
+    PmCartesian v;
+    double x, y;
+
+    pmCartCartSub(q, start, &v);
+    pmCartCartDot(&v, &bounds->t, a);
+    pmCartCartDot(&v, &bounds->p, &x);
+    pmCartCartDot(&v, &bounds->s, &y);
+    *m = hypot(x, y);
+    *psi = atan2(y, x);
+}
+
+/* Bound the curvature so the arc goes forward from the last point to
+ * (a, b) and spans at most 60 degrees between them */
+static int arcBoundsStep(PathFitArcBounds * const bounds, double a,
+        double b)
+{
+    double x = bounds->a * b - bounds->b * a, y = a - bounds->a;
+    double len = hypot(y, b - bounds->b);
+
+    if (len == 0.0) {
+        return 0;
+    }
+    if (x > 0.0) {
+        bounds->k_lo = fmax(bounds->k_lo, -y / x);
+    } else if (x < 0.0) {
+        bounds->k_hi = fmin(bounds->k_hi, y / -x);
+    } else if (y <= 0.0) {
+        return -1;
+    }
+    bounds->k_hi = fmin(bounds->k_hi, 1.0 / len);
+    return bounds->k_lo <= bounds->k_hi ? 0 : -1;
+}
+
+/* Narrow the arc bounds to the arcs that also pass within tol of q and
+ * of the segments either side of it, span is the longer of those; returns
+ * -1 if none are left */
+static int arcBoundsAdd(PathFitArcBounds * const bounds,
+        PmCartesian const * const start, PmCartesian const * const q,
+        double span, double tol)
+{
+    double tol_h = PLANE_SHARE * tol;
+    double tol_in = tol * sqrt(1.0 - PLANE_SHARE * PLANE_SHARE);
+    double a, m, psi, b, db, tau, bulge, r_sq, lower;
+
+    arcLocal(bounds, start, q, &a, &m, &psi);
+
+    // q must be within tol_h of the plane of the arc
+    if (m > tol_h) {
+        double half = asin(tol_h / m), root = sqrt(m * m - tol_h * tol_h);
+
+        if (bounds->psi_any) {
+            bounds->psi_any = 0;
+            bounds->psi_ref = psi;
+            bounds->psi_lo = -half;
+            bounds->psi_hi = half;
+        } else {
+            double c = wrapAngle(psi - bounds->psi_ref);
+
+            bounds->psi_lo = fmax(bounds->psi_lo, c - half);
+            bounds->psi_hi = fmin(bounds->psi_hi, c + half);
+            if (bounds->psi_lo > bounds->psi_hi) {
+                return -1;
+            }
+        }
+        // Seen in the plane, q is off the tangent by between root and m
+        b = (m + root) / 2.0;
+        db = (m - root) / 2.0;
+    } else {
+        b = 0.0;
+        db = m;
+    }
+
+    // and within tau - bulge * k of the circle, which passes through
+    // start with its centre at 1 / k toward b, so that the arc also
+    // stays within tol of the segments, which it bulges out from by about
+    // k span^2 / 8.  Dropping the tau^2 terms of
+    // (1/k - tau)^2 <= a^2 + (b - 1/k)^2 <= (1/k + tau)^2 leaves bounds
+    // on k that only ever narrow.
+    tau = tol_in - db;
+    bulge = 1.1 * span * span / 8.0;
+    r_sq = a * a + b * b;
+    bounds->k_hi = fmin(bounds->k_hi, tau / bulge);
+    bounds->k_hi = fmin(bounds->k_hi, 2.0 * (b + tau) / (r_sq + 2.0 * bulge));
+    lower = r_sq - tau * tau - 2.0 * bulge;
+    if (lower > 0.0) {
+        bounds->k_lo = fmax(bounds->k_lo, 2.0 * (b - tau) / lower);
+    } else if (lower < 0.0) {
+        bounds->k_hi = fmin(bounds->k_hi, 2.0 * (b - tau) / lower);
+    } else if (b > tau) {
+        return -1;
+    }
+    if (arcBoundsStep(bounds, a, b)) {
+        return -1;
+    }
+    bounds->a = a;
+    bounds->b = b;
+    return 0;
+}
+
+/* Fit the arc from start to e that the bounds allow; length is along the
+ * segments from start to e */
+static int arcBoundsFit(PathFitArcBounds const * const bounds,
+        PmCartesian const * const start, PmCartesian const * const e,
+        double length, PathFitArc * const arc)
+{
+    PathFitArcBounds last = *bounds;
+    PmCartesian u, v, rel;
+    double a, m, psi, k;
+
+    if (bounds->dead) {
+        return -1;
+    }
+    arcLocal(bounds, start, e, &a, &m, &psi);
+    if (m == 0.0) {
+        return -1;
+    }
+    if (!bounds->psi_any) {
+        double c = wrapAngle(psi - bounds->psi_ref);
+
+        if (c < bounds->psi_lo || c > bounds->psi_hi) {
+            return -1;
+        }
+    }
+    k = 2.0 * m / (a * a + m * m);
+    if (arcBoundsStep(&last, a, m) || k < last.k_lo || k > last.k_hi) {
+        return -1;
+    }
+
+    arc->radius = 1.0 / k;
+    arc->angle = atan2(a, arc->radius - m);
+    if (arc->angle < 0.0) {
+        arc->angle += PM_2_PI;
+    }
+    if (arc->angle > PATHFIT_MAX_ANGLE || length * k > PATHFIT_MAX_ANGLE) {
+        return -1;
+    }
+
+    pmCartScalMult(&bounds->p, cos(psi), &u);
+    pmCartScalMult(&bounds->s, sin(psi), &v);
+    pmCartCartAddEq(&u, &v);
+    pmCartScalMult(&u, arc->radius, &arc->center);
+    pmCartCartAddEq(&arc->center, start);
+    pmCartCartCross(&bounds->t, &u, &arc->normal);
+    pmCartUnitEq(&arc->normal);
+    pmCartCartSub(e, &arc->center, &rel);
+    pmCartCartCross(&arc->normal, &rel, &arc->end_tangent);
+    return pmCartUnitEq(&arc->end_tangent) ? -1 : 0;
+}
+
+void pathFitChainStart(PathFitChain * const chain,
+        PmCartesian const * const start, PmCartesian const * const tangent,
+        int chord, double tol)
+{
+    chain->start = *start;
+    chain->end = *start;
+    chain->pts[0] = *start;
+    chain->n = 1;
+    chain->tol = tol;
+    chain->have_tangent = tangent != NULL;
+    if (tangent) {
+        chain->tangent = *tangent;
+    }
+    chain->chord = chord;
+    chain->corner = 0;
+    chain->free = 0;
+    chain->is_arc = 0;
+    chain->length = 0.0;
+    chain->line.angle = -1.0;
+    chain->line.reach = 0.0;
+    chain->line.dead = 0;
+    chain->bounds.dead = 1;
+    chain->prev_n = 0;
+}
+
+/* Stop fitting arcs freely: hold them to the tangent the fit so far has
+ * at start, and bound them by the points kept */
+static void chainFreeze(PathFitChain * const chain)
+{
+    PmCartesian const * const pts = chain->pts;
+    PmCartesian tangent;
+    int i;
+
+    chain->free = 0;
+    if (chain->is_arc) {
+        PmCartesian rel;
+
+        pmCartCartSub(&chain->start, &chain->arc.center, &rel);
+        pmCartCartCross(&chain->arc.normal, &rel, &tangent);
+    } else {
+        pmCartCartSub(&chain->end, &chain->start, &tangent);
+    }
+    if (pmCartUnitEq(&tangent)) {
+        return;
+    }
+    arcBoundsStart(&chain->bounds, &tangent, chain->tol);
+    for (i = 1; i < chain->n - 1; i++) {
+        PmCartesian d;
+        double before, after;
+
+        pmCartCartSub(&pts[i], &pts[i - 1], &d);
+        pmCartMag(&d, &before);
+        pmCartCartSub(&pts[i + 1], &pts[i], &d);
+        pmCartMag(&d, &after);
+        if (arcBoundsAdd(&chain->bounds, &chain->start, &pts[i],
+                fmax(before, after), chain->tol)) {
+            chain->bounds.dead = 1;
+            return;
+        }
+    }
+}
+
+int pathFitChainAdd(PathFitChain * const chain, PmCartesian const * const p)
+{
+    PathFitLineBounds line;
+    PathFitArcBounds bounds;
+    PathFitArc arc;
+    PmCartesian d;
+    double step;
+    int is_arc, arc_fits;
+
+    pmCartCartSub(p, &chain->end, &d);
+    pmCartMag(&d, &step);
+
+    if (chain->n < 2) {
+        if (chain->have_tangent) {
+            // The first segment is a chord of any arc tangent to the move
+            // before; if that arc strays from it by more than tol the path
+            // turns a corner here
+            double c, half;
+
+            pmCartCartDot(&d, &chain->tangent, &c);
+            half = step > 0.0 ? acos(fmax(-1.0, fmin(1.0, c / step))) / 2.0 : 0.0;
+            if (half >= PM_PI / 4.0 || step / 2.0 * tan(half) > chain->tol) {
+                chain->corner = !chain->lines_only;
+                chain->have_tangent = 0;
+            } else if (chain->chord) {
+                chain->have_tangent = 0;
+            }
+        }
+        if (!chain->lines_only) {
+            if (chain->have_tangent) {
+                arcBoundsStart(&chain->bounds, &chain->tangent, chain->tol);
+            } else {
+                chain->free = 1;
+            }
+        }
+        chain->pts[1] = *p;
+        chain->prev_n = chain->n;
+        chain->prev_end = chain->end;
+        chain->prev_is_arc = 0;
+        chain->end = *p;
+        chain->length = step;
+        chain->last_step = step;
+        chain->n = 2;
+        return 0;
+    }
+    if (p->x == chain->start.x && p->y == chain->start.y
+            && p->z == chain->start.z) {
+        return -1;
+    }
+
+    // A run with no tangent to start along fits arcs freely through the
+    // points it keeps, until it has no room for more
+    if (chain->free && chain->n == PATHFIT_FREE_POINTS) {
+        chainFreeze(chain);
+    }
+
+    // The end so far becomes a point in the middle of the run
+    line = chain->line;
+    bounds = chain->bounds;
+    if (!line.dead && lineBoundsAdd(&line, &chain->start, &chain->end,
+            chain->tol)) {
+        line.dead = 1;
+    }
+    if (!bounds.dead && arcBoundsAdd(&bounds, &chain->start, &chain->end,
+            fmax(chain->last_step, step), chain->tol)) {
+        bounds.dead = 1;
+    }
+
+    // Try a line first, and an arc if the points curve
+    if (chain->free) {
+        chain->pts[chain->n] = *p;
+    }
+    if (!lineBoundsFit(&line, &chain->start, p)) {
+        is_arc = 0;
+    } else {
+        if (chain->free) {
+            arc_fits = !pathFitArc(chain->pts, chain->n + 1, NULL,
+                chain->tol, &arc);
+        } else {
+            arc_fits = !arcBoundsFit(&bounds, &chain->start, p,
+                chain->length + step, &arc);
+        }
+        // An arc from a corner is only blended with the move before it
+        // if both lie in one plane
+        if (arc_fits && chain->corner) {
+            double off;
+
+            pmCartCartDot(&arc.normal, &chain->tangent, &off);
+            arc_fits = fabs(off) <= PLANE_EPSILON;
+        }
+        if (!arc_fits) {
+            return -1;
+        }
+        is_arc = 1;
+    }
+
+    chain->prev_n = chain->n;
+    chain->prev_end = chain->end;
+    chain->prev_is_arc = chain->is_arc;
+    chain->prev_arc = chain->arc;
+    chain->line = line;
+    chain->bounds = bounds;
+    chain->end = *p;
+    chain->length += step;
+    chain->last_step = step;
+    chain->is_arc = is_arc;
+    if (is_arc) {
+        chain->arc = arc;
+    }
+    chain->n++;
+    return 0;
+}
+
+int pathFitChainBackUp(PathFitChain * const chain)
+{
+    if (chain->prev_n < 2 || chain->prev_n != chain->n - 1) {
+        return -1;
+    }
+    chain->n = chain->prev_n;
+    chain->end = chain->prev_end;
+    chain->is_arc = chain->prev_is_arc;
+    chain->arc = chain->prev_arc;
+    chain->line.dead = 1;
+    chain->bounds.dead = 1;
+    chain->prev_n = 0;
+    return 0;
+}
+
+int pathFitChainLeavesPlane(PathFitChain const * const chain,
+        PmCartesian const * const next)
+{
+    PmCartesian d;
+    double off;
+
+    if (!chain->is_arc) {
+        return 0;
+    }
+    pmCartCartSub(next, &chain->end, &d);
+    if (pmCartUnitEq(&d)) {
+        return 0;
+    }
+    pmCartCartDot(&d, &chain->arc.normal, &off);
+    return fabs(off) > PLANE_EPSILON;
+}
+
+int pathFitChainEndTangent(PathFitChain const * const chain,
+        PmCartesian * const tangent)
+{
+    PmCartesian d;
+
+    if (chain->is_arc) {
+        *tangent = chain->arc.end_tangent;
+        return 0;
+    }
+    if (chain->n < 2) {
+        return -1;
+    }
+    pmCartCartSub(&chain->end, &chain->start, &d);
+    if (pmCartUnit(&d, tangent)) {
+        return -1;
+    }
+    return chain->corner;
+}
@@ -0,0 +1,141 @@
+/********************************************************************
+ * Description: pathfit.h
+ *
+ * Joining of runs of short line segments into longer lines and arcs.
+ *
+ * License: GPL Version 2
+ * System: Linux
+ *
+ ********************************************************************/
+#ifndef PATHFIT_H
+#define PATHFIT_H
+
+#include "posemath.h"
+
+/* Largest angle one fitted arc may sweep.  Kept well short of a full
+ * turn, so the start and end point leave no doubt which way around the
+ * circle the arc goes. */
+#define PATHFIT_MAX_ANGLE (1.5 * PM_PI)
+#define PATHFIT_MIN_RADIUS 1e-6
+/* Points kept of a run that has no tangent to start along */
+#define PATHFIT_FREE_POINTS 32
+
+typedef struct {
+    PmCartesian center;
+    PmCartesian normal;     /* the path runs counterclockwise about this */
+    double radius;
+    double angle;           /* angle swept from the first point to the last */
+    PmCartesian end_tangent;
+} PathFitArc;
+
+/* Directions a line from the start of a run can take and keep every
+ * point so far within tol: a cone about axis, or any direction while
+ * angle is negative.  Points further out than reach must not be past
+ * the end of the line. */
+typedef struct {
+    PmCartesian axis;
+    double angle;
+    double reach;
+    int dead;               /* no line fits */
+} PathFitLineBounds;
+
+/* Arcs leaving the start of a run along t that keep every point so far
+ * within tol.  Such an arc lies in a plane through t, at angle psi
+ * about it from p toward s, and psi_lo..psi_hi bounds that angle
+ * relative to psi_ref; k_lo..k_hi bounds the curvature.  a and b are about where the last point lies in the plane,
+ * along the tangent and toward the centre. */
+typedef struct {
+    PmCartesian t, p, s;
+    double psi_ref, psi_lo, psi_hi;
+    int psi_any;            /* no bounds on psi yet */
+    double k_lo, k_hi;
+    double a, b;
+    int dead;               /* no arc fits */
+} PathFitArcBounds;
+
+/* A run of segments from start to end, through n - 2 points in between,
+ * that lies within tol of the line from start to end, or of arc if
+ * is_arc is set.  Each point is checked against bounds kept for the
+ * points before it, so a run may be any length.
+ *
+ * An arc starts tangent to the move before the run.  If the path turns
+ * a corner at start, or there is no move before, the arc is fitted
+ * freely through the first PATHFIT_FREE_POINTS points and then held to
+ * the tangent it has.  At a corner the arc must also lie in one plane
+ * with the move before, or the corner could not be blended; a line from
+ * a corner only tells the run after it whether it turns another. */
+typedef struct {
+    PmCartesian start;
+    PmCartesian end;
+    int n;
+    double tol;
+    int lines_only;         /* do not fit arcs */
+    PmCartesian tangent;    /* direction of the path coming into start */
+    int have_tangent;
+    int chord;              /* tangent is the direction of a corner run */
+    int corner;             /* the path turns a corner at start */
+    int free;               /* arcs are fitted through pts */
+    int is_arc;
+    PathFitArc arc;
+    double length;          /* along the segments */
+    double last_step;       /* length of the last one */
+    PathFitLineBounds line;
+    PathFitArcBounds bounds;
+    PmCartesian pts[PATHFIT_FREE_POINTS];   /* from start, while free */
+    /* the run as it was before end was added */
+    int prev_n;
+    PmCartesian prev_end;
+    int prev_is_arc;
+    PathFitArc prev_arc;
+} PathFitChain;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Checks of a whole run at once, in O(n).  pts[0] is where the path
+ * starts and pts[n - 1] where it ends; the points in between are the
+ * ends of the segments along the way.  Both
+ * return 0 if every point lies within tol of the fitted path, and
+ * pathFitArc() also requires the path between two points to stay within
+ * tol of the segment joining them, and the points to go around the arc
+ * in order.  If start_tangent is given the arc must leave pts[0] in that
+ * direction.  arc is only written when the points fit. */
+int pathFitLine(PmCartesian const * const pts, int n, double tol);
+
+int pathFitArc(PmCartesian const * const pts, int n,
+        PmCartesian const * const start_tangent, double tol,
+        PathFitArc * const arc);
+
+/* Start a run at start, coming in along tangent if it is not NULL; chord
+ * is what pathFitChainEndTangent() returned for it.  lines_only is left
+ * as it is. */
+void pathFitChainStart(PathFitChain * const chain,
+        PmCartesian const * const start, PmCartesian const * const tangent,
+        int chord, double tol);
+
+/* Add p to the run and return 0 if the run still fits a line or an arc
+ * with it; otherwise leave the run as it is and return -1.  The first
+ * point after the start always goes in. */
+int pathFitChainAdd(PathFitChain * const chain, PmCartesian const * const p);
+
+/* Take the last point off the run again, and return 0; -1 if that
+ * would leave no segment.  Only for ending the run: no more points may
+ * be added after it. */
+int pathFitChainBackUp(PathFitChain * const chain);
+
+/* Nonzero if the run ends in an arc and the path goes on from there to
+ * next out of the plane of the arc */
+int pathFitChainLeavesPlane(PathFitChain const * const chain,
+        PmCartesian const * const next);
+
+/* Direction of the fitted path where the run ends; returns -1 if the
+ * run has not gone anywhere, and 1 if it is a line from a corner */
+int pathFitChainEndTangent(PathFitChain const * const chain,
+        PmCartesian * const tangent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
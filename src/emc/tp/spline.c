@@ -0,0 +1,314 @@
+/********************************************************************
+ * Description: spline.c
+ *
+ * Rational Bezier curves for spline motions, with the lookup tables the
+ * planner needs to move along them by arc length.
+ *
+ * License: GPL Version 2
+ * System: Linux
+ *
+ ********************************************************************/
+
+#include "posemath.h"
+#include "spline.h"
+#include "tp_types.h"
+#include "rtapi_math.h"
+
+/* A control point in homogeneous coordinates, (w * P, w) */
+typedef struct {
+    double x, y, z, w;
+} SplineHom;
+
+static void homFromPoint(PmCartesian const * const p, double w,
+        SplineHom * const out)
+{
+    out->x = p->x * w;
+    out->y = p->y * w;
+    out->z = p->z * w;
+    out->w = w;
+}
+
+static void homAddScaled(SplineHom * const acc, SplineHom const * const h,
+        double k)
+{
+    acc->x += h->x * k;
+    acc->y += h->y * k;
+    acc->z += h->z * k;
+    acc->w += h->w * k;
+}
+
+/* Bernstein polynomials of degree d at u, b[0 .. d] */
+static void bernstein(int d, double u, double * const b)
+{
+    int j, k;
+
+    b[0] = 1.0;
+    for (j = 1; j <= d; j++) {
+        double saved = 0.0;
+        for (k = 0; k < j; k++) {
+            double tmp = b[k];
+            b[k] = saved + (1.0 - u) * tmp;
+            saved = u * tmp;
+        }
+        b[j] = saved;
+    }
+}
+
+int splineDerivs(PmSpline const * const spline, double u,
+        PmCartesian * const point, PmCartesian * const d1,
+        PmCartesian * const d2)
+{
+    SplineHom H[SPLINE_MAX_DEGREE + 1];
+    SplineHom A = {0}, A1 = {0}, A2 = {0};
+    double b[SPLINE_MAX_DEGREE + 1];
+    PmCartesian C, C1 = {0}, C2 = {0};
+    int d = spline->degree;
+    int i;
+
+    for (i = 0; i <= d; i++) {
+        homFromPoint(&spline->ctrl[i], spline->weight[i], &H[i]);
+    }
+
+    bernstein(d, u, b);
+    for (i = 0; i <= d; i++) {
+        homAddScaled(&A, &H[i], b[i]);
+    }
+    if (d >= 1) {
+        bernstein(d - 1, u, b);
+        for (i = 0; i < d; i++) {
+            homAddScaled(&A1, &H[i + 1], d * b[i]);
+            homAddScaled(&A1, &H[i], -d * b[i]);
+        }
+    }
+    if (d >= 2) {
+        bernstein(d - 2, u, b);
+        for (i = 0; i < d - 1; i++) {
+            double k = d * (d - 1) * b[i];
+            homAddScaled(&A2, &H[i + 2], k);
+            homAddScaled(&A2, &H[i + 1], -2.0 * k);
+            homAddScaled(&A2, &H[i], k);
+        }
+    }
+    if (A.w <= 0.0) {
+        return TP_ERR_GEOM;
+    }
+
+    // Quotient rule on (A.xyz / A.w)
+    C.x = A.x / A.w;
+    C.y = A.y / A.w;
+    C.z = A.z / A.w;
+    C1.x = (A1.x - A1.w * C.x) / A.w;
+    C1.y = (A1.y - A1.w * C.y) / A.w;
+    C1.z = (A1.z - A1.w * C.z) / A.w;
+    C2.x = (A2.x - 2.0 * A1.w * C1.x - A2.w * C.x) / A.w;
+    C2.y = (A2.y - 2.0 * A1.w * C1.y - A2.w * C.y) / A.w;
+    C2.z = (A2.z - 2.0 * A1.w * C1.z - A2.w * C.z) / A.w;
+
+    if (point) *point = C;
+    if (d1) *d1 = C1;
+    if (d2) *d2 = C2;
+    return TP_ERR_OK;
+}
+
+static double splineSpeed(PmSpline const * const spline, double u)
+{
+    PmCartesian d1;
+    double speed = 0.0;
+
+    splineDerivs(spline, u, NULL, &d1, NULL);
+    pmCartMag(&d1, &speed);
+    return speed;
+}
+
+/* Arc length from u0 to u1 by 5 point Gauss-Legendre quadrature */
+static double splineLengthBetween(PmSpline const * const spline,
+        double u0, double u1)
+{
+    static const double node[5] = {
+        -0.9061798459386640, -0.5384693101056831, 0.0,
+        0.5384693101056831, 0.9061798459386640 };
+    static const double weight[5] = {
+        0.2369268850561891, 0.4786286704993665, 0.5688888888888889,
+        0.4786286704993665, 0.2369268850561891 };
+    double half = (u1 - u0) / 2.0, mid = (u1 + u0) / 2.0;
+    double sum = 0.0;
+    int i;
+
+    for (i = 0; i < 5; i++) {
+        sum += weight[i] * splineSpeed(spline, mid + half * node[i]);
+    }
+    return sum * half;
+}
+
+int splineInit(PmSpline * const spline, PmCartesian const * const ctrl,
+        double const * const weight, int degree)
+{
+    int i;
+
+    if (degree < 1 || degree > SPLINE_MAX_DEGREE) {
+        return TP_ERR_RANGE;
+    }
+    for (i = 0; i <= degree; i++) {
+        if (!(weight[i] > 0.0)) {
+            return TP_ERR_INVALID;
+        }
+        spline->ctrl[i] = ctrl[i];
+        spline->weight[i] = weight[i];
+    }
+    spline->degree = degree;
+
+    spline->s[0] = 0.0;
+    for (i = 0; i < SPLINE_TABLE_SIZE; i++) {
+        double u0 = (double)i / SPLINE_TABLE_SIZE;
+        double u1 = (double)(i + 1) / SPLINE_TABLE_SIZE;
+        spline->s[i + 1] = spline->s[i] + splineLengthBetween(spline, u0, u1);
+        spline->speed[i] = splineSpeed(spline, u0);
+    }
+    spline->speed[SPLINE_TABLE_SIZE] = splineSpeed(spline, 1.0);
+    spline->length = spline->s[SPLINE_TABLE_SIZE];
+    if (spline->length < TP_POS_EPSILON) {
+        return TP_ERR_ZERO_LENGTH;
+    }
+
+    // Curvature |P' x P''| / |P'|^3, sampled along the curve
+    spline->max_curvature = 0.0;
+    for (i = 0; i <= SPLINE_TABLE_SIZE * SPLINE_CURVATURE_SAMPLES; i++) {
+        PmCartesian d1, d2, cross;
+        double speed, cross_mag;
+
+        splineDerivs(spline,
+                (double)i / (SPLINE_TABLE_SIZE * SPLINE_CURVATURE_SAMPLES),
+                NULL, &d1, &d2);
+        pmCartMag(&d1, &speed);
+        if (speed < TP_POS_EPSILON) {
+            // A cusp in the parameter only; the path itself turns smoothly
+            continue;
+        }
+        pmCartCartCross(&d1, &d2, &cross);
+        pmCartMag(&cross, &cross_mag);
+        spline->max_curvature = fmax(spline->max_curvature,
+                cross_mag / (speed * speed * speed));
+    }
+    return TP_ERR_OK;
+}
+
+/* Slope of u against the fraction of the table interval travelled, for
+ * the Hermite interpolation below.  Limited to 3 times the interval,
+ * which keeps u rising with s. */
+static double hermiteSlope(double speed, double ds, double h)
+{
+    if (speed * 3.0 * h <= ds) {
+        return 3.0 * h;
+    }
+    return ds / speed;
+}
+
+double splineParamFromLength(PmSpline const * const spline, double s)
+{
+    const double h = 1.0 / SPLINE_TABLE_SIZE;
+    int lo = 0, hi = SPLINE_TABLE_SIZE;
+
+    if (s <= 0.0) {
+        return 0.0;
+    }
+    if (s >= spline->length) {
+        return 1.0;
+    }
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (spline->s[mid] <= s) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // Cubic Hermite between the table entries, with du/ds = 1 / speed at each
+    double ds = spline->s[hi] - spline->s[lo];
+    double u0 = lo * h, u1 = hi * h;
+    if (ds <= 0.0) {
+        return u0;
+    }
+    double t = (s - spline->s[lo]) / ds;
+    double t2 = t * t, t3 = t2 * t;
+    double m0 = hermiteSlope(spline->speed[lo], ds, h);
+    double m1 = hermiteSlope(spline->speed[hi], ds, h);
+    double u = (2.0 * t3 - 3.0 * t2 + 1.0) * u0 + (t3 - 2.0 * t2 + t) * m0
+        + (-2.0 * t3 + 3.0 * t2) * u1 + (t3 - t2) * m1;
+    return fmax(u0, fmin(u1, u));
+}
+
+int splinePoint(PmSpline const * const spline, double s,
+        PmCartesian * const out)
+{
+    return splineDerivs(spline, splineParamFromLength(spline, s),
+            out, NULL, NULL);
+}
+
+int splineTangent(PmSpline const * const spline, double s,
+        PmCartesian * const out)
+{
+    PmCartesian d1, d2;
+    int res = splineDerivs(spline, splineParamFromLength(spline, s),
+            NULL, &d1, &d2);
+
+    if (res) {
+        return res;
+    }
+    // Where the first derivative vanishes the path leaves along the second
+    if (!pmCartUnit(&d1, out)) {
+        return TP_ERR_OK;
+    }
+    if (s > spline->length / 2.0) {
+        pmCartNegEq(&d2);
+    }
+    return pmCartUnit(&d2, out) ? TP_ERR_GEOM : TP_ERR_OK;
+}
+
+int splineNurbsSpan(PmCartesian const * const ctrl,
+        double const * const weight, int n, int order, int index,
+        SplineSpan * const span)
+{
+    const int p = order - 1;
+    const int l = index + p;
+    int m, r, i;
+
+    if (p < 1 || p > SPLINE_MAX_DEGREE || index < 0 || index > n - order) {
+        return TP_ERR_RANGE;
+    }
+
+    // Bezier control point m of the span [index, index + 1] is the
+    // blossom of the NURBS at index repeated p - m times and index + 1
+    // repeated m times
+    for (m = 0; m <= p; m++) {
+        SplineHom d[SPLINE_MAX_DEGREE + 1];
+
+        for (i = 0; i <= p; i++) {
+            homFromPoint(&ctrl[l - p + i], weight[l - p + i], &d[i]);
+        }
+        for (r = 1; r <= p; r++) {
+            double t = r <= p - m ? index : index + 1;
+            for (i = l; i >= l - p + r; i--) {
+                // Knots are 0 (order times), 1, 2, ..., n - order + 1 (order times)
+                double lo = i < order ? 0 : (i < n ? i - order + 1 : n - order + 1);
+                int j = i + p + 1 - r;
+                double hi = j < order ? 0 : (j < n ? j - order + 1 : n - order + 1);
+                double alpha = (t - lo) / (hi - lo);
+                SplineHom * const cur = &d[i - (l - p)];
+                SplineHom const * const prev = &d[i - 1 - (l - p)];
+                cur->x = (1.0 - alpha) * prev->x + alpha * cur->x;
+                cur->y = (1.0 - alpha) * prev->y + alpha * cur->y;
+                cur->z = (1.0 - alpha) * prev->z + alpha * cur->z;
+                cur->w = (1.0 - alpha) * prev->w + alpha * cur->w;
+            }
+        }
+        if (d[p].w <= 0.0) {
+            return TP_ERR_GEOM;
+        }
+        span->weight[m] = d[p].w;
+        span->ctrl[m].x = d[p].x / d[p].w;
+        span->ctrl[m].y = d[p].y / d[p].w;
+        span->ctrl[m].z = d[p].z / d[p].w;
+    }
+    return TP_ERR_OK;
+}
@@ -0,0 +1,72 @@
+/********************************************************************
+ * Description: spline.h
+ *
+ * Rational Bezier curves for spline motions, with the lookup tables the
+ * planner needs to move along them by arc length.
+ *
+ * License: GPL Version 2
+ * System: Linux
+ *
+ ********************************************************************/
+#ifndef SPLINE_H
+#define SPLINE_H
+
+#include "posemath.h"
+#include "emcmotcfg.h"
+
+#define SPLINE_MAX_DEGREE (EMCMOT_MAX_SPLINE_POINTS - 1)
+/* Intervals in u of the arc length table */
+#define SPLINE_TABLE_SIZE 16
+/* Curvature is checked this many times per table interval */
+#define SPLINE_CURVATURE_SAMPLES 4
+
+typedef struct {
+    PmCartesian ctrl[SPLINE_MAX_DEGREE + 1];
+    double weight[SPLINE_MAX_DEGREE + 1];
+    int degree;
+    double length;
+    /* Arc length from the start, and speed |dP/du|, at u = i / SPLINE_TABLE_SIZE */
+    double s[SPLINE_TABLE_SIZE + 1];
+    double speed[SPLINE_TABLE_SIZE + 1];
+    double max_curvature;
+} PmSpline;
+
+/* One span of a NURBS as a rational Bezier curve */
+typedef struct {
+    PmCartesian ctrl[SPLINE_MAX_DEGREE + 1];
+    double weight[SPLINE_MAX_DEGREE + 1];
+} SplineSpan;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int splineInit(PmSpline * const spline, PmCartesian const * const ctrl,
+        double const * const weight, int degree);
+
+/* Point, first and second derivative with respect to u at u, 0 <= u <= 1.
+ * d1 and d2 may be NULL. */
+int splineDerivs(PmSpline const * const spline, double u,
+        PmCartesian * const point, PmCartesian * const d1,
+        PmCartesian * const d2);
+
+double splineParamFromLength(PmSpline const * const spline, double s);
+
+int splinePoint(PmSpline const * const spline, double s,
+        PmCartesian * const out);
+
+int splineTangent(PmSpline const * const spline, double s,
+        PmCartesian * const out);
+
+/* The NURBS of the given order through ctrl[0 .. n - 1] with weights,
+ * on the uniform clamped knot vector G5.2 uses, has n - order + 1 spans.
+ * Write span number index of them to span. */
+int splineNurbsSpan(PmCartesian const * const ctrl,
+        double const * const weight, int n, int order, int index,
+        SplineSpan * const span);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
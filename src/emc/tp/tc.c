@@ -77,7 +77,8 @@ double tcGetTangentialMaxAccel(TC_STRUCT const * const tc)
     // Reduce allowed tangential acceleration in circular motions to stay
     // within overall limits (accounts for centripetal acceleration while
     // moving along the circular path).
-    if (tc->motion_type == TC_CIRCULAR || tc->motion_type == TC_SPHERICAL) {
+    if (tc->motion_type == TC_CIRCULAR || tc->motion_type == TC_SPHERICAL
+            || tc->motion_type == TC_SPLINE) {
         //Limit acceleration for cirular arcs to allow for normal acceleration
         a_scale *= tc->acc_ratio_tan;
     }
@@ -161,6 +162,9 @@ int tcGetStartAccelUnitVector(TC_STRUCT const * const tc, PmCartesian * const ou
         case TC_CIRCULAR:
             tcCircleStartAccelUnitVector(tc,out);
             break;
+        case TC_SPLINE:
+            splineTangent(&tc->coords.spline.xyz, 0.0, out);
+            break;
         case TC_SPHERICAL:
             return -1;
         default:
@@ -185,6 +189,10 @@ int tcGetEndAccelUnitVector(TC_STRUCT const * const tc, PmCartesian * const out)
         case TC_CIRCULAR:
             tcCircleEndAccelUnitVector(tc,out);
             break;
+        case TC_SPLINE:
+            splineTangent(&tc->coords.spline.xyz,
+                    tc->coords.spline.xyz.length, out);
+            break;
        case TC_SPHERICAL:
             return -1;
        default:
@@ -287,6 +295,8 @@ int tcGetStartTangentUnitVector(TC_STRUCT const * const tc, PmCartesian * const
         case TC_CIRCULAR:
             pmCircleTangentVector(&tc->coords.circle.xyz, 0.0, out);
             break;
+        case TC_SPLINE:
+            return splineTangent(&tc->coords.spline.xyz, 0.0, out);
         default:
             rtapi_print_msg(RTAPI_MSG_ERR, "Invalid motion type %d!\n",tc->motion_type);
             return -1;
@@ -310,6 +320,9 @@ int tcGetEndTangentUnitVector(TC_STRUCT const * const tc, PmCartesian * const ou
             pmCircleTangentVector(&tc->coords.circle.xyz,
                     tc->coords.circle.xyz.angle, out);
             break;
+        case TC_SPLINE:
+            return splineTangent(&tc->coords.spline.xyz,
+                    tc->coords.spline.xyz.length, out);
         default:
             rtapi_print_msg(RTAPI_MSG_ERR, "Invalid motion type %d!\n",tc->motion_type);
             return -1;
@@ -353,7 +366,25 @@ double tcGetTarget(TC_STRUCT const * const tc, int direction)
  * @return	 EmcPose   returns a position (\ref EmcPose = datatype carrying XYZABC information
  */
 
-int tcGetPos(TC_STRUCT const * const tc, EmcPose * const out) {
+int tcGetPos(TC_STRUCT * const tc, EmcPose * const out) {
+    if (tc->motion_type == TC_CIRCULAR) {
+        // Called every cycle, so use the incremental evaluation
+        PmCircle9 * const circ9 = &tc->coords.circle;
+        PmCartesian xyz, abc, uvw;
+        int res_fit = pmCircleFastPoint(&circ9->xyz, &circ9->fit,
+                &circ9->cursor, tc->progress, &xyz);
+        if (res_fit != TP_ERR_OK) {
+            return res_fit;
+        }
+        pmCartLinePoint(&circ9->abc,
+                tc->progress * circ9->abc.tmag / tc->target,
+                &abc);
+        pmCartLinePoint(&circ9->uvw,
+                tc->progress * circ9->uvw.tmag / tc->target,
+                &uvw);
+        pmCartesianToEmcPose(&xyz, &abc, &uvw, out);
+        return 0;
+    }
     tcGetPosReal(tc, TC_GET_PROGRESS, out);
     return 0;
 }
@@ -435,6 +466,17 @@ int tcGetPosReal(TC_STRUCT const * const tc, int of_point, EmcPose * const pos)
             abc = tc->coords.arc.abc;
             uvw = tc->coords.arc.uvw;
             break;
+        case TC_SPLINE:
+            res_fit = splinePoint(&tc->coords.spline.xyz,
+                    progress,
+                    &xyz);
+            pmCartLinePoint(&tc->coords.spline.abc,
+                    progress * tc->coords.spline.abc.tmag / tc->target,
+                    &abc);
+            pmCartLinePoint(&tc->coords.spline.uvw,
+                    progress * tc->coords.spline.uvw.tmag / tc->target,
+                    &uvw);
+            break;
     }
 
     if (res_fit == TP_ERR_OK) {
@@ -735,24 +777,87 @@ int pmCircle9Init(PmCircle9 * const circ9,
     return TP_ERR_OK;
 }
 
-double pmCircle9Target(PmCircle9 const * const circ9)
+int pmSpline9Init(PmSpline9 * const spline9,
+        EmcPose const * const start,
+        EmcPose const * const end,
+        PmCartesian const * const ctrl,
+        double const * const weight,
+        int degree)
 {
+    PmCartesian start_xyz, end_xyz;
+    PmCartesian start_uvw, end_uvw;
+    PmCartesian start_abc, end_abc;
+    PmCartesian points[SPLINE_MAX_DEGREE + 1];
+    int i;
+
+    if (degree < 1 || degree > SPLINE_MAX_DEGREE) {
+        return TP_ERR_RANGE;
+    }
+
+    emcPoseToPmCartesian(start, &start_xyz, &start_abc, &start_uvw);
+    emcPoseToPmCartesian(end, &end_xyz, &end_abc, &end_uvw);
+
+    // The curve runs from wherever the last move ended to the endpoint,
+    // whatever rounding the control points went through
+    for (i = 0; i <= degree; i++) {
+        points[i] = ctrl[i];
+    }
+    points[0] = start_xyz;
+    points[degree] = end_xyz;
+
+    int xyz_fail = splineInit(&spline9->xyz, points, weight, degree);
+    if (xyz_fail == TP_ERR_ZERO_LENGTH) {
+        return TP_ERR_ZERO_LENGTH;
+    }
+    int abc_fail = pmCartLineInit(&spline9->abc, &start_abc, &end_abc);
+    int uvw_fail = pmCartLineInit(&spline9->uvw, &start_uvw, &end_uvw);
 
-    double h2;
-    pmCartMagSq(&circ9->xyz.rHelix, &h2);
-    double helical_length = pmSqrt(pmSq(circ9->fit.total_planar_length) + h2);
+    if (xyz_fail || abc_fail || uvw_fail) {
+        rtapi_print_msg(RTAPI_MSG_ERR,"Failed to initialize Spline9, err codes %d, %d, %d\n",
+                xyz_fail, abc_fail, uvw_fail);
+        return TP_ERR_FAIL;
+    }
+    return TP_ERR_OK;
+}
+
+double pmSpline9Target(PmSpline9 const * const spline9)
+{
+    return spline9->xyz.length;
+}
 
-    return helical_length;
+double pmCircle9Target(PmCircle9 const * const circ9)
+{
+    // Helical length is stored by findSpiralArcLengthFit
+    return circ9->fit.total_length;
 }
 
-int tcUpdateCircleAccRatio(TC_STRUCT * tc)
+int tcUpdateCircleAccRatio(TC_STRUCT * tc, double max_feed_scale)
 {
+    // The tangential acceleration only has to leave room for the normal
+    // acceleration at the fastest the segment can be fed, which is often
+    // well short of maxvel
+    double v_reach = tcGetMaxTargetVel(tc, max_feed_scale);
+
     if (tc->motion_type == TC_CIRCULAR) {
         PmCircleLimits limits = pmCircleActualMaxVel(&tc->coords.circle.xyz,
                              tc->maxvel,
                              tcGetOverallMaxAccel(tc));
+        PmCircleLimits reach = pmCircleActualMaxVel(&tc->coords.circle.xyz,
+                             v_reach,
+                             tcGetOverallMaxAccel(tc));
         tc->maxvel = limits.v_max;
-        tc->acc_ratio_tan = limits.acc_ratio;
+        tc->acc_ratio_tan = reach.acc_ratio;
+        return 0;
+    }
+    if (tc->motion_type == TC_SPLINE) {
+        PmCircleLimits limits = pmSplineActualMaxVel(&tc->coords.spline.xyz,
+                             tc->maxvel,
+                             tcGetOverallMaxAccel(tc));
+        PmCircleLimits reach = pmSplineActualMaxVel(&tc->coords.spline.xyz,
+                             v_reach,
+                             tcGetOverallMaxAccel(tc));
+        tc->maxvel = limits.v_max;
+        tc->acc_ratio_tan = reach.acc_ratio;
         return 0;
     }
     // TODO handle blend arc here too?
@@ -766,7 +871,7 @@ int tcUpdateCircleAccRatio(TC_STRUCT * tc)
  * trust that the length will be the same, and so can use the length in the
  * velocity optimization.
  */
-int tcFinalizeLength(TC_STRUCT * const tc)
+int tcFinalizeLength(TC_STRUCT * const tc, double max_feed_scale)
 {
     //Apply velocity corrections
     if (!tc) {
@@ -782,7 +887,7 @@ int tcFinalizeLength(TC_STRUCT * const tc)
 
     tcClampVelocityByLength(tc);
 
-    tcUpdateCircleAccRatio(tc);
+    tcUpdateCircleAccRatio(tc, max_feed_scale);
 
     tc->finalized = 1;
     return TP_ERR_OK;
@@ -813,11 +918,7 @@ int tcUpdateTargetFromCircle(TC_STRUCT * const tc)
         return TP_ERR_FAIL;
     }
 
-    double h2;
-    pmCartMagSq(&tc->coords.circle.xyz.rHelix, &h2);
-    double helical_length = pmSqrt(pmSq(tc->coords.circle.fit.total_planar_length) + h2);
-
-    tc->target = helical_length;
+    tc->target = tc->coords.circle.fit.total_length;
     return TP_ERR_OK;
 }
 
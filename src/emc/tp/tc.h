@@ -33,7 +33,7 @@ int tcInitKinkProperties(TC_STRUCT *tc);
 int tcRemoveKinkProperties(TC_STRUCT *prev_tc, TC_STRUCT *tc);
 int tcGetEndpoint(TC_STRUCT const * const tc, EmcPose * const out);
 int tcGetStartpoint(TC_STRUCT const * const tc, EmcPose * const out);
-int tcGetPos(TC_STRUCT const * const tc,  EmcPose * const out);
+int tcGetPos(TC_STRUCT * const tc,  EmcPose * const out);
 int tcGetPosReal(TC_STRUCT const * const tc, int of_endpoint,  EmcPose * const out);
 int tcGetEndAccelUnitVector(TC_STRUCT const * const tc, PmCartesian * const out);
 int tcGetStartAccelUnitVector(TC_STRUCT const * const tc, PmCartesian * const out);
@@ -81,6 +81,15 @@ int pmCircle9Init(PmCircle9 * const circ9,
         PmCartesian const * const normal,
         int turn);
 
+int pmSpline9Init(PmSpline9 * const spline9,
+        EmcPose const * const start,
+        EmcPose const * const end,
+        PmCartesian const * const ctrl,
+        double const * const weight,
+        int degree);
+
+double pmSpline9Target(PmSpline9 const * const spline9);
+
 int pmRigidTapInit(PmRigidTap * const tap,
         EmcPose const * const start,
         EmcPose const * const end,
@@ -104,9 +113,9 @@ int tcSetupMotion(TC_STRUCT * const tc,
 
 int tcSetupState(TC_STRUCT * const tc, TP_STRUCT const * const tp);
 
-int tcUpdateCircleAccRatio(TC_STRUCT * tc);
+int tcUpdateCircleAccRatio(TC_STRUCT * tc, double max_feed_scale);
 
-int tcFinalizeLength(TC_STRUCT * const tc);
+int tcFinalizeLength(TC_STRUCT * const tc, double max_feed_scale);
 
 int tcClampVelocityByLength(TC_STRUCT * const tc);
 
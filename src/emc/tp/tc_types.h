@@ -14,6 +14,7 @@
 #define TC_TYPES_H
 
 #include "spherical_arc.h"
+#include "spline.h"
 #include "posemath.h"
 #include "emcpos.h"
 #include "emcmotcfg.h"
@@ -32,7 +33,8 @@ typedef enum {
     TC_LINEAR = 1,
     TC_CIRCULAR = 2,
     TC_RIGIDTAP = 3,
-    TC_SPHERICAL = 4
+    TC_SPHERICAL = 4,
+    TC_SPLINE = 5
 } tc_motion_type_t;
 
 typedef enum {
@@ -65,8 +67,27 @@ typedef struct {
     double total_planar_length; /* total arc length in plane */
     int spiral_in;              /* flag indicating spiral is inward,
                                    rather than outward */
+    /* Per-segment constants for pmCircleFastPoint() */
+    double total_length;        /* arc length along the helix */
+    double inv_b1;              /* 1 / b1, for circles with no spiral */
+    double inv_angle;           /* 1 / angle */
+    double spiral_rate;         /* fractional growth of radius per radian */
 } SpiralArcLengthFit;
 
+/**
+ * Cos and sin of the last angle evaluated along a circle.
+ * From one servo cycle to the next the angle only moves a little, so
+ * the next point can be found by rotating these instead of calling
+ * cos() and sin() again.
+ */
+typedef struct {
+    double angle;
+    double cos_angle;
+    double sin_angle;
+    int steps;                  /* rotations since the last exact evaluation */
+    int valid;
+} PmCircleCursor;
+
 
 /* structure for individual trajectory elements */
 
@@ -81,8 +102,15 @@ typedef struct {
     PmCartLine abc;
     PmCartLine uvw;
     SpiralArcLengthFit fit;
+    PmCircleCursor cursor;
 } PmCircle9;
 
+typedef struct {
+    PmSpline xyz;
+    PmCartLine abc;
+    PmCartLine uvw;
+} PmSpline9;
+
 typedef struct {
     SphericalArc xyz;
     PmCartesian abc;
@@ -146,11 +174,13 @@ typedef struct {
         PmCircle9 circle;
         PmRigidTap rigidtap;
         Arc9 arc;
+        PmSpline9 spline;
     } coords;
 
     int motion_type;       // TC_LINEAR (coords.line) or
                             // TC_CIRCULAR (coords.circle) or
-                            // TC_RIGIDTAP (coords.rigidtap)
+                            // TC_RIGIDTAP (coords.rigidtap) or
+                            // TC_SPLINE (coords.spline)
     int active;            // this motion is being executed
     int canon_motion_type;  // this motion is due to which canon function?
     int term_cond;          // gcode requests continuous feed at the end of
@@ -103,6 +103,12 @@ STATIC int tcRotaryMotionCheck(TC_STRUCT const * const tc) {
             }
         case TC_SPHERICAL:
             return true;
+        case TC_SPLINE:
+            if (tc->coords.spline.abc.tmag_zero && tc->coords.spline.uvw.tmag_zero) {
+                return false;
+            } else {
+                return true;
+            }
         default:
             tp_debug_print("Unknown motion type!\n");
             return false;
@@ -740,7 +746,7 @@ STATIC int tpInitBlendArcFromPrev(TP_STRUCT const * const tp,
 
     //NOTE: blend arc radius and everything else is finalized, so set this to 1.
     //In the future, radius may be adjustable.
-    tcFinalizeLength(blend_tc);
+    tcFinalizeLength(blend_tc, getMaxFeedScale(blend_tc));
 
     return TP_ERR_OK;
 }
@@ -1519,7 +1525,7 @@ int tpAddRigidTap(TP_STRUCT * const tp,
     TC_STRUCT *prev_tc;
     //Assume non-zero error code is failure
     prev_tc = tcqLast(&tp->queue);
-    tcFinalizeLength(prev_tc);
+    tcFinalizeLength(prev_tc, getMaxFeedScale(prev_tc));
     tcFlagEarlyStop(prev_tc, &tc);
     int retval = tpAddSegmentToQueue(tp, &tc, true);
     tpRunOptimization(tp);
@@ -1820,7 +1826,8 @@ STATIC int tpSetupTangent(TP_STRUCT const * const tp,
     //FIXME this ratio is arbitrary, should be more easily tunable
     double acc_scale_max = pmCartAbsMax(&acc_scale);
     //KLUDGE lumping a few calculations together here
-    if (prev_tc->motion_type == TC_CIRCULAR || tc->motion_type == TC_CIRCULAR) {
+    if (prev_tc->motion_type == TC_CIRCULAR || tc->motion_type == TC_CIRCULAR
+            || prev_tc->motion_type == TC_SPLINE || tc->motion_type == TC_SPLINE) {
         acc_scale_max /= BLEND_ACC_RATIO_TANGENTIAL;
     }
 
@@ -1996,7 +2003,7 @@ int tpAddLine(TP_STRUCT * const tp, EmcPose end, int canon_motion_type,
     if (emcmotConfig->arcBlendEnable){
         tpHandleBlendArc(tp, &tc);
     }
-    tcFinalizeLength(prev_tc);
+    tcFinalizeLength(prev_tc, getMaxFeedScale(prev_tc));
     tcFlagEarlyStop(prev_tc, &tc);
 
     int retval = tpAddSegmentToQueue(tp, &tc, true);
@@ -2087,7 +2094,94 @@ int tpAddCircle(TP_STRUCT * const tp,
         tpHandleBlendArc(tp, &tc);
         findSpiralArcLengthFit(&tc.coords.circle.xyz, &tc.coords.circle.fit);
     }
-    tcFinalizeLength(prev_tc);
+    tcFinalizeLength(prev_tc, getMaxFeedScale(prev_tc));
+    tcFlagEarlyStop(prev_tc, &tc);
+
+    int retval = tpAddSegmentToQueue(tp, &tc, true);
+
+    tpRunOptimization(tp);
+    return retval;
+}
+
+
+/**
+ * Adds a spline move, a rational Bezier curve from the end of the last move
+ * to this new position.
+ *
+ * ctrl and weight hold the degree + 1 control points and their weights; the
+ * first and last points are replaced by the start and end of the move. The
+ * curve is queued as a single segment, moved along by arc length, and its
+ * velocity limited so that the acceleration around its tightest bend stays
+ * within the machine limits.
+ */
+int tpAddSpline(TP_STRUCT * const tp,
+        EmcPose end,
+        PmCartesian const * const ctrl,
+        double const * const weight,
+        int degree,
+        int canon_motion_type,
+        double vel,
+        double ini_maxvel,
+        double acc,
+        unsigned char enables,
+        char atspeed,
+        struct state_tag_t tag)
+{
+    if (tpErrorCheck(tp)<0) {
+        return TP_ERR_FAIL;
+    }
+
+    tp_info_print("== AddSpline ==\n");
+
+    TC_STRUCT tc = {0};
+
+    tcInit(&tc,
+            TC_SPLINE,
+            canon_motion_type,
+            tp->cycleTime,
+            enables,
+            atspeed);
+    tc.tag = tag;
+    // Setup any synced IO for this move
+    tpSetupSyncedIO(tp, &tc);
+
+    // Copy over state data from the trajectory planner
+    tcSetupState(&tc, tp);
+
+    // Setup spline geometry and its arc length table
+    int res_init = pmSpline9Init(&tc.coords.spline,
+            &tp->goalPos,
+            &end,
+            ctrl,
+            weight,
+            degree);
+
+    if (res_init) return res_init;
+
+    tc.target = pmSpline9Target(&tc.coords.spline);
+    if (tc.target < TP_POS_EPSILON) {
+        return TP_ERR_ZERO_LENGTH;
+    }
+    tp_debug_print("tc.target = %f\n",tc.target);
+    tc.nominal_length = tc.target;
+
+    // Copy in motion parameters
+    tcSetupMotion(&tc,
+            vel,
+            ini_maxvel,
+            acc);
+
+    //Reduce max velocity to match sample rate
+    tcClampVelocityByLength(&tc);
+
+    TC_STRUCT *prev_tc;
+    prev_tc = tcqLast(&tp->queue);
+
+    handleModeChange(prev_tc, &tc);
+    if (emcmotConfig->arcBlendEnable){
+        tpHandleBlendArc(tp, &tc);
+    }
+    tcFinalizeLength(prev_tc, getMaxFeedScale(prev_tc));
     tcFlagEarlyStop(prev_tc, &tc);
 
     int retval = tpAddSegmentToQueue(tp, &tc, true);
@@ -53,6 +53,11 @@ int tpAddCircle(TP_STRUCT * const tp, EmcPose end, PmCartesian center,
 		PmCartesian normal, int turn, int canon_motion_type, double vel,
 		double ini_maxvel, double acc, unsigned char enables,
 		char atspeed, struct state_tag_t tag);
+int tpAddSpline(TP_STRUCT * const tp, EmcPose end,
+		PmCartesian const * const ctrl, double const * const weight,
+		int degree, int canon_motion_type, double vel, double ini_maxvel,
+		double acc, unsigned char enables, char atspeed,
+		struct state_tag_t tag);
 int tpGetPos(TP_STRUCT const  * const tp, EmcPose * const pos);
 int tpIsDone(TP_STRUCT * const tp);
 int tpQueueDepth(TP_STRUCT * const tp);
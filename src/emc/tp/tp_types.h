@@ -46,6 +46,11 @@
 #define TP_MIN_ARC_LENGTH 1e-6
 #define TP_BIG_NUM 1e10
 
+/* Largest angle step (rad) that pmCircleFastPoint() takes by rotation, and
+ * the number of rotations before cos/sin are recomputed exactly */
+#define TP_CIRCLE_STEP_MAX 0.05
+#define TP_CIRCLE_RESYNC_STEPS 1024
+
 /**
  * TP return codes.
  * This enum is a catch-all for useful return statuses from TP
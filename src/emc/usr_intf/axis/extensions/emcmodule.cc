@@ -82,10 +82,52 @@ struct pyIniFile {
     IniFile *i;
 };
 
+// Field groups reported by stat.poll().  Each byte of EMC_STAT belongs to
+// exactly one group; see stat_ranges below.
+enum {
+    STAT_GROUP_STAT       = 1 << 0,
+    STAT_GROUP_TASK       = 1 << 1,
+    STAT_GROUP_TRAJ       = 1 << 2,
+    STAT_GROUP_JOINT      = 1 << 3,
+    STAT_GROUP_AXIS       = 1 << 4,
+    STAT_GROUP_SPINDLE    = 1 << 5,
+    STAT_GROUP_MOTION     = 1 << 6,
+    STAT_GROUP_IO         = 1 << 7,
+    STAT_GROUP_TOOL_TABLE = 1 << 8,
+    STAT_GROUP_ALL        = (1 << 9) - 1
+};
+
+// Getters whose result is kept until poll() sees their group change.
+// Only getters that return immutable objects are cached.
+enum {
+    STAT_CACHE_POSITION,
+    STAT_CACHE_ACTUAL,
+    STAT_CACHE_DTG,
+    STAT_CACHE_PROBED,
+    STAT_CACHE_G5X_OFFSET,
+    STAT_CACHE_G92_OFFSET,
+    STAT_CACHE_TOOL_OFFSET,
+    STAT_CACHE_JOINT_POSITION,
+    STAT_CACHE_JOINT_ACTUAL,
+    STAT_CACHE_LIMIT,
+    STAT_CACHE_HOMED,
+    STAT_CACHE_GCODES,
+    STAT_CACHE_MCODES,
+    STAT_CACHE_SETTINGS,
+    STAT_CACHE_DIN,
+    STAT_CACHE_DOUT,
+    STAT_CACHE_AIN,
+    STAT_CACHE_AOUT,
+    STAT_CACHE_TOOL_TABLE,
+    STAT_CACHE_MAX
+};
+
 struct pyStatChannel {
     PyObject_HEAD
     RCS_STAT_CHANNEL *c;
     EMC_STAT status;
+    bool polled;
+    PyObject *cache[STAT_CACHE_MAX];
 };
 
 struct pyCommandChannel {
@@ -272,7 +314,10 @@ static int Stat_init(pyStatChannel *self, PyObject *a, PyObject *k) {
 }
 
 static void Stat_dealloc(PyObject *self) {
-    delete ((pyStatChannel*)self)->c;
+    pyStatChannel *s = (pyStatChannel*)self;
+    for(int i = 0; i < STAT_CACHE_MAX; i++)
+        Py_CLEAR(s->cache[i]);
+    delete s->c;
     PyObject_Del(self);
 }
 
@@ -284,18 +329,119 @@ static bool check_stat(RCS_STAT_CHANNEL *emcStatusBuffer) {
     return true;
 }
 
+#define SO(x) offsetof(EMC_STAT, x)
+static const struct {
+    size_t start, end;
+    unsigned group;
+} stat_ranges[] = {
+    {0, SO(task), STAT_GROUP_STAT},
+    {SO(task), SO(motion), STAT_GROUP_TASK},
+    {SO(motion), SO(motion.traj), STAT_GROUP_MOTION},
+    {SO(motion.traj), SO(motion.joint), STAT_GROUP_TRAJ},
+    {SO(motion.joint), SO(motion.axis), STAT_GROUP_JOINT},
+    {SO(motion.axis), SO(motion.spindle), STAT_GROUP_AXIS},
+    {SO(motion.spindle), SO(motion.synch_di), STAT_GROUP_SPINDLE},
+    {SO(motion.synch_di), SO(io), STAT_GROUP_MOTION},
+    {SO(io), SO(io.tool.toolTable), STAT_GROUP_IO},
+    {SO(io.tool.toolTable), SO(io.coolant), STAT_GROUP_TOOL_TABLE},
+    {SO(io.coolant), SO(debug), STAT_GROUP_IO},
+    {SO(debug), sizeof(EMC_STAT), STAT_GROUP_STAT},
+};
+#undef SO
+
+static const char *stat_group_names[] = {
+    "stat", "task", "traj", "joint", "axis", "spindle", "motion", "io",
+    "tool_table",
+};
+
+static const unsigned stat_cache_groups[STAT_CACHE_MAX] = {
+    STAT_GROUP_TRAJ,                    // position
+    STAT_GROUP_TRAJ,                    // actual_position
+    STAT_GROUP_TRAJ,                    // dtg
+    STAT_GROUP_TRAJ,                    // probed_position
+    STAT_GROUP_TASK,                    // g5x_offset
+    STAT_GROUP_TASK,                    // g92_offset
+    STAT_GROUP_TASK,                    // tool_offset
+    STAT_GROUP_JOINT,                   // joint_position
+    STAT_GROUP_JOINT,                   // joint_actual_position
+    STAT_GROUP_JOINT,                   // limit
+    STAT_GROUP_JOINT,                   // homed
+    STAT_GROUP_TASK,                    // gcodes
+    STAT_GROUP_TASK,                    // mcodes
+    STAT_GROUP_TASK,                    // settings
+    STAT_GROUP_MOTION,                  // din
+    STAT_GROUP_MOTION,                  // dout
+    STAT_GROUP_MOTION,                  // ain
+    STAT_GROUP_MOTION,                  // aout
+    STAT_GROUP_TOOL_TABLE,              // tool_table
+};
+
+// Copy the parts of the status buffer that differ from the last poll and
+// return the groups they belong to.
+static unsigned stat_update(pyStatChannel *s, const EMC_STAT *emcStatus) {
+    const char *src = (const char *)emcStatus;
+    char *dst = (char *)&s->status;
+    unsigned changed = 0;
+
+    if(!s->polled) {
+        memcpy(dst, src, sizeof(EMC_STAT));
+        s->polled = true;
+        return STAT_GROUP_ALL;
+    }
+    for(size_t i = 0; i < sizeof(stat_ranges) / sizeof(stat_ranges[0]); i++) {
+        size_t start = stat_ranges[i].start, len = stat_ranges[i].end - start;
+        if(memcmp(dst + start, src + start, len)) {
+            memcpy(dst + start, src + start, len);
+            changed |= stat_ranges[i].group;
+        }
+    }
+    return changed;
+}
+
 static PyObject *poll(pyStatChannel *s, PyObject *o) {
+    unsigned changed = 0;
     if(!check_stat(s->c)) return NULL;
     if(s->c->peek() == EMC_STAT_TYPE) {
         EMC_STAT *emcStatus = static_cast<EMC_STAT*>(s->c->get_address());
-        memcpy((char*)&s->status, emcStatus, sizeof(EMC_STAT));
+        changed = stat_update(s, emcStatus);
     }
-    Py_INCREF(Py_None);
-    return Py_None;
+    if(changed) {
+        for(int i = 0; i < STAT_CACHE_MAX; i++) {
+            if(stat_cache_groups[i] & changed)
+                Py_CLEAR(s->cache[i]);
+        }
+    }
+
+    PyObject *res = PyFrozenSet_New(NULL);
+    if(!res) return NULL;
+    for(unsigned i = 0; i < sizeof(stat_group_names) / sizeof(stat_group_names[0]); i++) {
+        if(!(changed & (1u << i))) continue;
+        PyObject *name = PyStr_FromString(stat_group_names[i]);
+        if(!name || PySet_Add(res, name) < 0) {
+            Py_XDECREF(name);
+            Py_DECREF(res);
+            return NULL;
+        }
+        Py_DECREF(name);
+    }
+    return res;
 }
 
+static PyObject *Stat_view(pyStatChannel *s, PyObject *o);
+
 static PyMethodDef Stat_methods[] = {
-    {"poll", (PyCFunction)poll, METH_NOARGS, "Update current machine state"},
+    {"poll", (PyCFunction)poll, METH_NOARGS,
+        "Update current machine state.  Returns a frozenset naming the groups\n"
+        "of fields that changed since the last poll: 'stat', 'task', 'traj',\n"
+        "'joint', 'axis', 'spindle', 'motion', 'io' and 'tool_table'.  The\n"
+        "first poll reports every group."},
+    {"view", (PyCFunction)Stat_view, METH_O,
+        "view(name) -> memoryview of a status array without copying it.  The\n"
+        "view follows the values of the latest poll().  Names are the pose\n"
+        "attributes (position, actual_position, dtg, probed_position,\n"
+        "g5x_offset, g92_offset, tool_offset), joint_position,\n"
+        "joint_actual_position, joint_velocity, ain, aout, din, dout,\n"
+        "tool_id, tool_offset_table (pockets x 9) and tool_diameter."},
     {NULL}
 };
 
@@ -326,6 +472,9 @@ static PyMemberDef Stat_members[] = {
     {(char*)"rotation_xy", T_DOUBLE, O(task.rotation_xy), READONLY},
     {(char*)"delay_left", T_DOUBLE, O(task.delayLeft), READONLY},
     {(char*)"queued_mdi_commands", T_INT, O(task.queuedMDIcommands), READONLY, (char*)"Number of MDI commands queued waiting to run." },
+    {(char*)"task_cycle_time", T_DOUBLE, O(task.cycleTime), READONLY, (char*)"Length of the last task cycle in seconds, including the wait." },
+    {(char*)"task_work_time", T_DOUBLE, O(task.cycleWorkTime), READONLY, (char*)"Time the last task cycle spent working rather than waiting." },
+    {(char*)"motion_starvations", T_INT, O(task.motionStarvations), READONLY, (char*)"Times the motion queue ran empty while a program was being read." },
 
 // motion
 //   EMC_TRAJ_STAT traj
@@ -364,6 +513,13 @@ static PyMemberDef Stat_members[] = {
     {(char*)"adaptive_feed_enabled", T_BOOL, O(motion.traj.adaptive_feed_enabled), READONLY},
     {(char*)"feed_hold_enabled", T_BOOL, O(motion.traj.feed_hold_enabled), READONLY},
     {(char*)"num_extrajoints", T_INT, O(motion.numExtraJoints), READONLY},
+    {(char*)"status_reads", T_ULONG, O(motion.status_reads), READONLY,
+        (char*)"The number of times task has read the motion status."},
+    {(char*)"status_retries", T_ULONG, O(motion.status_retries), READONLY,
+        (char*)"The number of motion status reads that were torn by motion writing\n"
+        "at the same time and read again."},
+    {(char*)"status_failures", T_ULONG, O(motion.status_failures), READONLY,
+        (char*)"The number of motion status reads that stayed torn after every retry."},
 
 
 // EMC_SPINDLE_STAT motion.spindle
@@ -693,39 +849,234 @@ static PyObject *Stat_axes(pyStatChannel *s) {
 // XXX io.tool.toolTable
 // XXX EMC_JOINT_STAT motion.joint[]
 
+struct stat_cache_entry {
+    int slot;
+    PyObject *(*build)(pyStatChannel *);
+};
+
+static stat_cache_entry stat_cache_entries[STAT_CACHE_MAX] = {
+    {STAT_CACHE_POSITION, Stat_position},
+    {STAT_CACHE_ACTUAL, Stat_actual},
+    {STAT_CACHE_DTG, Stat_dtg},
+    {STAT_CACHE_PROBED, Stat_probed},
+    {STAT_CACHE_G5X_OFFSET, Stat_g5x_offset},
+    {STAT_CACHE_G92_OFFSET, Stat_g92_offset},
+    {STAT_CACHE_TOOL_OFFSET, Stat_tool_offset},
+    {STAT_CACHE_JOINT_POSITION, Stat_joint_position},
+    {STAT_CACHE_JOINT_ACTUAL, Stat_joint_actual},
+    {STAT_CACHE_LIMIT, Stat_limit},
+    {STAT_CACHE_HOMED, Stat_homed},
+    {STAT_CACHE_GCODES, Stat_activegcodes},
+    {STAT_CACHE_MCODES, Stat_activemcodes},
+    {STAT_CACHE_SETTINGS, Stat_activesettings},
+    {STAT_CACHE_DIN, Stat_din},
+    {STAT_CACHE_DOUT, Stat_dout},
+    {STAT_CACHE_AIN, Stat_ain},
+    {STAT_CACHE_AOUT, Stat_aout},
+    {STAT_CACHE_TOOL_TABLE, Stat_tool_table},
+};
+
+// Getter for the entries above: the same object is handed out until poll()
+// reports a change in its group, so reading stat.tool_table every cycle
+// doesn't rebuild all the tool entries.
+static PyObject *Stat_cached(pyStatChannel *s, void *closure) {
+    stat_cache_entry *e = (stat_cache_entry *)closure;
+    if(!s->cache[e->slot]) {
+        s->cache[e->slot] = e->build(s);
+        if(!s->cache[e->slot]) return NULL;
+    }
+    Py_INCREF(s->cache[e->slot]);
+    return s->cache[e->slot];
+}
+
+// stat.view(): memoryviews straight onto pyStatChannel.status.  The
+// exporter object holds a reference to the stat object, which keeps the
+// memory alive for as long as any view of it exists.
+struct pyStatArray {
+    PyObject_HEAD
+    PyObject *stat;
+    char *buf;
+    const char *format;
+    Py_ssize_t itemsize;
+    int ndim;
+    Py_ssize_t shape[2];
+    Py_ssize_t strides[2];
+};
+
+static int StatArray_getbuffer(pyStatArray *a, Py_buffer *view, int flags) {
+    if((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "stat views are read-only");
+        return -1;
+    }
+    if((flags & PyBUF_STRIDES) != PyBUF_STRIDES) {
+        PyErr_SetString(PyExc_BufferError, "stat views need strided buffers");
+        return -1;
+    }
+    view->obj = (PyObject *)a;
+    Py_INCREF(a);
+    view->buf = a->buf;
+    view->len = a->itemsize * a->shape[0] * (a->ndim > 1 ? a->shape[1] : 1);
+    view->readonly = 1;
+    view->itemsize = a->itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? (char *)a->format : NULL;
+    view->ndim = a->ndim;
+    view->shape = a->shape;
+    view->strides = a->strides;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+static void StatArray_dealloc(pyStatArray *a) {
+    Py_XDECREF(a->stat);
+    PyObject_Del(a);
+}
+
+static PyBufferProcs StatArray_as_buffer = {
+    (getbufferproc)StatArray_getbuffer,
+    (releasebufferproc)NULL,
+};
+
+static PyTypeObject StatArray_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "linuxcnc.stat_array",  /*tp_name*/
+    sizeof(pyStatArray),    /*tp_basicsize*/
+    0,                      /*tp_itemsize*/
+    /* methods */
+    (destructor)StatArray_dealloc, /*tp_dealloc*/
+    0,                      /*tp_print*/
+    0,                      /*tp_getattr*/
+    0,                      /*tp_setattr*/
+    0,                      /*tp_compare*/
+    0,                      /*tp_repr*/
+    0,                      /*tp_as_number*/
+    0,                      /*tp_as_sequence*/
+    0,                      /*tp_as_mapping*/
+    0,                      /*tp_hash*/
+    0,                      /*tp_call*/
+    0,                      /*tp_str*/
+    0,                      /*tp_getattro*/
+    0,                      /*tp_setattro*/
+    &StatArray_as_buffer,   /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,     /*tp_flags*/
+    0,                      /*tp_doc*/
+};
+
+static PyObject *stat_array(pyStatChannel *s, void *base, const char *format,
+        Py_ssize_t itemsize, Py_ssize_t n, Py_ssize_t stride,
+        Py_ssize_t m = 0, Py_ssize_t inner_stride = 0) {
+    pyStatArray *a = PyObject_New(pyStatArray, &StatArray_Type);
+    if(!a) return NULL;
+    Py_INCREF(s);
+    a->stat = (PyObject *)s;
+    a->buf = (char *)base;
+    a->format = format;
+    a->itemsize = itemsize;
+    a->ndim = m ? 2 : 1;
+    a->shape[0] = n;
+    a->strides[0] = stride;
+    a->shape[1] = m;
+    a->strides[1] = inner_stride;
+    PyObject *res = PyMemoryView_FromObject((PyObject *)a);
+    Py_DECREF(a);
+    return res;
+}
+
+static PyObject *pose_array(pyStatChannel *s, EmcPose &p) {
+    return stat_array(s, &p, "d", sizeof(double), 9, sizeof(double));
+}
+
+static PyObject *Stat_view(pyStatChannel *s, PyObject *o) {
+    const char *name = PyStr_AsString(o);
+    if(!name) return NULL;
+
+    EMC_STAT &st = s->status;
+    if(!strcmp(name, "position"))
+        return pose_array(s, st.motion.traj.position);
+    if(!strcmp(name, "actual_position"))
+        return pose_array(s, st.motion.traj.actualPosition);
+    if(!strcmp(name, "dtg"))
+        return pose_array(s, st.motion.traj.dtg);
+    if(!strcmp(name, "probed_position"))
+        return pose_array(s, st.motion.traj.probedPosition);
+    if(!strcmp(name, "g5x_offset"))
+        return pose_array(s, st.task.g5x_offset);
+    if(!strcmp(name, "g92_offset"))
+        return pose_array(s, st.task.g92_offset);
+    if(!strcmp(name, "tool_offset"))
+        return pose_array(s, st.task.toolOffset);
+    if(!strcmp(name, "joint_position"))
+        return stat_array(s, &st.motion.joint[0].output, "d", sizeof(double),
+                EMCMOT_MAX_JOINTS, sizeof(EMC_JOINT_STAT));
+    if(!strcmp(name, "joint_actual_position"))
+        return stat_array(s, &st.motion.joint[0].input, "d", sizeof(double),
+                EMCMOT_MAX_JOINTS, sizeof(EMC_JOINT_STAT));
+    if(!strcmp(name, "joint_velocity"))
+        return stat_array(s, &st.motion.joint[0].velocity, "d", sizeof(double),
+                EMCMOT_MAX_JOINTS, sizeof(EMC_JOINT_STAT));
+    if(!strcmp(name, "ain"))
+        return stat_array(s, st.motion.analog_input, "d", sizeof(double),
+                EMCMOT_MAX_AIO, sizeof(double));
+    if(!strcmp(name, "aout"))
+        return stat_array(s, st.motion.analog_output, "d", sizeof(double),
+                EMCMOT_MAX_AIO, sizeof(double));
+    if(!strcmp(name, "din"))
+        return stat_array(s, st.motion.synch_di, "i", sizeof(int),
+                EMCMOT_MAX_DIO, sizeof(int));
+    if(!strcmp(name, "dout"))
+        return stat_array(s, st.motion.synch_do, "i", sizeof(int),
+                EMCMOT_MAX_DIO, sizeof(int));
+    if(!strcmp(name, "tool_id"))
+        return stat_array(s, &st.io.tool.toolTable[0].toolno, "i", sizeof(int),
+                CANON_POCKETS_MAX, sizeof(CANON_TOOL_TABLE));
+    if(!strcmp(name, "tool_offset_table"))
+        return stat_array(s, &st.io.tool.toolTable[0].offset, "d", sizeof(double),
+                CANON_POCKETS_MAX, sizeof(CANON_TOOL_TABLE), 9, sizeof(double));
+    if(!strcmp(name, "tool_diameter"))
+        return stat_array(s, &st.io.tool.toolTable[0].diameter, "d", sizeof(double),
+                CANON_POCKETS_MAX, sizeof(CANON_TOOL_TABLE));
+
+    PyErr_Format(PyExc_KeyError, "%s", name);
+    return NULL;
+}
+
+#define C(x) (void *)&stat_cache_entries[STAT_CACHE_##x]
 static PyGetSetDef Stat_getsetlist[] = {
-    {(char*)"actual_position", (getter)Stat_actual},
-    {(char*)"ain", (getter)Stat_ain},
-    {(char*)"aout", (getter)Stat_aout},
+    {(char*)"actual_position", (getter)Stat_cached, (setter)NULL, NULL, C(ACTUAL)},
+    {(char*)"ain", (getter)Stat_cached, (setter)NULL, NULL, C(AIN)},
+    {(char*)"aout", (getter)Stat_cached, (setter)NULL, NULL, C(AOUT)},
     {(char*)"joint", (getter)Stat_joint},
     {(char*)"axis", (getter)Stat_axis},
     {(char*)"spindle", (getter)Stat_spindle},
-    {(char*)"din", (getter)Stat_din},
-    {(char*)"dout", (getter)Stat_dout},
-    {(char*)"gcodes", (getter)Stat_activegcodes},
-    {(char*)"homed", (getter)Stat_homed},
-    {(char*)"limit", (getter)Stat_limit},
-    {(char*)"mcodes", (getter)Stat_activemcodes},
-    {(char*)"g5x_offset", (getter)Stat_g5x_offset},
+    {(char*)"din", (getter)Stat_cached, (setter)NULL, NULL, C(DIN)},
+    {(char*)"dout", (getter)Stat_cached, (setter)NULL, NULL, C(DOUT)},
+    {(char*)"gcodes", (getter)Stat_cached, (setter)NULL, NULL, C(GCODES)},
+    {(char*)"homed", (getter)Stat_cached, (setter)NULL, NULL, C(HOMED)},
+    {(char*)"limit", (getter)Stat_cached, (setter)NULL, NULL, C(LIMIT)},
+    {(char*)"mcodes", (getter)Stat_cached, (setter)NULL, NULL, C(MCODES)},
+    {(char*)"g5x_offset", (getter)Stat_cached, (setter)NULL, NULL, C(G5X_OFFSET)},
     {(char*)"g5x_index", (getter)Stat_g5x_index},
-    {(char*)"g92_offset", (getter)Stat_g92_offset},
-    {(char*)"position", (getter)Stat_position},
-    {(char*)"dtg", (getter)Stat_dtg},
-    {(char*)"joint_position", (getter)Stat_joint_position},
-    {(char*)"joint_actual_position", (getter)Stat_joint_actual},
-    {(char*)"probed_position", (getter)Stat_probed},
-    {(char*)"settings", (getter)Stat_activesettings, (setter)NULL,
+    {(char*)"g92_offset", (getter)Stat_cached, (setter)NULL, NULL, C(G92_OFFSET)},
+    {(char*)"position", (getter)Stat_cached, (setter)NULL, NULL, C(POSITION)},
+    {(char*)"dtg", (getter)Stat_cached, (setter)NULL, NULL, C(DTG)},
+    {(char*)"joint_position", (getter)Stat_cached, (setter)NULL, NULL, C(JOINT_POSITION)},
+    {(char*)"joint_actual_position", (getter)Stat_cached, (setter)NULL, NULL, C(JOINT_ACTUAL)},
+    {(char*)"probed_position", (getter)Stat_cached, (setter)NULL, NULL, C(PROBED)},
+    {(char*)"settings", (getter)Stat_cached, (setter)NULL,
         (char*)"This is an array containing the Interp active settings: sequence number,\n"
-        "feed rate, spindle speed, and G64 blend and naive CAM tolerances."
+        "feed rate, spindle speed, and G64 blend and naive CAM tolerances.",
+        C(SETTINGS)
     },
-    {(char*)"tool_offset", (getter)Stat_tool_offset},
-    {(char*)"tool_table", (getter)Stat_tool_table, (setter)NULL,
+    {(char*)"tool_offset", (getter)Stat_cached, (setter)NULL, NULL, C(TOOL_OFFSET)},
+    {(char*)"tool_table", (getter)Stat_cached, (setter)NULL,
         (char*)"The tooltable, expressed as a list of tools.  Each tool is a dict with the\n"
-        "tool id (tool number), diameter, offsets, etc."
+        "tool id (tool number), diameter, offsets, etc.",
+        C(TOOL_TABLE)
     },
     {(char*)"axes", (getter)Stat_axes},
     {NULL}
 };
+#undef C
 
 static PyTypeObject Stat_Type = {
     PyVarObject_HEAD_INIT(NULL, 0)
@@ -2212,6 +2563,7 @@ MODULE_INIT_FUNC(linuxcnc)
     clear_rcs_print_flag(~0);
 
     PyType_Ready(&Stat_Type);
+    PyType_Ready(&StatArray_Type);
     PyType_Ready(&Command_Type);
     PyType_Ready(&Error_Type);
     PyType_Ready(&Ini_Type);
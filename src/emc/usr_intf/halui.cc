@@ -21,6 +21,8 @@
 #include <stdlib.h>
 #include <signal.h>
 #include <math.h>
+#include <map>
+#include <vector>
 
 #include "hal.h"		/* access to HAL functions/definitions */
 #include "rtapi.h"		/* rtapi_print_msg */
@@ -197,6 +199,9 @@ static int axis_mask = 0;
     ARRAY(hal_bit_t,mdi_commands,MDI_MAX) \
 \
     FIELD(hal_float_t,units_per_mm) \
+\
+    FIELD(hal_float_t,latency_last) /* seconds from input change to Task echo, last command */ \
+    FIELD(hal_float_t,latency_max) /* the same, worst case since startup */ \
 
 struct PTR {
     template<class T>
@@ -263,11 +268,64 @@ static double receiveTimeout = 5.0;
 // how long to wait for Task to finish running our command
 static double doneTimeout = 60.;
 
+// how often the main loop looks at the input pins and the status
+// buffer; [HALUI]CYCLE_TIME, defaulting to [TASK]CYCLE_TIME
+static double halui_cycle_time = 0.02;
+
+// The input pins are grouped by the handler that acts on them
+enum {
+    HALUI_TASK_PINS = 1,	// machine, estop, mode, coolant, program
+    HALUI_OVERRIDE_PINS = 2,	// max-velocity and the overrides
+    HALUI_SPINDLE_PINS = 4,
+    HALUI_JOINT_PINS = 8,
+    HALUI_AXIS_PINS = 16,
+    HALUI_MDI_PINS = 32,
+    HALUI_ALL_PINS = 63
+};
+
+// The input pins of this component.  The main loop compares them with
+// the values it saw last time and only runs the handlers of the groups
+// in which one has changed.  'pin' is the address of the pin pointer
+// in halui_data, which changes when the pin is linked to a signal.
+struct halui_watch {
+    unsigned group;
+    hal_type_t type;
+    union {
+	hal_bit_t **b;
+	hal_s32_t **s;
+	hal_float_t **f;
+    } pin;
+    union {
+	bool b;
+	rtapi_s32 s;
+	double f;
+    } last;
+};
+static std::vector<halui_watch> watched_pins;
+
+// set by updateStatus() when a new status message has been read
+static bool emcStatusNew = false;
+
+// Time from noticing an input change to Task echoing the command it
+// caused, per NML command type.  Dumped to stdout on SIGUSR1.
+struct halui_latency {
+    unsigned long count;
+    double total, max;
+};
+static std::map<NMLTYPE, halui_latency> command_latency;
+static double input_change_time = 0.0;
+static volatile sig_atomic_t report_latency = 0;
+
 static void quit(int sig)
 {
     done = 1;
 }
 
+static void request_latency_report(int sig)
+{
+    report_latency = 1;
+}
+
 static int emcTaskNmlGet()
 {
     int retval = 0;
@@ -397,7 +455,10 @@ static int updateStatus()
 	break;
 
     case 0:			// no new data
+	break;
+
     case EMC_STAT_TYPE:	// new data
+	emcStatusNew = true;
 	break;
 
     default:
@@ -441,6 +502,35 @@ static int emcCommandWaitDone()
     return -1;
 }
 
+static void record_latency(NMLTYPE type)
+{
+    double latency = etime() - input_change_time;
+    halui_latency &l = command_latency[type];
+
+    l.count++;
+    l.total += latency;
+    if (latency > l.max) {
+	l.max = latency;
+    }
+    *(halui_data->latency_last) = latency;
+    if (latency > *(halui_data->latency_max)) {
+	*(halui_data->latency_max) = latency;
+    }
+}
+
+static void print_latency_report()
+{
+    printf("halui: command latency (input change to Task echo)\n");
+    printf("%-32s %8s %10s %10s\n", "command", "count", "avg ms", "max ms");
+    for (std::map<NMLTYPE, halui_latency>::const_iterator i = command_latency.begin();
+	    i != command_latency.end(); ++i) {
+	const halui_latency &l = i->second;
+	printf("%-32s %8lu %10.3f %10.3f\n", emc_symbol_lookup(i->first),
+	    l.count, l.total / l.count * 1000.0, l.max * 1000.0);
+    }
+    fflush(stdout);
+}
+
 static int emcCommandSend(RCS_CMD_MSG & cmd)
 {
     // write command
@@ -457,6 +547,7 @@ static int emcCommandSend(RCS_CMD_MSG & cmd)
 	int serial_diff = emcStatus->echo_serial_number - emcCommandSerialNumber;
 
 	if (serial_diff >= 0) {
+	    record_latency(cmd.type);
 	    return 0;
 	}
 
@@ -933,10 +1024,187 @@ int halui_hal_init(void)
         if (retval < 0) return retval;
     }
 
+    retval = hal_pin_float_newf(HAL_OUT, &(halui_data->latency_last), comp_id, "halui.latency.last");
+    if (retval < 0) return retval;
+    retval = hal_pin_float_newf(HAL_OUT, &(halui_data->latency_max), comp_id, "halui.latency.max");
+    if (retval < 0) return retval;
+
     hal_ready(comp_id);
     return 0;
 }
 
+static void watch_pin(unsigned group, hal_bit_t **pin)
+{
+    halui_watch w;
+    w.group = group;
+    w.type = HAL_BIT;
+    w.pin.b = pin;
+    w.last.b = **pin;
+    watched_pins.push_back(w);
+}
+
+static void watch_pin(unsigned group, hal_s32_t **pin)
+{
+    halui_watch w;
+    w.group = group;
+    w.type = HAL_S32;
+    w.pin.s = pin;
+    w.last.s = **pin;
+    watched_pins.push_back(w);
+}
+
+static void watch_pin(unsigned group, hal_float_t **pin)
+{
+    halui_watch w;
+    w.group = group;
+    w.type = HAL_FLOAT;
+    w.pin.f = pin;
+    w.last.f = **pin;
+    watched_pins.push_back(w);
+}
+
+// collect the input pins exported by halui_hal_init() for
+// hal_inputs_changed(), each in the group of the handler that reads it
+static void watch_input_pins()
+{
+    int joint, spindle, axis_num;
+
+    watch_pin(HALUI_TASK_PINS, &(halui_data->machine_on));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->machine_off));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->estop_activate));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->estop_reset));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->mode_manual));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->mode_auto));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->mode_mdi));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->mode_teleop));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->mode_joint));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->mist_on));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->mist_off));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->flood_on));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->flood_off));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->lube_on));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->lube_off));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->program_run));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->program_pause));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->program_resume));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->program_step));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->program_stop));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->program_os_on));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->program_os_off));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->program_bd_on));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->program_bd_off));
+    watch_pin(HALUI_TASK_PINS, &(halui_data->abort));
+    if (have_home_all) {
+	watch_pin(HALUI_TASK_PINS, &(halui_data->home_all));
+    }
+
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->mv_counts));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->mv_count_enable));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->mv_direct_value));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->mv_scale));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->mv_increase));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->mv_decrease));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->fo_counts));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->fo_count_enable));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->fo_direct_value));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->fo_scale));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->fo_increase));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->fo_decrease));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->ro_counts));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->ro_count_enable));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->ro_direct_value));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->ro_scale));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->ro_increase));
+    watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->ro_decrease));
+
+    for (spindle = 0; spindle < num_spindles; spindle++) {
+	watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->so_counts[spindle]));
+	watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->so_count_enable[spindle]));
+	watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->so_direct_value[spindle]));
+	watch_pin(HALUI_OVERRIDE_PINS, &(halui_data->so_scale[spindle]));
+	watch_pin(HALUI_SPINDLE_PINS, &(halui_data->so_increase[spindle]));
+	watch_pin(HALUI_SPINDLE_PINS, &(halui_data->so_decrease[spindle]));
+	watch_pin(HALUI_SPINDLE_PINS, &(halui_data->spindle_start[spindle]));
+	watch_pin(HALUI_SPINDLE_PINS, &(halui_data->spindle_stop[spindle]));
+	watch_pin(HALUI_SPINDLE_PINS, &(halui_data->spindle_forward[spindle]));
+	watch_pin(HALUI_SPINDLE_PINS, &(halui_data->spindle_reverse[spindle]));
+	watch_pin(HALUI_SPINDLE_PINS, &(halui_data->spindle_increase[spindle]));
+	watch_pin(HALUI_SPINDLE_PINS, &(halui_data->spindle_decrease[spindle]));
+	watch_pin(HALUI_SPINDLE_PINS, &(halui_data->spindle_brake_on[spindle]));
+	watch_pin(HALUI_SPINDLE_PINS, &(halui_data->spindle_brake_off[spindle]));
+    }
+
+    /* index num_joints is the selected joint */
+    for (joint = 0; joint <= num_joints; joint++) {
+	watch_pin(HALUI_JOINT_PINS, &(halui_data->joint_home[joint]));
+	watch_pin(HALUI_JOINT_PINS, &(halui_data->joint_unhome[joint]));
+	watch_pin(HALUI_JOINT_PINS, &(halui_data->jjog_plus[joint]));
+	watch_pin(HALUI_JOINT_PINS, &(halui_data->jjog_minus[joint]));
+	watch_pin(HALUI_JOINT_PINS, &(halui_data->jjog_increment[joint]));
+	watch_pin(HALUI_JOINT_PINS, &(halui_data->jjog_increment_plus[joint]));
+	watch_pin(HALUI_JOINT_PINS, &(halui_data->jjog_increment_minus[joint]));
+	if (joint < num_joints) {
+	    watch_pin(HALUI_JOINT_PINS, &(halui_data->joint_nr_select[joint]));
+	    watch_pin(HALUI_JOINT_PINS, &(halui_data->jjog_analog[joint]));
+	}
+    }
+    watch_pin(HALUI_JOINT_PINS, &(halui_data->jjog_speed));
+    watch_pin(HALUI_JOINT_PINS, &(halui_data->jjog_deadband));
+
+    /* index EMCMOT_MAX_AXIS is the selected axis */
+    for (axis_num = 0; axis_num <= EMCMOT_MAX_AXIS; axis_num++) {
+	watch_pin(HALUI_AXIS_PINS, &(halui_data->ajog_plus[axis_num]));
+	watch_pin(HALUI_AXIS_PINS, &(halui_data->ajog_minus[axis_num]));
+	watch_pin(HALUI_AXIS_PINS, &(halui_data->ajog_increment[axis_num]));
+	watch_pin(HALUI_AXIS_PINS, &(halui_data->ajog_increment_plus[axis_num]));
+	watch_pin(HALUI_AXIS_PINS, &(halui_data->ajog_increment_minus[axis_num]));
+	if (axis_num < EMCMOT_MAX_AXIS) {
+	    watch_pin(HALUI_AXIS_PINS, &(halui_data->axis_nr_select[axis_num]));
+	    watch_pin(HALUI_AXIS_PINS, &(halui_data->ajog_analog[axis_num]));
+	}
+    }
+    watch_pin(HALUI_AXIS_PINS, &(halui_data->ajog_speed));
+    watch_pin(HALUI_AXIS_PINS, &(halui_data->ajog_deadband));
+
+    for (int n = 0; n < num_mdi_commands; n++) {
+	watch_pin(HALUI_MDI_PINS, &(halui_data->mdi_commands[n]));
+    }
+}
+
+// returns the groups with an input pin that differs from the last call
+static unsigned hal_inputs_changed()
+{
+    unsigned changed = 0;
+
+    for (size_t n = 0; n < watched_pins.size(); n++) {
+	halui_watch &w = watched_pins[n];
+
+	switch (w.type) {
+	case HAL_BIT:
+	    if (**w.pin.b != w.last.b) {
+		w.last.b = **w.pin.b;
+		changed |= w.group;
+	    }
+	    break;
+	case HAL_S32:
+	    if (**w.pin.s != w.last.s) {
+		w.last.s = **w.pin.s;
+		changed |= w.group;
+	    }
+	    break;
+	case HAL_FLOAT:
+	    if (**w.pin.f != w.last.f) {
+		w.last.f = **w.pin.f;
+		changed |= w.group;
+	    }
+	    break;
+	default:
+	    break;
+	}
+    }
+    return changed;
+}
+
 static int sendMachineOn()
 {
     EMC_TASK_SET_STATE state_msg;
@@ -1498,6 +1766,22 @@ static int iniLoad(const char *filename)
 	}
     }
 
+    // Task's cycle is how often a new status can show up, so there is
+    // no point looking more often than that unless asked to
+    if (NULL != (inistring = inifile.Find("CYCLE_TIME", "TASK"))) {
+	if (1 == sscanf(inistring, "%lf", &d) && d > 0.0) {
+	    halui_cycle_time = d;
+	}
+    }
+    if (NULL != (inistring = inifile.Find("CYCLE_TIME", "HALUI"))) {
+	if (1 == sscanf(inistring, "%lf", &d) && d > 0.0) {
+	    halui_cycle_time = d;
+	}
+    }
+    if (halui_cycle_time < 0.001) {
+	halui_cycle_time = 0.001;
+    }
+
     const char *mc;
     while(num_mdi_commands < MDI_MAX && (mc = inifile.Find("MDI_COMMAND", "HALUI", num_mdi_commands+1))) {
         mdi_commands[num_mdi_commands++] = strdup(mc);
@@ -1618,24 +1902,14 @@ static bool jogging_selected_axis(local_halui_str &hal) {
 }
 
 
-// this function looks if any of the hal pins has changed
-// and sends appropiate messages if so
-static void check_hal_changes()
-{
-    hal_s32_t counts;
-    int jselect_changed, joint;
-    int aselect_changed, axis_num;
-    hal_bit_t bit;
-    int js;
-    hal_float_t floatt;
-    int jjog_speed_changed;
-    int ajog_speed_changed;
-
-    local_halui_str new_halui_data_mutable;
-    copy_hal_data(*halui_data, new_halui_data_mutable);
-    const local_halui_str &new_halui_data = new_halui_data_mutable;
-
+// The handlers below look at the hal pins of one group each and send
+// the appropiate messages for those that have changed.  Each group is
+// only looked at when one of its pins has changed, see
+// hal_inputs_changed().
 
+// machine, estop, mode, coolant and program pins
+static void check_task_changes(const local_halui_str &new_halui_data)
+{
     //check if machine_on pin has changed (the rest work exactly the same)
     if (check_bit_changed(new_halui_data.machine_on, old_halui_data.machine_on) != 0)
 	sendMachineOn();                //send MachineOn NML command
@@ -1709,6 +1983,18 @@ static void check_hal_changes()
     if (check_bit_changed(new_halui_data.program_stop, old_halui_data.program_stop) != 0)
 	sendAbort();
 
+    if (check_bit_changed(new_halui_data.abort, old_halui_data.abort) != 0)
+	sendAbort();
+
+    if (check_bit_changed(new_halui_data.home_all, old_halui_data.home_all) != 0)
+	sendHome(-1);
+}
+
+// max-velocity, feed, rapid and spindle override pins
+static void check_override_changes(const local_halui_str &new_halui_data)
+{
+    hal_s32_t counts;
+
     //max-velocity stuff
     counts = new_halui_data.mv_counts;
     if (counts != old_halui_data.mv_counts) {
@@ -1781,6 +2067,12 @@ static void check_hal_changes()
         sendRapidOverride(new_halui_data.ro_value + new_halui_data.ro_scale);
     if (check_bit_changed(new_halui_data.ro_decrease, old_halui_data.ro_decrease) != 0)
         sendRapidOverride(new_halui_data.ro_value - new_halui_data.ro_scale);
+}
+
+// spindle pins
+static void check_spindle_changes(const local_halui_str &new_halui_data)
+{
+    hal_bit_t bit;
 
 	// spindle stuff
     for (int spindle = 0; spindle < num_spindles; spindle++){
@@ -1825,12 +2117,16 @@ static void check_hal_changes()
 		if (check_bit_changed(new_halui_data.spindle_brake_off[spindle], old_halui_data.spindle_brake_off[spindle]) != 0)
 		sendBrakeRelease(spindle);
     }
+}
 
-	if (check_bit_changed(new_halui_data.abort, old_halui_data.abort) != 0)
-	sendAbort();
-
-	if (check_bit_changed(new_halui_data.home_all, old_halui_data.home_all) != 0)
-	sendHome(-1);
+// joint homing, selection and jog pins
+static void check_joint_changes(const local_halui_str &new_halui_data)
+{
+    hal_bit_t bit;
+    int jselect_changed, joint;
+    int js;
+    hal_float_t floatt;
+    int jjog_speed_changed;
 
 // joint stuff (selection, homing..)
     jselect_changed = -1; // flag to see if the selected joint changed
@@ -1843,18 +2139,6 @@ static void check_hal_changes()
     } else {
         jjog_speed_changed = 0;
     }
-// axis stuff (selection, homing..)
-    aselect_changed = -1; // flag to see if the selected joint changed
-
-    // if the jog-speed changes while in a continuous jog, we want to
-    // re-start the jog with the new speed
-    if (fabs(old_halui_data.ajog_speed - new_halui_data.ajog_speed) > 0.00001) {
-        old_halui_data.ajog_speed = new_halui_data.ajog_speed;
-        ajog_speed_changed = 1;
-    } else {
-        ajog_speed_changed = 0;
-    }
-
     for (joint=0; joint < num_joints; joint++) {
 	if (check_bit_changed(new_halui_data.joint_home[joint], old_halui_data.joint_home[joint]) != 0)
 	    sendHome(joint);
@@ -1934,6 +2218,70 @@ static void check_hal_changes()
 	}
     }
 
+    if (check_bit_changed(new_halui_data.joint_home[num_joints], old_halui_data.joint_home[num_joints]) != 0)
+	sendHome(new_halui_data.joint_selected);
+
+    if (check_bit_changed(new_halui_data.joint_unhome[num_joints], old_halui_data.joint_unhome[num_joints]) != 0)
+	sendUnhome(new_halui_data.joint_selected);
+
+    bit = new_halui_data.jjog_minus[num_joints];
+    js = new_halui_data.joint_selected;
+    if ((bit != old_halui_data.jjog_minus[num_joints]) || (bit && jjog_speed_changed)) {
+        if (bit != 0)
+	    sendJogCont(js, -new_halui_data.jjog_speed,JOGJOINT);
+	else
+	    sendJogStop(js,JOGJOINT);
+	old_halui_data.jjog_minus[num_joints] = bit;
+    }
+
+    bit = new_halui_data.jjog_plus[num_joints];
+    js = new_halui_data.joint_selected;
+    if ((bit != old_halui_data.jjog_plus[num_joints]) || (bit && jjog_speed_changed)) {
+        if (bit != 0)
+	    sendJogCont(js,new_halui_data.jjog_speed,JOGJOINT);
+	else
+	    sendJogStop(js,JOGJOINT);
+	old_halui_data.jjog_plus[num_joints] = bit;
+    }
+
+    bit = new_halui_data.jjog_increment_plus[num_joints];
+    js = new_halui_data.joint_selected;
+    if (bit != old_halui_data.jjog_increment_plus[num_joints]) {
+	if (bit)
+	    sendJogIncr(js, new_halui_data.jjog_speed, new_halui_data.jjog_increment[num_joints],JOGJOINT);
+	old_halui_data.jjog_increment_plus[num_joints] = bit;
+    }
+
+    bit = new_halui_data.jjog_increment_minus[num_joints];
+    js = new_halui_data.joint_selected;
+    if (bit != old_halui_data.jjog_increment_minus[num_joints]) {
+	if (bit)
+	    sendJogIncr(js, new_halui_data.jjog_speed, -(new_halui_data.jjog_increment[num_joints]),JOGJOINT);
+	old_halui_data.jjog_increment_minus[num_joints] = bit;
+    }
+}
+
+// axis selection and jog pins
+static void check_axis_changes(const local_halui_str &new_halui_data)
+{
+    hal_bit_t bit;
+    int aselect_changed, axis_num;
+    int js;
+    hal_float_t floatt;
+    int ajog_speed_changed;
+
+// axis stuff (selection, homing..)
+    aselect_changed = -1; // flag to see if the selected joint changed
+
+    // if the jog-speed changes while in a continuous jog, we want to
+    // re-start the jog with the new speed
+    if (fabs(old_halui_data.ajog_speed - new_halui_data.ajog_speed) > 0.00001) {
+        old_halui_data.ajog_speed = new_halui_data.ajog_speed;
+        ajog_speed_changed = 1;
+    } else {
+        ajog_speed_changed = 0;
+    }
+
     for (axis_num = 0; axis_num < EMCMOT_MAX_AXIS; axis_num++) {
         if ( !(axis_mask & (1 << axis_num)) ) { continue; }
 	bit = new_halui_data.ajog_minus[axis_num];
@@ -2008,48 +2356,6 @@ static void check_hal_changes()
 	}
     }
 
-    if (check_bit_changed(new_halui_data.joint_home[num_joints], old_halui_data.joint_home[num_joints]) != 0)
-	sendHome(new_halui_data.joint_selected);
-
-    if (check_bit_changed(new_halui_data.joint_unhome[num_joints], old_halui_data.joint_unhome[num_joints]) != 0)
-	sendUnhome(new_halui_data.joint_selected);
-
-    bit = new_halui_data.jjog_minus[num_joints];
-    js = new_halui_data.joint_selected;
-    if ((bit != old_halui_data.jjog_minus[num_joints]) || (bit && jjog_speed_changed)) {
-        if (bit != 0)
-	    sendJogCont(js, -new_halui_data.jjog_speed,JOGJOINT);
-	else
-	    sendJogStop(js,JOGJOINT);
-	old_halui_data.jjog_minus[num_joints] = bit;
-    }
-
-    bit = new_halui_data.jjog_plus[num_joints];
-    js = new_halui_data.joint_selected;
-    if ((bit != old_halui_data.jjog_plus[num_joints]) || (bit && jjog_speed_changed)) {
-        if (bit != 0)
-	    sendJogCont(js,new_halui_data.jjog_speed,JOGJOINT);
-	else
-	    sendJogStop(js,JOGJOINT);
-	old_halui_data.jjog_plus[num_joints] = bit;
-    }
-
-    bit = new_halui_data.jjog_increment_plus[num_joints];
-    js = new_halui_data.joint_selected;
-    if (bit != old_halui_data.jjog_increment_plus[num_joints]) {
-	if (bit)
-	    sendJogIncr(js, new_halui_data.jjog_speed, new_halui_data.jjog_increment[num_joints],JOGJOINT);
-	old_halui_data.jjog_increment_plus[num_joints] = bit;
-    }
-
-    bit = new_halui_data.jjog_increment_minus[num_joints];
-    js = new_halui_data.joint_selected;
-    if (bit != old_halui_data.jjog_increment_minus[num_joints]) {
-	if (bit)
-	    sendJogIncr(js, new_halui_data.jjog_speed, -(new_halui_data.jjog_increment[num_joints]),JOGJOINT);
-	old_halui_data.jjog_increment_minus[num_joints] = bit;
-    }
-
     bit = new_halui_data.ajog_minus[EMCMOT_MAX_AXIS];
     js = new_halui_data.axis_selected;
     if ((bit != old_halui_data.ajog_minus[EMCMOT_MAX_AXIS]) || (bit && ajog_speed_changed)) {
@@ -2085,13 +2391,38 @@ static void check_hal_changes()
 	    sendJogIncr(js, new_halui_data.ajog_speed, -(new_halui_data.ajog_increment[EMCMOT_MAX_AXIS]),JOGTELEOP);
 	old_halui_data.ajog_increment_minus[EMCMOT_MAX_AXIS] = bit;
     }
+}
 
+// MDI command pins
+static void check_mdi_changes(const local_halui_str &new_halui_data)
+{
     for(int n = 0; n < num_mdi_commands; n++) {
         if (check_bit_changed(new_halui_data.mdi_commands[n], old_halui_data.mdi_commands[n]) != 0)
             sendMdiCommand(n);
     }
 }
 
+// runs the handlers of the groups of pins in 'changed'
+static void check_hal_changes(unsigned changed)
+{
+    local_halui_str new_halui_data_mutable;
+    copy_hal_data(*halui_data, new_halui_data_mutable);
+    const local_halui_str &new_halui_data = new_halui_data_mutable;
+
+    if (changed & HALUI_TASK_PINS)
+	check_task_changes(new_halui_data);
+    if (changed & HALUI_OVERRIDE_PINS)
+	check_override_changes(new_halui_data);
+    if (changed & HALUI_SPINDLE_PINS)
+	check_spindle_changes(new_halui_data);
+    if (changed & HALUI_JOINT_PINS)
+	check_joint_changes(new_halui_data);
+    if (changed & HALUI_AXIS_PINS)
+	check_axis_changes(new_halui_data);
+    if (changed & HALUI_MDI_PINS)
+	check_mdi_changes(new_halui_data);
+}
+
 // this function looks at the received NML status message
 // and modifies the appropiate HAL pins
 static void modify_hal_pins()
@@ -2308,6 +2639,7 @@ int main(int argc, char *argv[])
 
     //initialize safe values
     hal_init_pins();
+    watch_input_pins();
 
     // init NML
     if (0 != tryNml()) {
@@ -2325,7 +2657,13 @@ int main(int argc, char *argv[])
     signal(SIGINT, quit);
     /* catch SIGTERM too - the run script uses it to shut things down */
     signal(SIGTERM, quit);
+    signal(SIGUSR1, request_latency_report);
 
+    // The inputs are compared with their last values every cycle, which
+    // is cheap, and a handler in check_hal_changes() only runs when one
+    // of the pins it reads has changed.  The status pins are only rewritten when
+    // Task has published a new status.
+    bool first = true;
     while (!done) {
         static bool task_start_synced = 0;
         if (!task_start_synced) {
@@ -2336,9 +2674,21 @@ int main(int argc, char *argv[])
               task_start_synced = 1;
            }
         }
-        check_hal_changes(); //if anything changed send NML messages
-        modify_hal_pins(); //if status changed modify HAL too
-        esleep(0.02); //sleep for a while
+        unsigned changed = first ? HALUI_ALL_PINS : hal_inputs_changed();
+        if (changed) {
+            input_change_time = etime();
+            check_hal_changes(changed); //if anything changed send NML messages
+        }
+        if (emcStatusNew || first) {
+            emcStatusNew = false;
+            modify_hal_pins(); //if status changed modify HAL too
+        }
+        first = false;
+        if (report_latency) {
+            report_latency = 0;
+            print_latency_report();
+        }
+        esleep(halui_cycle_time);
         updateStatus();
     }
     thisQuit();
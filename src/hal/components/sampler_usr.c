@@ -20,7 +20,7 @@
 
     Invoking:
 
-    halsampler [-c chan_num] [-n num_samples] [-t]
+    halsampler [-c chan_num] [-n num_samples] [-t] [-b] [-r records] [file]
 
     'chan_num', if present, specifies the sampler channel to use.
     The default is channel zero.
@@ -32,6 +32,18 @@
     '-t' tells sampler to print the sample number at the start
     of each line.
 
+    '-b' writes fixed size binary records (see streamer_file.h)
+    instead of text.  This avoids the cost of formatting every
+    value, which is what limits text capture of fast threads.
+
+    '-r records' writes binary records into a memory mapped ring
+    file that holds the newest 'records' samples; 'file' is
+    required.  The capture can run forever in a fixed amount of
+    disk, and the file can be replayed with 'halstreamer -r'.
+
+    In the binary modes overruns are reported on stderr, since a
+    line in the output would corrupt the records.
+
 */
 
 /** This program is free software; you can redistribute it and/or
@@ -73,6 +85,7 @@
 #include "rtapi.h"		/* RTAPI realtime OS API */
 #include "hal.h"                /* HAL public API decls */
 #include "streamer.h"
+#include "streamer_file.h"
 
 /***********************************************************************
 *                  LOCAL FUNCTION DECLARATIONS                         *
@@ -103,19 +116,61 @@ static void quit(int sig)
 }
 
 #define BUF_SIZE 4000
+/* samples taken from the stream per call */
+#define SAMPLE_BATCH 256
+
+enum { MODE_TEXT, MODE_BINARY, MODE_RING };
+
+static int print_sample(hal_stream_t *stream, union hal_stream_data *buf,
+    int tag, unsigned this_sample)
+{
+    int n, num_pins = hal_stream_element_count(stream);
+
+    if ( tag ) {
+	printf ( "%d ", this_sample-1 );
+    }
+    for ( n = 0 ; n < num_pins; n++ ) {
+	switch ( hal_stream_element_type(stream, n) ) {
+	case HAL_FLOAT:
+	    printf ( "%f ", buf[n].f);
+	    break;
+	case HAL_BIT:
+	    if ( buf[n].b ) {
+		printf ( "1 " );
+	    } else {
+		printf ( "0 " );
+	    }
+	    break;
+	case HAL_U32:
+	    printf ( "%lu ", (unsigned long)buf[n].u);
+	    break;
+	case HAL_S32:
+	    printf ( "%ld ", (long)buf[n].s);
+	    break;
+	default:
+	    /* better not happen */
+	    return -1;
+	}
+    }
+    printf ( "\n" );
+    return 0;
+}
 
 int main(int argc, char **argv)
 {
-    int n, channel, tag;
-    long int samples;
+    int n, channel, tag, mode;
+    long int samples, ring_records = 0;
     unsigned this_sample, last_sample=0;
     char *cp, *cp2;
     hal_stream_t stream;
+    stream_ring_t ring = { .hdr = NULL };
+    const char *filename = NULL;
 
     /* set return code to "fail", clear it later if all goes well */
     exitval = 1;
     channel = 0;
     tag = 0;
+    mode = MODE_TEXT;
     samples = -1;  /* -1 means run forever */
     /* FIXME - if I wasn't so lazy I'd learn how to use getopt() here */
     for ( n = 1 ; n < argc ; n++ ) {
@@ -147,6 +202,20 @@ int main(int argc, char **argv)
 	case 't':
 	    tag = 1;
 	    break;
+	case 'b':
+	    mode = MODE_BINARY;
+	    break;
+	case 'r':
+	    if (( *(++cp) == '\0' ) && ( ++n < argc )) { 
+		cp = argv[n];
+	    }
+	    ring_records = strtol(cp, &cp2, 10);
+	    if (( *cp2 ) || ( ring_records <= 0 )) {
+		fprintf(stderr, "ERROR: invalid ring size '%s'\n", cp );
+		exit(1);
+	    }
+	    mode = MODE_RING;
+	    break;
 	default:
 	    fprintf(stderr,"ERROR: unknown option '%s'\n", cp );
 	    exit(1);
@@ -159,10 +228,16 @@ int main(int argc, char **argv)
 	    fprintf(stderr, "ERROR: At most one filename may be specified\n");
 	    exit(1);
 	}
-	// make stdout be the named file
-	fd = open(argv[n], O_WRONLY | O_CREAT, 0666);
-	close(1);
-	dup2(fd, 1);
+	filename = argv[n];
+	if ( mode != MODE_RING ) {
+	    // make stdout be the named file
+	    fd = open(filename, O_WRONLY | O_CREAT, 0666);
+	    close(1);
+	    dup2(fd, 1);
+	}
+    } else if ( mode == MODE_RING ) {
+	fprintf(stderr, "ERROR: -r needs a filename\n");
+	exit(1);
     }
     /* register signal handlers - if the process is killed
        we need to call hal_exit() to free the shared memory */
@@ -189,57 +264,85 @@ int main(int argc, char **argv)
 	goto out;
     }
     int num_pins = hal_stream_element_count(&stream);
-    while ( samples != 0 ) {
-	union hal_stream_data buf[num_pins];
-	hal_stream_wait_readable(&stream, &stop);
-	if(stop) break;
-	int res = hal_stream_read(&stream, buf, &this_sample);
+    size_t record_size = stream_record_size(&stream, tag);
+    union hal_stream_data *buf = malloc(sizeof(*buf) * num_pins * SAMPLE_BATCH);
+    unsigned char *records = malloc(record_size * SAMPLE_BATCH);
+    unsigned sampleno[SAMPLE_BATCH];
+    if ( !buf || !records ) {
+	fprintf(stderr, "ERROR: out of memory\n");
+	goto out;
+    }
+    if ( mode == MODE_RING ) {
+	res = stream_ring_create(&ring, filename, &stream, tag, ring_records);
 	if (res < 0) {
 	    errno = -res;
-	    perror("hal_stream_read");
+	    perror(filename);
 	    goto out;
 	}
-	++last_sample;
-	if ( this_sample != last_sample ) {
-	    printf ( "overrun\n");
-	    last_sample = this_sample;
+    }
+    while ( samples != 0 ) {
+	int count = SAMPLE_BATCH, i;
+	uint64_t written = 0;
+	hal_stream_wait_readable(&stream, &stop);
+	if(stop) break;
+	if ( samples > 0 && samples < count ) {
+	    count = samples;
 	}
-	if ( tag ) {
-	    printf ( "%d ", this_sample-1 );
+	count = hal_stream_read_many(&stream, buf, sampleno, count);
+	if ( mode == MODE_RING ) {
+	    written = stream_ring_written(&ring);
 	}
-	for ( n = 0 ; n < num_pins; n++ ) {
-	    switch ( hal_stream_element_type(&stream, n) ) {
-	    case HAL_FLOAT:
-		printf ( "%f ", buf[n].f);
-		break;
-	    case HAL_BIT:
-		if ( buf[n].b ) {
-		    printf ( "1 " );
+	for ( i = 0 ; i < count ; i++ ) {
+	    union hal_stream_data *sample = buf + i * num_pins;
+	    this_sample = sampleno[i];
+	    ++last_sample;
+	    if ( this_sample != last_sample ) {
+		if ( mode == MODE_TEXT ) {
+		    printf ( "overrun\n");
 		} else {
-		    printf ( "0 " );
+		    fprintf ( stderr, "overrun before sample %u\n", this_sample-1 );
+		}
+		last_sample = this_sample;
+	    }
+	    switch ( mode ) {
+	    case MODE_TEXT:
+		if ( print_sample(&stream, sample, tag, this_sample) < 0 ) {
+		    goto out;
 		}
 		break;
-	    case HAL_U32:
-		printf ( "%lu ", (unsigned long)buf[n].u);
+	    case MODE_BINARY:
+		stream_record_encode(&stream, sample, this_sample-1, tag,
+		    records + i * record_size);
 		break;
-	    case HAL_S32:
-		printf ( "%ld ", (long)buf[n].s);
+	    case MODE_RING:
+		stream_record_encode(&stream, sample, this_sample-1, tag,
+		    stream_ring_record(&ring, written + i));
 		break;
-	    default:
-		/* better not happen */
+	    }
+	}
+	if ( mode == MODE_BINARY ) {
+	    if ( fwrite(records, record_size, count, stdout) != (size_t)count ) {
+		perror("halsampler: write");
 		goto out;
 	    }
+	} else if ( mode == MODE_RING ) {
+	    stream_ring_set_written(&ring, written + count);
 	}
-	printf ( "\n" );
 	if ( samples > 0 ) {
-	    samples--;
+	    samples -= count;
 	}
     }
+    /* stdout is buffered, so a failed write may only show up here */
+    if ( fflush(stdout) != 0 || ferror(stdout) ) {
+	perror("halsampler: write");
+	goto out;
+    }
     /* run was succesfull */
     exitval = 0;
 
 out:
     ignore_sig = 1;
+    stream_ring_close(&ring);
     hal_stream_detach(&stream);
     if ( comp_id >= 0 ) {
 	hal_exit(comp_id);
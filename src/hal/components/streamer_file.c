@@ -0,0 +1,253 @@
+/********************************************************************
+* Description:  streamer_file.c
+*               Binary record and ring file formats shared by
+*               halsampler and halstreamer.
+*
+* License: GPL Version 2
+*
+* Copyright (c) 2026 All rights reserved.
+*
+********************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <endian.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "rtapi.h"
+#include "hal.h"
+#include "streamer_file.h"
+
+static size_t element_size(hal_type_t type)
+{
+    switch (type) {
+    case HAL_FLOAT:
+	return 8;
+    case HAL_BIT:
+	return 1;
+    default:
+	return 4;
+    }
+}
+
+static char element_char(hal_type_t type)
+{
+    switch (type) {
+    case HAL_FLOAT:
+	return 'f';
+    case HAL_BIT:
+	return 'b';
+    case HAL_U32:
+	return 'u';
+    default:
+	return 's';
+    }
+}
+
+size_t stream_record_size(hal_stream_t *stream, int tagged)
+{
+    int n, num_pins = hal_stream_element_count(stream);
+    size_t size = tagged ? 4 : 0;
+
+    for (n = 0; n < num_pins; n++) {
+	size += element_size(hal_stream_element_type(stream, n));
+    }
+    return size;
+}
+
+void stream_record_encode(hal_stream_t *stream,
+    const union hal_stream_data *buf, unsigned sampleno, int tagged,
+    unsigned char *rec)
+{
+    int n, num_pins = hal_stream_element_count(stream);
+    uint32_t u32;
+    uint64_t u64;
+
+    if (tagged) {
+	u32 = htole32(sampleno);
+	memcpy(rec, &u32, 4);
+	rec += 4;
+    }
+    for (n = 0; n < num_pins; n++) {
+	switch (hal_stream_element_type(stream, n)) {
+	case HAL_FLOAT:
+	    memcpy(&u64, &buf[n].f, 8);
+	    u64 = htole64(u64);
+	    memcpy(rec, &u64, 8);
+	    rec += 8;
+	    break;
+	case HAL_BIT:
+	    *rec++ = buf[n].b ? 1 : 0;
+	    break;
+	case HAL_U32:
+	    u32 = htole32(buf[n].u);
+	    memcpy(rec, &u32, 4);
+	    rec += 4;
+	    break;
+	default:
+	    u32 = htole32((uint32_t) buf[n].s);
+	    memcpy(rec, &u32, 4);
+	    rec += 4;
+	    break;
+	}
+    }
+}
+
+void stream_record_decode(hal_stream_t *stream,
+    const unsigned char *rec, int tagged, union hal_stream_data *buf)
+{
+    int n, num_pins = hal_stream_element_count(stream);
+    uint32_t u32;
+    uint64_t u64;
+
+    if (tagged) {
+	rec += 4;
+    }
+    for (n = 0; n < num_pins; n++) {
+	switch (hal_stream_element_type(stream, n)) {
+	case HAL_FLOAT:
+	    memcpy(&u64, rec, 8);
+	    u64 = le64toh(u64);
+	    memcpy(&buf[n].f, &u64, 8);
+	    rec += 8;
+	    break;
+	case HAL_BIT:
+	    buf[n].b = *rec++ != 0;
+	    break;
+	case HAL_U32:
+	    memcpy(&u32, rec, 4);
+	    buf[n].u = le32toh(u32);
+	    rec += 4;
+	    break;
+	default:
+	    memcpy(&u32, rec, 4);
+	    buf[n].s = (int32_t) le32toh(u32);
+	    rec += 4;
+	    break;
+	}
+    }
+}
+
+static int ring_map(stream_ring_t *ring, int fd, size_t size, int prot)
+{
+    void *p = mmap(NULL, size, prot, MAP_SHARED, fd, 0);
+
+    if (p == MAP_FAILED) {
+	close(fd);
+	return -errno;
+    }
+    ring->fd = fd;
+    ring->map_size = size;
+    ring->hdr = p;
+    ring->data = (unsigned char *) p + sizeof(struct stream_ring_header);
+    return 0;
+}
+
+int stream_ring_create(stream_ring_t *ring, const char *path,
+    hal_stream_t *stream, int tagged, uint64_t capacity)
+{
+    struct stream_ring_header *hdr;
+    size_t record_size = stream_record_size(stream, tagged);
+    size_t size = sizeof(*hdr) + record_size * capacity;
+    int n, num_pins = hal_stream_element_count(stream);
+    int fd, res;
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+	return -errno;
+    }
+    /* allocate the blocks now so a full disk shows up here and not as
+       SIGBUS in the middle of a capture */
+    res = posix_fallocate(fd, 0, size);
+    if (res != 0) {
+	close(fd);
+	return -res;
+    }
+    res = ring_map(ring, fd, size, PROT_READ | PROT_WRITE);
+    if (res < 0) {
+	return res;
+    }
+    hdr = ring->hdr;
+    memcpy(hdr->magic, STREAM_RING_MAGIC, sizeof(hdr->magic));
+    hdr->record_size = htole32(record_size);
+    hdr->tagged = htole32(tagged);
+    hdr->capacity = htole64(capacity);
+    hdr->written = 0;
+    for (n = 0; n < num_pins; n++) {
+	hdr->types[n] = element_char(hal_stream_element_type(stream, n));
+    }
+    ring->record_size = record_size;
+    ring->capacity = capacity;
+    ring->tagged = tagged;
+    return 0;
+}
+
+int stream_ring_open(stream_ring_t *ring, const char *path,
+    hal_stream_t *stream)
+{
+    struct stream_ring_header hdr;
+    struct stat st;
+    int n, fd, num_pins = hal_stream_element_count(stream);
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+	return -errno;
+    }
+    if (read(fd, &hdr, sizeof(hdr)) != sizeof(hdr)
+	|| memcmp(hdr.magic, STREAM_RING_MAGIC, sizeof(hdr.magic))
+	|| fstat(fd, &st) < 0) {
+	fprintf(stderr, "ERROR: %s is not a ring file\n", path);
+	close(fd);
+	return -EINVAL;
+    }
+    ring->tagged = le32toh(hdr.tagged);
+    ring->record_size = le32toh(hdr.record_size);
+    ring->capacity = le64toh(hdr.capacity);
+    if ((size_t) st.st_size < sizeof(hdr) + ring->record_size * ring->capacity) {
+	fprintf(stderr, "ERROR: %s is truncated\n", path);
+	close(fd);
+	return -EINVAL;
+    }
+    for (n = 0; n < num_pins; n++) {
+	if (hdr.types[n] != element_char(hal_stream_element_type(stream, n))) {
+	    break;
+	}
+    }
+    if (n != num_pins || hdr.types[n] != '\0'
+	|| ring->record_size != stream_record_size(stream, ring->tagged)) {
+	fprintf(stderr, "ERROR: %s holds '%s' records, which do not match the stream\n",
+	    path, hdr.types);
+	close(fd);
+	return -EINVAL;
+    }
+    return ring_map(ring, fd, sizeof(hdr) + ring->record_size * ring->capacity,
+	PROT_READ);
+}
+
+unsigned char *stream_ring_record(stream_ring_t *ring, uint64_t n)
+{
+    return ring->data + (n % ring->capacity) * ring->record_size;
+}
+
+uint64_t stream_ring_written(stream_ring_t *ring)
+{
+    return le64toh(__atomic_load_n(&ring->hdr->written, __ATOMIC_ACQUIRE));
+}
+
+void stream_ring_set_written(stream_ring_t *ring, uint64_t written)
+{
+    __atomic_store_n(&ring->hdr->written, htole64(written), __ATOMIC_RELEASE);
+}
+
+void stream_ring_close(stream_ring_t *ring)
+{
+    if (ring->hdr) {
+	munmap(ring->hdr, ring->map_size);
+	close(ring->fd);
+	ring->hdr = NULL;
+    }
+}
@@ -0,0 +1,70 @@
+/********************************************************************
+* Description:  streamer_file.h
+*               Binary record and ring file formats shared by
+*               halsampler and halstreamer.
+*
+* License: GPL Version 2
+*
+* Copyright (c) 2026 All rights reserved.
+*
+********************************************************************/
+#ifndef STREAMER_FILE_H
+#define STREAMER_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hal.h"
+
+/* A binary record is one sample, with each element in the order of the
+   stream's config string, little-endian and packed:
+       f  8 byte IEEE double
+       b  1 byte, 0 or 1
+       u  4 byte unsigned
+       s  4 byte signed
+   A tagged record (halsampler -t) starts with the 4 byte sample number.
+*/
+extern size_t stream_record_size(hal_stream_t *stream, int tagged);
+extern void stream_record_encode(hal_stream_t *stream,
+    const union hal_stream_data *buf, unsigned sampleno, int tagged,
+    unsigned char *rec);
+extern void stream_record_decode(hal_stream_t *stream,
+    const unsigned char *rec, int tagged, union hal_stream_data *buf);
+
+/* A ring file is a header followed by 'capacity' records.  The writer
+   stores record n at slot n % capacity and then advances 'written', so
+   the file always holds the newest 'capacity' records and a reader can
+   follow it while it is written.  Header integers are little-endian. */
+#define STREAM_RING_MAGIC "HALRING1"
+
+struct stream_ring_header {
+    char magic[8];
+    uint32_t record_size;
+    uint32_t tagged;
+    uint64_t capacity;		/* records */
+    uint64_t written;		/* records written since the file was made */
+    char types[HAL_STREAM_MAX_PINS + 1];	/* config string, e.g. "ffb" */
+    char pad[64 - 32 - HAL_STREAM_MAX_PINS - 1];
+};
+
+typedef struct {
+    int fd;
+    size_t map_size;
+    struct stream_ring_header *hdr;
+    unsigned char *data;
+    size_t record_size;
+    uint64_t capacity;
+    int tagged;
+} stream_ring_t;
+
+/* create a ring file for the records of stream, replacing any file */
+extern int stream_ring_create(stream_ring_t *ring, const char *path,
+    hal_stream_t *stream, int tagged, uint64_t capacity);
+/* open an existing ring file and check it against stream */
+extern int stream_ring_open(stream_ring_t *ring, const char *path,
+    hal_stream_t *stream);
+extern unsigned char *stream_ring_record(stream_ring_t *ring, uint64_t n);
+extern uint64_t stream_ring_written(stream_ring_t *ring);
+extern void stream_ring_set_written(stream_ring_t *ring, uint64_t written);
+extern void stream_ring_close(stream_ring_t *ring);
+
+#endif
@@ -27,6 +27,14 @@
     from stdin, it will almost always either need to have stdin 
     redirected from a file, or have data piped into it from some
     other program.
+
+    halstreamer [-c chan_num] [-b] [-r] [file]
+
+    '-b' reads fixed size binary records, as written by
+    'halsampler -b' without '-t' (see streamer_file.h).
+
+    '-r' replays a ring file written by 'halsampler -r', oldest
+    record first.  Its record types must match the stream.
 */
 
 /** This program is free software; you can redistribute it and/or
@@ -64,10 +72,12 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <poll.h>
 
 #include "rtapi.h"		/* RTAPI realtime OS API */
 #include "hal.h"                /* HAL public API decls */
 #include "streamer.h"
+#include "streamer_file.h"
 
 /***********************************************************************
 *                  LOCAL FUNCTION DECLARATIONS                         *
@@ -98,18 +108,52 @@ static void quit(int sig)
 }
 
 #define BUF_SIZE 4000
+/* samples handed to the stream per call */
+#define SAMPLE_BATCH 256
+
+enum { MODE_TEXT, MODE_BINARY, MODE_RING };
+
+/* true if another line can be read without blocking; a file always can,
+   a pipe only once the writer has sent it */
+static int stdin_has_data(void)
+{
+    struct pollfd pfd = { .fd = 0, .events = POLLIN };
+    return poll(&pfd, 1, 0) > 0;
+}
+
+/* write count samples, waiting for room as needed; returns -1 if
+   interrupted by a signal */
+static int write_batch(hal_stream_t *stream, union hal_stream_data *data,
+    int count)
+{
+    int num_pins = hal_stream_element_count(stream);
+
+    while ( count > 0 ) {
+	hal_stream_wait_writable(stream, &stop);
+	if ( stop ) {
+	    return -1;
+	}
+	int n = hal_stream_write_many(stream, data, count);
+	data += n * num_pins;
+	count -= n;
+    }
+    return 0;
+}
 
 int main(int argc, char **argv)
 {
-    int n, channel, line=0;
+    int n, channel, mode, line=0;
     char *cp, *cp2;
     hal_stream_t stream;
+    stream_ring_t ring = { .hdr = NULL };
+    const char *filename = NULL;
     char buf[BUF_SIZE];
 	const char *errmsg;
 
     /* set return code to "fail", clear it later if all goes well */
     exitval = 1;
     channel = 0;
+    mode = MODE_TEXT;
     for ( n = 1 ; n < argc ; n++ ) {
 	cp = argv[n];
 	if ( *cp != '-' ) {
@@ -126,6 +170,12 @@ int main(int argc, char **argv)
 		exit(1);
 	    }
 	    break;
+	case 'b':
+	    mode = MODE_BINARY;
+	    break;
+	case 'r':
+	    mode = MODE_RING;
+	    break;
 	default:
 	    fprintf(stderr,"ERROR: unknown option '%s'\n", cp );
 	    exit(1);
@@ -138,10 +188,16 @@ int main(int argc, char **argv)
 	    fprintf(stderr, "ERROR: At most one filename may be specified\n");
 	    exit(1);
 	}
-	// make stdin be the named file
-	fd = open(argv[n], O_RDONLY);
-	close(0);
-	dup2(fd, 0);
+	filename = argv[n];
+	if ( mode != MODE_RING ) {
+	    // make stdin be the named file
+	    fd = open(filename, O_RDONLY);
+	    close(0);
+	    dup2(fd, 0);
+	}
+    } else if ( mode == MODE_RING ) {
+	fprintf(stderr, "ERROR: -r needs a filename\n");
+	exit(1);
     }
     /* register signal handlers - if the process is killed
        we need to call hal_exit() to free the shared memory */
@@ -169,6 +225,58 @@ int main(int argc, char **argv)
 	goto out;
     }
     int num_pins = hal_stream_element_count(&stream);
+    union hal_stream_data *batch = malloc(sizeof(*batch) * num_pins * SAMPLE_BATCH);
+    int pending = 0;
+    if ( !batch ) {
+	fprintf(stderr, "ERROR: out of memory\n");
+	goto out;
+    }
+    if ( mode == MODE_BINARY ) {
+	size_t record_size = stream_record_size(&stream, 0);
+	unsigned char *records = malloc(record_size * SAMPLE_BATCH);
+	size_t count;
+	if ( !records ) {
+	    fprintf(stderr, "ERROR: out of memory\n");
+	    goto out;
+	}
+	while ( (count = fread(records, record_size, SAMPLE_BATCH, stdin)) > 0 ) {
+	    for ( n = 0 ; n < (int)count ; n++ ) {
+		stream_record_decode(&stream, records + n * record_size, 0,
+		    batch + n * num_pins);
+	    }
+	    if ( write_batch(&stream, batch, count) < 0 ) {
+		break;
+	    }
+	}
+	free(records);
+	exitval = 0;
+	goto out;
+    }
+    if ( mode == MODE_RING ) {
+	uint64_t first, last, i;
+	r = stream_ring_open(&ring, filename, &stream);
+	if ( r < 0 ) {
+	    if ( r != -EINVAL ) {
+		errno = -r;
+		perror(filename);
+	    }
+	    goto out;
+	}
+	last = stream_ring_written(&ring);
+	first = last > ring.capacity ? last - ring.capacity : 0;
+	for ( i = first ; i < last ; i++ ) {
+	    stream_record_decode(&stream, stream_ring_record(&ring, i),
+		ring.tagged, batch + pending * num_pins);
+	    if ( ++pending == SAMPLE_BATCH || i + 1 == last ) {
+		if ( write_batch(&stream, batch, pending) < 0 ) {
+		    break;
+		}
+		pending = 0;
+	    }
+	}
+	exitval = 0;
+	goto out;
+    }
     while ( fgets(buf, BUF_SIZE, stdin) ) {
 	/* skip comment lines */
 	if ( buf[0] == '#' ) {
@@ -177,7 +285,7 @@ int main(int argc, char **argv)
 	}
 	cp = buf;
 	errmsg = NULL;
-	union hal_stream_data data[num_pins];
+	union hal_stream_data *data = batch + pending * num_pins;
 	for ( n = 0 ; n < num_pins ; n++ ) {
             union hal_stream_data *dptr = &data[n];
 	    /* strip leading whitespace */
@@ -237,17 +345,31 @@ int main(int argc, char **argv)
 		abort the program.  Right now it skips the line. */
 	} else {
 	    /* good data, keep it */
-            hal_stream_wait_writable(&stream, &stop);
-	    if(stop) break;
-	    hal_stream_write(&stream, data);
+	    if ( ++pending == SAMPLE_BATCH ) {
+		if ( write_batch(&stream, batch, pending) < 0 ) {
+		    break;
+		}
+		pending = 0;
+	    }
 	}
 	line++;
+	/* don't hold back samples while waiting for more input */
+	if ( pending && !stdin_has_data() ) {
+	    if ( write_batch(&stream, batch, pending) < 0 ) {
+		break;
+	    }
+	    pending = 0;
+	}
+    }
+    if ( pending && !stop ) {
+	write_batch(&stream, batch, pending);
     }
     /* run was succesfull */
     exitval = 0;
 
 out:
     ignore_sig = 1;
+    stream_ring_close(&ring);
     hal_stream_detach(&stream);
     if ( comp_id >= 0 ) {
 	hal_exit(comp_id);
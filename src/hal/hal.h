@@ -752,6 +752,25 @@ extern int hal_thread_delete(const char *name);
 extern int hal_add_funct_to_thread(const char *funct_name, const char *thread_name,
     int position);
 
+/** hal_add_funct_to_thread_divided() is like hal_add_funct_to_thread(),
+    but the function only runs in some periods of the thread.
+    'divisor' is how often it runs: 1 is every period, 10 is every
+    tenth period.  'phase' picks which of those periods, from 0 to
+    divisor-1.  Periods are counted from the start of the thread, so
+    functions with the same divisor and different phases never run
+    in the same period, which spreads slow work evenly over the
+    periods instead of doing all of it at once.
+    'enable_pin' is the name of a bit pin, or NULL.  If given, the
+    function is skipped in any period in which the pin is false.  If
+    the pin is later deleted, the function runs unconditionally.
+    Returns 0, or a negative error code.    Call
+    only from within user space or init code, not from
+    realtime code.
+*/
+extern int hal_add_funct_to_thread_divided(const char *funct_name,
+    const char *thread_name, int position, int divisor, int phase,
+    const char *enable_pin);
+
 /** hal_del_funct_from_thread() removes a function from a thread.
     'funct_name' is the name of the function, as specified in
     a call to hal_export_funct().
@@ -920,6 +939,10 @@ extern hal_type_t hal_stream_element_type(hal_stream_t *stream, int idx);
 // only one reader and one writer is allowed.
 extern int hal_stream_read(hal_stream_t *stream, union hal_stream_data *buf, unsigned *sampleno);
 extern bool hal_stream_readable(hal_stream_t *stream);
+/** read up to count samples, packed num_pins elements each, into buf.
+    If sampleno is not NULL it receives count sample numbers.  Returns
+    the number of samples read, 0 (an underrun) if the stream was empty. */
+extern int hal_stream_read_many(hal_stream_t *stream, union hal_stream_data *buf, unsigned *sampleno, int count);
 extern int hal_stream_depth(hal_stream_t *stream);
 extern int hal_stream_maxdepth(hal_stream_t *stream);
 extern int hal_stream_num_underruns(hal_stream_t *stream);
@@ -930,6 +953,10 @@ extern void hal_stream_wait_readable(hal_stream_t *stream, sig_atomic_t *stop);
 
 extern int hal_stream_write(hal_stream_t *stream, union hal_stream_data *buf);
 extern bool hal_stream_writable(hal_stream_t *stream);
+/** write up to count samples, packed num_pins elements each, from buf.
+    Returns the number of samples written, 0 (an overrun) if the stream
+    was full. */
+extern int hal_stream_write_many(hal_stream_t *stream, union hal_stream_data *buf, int count);
 #ifdef ULAPI
 extern void hal_stream_wait_writable(hal_stream_t *stream, sig_atomic_t *stop);
 #endif
@@ -59,6 +59,7 @@
 
 #include "rtapi_string.h"
 #include "rtapi_atomic.h"
+#include "rtapi_math64.h"
 
 #ifdef RTAPI
 #include "rtapi_app.h"
@@ -73,11 +74,20 @@ MODULE_LICENSE("GPL");
 #include <unistd.h>		/* getpid() */
 #include <time.h>
 #endif
+#if defined(RTAPI) && !defined(__KERNEL__)
+#include <stdlib.h>		/* getenv() */
+#endif
 
 char *hal_shmem_base = 0;
 hal_data_t *hal_data = 0;
 static int lib_module_id = -1;	/* RTAPI module ID for library module */
 static int lib_mem_id = 0;	/* RTAPI shmem ID for library module */
+static long lib_mem_size = 0;	/* size of the shmem as mapped here */
+
+#if defined(RTAPI) && defined(__KERNEL__)
+static long hal_size = 0;
+RTAPI_MP_LONG(hal_size, "size of HAL shared memory in bytes");
+#endif
 
 /***********************************************************************
 *                  LOCAL FUNCTION DECLARATIONS                         *
@@ -92,6 +102,23 @@ static int lib_mem_id = 0;	/* RTAPI shmem ID for library module */
 */
 static int init_hal_data(void);
 
+#ifdef RTAPI
+/** hal_shmem_size() returns the size of the HAL shared memory block to
+    create, if it does not exist yet.  It is HAL_SIZE unless the
+    'hal_size' module parameter (kernel realtime) or the HAL_SIZE
+    environment variable (uspace realtime) asks for more, up to
+    HAL_SIZE_MAX.  User space opens the block at HAL_SIZE and maps it
+    again at hal_data->shmem_size if that is bigger.
+*/
+static long hal_shmem_size(void);
+
+/** hal_shmem_flags() returns the RTAPI flags to create the block with:
+    RTAPI_SHMEM_HUGEPAGES if the HAL_HUGEPAGES environment variable
+    asks for huge pages (uspace realtime).
+*/
+static int hal_shmem_flags(void);
+#endif
+
 /** The 'shmalloc_xx()' functions allocate blocks of shared memory.
     Each function allocates a block that is 'size' bytes long.
     If 'size' is 3 or more, the block is aligned on a 4 byte
@@ -197,8 +224,10 @@ int hal_init(const char *name)
 	    return -EINVAL;
 	}
 
-	/* get HAL shared memory block from RTAPI */
-	lib_mem_id = rtapi_shmem_new(HAL_KEY, lib_module_id, HAL_SIZE);
+	/* get HAL shared memory block from RTAPI, at the smallest size
+	   it can have; realtime normally created it already */
+	lib_mem_size = HAL_SIZE;
+	lib_mem_id = rtapi_shmem_new(HAL_KEY, lib_module_id, lib_mem_size);
 	if (lib_mem_id < 0) {
 	    rtapi_print_msg(RTAPI_MSG_ERR,
 		"HAL: ERROR: could not open shared memory\n");
@@ -224,6 +253,23 @@ int hal_init(const char *name)
 	    rtapi_exit(lib_module_id);
 	    return -EINVAL;
 	}
+	/* the creator made it bigger, map all of it so that everything
+	   SHMCHK() accepts is mapped here too */
+	if (hal_data->shmem_size > lib_mem_size) {
+	    lib_mem_size = hal_data->shmem_size;
+	    rtapi_shmem_delete(lib_mem_id, lib_module_id);
+	    lib_mem_id = rtapi_shmem_new(HAL_KEY, lib_module_id, lib_mem_size);
+	    if (lib_mem_id < 0
+		|| rtapi_shmem_getptr(lib_mem_id, &mem) < 0) {
+		rtapi_print_msg(RTAPI_MSG_ERR,
+		    "HAL: ERROR: could not map %ld bytes of shared memory\n",
+		    lib_mem_size);
+		rtapi_exit(lib_module_id);
+		return -EINVAL;
+	    }
+	    hal_shmem_base = (char *) mem;
+	    hal_data = (hal_data_t *) mem;
+	}
     }
 #endif
     rtapi_print_msg(RTAPI_MSG_DBG, "HAL: initializing component '%s'\n",
@@ -877,11 +923,7 @@ int hal_pin_alias(const char *pin_name, const char *alias)
 
 int hal_signal_new(const char *name, hal_type_t type)
 {
-
-    rtapi_intptr_t *prev, next;
-    int cmp;
-    hal_sig_t *new, *ptr;
-    void *data_addr;
+    int retval;
 
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -910,6 +952,18 @@ int hal_signal_new(const char *name, hal_type_t type)
 	    "HAL: ERROR: duplicate signal '%s'\n", name);
 	return -EINVAL;
     }
+    retval = halpr_signal_new(name, type, 0, 0);
+    rtapi_mutex_give(&(hal_data->mutex));
+    return retval;
+}
+
+int halpr_signal_new(const char *name, hal_type_t type, hal_sig_t *after,
+    hal_sig_t **sig)
+{
+    rtapi_intptr_t *prev, next;
+    hal_sig_t *new, *ptr;
+    void *data_addr;
+
     /* allocate memory for the signal value */
 /*
 because accesses will later be through pointer of type hal_data_u,
@@ -930,7 +984,6 @@ with the C standard.
         data_addr = shmalloc_up(sizeof(hal_data_u));
     break;
     default:
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: illegal signal type %d'\n", type);
 	return -EINVAL;
@@ -940,7 +993,6 @@ with the C standard.
     new = alloc_sig_struct();
     if ((new == 0) || (data_addr == 0)) {
 	/* alloc failed */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: insufficient memory for signal '%s'\n", name);
 	return -ENOMEM;
@@ -972,30 +1024,26 @@ with the C standard.
     new->writers = 0;
     new->bidirs = 0;
     rtapi_snprintf(new->name, sizeof(new->name), "%s", name);
-    /* search list for 'name' and insert new structure */
-    prev = &(hal_data->sig_list_ptr);
+    /* search list for 'name' and insert new structure, starting after
+       'after' if the caller knows it sorts before 'name' */
+    prev = after ? &(after->next_ptr) : &(hal_data->sig_list_ptr);
     next = *prev;
-    while (1) {
-	if (next == 0) {
-	    /* reached end of list, insert here */
-	    new->next_ptr = next;
-	    *prev = SHMOFF(new);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
-	}
+    while (next != 0) {
 	ptr = SHMPTR(next);
-	cmp = strcmp(ptr->name, new->name);
-	if (cmp > 0) {
-	    /* found the right place for it, insert here */
-	    new->next_ptr = next;
-	    *prev = SHMOFF(new);
-	    rtapi_mutex_give(&(hal_data->mutex));
-	    return 0;
+	if (strcmp(ptr->name, new->name) > 0) {
+	    /* found the right place for it */
+	    break;
 	}
 	/* didn't find it yet, look at next one */
 	prev = &(ptr->next_ptr);
 	next = *prev;
     }
+    new->next_ptr = next;
+    *prev = SHMOFF(new);
+    if (sig) {
+	*sig = new;
+    }
+    return 0;
 }
 
 int hal_signal_delete(const char *name)
@@ -1047,8 +1095,7 @@ int hal_link(const char *pin_name, const char *sig_name)
 {
     hal_pin_t *pin;
     hal_sig_t *sig;
-    hal_comp_t *comp;
-    void **data_ptr_addr, *data_addr;
+    int retval;
 
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -1093,59 +1140,63 @@ int hal_link(const char *pin_name, const char *sig_name)
 	    "HAL: ERROR: signal '%s' not found\n", sig_name);
 	return -EINVAL;
     }
+    retval = halpr_link(pin, sig);
+    rtapi_mutex_give(&(hal_data->mutex));
+    return retval;
+}
+
+int halpr_link(hal_pin_t *pin, hal_sig_t *sig)
+{
+    hal_comp_t *comp;
+    hal_sig_t *osig;
+    void **data_ptr_addr, *data_addr;
+
     /* found both pin and signal, are they already connected? */
     if (SHMPTR(pin->signal) == sig) {
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_WARN,
-	    "HAL: Warning: pin '%s' already linked to '%s'\n", pin_name, sig_name);
+	    "HAL: Warning: pin '%s' already linked to '%s'\n", pin->name, sig->name);
 	return 0;
     }
     /* is the pin connected to something else? */
     if(pin->signal) {
-	rtapi_mutex_give(&(hal_data->mutex));
-	sig = SHMPTR(pin->signal);
+	osig = SHMPTR(pin->signal);
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL: ERROR: pin '%s' is linked to '%s', cannot link to '%s'\n",
-	    pin_name, sig->name, sig_name);
+	    pin->name, osig->name, sig->name);
 	return -EINVAL;
     }
     /* check types */
     if (pin->type != sig->type) {
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: type mismatch '%s' <- '%s'\n", pin_name, sig_name);
+	    "HAL: ERROR: type mismatch '%s' <- '%s'\n", pin->name, sig->name);
 	return -EINVAL;
     }
     /* linking output pin to sig that already has output or I/O pins? */
     if ((pin->dir == HAL_OUT) && ((sig->writers > 0) || (sig->bidirs > 0 ))) {
 	/* yes, can't do that */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: signal '%s' already has output or I/O pin(s)\n", sig_name);
+	    "HAL: ERROR: signal '%s' already has output or I/O pin(s)\n", sig->name);
 	return -EINVAL;
     }
     /* linking bidir pin to sig that is a port?*/
     if ((pin->dir == HAL_IO) && (pin->type == HAL_PORT)) {
-    rtapi_mutex_give(&(hal_data->mutex));
     rtapi_print_msg(RTAPI_MSG_ERR,
-        "HAL: ERROR: signal '%s' is a port and cannot have I/O pin(s)\n", sig_name);
+        "HAL: ERROR: signal '%s' is a port and cannot have I/O pin(s)\n", sig->name);
     return -EINVAL;
     }
     /* linking bidir pin to sig that already has output pin? */
     if ((pin->dir == HAL_IO) && (sig->writers > 0)) {
 	/* yes, can't do that */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: signal '%s' already has output pin\n", sig_name);
+	    "HAL: ERROR: signal '%s' already has output pin\n", sig->name);
 	return -EINVAL;
     }
 
     /* linking input pin to port sig that already has an input port? */
     if ((pin->type == HAL_PORT) && (pin->dir == HAL_IN) && (sig->readers > 0)) {
 	/* ports can only have one reader */
-	rtapi_mutex_give(&(hal_data->mutex));
 	rtapi_print_msg(RTAPI_MSG_ERR,
-	    "HAL: ERROR: siganl '%s' can only have one input pin\n", sig_name);
+	    "HAL: ERROR: siganl '%s' can only have one input pin\n", sig->name);
 	return -EINVAL;
     }
     
@@ -1203,8 +1254,7 @@ int hal_link(const char *pin_name, const char *sig_name)
     }
     /* and update the pin */
     pin->signal = SHMOFF(sig);
-    /* done, release the mutex and return */
-    rtapi_mutex_give(&(hal_data->mutex));
+    /* done */
     return 0;
 }
 
@@ -2080,9 +2130,18 @@ extern int hal_thread_delete(const char *name)
 #endif /* RTAPI */
 
 int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int position)
+{
+    return hal_add_funct_to_thread_divided(funct_name, thread_name,
+	position, 1, 0, NULL);
+}
+
+int hal_add_funct_to_thread_divided(const char *funct_name,
+    const char *thread_name, int position, int divisor, int phase,
+    const char *enable_pin)
 {
     hal_thread_t *thread;
     hal_funct_t *funct;
+    hal_pin_t *enable;
     hal_list_t *list_root, *list_entry;
     int n;
     hal_funct_entry_t *funct_entry;
@@ -2111,6 +2170,13 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 	rtapi_print_msg(RTAPI_MSG_ERR, "HAL: ERROR: bad position: 0\n");
 	return -EINVAL;
     }
+    /* make sure divisor and phase are valid */
+    if (divisor < 1 || phase < 0 || phase >= divisor) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: bad divisor/phase: %d/%d\n", divisor, phase);
+	return -EINVAL;
+    }
     /* make sure we were given a function name */
     if (funct_name == 0) {
 	/* no name supplied */
@@ -2157,6 +2223,23 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
 	    "HAL: ERROR: function '%s' needs FP\n", funct_name);
 	return -EINVAL;
     }
+    /* find the enable pin, if any */
+    enable = 0;
+    if (enable_pin != 0) {
+	enable = halpr_find_pin_by_name(enable_pin);
+	if (enable == 0) {
+	    rtapi_mutex_give(&(hal_data->mutex));
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: pin '%s' not found\n", enable_pin);
+	    return -EINVAL;
+	}
+	if (enable->type != HAL_BIT) {
+	    rtapi_mutex_give(&(hal_data->mutex));
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: enable pin '%s' is not a bit\n", enable_pin);
+	    return -EINVAL;
+	}
+    }
     /* find insertion point */
     list_root = &(thread->funct_list);
     list_entry = list_root;
@@ -2203,6 +2286,10 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
     funct_entry->funct_ptr = SHMOFF(funct);
     funct_entry->arg = funct->arg;
     funct_entry->funct = funct->funct;
+    funct_entry->divisor = divisor;
+    funct_entry->phase = phase;
+    funct_entry->countdown = -1;
+    funct_entry->enable_ptr = enable ? SHMOFF(enable) : 0;
     /* add the entry to the list */
     list_add_after((hal_list_t *) funct_entry, list_entry);
     /* update the function usage count */
@@ -2754,7 +2841,9 @@ int rtapi_app_main(void)
 	return -EINVAL;
     }
     /* get HAL shared memory block from RTAPI */
-    lib_mem_id = rtapi_shmem_new(HAL_KEY, lib_module_id, HAL_SIZE);
+    lib_mem_size = hal_shmem_size();
+    lib_mem_id = rtapi_shmem_new_flags(HAL_KEY, lib_module_id, lib_mem_size,
+	hal_shmem_flags());
     if (lib_mem_id < 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    "HAL_LIB: ERROR: could not open shared memory\n");
@@ -2827,6 +2916,8 @@ static void thread_task(void *arg)
     hal_thread_t *thread;
     hal_funct_t *funct;
     hal_funct_entry_t *funct_root, *funct_entry;
+    hal_pin_t *enable;
+    hal_bit_t *enabled;
     long long int start_time, end_time;
     long long int thread_start_time;
 
@@ -2842,6 +2933,35 @@ static void thread_task(void *arg)
 	    thread_start_time = start_time;
 	    /* run thru function list */
 	    while (funct_entry != funct_root) {
+		/* skip it if this is not one of its periods */
+		if (funct_entry->divisor > 1) {
+		    if (funct_entry->countdown < 0) {
+			/* first period it is on the list: line it up */
+			rtapi_u32 rem;
+			rtapi_div_u64_rem(thread->cycles, funct_entry->divisor, &rem);
+			funct_entry->countdown = (funct_entry->phase - (int) rem
+			    + funct_entry->divisor) % funct_entry->divisor;
+		    }
+		    if (funct_entry->countdown > 0) {
+			funct_entry->countdown--;
+			funct_entry = SHMPTR(funct_entry->links.next);
+			continue;
+		    }
+		    funct_entry->countdown = funct_entry->divisor - 1;
+		}
+		/* or if its enable pin is false */
+		if (funct_entry->enable_ptr != 0) {
+		    enable = SHMPTR(funct_entry->enable_ptr);
+		    if (enable->signal != 0) {
+			enabled = SHMPTR(((hal_sig_t *) SHMPTR(enable->signal))->data_ptr);
+		    } else {
+			enabled = &(enable->dummysig.b);
+		    }
+		    if (!*enabled) {
+			funct_entry = SHMPTR(funct_entry->links.next);
+			continue;
+		    }
+		}
 		/* call the function */
 		funct_entry->funct(funct_entry->arg, thread->period);
 		/* capture execution time */
@@ -2866,6 +2986,7 @@ static void thread_task(void *arg)
 	    if ( *(thread->runtime) > thread->maxtime) {
 	        thread->maxtime = *(thread->runtime);
 	    }
+	    thread->cycles++;
 	}
 	/* wait until next period */
 	rtapi_wait();
@@ -2915,14 +3036,54 @@ static int init_hal_data(void)
     hal_data->thread_free_ptr = 0;
     hal_data->exact_base_period = 0;
     /* set up for shmalloc_xx() */
+    hal_data->shmem_size = lib_mem_size;
     hal_data->shmem_bot = sizeof(hal_data_t);
-    hal_data->shmem_top = HAL_SIZE;
+    hal_data->shmem_top = lib_mem_size;
     hal_data->lock = HAL_LOCK_NONE;
     /* done, release mutex */
     rtapi_mutex_give(&(hal_data->mutex));
     return 0;
 }
 
+#ifdef RTAPI
+static long hal_shmem_size(void)
+{
+    long size = 0;
+#ifdef __KERNEL__
+    size = hal_size;
+#else
+    const char *env = getenv("HAL_SIZE");
+
+    if (env && *env) {
+	size = strtol(env, NULL, 0);
+    }
+#endif
+    if (size > HAL_SIZE_MAX) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: shared memory size %ld too big, using %ld\n",
+	    size, HAL_SIZE_MAX);
+	size = HAL_SIZE_MAX;
+    }
+    if (size < HAL_SIZE) {
+	size = HAL_SIZE;
+    }
+    /* whole pages */
+    return (size + 4095) & ~4095L;
+}
+
+static int hal_shmem_flags(void)
+{
+#ifndef __KERNEL__
+    const char *env = getenv("HAL_HUGEPAGES");
+
+    if (env && (env[0] == '1' || env[0] == 'y' || env[0] == 'Y')) {
+	return RTAPI_SHMEM_HUGEPAGES;
+    }
+#endif
+    return 0;
+}
+#endif
+
 static void *shmalloc_up(long int size)
 {
     long int tmp_bot;
@@ -3177,6 +3338,10 @@ static hal_funct_entry_t *alloc_funct_entry_struct(void)
 	p->funct_ptr = 0;
 	p->arg = 0;
 	p->funct = 0;
+	p->divisor = 1;
+	p->phase = 0;
+	p->countdown = -1;
+	p->enable_ptr = 0;
     }
     return p;
 }
@@ -3204,6 +3369,7 @@ static hal_thread_t *alloc_thread_struct(void)
 	p->period = 0;
 	p->priority = 0;
 	p->task_id = 0;
+	p->cycles = 0;
 	list_init_entry(&(p->funct_list));
 	p->name[0] = '\0';
     }
@@ -3345,7 +3511,26 @@ static void unlink_pin(hal_pin_t * pin)
 
 static void free_pin_struct(hal_pin_t * pin)
 {
+    rtapi_intptr_t next_thread;
+    hal_thread_t *thread;
+    hal_list_t *list_root, *list_entry;
+    hal_funct_entry_t *funct_entry;
 
+    /* functions enabled by this pin now run unconditionally */
+    next_thread = hal_data->thread_list_ptr;
+    while (next_thread != 0) {
+	thread = SHMPTR(next_thread);
+	list_root = &(thread->funct_list);
+	list_entry = list_next(list_root);
+	while (list_entry != list_root) {
+	    funct_entry = (hal_funct_entry_t *) list_entry;
+	    if (funct_entry->enable_ptr == SHMOFF(pin)) {
+		funct_entry->enable_ptr = 0;
+	    }
+	    list_entry = list_next(list_entry);
+	}
+	next_thread = thread->next_ptr;
+    }
     unlink_pin(pin);
     /* clear contents of struct */
     if ( pin->oldname != 0 ) free_oldname_struct(SHMPTR(pin->oldname));
@@ -3477,6 +3662,10 @@ static void free_funct_entry_struct(hal_funct_entry_t * funct_entry)
     funct_entry->funct_ptr = 0;
     funct_entry->arg = 0;
     funct_entry->funct = 0;
+    funct_entry->divisor = 1;
+    funct_entry->phase = 0;
+    funct_entry->countdown = -1;
+    funct_entry->enable_ptr = 0;
     /* add it to free list */
     list_add_after((hal_list_t *) funct_entry, &(hal_data->funct_entry_free));
 }
@@ -4048,6 +4237,55 @@ int hal_stream_read(hal_stream_t *stream, union hal_stream_data *buf, unsigned *
     return 0;
 }
 
+/* Bulk versions of hal_stream_read and hal_stream_write.  Samples are
+   packed in buf without sample numbers, num_pins elements each.  The
+   fifo index is only published once per call, so a userspace reader or
+   writer that keeps up with a fast thread pays for one handoff per batch
+   instead of one per sample. */
+int hal_stream_read_many(hal_stream_t *stream, union hal_stream_data *buf,
+        unsigned *this_sample, int count) {
+    int out = hal_stream_atomic_load_out(stream),
+        in = hal_stream_atomic_load_in(stream);
+    int num_pins = stream->fifo->num_pins;
+    int stride = num_pins + 1;
+    int n;
+    if(in == out) {
+        stream->fifo->num_underruns ++;
+        return 0;
+    }
+    for(n = 0; n < count && out != in; n++) {
+        union hal_stream_data *dptr = &stream->fifo->data[out * stride];
+        memcpy(buf + n * num_pins, dptr, sizeof(union hal_stream_data) * num_pins);
+        if(this_sample) this_sample[n] = dptr[num_pins].s;
+        out = hal_stream_advance(stream, out);
+    }
+    hal_stream_atomic_store_out(stream, out);
+    return n;
+}
+
+int hal_stream_write_many(hal_stream_t *stream, union hal_stream_data *buf,
+        int count) {
+    int in = hal_stream_atomic_load_in(stream),
+        out = hal_stream_atomic_load_out(stream);
+    int num_pins = stream->fifo->num_pins;
+    int stride = num_pins + 1;
+    int n, newin;
+    for(n = 0; n < count; n++) {
+        newin = hal_stream_advance(stream, in);
+        if(newin == out) break;
+        union hal_stream_data *dptr = &stream->fifo->data[in * stride];
+        memcpy(dptr, buf + n * num_pins, sizeof(union hal_stream_data) * num_pins);
+        dptr[num_pins].s = ++stream->fifo->this_sample;
+        in = newin;
+    }
+    if(n == 0) {
+        stream->fifo->num_overruns++;
+        return 0;
+    }
+    hal_stream_atomic_store_in(stream, in);
+    return n;
+}
+
 int hal_stream_attach(hal_stream_t *stream, int comp_id, int key, const char *typestring) {
     int i;
 
@@ -4187,6 +4425,7 @@ EXPORT_SYMBOL(hal_export_funct);
 EXPORT_SYMBOL(hal_create_thread);
 
 EXPORT_SYMBOL(hal_add_funct_to_thread);
+EXPORT_SYMBOL(hal_add_funct_to_thread_divided);
 EXPORT_SYMBOL(hal_del_funct_from_thread);
 
 EXPORT_SYMBOL(hal_start_threads);
@@ -4196,6 +4435,8 @@ EXPORT_SYMBOL(hal_shmem_base);
 EXPORT_SYMBOL(halpr_find_comp_by_name);
 EXPORT_SYMBOL(halpr_find_pin_by_name);
 EXPORT_SYMBOL(halpr_find_sig_by_name);
+EXPORT_SYMBOL(halpr_signal_new);
+EXPORT_SYMBOL(halpr_link);
 EXPORT_SYMBOL(halpr_find_param_by_name);
 EXPORT_SYMBOL(halpr_find_thread_by_name);
 EXPORT_SYMBOL(halpr_find_funct_by_name);
@@ -4228,6 +4469,8 @@ EXPORT_SYMBOL_GPL(hal_stream_depth);
 EXPORT_SYMBOL_GPL(hal_stream_maxdepth);
 EXPORT_SYMBOL_GPL(hal_stream_write);
 EXPORT_SYMBOL_GPL(hal_stream_read);
+EXPORT_SYMBOL_GPL(hal_stream_write_many);
+EXPORT_SYMBOL_GPL(hal_stream_read_many);
 EXPORT_SYMBOL_GPL(hal_stream_attach);
 EXPORT_SYMBOL_GPL(hal_stream_detach);
 EXPORT_SYMBOL_GPL(hal_stream_element_count);
@@ -108,7 +108,7 @@ RTAPI_BEGIN_DECLS
 /* offset 0 is reserved for a null-ish pointer, so SHMCHK(hal_shmem_base) is
    false by design */
 #define SHMCHK(ptr)  ( ((char *)(ptr)) > (hal_shmem_base) && \
-                       ((char *)(ptr)) < (hal_shmem_base + HAL_SIZE) )
+                       ((char *)(ptr)) < (hal_shmem_base + hal_data->shmem_size) )
 
 /** The good news is that none of this linked list complexity is
     visible to the components that use this API.  Complexity here
@@ -162,6 +162,7 @@ typedef struct {
 			        /* prefix of name for new instance */
     char constructor_arg[HAL_NAME_LEN+1];
 			        /* prefix of name for new instance */
+    long shmem_size;		/* size of the shmem block */
     rtapi_intptr_t shmem_bot;		/* bottom of free shmem (first free byte) */
     rtapi_intptr_t shmem_top;		/* top of free shmem (1 past last free) */
     rtapi_intptr_t comp_list_ptr;		/* root of linked list of components */
@@ -279,6 +280,11 @@ typedef struct {
     void *arg;			/* argument for function */
     void (*funct) (void *, long);	/* ptr to function code */
     int funct_ptr;		/* pointer to function */
+    int divisor;		/* run every 'divisor' periods... */
+    int phase;			/* ...when period count % divisor == phase */
+    int countdown;		/* periods until it next runs, or -1 until
+				   the thread has lined it up with phase */
+    int enable_ptr;		/* bit pin that must be true to run, or 0 */
 } hal_funct_entry_t;
 
 #define HAL_STACKSIZE 16384	/* realtime task stacksize */
@@ -292,6 +298,7 @@ typedef struct {
     hal_s32_t* runtime;	/* (pin) duration of last run, in CPU cycles */
     hal_s32_t maxtime;	/* (param) duration of longest run, in CPU cycles */
     hal_list_t funct_list;	/* list of functions to run */
+    rtapi_u64 cycles;		/* periods run since the thread started */
     char name[HAL_NAME_LEN + 1];	/* thread name */
     int comp_id;
 } hal_thread_t;
@@ -319,8 +326,11 @@ typedef struct {
 */
 
 #define HAL_KEY   0x48414C32	/* key used to open HAL shared memory */
-#define HAL_VER   0x0000000F	/* version code */
+#define HAL_VER   0x00000012	/* version code */
+/* Default and smallest size of the shmem block.  Whoever creates the
+   block can make it bigger, see hal_shmem_size() in hal_lib.c */
 #define HAL_SIZE  (85*4096)
+#define HAL_SIZE_MAX  (1024L*1024*1024)
 #define HAL_PSEUDO_COMP_PREFIX "__" /* prefix to identify a pseudo component */
 
 /* These pointers are set by hal_init() to point to the shmem block
@@ -417,6 +427,18 @@ extern hal_funct_t *halpr_find_funct_by_owner(hal_comp_t * owner,
 */
 extern hal_pin_t *halpr_find_pin_by_sig(hal_sig_t * sig, hal_pin_t * start);
 
+/** 'halpr_signal_new()' and 'halpr_link()' do the work of 'hal_signal_new()'
+    and 'hal_link()' for a caller that already holds the HAL mutex and has
+    found the objects involved, so that many of them can be done under a
+    single lock.  'halpr_signal_new()' does not check for a duplicate name.
+    If 'after' is not NULL, it must be a signal whose name sorts before
+    'name'; the search for the place to insert the new signal starts there.
+    The new signal is returned in '*sig' if 'sig' is not NULL.
+*/
+extern int halpr_signal_new(const char *name, hal_type_t type,
+    hal_sig_t *after, hal_sig_t **sig);
+extern int halpr_link(hal_pin_t *pin, hal_sig_t *sig);
+
 
 /** hal_port_alloc allocates a new empty hal_port having a buffer of size bytes. 
     returns a negative value on failure or a hal_port_t which can be used with
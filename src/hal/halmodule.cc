@@ -21,6 +21,7 @@
 #include <structmember.h>
 #include <string>
 #include <map>
+#include <vector>
 using namespace std;
 
 #include "config.h"
@@ -539,6 +540,8 @@ static PyObject *pyhal_set_prefix(PyObject *_self, PyObject *args) {
     Py_RETURN_NONE;
 }
 
+static PyObject *pyhal_new_group(PyObject *_self, PyObject *o);
+
 static PyMethodDef hal_methods[] = {
     {"setprefix", pyhal_set_prefix, METH_VARARGS,
         "Set the prefix for newly created pins and parameters"},
@@ -550,6 +553,8 @@ static PyMethodDef hal_methods[] = {
         "Create a new pin"},
     {"getitem", pyhal_get_pin, METH_VARARGS,
         "Get existing pin object"},
+    {"newgroup", pyhal_new_group, METH_O,
+        "Create a pin group from a list of pin and parameter names"},
     {"exit", pyhal_exit, METH_NOARGS,
         "Call hal_exit"},
     {"ready", pyhal_ready, METH_NOARGS,
@@ -766,6 +771,324 @@ static PyObject * pyhal_pin_new(halitem * pin, const char * name) {
     return (PyObject *) pypin;
 }
 
+// A pin group reads or writes many items of one component in a single
+// call.  The names are looked up once, when the group is made, and the
+// values are kept as doubles in an array.array('d') owned by the group,
+// which Python code sees through a memoryview.  Bits are 0.0 or 1.0.
+struct pingroupobject {
+    PyObject_HEAD
+    halobject *comp;
+    std::vector<halitem> *items;
+    PyObject *names;
+    PyObject *store;            // the array.array holding the values
+    Py_buffer storebuf;         // held for as long as the group exists
+    double *values;             // storebuf.buf
+    Py_ssize_t count;
+    PyObject *view;
+};
+
+static double pingroup_get(const halitem &item) {
+    if(item.is_pin) {
+        switch(item.type) {
+            case HAL_BIT: return *(item.u->pin.b) ? 1.0 : 0.0;
+            case HAL_U32: return *(item.u->pin.u32);
+            case HAL_S32: return *(item.u->pin.s32);
+            case HAL_FLOAT: return *(item.u->pin.f);
+            default: return 0.0;
+        }
+    } else {
+        switch(item.type) {
+            case HAL_BIT: return item.u->param.b ? 1.0 : 0.0;
+            case HAL_U32: return item.u->param.u32;
+            case HAL_S32: return item.u->param.s32;
+            case HAL_FLOAT: return item.u->param.f;
+            default: return 0.0;
+        }
+    }
+}
+
+// input pins and read-only parameters are not written, so one group
+// can cover both the inputs and the outputs of a component.  I/O pins
+// are only written when the value changes, since driving them again
+// with the same value can look like a new event to the other side.
+static void pingroup_set(const halitem &item, double v) {
+    if(item.is_pin) {
+        if(item.dir.pindir == HAL_IN) return;
+        if(item.dir.pindir == HAL_IO && pingroup_get(item) == v) return;
+        switch(item.type) {
+            case HAL_BIT: *(item.u->pin.b) = v != 0.0; break;
+            case HAL_U32: *(item.u->pin.u32) = v < 0.0 ? 0 : (rtapi_u32)v; break;
+            case HAL_S32: *(item.u->pin.s32) = (rtapi_s32)v; break;
+            case HAL_FLOAT: *(item.u->pin.f) = v; break;
+            default: break;
+        }
+    } else {
+        if(item.dir.paramdir == HAL_RO) return;
+        switch(item.type) {
+            case HAL_BIT: item.u->param.b = v != 0.0; break;
+            case HAL_U32: item.u->param.u32 = v < 0.0 ? 0 : (rtapi_u32)v; break;
+            case HAL_S32: item.u->param.s32 = (rtapi_s32)v; break;
+            case HAL_FLOAT: item.u->param.f = v; break;
+            default: break;
+        }
+    }
+}
+
+static bool pingroup_live(pingroupobject *self) {
+    if(!self->comp || self->comp->hal_id <= 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Invalid operation on closed HAL component");
+        return false;
+    }
+    return true;
+}
+
+// get a contiguous buffer of at least self->count doubles from o
+static bool pingroup_get_buffer(pingroupobject *self, PyObject *o,
+        Py_buffer *view, int flags) {
+    if(PyObject_GetBuffer(o, view, flags | PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) < 0)
+        return false;
+    if(view->itemsize != sizeof(double)
+            || !view->format || strcmp(view->format, "d")) {
+        PyErr_SetString(PyExc_TypeError, "buffer must hold doubles (format 'd')");
+        PyBuffer_Release(view);
+        return false;
+    }
+    if(view->len < self->count * (Py_ssize_t)sizeof(double)) {
+        PyErr_Format(PyExc_ValueError, "buffer holds %zd values, group has %zd",
+            view->len / (Py_ssize_t)sizeof(double), self->count);
+        PyBuffer_Release(view);
+        return false;
+    }
+    return true;
+}
+
+static PyObject *pingroup_read(PyObject *_self, PyObject *unused) {
+    pingroupobject *self = (pingroupobject *)_self;
+    if(!pingroup_live(self)) return NULL;
+
+    const std::vector<halitem> &items = *self->items;
+    for(Py_ssize_t i = 0; i < self->count; i++)
+        self->values[i] = pingroup_get(items[i]);
+    Py_INCREF(self->view);
+    return self->view;
+}
+
+static PyObject *pingroup_read_into(PyObject *_self, PyObject *o) {
+    pingroupobject *self = (pingroupobject *)_self;
+    Py_buffer view;
+    if(!pingroup_live(self)) return NULL;
+    if(!pingroup_get_buffer(self, o, &view, PyBUF_WRITABLE)) return NULL;
+
+    const std::vector<halitem> &items = *self->items;
+    double *out = (double *)view.buf;
+    for(Py_ssize_t i = 0; i < self->count; i++)
+        out[i] = pingroup_get(items[i]);
+    PyBuffer_Release(&view);
+    Py_RETURN_NONE;
+}
+
+static PyObject *pingroup_write(PyObject *_self, PyObject *args) {
+    pingroupobject *self = (pingroupobject *)_self;
+    PyObject *o = NULL;
+    if(!PyArg_ParseTuple(args, "|O:write", &o)) return NULL;
+    if(!pingroup_live(self)) return NULL;
+
+    const std::vector<halitem> &items = *self->items;
+    if(!o) {
+        for(Py_ssize_t i = 0; i < self->count; i++)
+            pingroup_set(items[i], self->values[i]);
+        Py_RETURN_NONE;
+    }
+
+    if(PyObject_CheckBuffer(o)) {
+        Py_buffer view;
+        if(!pingroup_get_buffer(self, o, &view, PyBUF_SIMPLE)) return NULL;
+        const double *in = (const double *)view.buf;
+        for(Py_ssize_t i = 0; i < self->count; i++)
+            pingroup_set(items[i], in[i]);
+        PyBuffer_Release(&view);
+        Py_RETURN_NONE;
+    }
+
+    PyObject *seq = PySequence_Fast(o, "write() needs a buffer or a sequence");
+    if(!seq) return NULL;
+    if(PySequence_Fast_GET_SIZE(seq) != self->count) {
+        PyErr_Format(PyExc_ValueError, "got %zd values, group has %zd",
+            PySequence_Fast_GET_SIZE(seq), self->count);
+        Py_DECREF(seq);
+        return NULL;
+    }
+    // convert everything before writing anything
+    PyObject **v = PySequence_Fast_ITEMS(seq);
+    for(Py_ssize_t i = 0; i < self->count; i++) {
+        self->values[i] = PyFloat_AsDouble(v[i]);
+        if(self->values[i] == -1.0 && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            return NULL;
+        }
+    }
+    Py_DECREF(seq);
+    for(Py_ssize_t i = 0; i < self->count; i++)
+        pingroup_set(items[i], self->values[i]);
+    Py_RETURN_NONE;
+}
+
+static PyObject *pingroup_get_values(PyObject *_self, void *unused) {
+    pingroupobject *self = (pingroupobject *)_self;
+    Py_INCREF(self->view);
+    return self->view;
+}
+
+static PyObject *pingroup_get_names(PyObject *_self, void *unused) {
+    pingroupobject *self = (pingroupobject *)_self;
+    Py_INCREF(self->names);
+    return self->names;
+}
+
+static Py_ssize_t pingroup_len(PyObject *_self) {
+    return ((pingroupobject *)_self)->count;
+}
+
+static void pingroup_delete(PyObject *_self) {
+    pingroupobject *self = (pingroupobject *)_self;
+    Py_XDECREF(self->view);
+    if(self->storebuf.obj)
+        PyBuffer_Release(&self->storebuf);
+    Py_XDECREF(self->store);
+    Py_XDECREF(self->names);
+    Py_XDECREF(self->comp);
+    delete self->items;
+    Py_TYPE(self)->tp_free(self);
+}
+
+static PyObject *pingroup_repr(PyObject *_self) {
+    pingroupobject *self = (pingroupobject *)_self;
+    return PyStr_FromFormat("<hal pin group of %zd items>", self->count);
+}
+
+static PyMethodDef pingroup_methods[] = {
+    {"read", pingroup_read, METH_NOARGS,
+        "Read every item into the group's buffer and return it as a memoryview"},
+    {"read_into", pingroup_read_into, METH_O,
+        "Read every item into a writable buffer of doubles"},
+    {"write", pingroup_write, METH_VARARGS,
+        "Write the output pins and writable parameters of the group from a\n"
+        "buffer of doubles or a sequence of numbers, or from the group's own\n"
+        "buffer if no argument is given.  Input pins are left alone."},
+    {NULL},
+};
+
+// "deprecated conversion from string constant to 'char *'" occurs due to
+// missing const-qualifications in Python headers
+#pragma GCC diagnostic ignored "-Wwrite-strings"
+static PyGetSetDef pingroup_getset[] = {
+    {"values", pingroup_get_values, NULL,
+        "memoryview of the group's buffer, updated by read()", NULL},
+    {"names", pingroup_get_names, NULL, "names of the items in the group", NULL},
+    {}
+};
+#pragma GCC diagnostic warning "-Wwrite-strings"
+
+static PySequenceMethods pingroup_sequence = {
+    pingroup_len,              /*sq_length*/
+};
+
+static
+PyTypeObject pingroup_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "hal.pingroup",            /*tp_name*/
+    sizeof(pingroupobject),    /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    pingroup_delete,           /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    pingroup_repr,             /*tp_repr*/
+    0,                         /*tp_as_number*/
+    &pingroup_sequence,        /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,        /*tp_flags*/
+    "HAL Pin Group",           /*tp_doc*/
+    0,                         /*tp_traverse*/
+    0,                         /*tp_clear*/
+    0,                         /*tp_richcompare*/
+    0,                         /*tp_weaklistoffset*/
+    0,                         /*tp_iter*/
+    0,                         /*tp_iternext*/
+    pingroup_methods,          /*tp_methods*/
+    0,                         /*tp_members*/
+    pingroup_getset,           /*tp_getset*/
+};
+
+static PyObject *pyhal_new_group(PyObject *_self, PyObject *o) {
+    halobject *self = (halobject *)_self;
+    PyObject *array_mod, *zeros;
+    EXCEPTION_IF_NOT_LIVE(NULL);
+
+    PyObject *seq = PySequence_Fast(o, "newgroup() needs a sequence of names");
+    if(!seq) return NULL;
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(seq);
+
+    pingroupobject *group = PyObject_New(pingroupobject, &pingroup_type);
+    if(!group) {
+        Py_DECREF(seq);
+        return NULL;
+    }
+    group->comp = NULL;
+    group->names = NULL;
+    group->store = NULL;
+    group->values = NULL;
+    group->storebuf.obj = NULL;
+    group->view = NULL;
+    group->count = count;
+    group->items = new std::vector<halitem>();
+    group->items->reserve(count);
+
+    for(Py_ssize_t i = 0; i < count; i++) {
+        halitem *item = find_item(self, PyStr_AsString(PySequence_Fast_GET_ITEM(seq, i)));
+        if(!item) goto fail;
+        group->items->push_back(*item);
+    }
+    group->names = PySequence_Tuple(seq);
+    if(!group->names) goto fail;
+    Py_INCREF(self);
+    group->comp = self;
+
+    array_mod = PyImport_ImportModule("array");
+    if(!array_mod) goto fail;
+    zeros = PyBytes_FromStringAndSize(NULL, count * sizeof(double));
+    if(!zeros) {
+        Py_DECREF(array_mod);
+        goto fail;
+    }
+    memset(PyBytes_AS_STRING(zeros), 0, count * sizeof(double));
+    group->store = PyObject_CallMethod(array_mod, "array", "sO", "d", zeros);
+    Py_DECREF(zeros);
+    Py_DECREF(array_mod);
+    if(!group->store) goto fail;
+    // holding the buffer also stops the array from being resized
+    if(PyObject_GetBuffer(group->store, &group->storebuf, PyBUF_WRITABLE) < 0)
+        goto fail;
+    group->values = (double *)group->storebuf.buf;
+    group->view = PyMemoryView_FromObject(group->store);
+    if(!group->view) goto fail;
+
+    Py_DECREF(seq);
+    return (PyObject *)group;
+
+fail:
+    Py_DECREF(seq);
+    Py_DECREF(group);
+    return NULL;
+}
+
 PyObject *pin_has_writer(PyObject *self, PyObject *args) {
     char *name;
     if(!PyArg_ParseTuple(args, "s", &name)) return NULL;
@@ -1541,10 +1864,12 @@ MODULE_INIT_FUNC(_hal)
     PyType_Ready(&shm_type);
     PyType_Ready(&halpin_type);
     PyType_Ready(&stream_type);
+    PyType_Ready(&pingroup_type);
     PyModule_AddObject(m, "component", (PyObject*)&halobject_type);
     PyModule_AddObject(m, "shm", (PyObject*)&shm_type);
     PyModule_AddObject(m, "item", (PyObject*)&halpin_type);
     PyModule_AddObject(m, "stream", (PyObject*)&stream_type);
+    PyModule_AddObject(m, "pingroup", (PyObject*)&pingroup_type);
 
     PyModule_AddIntConstant(m, "MSG_NONE", RTAPI_MSG_NONE);
     PyModule_AddIntConstant(m, "MSG_ERR", RTAPI_MSG_ERR);
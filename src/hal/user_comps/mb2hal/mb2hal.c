@@ -115,17 +115,25 @@ QUIT_CLEANUP:
  * One thread loop for each link
  * The LOGIC is here
  * thrd_link_num is the corresponding link of this thread (int *)
+ *
+ * The transactions of the link are run earliest deadline first: each
+ * time the one whose next_time is oldest goes next, and if none is due
+ * yet the thread sleeps until the first one is. A transaction with a low
+ * MAX_UPDATE_RATE so only takes bus time when it is due, and fast ones
+ * are not held up cycling past it.
  */
 
 void *link_loop_and_logic(void *thrd_link_num)
 {
     char *fnct_name = "link_loop_and_logic";
-    int ret, ret_available, ret_connected;
-    int tx_counter;
+    int ret, ret_connected;
+    int counter, ngroup, first_addr, nelem;
+    double wait, start, end;
     mb_tx_t   *this_mb_tx = NULL;
     int        this_mb_tx_num;
     mb_link_t *this_mb_link = NULL;
     int        this_mb_link_num;
+    mb_tx_t  **group;
 
     if (thrd_link_num == NULL) {
         ERR(gbl.init_dbg, "NULL pointer");
@@ -138,53 +146,59 @@ void *link_loop_and_logic(void *thrd_link_num)
     }
     this_mb_link = &gbl.mb_links[this_mb_link_num];
 
+    group = malloc(sizeof(mb_tx_t *) * gbl.tot_mb_tx);
+    if (group == NULL) {
+        ERR(gbl.init_dbg, "malloc group failed [%s]", strerror(errno));
+        return NULL;
+    }
+
     while (1) {
 
-        for (tx_counter = 0; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+        if (gbl.quit_flag != 0) { //tell the threads to quit (SIGTERM o SGIQUIT) (unloadusr mb2hal).
+            break;
+        }
 
-            if (gbl.quit_flag != 0) { //tell the threads to quit (SIGTERM o SGIQUIT) (unloadusr mb2hal).
-                return NULL;
+        //earliest deadline of this link
+        if (get_next_tx(this_mb_link_num, &this_mb_tx_num, &wait) != retOK) {
+            ERR(gbl.init_dbg, "mb_links[%d] thread[%d] fd[%d] get_next_tx ERR",
+                this_mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
+            break;
+        }
+        if (wait > 0) {
+            if (wait > MB2HAL_MAX_IDLE_MS / 1000.0) {
+                wait = MB2HAL_MAX_IDLE_MS / 1000.0;
             }
+            usleep(wait * 1000 * 1000);
+            continue;
+        }
+        this_mb_tx = &gbl.mb_tx[this_mb_tx_num];
 
-            this_mb_tx_num = tx_counter;
-            this_mb_tx = &gbl.mb_tx[this_mb_tx_num];
+        DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] going to TEST connection",
+            this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
 
-            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] going to TEST availability",
+        //first time connection or reconnection, run time parameters setting
+        if (get_tx_connection(this_mb_tx_num, &ret_connected) != retOK) {
+            ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] get_tx_connection ERR",
                 this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-
-            //corresponding link and time (update_rate)
-            if (is_this_tx_ready(this_mb_link_num, this_mb_tx_num, &ret_available) != retOK) {
-                ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] is_this_tx_ready ERR",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                return NULL;
-            }
-            if (ret_available == 0) {
-                DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] NOT available",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                usleep(1000);
-                continue;
-            }
-
-            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] going to TEST connection",
+            break;
+        }
+        if (ret_connected == 0) {
+            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] NOT connected",
                 this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
+            usleep(1000);
+            continue;
+        }
 
-            //first time connection or reconnection, run time parameters setting
-            if (get_tx_connection(this_mb_tx_num, &ret_connected) != retOK) {
-                ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] get_tx_connection ERR",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                return NULL;
-            }
-            if (ret_connected == 0) {
-                DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] NOT connected",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                usleep(1000);
-                continue;
-            }
-
-            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] lk_dbg[%d] going to EXECUTE transaction",
-                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
-                this_mb_tx->protocol_debug);
+        DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] lk_dbg[%d] going to EXECUTE transaction",
+            this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
+            this_mb_tx->protocol_debug);
 
+        start = get_time();
+        ngroup = coalesce_reads(this_mb_tx, group, &first_addr, &nelem);
+        if (ngroup > 1) {
+            ret = fnct_read_coalesced(group, ngroup, first_addr, nelem, this_mb_link);
+        }
+        else {
             switch (this_mb_tx->mb_tx_fnct) {
             case mbtx_02_READ_DISCRETE_INPUTS:
                 ret = fnct_02_read_discrete_inputs(this_mb_tx, this_mb_link);
@@ -210,97 +224,266 @@ void *link_loop_and_logic(void *thrd_link_num)
                     this_mb_tx->mb_tx_fnct, this_mb_tx->mb_tx_fnct_name, this_mb_tx_num);
                 break;
             }
+        }
+        end = get_time();
 
-            if (gbl.quit_flag != 0) { //tell the threads to quit (SIGTERM o SGIQUIT) (unloadusr mb2hal).
-                return NULL;
-            }
+        if (gbl.quit_flag != 0) { //tell the threads to quit (SIGTERM o SGIQUIT) (unloadusr mb2hal).
+            break;
+        }
+
+        if (ret == retOKwithWarning) { //write skipped, values unchanged
+            this_mb_link->stat_skipped++;
+        }
+        else {
+            update_link_stats(this_mb_link, start, end, this_mb_tx->next_time);
+            this_mb_link->stat_coalesced += ngroup - 1;
+        }
 
-            if (ret != retOK && modbus_get_socket(this_mb_link->modbus) < 0) { //link failure
-                (*this_mb_tx->num_errors)++;
+        for (counter = 0; counter < ngroup; counter++) {
+            this_mb_tx = group[counter];
+
+            if (ret != retOK && ret != retOKwithWarning && modbus_get_socket(this_mb_link->modbus) < 0) { //link failure
+                (**this_mb_tx->num_errors)++;
                 ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] link failure, going to close link",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
+                    this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
                 modbus_close(this_mb_link->modbus);
             }
-            else if (ret != retOK) {  //transaction failure but link OK
+            else if (ret != retOK && ret != retOKwithWarning) {  //transaction failure but link OK
                 (**this_mb_tx->num_errors)++;
                 ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] transaction failure, num_errors[%d]",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), **this_mb_tx->num_errors);
+                    this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), **this_mb_tx->num_errors);
                 // Clear any unread data. Otherwise the link might get out of sync
                 modbus_flush(this_mb_link->modbus);
             }
             else { //transaction and link OK
                 OK(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] transaction OK, update_HZ[%0.03f]",
-                   this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
-                   1.0/(get_time()-this_mb_tx->last_time_ok));
-                this_mb_tx->last_time_ok = get_time();
+                   this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
+                   1.0/(end-this_mb_tx->last_time_ok));
+                this_mb_tx->last_time_ok = end;
                 (**this_mb_tx->num_errors) = 0;
             }
 
             //set the next (waiting) time for update rate
-            this_mb_tx->next_time = get_time() + this_mb_tx->time_increment;
-
-            //wait time for serial lines
-            if (this_mb_tx->cfg_link_type == linkRTU) {
-                DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] SERIAL_DELAY_MS activated [%d]",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
-                    this_mb_tx->cfg_serial_delay_ms);
-                usleep(this_mb_tx->cfg_serial_delay_ms * 1000);
+            this_mb_tx->next_time = end + this_mb_tx->time_increment;
+            //a skipped write took no time on the link, don't spin on it
+            if (ret == retOKwithWarning && this_mb_tx->time_increment < MB2HAL_WRITE_CHECK_MS / 1000.0) {
+                this_mb_tx->next_time = end + MB2HAL_WRITE_CHECK_MS / 1000.0;
             }
+        }
 
-            //wait time to gbl.slowdown activity (debugging)
-            if (gbl.slowdown > 0) {
-                DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] gbl.slowdown activated [%0.3f]",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), gbl.slowdown);
-                usleep(gbl.slowdown * 1000 * 1000);
+        //a reconnection may find a restarted slave, send it everything again
+        if (modbus_get_socket(this_mb_link->modbus) < 0) {
+            for (counter = 0; counter < gbl.tot_mb_tx; counter++) {
+                if (gbl.mb_tx[counter].mb_link_num == this_mb_link_num) {
+                    gbl.mb_tx[counter].wr_valid = 0;
+                }
             }
-        }  //end for
+        }
+
+        //wait time for serial lines, not needed if nothing was sent
+        if (this_mb_tx->cfg_link_type == linkRTU && ret != retOKwithWarning) {
+            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] SERIAL_DELAY_MS activated [%d]",
+                this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
+                this_mb_tx->cfg_serial_delay_ms);
+            usleep(this_mb_tx->cfg_serial_delay_ms * 1000);
+        }
+
+        //wait time to gbl.slowdown activity (debugging)
+        if (gbl.slowdown > 0) {
+            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] gbl.slowdown activated [%0.3f]",
+                this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), gbl.slowdown);
+            usleep(gbl.slowdown * 1000 * 1000);
+        }
 
     } //end while
 
+    free(group);
     return NULL;
 }
 
 /*
- * Check if the transaction is available for this link
+ * Earliest deadline first: the transaction of this link with the oldest
+ * next_time, and how long until it is due (<= 0 if it already is)
  */
 
-retCode is_this_tx_ready(const int this_mb_link_num, const int this_mb_tx_num, int *ret_available)
+retCode get_next_tx(const int this_mb_link_num, int *ret_mb_tx_num, double *ret_wait)
 {
-    char *fnct_name = "is_this_tx_available";
+    char *fnct_name = "get_next_tx";
+    int tx_counter;
     mb_tx_t *this_mb_tx;
-    int this_mb_tx_link_num;
 
-    if (this_mb_tx_num < 0 || this_mb_tx_num > gbl.tot_mb_tx) {
-        ERR(gbl.init_dbg, "parameter out of range this_mb_tx_num[%d]", this_mb_tx_num);
+    if (ret_mb_tx_num == NULL || ret_wait == NULL) {
+        ERR(gbl.init_dbg, "NULL pointer");
         return retERR;
     }
-    this_mb_tx = &gbl.mb_tx[this_mb_tx_num];
 
-    if (ret_available == NULL) {
-        ERR(this_mb_tx->cfg_debug, "NULL pointer");
+    *ret_mb_tx_num = -1;
+    for (tx_counter = 0; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+        this_mb_tx = &gbl.mb_tx[tx_counter];
+        if (this_mb_tx->mb_link_num != this_mb_link_num) {
+            continue;
+        }
+        if (*ret_mb_tx_num < 0 || this_mb_tx->next_time < gbl.mb_tx[*ret_mb_tx_num].next_time) {
+            *ret_mb_tx_num = tx_counter;
+        }
+    }
+    if (*ret_mb_tx_num < 0) {
+        ERR(gbl.init_dbg, "no transactions for link [%d]", this_mb_link_num);
         return retERR;
     }
 
-    this_mb_tx_link_num = this_mb_tx->mb_link_num;
-    if (this_mb_tx_link_num < 0 || this_mb_tx_link_num >= gbl.tot_mb_links) {
-        ERR(this_mb_tx->cfg_debug, "parameter out of range this_mb_tx_link_num[%d]", this_mb_tx_link_num);
-        return retERR;
+    *ret_wait = gbl.mb_tx[*ret_mb_tx_num].next_time - get_time();
+    return retOK;
+}
+
+/*
+ * Read coalescing: collect the transactions of the link that are due now,
+ * read from the same slave with the same function as lead, and whose
+ * ranges overlap or adjoin lead's (or each other's), as long as the whole
+ * range fits in one request. group[0] is lead. Returns the number of
+ * transactions in the group and the range that covers them all.
+ * Writes, and everything when COALESCE_READS=0, are alone in their group.
+ */
+
+int coalesce_reads(mb_tx_t *lead, mb_tx_t **group, int *first_addr, int *nelem)
+{
+    int tx_counter, member, added, ngroup = 1;
+    int lo, hi, max_nelem;
+    double now;
+
+    group[0] = lead;
+    lo = lead->mb_tx_1st_addr;
+    hi = lead->mb_tx_1st_addr + lead->mb_tx_nelem;
+    *first_addr = lo;
+    *nelem = hi - lo;
+
+    switch (lead->mb_tx_fnct) {
+    case mbtx_02_READ_DISCRETE_INPUTS:
+        max_nelem = MB2HAL_MAX_FNCT02_ELEMENTS;
+        break;
+    case mbtx_03_READ_HOLDING_REGISTERS:
+        max_nelem = MB2HAL_MAX_FNCT03_ELEMENTS;
+        break;
+    case mbtx_04_READ_INPUT_REGISTERS:
+        max_nelem = MB2HAL_MAX_FNCT04_ELEMENTS;
+        break;
+    default:
+        return ngroup;
+    }
+    if (!gbl.coalesce_reads) {
+        return ngroup;
     }
 
-    *ret_available = 0; //defaults to not available
+    now = get_time();
+    do {
+        added = 0;
+        for (tx_counter = 0; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+            mb_tx_t *this_mb_tx = &gbl.mb_tx[tx_counter];
+            int a = this_mb_tx->mb_tx_1st_addr;
+            int b = a + this_mb_tx->mb_tx_nelem;
+
+            if (this_mb_tx->mb_link_num != lead->mb_link_num
+                    || this_mb_tx->mb_tx_slave_id != lead->mb_tx_slave_id
+                    || this_mb_tx->mb_tx_fnct != lead->mb_tx_fnct
+                    || this_mb_tx->next_time > now
+                    || a > hi || b < lo
+                    || (b > hi ? b : hi) - (a < lo ? a : lo) > max_nelem) {
+                continue;
+            }
+            for (member = 0; member < ngroup; member++) {
+                if (group[member] == this_mb_tx) {
+                    break;
+                }
+            }
+            if (member < ngroup) {
+                continue;
+            }
+            group[ngroup++] = this_mb_tx;
+            lo = a < lo ? a : lo;
+            hi = b > hi ? b : hi;
+            added = 1;
+        }
+    } while (added);
+
+    *first_addr = lo;
+    *nelem = hi - lo;
+    return ngroup;
+}
+
+/*
+ * Throughput and latency of a link, after each request sent. Totals are
+ * kept for report_link_stats(), the HAL pins are updated every
+ * MB2HAL_STATS_PERIOD seconds.
+ */
+
+void update_link_stats(mb_link_t *this_mb_link, double start, double end, double deadline)
+{
+    double latency = end - start;
+    double elapsed;
 
-    //the tx is not of this link
-    if (this_mb_link_num != this_mb_tx_link_num) {
-        return retOK;
+    if (this_mb_link->stat_requests == 0) {
+        this_mb_link->stat_start = start;
+        this_mb_link->period_start = start;
+    }
+    this_mb_link->stat_requests++;
+    this_mb_link->stat_latency += latency;
+    if (latency > this_mb_link->stat_latency_max) {
+        this_mb_link->stat_latency_max = latency;
+    }
+    //next_time is 0 until the first run
+    if (deadline > 0 && start - deadline > this_mb_link->stat_late_max) {
+        this_mb_link->stat_late_max = start - deadline;
     }
+    this_mb_link->period_requests++;
+    this_mb_link->period_latency += latency;
 
-    //not now
-    if (get_time() < this_mb_tx->next_time) {
-        return retOK;
+    elapsed = end - this_mb_link->period_start;
+    if (elapsed < MB2HAL_STATS_PERIOD) {
+        return;
     }
+    if (this_mb_link->requests != NULL) {
+        **this_mb_link->requests = this_mb_link->stat_requests;
+        **this_mb_link->coalesced = this_mb_link->stat_coalesced;
+        **this_mb_link->skipped_writes = this_mb_link->stat_skipped;
+        **this_mb_link->rate = this_mb_link->period_requests / elapsed;
+        **this_mb_link->latency_ms = this_mb_link->period_latency / this_mb_link->period_requests * 1000.0;
+        **this_mb_link->latency_max_ms = this_mb_link->stat_latency_max * 1000.0;
+        **this_mb_link->late_max_ms = this_mb_link->stat_late_max * 1000.0;
+    }
+    this_mb_link->period_start = end;
+    this_mb_link->period_requests = 0;
+    this_mb_link->period_latency = 0;
+}
 
-    *ret_available = 1; //is available
-    return retOK;
+/*
+ * Summary of each link, printed on exit
+ */
+
+void report_link_stats(void)
+{
+    int counter;
+    double elapsed;
+
+    if (gbl.init_dbg < debugERR) {
+        return;
+    }
+    for (counter = 0; counter < gbl.tot_mb_links; counter++) {
+        mb_link_t *this_mb_link = &gbl.mb_links[counter];
+
+        if (this_mb_link->stat_requests == 0) {
+            continue;
+        }
+        elapsed = get_time() - this_mb_link->stat_start;
+        fprintf(stdout, "%s link %d [%s]: %u requests in %0.1f s (%0.1f/s), %u reads coalesced, %u writes skipped\n",
+                gbl.hal_mod_name, counter,
+                this_mb_link->lp_link_type == linkRTU ? this_mb_link->lp_serial_device : this_mb_link->lp_tcp_ip,
+                this_mb_link->stat_requests, elapsed, this_mb_link->stat_requests / elapsed,
+                this_mb_link->stat_coalesced, this_mb_link->stat_skipped);
+        fprintf(stdout, "%s link %d: latency avg %0.2f ms max %0.2f ms, worst start after deadline %0.2f ms\n",
+                gbl.hal_mod_name, counter,
+                this_mb_link->stat_latency / this_mb_link->stat_requests * 1000.0,
+                this_mb_link->stat_latency_max * 1000.0, this_mb_link->stat_late_max * 1000.0);
+    }
 }
 
 /*
@@ -396,6 +579,7 @@ void set_init_gbl_params()
     gbl.hal_mod_id   = -1;
     gbl.init_dbg     = debugERR; //until readed in config file
     gbl.slowdown     = 0;        //until readed in config file
+    gbl.coalesce_reads = 1;      //until readed in config file
     gbl.mb_tx_fncts[mbtxERR]                         = "";
     gbl.mb_tx_fncts[mbtx_02_READ_DISCRETE_INPUTS]    = "fnct_02_read_discrete_inputs";
     gbl.mb_tx_fncts[mbtx_03_READ_HOLDING_REGISTERS]  = "fnct_03_read_holding_registers";
@@ -434,6 +618,8 @@ void quit_cleanup(void)
 
     DBG(gbl.init_dbg, "started");
 
+    report_link_stats();
+
     for (counter = 0; counter < gbl.tot_mb_links; counter++) {
         if (gbl.mb_links[counter].modbus != NULL) {
             modbus_close(gbl.mb_links[counter].modbus);
@@ -29,6 +29,10 @@
 #define MB2HAL_MAX_FNCT06_ELEMENTS 1
 #define MB2HAL_MAX_FNCT15_ELEMENTS 100
 #define MB2HAL_MAX_FNCT16_ELEMENTS 100
+#define MB2HAL_MAX_WRITE_ELEMENTS  100 //largest of FNCT06, FNCT15 and FNCT16
+#define MB2HAL_MAX_IDLE_MS         100 //longest sleep before checking quit_flag
+#define MB2HAL_WRITE_CHECK_MS        1 //how often unchanged writes are checked again
+#define MB2HAL_STATS_PERIOD        1.0 //seconds between link statistic pin updates
 
 #ifdef MODULE_VERBOSE
 MODULE_VERBOSE(emc2, "component:mb2hal:Userspace HAL component to communicate with one or more Modbus devices");
@@ -86,6 +90,7 @@ typedef struct {
     //cfg_* are others INI config params
     double cfg_update_rate;    //tx update rate
     int    cfg_debug;          //tx debug level (program, may be also protocol)
+    int    cfg_write_on_change; //skip writes when the HAL values are unchanged
     //Modbus protocol debug
     int  protocol_debug;       //Flag debug Modbus protocol
     //internal processing values
@@ -95,6 +100,8 @@ typedef struct {
     double time_increment; //wait time between tx
     double next_time;      //next time for this tx
     double last_time_ok;   //last OK tx time
+    int    wr_valid;       //wr_last holds what the slave was last sent
+    uint16_t wr_last[MB2HAL_MAX_WRITE_ELEMENTS];
     //HAL related params
     char hal_tx_name[HAL_NAME_LEN + 1];
     hal_float_t **float_value;
@@ -125,6 +132,26 @@ typedef struct {
     int mb_link_num;       //corresponding number of this link/thread
     modbus_t *modbus;
     pthread_t thrd;
+    //throughput and latency, totals since start
+    double   stat_start;      //time of first request
+    unsigned stat_requests;   //Modbus requests sent
+    unsigned stat_coalesced;  //transactions served by another one's request
+    unsigned stat_skipped;    //writes skipped, values unchanged
+    double   stat_latency;    //sum of request round trips
+    double   stat_latency_max;
+    double   stat_late_max;   //worst start of a transaction after its deadline
+    //same for the current MB2HAL_STATS_PERIOD
+    double   period_start;
+    unsigned period_requests;
+    double   period_latency;
+    //HAL pins with the above
+    hal_u32_t   **requests;
+    hal_u32_t   **coalesced;
+    hal_u32_t   **skipped_writes;
+    hal_float_t **rate;           //requests per second
+    hal_float_t **latency_ms;     //average round trip
+    hal_float_t **latency_max_ms;
+    hal_float_t **late_max_ms;
 } mb_link_t;
 
 //Structure of global data (gbl_t)
@@ -136,6 +163,7 @@ typedef struct {
     //INI config, common section
     int    init_dbg;
     double slowdown;
+    int    coalesce_reads; //merge reads of adjacent or overlapping ranges
     //HAL related
     int   hal_mod_id;
     char *hal_mod_name;
@@ -154,7 +182,10 @@ extern gbl_t gbl;
 
 //mb2hal.c
 void *link_loop_and_logic(void *thrd_link_num);
-retCode is_this_tx_ready(const int this_mb_link_num, const int this_mb_tx_num, int *ret_available);
+retCode get_next_tx(const int this_mb_link_num, int *ret_mb_tx_num, double *ret_wait);
+int coalesce_reads(mb_tx_t *lead, mb_tx_t **group, int *first_addr, int *nelem);
+void update_link_stats(mb_link_t *this_mb_link, double start, double end, double deadline);
+void report_link_stats(void);
 retCode get_tx_connection(const int mb_tx_num, int *ret_connected);
 void set_init_gbl_params();
 double get_time();
@@ -176,6 +207,7 @@ retCode init_mb_tx();
 //mb2hal_hal.c
 retCode create_HAL_pins();
 retCode create_each_mb_tx_hal_pins(mb_tx_t *mb_tx);
+retCode create_each_mb_link_hal_pins(mb_link_t *mb_link);
 
 //mb2hal_modbus.c
 retCode fnct_15_write_multiple_coils(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link);
@@ -184,3 +216,4 @@ retCode fnct_04_read_input_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_lin
 retCode fnct_03_read_holding_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link);
 retCode fnct_06_write_single_register(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link);
 retCode fnct_16_write_multiple_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link);
+retCode fnct_read_coalesced(mb_tx_t **group, int ngroup, int first_addr, int nelem, mb_link_t *this_mb_link);
@@ -3,7 +3,7 @@
 retCode create_HAL_pins()
 {
     char *fnct_name = "create_HAL_pins";
-    int tx_counter;
+    int tx_counter, lk_counter;
 
     for (tx_counter = 0; tx_counter < gbl.tot_mb_tx; tx_counter++) {
         if (create_each_mb_tx_hal_pins(&gbl.mb_tx[tx_counter]) != retOK) {
@@ -13,6 +13,69 @@ retCode create_HAL_pins()
         }
     }
 
+    for (lk_counter = 0; lk_counter < gbl.tot_mb_links; lk_counter++) {
+        if (create_each_mb_link_hal_pins(&gbl.mb_links[lk_counter]) != retOK) {
+            ERR(gbl.init_dbg, "failed to initialize hal pins in link_num[%d]", lk_counter);
+            return retERR;
+        }
+    }
+
+    return retOK;
+}
+
+/*
+ * Throughput and latency pins of a link, see update_link_stats()
+ */
+
+retCode create_each_mb_link_hal_pins(mb_link_t *mb_link)
+{
+    char *fnct_name = "create_each_mb_link_hal_pins";
+    char hal_pin_prefix[HAL_NAME_LEN + 1];
+    int ret;
+
+    if (mb_link == NULL) {
+        ERR(gbl.init_dbg, "NULL pointer");
+        return retERR;
+    }
+
+    mb_link->requests       = hal_malloc(sizeof(hal_u32_t *));
+    mb_link->coalesced      = hal_malloc(sizeof(hal_u32_t *));
+    mb_link->skipped_writes = hal_malloc(sizeof(hal_u32_t *));
+    mb_link->rate           = hal_malloc(sizeof(hal_float_t *));
+    mb_link->latency_ms     = hal_malloc(sizeof(hal_float_t *));
+    mb_link->latency_max_ms = hal_malloc(sizeof(hal_float_t *));
+    mb_link->late_max_ms    = hal_malloc(sizeof(hal_float_t *));
+    if (mb_link->requests == NULL || mb_link->coalesced == NULL || mb_link->skipped_writes == NULL
+            || mb_link->rate == NULL || mb_link->latency_ms == NULL || mb_link->latency_max_ms == NULL
+            || mb_link->late_max_ms == NULL) {
+        ERR(gbl.init_dbg, "link [%d] NULL hal_malloc", mb_link->mb_link_num);
+        return retERR;
+    }
+
+    ret = snprintf(hal_pin_prefix, HAL_NAME_LEN, "%s.link.%02d", gbl.hal_mod_name, mb_link->mb_link_num);
+    if (ret >= HAL_NAME_LEN || ret < 0) {
+        ERR(gbl.init_dbg, "hal pin name too long");
+        return retERR;
+    }
+    if (0 != hal_pin_u32_newf(HAL_OUT, mb_link->requests, gbl.hal_mod_id, "%s.requests", hal_pin_prefix)
+            || 0 != hal_pin_u32_newf(HAL_OUT, mb_link->coalesced, gbl.hal_mod_id, "%s.coalesced", hal_pin_prefix)
+            || 0 != hal_pin_u32_newf(HAL_OUT, mb_link->skipped_writes, gbl.hal_mod_id, "%s.skipped_writes", hal_pin_prefix)
+            || 0 != hal_pin_float_newf(HAL_OUT, mb_link->rate, gbl.hal_mod_id, "%s.rate", hal_pin_prefix)
+            || 0 != hal_pin_float_newf(HAL_OUT, mb_link->latency_ms, gbl.hal_mod_id, "%s.latency_ms", hal_pin_prefix)
+            || 0 != hal_pin_float_newf(HAL_OUT, mb_link->latency_max_ms, gbl.hal_mod_id, "%s.latency_max_ms", hal_pin_prefix)
+            || 0 != hal_pin_float_newf(HAL_OUT, mb_link->late_max_ms, gbl.hal_mod_id, "%s.late_max_ms", hal_pin_prefix)) {
+        ERR(gbl.init_dbg, "[%s] hal_pin_newf failed", hal_pin_prefix);
+        return retERR;
+    }
+    **mb_link->requests = 0;
+    **mb_link->coalesced = 0;
+    **mb_link->skipped_writes = 0;
+    **mb_link->rate = 0;
+    **mb_link->latency_ms = 0;
+    **mb_link->latency_max_ms = 0;
+    **mb_link->late_max_ms = 0;
+    DBG(gbl.init_dbg, "link [%d] pin prefix [%s]", mb_link->mb_link_num, hal_pin_prefix);
+
     return retOK;
 }
 
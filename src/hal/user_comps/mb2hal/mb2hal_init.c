@@ -101,6 +101,10 @@ retCode parse_common_section()
     iniFindDouble(gbl.ini_file_ptr, tag, section, &gbl.slowdown);
     DBG(gbl.init_dbg, "[%s] [%s] [%0.3f]", section, tag, gbl.slowdown);
 
+    tag     = "COALESCE_READS"; //optional
+    iniFindInt(gbl.ini_file_ptr, tag, section, &gbl.coalesce_reads);
+    DBG(gbl.init_dbg, "[%s] [%s] [%d]", section, tag, gbl.coalesce_reads);
+
     tag     = "TOTAL_TRANSACTIONS"; //required
     if (iniFindInt(gbl.ini_file_ptr, tag, section, &gbl.tot_mb_tx) != 0) {
         ERR(gbl.init_dbg, "required [%s] [%s] not found", section, tag);
@@ -333,6 +337,17 @@ retCode parse_transaction_section(const int mb_tx_num)
     }
     DBG(gbl.init_dbg, "[%s] [%s] [%d]", section, tag, this_mb_tx->cfg_debug);
 
+    tag = "WRITE_ON_CHANGE"; //optional
+    this_mb_tx->cfg_write_on_change = 1; //default
+    if (iniFindInt(gbl.ini_file_ptr, tag, section, &this_mb_tx->cfg_write_on_change) != 0) { //not found
+        if (mb_tx_num > 0) { //previous value?
+            if (strcasecmp(this_mb_tx->cfg_link_type_str, gbl.mb_tx[mb_tx_num-1].cfg_link_type_str) == 0) {
+                this_mb_tx->cfg_write_on_change = gbl.mb_tx[mb_tx_num-1].cfg_write_on_change;
+            }
+        }
+    }
+    DBG(gbl.init_dbg, "[%s] [%s] [%d]", section, tag, this_mb_tx->cfg_write_on_change);
+
     tag = "MB_TX_CODE"; //required
     tmpstr = iniFind(gbl.ini_file_ptr, tag, section);
     if (tmpstr != NULL) {
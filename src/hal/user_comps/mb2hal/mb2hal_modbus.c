@@ -1,6 +1,28 @@
 #include <sys/time.h>
 #include "mb2hal.h"
 
+/*
+ * Write on change: compare the values about to be written with the ones
+ * the slave was last sent. Returns 1 if they are the same and the write
+ * can be skipped, otherwise remembers them and returns 0. A failed write
+ * clears wr_valid, so the values are sent again next time.
+ */
+
+static int write_unchanged(mb_tx_t *this_mb_tx, const uint16_t *data, int nelem)
+{
+    char *fnct_name = "write_unchanged";
+
+    if (this_mb_tx->cfg_write_on_change && this_mb_tx->wr_valid
+            && memcmp(this_mb_tx->wr_last, data, nelem * sizeof(uint16_t)) == 0) {
+        DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] values unchanged, not sent",
+            this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num);
+        return 1;
+    }
+    memcpy(this_mb_tx->wr_last, data, nelem * sizeof(uint16_t));
+    this_mb_tx->wr_valid = 1;
+    return 0;
+}
+
 retCode fnct_02_read_discrete_inputs(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
 {
     char *fnct_name = "fnct_02_read_discrete_inputs";
@@ -118,6 +140,7 @@ retCode fnct_06_write_single_register(mb_tx_t *this_mb_tx, mb_link_t *this_mb_li
 {
     char *fnct_name = "fnct_06_write_single_register";
     int ret, data;
+    uint16_t wr_data;
 
     if (this_mb_tx == NULL || this_mb_link == NULL) {
         return retERR;
@@ -128,6 +151,11 @@ retCode fnct_06_write_single_register(mb_tx_t *this_mb_tx, mb_link_t *this_mb_li
 
     float val = *(this_mb_tx->float_value[0]);
     data = (int) val;
+    wr_data = data;
+
+    if (write_unchanged(this_mb_tx, &wr_data, 1)) {
+        return retOKwithWarning;
+    }
 
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
         this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id,
@@ -135,6 +163,7 @@ retCode fnct_06_write_single_register(mb_tx_t *this_mb_tx, mb_link_t *this_mb_li
 
     ret = modbus_write_register(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, data);
     if (ret < 0) {
+        this_mb_tx->wr_valid = 0;
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
         }
@@ -152,6 +181,7 @@ retCode fnct_15_write_multiple_coils(mb_tx_t *this_mb_tx, mb_link_t *this_mb_lin
     char *fnct_name = "fnct_15_write_multiple_coils";
     int counter, ret;
     uint8_t bits[MB2HAL_MAX_FNCT15_ELEMENTS];
+    uint16_t wr_data[MB2HAL_MAX_FNCT15_ELEMENTS];
 
     if (this_mb_tx == NULL || this_mb_link == NULL) {
         return retERR;
@@ -162,6 +192,11 @@ retCode fnct_15_write_multiple_coils(mb_tx_t *this_mb_tx, mb_link_t *this_mb_lin
 
     for (counter = 0; counter < this_mb_tx->mb_tx_nelem; counter++) {
         bits[counter] = *(this_mb_tx->bit[counter]);
+        wr_data[counter] = bits[counter];
+    }
+
+    if (write_unchanged(this_mb_tx, wr_data, this_mb_tx->mb_tx_nelem)) {
+        return retOKwithWarning;
     }
 
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
@@ -170,6 +205,7 @@ retCode fnct_15_write_multiple_coils(mb_tx_t *this_mb_tx, mb_link_t *this_mb_lin
 
     ret = modbus_write_bits(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem, bits);
     if (ret < 0) {
+        this_mb_tx->wr_valid = 0;
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
         }
@@ -202,11 +238,71 @@ retCode fnct_16_write_multiple_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb
         data[counter] = (int) val;
     }
 
+    if (write_unchanged(this_mb_tx, data, this_mb_tx->mb_tx_nelem)) {
+        return retOKwithWarning;
+    }
+
     DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d]",
         this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id,
         modbus_get_socket(this_mb_link->modbus), this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem);
 
     ret = modbus_write_registers(this_mb_link->modbus, this_mb_tx->mb_tx_1st_addr, this_mb_tx->mb_tx_nelem, data);
+    if (ret < 0) {
+        this_mb_tx->wr_valid = 0;
+        if (modbus_get_socket(this_mb_link->modbus) < 0) {
+            modbus_close(this_mb_link->modbus);
+        }
+        ERR(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] = ret[%d] fd[%d]",
+            this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id, ret,
+            modbus_get_socket(this_mb_link->modbus));
+        return retERR;
+    }
+
+    return retOK;
+}
+
+/*
+ * One read for a group of transactions found by coalesce_reads(): all
+ * have the same slave and read function, and their ranges together are
+ * first_addr .. first_addr + nelem - 1 without gaps. group[0] leads.
+ */
+
+retCode fnct_read_coalesced(mb_tx_t **group, int ngroup, int first_addr, int nelem, mb_link_t *this_mb_link)
+{
+    char *fnct_name = "fnct_read_coalesced";
+    mb_tx_t *this_mb_tx;
+    int counter, member, ret;
+    uint8_t bits[MB2HAL_MAX_FNCT02_ELEMENTS];
+    uint16_t data[MB2HAL_MAX_FNCT03_ELEMENTS];
+
+    if (group == NULL || ngroup < 1 || this_mb_link == NULL) {
+        return retERR;
+    }
+    this_mb_tx = group[0];
+    if (nelem > MB2HAL_MAX_FNCT02_ELEMENTS || nelem > MB2HAL_MAX_FNCT03_ELEMENTS
+            || nelem > MB2HAL_MAX_FNCT04_ELEMENTS) {
+        return retERR;
+    }
+
+    DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d] for %d transactions",
+        this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_slave_id,
+        modbus_get_socket(this_mb_link->modbus), first_addr, nelem, ngroup);
+
+    switch (this_mb_tx->mb_tx_fnct) {
+    case mbtx_02_READ_DISCRETE_INPUTS:
+        ret = modbus_read_input_bits(this_mb_link->modbus, first_addr, nelem, bits);
+        break;
+    case mbtx_03_READ_HOLDING_REGISTERS:
+        ret = modbus_read_registers(this_mb_link->modbus, first_addr, nelem, data);
+        break;
+    case mbtx_04_READ_INPUT_REGISTERS:
+        ret = modbus_read_input_registers(this_mb_link->modbus, first_addr, nelem, data);
+        break;
+    default:
+        ERR(this_mb_tx->cfg_debug, "mb_tx[%d] [%s] cannot be coalesced",
+            this_mb_tx->mb_tx_num, this_mb_tx->mb_tx_fnct_name);
+        return retERR;
+    }
     if (ret < 0) {
         if (modbus_get_socket(this_mb_link->modbus) < 0) {
             modbus_close(this_mb_link->modbus);
@@ -217,5 +313,21 @@ retCode fnct_16_write_multiple_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb
         return retERR;
     }
 
+    for (member = 0; member < ngroup; member++) {
+        mb_tx_t *tx = group[member];
+        int offset = tx->mb_tx_1st_addr - first_addr;
+
+        for (counter = 0; counter < tx->mb_tx_nelem; counter++) {
+            if (tx->mb_tx_fnct == mbtx_02_READ_DISCRETE_INPUTS) {
+                *(tx->bit[counter]) = bits[offset + counter];
+            }
+            else {
+                float val = data[offset + counter];
+                *(tx->float_value[counter]) = val;
+                *(tx->int_value[counter]) = (hal_s32_t) val;
+            }
+        }
+    }
+
     return retOK;
 }
@@ -0,0 +1,943 @@
+/** This file, 'halcmd_batch.c', implements batch mode for halcmd
+    ('halcmd -B -f file...').
+
+    In batch mode the whole input is read and preprocessed first.  The
+    commands are then run in order, except that each run of consecutive
+    'net', 'linkps', 'linksp', 'newsig', 'setp' and 'sets' commands is
+    handled as a single transaction:
+
+      - the HAL mutex is taken once for the whole run
+      - the pins, params and signals are indexed by name, including
+        the old names of aliased pins and params
+      - every command in the run is checked against that index, which
+        is updated as if the earlier commands had already been done, so
+        all errors in the run are reported together
+      - only if there were no errors is the run applied: new signals
+        are created in name order so that each one is inserted into the
+        signal list in a single pass, then links and values are made in
+        the order they were written
+
+    Any other command (loadrt, addf, start, ...) ends the run, and is
+    run normally once the run before it has been applied.  Nothing is
+    reordered across such commands, so a file gives the same result in
+    batch mode as it does without it.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include "config.h"
+#include "rtapi.h"
+#include "hal.h"
+#include "../hal_priv.h"
+#include "halcmd.h"
+#include "halcmd_commands.h"
+#include "halcmd_batch.h"
+#include <rtapi_mutex.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <search.h>
+
+extern int hal_flag;
+
+/***********************************************************************
+*                         TYPEDEFS AND DEFINES                         *
+************************************************************************/
+
+typedef struct {
+    char *argv[MAX_TOK + 1];	/* tokens, terminated by "" */
+    int argc;
+    const char *filename;
+    int linenumber;
+} batch_cmd_t;
+
+typedef enum {
+    OP_NET,
+    OP_LINK,
+    OP_NEWSIG,
+    OP_SETP,
+    OP_SETS
+} batch_kind_t;
+
+/* a signal as it will be once the earlier commands in the run are done */
+typedef struct {
+    const char *name;		/* must be first, see compare_name() */
+    hal_sig_t *sig;		/* NULL for a new signal until it is created */
+    hal_type_t type;
+    int readers, writers, bidirs;
+    const char *writer;		/* an output or I/O pin, for messages */
+    unsigned port_size;		/* port buffer, allocated or to be */
+    int is_new;
+} batch_sig_t;
+
+/* a pin or param, with the signal a pin is or will be linked to */
+typedef struct {
+    hal_pin_t *pin;
+    hal_param_t *param;
+    batch_sig_t *sig;
+} batch_obj_t;
+
+/* an index entry for a pin or param; aliased ones have two */
+typedef struct {
+    const char *name;		/* must be first, see compare_name() */
+    batch_obj_t *obj;
+} batch_name_t;
+
+typedef struct {
+    void *pins, *params, *sigs;	/* tsearch() roots */
+    batch_obj_t *objs;
+    batch_name_t *names;
+    batch_sig_t *old_sigs;
+    batch_sig_t **new_sigs;
+    int num_new, max_new;
+} batch_index_t;
+
+typedef struct {
+    batch_kind_t kind;
+    batch_cmd_t *cmd;
+    char *name;			/* the signal, or the pin or param for setp */
+    char *value;		/* setp, sets */
+    hal_type_t type;		/* newsig */
+    char *pins[MAX_TOK];	/* net, link */
+    int npins;
+    batch_obj_t *obj[MAX_TOK];	/* the pins, or the setp target in obj[0] */
+    batch_sig_t *sig;
+} batch_op_t;
+
+/***********************************************************************
+*                         LOCAL VARIABLES                              *
+************************************************************************/
+
+static batch_cmd_t *cmds;
+static int num_cmds, max_cmds;
+static char *last_filename;
+static const char *location_file;
+
+/* totals for the load time report */
+static double t_commands, t_index, t_validate, t_apply;
+static int num_batched, num_transactions;
+
+/***********************************************************************
+*                  LOCAL FUNCTION DEFINITIONS                          *
+************************************************************************/
+
+double halcmd_batch_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* point error messages at 'cmd' */
+static void set_location(batch_cmd_t *cmd)
+{
+    if (cmd->filename != location_file) {
+	halcmd_set_filename(cmd->filename);
+	location_file = cmd->filename;
+    }
+    halcmd_set_linenumber(cmd->linenumber);
+}
+
+static const char *type_name(hal_type_t type)
+{
+    switch (type) {
+    case HAL_BIT:
+	return "bit";
+    case HAL_FLOAT:
+	return "float";
+    case HAL_S32:
+	return "s32";
+    case HAL_U32:
+	return "u32";
+    case HAL_PORT:
+	return "port";
+    default:
+	return "unknown";
+    }
+}
+
+static int is_arrow(const char *s)
+{
+    return !strcmp(s, "<=") || !strcmp(s, "=>") || !strcmp(s, "<=>");
+}
+
+static int is_command(const char *name)
+{
+    int n;
+
+    for (n = 0; n < halcmd_ncommands; n++) {
+	if (!strcmp(halcmd_commands[n].name, name)) {
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+/* fill in 'op' if 'cmd' can be part of a transaction, otherwise
+   return -1.  Commands with the wrong number of arguments are left to
+   the normal parser, which reports the error. */
+static int classify(batch_cmd_t *cmd, batch_op_t *op)
+{
+    char **argv = cmd->argv;
+    int argc = cmd->argc, n, nargs = 0;
+    char *args[MAX_TOK];
+
+    memset(op, 0, sizeof(*op));
+    op->cmd = cmd;
+    if (argc == 3 && !strcmp(argv[1], "=") && !is_command(argv[0])) {
+	op->kind = OP_SETP;
+	op->name = argv[0];
+	op->value = argv[2];
+	return 0;
+    }
+    for (n = 1; n < argc; n++) {
+	if (!is_arrow(argv[n])) {
+	    args[nargs++] = argv[n];
+	}
+    }
+    if (!strcmp(argv[0], "net") && nargs >= 2) {
+	op->kind = OP_NET;
+	op->name = args[0];
+	for (n = 1; n < nargs; n++) {
+	    op->pins[op->npins++] = args[n];
+	}
+	return 0;
+    }
+    if (!strcmp(argv[0], "linkps") && nargs == 2) {
+	op->kind = OP_LINK;
+	op->pins[op->npins++] = args[0];
+	op->name = args[1];
+	return 0;
+    }
+    if (!strcmp(argv[0], "linksp") && nargs == 2) {
+	op->kind = OP_LINK;
+	op->name = args[0];
+	op->pins[op->npins++] = args[1];
+	return 0;
+    }
+    if (argc != 3) {
+	return -1;
+    }
+    if (!strcmp(argv[0], "setp")) {
+	op->kind = OP_SETP;
+    } else if (!strcmp(argv[0], "sets")) {
+	op->kind = OP_SETS;
+    } else if (!strcmp(argv[0], "newsig")) {
+	op->kind = OP_NEWSIG;
+	if (strcasecmp(argv[2], "bit") == 0) {
+	    op->type = HAL_BIT;
+	} else if (strcasecmp(argv[2], "float") == 0) {
+	    op->type = HAL_FLOAT;
+	} else if (strcasecmp(argv[2], "u32") == 0) {
+	    op->type = HAL_U32;
+	} else if (strcasecmp(argv[2], "s32") == 0) {
+	    op->type = HAL_S32;
+	} else if (strcasecmp(argv[2], "port") == 0) {
+	    op->type = HAL_PORT;
+	} else {
+	    return -1;
+	}
+    } else {
+	return -1;
+    }
+    op->name = argv[1];
+    op->value = argv[2];
+    return 0;
+}
+
+/* index entries all start with their name */
+static int compare_name(const void *a, const void *b)
+{
+    return strcmp(*(const char *const *) a, *(const char *const *) b);
+}
+
+static int compare_new_sig(const void *a, const void *b)
+{
+    return strcmp((*(batch_sig_t *const *) a)->name,
+	(*(batch_sig_t *const *) b)->name);
+}
+
+static void free_nothing(void *p)
+{
+}
+
+static batch_obj_t *find_obj(void *root, const char *name)
+{
+    batch_name_t **found = tfind(&name, &root, compare_name);
+
+    return found ? (*found)->obj : NULL;
+}
+
+static batch_sig_t *find_sig(batch_index_t *ix, const char *name)
+{
+    batch_sig_t **found = tfind(&name, &ix->sigs, compare_name);
+
+    return found ? *found : NULL;
+}
+
+static void add_pin_to_sig(batch_sig_t *s, hal_pin_t *pin)
+{
+    if ((pin->dir & HAL_IN) != 0) {
+	s->readers++;
+    }
+    if (pin->dir == HAL_OUT) {
+	s->writers++;
+	s->writer = pin->name;
+    }
+    if (pin->dir == HAL_IO) {
+	s->bidirs++;
+	s->writer = pin->name;
+    }
+}
+
+/* build the index, the caller must hold the HAL mutex */
+static int build_index(batch_index_t *ix)
+{
+    int next, num_objs = 0, num_names = 0, num_sigs = 0;
+    hal_pin_t *pin;
+    hal_param_t *param;
+    hal_sig_t *sig;
+    batch_obj_t *obj;
+    batch_name_t *name;
+    batch_sig_t *s;
+
+    memset(ix, 0, sizeof(*ix));
+    for (next = hal_data->pin_list_ptr; next; next = pin->next_ptr) {
+	pin = SHMPTR(next);
+	num_objs++;
+	num_names += pin->oldname ? 2 : 1;
+    }
+    for (next = hal_data->param_list_ptr; next; next = param->next_ptr) {
+	param = SHMPTR(next);
+	num_objs++;
+	num_names += param->oldname ? 2 : 1;
+    }
+    for (next = hal_data->sig_list_ptr; next; next = sig->next_ptr) {
+	sig = SHMPTR(next);
+	num_sigs++;
+    }
+    ix->objs = malloc(sizeof(batch_obj_t) * (num_objs + 1));
+    ix->names = malloc(sizeof(batch_name_t) * (num_names + 1));
+    ix->old_sigs = malloc(sizeof(batch_sig_t) * (num_sigs + 1));
+    if (!ix->objs || !ix->names || !ix->old_sigs) {
+	return -ENOMEM;
+    }
+    s = ix->old_sigs;
+    for (next = hal_data->sig_list_ptr; next; next = sig->next_ptr) {
+	sig = SHMPTR(next);
+	s->name = sig->name;
+	s->sig = sig;
+	s->type = sig->type;
+	s->readers = sig->readers;
+	s->writers = sig->writers;
+	s->bidirs = sig->bidirs;
+	s->writer = NULL;
+	s->port_size = sig->type == HAL_PORT ?
+	    hal_port_buffer_size(*(hal_port_t *) SHMPTR(sig->data_ptr)) : 0;
+	s->is_new = 0;
+	if (!tsearch(s, &ix->sigs, compare_name)) {
+	    return -ENOMEM;
+	}
+	s++;
+    }
+    obj = ix->objs;
+    name = ix->names;
+    for (next = hal_data->pin_list_ptr; next; next = pin->next_ptr) {
+	pin = SHMPTR(next);
+	obj->pin = pin;
+	obj->param = NULL;
+	obj->sig = NULL;
+	if (pin->signal) {
+	    sig = SHMPTR(pin->signal);
+	    obj->sig = find_sig(ix, sig->name);
+	    if (obj->sig && (pin->dir == HAL_OUT || pin->dir == HAL_IO)) {
+		obj->sig->writer = pin->name;
+	    }
+	}
+	name->name = pin->name;
+	name->obj = obj;
+	if (!tsearch(name++, &ix->pins, compare_name)) {
+	    return -ENOMEM;
+	}
+	if (pin->oldname) {
+	    hal_oldname_t *oldname = SHMPTR(pin->oldname);
+	    name->name = oldname->name;
+	    name->obj = obj;
+	    if (!tsearch(name++, &ix->pins, compare_name)) {
+		return -ENOMEM;
+	    }
+	}
+	obj++;
+    }
+    for (next = hal_data->param_list_ptr; next; next = param->next_ptr) {
+	param = SHMPTR(next);
+	obj->pin = NULL;
+	obj->param = param;
+	obj->sig = NULL;
+	name->name = param->name;
+	name->obj = obj;
+	if (!tsearch(name++, &ix->params, compare_name)) {
+	    return -ENOMEM;
+	}
+	if (param->oldname) {
+	    hal_oldname_t *oldname = SHMPTR(param->oldname);
+	    name->name = oldname->name;
+	    name->obj = obj;
+	    if (!tsearch(name++, &ix->params, compare_name)) {
+		return -ENOMEM;
+	    }
+	}
+	obj++;
+    }
+    return 0;
+}
+
+static void free_index(batch_index_t *ix)
+{
+    int n;
+
+    tdestroy(ix->pins, free_nothing);
+    tdestroy(ix->params, free_nothing);
+    tdestroy(ix->sigs, free_nothing);
+    for (n = 0; n < ix->num_new; n++) {
+	free(ix->new_sigs[n]);
+    }
+    free(ix->new_sigs);
+    free(ix->old_sigs);
+    free(ix->names);
+    free(ix->objs);
+}
+
+static batch_sig_t *new_sig(batch_index_t *ix, const char *name,
+    hal_type_t type)
+{
+    batch_sig_t *s;
+
+    if (ix->num_new == ix->max_new) {
+	batch_sig_t **p;
+	ix->max_new = ix->max_new ? 2 * ix->max_new : 64;
+	p = realloc(ix->new_sigs, sizeof(batch_sig_t *) * ix->max_new);
+	if (!p) {
+	    return NULL;
+	}
+	ix->new_sigs = p;
+    }
+    s = calloc(1, sizeof(batch_sig_t));
+    if (!s) {
+	return NULL;
+    }
+    s->name = name;
+    s->type = type;
+    s->is_new = 1;
+    if (!tsearch(s, &ix->sigs, compare_name)) {
+	free(s);
+	return NULL;
+    }
+    ix->new_sigs[ix->num_new++] = s;
+    return s;
+}
+
+/* the checks made by hal_link(), against the index */
+static int check_link(batch_sig_t *s, hal_pin_t *pin)
+{
+    if (pin->type != s->type) {
+	halcmd_error(
+	    "Signal '%s' of type '%s' cannot add pin '%s' of type '%s'\n",
+	    s->name, type_name(s->type), pin->name, type_name(pin->type));
+	return -EINVAL;
+    }
+    if (pin->dir == HAL_OUT && (s->writers || s->bidirs)) {
+	halcmd_error("Signal '%s' can not add output pin '%s', "
+	    "it already has %s pin '%s'\n", s->name, pin->name,
+	    s->writers ? "output" : "I/O", s->writer ? s->writer : "?");
+	return -EINVAL;
+    }
+    if (pin->dir == HAL_IO && pin->type == HAL_PORT) {
+	halcmd_error("Signal '%s' is a port and cannot have I/O pin '%s'\n",
+	    s->name, pin->name);
+	return -EINVAL;
+    }
+    if (pin->dir == HAL_IO && s->writers) {
+	halcmd_error("Signal '%s' can not add I/O pin '%s', "
+	    "it already has output pin '%s'\n", s->name, pin->name,
+	    s->writer ? s->writer : "?");
+	return -EINVAL;
+    }
+    if (pin->type == HAL_PORT && pin->dir == HAL_IN && s->readers) {
+	halcmd_error("Signal '%s' is a port and can only have one input pin\n",
+	    s->name);
+	return -EINVAL;
+    }
+    return 0;
+}
+
+/* the checks made by set_common(), without storing anything that
+   cannot be undone */
+static int check_value(hal_type_t type, char *value)
+{
+    hal_data_u scratch;
+    char *cp;
+
+    if (type == HAL_PORT) {
+	strtoul(value, &cp, 0);
+	if ((*cp != '\0') && (!isspace(*cp))) {
+	    halcmd_error("value '%s' invalid for PORT\n", value);
+	    return -EINVAL;
+	}
+	return 0;
+    }
+    return set_common(type, &scratch, value);
+}
+
+static int check_config_lock(void)
+{
+    if (hal_data->lock & HAL_LOCK_CONFIG) {
+	halcmd_error("HAL is locked, signals cannot be changed\n");
+	return -EPERM;
+    }
+    return 0;
+}
+
+static int validate_net(batch_index_t *ix, batch_op_t *op)
+{
+    batch_sig_t *s, tmp;
+    int n, m;
+
+    if (check_config_lock() < 0) {
+	return -EPERM;
+    }
+    if (find_obj(ix->pins, op->name)) {
+	halcmd_error("Signal name '%s' must not be the same as a pin.  "
+	    "Did you omit the signal name?\n", op->name);
+	return -ENOENT;
+    }
+    s = find_sig(ix, op->name);
+    if (s) {
+	tmp = *s;
+    } else {
+	if (strlen(op->name) > HAL_NAME_LEN) {
+	    halcmd_error("signal name '%s' is too long\n", op->name);
+	    return -EINVAL;
+	}
+	memset(&tmp, 0, sizeof(tmp));
+	tmp.name = op->name;
+	tmp.type = HAL_TYPE_UNSPECIFIED;
+    }
+    /* check the pins against a copy of the signal, so nothing changes
+       if one of them is refused */
+    for (n = 0; n < op->npins; n++) {
+	batch_obj_t *p = find_obj(ix->pins, op->pins[n]);
+	if (!p) {
+	    halcmd_error("Pin '%s' does not exist\n", op->pins[n]);
+	    return -ENOENT;
+	}
+	op->obj[n] = p;
+	for (m = 0; m < n; m++) {
+	    if (op->obj[m] == p) {
+		/* listed twice, the second one is a no-op */
+		op->obj[n] = NULL;
+	    }
+	}
+	if (!op->obj[n] || (s && p->sig == s)) {
+	    continue;
+	}
+	if (p->sig) {
+	    halcmd_error("Pin '%s' was already linked to signal '%s'\n",
+		p->pin->name, p->sig->name);
+	    return -EINVAL;
+	}
+	if (tmp.type == HAL_TYPE_UNSPECIFIED) {
+	    tmp.type = p->pin->type;
+	}
+	if (check_link(&tmp, p->pin) < 0) {
+	    return -EINVAL;
+	}
+	add_pin_to_sig(&tmp, p->pin);
+    }
+    if (!s) {
+	s = new_sig(ix, op->name, tmp.type);
+	if (!s) {
+	    halcmd_error("out of memory\n");
+	    return -ENOMEM;
+	}
+    }
+    s->readers = tmp.readers;
+    s->writers = tmp.writers;
+    s->bidirs = tmp.bidirs;
+    s->writer = tmp.writer;
+    for (n = 0; n < op->npins; n++) {
+	if (op->obj[n]) {
+	    op->obj[n]->sig = s;
+	}
+    }
+    op->sig = s;
+    return 0;
+}
+
+static int validate_link(batch_index_t *ix, batch_op_t *op)
+{
+    batch_sig_t *s;
+    batch_obj_t *p;
+
+    if (check_config_lock() < 0) {
+	return -EPERM;
+    }
+    p = find_obj(ix->pins, op->pins[0]);
+    if (!p) {
+	halcmd_error("pin '%s' not found\n", op->pins[0]);
+	return -EINVAL;
+    }
+    s = find_sig(ix, op->name);
+    if (!s) {
+	halcmd_error("signal '%s' not found\n", op->name);
+	return -EINVAL;
+    }
+    op->obj[0] = p;
+    op->sig = s;
+    if (p->sig == s) {
+	return 0;
+    }
+    if (p->sig) {
+	halcmd_error("pin '%s' is linked to '%s', cannot link to '%s'\n",
+	    p->pin->name, p->sig->name, s->name);
+	return -EINVAL;
+    }
+    if (check_link(s, p->pin) < 0) {
+	return -EINVAL;
+    }
+    add_pin_to_sig(s, p->pin);
+    p->sig = s;
+    return 0;
+}
+
+static int validate_newsig(batch_index_t *ix, batch_op_t *op)
+{
+    if (check_config_lock() < 0) {
+	return -EPERM;
+    }
+    if (strlen(op->name) > HAL_NAME_LEN) {
+	halcmd_error("signal name '%s' is too long\n", op->name);
+	return -EINVAL;
+    }
+    if (find_sig(ix, op->name)) {
+	halcmd_error("duplicate signal '%s'\n", op->name);
+	return -EINVAL;
+    }
+    op->sig = new_sig(ix, op->name, op->type);
+    if (!op->sig) {
+	halcmd_error("out of memory\n");
+	return -ENOMEM;
+    }
+    return 0;
+}
+
+static int validate_setp(batch_index_t *ix, batch_op_t *op)
+{
+    batch_obj_t *obj;
+
+    obj = find_obj(ix->params, op->name);
+    if (obj) {
+	if (obj->param->dir == HAL_RO) {
+	    halcmd_error("param '%s' is not writable\n", op->name);
+	    return -EINVAL;
+	}
+	op->obj[0] = obj;
+	return check_value(obj->param->type, op->value);
+    }
+    obj = find_obj(ix->pins, op->name);
+    if (!obj) {
+	halcmd_error("parameter or pin '%s' not found\n", op->name);
+	return -EINVAL;
+    }
+    if (obj->pin->dir == HAL_OUT) {
+	halcmd_error("pin '%s' is not writable\n", op->name);
+	return -EINVAL;
+    }
+    if (obj->sig) {
+	halcmd_error("pin '%s' is connected to a signal\n", op->name);
+	return -EINVAL;
+    }
+    op->obj[0] = obj;
+    return check_value(obj->pin->type, op->value);
+}
+
+static int validate_sets(batch_index_t *ix, batch_op_t *op)
+{
+    batch_sig_t *s = find_sig(ix, op->name);
+
+    if (!s) {
+	halcmd_error("signal '%s' not found\n", op->name);
+	return -EINVAL;
+    }
+    if (s->type != HAL_PORT && s->writers > 0) {
+	halcmd_error("signal '%s' already has writer(s)\n", op->name);
+	return -EINVAL;
+    }
+    if (s->type == HAL_PORT && s->port_size > 0) {
+	halcmd_error("port is already allocated with %u bytes.\n",
+	    s->port_size);
+	return -EINVAL;
+    }
+    op->sig = s;
+    if (check_value(s->type, op->value) != 0) {
+	return -EINVAL;
+    }
+    if (s->type == HAL_PORT) {
+	s->port_size = strtoul(op->value, NULL, 0);
+    }
+    return 0;
+}
+
+static int validate(batch_index_t *ix, batch_op_t *op)
+{
+    switch (op->kind) {
+    case OP_NET:
+	return validate_net(ix, op);
+    case OP_LINK:
+	return validate_link(ix, op);
+    case OP_NEWSIG:
+	return validate_newsig(ix, op);
+    case OP_SETP:
+	return validate_setp(ix, op);
+    case OP_SETS:
+	return validate_sets(ix, op);
+    }
+    return -EINVAL;
+}
+
+/* make the changes, the caller must hold the HAL mutex.  Everything
+   has been checked, so this only fails if HAL memory runs out. */
+static int apply(batch_index_t *ix, batch_op_t *ops, int num_ops)
+{
+    hal_sig_t *after = NULL;
+    int n, p, retval, errors = 0;
+
+    /* in name order, each new signal goes after the one before it */
+    qsort(ix->new_sigs, ix->num_new, sizeof(batch_sig_t *), compare_new_sig);
+    for (n = 0; n < ix->num_new; n++) {
+	batch_sig_t *s = ix->new_sigs[n];
+	retval = halpr_signal_new(s->name, s->type, after, &s->sig);
+	if (retval < 0) {
+	    halcmd_error("creating signal '%s' failed\n", s->name);
+	    return 1;
+	}
+	after = s->sig;
+    }
+    for (n = 0; n < num_ops; n++) {
+	batch_op_t *op = &ops[n];
+	set_location(op->cmd);
+	switch (op->kind) {
+	case OP_NET:
+	case OP_LINK:
+	    for (p = 0; p < op->npins; p++) {
+		if (!op->obj[p]) {
+		    continue;
+		}
+		retval = halpr_link(op->obj[p]->pin, op->sig->sig);
+		if (retval < 0) {
+		    halcmd_error("link failed\n");
+		    errors++;
+		} else {
+		    halcmd_info("Pin '%s' linked to signal '%s'\n",
+			op->obj[p]->pin->name, op->sig->name);
+		}
+	    }
+	    break;
+	case OP_NEWSIG:
+	    break;
+	case OP_SETP:
+	    if (op->obj[0]->param) {
+		hal_param_t *param = op->obj[0]->param;
+		retval = set_common(param->type, SHMPTR(param->data_ptr),
+		    op->value);
+	    } else {
+		hal_pin_t *pin = op->obj[0]->pin;
+		retval = set_common(pin->type, (void *) &pin->dummysig,
+		    op->value);
+	    }
+	    if (retval < 0) {
+		halcmd_error("setp failed\n");
+		errors++;
+	    } else {
+		halcmd_info("%s '%s' set to %s\n",
+		    op->obj[0]->param ? "Parameter" : "Pin", op->name,
+		    op->value);
+	    }
+	    break;
+	case OP_SETS:
+	    retval = set_common(op->sig->type, SHMPTR(op->sig->sig->data_ptr),
+		op->value);
+	    if (retval < 0) {
+		halcmd_error("sets failed\n");
+		errors++;
+	    } else {
+		halcmd_info("Signal '%s' set to %s\n", op->name, op->value);
+	    }
+	    break;
+	}
+    }
+    return errors;
+}
+
+/* check and apply one run of commands, returns the number of errors */
+static int run_transaction(batch_op_t *ops, int num_ops)
+{
+    batch_index_t ix;
+    double t0, t1, t2, t3;
+    int n, errors = 0, num_checked = num_ops;
+
+    t0 = halcmd_batch_now();
+    rtapi_mutex_get(&(hal_data->mutex));
+    /* tell the signal handler that we have the mutex */
+    hal_flag = 1;
+    if (build_index(&ix) < 0) {
+	set_location(ops[0].cmd);
+	halcmd_error("out of memory indexing HAL\n");
+	errors++;
+	num_checked = 0;
+    }
+    t1 = halcmd_batch_now();
+    /* check everything, so all the errors are reported at once */
+    for (n = 0; n < num_checked; n++) {
+	set_location(ops[n].cmd);
+	if (validate(&ix, &ops[n]) < 0) {
+	    errors++;
+	}
+    }
+    t2 = halcmd_batch_now();
+    if (errors == 0) {
+	errors = apply(&ix, ops, num_ops);
+    } else {
+	set_location(ops[0].cmd);
+	halcmd_error("%d error(s) in the %d commands starting here, "
+	    "none of them were applied\n", errors, num_ops);
+    }
+    hal_flag = 0;
+    rtapi_mutex_give(&(hal_data->mutex));
+    t3 = halcmd_batch_now();
+    free_index(&ix);
+    t_index += t1 - t0;
+    t_validate += t2 - t1;
+    t_apply += t3 - t2;
+    num_batched += num_ops;
+    num_transactions++;
+    return errors;
+}
+
+/***********************************************************************
+*                        PUBLIC FUNCTIONS                              *
+************************************************************************/
+
+int halcmd_batch_add(char **tokens)
+{
+    batch_cmd_t *cmd;
+    const char *filename = halcmd_get_filename();
+    int n;
+
+    if (!tokens[0] || !tokens[0][0]) {
+	/* blank line or comment */
+	return 0;
+    }
+    if (num_cmds == max_cmds) {
+	batch_cmd_t *p;
+	max_cmds = max_cmds ? 2 * max_cmds : 1024;
+	p = realloc(cmds, sizeof(batch_cmd_t) * max_cmds);
+	if (!p) {
+	    halcmd_error("out of memory\n");
+	    return -ENOMEM;
+	}
+	cmds = p;
+    }
+    if (!last_filename || strcmp(last_filename, filename)) {
+	last_filename = strdup(filename);
+    }
+    cmd = &cmds[num_cmds];
+    cmd->filename = last_filename;
+    cmd->linenumber = halcmd_get_linenumber();
+    for (n = 0; n < MAX_TOK && tokens[n] && tokens[n][0]; n++) {
+	cmd->argv[n] = strdup(tokens[n]);
+	if (!cmd->argv[n]) {
+	    halcmd_error("out of memory\n");
+	    return -ENOMEM;
+	}
+    }
+    cmd->argc = n;
+    for (; n <= MAX_TOK; n++) {
+	cmd->argv[n] = "";
+    }
+    num_cmds++;
+    return 0;
+}
+
+int halcmd_batch_run(int keep_going, double parse_time)
+{
+    batch_op_t *ops;
+    int n, num_ops = 0, errors = 0, stop = 0;
+    double t;
+
+    ops = malloc(sizeof(batch_op_t) * (num_cmds + 1));
+    if (!ops) {
+	halcmd_error("out of memory\n");
+	return 1;
+    }
+    for (n = 0; n < num_cmds && !stop; n++) {
+	batch_cmd_t *cmd = &cmds[n];
+	int retval;
+
+	if (classify(cmd, &ops[num_ops]) == 0) {
+	    num_ops++;
+	    continue;
+	}
+	/* anything else ends the run before it */
+	if (num_ops) {
+	    retval = run_transaction(ops, num_ops);
+	    num_ops = 0;
+	    errors += retval;
+	    if ((retval && !keep_going) || halcmd_done) {
+		break;
+	    }
+	}
+	t = halcmd_batch_now();
+	set_location(cmd);
+	retval = halcmd_parse_cmd(cmd->argv);
+	/* the command may have changed the file name (source) */
+	location_file = NULL;
+	t_commands += halcmd_batch_now() - t;
+	if (retval != 0) {
+	    errors++;
+	}
+	/* an interrupt is counted by the caller */
+	stop = (retval != 0 && !keep_going) || halcmd_done;
+    }
+    if (num_ops && !stop && !halcmd_done) {
+	errors += run_transaction(ops, num_ops);
+    }
+    free(ops);
+    if (rtapi_get_msg_level() >= RTAPI_MSG_INFO) {
+	halcmd_output("load time: parse %.3fs, other commands %.3fs, "
+	    "index %.3fs, check %.3fs, apply %.3fs\n",
+	    parse_time, t_commands, t_index, t_validate, t_apply);
+	halcmd_output("%d of %d commands done in %d transaction(s)\n",
+	    num_batched, num_cmds, num_transactions);
+    }
+    return errors;
+}
@@ -0,0 +1,37 @@
+/*  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of version 2 of the GNU General
+ *  Public License as published by the Free Software Foundation.
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *  This code was written as part of the EMC HAL project.  For more
+ *  information, go to www.linuxcnc.org.
+ */
+
+#ifndef HALCMD_BATCH_H
+#define HALCMD_BATCH_H
+
+/* Batch mode ('halcmd -B') reads all of its input before running any
+   of it.  Runs of consecutive 'net', 'linkps', 'linksp', 'newsig',
+   'setp' and 'sets' commands are then checked together and applied
+   as one transaction, under a single hold of the HAL mutex and with
+   names looked up in an index instead of the HAL lists.  Any other
+   command ends the run and is executed normally, so the commands
+   still take effect in the order they were written.
+*/
+
+/* queue one preprocessed command line; the tokens are copied */
+extern int halcmd_batch_add(char **tokens);
+/* run everything queued, returns the number of commands that failed.
+   'parse_time' is the time taken to read the input, for the report. */
+extern int halcmd_batch_run(int keep_going, double parse_time);
+/* monotonic time in seconds, for timing the phases */
+extern double halcmd_batch_now(void);
+
+#endif
@@ -319,13 +319,35 @@ int do_unecho_cmd(void) {
     return 0;
 }
 int do_addf_cmd(char *func, char *thread, char **opt) {
-    char *position_str = opt ? opt[0] : NULL;
     int position = -1;
-    int retval;
-
-    if(position_str && *position_str) position = atoi(position_str);
+    int divisor = 1, phase = 0;
+    char *enable = NULL;
+    char *cp;
+    int retval, n;
+
+    /* an optional position, then optional 'divisor=N', 'phase=N'
+       and 'enable=pinname' in any order */
+    for(n = 0; opt && opt[n] && *opt[n]; n++) {
+        if(strncmp(opt[n], "divisor=", 8) == 0) {
+            divisor = strtol(opt[n] + 8, &cp, 0);
+        } else if(strncmp(opt[n], "phase=", 6) == 0) {
+            phase = strtol(opt[n] + 6, &cp, 0);
+        } else if(strncmp(opt[n], "enable=", 7) == 0) {
+            enable = opt[n] + 7;
+            cp = "";
+        } else if(n == 0) {
+            position = strtol(opt[n], &cp, 0);
+        } else {
+            cp = opt[n];
+        }
+        if(*cp != '\0' || (enable && *enable == '\0')) {
+            halcmd_error("addf: bad argument '%s'\n", opt[n]);
+            return -EINVAL;
+        }
+    }
 
-    retval = hal_add_funct_to_thread(func, thread, position);
+    retval = hal_add_funct_to_thread_divided(func, thread, position,
+                                             divisor, phase, enable);
     if(retval == 0) {
         halcmd_info("Function '%s' added to thread '%s'\n",
                     func, thread);
@@ -643,7 +665,7 @@ int do_newsig_cmd(char *name, char *type)
     return retval;
 }
 
-static int set_common(hal_type_t type, void *d_ptr, char *value) {
+int set_common(hal_type_t type, void *d_ptr, char *value) {
     // This function assumes that the mutex is held
     int retval = 0;
     double fval;
@@ -1919,6 +1941,64 @@ static void print_funct_info(char **patterns)
     halcmd_output("\n");
 }
 
+static long gcd(long a, long b)
+{
+    while (b != 0) {
+	long t = a % b;
+	a = b;
+	b = t;
+    }
+    return a;
+}
+
+/* with the HAL mutex held, print how much of each period the functions
+   of a thread that runs divided functions can take: for each slot,
+   the sum of the Max-Time of the functions that run in it */
+#define MAX_SLOTS 10000
+#define MAX_SLOTS_SHOWN 16
+static void print_thread_slots(hal_thread_t *tptr)
+{
+    hal_list_t *list_root, *list_entry;
+    hal_funct_entry_t *fentry;
+    hal_funct_t *funct;
+    long slots = 1, slot, worst_slot = 0;
+    long long budget, worst = -1;
+
+    list_root = &(tptr->funct_list);
+    for (list_entry = list_next(list_root); list_entry != list_root;
+	    list_entry = list_next(list_entry)) {
+	fentry = (hal_funct_entry_t *) list_entry;
+	slots = slots / gcd(slots, fentry->divisor) * fentry->divisor;
+	if (slots > MAX_SLOTS) {
+	    halcmd_output("  Slots: more than %d, not shown\n", MAX_SLOTS);
+	    return;
+	}
+    }
+    if (slots == 1) {
+	return;
+    }
+    halcmd_output("  Slots: %ld (sum of function Max-Time per slot)\n", slots);
+    for (slot = 0; slot < slots; slot++) {
+	budget = 0;
+	for (list_entry = list_next(list_root); list_entry != list_root;
+		list_entry = list_next(list_entry)) {
+	    fentry = (hal_funct_entry_t *) list_entry;
+	    funct = SHMPTR(fentry->funct_ptr);
+	    if (slot % fentry->divisor == fentry->phase) {
+		budget += funct->maxtime;
+	    }
+	}
+	if (slots <= MAX_SLOTS_SHOWN) {
+	    halcmd_output("                 %2ld %8lld\n", slot, budget);
+	}
+	if (budget > worst) {
+	    worst = budget;
+	    worst_slot = slot;
+	}
+    }
+    halcmd_output("  Worst slot: %ld ( %8lld )\n", worst_slot, worst);
+}
+
 static void print_thread_info(char **patterns)
 {
     int next_thread, n;
@@ -1982,7 +2062,16 @@ static void print_thread_info(char **patterns)
 		/* scriptmode only uses one line per thread, which contains: 
 		   thread period, FP flag, name, then all functs separated by spaces  */
 		if (scriptmode == 0) {
-		    halcmd_output("                 %2d %s\n", n, funct->name);
+		    halcmd_output("                 %2d %s", n, funct->name);
+		    if (fentry->divisor > 1) {
+			halcmd_output("  divisor=%d phase=%d",
+			    fentry->divisor, fentry->phase);
+		    }
+		    if (fentry->enable_ptr != 0) {
+			halcmd_output("  enable=%s",
+			    ((hal_pin_t *) SHMPTR(fentry->enable_ptr))->name);
+		    }
+		    halcmd_output("\n");
 		} else {
 		    halcmd_output(" %s", funct->name);
 		}
@@ -1991,6 +2080,8 @@ static void print_thread_info(char **patterns)
 	    }
 	    if (scriptmode != 0) {
 		halcmd_output("\n");
+	    } else {
+		print_thread_slots(tptr);
 	    }
 	}
 	next_thread = tptr->next_ptr;
@@ -2150,7 +2241,7 @@ static void print_mem_status()
     hal_param_t *param;
 
     halcmd_output("HAL memory status\n");
-    halcmd_output("  used/total shared memory:   %ld/%d\n", (long)(HAL_SIZE - hal_data->shmem_avail), HAL_SIZE);
+    halcmd_output("  used/total shared memory:   %ld/%ld\n", (long)(hal_data->shmem_size - hal_data->shmem_avail), hal_data->shmem_size);
     // count components
     active = count_list(hal_data->comp_list_ptr);
     recycled = count_list(hal_data->comp_free_ptr);
@@ -2734,7 +2825,16 @@ static void save_threads(FILE *dst)
 	    /* print the function info */
 	    fentry = (hal_funct_entry_t *) list_entry;
 	    funct = SHMPTR(fentry->funct_ptr);
-	    fprintf(dst, "addf %s %s\n", funct->name, tptr->name);
+	    fprintf(dst, "addf %s %s", funct->name, tptr->name);
+	    if (fentry->divisor > 1) {
+		fprintf(dst, " divisor=%d phase=%d",
+		    fentry->divisor, fentry->phase);
+	    }
+	    if (fentry->enable_ptr != 0) {
+		fprintf(dst, " enable=%s",
+		    ((hal_pin_t *) SHMPTR(fentry->enable_ptr))->name);
+	    }
+	    fprintf(dst, "\n");
 	    list_entry = list_next(list_entry);
 	}
 	next_thread = tptr->next_ptr;
@@ -2893,13 +2993,17 @@ int do_help_cmd(char *command)
 	printf("stype signame\n");
 	printf("  Gets the type of signal 'signame'\n");
     } else if (strcmp(command, "addf") == 0) {
-	printf("addf functname threadname [position]\n");
+	printf("addf functname threadname [position] [divisor=N] [phase=N] [enable=pin]\n");
 	printf("  Adds function 'functname' to thread 'threadname'.  If\n");
 	printf("  'position' is specified, adds the function to that spot\n");
 	printf("  in the thread, otherwise adds it to the end.  Negative\n");
 	printf("  'position' means position with respect to the end of the\n");
 	printf("  thread.  For example '1' is start of thread, '-1' is the\n");
 	printf("  end of the thread, '-3' is third from the end.\n");
+	printf("  With 'divisor', the function only runs every Nth period\n");
+	printf("  of the thread, in the periods where the period count\n");
+	printf("  modulo N is 'phase' (default 0).  With 'enable', it is\n");
+	printf("  skipped in any period when bit pin 'pin' is false.\n");
     } else if (strcmp(command, "delf") == 0) {
 	printf("delf functname threadname\n");
 	printf("  Removes function 'functname' from thread 'threadname'.\n");
@@ -86,6 +86,10 @@ extern int do_waitusr_cmd(char *comp_name);
 extern int do_save_cmd(char *type, char *filename);
 extern int do_setexact_cmd(void);
 
+/* parse 'value' as 'type' and store it at 'd_ptr'; the caller must hold
+   the HAL mutex */
+extern int set_common(hal_type_t type, void *d_ptr, char *value);
+
 pid_t hal_systemv_nowait(char *const argv[]);
 int hal_systemv(char *const argv[]);
 
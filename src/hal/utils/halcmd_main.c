@@ -44,6 +44,7 @@
 #include "halcmd.h"
 #include "halcmd_commands.h"
 #include "halcmd_completion.h"
+#include "halcmd_batch.h"
 #include <rtapi_mutex.h>
 
 #include <stdio.h>
@@ -60,6 +61,8 @@
 #include <search.h>
 
 static int get_input(FILE *srcfile, char *buf, size_t bufsize);
+static int get_batch_input(FILE **srcfile, char *buf, size_t bufsize,
+    int *linenumber);
 static void print_help_general(int showR);
 static int release_HAL_mutex(void);
 static int propose_completion(char *all, char *fragment, int start);
@@ -71,6 +74,11 @@ static char *prompt_continue    = "halcmd+: ";
 
 #define MAX_EXTEND_LINES 20
 
+/* in batch mode, files after the first one named with -f */
+static FILE **batch_files;
+static char **batch_names;
+static int num_batch_files, next_batch_file;
+
 /***********************************************************************
 *                   LOCAL FUNCTION DEFINITIONS                         *
 ************************************************************************/
@@ -80,6 +88,8 @@ int main(int argc, char **argv)
     int c, fd;
     int keep_going, retval, errorcount;
     int filemode = 0;
+    int batchmode = 0;
+    double parse_start = 0.0;
     char *filename = NULL;
     FILE *srcfile = NULL;
     char raw_buf[MAX_CMD_LEN+1];
@@ -97,7 +107,7 @@ int main(int argc, char **argv)
     keep_going = 0;
     /* start parsing the command line, options first */
     while(1) {
-        c = getopt(argc, argv, "+RCfi:kqQsvVhe");
+        c = getopt(argc, argv, "+BRCfi:kqQsvVhe");
         if(c == -1) break;
         switch(c) {
             case 'R':
@@ -108,6 +118,10 @@ int main(int argc, char **argv)
 		}
 		return 0;
 		break;
+	    case 'B':
+		/* -B = batch mode, read all input before running it */
+		batchmode = 1;
+		break;
 	    case 'h':
 		/* -h = help */
                 if (argc > optind) { /* there are more arguments */
@@ -218,6 +232,24 @@ int main(int argc, char **argv)
             /* make sure file is closed on exec() */
             fd = fileno(srcfile);
             fcntl(fd, F_SETFD, FD_CLOEXEC);
+            /* batch mode reads all the files named, as one batch */
+            if (batchmode && argc > optind) {
+                int n;
+                num_batch_files = argc - optind;
+                batch_files = calloc(num_batch_files, sizeof(FILE *));
+                batch_names = &argv[optind];
+                for (n = 0; n < num_batch_files; n++) {
+                    batch_files[n] = fopen(batch_names[n], "r");
+                    if (batch_files[n] == NULL) {
+                        fprintf(stderr,
+                            "Could not open command file '%s'\n",
+                            batch_names[n]);
+                        exit(-1);
+                    }
+                    fcntl(fileno(batch_files[n]), F_SETFD, FD_CLOEXEC);
+                }
+                optind = argc;
+            }
         } else {
             halcmd_set_filename("<stdin>");
             /* no filename followed -f option, use stdin */
@@ -255,8 +287,11 @@ int main(int argc, char **argv)
     } else {
         int   extend_ct = 0; // extend lines with backslash (\)
         char *elinenext = 0;
+        parse_start = halcmd_batch_now();
 	/* read command line(s) from 'srcfile' */
-	while (get_input(srcfile, raw_buf, MAX_CMD_LEN)) {
+	while (batchmode ?
+	       get_batch_input(&srcfile, raw_buf, MAX_CMD_LEN, &linenumber) :
+	       get_input(srcfile, raw_buf, MAX_CMD_LEN)) {
 	    char *tokens[MAX_TOK+1];
             char  eline [(LINELEN + 2) * (MAX_EXTEND_LINES + 1)];
             char *elineptr;
@@ -306,8 +341,12 @@ int main(int argc, char **argv)
 		     ( strcasecmp(tokens[0],"exit") == 0 ) ) {
 		    break;
 		}
-		/* process command */
-		retval = halcmd_parse_cmd(tokens);
+		/* process command, or in batch mode queue it */
+		if (batchmode) {
+		    retval = halcmd_batch_add(tokens);
+		} else {
+		    retval = halcmd_parse_cmd(tokens);
+		}
 	    }
 	    /* did a signal happen while we were busy? */
 	    if ( halcmd_done ) {
@@ -325,6 +364,14 @@ int main(int argc, char **argv)
 	    }
 	} //while get_input()
         extend_ct=0;
+        if (batchmode && !halcmd_done && (errorcount == 0 || keep_going)) {
+            errorcount += halcmd_batch_run(keep_going,
+                halcmd_batch_now() - parse_start);
+            /* a signal during the run, treated as an error as above */
+            if (halcmd_done) {
+                errorcount++;
+            }
+        }
     }
     /* all done */
     halcmd_shutdown();
@@ -336,6 +383,26 @@ int main(int argc, char **argv)
 
 }
 
+/* get_batch_input() reads the next line of input in batch mode,
+   moving on to the next file at the end of each one */
+static int get_batch_input(FILE **srcfile, char *buf, size_t bufsize,
+    int *linenumber)
+{
+    while (!get_input(*srcfile, buf, bufsize)) {
+        if (next_batch_file == num_batch_files) {
+            return 0;
+        }
+        if (*srcfile != stdin) {
+            fclose(*srcfile);
+        }
+        *srcfile = batch_files[next_batch_file];
+        halcmd_set_filename(batch_names[next_batch_file]);
+        next_batch_file++;
+        *linenumber = 1;
+    }
+    return 1;
+}
+
 /* release_HAL_mutex() unconditionally releases the hal_mutex
    very useful after a program segfaults while holding the mutex
 */
@@ -406,6 +473,10 @@ static void print_help_general(int showR)
     printf("\n         halcmd [options] -f [filename]\n\n");
     printf("options:\n\n");
     printf("  -e             echo the commands from stdin to stderr\n");
+    printf("  -B             Batch mode - read all of the input before running\n");
+    printf("                 it, and do runs of net, setp and similar\n");
+    printf("                 commands together.  With -f, all the files\n");
+    printf("                 named are read.\n");
     printf("  -f [filename]  Read commands from 'filename', not command\n");
     printf("                 line.  If no filename, read from stdin.\n");
 #ifndef NO_INI
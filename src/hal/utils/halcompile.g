@@ -113,6 +113,10 @@ MAX_USERSPACE_NAMES = 16 # for userspace (loadusr) components
 # exported is computed modulo MAX_PERSONALITIES
 MAX_PERSONALITIES = 64
 
+# Set by the cmdline option -b|--batch, as if every component had
+# "option batch yes"
+force_batch = False
+
 mp_decl_map = {'int': 'RTAPI_MP_INT', 'dummy': None}
 
 # These are symbols that comp puts in the global namespace of the C file it
@@ -254,6 +258,14 @@ def removeprefix(s,p):
     if s.startswith(p): return s[len(p):]
     return s
 
+def batched():
+    return (options.get("batch") or force_batch) \
+        and options.get("rtapi_app", 1) \
+        and not options.get("singleton") and not options.get("userspace")
+
+def batch_name(name):
+    return to_hal(removeprefix(comp_name, "hal_")) + ".batch" + to_hal("." + name)
+
 def to_hal(name):
     name = re.sub("#+", lambda m: "%%0%dd" % len(m.group(0)), name)
     return name.replace("_", "-").rstrip("-").rstrip(".")
@@ -368,6 +380,11 @@ static int comp_id;
         names[name] = 1
 
     print("static int __comp_get_data_size(void);", file=f)
+    if batched():
+        print("static char *__comp_pool;", file=f)
+        print("static int __comp_pool_size, __comp_pool_used;", file=f)
+        for name, fp in functions:
+            print("static void __comp_batch_%s(void *__arg, long __period);" % to_c(name), file=f)
     if options.get("extra_setup"):
         print("static int extra_setup(struct __comp_state *__comp_inst, char *prefix, long extra_arg);", file=f)
     if options.get("extra_cleanup"):
@@ -394,7 +411,18 @@ static int comp_id;
     if has_array:
         print("    int j = 0;", file=f)
     print("    int sz = sizeof(struct __comp_state) + __comp_get_data_size();", file=f)
-    print("    struct __comp_state *inst = hal_malloc(sz);", file=f)
+    if batched():
+        # instances from the pool are laid out one after another, so the
+        # batch functions can step through them as an array
+        print("    struct __comp_state *inst;", file=f)
+        print("    sz = (sz + 15) & ~15;", file=f)
+        print("    if(__comp_pool_used < __comp_pool_size) {", file=f)
+        print("        inst = (struct __comp_state *)(__comp_pool + __comp_pool_used++ * sz);", file=f)
+        print("    } else {", file=f)
+        print("        inst = hal_malloc(sz);", file=f)
+        print("    }", file=f)
+    else:
+        print("    struct __comp_state *inst = hal_malloc(sz);", file=f)
     print("    memset(inst, 0, sz);", file=f)
     if has_data:
         print("    inst->_data = (char*)inst + sizeof(struct __comp_state);", file=f)
@@ -489,6 +517,24 @@ static int comp_id;
     print("    return 0;", file=f)
     print("}", file=f)
 
+    if batched():
+        print("static int __comp_reserve(int n) {", file=f)
+        print("    int sz = (sizeof(struct __comp_state) + __comp_get_data_size() + 15) & ~15;", file=f)
+        print("    if(n <= 0) return 0;", file=f)
+        print("    __comp_pool = hal_malloc(n * sz);", file=f)
+        print("    if(!__comp_pool) return -ENOMEM;", file=f)
+        print("    __comp_pool_size = n;", file=f)
+        print("    return 0;", file=f)
+        print("}", file=f)
+        print("static int __comp_export_batch(void) {", file=f)
+        print("    int r;", file=f)
+        for name, fp in functions:
+            print("    r = hal_export_funct(\"%s\", __comp_batch_%s, 0, %s, 0, comp_id);" % (
+                batch_name(name), to_c(name), int(fp)), file=f)
+            print("    if(r != 0) return r;", file=f)
+        print("    return 0;", file=f)
+        print("}", file=f)
+
     if options.get("count_function"):
         print("static int get_count(void);", file=f)
 
@@ -551,6 +597,9 @@ static int comp_id;
                 print("    r = export(\"%s\", 0);" % \
                         to_hal(removeprefix(comp_name, "hal_")), file=f)
         elif options.get("count_function"):
+            if batched():
+                print("    r = __comp_reserve(count);", file=f)
+                print("    if(r) { hal_exit(comp_id); return r; }", file=f)
             print("    for(i=0; i<count; i++) {", file=f)
             print("        char buf[HAL_NAME_LEN + 1];", file=f)
             print("        rtapi_snprintf(buf, sizeof(buf), " \
@@ -568,6 +617,15 @@ static int comp_id;
             print("        return -EINVAL;", file=f)
             print("    }", file=f)
             print("    if(!count && !names[0]) count = default_count;", file=f)
+            if batched():
+                print("    if(count) {", file=f)
+                print("        r = __comp_reserve(count);", file=f)
+                print("    } else {", file=f)
+                print("        const char *c;", file=f)
+                print("        for(i = 1, c = names; *c; c++) if(*c == ',') i++;", file=f)
+                print("        r = __comp_reserve(i);", file=f)
+                print("    }", file=f)
+                print("    if(r) { hal_exit(comp_id); return r; }", file=f)
             print("    if(count) {", file=f)
             print("        for(i=0; i<count; i++) {", file=f)
             print("            char buf[HAL_NAME_LEN + 1];", file=f)
@@ -623,6 +681,8 @@ static int comp_id;
                 print("        }", file=f)
                 print("    }", file=f)
 
+        if batched():
+            print("    if(!r) r = __comp_export_batch();", file=f)
         if options.get("constructable") and not options.get("singleton"):
             print("    hal_set_constructor(comp_id, export_1);", file=f)
         print("    if(r) {", file=f)
@@ -771,6 +831,23 @@ def epilogue(f):
         print("static int __comp_get_data_size(void) { return sizeof(%s); }" % data, file=f)
     else:
         print("static int __comp_get_data_size(void) { return 0; }", file=f)
+    if batched():
+        for name, fp in functions:
+            print("static void __comp_batch_%s(void *__arg, long __period) {" % to_c(name), file=f)
+            print("    const int __sz = (sizeof(struct __comp_state) + __comp_get_data_size() + 15) & ~15;", file=f)
+            print("    struct __comp_state *__inst;", file=f)
+            print("    int __i;", file=f)
+            print("    for(__i = 0; __i < __comp_pool_used; __i++) {", file=f)
+            print("        %s((struct __comp_state *)(__comp_pool + __i * __sz), __period);" % to_c(name), file=f)
+            print("    }", file=f)
+            print("    /* instances made later with newinst */", file=f)
+            print("    __inst = __comp_pool_used", file=f)
+            print("        ? ((struct __comp_state *)(__comp_pool + (__comp_pool_used - 1) * __sz))->_next", file=f)
+            print("        : __comp_first_inst;", file=f)
+            print("    for(; __inst; __inst = __inst->_next) {", file=f)
+            print("        %s(__inst, __period);" % to_c(name), file=f)
+            print("    }", file=f)
+            print("}", file=f)
 
 INSTALL, COMPILE, PREPROCESS, DOCUMENT, INSTALLDOC, VIEWDOC, MODINC = range(7)
 modename = ("install", "compile", "preprocess", "document", "installdoc", "viewdoc", "print-modinc")
@@ -955,6 +1032,17 @@ def document(filename, outfilename):
             else:
                 print("", file=f)
             print(doc, file=f)
+        if batched():
+            for _, name, fp, doc in finddocs('funct'):
+                print(".TP", file=f)
+                print("\\fB%s\\fR" % batch_name(name), end='', file=f)
+                if fp:
+                    print(" (requires a floating-point thread)", file=f)
+                else:
+                    print("", file=f)
+                print("Runs \\fB%s\\fR for every instance, in the order they were created."
+                    "  Add either this or the per-instance functions to a thread, not both."
+                    % to_hal_man(name), file=f)
 
     lead = ".TP"
     print(".SH PINS", file=f)
@@ -1092,6 +1180,9 @@ Usage:
     [sudo] %(name)s --install --userspace pyfile...
            %(name)s --print-modinc
 
+Option to export batch functions as if 'option batch yes' were given:
+    --batch
+
 Option to set maximum 'personalities' items:
     --personalities=integer_value   (default is %(dflt)d)
 """ % {'name': os.path.basename(sys.argv[0]),'dflt':MAX_PERSONALITIES})
@@ -1101,6 +1192,7 @@ def main():
     global require_license
     global MAX_USERSPACE_NAMES
     global MAX_PERSONALITIES
+    global force_batch
     require_license = True
     global require_unix_line_endings
     require_unix_line_endings = False
@@ -1108,11 +1200,11 @@ def main():
     outfile = None
     userspace = False
     try:
-        opts, args = getopt.getopt(sys.argv[1:], "Uluijcpdo:h?P:",
+        opts, args = getopt.getopt(sys.argv[1:], "Uluijcpdo:h?P:b",
                            ['unix', 'install', 'compile', 'preprocess', 'outfile=',
                             'document', 'help', 'userspace', 'install-doc',
                             'view-doc', 'require-license', 'print-modinc',
-                            'personalities='])
+                            'personalities=', 'batch'])
     except getopt.GetoptError:
         usage(1)
 
@@ -1141,6 +1233,8 @@ def main():
             if len(args) != 1:
                 raise SystemExit("Cannot specify -o with multiple input files")
             outfile = v 
+        if k in ("-b", "--batch"):
+            force_batch = True
         if k in ("-P", "--personalities"):
             try:
                 MAX_PERSONALITIES = int(v)
@@ -106,6 +106,7 @@ int main(int argc, gchar * argv[])
     int num_samples = SCOPE_NUM_SAMPLES_DEFAULT;
     char *ifilename = "autosave.halscope";
     char *ofilename = "autosave.halscope";
+    char *vfilename = NULL;
 
     bindtextdomain("linuxcnc", EMC2_PO_DIR);
     setlocale(LC_MESSAGES,"");
@@ -119,13 +120,13 @@ int main(int argc, gchar * argv[])
 
     while(1) {
         int c;
-        c = getopt(argc, argv, "hi:o:");
+        c = getopt(argc, argv, "hi:o:f:");
         if(c == -1) break;
         switch(c) {
          case 'h':
             rtapi_print_msg(RTAPI_MSG_ERR,
             _("Usage:\n  halscope [-h] [-i infile] [-o outfile]"
-            " [num_samples]\n"));
+            " [-f streamfile] [num_samples]\n"));
             return -1;
             break;
          case 'i':
@@ -134,6 +135,9 @@ int main(int argc, gchar * argv[])
          case 'o':
             ofilename = optarg;
             break;
+         case 'f':
+            vfilename = optarg;
+            break;
         }
     }
     if(argc > optind) num_samples = atoi(argv[argc-1]);
@@ -209,13 +213,24 @@ int main(int argc, gchar * argv[])
     /* The interface is now completely set up */
     /* show the window */
     gtk_widget_show(ctrl_usr->main_win);
-    /* read the saved config file */
-    read_config_file(ifilename);
+    if (vfilename != NULL) {
+	/* show a recorded stream instead of live data */
+	if (open_stream_view(vfilename) < 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"SCOPE: ERROR: can't read stream file '%s'\n", vfilename);
+	    exit(1);
+	}
+    } else {
+	/* read the saved config file */
+	read_config_file(ifilename);
+    }
     /* arrange for periodic call of heartbeat() */
     gtk_timeout_add(100, heartbeat, NULL);
     /* enter the main loop */
     gtk_main();
-    write_config_file(ofilename);
+    if (!stream_view_active()) {
+	write_config_file(ofilename);
+    }
 
     return (0);
 }
@@ -230,6 +245,14 @@ int main(int argc, gchar * argv[])
 static int heartbeat(gpointer data)
 {
     refresh_state_info();
+    if (stream_view_active()) {
+	/* nothing is live, just redraw when asked to */
+	if (ctrl_usr->display_refresh_timer > 0
+	    && --ctrl_usr->display_refresh_timer == 0) {
+	    refresh_display();
+	}
+	return 1;
+    }
     /* check watchdog */
     if (ctrl_shm->watchdog < 10) {
 	ctrl_shm->watchdog++;
@@ -266,8 +289,8 @@ void start_capture(void)
     hal_sig_t *sig;
     hal_param_t *param;
 
-    if (ctrl_shm->state != IDLE) {
-	/* already running! */
+    if (ctrl_shm->state != IDLE || stream_view_active()) {
+	/* already running, or showing a stream file */
 	return;
     }
     for (n = 0; n < 16; n++) {
@@ -206,7 +206,12 @@ void refresh_display(void)
     pixels_per_sec = pixels_per_div / horiz->disp_scale;
     disp->pixels_per_sample = pixels_per_sec * horiz->sample_period;
     overall_record_length = horiz->sample_period * ctrl_shm->rec_len;
-    screen_center_time = overall_record_length * horiz->pos_setting;
+    if (stream_view_active()) {
+	/* the position slider moves the window within the file */
+	screen_center_time = overall_record_length * 0.5;
+    } else {
+	screen_center_time = overall_record_length * horiz->pos_setting;
+    }
     screen_start_time = screen_center_time - (5.0 * horiz->disp_scale);
     disp->horiz_offset = screen_start_time * pixels_per_sec;
     disp->start_sample = screen_start_time / horiz->sample_period;
@@ -502,6 +507,10 @@ static void change_zoom(int dir, int x) {
     old_pixels_per_sample = disp->pixels_per_sample;
 
     set_horiz_zoom(horiz->zoom_setting + dir);
+    if (stream_view_active()) {
+	/* position is relative to the file, not the buffer */
+	return;
+    }
 
     /* calculate horizontal params that depend on width */
     pixels_per_div = disp->width * 0.1;
@@ -563,6 +572,8 @@ static void middle_drag(int dx) {
     scope_disp_t *disp = &(ctrl_usr->disp);
     scope_horiz_t *horiz = &(ctrl_usr->horiz);
     double dt = (dx / disp->pixels_per_sample) / ctrl_shm->rec_len;
+    /* when viewing a stream file the buffer is only part of the file */
+    dt *= stream_view_fraction();
     set_horiz_pos(horiz->pos_setting + 5 * dt);
     refresh_display();
 }
@@ -286,11 +286,12 @@ void refresh_state_info(void)
 	"TRIGGER?",
 	"TRIGGERED",
 	"DONE",
-	"RESET"
+	"RESET",
+	"STREAM"
     };
 
     horiz = &(ctrl_usr->horiz);
-    if (ctrl_shm->state > RESET) {
+    if (ctrl_shm->state > STREAMING) {
 	ctrl_shm->state = IDLE;
     }
     gtk_label_set_text_if(horiz->state_label, state_names[ctrl_shm->state]);
@@ -411,6 +412,8 @@ int set_horiz_zoom(int setting)
     /* set zoom slider based on new setting */
     adj = GTK_ADJUSTMENT(horiz->zoom_adj);
     gtk_adjustment_set_value(adj, setting);
+    /* a stream file being viewed loads a new window instead */
+    refresh_stream_view();
     /* refresh other stuff */    
     calc_horiz_scaling();
     refresh_horiz_info();
@@ -434,6 +437,10 @@ int set_horiz_pos(double setting)
     /* set position slider based on new setting */
     adj = GTK_ADJUSTMENT(horiz->pos_adj);
     gtk_adjustment_set_value(adj, setting * 1000);
+    if (stream_view_active()) {
+	refresh_stream_view();
+	calc_horiz_scaling();
+    }
     /* refresh other stuff */    
     refresh_horiz_info();
     request_display_refresh(1);
@@ -974,7 +981,7 @@ static void calc_horiz_scaling(void)
     scope_horiz_t *horiz;
     double total_rec_time;
     long int desired_usec_per_div, actual_usec_per_div;
-    int n, decade, sub_decade;
+    int n, zoom, decade, sub_decade;
 
     horiz = &(ctrl_usr->horiz);
     if (horiz->thread_name == NULL) {
@@ -1009,8 +1016,10 @@ static void calc_horiz_scaling(void)
 	}
 	actual_usec_per_div = decade * sub_decade;
     }
-    /* now correct for zoom factor */
-    for (n = 1; n < horiz->zoom_setting; n++) {
+    /* now correct for zoom factor; a stream file being viewed zooms by
+       loading a narrower window, and the whole window is displayed */
+    zoom = stream_view_active() ? 1 : horiz->zoom_setting;
+    for (n = 1; n < zoom; n++) {
 	if (sub_decade == 1) {
 	    sub_decade = 5;
 	    decade /= 10;
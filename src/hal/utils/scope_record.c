@@ -0,0 +1,575 @@
+/** This file, 'scope_record.c', is 'halscope-record', a command line
+    companion to 'halscope' that runs the realtime part of the scope
+    in streaming mode and writes everything it captures to a stream
+    file (see 'scope_stream.h'), for as long as it is left running.
+    The file can be viewed with 'halscope -f'.
+
+    Invoking:
+
+    halscope-record -t thread [options] -o file source...
+    halscope-record -d file
+
+    Each 'source' is the name of a pin, signal or parameter, optionally
+    prefixed with 'pin:', 'sig:' or 'param:' to pick between objects
+    with the same name.  Up to 16 sources can be recorded.
+
+    -t thread     thread to sample in (required)
+    -m mult       sample every 'mult' periods of the thread
+    -o file       stream file to write (required)
+    -n count      stop after 'count' sample periods
+    -c samples    samples per chunk in the file
+    -N samples    ring size to use if scope_rt has to be loaded
+    -T chan       trigger channel, 1 to the number of sources
+    -l level      trigger level
+    -e edge       'rise' (default) or 'fall'
+    -p pre        with -P, only keep 'pre' samples before and
+    -P post       'post' samples after each trigger; without them
+                  everything is kept and triggers are only marked
+
+    With -d, the samples in an existing stream file are printed one
+    per line, as the sample number followed by the value of each
+    channel.  Samples that were lost or not kept are left out.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "hal.h"		/* HAL public API decls */
+#include "../hal_priv.h"	/* HAL private API decls */
+#include "scope_shm.h"
+#include "scope_stream.h"
+
+/***********************************************************************
+*                         TYPEDEFS AND DEFINES                         *
+************************************************************************/
+
+/* how often the ring is drained */
+#define POLL_USEC 10000
+/* polls without a sample before the thread is assumed stopped */
+#define WATCHDOG_POLLS 100
+
+/***********************************************************************
+*                         GLOBAL VARIABLES                             *
+************************************************************************/
+
+static int comp_id = -1;
+static int shm_id = -1;
+static scope_shm_control_t *ctrl_shm;
+static scope_data_t *buffer;
+static sig_atomic_t stop;
+
+static int num_chans;
+static hal_type_t chan_type[16];
+static char *chan_name[16];
+
+/* trigger windows, both zero to keep everything */
+static long pre_samples, post_samples;
+static scope_data_t *history;	/* last 'pre_samples' samples */
+static uint64_t history_first, history_count;
+static uint64_t keep_until;	/* keep samples up to here */
+static int keeping;
+
+/***********************************************************************
+*                  LOCAL FUNCTION DEFINITIONS                          *
+************************************************************************/
+
+static void quit(int sig)
+{
+    stop = 1;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+	"Usage: halscope-record -t thread [-m mult] [-n count] [-c chunk]\n"
+	"           [-N ring] [-T chan [-l level] [-e rise|fall]\n"
+	"           [-p pre -P post]] -o file source...\n"
+	"       halscope-record -d file\n");
+}
+
+/* point channel 'n' at a pin, signal or parameter, like halscope does
+   when a capture starts; call with the HAL mutex held */
+static int find_source(int n, char *spec)
+{
+    char *name = strchr(spec, ':');
+    int want = -1;		/* -1 any, 0 pin, 1 sig, 2 param */
+    hal_pin_t *pin = NULL;
+    hal_sig_t *sig = NULL;
+    hal_param_t *param = NULL;
+
+    if (name != NULL) {
+	*name++ = '\0';
+	if (strcmp(spec, "pin") == 0) {
+	    want = 0;
+	} else if (strcmp(spec, "sig") == 0) {
+	    want = 1;
+	} else if (strcmp(spec, "param") == 0) {
+	    want = 2;
+	} else {
+	    fprintf(stderr, "ERROR: unknown source type '%s'\n", spec);
+	    return -1;
+	}
+    } else {
+	name = spec;
+    }
+    if (want <= 0 && (pin = halpr_find_pin_by_name(name)) != NULL) {
+	if (pin->signal == 0) {
+	    /* pin is unlinked, get data from dummysig */
+	    ctrl_shm->data_offset[n] = SHMOFF(&(pin->dummysig));
+	} else {
+	    sig = SHMPTR(pin->signal);
+	    ctrl_shm->data_offset[n] = sig->data_ptr;
+	}
+	chan_type[n] = pin->type;
+    } else if ((want == -1 || want == 1)
+	&& (sig = halpr_find_sig_by_name(name)) != NULL) {
+	ctrl_shm->data_offset[n] = sig->data_ptr;
+	chan_type[n] = sig->type;
+    } else if ((want == -1 || want == 2)
+	&& (param = halpr_find_param_by_name(name)) != NULL) {
+	ctrl_shm->data_offset[n] = param->data_ptr;
+	chan_type[n] = param->type;
+    } else {
+	fprintf(stderr, "ERROR: '%s' not found\n", name);
+	return -1;
+    }
+    switch (chan_type[n]) {
+    case HAL_BIT:
+	ctrl_shm->data_len[n] = sizeof(hal_bit_t);
+	break;
+    case HAL_FLOAT:
+	ctrl_shm->data_len[n] = sizeof(hal_float_t);
+	break;
+    case HAL_S32:
+	ctrl_shm->data_len[n] = sizeof(hal_s32_t);
+	break;
+    case HAL_U32:
+	ctrl_shm->data_len[n] = sizeof(hal_u32_t);
+	break;
+    default:
+	fprintf(stderr, "ERROR: '%s' has a type the scope can't sample\n", name);
+	return -1;
+    }
+    ctrl_shm->data_type[n] = chan_type[n];
+    chan_name[n] = name;
+    return 0;
+}
+
+static int set_trigger_level(hal_type_t type, const char *text)
+{
+    char *end;
+
+    switch (type) {
+    case HAL_FLOAT:
+	ctrl_shm->trig_level.d_real = strtod(text, &end);
+	break;
+    case HAL_S32:
+	ctrl_shm->trig_level.d_s32 = strtol(text, &end, 0);
+	break;
+    case HAL_U32:
+	ctrl_shm->trig_level.d_u32 = strtoul(text, &end, 0);
+	break;
+    default:
+	/* bits trigger on their edges, the level is not used */
+	return 0;
+    }
+    return *end ? -1 : 0;
+}
+
+/* write one sample, leaving a gap in the file if samples before it
+   were not kept */
+static int write_sample(scope_stream_writer_t *w, uint64_t tick,
+    const scope_data_t *sample)
+{
+    uint64_t next = scope_stream_next(w);
+
+    if (tick > next && scope_stream_skip(w, tick - next) < 0) {
+	return -1;
+    }
+    return scope_stream_append(w, sample);
+}
+
+/* handle one sample in windowed mode */
+static int window_sample(scope_stream_writer_t *w, uint64_t tick,
+    const scope_data_t *sample, int triggered)
+{
+    if (triggered) {
+	/* write out the pre-trigger history, oldest first */
+	uint64_t n;
+	for (n = 0; n < history_count; n++) {
+	    uint64_t t = history_first + n;
+	    if (write_sample(w, t,
+		    history + (t % pre_samples) * num_chans) < 0) {
+		return -1;
+	    }
+	}
+	history_count = 0;
+	keep_until = tick + post_samples;
+	keeping = 1;
+    }
+    if (keeping && tick <= keep_until) {
+	return write_sample(w, tick, sample);
+    }
+    keeping = 0;
+    if (pre_samples > 0) {
+	if (history_count == (uint64_t) pre_samples) {
+	    history_first++;
+	    history_count--;
+	}
+	if (history_count == 0) {
+	    history_first = tick;
+	}
+	memcpy(history + (tick % pre_samples) * num_chans, sample,
+	    sizeof(scope_data_t) * num_chans);
+	history_count++;
+    }
+    return 0;
+}
+
+/* print every sample in a stream file */
+static int dump_file(const char *filename)
+{
+    scope_stream_reader_t r;
+    uint64_t sample;
+    double value;
+    unsigned n;
+
+    if (scope_stream_open(&r, filename) < 0) {
+	perror(filename);
+	return 1;
+    }
+    for (sample = r.first; sample < r.end; sample++) {
+	if (scope_stream_value(&r, 0, sample, &value) < 0) {
+	    continue;
+	}
+	printf("%llu %.15g", (unsigned long long) sample, value);
+	for (n = 1; n < r.hdr.num_chans; n++) {
+	    scope_stream_value(&r, n, sample, &value);
+	    printf(" %.15g", value);
+	}
+	printf("\n");
+    }
+    scope_stream_release(&r);
+    return 0;
+}
+
+/***********************************************************************
+*                            MAIN PROGRAM                              *
+************************************************************************/
+
+int main(int argc, char **argv)
+{
+    char comp_name[HAL_NAME_LEN + 1];
+    char *thread_name = NULL, *filename = NULL, *level = NULL;
+    long mult = 1, count = -1, chunk = 0, ring = 0;
+    int trig_chan = 0, rising = 1;
+    int c, n, retval, exitval = 1, started = 0;
+    void *shm_base;
+    hal_thread_t *thread;
+    double sample_period = 0.0;
+    scope_stream_writer_t w;
+    unsigned out, last_lost, last_trig, slots;
+    uint64_t tick = 0, lost_total = 0, trigs = 0;
+    int idle_polls = 0;
+
+    while ((c = getopt(argc, argv, "t:m:o:n:c:N:T:l:e:p:P:d:h")) != -1) {
+	switch (c) {
+	case 't':
+	    thread_name = optarg;
+	    break;
+	case 'm':
+	    mult = atol(optarg);
+	    break;
+	case 'o':
+	    filename = optarg;
+	    break;
+	case 'n':
+	    count = atol(optarg);
+	    break;
+	case 'c':
+	    chunk = atol(optarg);
+	    break;
+	case 'N':
+	    ring = atol(optarg);
+	    break;
+	case 'T':
+	    trig_chan = atoi(optarg);
+	    break;
+	case 'l':
+	    level = optarg;
+	    break;
+	case 'e':
+	    if (strcmp(optarg, "rise") == 0) {
+		rising = 1;
+	    } else if (strcmp(optarg, "fall") == 0) {
+		rising = 0;
+	    } else {
+		usage();
+		return 1;
+	    }
+	    break;
+	case 'p':
+	    pre_samples = atol(optarg);
+	    break;
+	case 'P':
+	    post_samples = atol(optarg);
+	    break;
+	case 'd':
+	    return dump_file(optarg);
+	default:
+	    usage();
+	    return 1;
+	}
+    }
+    num_chans = argc - optind;
+    if (thread_name == NULL || filename == NULL || num_chans < 1
+	|| num_chans > 16 || mult < 1 || chunk < 0 || ring < 0
+	|| pre_samples < 0 || post_samples < 0
+	|| trig_chan < 0 || trig_chan > num_chans
+	|| ((pre_samples || post_samples) && trig_chan == 0)) {
+	usage();
+	return 1;
+    }
+
+    signal(SIGINT, quit);
+    signal(SIGTERM, quit);
+    snprintf(comp_name, sizeof(comp_name), "halscope-record%d", getpid());
+    comp_id = hal_init(comp_name);
+    if (comp_id < 0) {
+	fprintf(stderr, "ERROR: hal_init() failed: %d\n", comp_id);
+	return 1;
+    }
+    if (!halpr_find_funct_by_name("scope.sample")) {
+	char buf[1000];
+	snprintf(buf, sizeof(buf), EMC2_BIN_DIR "/halcmd loadrt scope_rt num_samples=%ld",
+	    ring > 0 ? ring : (long) SCOPE_NUM_SAMPLES_DEFAULT);
+	if (system(buf) != 0) {
+	    fprintf(stderr, "ERROR: loadrt scope_rt failed\n");
+	    goto out;
+	}
+    }
+    shm_id = rtapi_shmem_new(SCOPE_SHM_KEY, comp_id, sizeof(scope_shm_control_t));
+    if (shm_id < 0 || rtapi_shmem_getptr(shm_id, &shm_base) < 0) {
+	fprintf(stderr, "ERROR: failed to map scope shared memory\n");
+	goto out;
+    }
+    ctrl_shm = shm_base;
+    buffer = (scope_data_t *) ((char *) shm_base
+	+ ((sizeof(scope_shm_control_t) + 3) & ~3));
+    hal_ready(comp_id);
+    if (ctrl_shm->shm_size == 0) {
+	fprintf(stderr, "ERROR: realtime component not loaded\n");
+	goto out;
+    }
+    if (ctrl_shm->thread_name[0] != '\0' || ctrl_shm->state != IDLE) {
+	fprintf(stderr, "ERROR: the scope is in use, close halscope first\n");
+	goto out;
+    }
+
+    /* point the channels at their sources */
+    rtapi_mutex_get(&(hal_data->mutex));
+    thread = halpr_find_thread_by_name(thread_name);
+    retval = thread ? 0 : -1;
+    if (thread == NULL) {
+	fprintf(stderr, "ERROR: thread '%s' not found\n", thread_name);
+    } else {
+	sample_period = thread->period * 1e-9 * mult;
+    }
+    for (n = 0; n < 16; n++) {
+	ctrl_shm->data_len[n] = 0;
+    }
+    for (n = 0; n < num_chans && retval == 0; n++) {
+	retval = find_source(n, argv[optind + n]);
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    if (retval < 0) {
+	goto out;
+    }
+
+    /* the ring needs room for a whole sample and the lost count per slot */
+    for (n = 1; n < num_chans + 1; n *= 2);
+    ctrl_shm->sample_len = n;
+    ctrl_shm->rec_len = ctrl_shm->buf_len / ctrl_shm->sample_len;
+    slots = ctrl_shm->rec_len;
+    ctrl_shm->mult = mult;
+    ctrl_shm->pre_trig = 0;
+    ctrl_shm->auto_trig = 0;
+    ctrl_shm->force_trig = 0;
+    ctrl_shm->trig_chan = trig_chan;
+    ctrl_shm->trig_edge = rising;
+    ctrl_shm->trig_level.d_ireal = 0;
+    if (trig_chan && level
+	&& set_trigger_level(chan_type[trig_chan - 1], level) < 0) {
+	fprintf(stderr, "ERROR: bad trigger level '%s'\n", level);
+	goto out;
+    }
+    if (pre_samples > 0) {
+	history = malloc(sizeof(scope_data_t) * pre_samples * num_chans);
+	if (history == NULL) {
+	    fprintf(stderr, "ERROR: out of memory\n");
+	    goto out;
+	}
+    }
+
+    if (scope_stream_create(&w, filename, num_chans, chan_type, chan_name,
+	    sample_period, chunk) < 0) {
+	perror(filename);
+	goto out;
+    }
+    /* start sampling */
+    retval = hal_add_funct_to_thread("scope.sample", thread_name, -1);
+    if (retval < 0) {
+	fprintf(stderr, "ERROR: can't add scope.sample to '%s'\n", thread_name);
+	scope_stream_close(&w);
+	goto out;
+    }
+    strncpy(ctrl_shm->thread_name, thread_name, HAL_NAME_LEN);
+    ctrl_shm->thread_name[HAL_NAME_LEN] = '\0';
+    ctrl_shm->stream = 1;
+    ctrl_shm->stream_out = 0;
+    out = 0;
+    last_lost = 0;
+    last_trig = 0;
+    started = 1;
+    __sync_synchronize();
+    ctrl_shm->state = INIT;
+
+    while (!stop && (count < 0 || tick < (uint64_t) count)) {
+	unsigned in, lost, trig_count, avail, i;
+
+	usleep(POLL_USEC);
+	if (ctrl_shm->state != STREAMING) {
+	    /* realtime hasn't picked up the INIT yet */
+	    if (++idle_polls > WATCHDOG_POLLS) {
+		fprintf(stderr, "ERROR: thread '%s' is not running\n", thread_name);
+		break;
+	    }
+	    continue;
+	}
+	lost = ctrl_shm->stream_lost;
+	__sync_synchronize();
+	in = ctrl_shm->stream_in;
+	__sync_synchronize();
+	trig_count = ctrl_shm->trig_count;
+	__sync_synchronize();
+	if (trig_count - last_trig > SCOPE_STREAM_TRIGS) {
+	    fprintf(stderr, "%u triggers were missed\n",
+		trig_count - last_trig - SCOPE_STREAM_TRIGS);
+	    last_trig = trig_count - SCOPE_STREAM_TRIGS;
+	}
+	avail = in - out;
+	if (avail == 0 && lost == last_lost) {
+	    if (++idle_polls > WATCHDOG_POLLS) {
+		fprintf(stderr, "ERROR: no samples from thread '%s'\n", thread_name);
+		break;
+	    }
+	    continue;
+	}
+	idle_polls = 0;
+	for (i = 0; i < avail; i++) {
+	    unsigned sample_no = out + i;
+	    scope_data_t *sample = buffer + (sample_no % slots) * ctrl_shm->sample_len;
+	    unsigned dropped = sample[ctrl_shm->sample_len - 1].d_u32 - last_lost;
+	    int triggered = 0;
+	    /* the periods dropped since the previous sample came before
+	       this one, whenever the reader gets to see the count */
+	    if (dropped) {
+		last_lost += dropped;
+		lost_total += dropped;
+		tick += dropped;
+		/* the history is no longer contiguous */
+		history_count = 0;
+		if (count >= 0 && tick >= (uint64_t) count) {
+		    break;
+		}
+	    }
+	    /* triggers are in sample order; one on a sample that is not in
+	       the ring yet waits for the next poll */
+	    while (last_trig != trig_count
+		&& ctrl_shm->trig_sample[last_trig % SCOPE_STREAM_TRIGS] - out <= i) {
+		triggered = 1;
+		last_trig++;
+	    }
+	    if (triggered) {
+		scope_stream_trigger(&w, tick);
+		trigs++;
+	    }
+	    if (pre_samples || post_samples) {
+		retval = window_sample(&w, tick, sample, triggered);
+	    } else {
+		retval = write_sample(&w, tick, sample);
+	    }
+	    if (retval < 0) {
+		perror(filename);
+		stop = 1;
+		break;
+	    }
+	    tick++;
+	    if (count >= 0 && tick >= (uint64_t) count) {
+		i++;
+		break;
+	    }
+	}
+	/* hand the slots back to realtime */
+	out += i;
+	__sync_synchronize();
+	ctrl_shm->stream_out = out;
+    }
+    /* periods dropped after the last sample taken */
+    if (count < 0) {
+	lost_total += ctrl_shm->stream_lost - last_lost;
+	tick += ctrl_shm->stream_lost - last_lost;
+    }
+    if (scope_stream_close(&w) < 0) {
+	perror(filename);
+    } else {
+	exitval = 0;
+    }
+    fprintf(stderr, "%llu sample periods, %llu samples lost, %llu triggers\n",
+	(unsigned long long) tick, (unsigned long long) lost_total,
+	(unsigned long long) trigs);
+
+out:
+    if (started) {
+	/* stop sampling and give the scope back */
+	hal_del_funct_from_thread("scope.sample", ctrl_shm->thread_name);
+	ctrl_shm->thread_name[0] = '\0';
+	ctrl_shm->stream = 0;
+	ctrl_shm->state = IDLE;
+    }
+    if (shm_id >= 0) {
+	rtapi_shmem_delete(shm_id, comp_id);
+    }
+    hal_exit(comp_id);
+    return exitval;
+}
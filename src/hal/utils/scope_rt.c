@@ -72,6 +72,7 @@ static void init_shm_control_struct(void);
 
 static void sample(void *arg, long period);
 static void capture_sample(void);
+static void stream_sample(void);
 static int check_trigger(void);
 
 /***********************************************************************
@@ -183,7 +184,19 @@ static void sample(void *arg, long period)
 	    ctrl_rt->data_len[n] = ctrl_shm->data_len[n];
 	}
 	/* set next state */
-	ctrl_shm->state = PRE_TRIG;
+	if (ctrl_shm->stream) {
+	    ctrl_shm->stream_in = 0;
+	    ctrl_shm->stream_lost = 0;
+	    ctrl_shm->trig_count = 0;
+	    /* dummy call to preset 'compare_result' */
+	    check_trigger();
+	    ctrl_shm->state = STREAMING;
+	} else {
+	    ctrl_shm->state = PRE_TRIG;
+	}
+	break;
+    case STREAMING:
+	stream_sample();
 	break;
     case PRE_TRIG:
 	/* acquire a sample */
@@ -282,6 +295,41 @@ static void capture_sample(void)
     }
 }
 
+static void stream_sample(void)
+{
+    unsigned in, slots, slot;
+    int captured = 0;
+
+    in = ctrl_shm->stream_in;
+    slots = ctrl_shm->buf_len / ctrl_shm->sample_len;
+    if (in - ctrl_shm->stream_out < slots) {
+	/* there is room, capture into the next slot */
+	slot = (in % slots) * ctrl_shm->sample_len;
+	ctrl_shm->curr = slot;
+	capture_sample();
+	/* and note how many were dropped before this one */
+	ctrl_rt->buffer[slot + ctrl_shm->sample_len - 1].d_u32 =
+	    ctrl_shm->stream_lost;
+	captured = 1;
+    } else {
+	/* reader has fallen behind, drop the sample */
+	ctrl_shm->stream_lost++;
+    }
+    if (check_trigger()) {
+	/* record the number of this sample, or if it was dropped, of the
+	   next one that is kept */
+	ctrl_shm->trig_sample[ctrl_shm->trig_count % SCOPE_STREAM_TRIGS] = in;
+	__sync_synchronize();
+	ctrl_shm->trig_count++;
+	ctrl_shm->force_trig = 0;
+    }
+    if (captured) {
+	/* the sample must be complete before the reader can see it */
+	__sync_synchronize();
+	ctrl_shm->stream_in = in + 1;
+    }
+}
+
 // TODO: type-independent way to get high bit
 // #define SIGN_BIT (~(((ireal_t)~(ireal_t)0)>>1))
 static int check_trigger(void)
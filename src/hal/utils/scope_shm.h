@@ -51,9 +51,13 @@ typedef enum {
     TRIG_WAIT,			/* waiting for trigger */
     POST_TRIG,			/* acquiring post-trigger data */
     DONE,			/* data acquisition complete */
-    RESET			/* data acquisition interrupted */
+    RESET,			/* data acquisition interrupted */
+    STREAMING			/* continuous capture into the ring */
 } scope_state_t;
 
+/* number of trigger events remembered while streaming */
+#define SCOPE_STREAM_TRIGS 16
+
 /* this struct holds a single value - one sample of one channel */
 
 typedef union {
@@ -91,6 +95,23 @@ typedef struct {
     int data_offset[16];	/* U data addr in shmem for each channel */
     hal_type_t data_type[16];	/* U data type for each channel */
     char data_len[16];		/* U data size, 0 if not to be acquired */
+    /* Streaming capture.  When 'stream' is set, INIT starts a capture
+       that never ends: the buffer becomes a ring of buf_len/sample_len
+       samples, and a user space reader takes samples from it while the
+       realtime code adds them.  Only realtime writes 'stream_in' and
+       only the reader writes 'stream_out'; both count samples since
+       INIT and wrap, and the slot of sample n is n % slots.  Samples
+       that arrive while the ring is full are dropped and counted.  The
+       last word of each slot holds 'stream_lost' as it was when the
+       sample was taken, so the reader can tell how many periods were
+       dropped just before it; 'sample_len' must leave room for it. */
+    int stream;			/* U nonzero to capture continuously */
+    volatile unsigned stream_in;	/* R samples put in the ring */
+    volatile unsigned stream_out;	/* U samples taken from the ring */
+    volatile unsigned stream_lost;	/* R samples dropped, ring was full */
+    volatile unsigned trig_count;	/* R triggers seen while streaming */
+    unsigned trig_sample[SCOPE_STREAM_TRIGS];	/* R stream_in at each
+						   trigger, by trig_count */
 } scope_shm_control_t;
 
 #endif /* HALSC_SHM_H */
@@ -0,0 +1,617 @@
+/** This file, 'scope_stream.c', reads and writes the files used for
+    streaming scope captures.  See 'scope_stream.h' for the layout.
+
+    Each chunk is compressed one channel at a time, and every chunk
+    starts from zero so it can be decoded on its own:
+
+      float  each value is XORed with the previous one, and only the
+             bytes up to the highest non-zero byte are stored, after a
+             one byte count.  Slowly changing values share sign,
+             exponent and the top of the mantissa, so this usually
+             drops two or three bytes, and a constant costs one.
+      s32    zigzag encoded difference from the previous value, stored
+      u32    as a base-128 varint.
+      bit    packed eight to a byte.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/types.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "hal.h"		/* HAL public API decls */
+#include "scope_stream.h"
+
+/***********************************************************************
+*                  LOCAL FUNCTION DEFINITIONS                          *
+************************************************************************/
+
+static double value_of(hal_type_t type, const scope_data_t *d)
+{
+    switch (type) {
+    case HAL_BIT:
+	return d->d_u8 ? 1.0 : 0.0;
+    case HAL_FLOAT:
+	return d->d_real;
+    case HAL_S32:
+	return d->d_s32;
+    case HAL_U32:
+	return d->d_u32;
+    default:
+	return 0.0;
+    }
+}
+
+/* worst case compressed size of one value */
+#define MAX_VALUE_BYTES 9
+
+static unsigned char *put_varint(unsigned char *p, rtapi_u32 v)
+{
+    while (v >= 0x80) {
+	*p++ = (v & 0x7f) | 0x80;
+	v >>= 7;
+    }
+    *p++ = v;
+    return p;
+}
+
+static const unsigned char *get_varint(const unsigned char *p,
+    const unsigned char *end, rtapi_u32 *v)
+{
+    rtapi_u32 x = 0;
+    int shift = 0;
+
+    while (p < end && shift < 35) {
+	x |= (rtapi_u32) (*p & 0x7f) << shift;
+	if (!(*p++ & 0x80)) {
+	    *v = x;
+	    return p;
+	}
+	shift += 7;
+    }
+    return NULL;
+}
+
+/* compress 'count' samples of 'num_chans' values, returns the size */
+static size_t encode_chunk(const scope_stream_header_t *hdr,
+    const scope_data_t *samples, int count, unsigned char *raw)
+{
+    unsigned char *p = raw;
+    int c, n, num_chans = hdr->num_chans;
+
+    for (c = 0; c < num_chans; c++) {
+	const scope_data_t *d = samples + c;
+	switch (hdr->chan[c].type) {
+	case HAL_FLOAT: {
+	    ireal_t prev = 0;
+	    for (n = 0; n < count; n++, d += num_chans) {
+		rtapi_u64 x = d->d_ireal ^ prev;
+		int len = 0;
+		prev = d->d_ireal;
+		while (len < 8 && (x >> (8 * len))) {
+		    len++;
+		}
+		*p++ = len;
+		for (; len > 0; len--, x >>= 8) {
+		    *p++ = x & 0xff;
+		}
+	    }
+	    break;
+	}
+	case HAL_S32:
+	case HAL_U32: {
+	    rtapi_u32 prev = 0;
+	    for (n = 0; n < count; n++, d += num_chans) {
+		rtapi_s32 diff = (rtapi_s32) (d->d_u32 - prev);
+		prev = d->d_u32;
+		p = put_varint(p, ((rtapi_u32) diff << 1) ^ (rtapi_u32) (diff >> 31));
+	    }
+	    break;
+	}
+	case HAL_BIT:
+	    for (n = 0; n < count; n += 8) {
+		unsigned char bits = 0;
+		int b;
+		for (b = 0; b < 8 && n + b < count; b++, d += num_chans) {
+		    if (d->d_u8) {
+			bits |= 1 << b;
+		    }
+		}
+		*p++ = bits;
+	    }
+	    break;
+	default:
+	    break;
+	}
+    }
+    return p - raw;
+}
+
+static int decode_chunk(const scope_stream_header_t *hdr,
+    const unsigned char *raw, size_t bytes, int count, scope_data_t *samples)
+{
+    const unsigned char *p = raw, *end = raw + bytes;
+    int c, n, num_chans = hdr->num_chans;
+
+    memset(samples, 0, sizeof(scope_data_t) * count * num_chans);
+    for (c = 0; c < num_chans; c++) {
+	scope_data_t *d = samples + c;
+	switch (hdr->chan[c].type) {
+	case HAL_FLOAT: {
+	    ireal_t prev = 0;
+	    for (n = 0; n < count; n++, d += num_chans) {
+		rtapi_u64 x = 0;
+		int len, b;
+		if (p >= end || (len = *p++) > 8 || p + len > end) {
+		    return -1;
+		}
+		for (b = 0; b < len; b++) {
+		    x |= (rtapi_u64) *p++ << (8 * b);
+		}
+		prev ^= x;
+		d->d_ireal = prev;
+	    }
+	    break;
+	}
+	case HAL_S32:
+	case HAL_U32: {
+	    rtapi_u32 prev = 0, z;
+	    for (n = 0; n < count; n++, d += num_chans) {
+		p = get_varint(p, end, &z);
+		if (p == NULL) {
+		    return -1;
+		}
+		prev += (z >> 1) ^ -(z & 1);
+		d->d_u32 = prev;
+	    }
+	    break;
+	}
+	case HAL_BIT:
+	    for (n = 0; n < count; n += 8) {
+		int b;
+		if (p >= end) {
+		    return -1;
+		}
+		for (b = 0; b < 8 && n + b < count; b++, d += num_chans) {
+		    d->d_u8 = (*p >> b) & 1;
+		}
+		p++;
+	    }
+	    break;
+	default:
+	    break;
+	}
+    }
+    return 0;
+}
+
+static int flush_chunk(scope_stream_writer_t *w)
+{
+    scope_stream_index_t *entry;
+    scope_stream_chunk_t *chunk;
+    int c, n, num_chans = w->hdr.num_chans;
+    off_t offset;
+
+    if (w->count == 0) {
+	return 0;
+    }
+    if (w->num_chunks == w->max_chunks) {
+	long max = w->max_chunks ? 2 * w->max_chunks : 256;
+	entry = realloc(w->index, max * sizeof(*entry));
+	if (entry == NULL) {
+	    return -1;
+	}
+	w->index = entry;
+	w->max_chunks = max;
+    }
+    offset = ftello(w->fp);
+    entry = &w->index[w->num_chunks];
+    entry->offset = offset;
+    chunk = &entry->chunk;
+    memset(chunk, 0, sizeof(*chunk));
+    chunk->magic = SCOPE_STREAM_CHUNK_MAGIC;
+    chunk->samples = w->count;
+    chunk->first = w->first;
+    for (c = 0; c < num_chans; c++) {
+	double v = value_of(w->hdr.chan[c].type, &w->samples[c]);
+	chunk->min[c] = chunk->max[c] = v;
+	for (n = 1; n < w->count; n++) {
+	    v = value_of(w->hdr.chan[c].type, &w->samples[n * num_chans + c]);
+	    if (v < chunk->min[c]) {
+		chunk->min[c] = v;
+	    }
+	    if (v > chunk->max[c]) {
+		chunk->max[c] = v;
+	    }
+	}
+    }
+    chunk->bytes = encode_chunk(&w->hdr, w->samples, w->count, w->raw);
+    if (fwrite(chunk, sizeof(*chunk), 1, w->fp) != 1
+	|| fwrite(w->raw, chunk->bytes, 1, w->fp) != 1) {
+	return -1;
+    }
+    /* complete chunks are visible to readers (and survive a crash of the
+       recorder) as soon as they are written */
+    fflush(w->fp);
+    w->num_chunks++;
+    w->first += w->count;
+    w->count = 0;
+    return 0;
+}
+
+/* index of the first chunk that ends after 'sample' */
+static long find_chunk(scope_stream_reader_t *r, uint64_t sample)
+{
+    long lo = 0, hi = r->num_chunks;
+
+    while (lo < hi) {
+	long mid = (lo + hi) / 2;
+	scope_stream_chunk_t *c = &r->index[mid].chunk;
+	if (c->first + c->samples <= sample) {
+	    lo = mid + 1;
+	} else {
+	    hi = mid;
+	}
+    }
+    return lo;
+}
+
+static int load_chunk(scope_stream_reader_t *r, long i)
+{
+    scope_stream_chunk_t *c = &r->index[i].chunk;
+
+    if (r->cached == i) {
+	return 0;
+    }
+    r->cached = -1;
+    if (fseeko(r->fp, r->index[i].offset + sizeof(*c), SEEK_SET) < 0
+	|| fread(r->raw, c->bytes, 1, r->fp) != 1
+	|| decode_chunk(&r->hdr, r->raw, c->bytes, c->samples, r->cache) < 0) {
+	return -1;
+    }
+    r->cached = i;
+    return 0;
+}
+
+/* rebuild the index of a file that was not closed cleanly */
+static int scan_chunks(scope_stream_reader_t *r, off_t size)
+{
+    scope_stream_chunk_t c;
+    off_t pos = sizeof(r->hdr);
+    long max = 0;
+
+    while (pos + (off_t) sizeof(c) <= size) {
+	if (fseeko(r->fp, pos, SEEK_SET) < 0 || fread(&c, sizeof(c), 1, r->fp) != 1
+	    || c.magic != SCOPE_STREAM_CHUNK_MAGIC
+	    || c.samples == 0 || c.samples > r->hdr.chunk_samples
+	    || pos + (off_t) sizeof(c) + c.bytes > size) {
+	    /* end of the good data */
+	    break;
+	}
+	if (r->num_chunks == max) {
+	    scope_stream_index_t *p;
+	    max = max ? 2 * max : 256;
+	    p = realloc(r->index, max * sizeof(*p));
+	    if (p == NULL) {
+		return -1;
+	    }
+	    r->index = p;
+	}
+	r->index[r->num_chunks].offset = pos;
+	r->index[r->num_chunks].chunk = c;
+	r->num_chunks++;
+	pos += sizeof(c) + c.bytes;
+    }
+    return 0;
+}
+
+/***********************************************************************
+*                        PUBLIC FUNCTIONS                              *
+************************************************************************/
+
+int scope_stream_create(scope_stream_writer_t *w, const char *filename,
+    int num_chans, const hal_type_t *types, char **names,
+    double sample_period, int chunk_samples)
+{
+    int n;
+
+    memset(w, 0, sizeof(*w));
+    if (num_chans < 1 || num_chans > SCOPE_STREAM_MAX_CHANS) {
+	return -1;
+    }
+    if (chunk_samples <= 0) {
+	chunk_samples = SCOPE_STREAM_CHUNK_DEFAULT;
+    }
+    memcpy(w->hdr.magic, SCOPE_STREAM_MAGIC, sizeof(w->hdr.magic));
+    w->hdr.version = SCOPE_STREAM_VERSION;
+    w->hdr.num_chans = num_chans;
+    w->hdr.chunk_samples = chunk_samples;
+    w->hdr.sample_period = sample_period;
+    for (n = 0; n < num_chans; n++) {
+	w->hdr.chan[n].type = types[n];
+	snprintf(w->hdr.chan[n].name, sizeof(w->hdr.chan[n].name), "%s",
+	    names[n]);
+    }
+    w->samples = malloc(sizeof(scope_data_t) * chunk_samples * num_chans);
+    w->raw = malloc(MAX_VALUE_BYTES * chunk_samples * num_chans);
+    if (w->samples == NULL || w->raw == NULL) {
+	free(w->samples);
+	free(w->raw);
+	return -1;
+    }
+    w->fp = fopen(filename, "wb");
+    if (w->fp == NULL) {
+	free(w->samples);
+	free(w->raw);
+	return -1;
+    }
+    if (fwrite(&w->hdr, sizeof(w->hdr), 1, w->fp) != 1) {
+	fclose(w->fp);
+	free(w->samples);
+	free(w->raw);
+	return -1;
+    }
+    return 0;
+}
+
+int scope_stream_append(scope_stream_writer_t *w, const scope_data_t *sample)
+{
+    int num_chans = w->hdr.num_chans;
+
+    memcpy(&w->samples[w->count * num_chans], sample,
+	sizeof(scope_data_t) * num_chans);
+    if (++w->count == (int) w->hdr.chunk_samples) {
+	return flush_chunk(w);
+    }
+    return 0;
+}
+
+int scope_stream_skip(scope_stream_writer_t *w, uint64_t count)
+{
+    /* chunks hold consecutive samples, so a gap ends the chunk */
+    if (flush_chunk(w) < 0) {
+	return -1;
+    }
+    w->first += count;
+    return 0;
+}
+
+int scope_stream_trigger(scope_stream_writer_t *w, uint64_t sample)
+{
+    if (w->num_trigs == w->max_trigs) {
+	long max = w->max_trigs ? 2 * w->max_trigs : 64;
+	uint64_t *p = realloc(w->trigs, max * sizeof(*p));
+	if (p == NULL) {
+	    return -1;
+	}
+	w->trigs = p;
+	w->max_trigs = max;
+    }
+    w->trigs[w->num_trigs++] = sample;
+    return 0;
+}
+
+uint64_t scope_stream_next(scope_stream_writer_t *w)
+{
+    return w->first + w->count;
+}
+
+int scope_stream_close(scope_stream_writer_t *w)
+{
+    scope_stream_trailer_t t;
+    int retval = 0;
+
+    if (w->fp == NULL) {
+	return -1;
+    }
+    if (flush_chunk(w) < 0) {
+	retval = -1;
+    }
+    memset(&t, 0, sizeof(t));
+    t.index_offset = ftello(w->fp);
+    t.num_chunks = w->num_chunks;
+    if (w->num_chunks
+	&& fwrite(w->index, sizeof(*w->index), w->num_chunks, w->fp)
+	!= (size_t) w->num_chunks) {
+	retval = -1;
+    }
+    t.trig_offset = ftello(w->fp);
+    t.num_trigs = w->num_trigs;
+    if (w->num_trigs
+	&& fwrite(w->trigs, sizeof(*w->trigs), w->num_trigs, w->fp)
+	!= (size_t) w->num_trigs) {
+	retval = -1;
+    }
+    memcpy(t.magic, SCOPE_STREAM_INDEX_MAGIC, sizeof(t.magic));
+    if (fwrite(&t, sizeof(t), 1, w->fp) != 1) {
+	retval = -1;
+    }
+    if (fclose(w->fp) != 0) {
+	retval = -1;
+    }
+    w->fp = NULL;
+    free(w->samples);
+    free(w->raw);
+    free(w->index);
+    free(w->trigs);
+    return retval;
+}
+
+int scope_stream_open(scope_stream_reader_t *r, const char *filename)
+{
+    scope_stream_trailer_t t;
+    off_t size;
+    long n;
+
+    memset(r, 0, sizeof(*r));
+    r->cached = -1;
+    r->fp = fopen(filename, "rb");
+    if (r->fp == NULL) {
+	return -1;
+    }
+    if (fread(&r->hdr, sizeof(r->hdr), 1, r->fp) != 1
+	|| memcmp(r->hdr.magic, SCOPE_STREAM_MAGIC, sizeof(r->hdr.magic))
+	|| r->hdr.version != SCOPE_STREAM_VERSION
+	|| r->hdr.num_chans < 1 || r->hdr.num_chans > SCOPE_STREAM_MAX_CHANS
+	|| r->hdr.chunk_samples == 0) {
+	goto fail;
+    }
+    fseeko(r->fp, 0, SEEK_END);
+    size = ftello(r->fp);
+    /* use the index if the file was closed properly */
+    if (size >= (off_t) (sizeof(r->hdr) + sizeof(t))
+	&& fseeko(r->fp, size - sizeof(t), SEEK_SET) == 0
+	&& fread(&t, sizeof(t), 1, r->fp) == 1
+	&& memcmp(t.magic, SCOPE_STREAM_INDEX_MAGIC, sizeof(t.magic)) == 0
+	&& t.index_offset + t.num_chunks * sizeof(*r->index) <= (uint64_t) size
+	&& t.trig_offset + t.num_trigs * sizeof(*r->trigs) <= (uint64_t) size) {
+	r->num_chunks = t.num_chunks;
+	r->num_trigs = t.num_trigs;
+	r->index = malloc((r->num_chunks + 1) * sizeof(*r->index));
+	r->trigs = malloc((r->num_trigs + 1) * sizeof(*r->trigs));
+	if (r->index == NULL || r->trigs == NULL
+	    || fseeko(r->fp, t.index_offset, SEEK_SET) < 0
+	    || fread(r->index, sizeof(*r->index), r->num_chunks, r->fp)
+	    != (size_t) r->num_chunks
+	    || fseeko(r->fp, t.trig_offset, SEEK_SET) < 0
+	    || fread(r->trigs, sizeof(*r->trigs), r->num_trigs, r->fp)
+	    != (size_t) r->num_trigs) {
+	    goto fail;
+	}
+    } else if (scan_chunks(r, size) < 0) {
+	goto fail;
+    }
+    r->cache = malloc(sizeof(scope_data_t) * r->hdr.chunk_samples
+	* r->hdr.num_chans);
+    r->raw = malloc(MAX_VALUE_BYTES * r->hdr.chunk_samples * r->hdr.num_chans);
+    if (r->cache == NULL || r->raw == NULL) {
+	goto fail;
+    }
+    for (n = 0; n < r->num_chunks; n++) {
+	if (r->index[n].chunk.bytes
+	    > MAX_VALUE_BYTES * r->hdr.chunk_samples * r->hdr.num_chans) {
+	    goto fail;
+	}
+    }
+    if (r->num_chunks > 0) {
+	scope_stream_chunk_t *last = &r->index[r->num_chunks - 1].chunk;
+	r->first = r->index[0].chunk.first;
+	r->end = last->first + last->samples;
+    }
+    return 0;
+
+fail:
+    scope_stream_release(r);
+    return -1;
+}
+
+void scope_stream_release(scope_stream_reader_t *r)
+{
+    if (r->fp != NULL) {
+	fclose(r->fp);
+    }
+    free(r->index);
+    free(r->trigs);
+    free(r->cache);
+    free(r->raw);
+    memset(r, 0, sizeof(*r));
+    r->cached = -1;
+}
+
+int scope_stream_value(scope_stream_reader_t *r, int chan, uint64_t sample,
+    double *value)
+{
+    long i = find_chunk(r, sample);
+    scope_stream_chunk_t *c;
+
+    if (i >= r->num_chunks || chan < 0 || chan >= (int) r->hdr.num_chans) {
+	return -1;
+    }
+    c = &r->index[i].chunk;
+    if (sample < c->first || load_chunk(r, i) < 0) {
+	return -1;
+    }
+    *value = value_of(r->hdr.chan[chan].type,
+	&r->cache[(sample - c->first) * r->hdr.num_chans + chan]);
+    return 0;
+}
+
+int scope_stream_lod(scope_stream_reader_t *r, int chan, uint64_t first,
+    uint64_t count, int buckets, double *min, double *max)
+{
+    int b, num_chans = r->hdr.num_chans;
+    hal_type_t type;
+
+    if (chan < 0 || chan >= num_chans || buckets <= 0) {
+	return -1;
+    }
+    type = r->hdr.chan[chan].type;
+    for (b = 0; b < buckets; b++) {
+	uint64_t b0 = first + (uint64_t) ((double) count * b / buckets);
+	uint64_t b1 = first + (uint64_t) ((double) count * (b + 1) / buckets);
+	double lo = INFINITY, hi = -INFINITY;
+	long i;
+
+	if (b1 == b0) {
+	    b1 = b0 + 1;
+	}
+	for (i = find_chunk(r, b0); i < r->num_chunks; i++) {
+	    scope_stream_chunk_t *c = &r->index[i].chunk;
+	    uint64_t c0, c1, s;
+
+	    if (c->first >= b1) {
+		break;
+	    }
+	    c0 = b0 > c->first ? b0 : c->first;
+	    c1 = b1 < c->first + c->samples ? b1 : c->first + c->samples;
+	    if (c0 == c->first && c1 == c->first + c->samples) {
+		/* the whole chunk is in this bucket, the index has it */
+		if (c->min[chan] < lo) {
+		    lo = c->min[chan];
+		}
+		if (c->max[chan] > hi) {
+		    hi = c->max[chan];
+		}
+		continue;
+	    }
+	    if (load_chunk(r, i) < 0) {
+		return -1;
+	    }
+	    for (s = c0; s < c1; s++) {
+		double v = value_of(type,
+		    &r->cache[(s - c->first) * num_chans + chan]);
+		if (v < lo) {
+		    lo = v;
+		}
+		if (v > hi) {
+		    hi = v;
+		}
+	    }
+	}
+	if (lo > hi) {
+	    lo = hi = NAN;
+	}
+	min[b] = lo;
+	max[b] = hi;
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+#ifndef HALSC_STREAM_H
+#define HALSC_STREAM_H
+/** This file, 'scope_stream.h', declares the file format used for
+    streaming scope captures, along with the writer used by
+    'halscope-record' and the reader used by 'halscope' to view them.
+    Nothing here depends on GTK.
+
+    A stream file holds any number of samples of up to 16 channels.
+    Samples are grouped into chunks that are compressed one channel
+    at a time.  Each chunk header carries the number of its first
+    sample and the min and max of every channel, so a viewer can
+    draw an overview of hours of data from the chunk headers alone,
+    and only decompresses chunks when zoomed in far enough to need
+    the individual samples.
+
+    Layout:
+
+        header
+        chunk header, compressed data
+        chunk header, compressed data
+        ...
+        index (one entry per chunk)
+        trigger list (sample numbers)
+        trailer
+
+    The index, trigger list and trailer are written when the capture
+    ends.  If they are missing, for example because the recorder was
+    killed, the reader rebuilds the index by walking the chunk headers.
+    Multi-byte values are in host byte order.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include "scope_shm.h"
+
+/***********************************************************************
+*                         TYPEDEFS AND DEFINES                         *
+************************************************************************/
+
+#define SCOPE_STREAM_MAGIC "HALSCST1"
+#define SCOPE_STREAM_INDEX_MAGIC "HALSCIDX"
+#define SCOPE_STREAM_CHUNK_MAGIC 0x4b4e4843	/* "CHNK" */
+#define SCOPE_STREAM_VERSION 1
+#define SCOPE_STREAM_CHUNK_DEFAULT 4096	/* samples per chunk */
+#define SCOPE_STREAM_MAX_CHANS 16
+
+typedef struct {
+    char magic[8];		/* SCOPE_STREAM_MAGIC */
+    uint32_t version;
+    uint32_t num_chans;		/* channels in each sample */
+    uint32_t chunk_samples;	/* max samples per chunk */
+    uint32_t reserved;
+    double sample_period;	/* seconds between samples */
+    struct {
+	uint32_t type;		/* hal_type_t of the channel */
+	char name[HAL_NAME_LEN + 1];	/* pin, signal or param name */
+    } chan[SCOPE_STREAM_MAX_CHANS];
+} scope_stream_header_t;
+
+typedef struct {
+    uint32_t magic;		/* SCOPE_STREAM_CHUNK_MAGIC */
+    uint32_t samples;		/* samples in this chunk */
+    uint64_t first;		/* sample number of the first sample */
+    uint32_t bytes;		/* size of the compressed data that follows */
+    uint32_t reserved;
+    double min[SCOPE_STREAM_MAX_CHANS];	/* per channel, over the chunk */
+    double max[SCOPE_STREAM_MAX_CHANS];
+} scope_stream_chunk_t;
+
+typedef struct {
+    uint64_t offset;		/* file offset of the chunk header */
+    scope_stream_chunk_t chunk;	/* copy of the chunk header */
+} scope_stream_index_t;
+
+typedef struct {
+    uint64_t index_offset;	/* file offset of the index */
+    uint64_t num_chunks;
+    uint64_t trig_offset;	/* file offset of the trigger list */
+    uint64_t num_trigs;
+    char magic[8];		/* SCOPE_STREAM_INDEX_MAGIC */
+} scope_stream_trailer_t;
+
+typedef struct {
+    FILE *fp;
+    scope_stream_header_t hdr;
+    scope_data_t *samples;	/* the chunk being built */
+    int count;			/* samples in it */
+    uint64_t first;		/* sample number of samples[0] */
+    unsigned char *raw;		/* compression buffer */
+    scope_stream_index_t *index;
+    long num_chunks, max_chunks;
+    uint64_t *trigs;
+    long num_trigs, max_trigs;
+} scope_stream_writer_t;
+
+typedef struct {
+    FILE *fp;
+    scope_stream_header_t hdr;
+    scope_stream_index_t *index;
+    long num_chunks;
+    uint64_t *trigs;
+    long num_trigs;
+    uint64_t first;		/* number of the first sample in the file */
+    uint64_t end;		/* one past the last sample in the file */
+    long cached;		/* chunk held in 'cache', -1 if none */
+    scope_data_t *cache;	/* decompressed samples of that chunk */
+    unsigned char *raw;
+} scope_stream_reader_t;
+
+/***********************************************************************
+*                          FUNCTIONS                                   *
+************************************************************************/
+
+/* writing */
+int scope_stream_create(scope_stream_writer_t *w, const char *filename,
+    int num_chans, const hal_type_t *types, char **names,
+    double sample_period, int chunk_samples);
+/* append one sample of 'num_chans' values */
+int scope_stream_append(scope_stream_writer_t *w, const scope_data_t *sample);
+/* leave a gap of 'count' samples, for samples that were not captured */
+int scope_stream_skip(scope_stream_writer_t *w, uint64_t count);
+/* record a trigger at sample number 'sample' */
+int scope_stream_trigger(scope_stream_writer_t *w, uint64_t sample);
+/* number the next appended sample will get */
+uint64_t scope_stream_next(scope_stream_writer_t *w);
+/* flush the current chunk, write the index and close the file */
+int scope_stream_close(scope_stream_writer_t *w);
+
+/* reading */
+int scope_stream_open(scope_stream_reader_t *r, const char *filename);
+void scope_stream_release(scope_stream_reader_t *r);
+/* the value of 'sample' on 'chan' as a double, returns -1 if the
+   sample is not in the file */
+int scope_stream_value(scope_stream_reader_t *r, int chan, uint64_t sample,
+    double *value);
+/* level of detail query: split samples [first, first+count) into
+   'buckets' equal buckets and return the min and max of 'chan' over
+   each one.  Chunks that fall entirely inside a bucket are summarized
+   from the index without being read.  Buckets without any samples get
+   NAN.  Returns 0, or -1 on a read error. */
+int scope_stream_lod(scope_stream_reader_t *r, int chan, uint64_t first,
+    uint64_t count, int buckets, double *min, double *max);
+
+#endif /* HALSC_STREAM_H */
@@ -296,4 +296,11 @@ int set_trigger_mode(int mode);
 int set_run_mode(int mode);
 void prepare_scope_restart(void);
 void log_popup(int);
+int set_channel_stream(int chan, hal_type_t type, char *name);
+
+/* viewing a stream file written by halscope-record, see scope_view.c */
+int open_stream_view(char *filename);
+int stream_view_active(void);
+void refresh_stream_view(void);
+double stream_view_fraction(void);
 #endif /* HALSC_USR_H */
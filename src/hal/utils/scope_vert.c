@@ -97,6 +97,7 @@ static void chan_sel_button(GtkWidget * widget, gpointer gdata);
 
 /* helper functions */
 static void write_chan_config(FILE *fp, scope_chan_t *chan);
+static void set_channel_limits(scope_chan_t *chan);
 
 /***********************************************************************
 *                       PUBLIC FUNCTIONS                               *
@@ -202,6 +203,38 @@ int set_channel_off(int chan_num)
     return 0;
 }
 
+/* set data length and scale slider limits from the data type */
+static void set_channel_limits(scope_chan_t *chan)
+{
+    switch (chan->data_type) {
+    case HAL_BIT:
+	chan->data_len = sizeof(hal_bit_t);
+	chan->min_index = -2;
+	chan->max_index = 2;
+	break;
+    case HAL_FLOAT:
+	chan->data_len = sizeof(hal_float_t);
+	chan->min_index = -36;
+	chan->max_index = 36;
+	break;
+    case HAL_S32:
+	chan->data_len = sizeof(hal_s32_t);
+	chan->min_index = -2;
+	chan->max_index = 30;
+	break;
+    case HAL_U32:
+	chan->data_len = sizeof(hal_u32_t);
+	chan->min_index = -2;
+	chan->max_index = 30;
+	break;
+    default:
+	/* Shouldn't get here, but just in case... */
+	chan->data_len = 0;
+	chan->min_index = -1;
+	chan->max_index = 1;
+    }
+}
+
 int set_channel_source(int chan_num, int type, char *name)
 {
     scope_vert_t *vert;
@@ -247,33 +280,7 @@ int set_channel_source(int chan_num, int type, char *name)
 	chan->data_type = param->type;
 	chan->name = param->name;
     }
-    switch (chan->data_type) {
-    case HAL_BIT:
-	chan->data_len = sizeof(hal_bit_t);
-	chan->min_index = -2;
-	chan->max_index = 2;
-	break;
-    case HAL_FLOAT:
-	chan->data_len = sizeof(hal_float_t);
-	chan->min_index = -36;
-	chan->max_index = 36;
-	break;
-    case HAL_S32:
-	chan->data_len = sizeof(hal_s32_t);
-	chan->min_index = -2;
-	chan->max_index = 30;
-	break;
-    case HAL_U32:
-	chan->data_len = sizeof(hal_u32_t);
-	chan->min_index = -2;
-	chan->max_index = 30;
-	break;
-    default:
-	/* Shouldn't get here, but just in case... */
-	chan->data_len = 0;
-	chan->min_index = -1;
-	chan->max_index = 1;
-    }
+    set_channel_limits(chan);
     /* invalidate any data in the buffer for this channel */
     vert->data_offset[chan_num - 1] = -1;
     /* set scale and offset to nominal values */
@@ -283,6 +290,27 @@ int set_channel_source(int chan_num, int type, char *name)
     return 0;
 }
 
+/* like set_channel_source, but for a channel of a stream file that is
+   being viewed, which need not exist in the HAL */
+int set_channel_stream(int chan_num, hal_type_t type, char *name)
+{
+    scope_chan_t *chan;
+
+    if ((chan_num < 1) || (chan_num > 16)) {
+	return -1;
+    }
+    chan = &(ctrl_usr->chan[chan_num - 1]);
+    chan->data_source_type = -1;
+    chan->data_source = 0;
+    chan->data_type = type;
+    chan->name = name;
+    set_channel_limits(chan);
+    ctrl_usr->vert.data_offset[chan_num - 1] = -1;
+    chan->vert_offset = 0.0;
+    chan->scale_index = 0;
+    return 0;
+}
+
 int set_vert_scale(int setting)
 {
     scope_vert_t *vert;
@@ -0,0 +1,252 @@
+/** This file, 'scope_view.c', lets halscope display a stream file
+    written by 'halscope-record' instead of live data ('halscope -f').
+
+    A stream file can hold far more samples than the display buffer,
+    so the buffer only ever holds a window of the file.  In view mode
+    the horizontal zoom slider picks the width of the window, from the
+    whole file at 1 down to 1/4^8 of it at 9, and the position slider
+    picks where in the file it is centered.  When the window holds
+    more samples than the buffer, each pair of buffer points is the
+    min and max of a bucket of samples, so short spikes stay visible
+    however far out the view is zoomed.  Those come from the chunk
+    summaries in the file where possible, so only the chunks that
+    overlap the edges of buckets, or a closely zoomed window, are read
+    and decompressed.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "hal.h"		/* HAL public API decls */
+#include "../hal_priv.h"	/* private HAL decls */
+
+#include <gtk/gtk.h>
+#include "miscgtk.h"		/* generic GTK stuff */
+#include "scope_usr.h"		/* scope related declarations */
+#include "scope_stream.h"
+
+/***********************************************************************
+*                         LOCAL VARIABLES                              *
+************************************************************************/
+
+static scope_stream_reader_t view;
+static int view_open;
+static char view_name[HAL_NAME_LEN + 1];
+static uint64_t win_first, win_count;	/* samples in the buffer */
+static double *lod_min, *lod_max;
+
+/***********************************************************************
+*                  LOCAL FUNCTION DEFINITIONS                          *
+************************************************************************/
+
+static void store_value(scope_data_t *d, hal_type_t type, double v)
+{
+    switch (type) {
+    case HAL_BIT:
+	d->d_u8 = v != 0.0;
+	break;
+    case HAL_FLOAT:
+	d->d_real = v;
+	break;
+    case HAL_S32:
+	d->d_s32 = v;
+	break;
+    case HAL_U32:
+	d->d_u32 = v;
+	break;
+    default:
+	break;
+    }
+}
+
+/* scale index whose units/div shows 'range' in 8 divisions, using the
+   same 1-2-5 sequence as the vertical scale slider */
+static int scale_index_for(scope_chan_t *chan, double range)
+{
+    static const double steps[3] = { 1.0, 2.0, 5.0 };
+    int index;
+
+    for (index = chan->min_index; index < chan->max_index; index++) {
+	int decade = (index >= 0) ? index / 3 : -((2 - index) / 3);
+	double scale = pow(10.0, decade) * steps[index - 3 * decade];
+	if (scale * 8.0 >= range) {
+	    break;
+	}
+    }
+    return index;
+}
+
+/* min and max of a channel over the whole file, from the index */
+static void chan_range(int chan, double *min, double *max)
+{
+    long n;
+
+    *min = INFINITY;
+    *max = -INFINITY;
+    for (n = 0; n < view.num_chunks; n++) {
+	scope_stream_chunk_t *c = &view.index[n].chunk;
+	if (c->min[chan] < *min) {
+	    *min = c->min[chan];
+	}
+	if (c->max[chan] > *max) {
+	    *max = c->max[chan];
+	}
+    }
+}
+
+/***********************************************************************
+*                        PUBLIC FUNCTIONS                              *
+************************************************************************/
+
+int stream_view_active(void)
+{
+    return view_open;
+}
+
+double stream_view_fraction(void)
+{
+    uint64_t total = view.end - view.first;
+
+    if (!view_open || total == 0) {
+	return 1.0;
+    }
+    return (double) win_count / total;
+}
+
+int open_stream_view(char *filename)
+{
+    const char *base;
+    int n, num_chans;
+
+    if (scope_stream_open(&view, filename) < 0) {
+	return -1;
+    }
+    if (view.end == view.first) {
+	/* no samples */
+	scope_stream_release(&view);
+	return -1;
+    }
+    lod_min = malloc(sizeof(double) * ctrl_shm->buf_len);
+    lod_max = malloc(sizeof(double) * ctrl_shm->buf_len);
+    if (lod_min == NULL || lod_max == NULL) {
+	scope_stream_release(&view);
+	return -1;
+    }
+    view_open = 1;
+    num_chans = view.hdr.num_chans;
+    /* replace whatever channels were set up with those in the file */
+    for (n = 0; n < 16; n++) {
+	set_channel_off(n + 1);
+	ctrl_usr->chan[n].data_source_type = -1;
+	ctrl_usr->chan[n].data_len = 0;
+	ctrl_usr->chan[n].name = NULL;
+    }
+    set_rec_len(16);
+    for (n = 0; n < num_chans; n++) {
+	scope_chan_t *chan = &(ctrl_usr->chan[n]);
+	double min, max;
+
+	set_channel_stream(n + 1, view.hdr.chan[n].type, view.hdr.chan[n].name);
+	set_active_channel(n + 1);
+	ctrl_usr->vert.data_offset[n] = n;
+	chan_range(n, &min, &max);
+	set_vert_scale(scale_index_for(chan, max - min));
+	if (chan->data_type != HAL_BIT) {
+	    set_vert_offset((min + max) / 2.0, 0);
+	}
+	set_vert_pos(0.5);
+    }
+    /* the file name stands in for the thread name */
+    base = strrchr(filename, '/');
+    snprintf(view_name, sizeof(view_name), "%s", base ? base + 1 : filename);
+    ctrl_usr->horiz.thread_name = view_name;
+    set_horiz_zoom(1);
+    set_horiz_pos(0.5);
+    return 0;
+}
+
+/* load the window selected by the horizontal sliders into the display
+   buffer, called whenever they change */
+void refresh_stream_view(void)
+{
+    scope_horiz_t *horiz = &(ctrl_usr->horiz);
+    uint64_t total, center;
+    int c, b, buckets, points, pairs, sample_len;
+    double period;
+
+    if (!view_open) {
+	return;
+    }
+    total = view.end - view.first;
+    win_count = total >> (2 * (horiz->zoom_setting - 1));
+    if (win_count < 16) {
+	win_count = total < 16 ? total : 16;
+    }
+    center = view.first + (uint64_t) (horiz->pos_setting * total);
+    win_first = center > view.first + win_count / 2 ? center - win_count / 2 : view.first;
+    if (win_first + win_count > view.end) {
+	win_first = view.end - win_count;
+    }
+    points = ctrl_shm->rec_len;
+    sample_len = ctrl_shm->sample_len;
+    /* more samples than points: min/max pairs, otherwise each sample
+       is repeated over the points it covers */
+    pairs = win_count > (uint64_t) points;
+    buckets = pairs ? points / 2 : points;
+    for (c = 0; c < (int) view.hdr.num_chans; c++) {
+	hal_type_t type = view.hdr.chan[c].type;
+	double last = 0.0;
+	if (scope_stream_lod(&view, c, win_first, win_count, buckets,
+		lod_min, lod_max) < 0) {
+	    memset(lod_min, 0, sizeof(double) * buckets);
+	    memset(lod_max, 0, sizeof(double) * buckets);
+	}
+	for (b = 0; b < buckets; b++) {
+	    /* a gap in the recording shows as a flat line */
+	    if (isnan(lod_min[b])) {
+		lod_min[b] = lod_max[b] = last;
+	    }
+	    last = lod_max[b];
+	    if (pairs) {
+		store_value(&ctrl_usr->disp_buf[(2 * b) * sample_len + c], type,
+		    lod_min[b]);
+		store_value(&ctrl_usr->disp_buf[(2 * b + 1) * sample_len + c],
+		    type, lod_max[b]);
+	    } else {
+		store_value(&ctrl_usr->disp_buf[b * sample_len + c], type,
+		    lod_min[b]);
+	    }
+	}
+    }
+    ctrl_usr->samples = pairs ? 2 * buckets : buckets;
+    /* the buffer covers the window, so each point stands for
+       win_count/samples real sample periods */
+    period = view.hdr.sample_period * win_count / ctrl_usr->samples;
+    horiz->thread_period_ns = period * 1e9;
+    if (horiz->thread_period_ns < 1) {
+	horiz->thread_period_ns = 1;
+    }
+    ctrl_shm->mult = 1;
+    /* cursor times count from the start of the file */
+    ctrl_shm->pre_trig = -(int) ((win_first - view.first) / (double) win_count
+	* ctrl_usr->samples);
+}
@@ -1038,6 +1038,13 @@ int rtapi_shmem_new(int key, int module_id, unsigned long int size)
     return shmem_id;
 }
 
+int rtapi_shmem_new_flags(int key, int module_id, unsigned long int size,
+    int flags)
+{
+    /* RTAI allocates the block itself, with no say in its pages */
+    return rtapi_shmem_new(key, module_id, size);
+}
+
 int rtapi_shmem_delete(int shmem_id, int module_id)
 {
     int retval;
@@ -1728,6 +1735,7 @@ EXPORT_SYMBOL(rtapi_task_resume);
 EXPORT_SYMBOL(rtapi_task_pause);
 EXPORT_SYMBOL(rtapi_task_self);
 EXPORT_SYMBOL(rtapi_shmem_new);
+EXPORT_SYMBOL(rtapi_shmem_new_flags);
 EXPORT_SYMBOL(rtapi_shmem_delete);
 EXPORT_SYMBOL(rtapi_shmem_getptr);
 EXPORT_SYMBOL(rtapi_sem_new);
@@ -534,6 +534,13 @@ static void check_memlock_limit(const char *where) {
     return;
 }
 
+int rtapi_shmem_new_flags(int key, int module_id, unsigned long int size,
+    int flags)
+{
+    /* RTAI allocates the block itself, with no say in its pages */
+    return rtapi_shmem_new(key, module_id, size);
+}
+
 int rtapi_shmem_delete(int shmem_id, int module_id)
 {
     int retval;
@@ -464,6 +464,17 @@ RTAPI_BEGIN_DECLS
     extern int rtapi_shmem_new(int key, int module_id,
 	unsigned long int size);
 
+/** 'rtapi_shmem_new_flags()' is 'rtapi_shmem_new()' with 'flags', which
+    only matter to the call that creates the block.  Where a flag cannot
+    be honoured the block is made as 'rtapi_shmem_new()' would make it.
+    With uspace realtime a block that already exists is mapped at the
+    size it has, which may be more than 'size'.
+*/
+#define RTAPI_SHMEM_HUGEPAGES 1	/* back the block with huge pages */
+
+    extern int rtapi_shmem_new_flags(int key, int module_id,
+	unsigned long int size, int flags);
+
 /** 'rtapi_shmem_delete()' frees the shared memory block associated
     with 'shmem_id'.  'module_id' is the ID of the calling module.
     Returns a status code.  Call only from within user or init/cleanup
@@ -52,7 +52,27 @@ typedef struct {
 
 static rtapi_shmem_handle shmem_array[MAX_SHM] = {{0},};
 
+static unsigned long shmem_hugepage_size(void)
+{
+  unsigned long kb = 0;
+  char line[128];
+  FILE *f = fopen("/proc/meminfo", "r");
+
+  if(f) {
+    while(fgets(line, sizeof(line), f))
+      if(sscanf(line, "Hugepagesize: %lu kB", &kb) == 1) break;
+    fclose(f);
+  }
+  return kb ? kb * 1024 : 2 * 1024 * 1024;
+}
+
 int rtapi_shmem_new(int key, int module_id, unsigned long int size)
+{
+  return rtapi_shmem_new_flags(key, module_id, size, 0);
+}
+
+int rtapi_shmem_new_flags(int key, int module_id, unsigned long int size,
+    int flags)
 {
 #ifdef RTAPI
   WITH_ROOT;
@@ -74,8 +94,28 @@ int rtapi_shmem_new(int key, int module_id, unsigned long int size)
   }
   shmem = &shmem_array[i];
 
-  /* now get shared memory block from OS */
-  shmem->id = shmget((key_t) key, (int) size, IPC_CREAT | 0600);
+  /* now get shared memory block from OS: open it at whatever size it
+     has if it exists, otherwise create it */
+  shmem->id = shmget((key_t) key, 0, 0600);
+#ifdef SHM_HUGETLB
+  if(shmem->id == -1 && errno == ENOENT
+      && (flags & RTAPI_SHMEM_HUGEPAGES)) {
+    unsigned long hsize = shmem_hugepage_size();
+    shmem->id = shmget((key_t) key, (size + hsize - 1) / hsize * hsize,
+        IPC_CREAT | IPC_EXCL | SHM_HUGETLB | 0600);
+    if(shmem->id == -1 && errno != EEXIST) {
+      rtapi_print_msg(RTAPI_MSG_WARN,
+          "rtapi_shmem_new: no huge pages for key 0x%08x, using normal pages: %s\n",
+          key, strerror(errno));
+      errno = ENOENT;
+    }
+  }
+#endif
+  if (shmem->id == -1 && errno == ENOENT)
+    shmem->id = shmget((key_t) key, size, IPC_CREAT | IPC_EXCL | 0600);
+  /* someone else created it in the meantime */
+  if (shmem->id == -1 && errno == EEXIST)
+    shmem->id = shmget((key_t) key, 0, 0600);
   if (shmem->id == -1) {
     rtapi_print_msg(RTAPI_MSG_ERR, "rtapi_shmem_new failed due to shmget(key=0x%08x): %s\n", key, strerror(errno));
     return -errno;
@@ -84,6 +124,17 @@ int rtapi_shmem_new(int key, int module_id, unsigned long int size)
   struct shmid_ds stat;
   int res = shmctl(shmem->id, IPC_STAT, &stat);
   if(res < 0) perror("shmctl IPC_STAT");
+  if(res == 0) {
+    /* whoever created the segment decided its size, the other users
+       must get at least what they asked for */
+    if(stat.shm_segsz < size) {
+      rtapi_print_msg(RTAPI_MSG_ERR,
+          "rtapi_shmem_new: segment key 0x%08x has %lu bytes, not %lu\n",
+          key, (unsigned long) stat.shm_segsz, size);
+      return -EINVAL;
+    }
+    size = stat.shm_segsz;
+  }
 
 #ifdef RTAPI
   /* ensure the segment is owned by user, not root */
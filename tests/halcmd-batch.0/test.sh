@@ -0,0 +1,19 @@
+#!/bin/sh
+$REALTIME start
+
+halcmd -B -f good.hal good2.hal
+echo "good: $?"
+halcmd gets ins
+halcmd gets spare
+halcmd getp and2.1.in1
+
+# nothing in a run with an error is applied
+halcmd -B -f bad.hal 2>/dev/null
+echo "bad: $?"
+halcmd gets d 2>/dev/null || echo "d not created"
+halcmd gets a-out
+halcmd -B -f bad2.hal 2>/dev/null
+echo "bad2: $?"
+halcmd gets p 2>/dev/null || echo "p not created"
+
+$REALTIME stop
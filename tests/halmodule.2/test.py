@@ -0,0 +1,56 @@
+#!/usr/bin/env linuxcnc-python
+import hal
+import array
+
+h = hal.component("x")
+try:
+    h.newpin("f", hal.HAL_FLOAT, hal.HAL_OUT)
+    h.newpin("s", hal.HAL_S32, hal.HAL_OUT)
+    h.newpin("u", hal.HAL_U32, hal.HAL_OUT)
+    h.newpin("b", hal.HAL_BIT, hal.HAL_OUT)
+    h.newpin("in", hal.HAL_FLOAT, hal.HAL_IN)
+    h.newparam("param", hal.HAL_FLOAT, hal.HAL_RW)
+    h.ready()
+
+    g = h.newgroup(["f", "s", "u", "b", "in", "param"])
+    print("len {}".format(len(g)))
+    print("names {}".format(" ".join(g.names)))
+
+    g.write([1.5, -3, 7, 1, 9.0, 2.25])
+    print("pins {} {} {} {} {} {}".format(h["f"], h["s"], h["u"], h["b"], h["in"], h["param"]))
+
+    v = g.read()
+    print("read {}".format(list(v)))
+    print("same view {}".format(v is g.read() and v is g.values))
+
+    h["f"] = 4.0
+    buf = array.array('d', [0.0] * 6)
+    g.read_into(buf)
+    print("read_into {}".format(list(buf)))
+
+    g.values[0] = -1.0
+    g.values[3] = 0.0
+    g.write()
+    print("write own {} {}".format(h["f"], h["b"]))
+
+    g.write(array.array('d', [0.5, 1, 2, 1, 5, 6]))
+    print("write buffer {} {} {}".format(h["f"], h["in"], h["param"]))
+
+    for bad in ([1, 2], array.array('f', [0.0] * 6), array.array('d', [0.0] * 2)):
+        try:
+            g.write(bad)
+            print("bad write ok")
+        except (TypeError, ValueError):
+            print("bad write fail")
+
+    try:
+        h.newgroup(["f", "not-found"])
+        print("newgroup not-found ok")
+    except AttributeError:
+        print("newgroup not-found fail")
+except:
+    import traceback
+    print("Exception: {}".format(traceback.format_exc()))
+    raise
+finally:
+    h.exit()
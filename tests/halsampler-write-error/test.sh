@@ -0,0 +1,17 @@
+#!/bin/sh
+$REALTIME start
+halcmd loadrt threads name1=thread period1=1000000
+halcmd loadrt sampler cfg=f depth=100
+halcmd addf sampler.0 thread
+halcmd start
+
+halsampler -n 10 > /dev/null
+echo "text: $?"
+halsampler -n 10 > /dev/full 2>/dev/null
+echo "text, disk full: $?"
+halsampler -b -n 10 > /dev/null
+echo "binary: $?"
+halsampler -b -n 10 > /dev/full 2>/dev/null
+echo "binary, disk full: $?"
+
+$REALTIME stop
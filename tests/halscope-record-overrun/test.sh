@@ -0,0 +1,15 @@
+#!/bin/sh
+$REALTIME start
+halcmd loadrt threads name1=fast period1=50000
+halcmd loadrt threadtest count=1
+halcmd net count threadtest.0.count
+halcmd addf threadtest.0.increment fast
+halcmd start
+
+halscope-record -t fast -N 64 -n 20000 -o record.hss sig:count 2> record.log
+echo "record: $?"
+
+$REALTIME stop
+
+halscope-record -d record.hss
+rm -f record.hss record.log
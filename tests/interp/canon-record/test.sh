@@ -0,0 +1,18 @@
+#!/bin/bash
+# Record the canonical calls of test.ngc with rs274 -R, replay the
+# recording through canterp, and check that the replay makes exactly the
+# same calls: the same printed canon, and a recording of the replay that
+# is the same bit for bit.  rs274 sets block delete before it starts
+# either program, so the recording of the replay has that one record (24
+# bytes) in front of the ones it replays.
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+rs274 -i test.ini -t test.tbl -g -R $TMP/direct.rec test.ngc > $TMP/direct.out || exit 1
+rs274 -i test.ini -t test.tbl -p ${LIBDIR}/libcanterp.so -g -R $TMP/replay.rec \
+    $TMP/direct.rec > $TMP/replay.out || exit 1
+
+diff -u $TMP/direct.out $TMP/replay.out || exit 1
+cmp <(head -c 16 $TMP/direct.rec) <(head -c 16 $TMP/replay.rec) || exit 1
+cmp <(tail -c +17 $TMP/direct.rec) <(tail -c +41 $TMP/replay.rec) || exit 1
+awk '{$1=""; print}' $TMP/replay.out | sed 's/-0\.0000/0.0000/g'
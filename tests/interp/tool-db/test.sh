@@ -0,0 +1,5 @@
+#!/bin/bash
+rm -f test.db test.db-wal test.db-shm
+linuxcnc-python -c 'import sqlite3; sqlite3.connect("test.db").executescript(open("test.sql").read())' || exit 1
+rs274 -g test.ngc -t test.db | awk '{$1=""; print}'
+exit ${PIPESTATUS[0]}
@@ -0,0 +1,12 @@
+#!/bin/bash
+# Each synch appends the parameters that changed to the journal, and
+# the parameter file is only rewritten, with the journal folded in and
+# removed, when the interpreter exits.
+export PYTHONUNBUFFERED=1
+rm -f test.var test.var.bak test.var.journal
+printf '5220\t1.000000\n5221\t1.000000\n5222\t2.000000\n' > test.var
+rs274 -i test.ini -v test.var -n 0 -g test.ngc 2>&1
+test ${PIPESTATUS[0]} = 0 || exit 1
+test ! -e test.var.journal || { echo "journal not removed"; exit 1; }
+grep -q '^5221	3.250000$' test.var || { echo "5221 not saved"; exit 1; }
+grep -q '^5222	4.500000$' test.var || { echo "5222 not saved"; exit 1; }
@@ -0,0 +1,12 @@
+#!/bin/bash
+# A journal with one complete batch and one that was cut short by a
+# crash.  Only the complete batch is applied, and the journal is folded
+# into the parameter file when the interpreter exits.
+rm -f test.var test.var.bak test.var.journal
+printf '5221\t1.500000\n4000\t7.000000\n.\n5222\t2.500000\n' > test.var.journal
+rs274 -v test.var -g test.ngc | awk '{$1=""; print}'
+test ${PIPESTATUS[0]} = 0 || exit 1
+test ! -e test.var.journal || { echo "journal not removed"; exit 1; }
+grep -q '^5221	1.500000$' test.var || { echo "5221 not saved"; exit 1; }
+grep -q '^4000	7.000000$' test.var || { echo "4000 not saved"; exit 1; }
+grep -q '^5222	0.000000$' test.var || { echo "5222 changed"; exit 1; }
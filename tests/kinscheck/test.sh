@@ -0,0 +1,5 @@
+#!/bin/bash
+for ini in good.ini tight.ini; do
+    kinscheck -i $ini -j 2 square.canon 2>&1
+    echo "exit $?"
+done
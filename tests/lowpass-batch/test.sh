@@ -0,0 +1,7 @@
+#!/bin/bash
+${SUDO} halcompile --install batchlowpass.comp || exit 1
+halrun -f per-instance.hal > per-instance.out || exit 1
+halrun -f batch.hal > batch.out || exit 1
+diff -u per-instance.out batch.out 1>&2 || exit 1
+cat batch.out
+rm -f per-instance.out batch.out
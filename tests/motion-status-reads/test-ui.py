@@ -0,0 +1,37 @@
+#!/usr/bin/env linuxcnc-python
+
+import linuxcnc
+import time
+import sys
+
+retval = 0
+
+c = linuxcnc.command()
+s = linuxcnc.stat()
+
+c.state(linuxcnc.STATE_ESTOP_RESET)
+c.state(linuxcnc.STATE_ON)
+c.wait_complete()
+
+s.poll()
+reads = s.status_reads
+retries = s.status_retries
+
+# task reads the motion status every cycle
+time.sleep(1)
+s.poll()
+
+if s.status_reads <= reads:
+    print("status_reads went from %d to %d" % (reads, s.status_reads))
+    retval = 1
+if s.status_retries < retries:
+    print("status_retries went down from %d to %d" % (retries, s.status_retries))
+    retval = 1
+if s.status_failures != 0:
+    print("%d status reads failed" % s.status_failures)
+    retval = 1
+
+if retval == 0:
+    print("Everything ok!")
+
+sys.exit(retval)
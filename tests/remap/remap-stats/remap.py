@@ -0,0 +1,13 @@
+import interpreter
+
+def body_410(self, **words):
+    # Replace this handler in the module.  The interpreter found it when
+    # it was first looked up and goes on calling it, until the lookups
+    # start afresh
+    globals()['body_410'] = replaced_410
+    self.execute("(body_410)")
+    return interpreter.INTERP_OK
+
+def replaced_410(self, **words):
+    self.execute("(replaced_410)")
+    return interpreter.INTERP_OK
@@ -0,0 +1,80 @@
+#!/usr/bin/env linuxcnc-python
+
+import linuxcnc
+import sqlite3
+import time
+import sys
+
+inifile = linuxcnc.ini(sys.argv[sys.argv.index('-ini') + 1])
+tool_table = inifile.find("EMCIO", "TOOL_TABLE")
+
+c = linuxcnc.command()
+s = linuxcnc.stat()
+e = linuxcnc.error_channel()
+
+c.state(linuxcnc.STATE_ESTOP_RESET)
+c.state(linuxcnc.STATE_ON)
+c.mode(linuxcnc.MODE_MDI)
+c.wait_complete()
+
+
+def mdi(command):
+    print("running '%s'" % command)
+    c.mdi(command)
+    c.wait_complete()
+    error = e.poll()
+    if error:
+        print("error: %s" % error[1])
+        sys.exit(1)
+
+
+def check_db_writes(command, toolno, column, value):
+    db = sqlite3.connect(tool_table)
+    db.execute("DELETE FROM writes")
+    db.commit()
+    mdi(command)
+
+    # iocontrol saves the table after it has acted on the command
+    start = time.time()
+    while time.time() - start < 5:
+        got = db.execute("SELECT %s FROM tools WHERE toolno = ?" % column,
+                (toolno,)).fetchone()[0]
+        if abs(got - value) < 1e-6:
+            break
+        time.sleep(0.1)
+    else:
+        print("'%s': tool %d %s is %f, not %f" % (command, toolno, column, got, value))
+        sys.exit(1)
+
+    writes = [row[0] for row in db.execute("SELECT toolno FROM writes")]
+    if writes != [toolno]:
+        print("'%s' wrote tools %s, expected only %d" % (command, writes, toolno))
+        sys.exit(1)
+    print("'%s' wrote only tool %d" % (command, toolno))
+    db.close()
+
+
+def wait_for_text_save(toolno, text):
+    start = time.time()
+    while time.time() - start < 5:
+        for line in open(tool_table):
+            if line.split()[0] == "T%d" % toolno and text in line:
+                return
+        time.sleep(0.1)
+    print("tool %d never got %s in %s" % (toolno, text, tool_table))
+    sys.exit(1)
+
+
+mdi("g20")
+if tool_table.endswith(".db"):
+    check_db_writes("g10 l1 p7 z2.5", 7, "z_offset", 2.5)
+    check_db_writes("g10 l1 p1200 z1.5", 1200, "z_offset", 1.5)
+    # tool 5 goes from its pocket to the empty spindle
+    check_db_writes("t5 m6", 5, "pocket", 0)
+else:
+    # the whole file is rewritten, test.sh checks the rest of it
+    mdi("g10 l1 p7 z2.5")
+    wait_for_text_save(7, "Z+2.500000")
+
+print("Everything ok!")
+sys.exit(0)
@@ -0,0 +1,22 @@
+#!/bin/bash
+rm -f test.db test.db-wal test.db-shm sim.var*
+linuxcnc-python -c 'import sqlite3; sqlite3.connect("test.db").executescript(open("test.sql").read())' || exit 1
+linuxcnc -r db.ini || exit 1
+
+# the same tools in a text file, in the format saveToolTable() writes
+awk 'BEGIN { for (i = 1; i <= 1500; i++)
+    printf "T%d P%d D%f Z%+f ;tool %d\n", i, i + 10, 0.25, i / 1000.0, i }' > text.tbl.orig
+cp text.tbl.orig text.tbl
+linuxcnc -r text.ini || exit 1
+
+# every tool past the first 1000 has to survive the rewrite, and only
+# tool 7 may have changed
+diff text.tbl.orig text.tbl > text.diff
+if [ "$(grep -c '^[<>]' text.diff)" != 2 ] ||
+    ! grep -q '^> T7 P17 D0.250000 Z+2.500000 ;tool 7$' text.diff; then
+    echo "text tool table did not round-trip:"
+    cat text.diff
+    exit 1
+fi
+rm -f text.tbl.orig text.tbl text.diff
+exit 0
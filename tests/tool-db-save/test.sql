@@ -0,0 +1,34 @@
+-- 1500 tools, more than the 1000 the tool table array holds; tool n has
+-- a z offset of n/1000 and sits in pocket n+10
+CREATE TABLE tools (
+    toolno INTEGER PRIMARY KEY,
+    pocket INTEGER,
+    diameter REAL DEFAULT (0.0),
+    backangle REAL DEFAULT (0.0),
+    frontangle REAL DEFAULT (0.0),
+    orientation INTEGER DEFAULT (0.0),
+    comment TEXT DEFAULT (NULL),
+    x_offset REAL DEFAULT (0.0),
+    y_offset REAL DEFAULT (0.0),
+    z_offset REAL DEFAULT (0.0),
+    a_offset REAL DEFAULT (0.0),
+    b_offset REAL DEFAULT (0.0),
+    c_offset REAL DEFAULT (0.0),
+    u_offset REAL DEFAULT (0.0),
+    v_offset REAL DEFAULT (0.0),
+    w_offset REAL DEFAULT (0.0)
+);
+WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 1500)
+INSERT INTO tools (toolno, pocket, diameter, z_offset, comment)
+    SELECT i, i + 10, 0.25, i / 1000.0, 'tool ' || i FROM n;
+
+-- every tool written, to tell how many rows a save touched
+CREATE TABLE writes (toolno INTEGER);
+CREATE TRIGGER tool_written AFTER INSERT ON tools
+BEGIN
+    INSERT INTO writes VALUES (new.toolno);
+END;
+CREATE TRIGGER tool_rewritten AFTER UPDATE ON tools
+BEGIN
+    INSERT INTO writes VALUES (new.toolno);
+END;
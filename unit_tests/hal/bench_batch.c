@@ -0,0 +1,100 @@
+/* Benchmark of a component's batch function against its per-instance
+ * functions.
+ *
+ * Built once per component, from the C file halcompile --batch makes of
+ * it, which bench_comp.c includes so the instance count can be set.  The
+ * per-instance functions are called the way thread_task() calls the
+ * functions in a thread, through the function pointer and with the
+ * runtime and maxtime bookkeeping after each one, and then the batch
+ * function is called once per period the same way.  Prints the cost
+ * per period of both.
+ *
+ * usage: bench_batch_<comp> [instances] [periods]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rtapi.h"
+#include "hal.h"
+#include "hal_funct_stub.h"
+
+extern int rtapi_app_main(void);
+extern void bench_set_count(int n);
+
+#define BENCH_DEFAULT_INSTANCES 12
+#define BENCH_DEFAULT_PERIODS 200000
+#define BENCH_PERIOD 1000000
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* run the functions in a thread for 'periods' periods, as thread_task()
+   does, and return the time per period in ns */
+static double run_thread(stub_funct_t **functs, int n, int periods)
+{
+    hal_s32_t runtime, maxtime = 0;
+    long long int start_time, end_time;
+    double t;
+    int p, i;
+
+    t = now();
+    for (p = 0; p < periods; p++) {
+        start_time = rtapi_get_clocks();
+        for (i = 0; i < n; i++) {
+            functs[i]->funct(functs[i]->arg, BENCH_PERIOD);
+            end_time = rtapi_get_clocks();
+            runtime = (hal_s32_t)(end_time - start_time);
+            if (runtime > maxtime) maxtime = runtime;
+            start_time = end_time;
+        }
+    }
+    return (now() - t) * 1e9 / periods;
+}
+
+int main(int argc, char **argv)
+{
+    int instances = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_INSTANCES;
+    int periods = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_PERIODS;
+    stub_funct_t *single[STUB_MAX_FUNCTS], *batch[STUB_MAX_FUNCTS];
+    int nsingle = 0, nbatch = 0, i;
+    double t_single, t_batch;
+
+    bench_set_count(instances);
+    if (rtapi_app_main() != 0) {
+        fprintf(stderr, "rtapi_app_main failed\n");
+        return 1;
+    }
+    for (i = 0; i < stub_nfuncts; i++) {
+        if (strstr(stub_functs[i].name, ".batch")) {
+            batch[nbatch++] = &stub_functs[i];
+        } else {
+            single[nsingle++] = &stub_functs[i];
+        }
+    }
+    if (nbatch == 0) {
+        fprintf(stderr, "no batch function exported\n");
+        return 1;
+    }
+
+    /* inputs away from the defaults, so no component takes a shortcut */
+    for (i = 0; i < stub_npins; i++) {
+        if (stub_pins[i].dir == HAL_IN && stub_pins[i].type == HAL_FLOAT) {
+            *(hal_float_t *) stub_pins[i].ptr = (i % 10) * 0.1;
+        }
+    }
+
+    run_thread(single, nsingle, periods / 10);
+    t_single = run_thread(single, nsingle, periods);
+    t_batch = run_thread(batch, nbatch, periods);
+
+    printf("%s: %d instances, %d periods\n", COMP_SOURCE, instances, periods);
+    printf("  per-instance: %4d functs %10.1f ns/period\n", nsingle, t_single);
+    printf("  batch:        %4d functs %10.1f ns/period (%.2fx)\n",
+        nbatch, t_batch, t_batch > 0 ? t_single / t_batch : 0);
+    return 0;
+}
@@ -0,0 +1,9 @@
+/* The component under test for bench_batch.c, from halcompile --batch */
+#include COMP_SOURCE
+
+/* the component's pins and variables are macros from here on */
+#undef count
+void bench_set_count(int n)
+{
+    count = n;
+}
@@ -0,0 +1,118 @@
+/* Minimal HAL for running a halcompile component outside of rtapi_app.
+ *
+ * Pins are plain heap variables and exported functions are only
+ * recorded, so a benchmark can call them the way thread_task() does.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include "rtapi.h"
+#include "hal.h"
+#include "hal_funct_stub.h"
+
+stub_funct_t stub_functs[STUB_MAX_FUNCTS];
+int stub_nfuncts;
+stub_pin_t stub_pins[STUB_MAX_PINS];
+int stub_npins;
+
+int hal_init(const char *name) { return 1; }
+int hal_ready(int comp_id) { return 0; }
+int hal_exit(int comp_id) { return 0; }
+int hal_set_constructor(int comp_id, constructor make) { return 0; }
+
+void *hal_malloc(long int size)
+{
+    return calloc(1, size);
+}
+
+int hal_export_funct(const char *name, void (*funct) (void *, long),
+    void *arg, int uses_fp, int reentrant, int comp_id)
+{
+    stub_funct_t *f;
+
+    if (stub_nfuncts == STUB_MAX_FUNCTS) return -ENOMEM;
+    f = &stub_functs[stub_nfuncts++];
+    snprintf(f->name, sizeof(f->name), "%s", name);
+    f->funct = funct;
+    f->arg = arg;
+    return 0;
+}
+
+static int new_pin(hal_type_t type, hal_pin_dir_t dir, void **data_ptr_addr,
+    size_t size)
+{
+    *data_ptr_addr = calloc(1, size);
+    if (!*data_ptr_addr) return -ENOMEM;
+    if (stub_npins < STUB_MAX_PINS) {
+        stub_pins[stub_npins].type = type;
+        stub_pins[stub_npins].dir = dir;
+        stub_pins[stub_npins].ptr = *data_ptr_addr;
+        stub_npins++;
+    }
+    return 0;
+}
+
+#define PIN_NEWF(type, TYPE) \
+int hal_pin_##type##_newf(hal_pin_dir_t dir, \
+    hal_##type##_t ** data_ptr_addr, int comp_id, const char *fmt, ...) \
+{ \
+    return new_pin(TYPE, dir, (void **)data_ptr_addr, sizeof(hal_##type##_t)); \
+}
+
+#define PARAM_NEWF(type) \
+int hal_param_##type##_newf(hal_param_dir_t dir, \
+    hal_##type##_t * data_addr, int comp_id, const char *fmt, ...) \
+{ \
+    return 0; \
+}
+
+PIN_NEWF(bit, HAL_BIT)
+PIN_NEWF(float, HAL_FLOAT)
+PIN_NEWF(u32, HAL_U32)
+PIN_NEWF(s32, HAL_S32)
+PARAM_NEWF(bit)
+PARAM_NEWF(float)
+PARAM_NEWF(u32)
+PARAM_NEWF(s32)
+
+long long int rtapi_get_clocks(void)
+{
+#if defined(__i386) || defined(__amd64)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+void rtapi_print(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
+
+void rtapi_print_msg(msg_level_t level, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+int rtapi_snprintf(char *buf, unsigned long size, const char *fmt, ...)
+{
+    va_list args;
+    int r;
+
+    va_start(args, fmt);
+    r = vsnprintf(buf, size, fmt, args);
+    va_end(args);
+    return r;
+}
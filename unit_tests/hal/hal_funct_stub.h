@@ -0,0 +1,27 @@
+#ifndef HAL_FUNCT_STUB_H
+#define HAL_FUNCT_STUB_H
+
+#include "hal.h"
+
+#define STUB_MAX_FUNCTS 256
+#define STUB_MAX_PINS 4096
+
+typedef struct {
+    char name[HAL_NAME_LEN + 1];
+    void (*funct) (void *, long);
+    void *arg;
+} stub_funct_t;
+
+typedef struct {
+    hal_type_t type;
+    hal_pin_dir_t dir;
+    void *ptr;
+} stub_pin_t;
+
+/* everything the component exported, in order */
+extern stub_funct_t stub_functs[STUB_MAX_FUNCTS];
+extern int stub_nfuncts;
+extern stub_pin_t stub_pins[STUB_MAX_PINS];
+extern int stub_npins;
+
+#endif
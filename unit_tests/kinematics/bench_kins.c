@@ -0,0 +1,194 @@
+/* Benchmark of the batch kinematics against the single pose functions.
+ *
+ * Built once per kinematics module.  A toolpath of closely spaced poses
+ * is run through kinematicsForward()/kinematicsInverse() pose by pose,
+ * each pose starting from the previous solution the way motion calls
+ * them, and then through kinematicsForwardBatch()/
+ * kinematicsInverseBatch().  Prints the cost per pose of both and fails
+ * if the results differ.
+ *
+ * usage: bench_<kins> [poses]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "rtapi.h"
+#include "motion.h"
+#include "kinematics.h"
+
+extern int rtapi_app_main(void);
+
+#define BENCH_DEFAULT_POSES 20000
+#define BENCH_TOLERANCE 1e-6
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double *column(int n)
+{
+    double *p = calloc(n, sizeof(double));
+    if (!p) {
+        perror("calloc");
+        exit(1);
+    }
+    return p;
+}
+
+static double max_diff(double **a, double **b, int columns, int n)
+{
+    double d = 0;
+    int c, i;
+
+    for (c = 0; c < columns; c++) {
+        if (!a[c] || !b[c]) continue;
+        for (i = 0; i < n; i++) {
+            if (fabs(a[c][i] - b[c][i]) > d) d = fabs(a[c][i] - b[c][i]);
+        }
+    }
+    return d;
+}
+
+#ifndef BENCH_JOINT_PATH
+/* a slow helix with a little wobble on the rotary axes: close to what
+   preview and soft limit checking evaluate */
+static void make_world_path(KINEMATICS_BATCH *b)
+{
+    int i;
+
+    for (i = 0; i < b->n; i++) {
+        double t = (double)i / b->n;
+        b->world[0][i] = 2.0 * cos(20 * M_PI * t);
+        b->world[1][i] = 2.0 * sin(20 * M_PI * t);
+        b->world[2][i] = 20.0 + t;
+        b->world[3][i] = 5.0 * sin(6 * M_PI * t);
+        b->world[4][i] = 5.0 * cos(6 * M_PI * t);
+        b->world[5][i] = 10.0 * t;
+    }
+}
+#else
+static void make_joint_path(KINEMATICS_BATCH *b)
+{
+    int i, j;
+
+    for (i = 0; i < b->n; i++) {
+        double t = (double)i / b->n;
+        for (j = 0; j < 6; j++) {
+            b->joint[j][i] = 10.0 + 5.0 * j + 20.0 * sin(2 * M_PI * (t + 0.1 * j));
+        }
+    }
+}
+#endif
+
+/* a batch that shares the input columns of path and has its own output
+   columns, seeded with the first pose of path */
+static void make_batch(KINEMATICS_BATCH *b, KINEMATICS_BATCH *path,
+                       int inverse)
+{
+    int c;
+
+    *b = *path;
+    for (c = 0; c < 6; c++) {
+        if (inverse) {
+            b->joint[c] = column(b->n);
+            b->joint[c][0] = path->joint[c][0];
+        } else {
+            b->world[c] = column(b->n);
+            b->world[c][0] = path->world[c][0];
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    KINEMATICS_BATCH path, single, batch;
+    KINEMATICS_FORWARD_FLAGS fflags = 0;
+    KINEMATICS_INVERSE_FLAGS iflags = 0;
+    double joint[EMCMOT_MAX_JOINTS] = {0};
+    EmcPose pos = {{0, 0, 0}, 0, 0, 0, 0, 0, 0};
+    double t0, t_single, t_batch, d;
+    int n = BENCH_DEFAULT_POSES;
+    int i, c, failed = 0;
+
+    if (argc > 1) n = atoi(argv[1]);
+    if (n <= 0) {
+        fprintf(stderr, "usage: %s [poses]\n", argv[0]);
+        return 1;
+    }
+    if (rtapi_app_main() != 0) {
+        fprintf(stderr, "rtapi_app_main failed\n");
+        return 1;
+    }
+
+    path.n = n;
+    path.status = NULL;
+    for (c = 0; c < KINEMATICS_BATCH_AXES; c++) {
+        path.world[c] = c < 6 ? column(n) : NULL;
+    }
+    for (c = 0; c < KINEMATICS_BATCH_MAX_JOINTS; c++) {
+        path.joint[c] = c < 6 ? column(n) : NULL;
+    }
+
+    /* reference path in both spaces */
+#ifdef BENCH_JOINT_PATH
+    make_joint_path(&path);
+    kinematicsForwardBatchLoop(kinematicsForward, &path, &fflags, &iflags);
+#else
+    make_world_path(&path);
+    kinematicsInverseBatchLoop(kinematicsInverse, &path, &iflags, &fflags);
+#endif
+
+    /* inverse */
+    make_batch(&single, &path, 1);
+    make_batch(&batch, &path, 1);
+
+    t0 = now();
+    kinematicsBatchGetJoints(&single, 0, joint);
+    for (i = 0; i < n; i++) {
+        kinematicsBatchGetPose(&single, i, &pos);
+        if (kinematicsInverse(&pos, joint, &iflags, &fflags)) failed++;
+        kinematicsBatchSetJoints(&single, i, joint);
+    }
+    t_single = now() - t0;
+
+    t0 = now();
+    failed += kinematicsInverseBatch(&batch, &iflags, &fflags);
+    t_batch = now() - t0;
+
+    d = max_diff(single.joint, batch.joint, 6, n);
+    printf("inverse: single %8.1f ns/pose  batch %8.1f ns/pose  max diff %g\n",
+           t_single / n * 1e9, t_batch / n * 1e9, d);
+    if (d > BENCH_TOLERANCE) failed++;
+
+    /* forward */
+    make_batch(&single, &path, 0);
+    make_batch(&batch, &path, 0);
+
+    t0 = now();
+    kinematicsBatchGetPose(&single, 0, &pos);
+    for (i = 0; i < n; i++) {
+        kinematicsBatchGetJoints(&single, i, joint);
+        if (kinematicsForward(joint, &pos, &fflags, &iflags)) failed++;
+        kinematicsBatchSetPose(&single, i, &pos);
+    }
+    t_single = now() - t0;
+
+    t0 = now();
+    failed += kinematicsForwardBatch(&batch, &fflags, &iflags);
+    t_batch = now() - t0;
+
+    d = max_diff(single.world, batch.world, 6, n);
+    printf("forward: single %8.1f ns/pose  batch %8.1f ns/pose  max diff %g\n",
+           t_single / n * 1e9, t_batch / n * 1e9, d);
+    if (d > BENCH_TOLERANCE) failed++;
+
+    if (failed) {
+        printf("%d failures\n", failed);
+        return 1;
+    }
+    return 0;
+}
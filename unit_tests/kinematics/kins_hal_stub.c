@@ -0,0 +1,70 @@
+/* Minimal HAL for running a kinematics module outside of rtapi_app.
+ *
+ * The kinematics modules create their pins and parameters in
+ * rtapi_app_main(); here the pins and parameters are plain heap
+ * variables so the module can be linked straight into a test or
+ * benchmark executable.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include "rtapi.h"
+#include "hal.h"
+
+int hal_init(const char *name) { return 1; }
+int hal_ready(int comp_id) { return 0; }
+int hal_exit(int comp_id) { return 0; }
+
+void *hal_malloc(long int size)
+{
+    return calloc(1, size);
+}
+
+int hal_export_vtable(const char *name, int version, void *vtable, int comp_id)
+{
+    return 1;
+}
+
+int hal_remove_vtable(int vtable_id) { return 0; }
+
+#define PIN_NEWF(type) \
+int hal_pin_##type##_newf(hal_pin_dir_t dir, \
+    hal_##type##_t ** data_ptr_addr, int comp_id, const char *fmt, ...) \
+{ \
+    *data_ptr_addr = calloc(1, sizeof(hal_##type##_t)); \
+    return *data_ptr_addr ? 0 : -ENOMEM; \
+}
+
+#define PARAM_NEWF(type) \
+int hal_param_##type##_newf(hal_param_dir_t dir, \
+    hal_##type##_t * data_addr, int comp_id, const char *fmt, ...) \
+{ \
+    return 0; \
+}
+
+PIN_NEWF(bit)
+PIN_NEWF(float)
+PIN_NEWF(u32)
+PIN_NEWF(s32)
+PARAM_NEWF(bit)
+PARAM_NEWF(float)
+PARAM_NEWF(u32)
+PARAM_NEWF(s32)
+
+void rtapi_print(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
+
+void rtapi_print_msg(msg_level_t level, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
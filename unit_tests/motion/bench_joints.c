@@ -0,0 +1,226 @@
+/* Benchmark of the per-period joint passes of the servo thread against
+ * the layout of the joint data.
+ *
+ * One period walks the joints once per pass the way process_inputs(),
+ * check_for_faults(), handle_jjogwheels(), get_pos_cmds(),
+ * compute_screw_comp() and output_to_hal() in control.c do, touching
+ * the same emcmot_joint_t fields.  Before each period a buffer larger
+ * than the caches is written, as the rest of the machine does to motion
+ * between two periods, so the periods start cold the way they do in a
+ * running system.  The passes are timed on two layouts:
+ *
+ *   split   - the joint array and the joint_comp array, as motion uses
+ *   inline  - each compensation table right after its joint, which is
+ *             where it was when it was a member of emcmot_joint_t
+ *
+ * Prints the mean and worst time per period of each.
+ *
+ * usage: bench_joints [joints [periods [cache_kb]]]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "rtapi.h"
+#include "motion.h"
+
+#define BENCH_DEFAULT_JOINTS 9
+#define BENCH_DEFAULT_PERIODS 5000
+#define BENCH_DEFAULT_CACHE_KB (4 * 1024)
+
+typedef struct {
+    emcmot_joint_t joint;
+    emcmot_comp_t comp;
+} inline_joint_t;
+
+/* stands in for the joint HAL pins */
+static double motor_pos_fb_pin[EMCMOT_MAX_JOINTS];
+static double motor_pos_cmd_pin[EMCMOT_MAX_JOINTS];
+static double out_pin[EMCMOT_MAX_JOINTS][8];
+static int jog_counts_pin[EMCMOT_MAX_JOINTS];
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void init_joint(emcmot_joint_t *joint, emcmot_comp_t *comp, int n)
+{
+    int i;
+
+    memset(joint, 0, sizeof(*joint));
+    joint->max_pos_limit = 1000.0;
+    joint->min_pos_limit = -1000.0;
+    joint->vel_limit = 100.0;
+    joint->acc_limit = 1000.0;
+    joint->min_ferror = 0.01;
+    joint->max_ferror = 1.0;
+    joint->big_vel = 10.0;
+    joint->free_tp.max_vel = 100.0;
+    joint->free_tp.max_acc = 1000.0;
+    joint->pos_cmd = n;
+    /* a table with a few hundred entries, as screw comp files have */
+    memset(comp, 0, sizeof(*comp));
+    comp->entries = EMCMOT_COMP_SIZE;
+    for (i = 0; i < EMCMOT_COMP_SIZE + 2; i++) {
+        comp->array[i].nominal = -1000.0 + i * 2000.0 / (EMCMOT_COMP_SIZE + 1);
+        comp->array[i].fwd_trim = 0.001 * sin(i);
+        comp->array[i].rev_trim = 0.001 * cos(i);
+    }
+    comp->entry = &comp->array[EMCMOT_COMP_SIZE / 2];
+}
+
+static void period(emcmot_joint_t **joint, emcmot_comp_t **comp, int joints,
+    int p)
+{
+    int n;
+    double dt = 0.001;
+
+    /* process_inputs() */
+    for (n = 0; n < joints; n++) {
+        emcmot_joint_t *j = joint[n];
+        j->motor_pos_fb = motor_pos_fb_pin[n];
+        j->pos_fb = j->motor_pos_fb - (j->backlash_filt + j->motor_offset);
+        j->ferror = j->pos_cmd - j->pos_fb;
+        j->ferror_limit = j->max_ferror * fabs(j->vel_cmd) / j->vel_limit;
+        if (j->ferror_limit < j->min_ferror) {
+            j->ferror_limit = j->min_ferror;
+        }
+        if (fabs(j->ferror) > j->ferror_high_mark) {
+            j->ferror_high_mark = fabs(j->ferror);
+        }
+        if (fabs(j->ferror) > j->ferror_limit) {
+            j->flag |= EMCMOT_JOINT_FERROR_BIT;
+        }
+    }
+    /* check_for_faults() */
+    for (n = 0; n < joints; n++) {
+        emcmot_joint_t *j = joint[n];
+        if (j->on_pos_limit || j->on_neg_limit
+            || j->pos_cmd > j->max_pos_limit
+            || j->pos_cmd < j->min_pos_limit) {
+            j->flag |= EMCMOT_JOINT_ERROR_BIT;
+        }
+    }
+    /* handle_jjogwheels() */
+    for (n = 0; n < joints; n++) {
+        emcmot_joint_t *j = joint[n];
+        int delta = jog_counts_pin[n] - j->old_jjog_counts;
+        j->old_jjog_counts = jog_counts_pin[n];
+        if (delta && !j->kb_jjog_active) {
+            j->wheel_jjog_active = 1;
+        }
+    }
+    /* get_pos_cmds(), coordinated mode: cubic interpolation */
+    for (n = 0; n < joints; n++) {
+        emcmot_joint_t *j = joint[n];
+        CUBIC_STRUCT *c = &j->cubic;
+        double old_vel = j->vel_cmd;
+        c->interpolationTime += c->segmentTime / 10.0;
+        j->coarse_pos = c->x0 + c->interpolationTime * (c->x1 - c->x0);
+        j->pos_cmd = j->coarse_pos + 1e-6 * ((p + n) & 7);
+        j->vel_cmd = (j->pos_cmd - j->coarse_pos) / dt;
+        j->acc_cmd = (j->vel_cmd - old_vel) / dt;
+        if (fabs(j->vel_cmd) > j->big_vel) {
+            j->vel_cmd = j->big_vel;
+        }
+    }
+    /* compute_screw_comp() */
+    for (n = 0; n < joints; n++) {
+        emcmot_joint_t *j = joint[n];
+        emcmot_comp_entry_t *e;
+        while (j->pos_cmd < comp[n]->entry->nominal) {
+            comp[n]->entry--;
+        }
+        while (j->pos_cmd >= (comp[n]->entry + 1)->nominal) {
+            comp[n]->entry++;
+        }
+        e = comp[n]->entry;
+        j->backlash_corr = j->vel_cmd > 0.0 ? e->fwd_trim : e->rev_trim;
+        j->backlash_vel = (j->backlash_corr - j->backlash_filt) / dt;
+        j->backlash_filt = j->backlash_corr;
+        j->motor_pos_cmd = j->pos_cmd + j->backlash_filt + j->motor_offset;
+    }
+    /* output_to_hal() */
+    for (n = 0; n < joints; n++) {
+        emcmot_joint_t *j = joint[n];
+        motor_pos_cmd_pin[n] = j->motor_pos_cmd;
+        out_pin[n][0] = j->pos_cmd;
+        out_pin[n][1] = j->pos_fb;
+        out_pin[n][2] = j->vel_cmd;
+        out_pin[n][3] = j->acc_cmd;
+        out_pin[n][4] = j->ferror;
+        out_pin[n][5] = j->ferror_limit;
+        out_pin[n][6] = j->backlash_filt;
+        out_pin[n][7] = j->kb_jjog_active + j->wheel_jjog_active
+            + (j->flag & EMCMOT_JOINT_ERROR_BIT ? 1 : 0);
+    }
+}
+
+static void run(const char *name, emcmot_joint_t **joint,
+    emcmot_comp_t **comp, int joints, int periods, char *cache, size_t cache_size)
+{
+    double t, sum = 0, worst = 0;
+    int p;
+
+    for (p = 0; p < periods; p++) {
+        memset(cache, p, cache_size);
+        motor_pos_fb_pin[p % joints] += 1e-6;
+        jog_counts_pin[p % joints] = p >> 10;
+        t = now();
+        period(joint, comp, joints, p);
+        t = now() - t;
+        sum += t;
+        if (t > worst) {
+            worst = t;
+        }
+    }
+    printf("%-8s %8.0f ns mean %8.0f ns worst per period\n", name,
+        sum / periods * 1e9, worst * 1e9);
+}
+
+int main(int argc, char **argv)
+{
+    int joints = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_JOINTS;
+    int periods = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_PERIODS;
+    size_t cache_size = (argc > 3 ? atoi(argv[3]) : BENCH_DEFAULT_CACHE_KB)
+        * (size_t)1024;
+    emcmot_joint_t *joint_array, *joint[EMCMOT_MAX_JOINTS];
+    emcmot_comp_t *comp_array, *comp[EMCMOT_MAX_JOINTS];
+    inline_joint_t *inline_array;
+    char *cache;
+    int n;
+
+    if (joints < 1 || joints > EMCMOT_MAX_JOINTS || periods < 1) {
+        fprintf(stderr, "usage: %s [joints [periods [cache_kb]]]\n", argv[0]);
+        return 1;
+    }
+    joint_array = aligned_alloc(64, sizeof(emcmot_joint_t) * EMCMOT_MAX_JOINTS);
+    comp_array = aligned_alloc(64, sizeof(emcmot_comp_t) * EMCMOT_MAX_JOINTS);
+    inline_array = aligned_alloc(64, sizeof(inline_joint_t) * EMCMOT_MAX_JOINTS);
+    cache = malloc(cache_size);
+    if (!joint_array || !comp_array || !inline_array || !cache) {
+        perror("malloc");
+        return 1;
+    }
+    printf("%d joints, emcmot_joint_t %zu bytes, emcmot_comp_t %zu bytes\n",
+        joints, sizeof(emcmot_joint_t), sizeof(emcmot_comp_t));
+
+    for (n = 0; n < joints; n++) {
+        joint[n] = &joint_array[n];
+        comp[n] = &comp_array[n];
+        init_joint(joint[n], comp[n], n);
+    }
+    run("split", joint, comp, joints, periods, cache, cache_size);
+
+    for (n = 0; n < joints; n++) {
+        joint[n] = &inline_array[n].joint;
+        comp[n] = &inline_array[n].comp;
+        init_joint(joint[n], comp[n], n);
+    }
+    run("inline", joint, comp, joints, periods, cache, cache_size);
+    return 0;
+}
@@ -0,0 +1,127 @@
+/* Benchmark of the per-cycle circle evaluation against the exact one.
+ *
+ * Each test arc is stepped from start to end in equal increments of
+ * progress, the way the planner walks a segment once per servo cycle.
+ * Every point is found both with pmCircleAngleFromProgress() and
+ * pmCirclePoint(), which recompute everything from scratch, and with
+ * pmCircleFastPoint(), which carries cos/sin forward from the previous
+ * point.  Prints the cost per point of both and the largest distance
+ * between them, and fails if that is over the tolerance.
+ *
+ * usage: bench_circle [steps]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "rtapi.h"
+#include "posemath.h"
+#include "blendmath.h"
+#include "tp_types.h"
+
+#define BENCH_DEFAULT_STEPS 200000
+#define BENCH_TOLERANCE 1e-9
+
+void rtapi_print_msg(msg_level_t level, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    const char *name;
+    PmCartesian start, end, center, normal;
+    int turn;
+} bench_arc_t;
+
+static const bench_arc_t arcs[] = {
+    { "circle", {10, 0, 0}, {0, 10, 0}, {0, 0, 0}, {0, 0, 1}, 0 },
+    { "helix", {5, 0, 0}, {5, 0, 4}, {0, 0, 0}, {0, 0, 1}, 3 },
+    { "spiral", {10, 0, 0}, {-12, 0, 1}, {0, 0, 0}, {0, 0, 1}, 1 },
+    { "spiral in", {0, 12, 0}, {-8, 0, 0}, {0, 0, 0}, {0, 0, 1}, 0 },
+};
+
+int main(int argc, char **argv)
+{
+    int n = BENCH_DEFAULT_STEPS;
+    int a, i, failed = 0;
+
+    if (argc > 1) n = atoi(argv[1]);
+    if (n <= 0) {
+        fprintf(stderr, "usage: %s [steps]\n", argv[0]);
+        return 1;
+    }
+
+    for (a = 0; a < (int)(sizeof(arcs) / sizeof(arcs[0])); a++) {
+        const bench_arc_t *arc = &arcs[a];
+        PmCircle circle;
+        SpiralArcLengthFit fit;
+        PmCircleCursor cursor = {0};
+        PmCartesian *exact, *fast;
+        double t0, t_exact, t_fast, d = 0;
+
+        if (pmCircleInit(&circle, &arc->start, &arc->end, &arc->center,
+                &arc->normal, arc->turn) ||
+                findSpiralArcLengthFit(&circle, &fit)) {
+            printf("%-10s: setup failed\n", arc->name);
+            failed++;
+            continue;
+        }
+        exact = calloc(n + 1, sizeof(PmCartesian));
+        fast = calloc(n + 1, sizeof(PmCartesian));
+        if (!exact || !fast) {
+            perror("calloc");
+            return 1;
+        }
+        /* fault the pages in so neither loop pays for it */
+        memset(exact, 0, (n + 1) * sizeof(PmCartesian));
+        memset(fast, 0, (n + 1) * sizeof(PmCartesian));
+
+        t0 = now();
+        for (i = 0; i <= n; i++) {
+            double angle;
+            pmCircleAngleFromProgress(&circle, &fit,
+                    fit.total_length * i / n, &angle);
+            pmCirclePoint(&circle, angle, &exact[i]);
+        }
+        t_exact = now() - t0;
+
+        t0 = now();
+        for (i = 0; i <= n; i++) {
+            if (pmCircleFastPoint(&circle, &fit, &cursor,
+                    fit.total_length * i / n, &fast[i])) {
+                failed++;
+            }
+        }
+        t_fast = now() - t0;
+
+        for (i = 0; i <= n; i++) {
+            double e;
+            pmCartCartDisp(&exact[i], &fast[i], &e);
+            if (e > d) d = e;
+        }
+        printf("%-10s: exact %6.1f ns/point  fast %6.1f ns/point  max diff %g\n",
+               arc->name, t_exact / (n + 1) * 1e9, t_fast / (n + 1) * 1e9, d);
+        if (d > BENCH_TOLERANCE) failed++;
+        free(exact);
+        free(fast);
+    }
+
+    if (failed) {
+        printf("%d failures\n", failed);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+#!/bin/bash
+# Program time of a surfacing job with and without fitting arcs to runs
+# of short feed moves under G64 P Q.
+#
+# The job is made here the way CAM output for it looks: a raster over a
+# curved surface and a set of contours, all cut as 0.05 to 0.1 mm long
+# G1 moves.  tpsim is run on it twice, first with -L, joining only moves
+# that lie on a line as canon does with [TASK]ARC_FIT = 0, then fitting
+# arcs too as canon does by default.
+#
+# usage: bench_smooth.sh path/to/tpsim [tpsim options]
+TPSIM=${1:?usage: $0 path/to/tpsim [tpsim options]}
+shift
+CANON=$(mktemp)
+trap 'rm -f "$CANON"' EXIT
+
+awk 'function call(s) { printf("%5d N..... %s\n", ++n, s) }
+function feed(x, y, z) {
+    call(sprintf("STRAIGHT_FEED(%.4f, %.4f, %.4f, 0.0000, 0.0000, 0.0000)", x, y, z))
+}
+BEGIN {
+    call("USE_LENGTH_UNITS(CANON_UNITS_MM)")
+    call("SET_MOTION_CONTROL_MODE(CANON_CONTINUOUS, 0.010000)")
+    call("SET_NAIVECAM_TOLERANCE(0.0050)")
+    call("SET_FEED_RATE(3000.0000)")
+    call("STRAIGHT_TRAVERSE(0.0000, 0.0000, 5.0000, 0.0000, 0.0000, 0.0000)")
+    # raster over z = 2 sin(x / 8) cos(y / 10) - 3
+    for (j = 0; j <= 40; j++) {
+        y = j * 0.5
+        for (i = 0; i <= 1000; i++) {
+            x = (j % 2) ? 50 - i * 0.05 : i * 0.05
+            feed(x, y, 2 * sin(x / 8) * cos(y / 10) - 3)
+        }
+    }
+    call("STRAIGHT_TRAVERSE(25.0000, 10.0000, 5.0000, 0.0000, 0.0000, 0.0000)")
+    # contours, each a circle of 0.1 mm chords
+    for (r = 2; r <= 10; r += 0.5) {
+        steps = int(2 * 3.14159265 * r / 0.1)
+        for (i = 0; i <= steps; i++) {
+            a = 2 * 3.14159265 * i / steps
+            feed(25 + r * cos(a), 10 + r * sin(a), -4)
+        }
+    }
+    call("STRAIGHT_TRAVERSE(25.0000, 10.0000, 5.0000, 0.0000, 0.0000, 0.0000)")
+}' > "$CANON"
+
+echo "== lines only"
+"$TPSIM" -L "$@" "$CANON" || exit 1
+echo "== lines and arcs"
+"$TPSIM" "$@" "$CANON"
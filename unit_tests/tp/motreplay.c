@@ -0,0 +1,517 @@
+/* Offline replay of the commands task sent to motion.
+ *
+ * Reads a recording made with [EMCMOT]COMMAND_RECORD and hands the
+ * commands that drive the coordinated planner to tp.c the way command.c
+ * does, each once the simulated clock reaches the time task sent it,
+ * with tpRunCycle() run back to back in between.  Moves are held back
+ * while the queue is full, as task would hold them.  Time with the
+ * planner idle and nothing due is skipped.  Reports how long each cycle
+ * took to compute, in CPU time, and compares the queue depth and speed
+ * with the status samples taken in the original run.
+ *
+ * Joint and teleop motion, homing, probing, spindle and I/O commands
+ * have no part in the planner and are counted but not simulated, and so
+ * is spindle synchronisation, so synchronised moves run at their feed.
+ * The feed scale follows the feed and rapid override commands; feed
+ * hold and adaptive feed from HAL are not seen.  Where the planner was
+ * idle in the original run, it starts the next move from the commanded
+ * position sampled there, which takes in any jogs and homing.
+ *
+ * usage: motreplay [options] recording
+ *   -t period        trajectory period in seconds (0.001)
+ *   -o file          write time, speed and queue depth of the replay and
+ *                    of the original run
+ *   -s n             ... every n periods (1)
+ *
+ * Exits with 1 if the planner refused a move, the recording is cut short
+ * or the replay does not end where the original run did, and with 77,
+ * which test harnesses take as a skip, if the recording was made by a
+ * build with a different emcmot_command_t.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "rtapi.h"
+#include "motion.h"
+#include "mot_priv.h"
+#include "motion_debug.h"
+#include "motion_types.h"
+#include "motion_record.h"
+#include "tp.h"
+#include "tcq.h"
+#include "emcpose.h"
+
+/* exit status for a recording this build can't read */
+#define MOTREPLAY_SKIP 77
+
+static double period;
+static TP_STRUCT *tp;
+
+/* the recording, read whole */
+static struct {
+    char *data;
+    size_t length;
+    size_t pos;
+    motion_record_sample_t last;	/* latest sample passed */
+    int have_sample;
+} rec;
+
+static struct {
+    long cycles;
+    double idle;			/* time skipped with nothing to do */
+    long commands;
+    long moves[3];			/* lines, circles, splines */
+    long refused;
+    long skipped;
+    long held;				/* cycles a move waited for room */
+    double busy_time, busy_dist;
+    double peak_vel;
+    long depth_sum;
+    int peak_depth;
+    float *cpu;				/* of each cycle, in seconds */
+    long cpu_size;
+    double worst_cpu;
+    int worst_id;
+} stats;
+
+/* the original run, from the samples */
+static struct {
+    double busy_time, busy_dist;
+    double peak_vel;
+    double depth_time;
+    int peak_depth;
+    long samples;
+} orig;
+
+static int stepping, id_for_step;
+
+static double cpu_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int load(const char *name)
+{
+    motion_record_file_t const *h;
+    FILE *f = fopen(name, "rb");
+    long size;
+
+    if (!f) {
+	perror(name);
+	return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    rewind(f);
+    rec.data = malloc(size > 0 ? size : 1);
+    if (size < (long) sizeof(*h) || !rec.data
+	    || fread(rec.data, size, 1, f) != 1) {
+	fprintf(stderr, "motreplay: can't read %s\n", name);
+	fclose(f);
+	return -1;
+    }
+    fclose(f);
+
+    h = (motion_record_file_t const *) rec.data;
+    if (memcmp(h->magic, MOTION_RECORD_MAGIC, sizeof(h->magic))
+	    || h->version != MOTION_RECORD_VERSION) {
+	fprintf(stderr, "motreplay: %s is not a motion recording\n", name);
+	return -1;
+    }
+    if (h->command_size != sizeof(emcmot_command_t)
+	    || h->sample_size != sizeof(motion_record_sample_t)) {
+	fprintf(stderr, "motreplay: %s was made by a different build of "
+	    "motion; record it again\n", name);
+	return MOTREPLAY_SKIP;
+    }
+    rec.length = size;
+    rec.pos = sizeof(*h);
+    return 0;
+}
+
+/* the next record, or NULL at the end of the recording */
+static motion_record_header_t const *peek(void)
+{
+    motion_record_header_t const *h;
+    size_t want;
+
+    if (rec.length - rec.pos < sizeof(*h)) {
+	return NULL;
+    }
+    h = (motion_record_header_t const *) (rec.data + rec.pos);
+    want = h->type == MOTION_RECORD_COMMAND ? sizeof(emcmot_command_t)
+	: sizeof(motion_record_sample_t);
+    if (h->size != want || rec.length - rec.pos - sizeof(*h) < h->size) {
+	/* cut short when task was killed */
+	return NULL;
+    }
+    return h;
+}
+
+static void advance(void)
+{
+    motion_record_header_t const *h = peek();
+    rec.pos += sizeof(*h) + h->size;
+}
+
+/* add a sample of the original run to its totals */
+static void account_sample(motion_record_sample_t const *s, double t)
+{
+    static double last_t;
+
+    if (rec.have_sample) {
+	double dt = t - last_t;
+	if (rec.last.depth > 0) {
+	    orig.busy_time += dt;
+	    orig.busy_dist += rec.last.current_vel * dt;
+	    orig.depth_time += rec.last.depth * dt;
+	}
+    }
+    orig.peak_vel = fmax(orig.peak_vel, s->current_vel);
+    if (s->depth > orig.peak_depth) {
+	orig.peak_depth = s->depth;
+    }
+    orig.samples++;
+    rec.last = *s;
+    rec.have_sample = 1;
+    last_t = t;
+}
+
+static int is_move(emcmot_command_t const *c)
+{
+    return c->command == EMCMOT_SET_LINE || c->command == EMCMOT_SET_CIRCLE
+	|| c->command == EMCMOT_SET_SPLINE;
+}
+
+/* what command.c would do with c for the coordinated planner */
+static void command(emcmot_command_t const *c)
+{
+    int res = 0;
+
+    if (is_move(c) && tpIsDone(tp) && rec.have_sample
+	    && rec.last.depth == 0) {
+	tpSetPos(tp, &rec.last.carte_pos_cmd);
+    }
+    stats.commands++;
+    switch (c->command) {
+    case EMCMOT_ABORT:
+	tpAbort(tp);
+	emcmotStatus->paused = 0;
+	stepping = 0;
+	break;
+    case EMCMOT_SET_TERM_COND:
+	tpSetTermCond(tp, c->termCond, c->tolerance);
+	break;
+    case EMCMOT_SET_LINE:
+	tpSetId(tp, c->id);
+	res = tpAddLine(tp, c->pos, c->motion_type, c->vel, c->ini_maxvel,
+	    c->acc, emcmotStatus->enables_new, 0, c->turn, c->tag);
+	stats.moves[0]++;
+	break;
+    case EMCMOT_SET_CIRCLE:
+	tpSetId(tp, c->id);
+	res = tpAddCircle(tp, c->pos, c->center, c->normal, c->turn,
+	    c->motion_type, c->vel, c->ini_maxvel, c->acc,
+	    emcmotStatus->enables_new, 0, c->tag);
+	stats.moves[1]++;
+	break;
+    case EMCMOT_SET_SPLINE:
+	tpSetId(tp, c->id);
+	res = tpAddSpline(tp, c->pos, c->ctrl, c->weight, c->turn,
+	    c->motion_type, c->vel, c->ini_maxvel, c->acc,
+	    emcmotStatus->enables_new, 0, c->tag);
+	stats.moves[2]++;
+	break;
+    case EMCMOT_SET_VEL:
+	emcmotStatus->vel = c->vel;
+	tpSetVmax(tp, c->vel, c->ini_maxvel);
+	break;
+    case EMCMOT_SET_VEL_LIMIT:
+	emcmotConfig->limitVel = c->vel;
+	tpSetVlimit(tp, c->vel);
+	break;
+    case EMCMOT_SET_ACC:
+	emcmotStatus->acc = c->acc;
+	tpSetAmax(tp, c->acc);
+	break;
+    case EMCMOT_SET_AXIS_VEL_LIMIT:
+	if (c->axis >= 0 && c->axis < EMCMOT_MAX_AXIS) {
+	    emcmotDebug->axes[c->axis].vel_limit = c->vel;
+	}
+	break;
+    case EMCMOT_SET_AXIS_ACC_LIMIT:
+	if (c->axis >= 0 && c->axis < EMCMOT_MAX_AXIS) {
+	    emcmotDebug->axes[c->axis].acc_limit = c->acc;
+	}
+	break;
+    case EMCMOT_SETUP_ARC_BLENDS:
+	emcmotConfig->arcBlendEnable = c->arcBlendEnable;
+	emcmotConfig->arcBlendFallbackEnable = c->arcBlendFallbackEnable;
+	emcmotConfig->arcBlendOptDepth = c->arcBlendOptDepth;
+	emcmotConfig->arcBlendGapCycles = c->arcBlendGapCycles;
+	emcmotConfig->arcBlendRampFreq = c->arcBlendRampFreq;
+	emcmotConfig->arcBlendTangentKinkRatio = c->arcBlendTangentKinkRatio;
+	break;
+    case EMCMOT_SET_MAX_FEED_OVERRIDE:
+	emcmotConfig->maxFeedScale = c->maxFeedScale;
+	break;
+    case EMCMOT_PAUSE:
+	tpPause(tp);
+	emcmotStatus->paused = 1;
+	break;
+    case EMCMOT_RESUME:
+	stepping = 0;
+	tpResume(tp);
+	emcmotStatus->paused = 0;
+	break;
+    case EMCMOT_STEP:
+	if (emcmotStatus->paused) {
+	    id_for_step = tpGetExecId(tp);
+	    stepping = 1;
+	    tpResume(tp);
+	}
+	break;
+    case EMCMOT_REVERSE:
+	tpSetRunDir(tp, TC_DIR_REVERSE);
+	break;
+    case EMCMOT_FORWARD:
+	tpSetRunDir(tp, TC_DIR_FORWARD);
+	break;
+    case EMCMOT_FEED_SCALE:
+	emcmotStatus->feed_scale = fmax(c->scale, 0.0);
+	break;
+    case EMCMOT_RAPID_SCALE:
+	emcmotStatus->rapid_scale = fmax(c->scale, 0.0);
+	break;
+    case EMCMOT_FS_ENABLE:
+	emcmotStatus->enables_new = c->mode ? emcmotStatus->enables_new
+	    | FS_ENABLED : emcmotStatus->enables_new & ~FS_ENABLED;
+	break;
+    case EMCMOT_FH_ENABLE:
+	emcmotStatus->enables_new = c->mode ? emcmotStatus->enables_new
+	    | FH_ENABLED : emcmotStatus->enables_new & ~FH_ENABLED;
+	break;
+    default:
+	stats.skipped++;
+	break;
+    }
+    if (res < 0) {
+	stats.refused++;
+	tpAbort(tp);
+    }
+}
+
+/* net_feed_scale as control.c works it out, without the HAL pins */
+static void feed_scale(void)
+{
+    double scale = 1.0;
+
+    if (emcmotStatus->enables_queued & FS_ENABLED) {
+	scale = tpGetMotionType(tp) == EMC_MOTION_TYPE_TRAVERSE
+	    ? emcmotStatus->rapid_scale : emcmotStatus->feed_scale;
+    }
+    emcmotStatus->net_feed_scale = scale;
+}
+
+static void account_cycle(double cpu, FILE *profile, int every, double t)
+{
+    int depth = tcqLen(&tp->queue);
+
+    if (stats.cycles >= stats.cpu_size) {
+	stats.cpu_size = stats.cpu_size ? 2 * stats.cpu_size : 1 << 16;
+	stats.cpu = realloc(stats.cpu, stats.cpu_size * sizeof(*stats.cpu));
+	if (!stats.cpu) {
+	    fprintf(stderr, "motreplay: out of memory\n");
+	    exit(1);
+	}
+    }
+    stats.cpu[stats.cycles] = cpu;
+    if (cpu > stats.worst_cpu) {
+	stats.worst_cpu = cpu;
+	stats.worst_id = tpGetExecId(tp);
+    }
+    stats.cycles++;
+
+    if (depth > 0) {
+	stats.busy_time += period;
+	stats.busy_dist += emcmotStatus->current_vel * period;
+	stats.depth_sum += depth;
+    }
+    stats.peak_vel = fmax(stats.peak_vel, emcmotStatus->current_vel);
+    if (depth > stats.peak_depth) {
+	stats.peak_depth = depth;
+    }
+    if (profile && stats.cycles % every == 0) {
+	fprintf(profile, "%.6f %.6f %d %.6f %d\n", t,
+	    emcmotStatus->current_vel, depth,
+	    rec.have_sample ? rec.last.current_vel : 0.0,
+	    rec.have_sample ? rec.last.depth : 0);
+    }
+}
+
+static int cmp_float(const void *a, const void *b)
+{
+    float x = *(const float *) a, y = *(const float *) b;
+    return (x > y) - (x < y);
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: motreplay [-t period] [-o profile [-s n]] recording\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *profile = NULL;
+    motion_record_header_t const *h;
+    double t = 0.0, mean;
+    long period_ns;
+    int opt, n, every = 1, ret;
+
+    emcmotConfig->arcBlendEnable = 1;
+    emcmotConfig->arcBlendOptDepth = 50;
+    emcmotConfig->arcBlendGapCycles = 4;
+    emcmotConfig->arcBlendRampFreq = 100.0;
+    emcmotConfig->arcBlendTangentKinkRatio = 0.1;
+    emcmotConfig->maxFeedScale = 1.0;
+    emcmotConfig->numSpindles = 1;
+    emcmotStatus->feed_scale = emcmotStatus->rapid_scale = 1.0;
+    emcmotStatus->net_feed_scale = 1.0;
+    emcmotStatus->enables_new = FS_ENABLED | SS_ENABLED | FH_ENABLED;
+    period = 0.001;
+
+    while ((opt = getopt(argc, argv, "t:o:s:")) != -1) {
+	switch (opt) {
+	case 't': period = atof(optarg); break;
+	case 'o':
+	    profile = fopen(optarg, "w");
+	    if (!profile) {
+		perror(optarg);
+		return 1;
+	    }
+	    break;
+	case 's': every = atoi(optarg); break;
+	default: usage();
+	}
+    }
+    if (optind != argc - 1 || period <= 0.0 || every < 1) {
+	usage();
+    }
+    ret = load(argv[optind]);
+    if (ret != 0) {
+	return ret < 0 ? 1 : ret;
+    }
+
+    tp = &emcmotDebug->coord_tp;
+    period_ns = period * 1e9 + 0.5;
+    if (tpCreate(tp, DEFAULT_TC_QUEUE_SIZE, emcmotDebug->queueTcSpace) < 0) {
+	fprintf(stderr, "motreplay: can't create planner\n");
+	return 1;
+    }
+    tpSetCycleTime(tp, period);
+
+    while ((h = peek()) || !tpIsDone(tp)) {
+	double start;
+
+	/* nothing moving and nothing due: go straight to the next record */
+	if (h && tpIsDone(tp) && h->time > t + period) {
+	    stats.idle += h->time - t;
+	    t = h->time;
+	}
+
+	/* one servo cycle: the commands due, then the planner */
+	start = cpu_now();
+	while ((h = peek()) && h->time <= t) {
+	    emcmot_command_t const *c = (emcmot_command_t const *) (h + 1);
+	    if (h->type == MOTION_RECORD_SAMPLE) {
+		account_sample((motion_record_sample_t const *) (h + 1),
+		    h->time);
+	    } else if (h->type == MOTION_RECORD_COMMAND) {
+		if (is_move(c) && tcqFull(&tp->queue)) {
+		    stats.held++;
+		    break;
+		}
+		command(c);
+	    }
+	    advance();
+	}
+	feed_scale();
+	tpRunCycle(tp, period_ns);
+	if (stepping && tpGetExecId(tp) != id_for_step) {
+	    tpPause(tp);
+	    stepping = 0;
+	}
+	account_cycle(cpu_now() - start, profile, every, t);
+	t += period;
+    }
+    if (rec.pos != rec.length) {
+	fprintf(stderr, "motreplay: recording is cut short\n");
+	ret = 1;
+    }
+    /* where the original run ended idle, the replay must end there too */
+    if (rec.have_sample && rec.last.depth == 0) {
+	EmcPose end, diff;
+	double error;
+	tpGetPos(tp, &end);
+	emcPoseSub(&end, &rec.last.carte_pos_cmd, &diff);
+	emcPoseMagnitude(&diff, &error);
+	if (error > 1e-6) {
+	    fprintf(stderr, "motreplay: replay ends at %g %g %g, "
+		"the original run at %g %g %g\n", end.tran.x, end.tran.y,
+		end.tran.z, rec.last.carte_pos_cmd.tran.x,
+		rec.last.carte_pos_cmd.tran.y, rec.last.carte_pos_cmd.tran.z);
+	    ret = 1;
+	}
+    }
+    if (stats.refused) {
+	ret = 1;
+    }
+
+    printf("recording      %.3f s, %ld commands (%ld not simulated), "
+	"%ld samples\n", t, stats.commands, stats.skipped, orig.samples);
+    printf("moves          %ld line, %ld circle, %ld spline",
+	stats.moves[0], stats.moves[1], stats.moves[2]);
+    if (stats.refused) {
+	printf(", %ld refused", stats.refused);
+    }
+    printf("\nreplayed       %ld periods of %g s, %.3f s idle skipped, "
+	"%ld held for a full queue\n", stats.cycles, period, stats.idle,
+	stats.held);
+    printf("                   replay  original\n");
+    printf("moving time    %9.3f %9.3f s\n", stats.busy_time, orig.busy_time);
+    printf("mean speed     %9.4f %9.4f /s\n",
+	stats.busy_time > 0.0 ? stats.busy_dist / stats.busy_time : 0.0,
+	orig.busy_time > 0.0 ? orig.busy_dist / orig.busy_time : 0.0);
+    printf("peak speed     %9.4f %9.4f /s\n", stats.peak_vel, orig.peak_vel);
+    printf("mean depth     %9.2f %9.2f\n",
+	stats.busy_time > 0.0 ? stats.depth_sum * period / stats.busy_time
+	: 0.0, orig.busy_time > 0.0 ? orig.depth_time / orig.busy_time : 0.0);
+    printf("peak depth     %9d %9d\n", stats.peak_depth, orig.peak_depth);
+
+    if (stats.cycles > 0) {
+	mean = 0.0;
+	for (n = 0; n < stats.cycles; n++) {
+	    mean += stats.cpu[n];
+	}
+	mean /= stats.cycles;
+	qsort(stats.cpu, stats.cycles, sizeof(*stats.cpu), cmp_float);
+	printf("cycle cpu      mean %.2f, 50%% %.2f, 99%% %.2f, 99.9%% %.2f, "
+	    "max %.2f us (at id %d)\n", mean * 1e6,
+	    stats.cpu[stats.cycles / 2] * 1e6,
+	    stats.cpu[(long) (stats.cycles * 0.99)] * 1e6,
+	    stats.cpu[(long) (stats.cycles * 0.999)] * 1e6,
+	    stats.worst_cpu * 1e6, stats.worst_id);
+    }
+    if (profile) {
+	fclose(profile);
+    }
+    free(stats.cpu);
+    free(rec.data);
+    return ret;
+}
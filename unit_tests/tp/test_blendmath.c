@@ -63,10 +63,100 @@ TEST pmCartCartAntiParallel_numerical() {
     PASS();
 }
 
+TEST pmCircleFastPoint_matches_exact() {
+
+    PmCartesian start = {5, 0, 0};
+    PmCartesian end = {-6, 0, 2};
+    PmCartesian center = {0, 0, 0};
+    PmCartesian normal = {0, 0, 1};
+    PmCircle circle;
+    SpiralArcLengthFit fit;
+    PmCircleCursor cursor = {0};
+
+    ASSERT_FALSE(pmCircleInit(&circle, &start, &end, &center, &normal, 2));
+    ASSERT_FALSE(findSpiralArcLengthFit(&circle, &fit));
+
+    // Small steps forward rotate the cursor, then jumps back and forth
+    // make it start over from exact values
+    const int steps = 5000;
+    for (int i = 0; i <= steps + 10; ++i) {
+        double t = i <= steps ? (double)i / steps : ((i * 7) % 10) / 10.0;
+        double angle;
+        PmCartesian exact, fast;
+        ASSERT_FALSE(pmCircleAngleFromProgress(&circle, &fit, t * fit.total_length, &angle));
+        pmCirclePoint(&circle, angle, &exact);
+        ASSERT_FALSE(pmCircleFastPoint(&circle, &fit, &cursor, t * fit.total_length, &fast));
+        double err;
+        pmCartCartDisp(&exact, &fast, &err);
+        ASSERT(err < 1e-9);
+    }
+
+    PASS();
+}
+
+TEST pmSpline_quarter_circle() {
+    // A quarter of the unit circle as a rational quadratic
+    PmCartesian ctrl[3] = {{1,0,0}, {1,1,0}, {0,1,0}};
+    double weight[3] = {1, M_SQRT1_2, 1};
+    PmSpline spline;
+    ASSERT_FALSE(splineInit(&spline, ctrl, weight, 2));
+    ASSERT_IN_RANGE(PM_PI_2, spline.length, 1e-9);
+    ASSERT_IN_RANGE(1.0, spline.max_curvature, 1e-9);
+
+    // Points by arc length lie on the circle, at the angle travelled
+    const int steps = 100;
+    for (int i = 0; i <= steps; ++i) {
+        double s = spline.length * i / steps;
+        PmCartesian p, tan;
+        ASSERT_FALSE(splinePoint(&spline, s, &p));
+        ASSERT_IN_RANGE(1.0, hypot(p.x, p.y), 1e-12);
+        ASSERT_IN_RANGE(s, atan2(p.y, p.x), 1e-5);
+        ASSERT_FALSE(splineTangent(&spline, s, &tan));
+        ASSERT_IN_RANGE(0.0, tan.x * p.x + tan.y * p.y, 1e-9);
+    }
+
+    PmCircleLimits limits = pmSplineActualMaxVel(&spline, 100, 1000);
+    ASSERT(limits.v_max < 100);
+    ASSERT_IN_RANGE(BLEND_ACC_RATIO_TANGENTIAL, limits.acc_ratio, 1e-9);
+    PASS();
+}
+
+TEST splineNurbsSpan_splits_curve() {
+    // A cubic NURBS with two spans; the spans must join with matching
+    // points and tangent directions
+    PmCartesian ctrl[5] = {{0,0,0}, {1,2,0}, {3,2,0}, {4,0,0}, {6,1,0}};
+    double weight[5] = {1, 2, 1, 1, 1};
+    SplineSpan spans[2];
+    PmSpline a, b;
+    ASSERT_FALSE(splineNurbsSpan(ctrl, weight, 5, 4, 0, &spans[0]));
+    ASSERT_FALSE(splineNurbsSpan(ctrl, weight, 5, 4, 1, &spans[1]));
+    ASSERT(splineNurbsSpan(ctrl, weight, 5, 4, 2, &spans[1]));
+
+    ASSERT_FALSE(splineInit(&a, spans[0].ctrl, spans[0].weight, 3));
+    ASSERT_FALSE(splineInit(&b, spans[1].ctrl, spans[1].weight, 3));
+    ASSERT_IN_RANGE(0.0, spans[0].ctrl[0].x, 1e-12);
+    ASSERT_IN_RANGE(6.0, spans[1].ctrl[3].x, 1e-12);
+    ASSERT_IN_RANGE(1.0, spans[1].ctrl[3].y, 1e-12);
+
+    PmCartesian end_a, start_b, tan_a, tan_b;
+    double dist;
+    splinePoint(&a, a.length, &end_a);
+    splinePoint(&b, 0.0, &start_b);
+    pmCartCartDisp(&end_a, &start_b, &dist);
+    ASSERT(dist < 1e-12);
+    splineTangent(&a, a.length, &tan_a);
+    splineTangent(&b, 0.0, &tan_b);
+    ASSERT(pmCartCartParallel(&tan_a, &tan_b, TP_ANGLE_EPSILON_SQ));
+    PASS();
+}
+
 
  SUITE(blendmath) {
      RUN_TEST(pmCartCartParallel_numerical);
      RUN_TEST(pmCartCartAntiParallel_numerical);
+     RUN_TEST(pmCircleFastPoint_matches_exact);
+     RUN_TEST(pmSpline_quarter_circle);
+     RUN_TEST(splineNurbsSpan_splits_curve);
 
  }
 
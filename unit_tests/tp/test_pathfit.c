@@ -0,0 +1,178 @@
+#include "greatest.h"
+#include "pathfit.h"
+#include "posemath.h"
+#include "rtapi_math.h"
+
+/* Expand to all the definitions that need to be in
+   the test runner's main file. */
+GREATEST_MAIN_DEFS();
+
+static const double tol = 0.005;
+
+/* Points every step along a circle of radius r about the origin in the
+ * XY plane, from angle 0, rounded to 4 places as a CAM program would */
+static void circlePoints(double r, double step, int n, PmCartesian *pts)
+{
+    for (int i = 0; i < n; ++i) {
+        double th = i * step / r;
+        pts[i].x = round(r * cos(th) * 1e4) / 1e4;
+        pts[i].y = round(r * sin(th) * 1e4) / 1e4;
+        pts[i].z = 0;
+    }
+}
+
+TEST chain_arc_longer_than_a_batch() {
+    static PmCartesian pts[400];
+    PmCartesian t = {0, 1, 0};
+    PathFitChain chain;
+
+    // 400 segments of 0.05 around a circle of radius 10, well past the
+    // points an exact fit would be asked to check at once
+    circlePoints(10, 0.05, 400, pts);
+    chain.lines_only = 0;
+    pathFitChainStart(&chain, &pts[0], &t, 0, tol);
+    for (int i = 1; i < 400; ++i) {
+        ASSERT_EQ(0, pathFitChainAdd(&chain, &pts[i]));
+    }
+    ASSERT(chain.is_arc);
+    ASSERT_IN_RANGE(10, chain.arc.radius, tol);
+    ASSERT_IN_RANGE(399 * 0.05 / 10, chain.arc.angle, 1e-3);
+
+    // Whatever the chain fitted must hold up when checked exactly
+    PathFitArc arc;
+    ASSERT_EQ(0, pathFitArc(pts, 400, &t, tol, &arc));
+    PASS();
+}
+
+TEST chain_matches_exact_fit() {
+    static PmCartesian pts[300];
+    PathFitChain chain;
+    PathFitArc arc;
+
+    // A curve that bends ever more tightly, so the arc has to end
+    for (int i = 0; i < 300; ++i) {
+        double x = i * 0.05;
+        pts[i].x = x;
+        pts[i].y = round(0.002 * x * x * x * 1e4) / 1e4;
+        pts[i].z = 0;
+    }
+    PmCartesian t = {1, 0, 0};
+    chain.lines_only = 0;
+    pathFitChainStart(&chain, &pts[0], &t, 0, tol);
+    int n = 1;
+    while (n < 300 && !pathFitChainAdd(&chain, &pts[n])) {
+        ++n;
+    }
+    ASSERT(n < 300);
+    ASSERT(chain.is_arc);
+
+    // The run must fit exactly, and the exact fit may go at most a
+    // point further than the bounds the chain keeps allow
+    ASSERT_EQ(0, pathFitArc(pts, n, &t, tol, &arc));
+    ASSERT_IN_RANGE(chain.arc.radius, arc.radius, 100 * tol);
+    ASSERT(n + 1 >= 300 || pathFitArc(pts, n + 2, &t, tol, &arc));
+    PASS();
+}
+
+TEST chain_without_tangent_fits_free_arc() {
+    static PmCartesian pts[100];
+    PathFitChain chain;
+
+    circlePoints(2, 0.05, 100, pts);
+    chain.lines_only = 0;
+    pathFitChainStart(&chain, &pts[0], NULL, 0, tol);
+    for (int i = 1; i < 100; ++i) {
+        ASSERT_EQ(0, pathFitChainAdd(&chain, &pts[i]));
+    }
+    ASSERT(chain.is_arc);
+    ASSERT_IN_RANGE(2, chain.arc.radius, 10 * tol);
+
+    // The arc must end where the circle goes
+    PmCartesian end_tangent;
+    ASSERT_EQ(0, pathFitChainEndTangent(&chain, &end_tangent));
+    ASSERT_IN_RANGE(-sin(99 * 0.05 / 2), end_tangent.x, 0.01);
+    ASSERT_IN_RANGE(cos(99 * 0.05 / 2), end_tangent.y, 0.01);
+    PASS();
+}
+
+TEST chain_corner_gives_line() {
+    PmCartesian pts[] = {{0, 0, 0}, {1, 0, 0}, {2, 0, 0}, {3, 0.5, 0}};
+    PmCartesian t = {0, 1, 0};
+    PmCartesian end_tangent;
+    PathFitChain chain;
+
+    // Coming in along Y and going off along X is a corner, not an arc
+    chain.lines_only = 0;
+    pathFitChainStart(&chain, &pts[0], &t, 0, tol);
+    ASSERT_EQ(0, pathFitChainAdd(&chain, &pts[1]));
+    ASSERT_EQ(0, pathFitChainAdd(&chain, &pts[2]));
+    ASSERT_FALSE(chain.is_arc);
+    ASSERT_EQ(1, pathFitChainEndTangent(&chain, &end_tangent));
+    ASSERT_IN_RANGE(1, end_tangent.x, 1e-9);
+
+    // A point off the line ends the run and leaves it as it was
+    ASSERT_EQ(-1, pathFitChainAdd(&chain, &pts[3]));
+    ASSERT_EQ(3, chain.n);
+    PASS();
+}
+
+TEST chain_backs_up_one_point() {
+    static PmCartesian pts[50];
+    PmCartesian t = {0, 1, 0};
+    PathFitChain chain;
+
+    circlePoints(2, 0.05, 50, pts);
+    chain.lines_only = 0;
+    pathFitChainStart(&chain, &pts[0], &t, 0, tol);
+    ASSERT_EQ(-1, pathFitChainBackUp(&chain));
+    for (int i = 1; i < 50; ++i) {
+        ASSERT_EQ(0, pathFitChainAdd(&chain, &pts[i]));
+    }
+    ASSERT_EQ(0, pathFitChainBackUp(&chain));
+    ASSERT_EQ(49, chain.n);
+    ASSERT_IN_RANGE(pts[48].x, chain.end.x, 1e-12);
+    ASSERT_IN_RANGE(pts[48].y, chain.end.y, 1e-12);
+    ASSERT(chain.is_arc);
+    ASSERT_IN_RANGE(48 * 0.05 / 2, chain.arc.angle, 1e-3);
+
+    // Going on out of the plane of the arc is seen
+    PmCartesian up = pts[48];
+    up.z = 0.5;
+    ASSERT(pathFitChainLeavesPlane(&chain, &up));
+    ASSERT_FALSE(pathFitChainLeavesPlane(&chain, &pts[49]));
+    PASS();
+}
+
+TEST chain_lines_only() {
+    static PmCartesian pts[20];
+    PmCartesian t = {0, 1, 0};
+    PathFitChain chain;
+
+    circlePoints(2, 0.05, 20, pts);
+    chain.lines_only = 1;
+    pathFitChainStart(&chain, &pts[0], &t, 0, tol);
+    int n = 1;
+    while (n < 20 && !pathFitChainAdd(&chain, &pts[n])) {
+        ++n;
+    }
+    ASSERT(n < 20);
+    ASSERT_FALSE(chain.is_arc);
+    ASSERT_EQ(0, pathFitLine(pts, n, tol));
+    ASSERT(pathFitLine(pts, n + 1, tol));
+    PASS();
+}
+
+SUITE(pathfit) {
+    RUN_TEST(chain_arc_longer_than_a_batch);
+    RUN_TEST(chain_matches_exact_fit);
+    RUN_TEST(chain_without_tangent_fits_free_arc);
+    RUN_TEST(chain_corner_gives_line);
+    RUN_TEST(chain_backs_up_one_point);
+    RUN_TEST(chain_lines_only);
+}
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN();
+    RUN_SUITE(pathfit);
+    GREATEST_MAIN_END();
+}
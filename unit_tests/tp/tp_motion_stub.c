@@ -0,0 +1,39 @@
+/* Minimal motion controller for running tp.c outside of motmod.
+ *
+ * The planner reads its configuration and writes its status through
+ * the emcmotStatus, emcmotConfig and emcmotDebug pointers, and sets
+ * digital/analog outputs through the motion module.  Here those are
+ * plain static structs and the outputs do nothing, so tp.c can be
+ * linked straight into a userspace program.
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include "rtapi.h"
+#include "motion.h"
+#include "mot_priv.h"
+#include "motion_debug.h"
+
+static emcmot_status_t status;
+static emcmot_config_t config;
+static emcmot_debug_t debug;
+
+emcmot_status_t *emcmotStatus = &status;
+emcmot_config_t *emcmotConfig = &config;
+emcmot_debug_t *emcmotDebug = &debug;
+
+void emcmotDioWrite(int index, char value) { }
+void emcmotAioWrite(int index, double value) { }
+void emcmotSetRotaryUnlock(int axis, int unlock) { }
+int emcmotGetRotaryIsUnlocked(int axis) { return 1; }
+
+void rtapi_print_msg(msg_level_t level, const char *fmt, ...)
+{
+    va_list args;
+
+    if (level > RTAPI_MSG_ERR) {
+        return;
+    }
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
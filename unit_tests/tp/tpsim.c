@@ -0,0 +1,755 @@
+/* Offline run of the trajectory planner.
+ *
+ * Reads the canonical calls printed by the standalone interpreter
+ * ("rs274 -g program.ngc"), queues the moves in tp.c the way canon and
+ * motion would, and then runs tpRunCycle() back to back with no
+ * realtime wait.  Reports the program's run time to the period, the
+ * peak speed and the per-axis peak velocity and acceleration, and how
+ * the segments were joined.  Optionally writes the whole profile.
+ *
+ * Velocity and acceleration limits for each move are worked out from
+ * the axis limits as emccanon.cc does.  Under G64 Q, runs of feed moves
+ * are joined into lines, and with -a into arcs, as canon joins them,
+ * though arcs short enough to be flattened into two lines by canon are
+ * queued as they are.  NURBS of order 4 or less are queued one span at a
+ * time as spline segments, as canon sends G5, G5.1 and G5.2 of that
+ * order.  Work offsets only move the path so they are ignored; spindle
+ * synchronised moves, rigid tapping and higher order NURBS are skipped
+ * with a warning.  Dwells and probe moves wait for the queue to empty,
+ * like the queue busters they are in task.
+ *
+ * Exits with 1 if the planner refuses a move or does not end where the
+ * program does.
+ *
+ * usage: tpsim [options] [canon-file]
+ *   -t period        trajectory period in seconds (0.001)
+ *   -u mm|inch       machine units (mm)
+ *   -l axes=vel,acc  limits for the named axes in machine units (and
+ *                    degrees), e.g. -l xyz=50,500.  All start at 100,1000
+ *   -V vel           [TRAJ]MAX_VELOCITY, default the fastest axis
+ *   -A acc           [TRAJ]MAX_ACCELERATION, default the fastest axis
+ *   -d depth         [TRAJ]ARC_BLEND_OPTIMIZATION_DEPTH (50)
+ *   -n               [TRAJ]ARC_BLEND_ENABLE = 0
+ *   -g cycles        [TRAJ]ARC_BLEND_GAP_CYCLES (4)
+ *   -r freq          [TRAJ]ARC_BLEND_RAMP_FREQ (100)
+ *   -L               [TASK]ARC_FIT = 0, join feed moves under G64 Q
+ *                    into lines only
+ *   -o file          write time, position, speed and acceleration
+ *   -s n             ... every n periods (1)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "rtapi.h"
+#include "motion.h"
+#include "mot_priv.h"
+#include "motion_debug.h"
+#include "motion_types.h"
+#include "tp.h"
+#include "tcq.h"
+#include "pathfit.h"
+#include "spline.h"
+
+#define SIM_AXES 9
+#define SIM_OVER 1.01		/* report peaks over the limit by this much */
+#define SIM_NURBS_POINTS 100	/* most control points of a NURBS_FEED */
+#define SIM_ARGS (2 + 3 * SIM_NURBS_POINTS)
+
+static const char axis_names[] = "XYZABCUVW";
+
+static double axis_vel[SIM_AXES], axis_acc[SIM_AXES];
+static double machine_per_mm = 1.0;
+static TP_STRUCT *tp;
+static long period_ns;
+static double period;
+
+/* what canon would know at this point in the program */
+static struct {
+    double units;		/* machine units per program unit */
+    double feed;		/* machine units per second */
+    int plane;			/* 0 XY, 1 YZ, 2 XZ */
+    int term_cond;
+    double tolerance;
+    double naivecam;		/* G64 Q */
+    EmcPose pos;		/* end of the last move */
+    int line;
+    double wait;		/* dwell to do once the queue is empty */
+    int sync;			/* stop reading until the queue is empty */
+} canon;
+
+/* feed moves being joined, like chained_points in canon */
+static struct {
+    PathFitChain path;
+    EmcPose end;
+    EmcPose before;		/* end of the one before it */
+    PmCartesian tangent;	/* direction of the last one where it ended */
+    int have_tangent;
+    int chord;			/* and it was a line from a corner */
+} chain;
+
+static struct {
+    long cycles;
+    long queued[3];		/* traverses, feeds, arcs */
+    long splines;		/* of the arcs, spline segments */
+    long joined[2];		/* feeds joined into lines, into arcs */
+    long skipped;
+    long ended[4];		/* segments by TC_TERM_COND_* */
+    long arc_blends;
+    double dwell;
+    double peak_speed, peak_accel;
+    double peak_vel[SIM_AXES], peak_acc[SIM_AXES];
+    long vel_over[SIM_AXES], acc_over[SIM_AXES];
+} stats;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void pose_to_array(EmcPose const *p, double *v)
+{
+    v[0] = p->tran.x; v[1] = p->tran.y; v[2] = p->tran.z;
+    v[3] = p->a; v[4] = p->b; v[5] = p->c;
+    v[6] = p->u; v[7] = p->v; v[8] = p->w;
+}
+
+/* shortest time the axes allow for a straight move to end, for
+   velocity and for acceleration, and the length the planner measures
+   it by; getStraightVelocity() and getStraightAcceleration() in canon */
+static double straight_limits(EmcPose const *end, double *tvel, double *tacc)
+{
+    double from[SIM_AXES], to[SIM_AXES], d[SIM_AXES];
+    double xyz, uvw, abc;
+    int n;
+
+    pose_to_array(&canon.pos, from);
+    pose_to_array(end, to);
+    *tvel = *tacc = 0.0;
+    for (n = 0; n < SIM_AXES; n++) {
+	d[n] = fabs(to[n] - from[n]);
+	if (d[n] < 1e-7) {
+	    continue;
+	}
+	*tvel = fmax(*tvel, d[n] / axis_vel[n]);
+	*tacc = fmax(*tacc, d[n] / axis_acc[n]);
+    }
+    xyz = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    uvw = sqrt(d[6] * d[6] + d[7] * d[7] + d[8] * d[8]);
+    abc = sqrt(d[3] * d[3] + d[4] * d[4] + d[5] * d[5]);
+    return xyz > 0.0 ? xyz : uvw > 0.0 ? uvw : abc;
+}
+
+static void queued(int type, EmcPose const *end, int res)
+{
+    if (res < 0) {
+	fprintf(stderr, "tpsim: planner refused move at line %d (%d)\n",
+	    canon.line, res);
+	exit(1);
+    }
+    stats.queued[type - EMC_MOTION_TYPE_TRAVERSE]++;
+    canon.pos = *end;
+}
+
+static void straight(int type, EmcPose end)
+{
+    static struct state_tag_t tag;
+    double tvel, tacc, len, vmax, amax, vel;
+
+    len = straight_limits(&end, &tvel, &tacc);
+    if (len <= 0.0 || tvel <= 0.0) {
+	canon.pos = end;
+	return;
+    }
+    vmax = len / tvel;
+    amax = len / tacc;
+    vel = (type == EMC_MOTION_TYPE_TRAVERSE) ? vmax : fmin(canon.feed, vmax);
+    tpSetTermCond(tp, canon.term_cond, canon.tolerance);
+    tpSetId(tp, canon.line);
+    queued(type == EMC_MOTION_TYPE_PROBING ? EMC_MOTION_TYPE_FEED : type, &end,
+	tpAddLine(tp, end, type, vel, vmax, amax, emcmotStatus->enables_new,
+	    0, -1, tag));
+}
+
+/* ARC_FEED() in emccanon.cc, without the rotation of the XY plane */
+static void arc(double first_end, double second_end, double first_axis,
+    double second_axis, int rotation, double axis_end, EmcPose end)
+{
+    static struct state_tag_t tag;
+    static const int plane_axes[3][3] = { {0, 1, 2}, {1, 2, 0}, {2, 0, 1} };
+    const int *ax = plane_axes[canon.plane];
+    double e[3], c[3], s[3];
+    PmCartesian center, normal = { 0.0, 0.0, 0.0 };
+    double theta_start, theta_end, angle, start_radius, end_radius;
+    double spiral, dr, min_radius, effective_radius, spiral_length;
+    double v_max_axes, a_max_axes, v_max_planar, axis_len, total;
+    double tvel, tacc, vmax, amax, vel;
+
+    e[ax[0]] = first_end; e[ax[1]] = second_end; e[ax[2]] = axis_end;
+    c[ax[0]] = first_axis; c[ax[1]] = second_axis; c[ax[2]] = axis_end;
+    s[0] = canon.pos.tran.x; s[1] = canon.pos.tran.y; s[2] = canon.pos.tran.z;
+    end.tran.x = e[0]; end.tran.y = e[1]; end.tran.z = e[2];
+    center.x = c[0]; center.y = c[1]; center.z = c[2];
+    if (ax[2] == 0) normal.x = 1.0;
+    else if (ax[2] == 1) normal.y = 1.0;
+    else normal.z = 1.0;
+
+    theta_start = atan2(s[ax[1]] - c[ax[1]], s[ax[0]] - c[ax[0]]);
+    theta_end = atan2(e[ax[1]] - c[ax[1]], e[ax[0]] - c[ax[0]]);
+    start_radius = hypot(s[ax[1]] - c[ax[1]], s[ax[0]] - c[ax[0]]);
+    end_radius = hypot(e[ax[1]] - c[ax[1]], e[ax[0]] - c[ax[0]]);
+    if (rotation < 0) {
+	if (theta_end + 1e-12 >= theta_start) theta_end -= 2.0 * M_PI;
+    } else {
+	if (theta_end - 1e-12 <= theta_start) theta_end += 2.0 * M_PI;
+    }
+    angle = theta_end - theta_start;
+    if (rotation > 1) angle += 2.0 * M_PI * (rotation - 1);
+    if (rotation < -1) angle += 2.0 * M_PI * (rotation + 1);
+
+    spiral = end_radius - start_radius;
+    dr = spiral / fabs(angle);
+    min_radius = fmin(start_radius, end_radius);
+    effective_radius = sqrt(dr * dr + min_radius * min_radius);
+    v_max_axes = fmin(axis_vel[ax[0]], axis_vel[ax[1]]);
+    a_max_axes = fmin(axis_acc[ax[0]], axis_acc[ax[1]]);
+    v_max_planar = fmin(sqrt(a_max_axes * sqrt(3.0) / 2.0 * effective_radius),
+	v_max_axes);
+    spiral_length = hypot(min_radius * fabs(angle), spiral);
+    axis_len = e[ax[2]] - s[ax[2]];
+    total = hypot(spiral_length, axis_len);
+
+    straight_limits(&end, &tvel, &tacc);
+    vmax = total / fmax(tvel, spiral_length / v_max_planar);
+    amax = total / fmax(tacc, spiral_length / a_max_axes);
+    vel = fmin(canon.feed, vmax);
+    if (!(vel > 0.0 && amax > 0.0)) {
+	canon.pos = end;
+	return;
+    }
+    tpSetTermCond(tp, canon.term_cond, canon.tolerance);
+    tpSetId(tp, canon.line);
+    if (rotation == 0) {
+	queued(EMC_MOTION_TYPE_ARC, &end,
+	    tpAddLine(tp, end, EMC_MOTION_TYPE_ARC, vel, vmax, amax,
+		emcmotStatus->enables_new, 0, -1, tag));
+    } else {
+	queued(EMC_MOTION_TYPE_ARC, &end,
+	    tpAddCircle(tp, end, center, normal,
+		rotation > 0 ? rotation - 1 : rotation, EMC_MOTION_TYPE_ARC,
+		vel, vmax, amax, emcmotStatus->enables_new, 0, tag));
+    }
+}
+
+/* flush_arc() and send_circle() in emccanon.cc */
+static void fitted_arc(PathFitArc const *fit, EmcPose end)
+{
+    static struct state_tag_t tag;
+    double normal[3] = { fit->normal.x, fit->normal.y, fit->normal.z };
+    double v_max_axes = 1e99, a_max_axes = 1e99, v_max_planar, length;
+    double tvel, tacc, vmax, amax, vel;
+    int n;
+
+    for (n = 0; n < 3; n++) {
+	if (fabs(normal[n]) > 1.0 - 1e-9) {
+	    continue;
+	}
+	v_max_axes = fmin(v_max_axes, axis_vel[n]);
+	a_max_axes = fmin(a_max_axes, axis_acc[n]);
+    }
+    v_max_planar = fmin(sqrt(a_max_axes * sqrt(3.0) / 2.0 * fit->radius),
+	v_max_axes);
+    length = fit->radius * fit->angle;
+
+    straight_limits(&end, &tvel, &tacc);
+    vmax = length / fmax(tvel, length / v_max_planar);
+    amax = length / fmax(tacc, length / a_max_axes);
+    vel = fmin(canon.feed, vmax);
+    if (!(vel > 0.0 && amax > 0.0)) {
+	canon.pos = end;
+	return;
+    }
+    tpSetTermCond(tp, canon.term_cond, canon.tolerance);
+    tpSetId(tp, canon.line);
+    queued(EMC_MOTION_TYPE_ARC, &end,
+	tpAddCircle(tp, end, fit->center, fit->normal, 0, EMC_MOTION_TYPE_ARC,
+	    vel, vmax, amax, emcmotStatus->enables_new, 0, tag));
+}
+
+static void flush_chain(void)
+{
+    int ended;
+
+    if (chain.path.n < 2) {
+	chain.path.n = 0;
+	return;
+    }
+    stats.joined[chain.path.is_arc] += chain.path.n - 2;
+    ended = pathFitChainEndTangent(&chain.path, &chain.tangent);
+    chain.have_tangent = ended >= 0;
+    chain.chord = ended > 0;
+    if (chain.path.is_arc) {
+	fitted_arc(&chain.path.arc, chain.end);
+    } else {
+	straight(EMC_MOTION_TYPE_FEED, chain.end);
+    }
+    chain.path.n = 0;
+}
+
+static void start_chain(EmcPose end)
+{
+    PmCartesian *at = &canon.pos.tran;
+    int tangent = chain.have_tangent && at->x == chain.end.tran.x
+	&& at->y == chain.end.tran.y && at->z == chain.end.tran.z;
+
+    pathFitChainStart(&chain.path, at, tangent ? &chain.tangent : NULL,
+	chain.chord, canon.naivecam);
+    pathFitChainAdd(&chain.path, &end.tran);
+}
+
+/* see_segment() and linkable() in emccanon.cc */
+static void feed(EmcPose end)
+{
+    if (chain.path.n > 0 && !(canon.term_cond == TC_TERM_COND_PARABOLIC
+	    && canon.naivecam > 0.0
+	    && end.a == chain.end.a && end.b == chain.end.b
+	    && end.c == chain.end.c && end.u == chain.end.u
+	    && end.v == chain.end.v && end.w == chain.end.w
+	    && !pathFitChainAdd(&chain.path, &end.tran))) {
+	if (pathFitChainLeavesPlane(&chain.path, &end.tran)
+		&& !pathFitChainBackUp(&chain.path)) {
+	    EmcPose last = chain.end;
+
+	    chain.end = chain.before;
+	    flush_chain();
+	    start_chain(last);
+	    chain.end = last;
+	}
+	flush_chain();
+    }
+    if (chain.path.n == 0) {
+	start_chain(end);
+    } else {
+	chain.before = chain.end;
+    }
+    chain.end = end;
+    if (end.a != canon.pos.a || end.b != canon.pos.b || end.c != canon.pos.c
+	    || end.u != canon.pos.u || end.v != canon.pos.v
+	    || end.w != canon.pos.w) {
+	flush_chain();
+    }
+}
+
+static void not_simulated(const char *name)
+{
+    static int warned;
+
+    stats.skipped++;
+    if (!warned++) {
+	fprintf(stderr, "tpsim: %s and the like are not simulated\n", name);
+    }
+}
+
+/* NURBS_FEED() and send_spline() in emccanon.cc: args are the number of
+   points, the order, then X, Y and weight of each point */
+static void nurbs(double *args, int n)
+{
+    static struct state_tag_t tag;
+    PmCartesian ctrl[SIM_NURBS_POINTS];
+    double weight[SIM_NURBS_POINTS];
+    double v_max = fmin(axis_vel[0], axis_vel[1]);
+    double a_max = fmin(axis_acc[0], axis_acc[1]);
+    double vel = fmin(canon.feed, v_max);
+    int count = n >= 2 ? (int) args[0] : 0, order = n >= 2 ? (int) args[1] : 0;
+    int i;
+
+    if (order < 2 || order > EMCMOT_MAX_SPLINE_POINTS || count < order
+	    || count > SIM_NURBS_POINTS || n < 2 + 3 * count) {
+	not_simulated("NURBS_FEED");
+	return;
+    }
+    for (i = 0; i < count; i++) {
+	ctrl[i].x = args[2 + 3 * i] * canon.units;
+	ctrl[i].y = args[3 + 3 * i] * canon.units;
+	ctrl[i].z = canon.pos.tran.z;
+	weight[i] = args[4 + 3 * i];
+    }
+    for (i = 0; i + order <= count; i++) {
+	SplineSpan span;
+	EmcPose end = canon.pos;
+	if (splineNurbsSpan(ctrl, weight, count, order, i, &span)) {
+	    break;
+	}
+	end.tran = span.ctrl[order - 1];
+	tpSetTermCond(tp, canon.term_cond, canon.tolerance);
+	tpSetId(tp, canon.line);
+	queued(EMC_MOTION_TYPE_ARC, &end,
+	    tpAddSpline(tp, end, span.ctrl, span.weight, order - 1,
+		EMC_MOTION_TYPE_ARC, vel, v_max, a_max,
+		emcmotStatus->enables_new, 0, tag));
+	stats.splines++;
+    }
+}
+
+/* split "  12 N00030 NAME(a, b, c)" into the name and its arguments */
+static int parse_call(char *line, char **name, char **text, double *args,
+    int max)
+{
+    char *open = strchr(line, '('), *p;
+    int n = 0;
+
+    if (!open) {
+	return -1;
+    }
+    p = open;
+    while (p > line && (isupper((unsigned char) p[-1]) || p[-1] == '_')) {
+	p--;
+    }
+    *open = 0;
+    *name = p;
+    *text = open + 1;
+    for (p = open + 1; n < max && *p && *p != ')';) {
+	char *next;
+	args[n] = strtod(p, &next);
+	if (next == p) {
+	    break;
+	}
+	n++;
+	p = next;
+	while (*p == ',' || *p == ' ') {
+	    p++;
+	}
+    }
+    return n;
+}
+
+static EmcPose end_pose(double *args, int n)
+{
+    EmcPose end = canon.pos;
+    double u = canon.units;
+
+    end.tran.x = args[0] * u; end.tran.y = args[1] * u; end.tran.z = args[2] * u;
+    if (n >= 6) {
+	end.a = args[3]; end.b = args[4]; end.c = args[5];
+    }
+    if (n >= 9) {
+	end.u = args[6] * u; end.v = args[7] * u; end.w = args[8] * u;
+    }
+    return end;
+}
+
+/* handle one line of canon output; returns 0 at the end of the input */
+static int read_canon(FILE *in)
+{
+    char line[16 * SIM_ARGS], *name, *text;
+    double args[SIM_ARGS];
+    int n;
+
+    if (!fgets(line, sizeof(line), in)) {
+	flush_chain();
+	return 0;
+    }
+    canon.line++;
+    n = parse_call(line, &name, &text, args, SIM_ARGS);
+    if (n < 0) {
+	return 1;
+    }
+    if (!strcmp(name, "STRAIGHT_FEED") && n >= 3) {
+	feed(end_pose(args, n));
+	return 1;
+    }
+    if (!strcmp(name, "SET_NAIVECAM_TOLERANCE") && n >= 1) {
+	canon.naivecam = args[0] * canon.units;
+	return 1;
+    }
+    /* most other calls end a run of joined feed moves in canon, so
+       treat them all that way */
+    if (strcmp(name, "USE_LENGTH_UNITS") && strcmp(name, "SELECT_PLANE")) {
+	flush_chain();
+    }
+    if (!strcmp(name, "STRAIGHT_TRAVERSE") && n >= 3) {
+	straight(EMC_MOTION_TYPE_TRAVERSE, end_pose(args, n));
+    } else if (!strcmp(name, "ARC_FEED") && n >= 6) {
+	double u = canon.units;
+	EmcPose end = canon.pos;
+	if (n >= 9) {
+	    end.a = args[6]; end.b = args[7]; end.c = args[8];
+	}
+	arc(args[0] * u, args[1] * u, args[2] * u, args[3] * u, (int) args[4],
+	    args[5] * u, end);
+    } else if (!strcmp(name, "STRAIGHT_PROBE") && n >= 3) {
+	straight(EMC_MOTION_TYPE_PROBING, end_pose(args, n));
+	canon.sync = 1;
+    } else if (!strcmp(name, "DWELL") && n >= 1) {
+	canon.wait += args[0];
+	canon.sync = 1;
+    } else if (!strcmp(name, "SET_FEED_RATE") && n >= 1) {
+	canon.feed = args[0] * canon.units / 60.0;
+    } else if (!strcmp(name, "USE_LENGTH_UNITS")) {
+	canon.units = machine_per_mm * (strstr(text, "INCHES") ? 25.4 : 1.0);
+    } else if (!strcmp(name, "SELECT_PLANE")) {
+	canon.plane = strstr(text, "YZ") ? 1 : strstr(text, "XZ") ? 2 : 0;
+    } else if (!strcmp(name, "SET_MOTION_CONTROL_MODE")) {
+	if (strstr(text, "EXACT_STOP")) {
+	    canon.term_cond = TC_TERM_COND_STOP;
+	} else if (strstr(text, "EXACT_PATH")) {
+	    canon.term_cond = TC_TERM_COND_EXACT;
+	} else {
+	    char *comma = strchr(text, ',');
+	    canon.term_cond = TC_TERM_COND_PARABOLIC;
+	    canon.tolerance = comma ? strtod(comma + 1, NULL) * canon.units : 0.0;
+	}
+    } else if (!strcmp(name, "NURBS_FEED")) {
+	nurbs(args, n);
+    } else if (!strcmp(name, "RIGID_TAP")
+	    || !strcmp(name, "START_SPEED_FEED_SYNCH")) {
+	not_simulated(name);
+    }
+    return 1;
+}
+
+/* account for one period of output */
+static void sample(FILE *profile, int every)
+{
+    static double last[SIM_AXES], last_vel[SIM_AXES], last_speed;
+    static TC_STRUCT *active;
+    static int samples;
+    double pos[SIM_AXES], vel[SIM_AXES], speed, accel;
+    TC_STRUCT *tc;
+    EmcPose p;
+    int n;
+
+    tc = tcqItem(&tp->queue, 0);
+    if (tc && tc != active) {
+	if (tc->term_cond >= 0 && tc->term_cond < 4) {
+	    stats.ended[tc->term_cond]++;
+	}
+	if (tc->motion_type == TC_SPHERICAL) {
+	    stats.arc_blends++;
+	}
+    }
+    active = tc;
+
+    tpGetPos(tp, &p);
+    pose_to_array(&p, pos);
+    for (n = 0; n < SIM_AXES; n++) {
+	vel[n] = (pos[n] - last[n]) / period;
+    }
+    speed = sqrt(vel[0] * vel[0] + vel[1] * vel[1] + vel[2] * vel[2]);
+    accel = (speed - last_speed) / period;
+    if (samples > 0) {
+	stats.peak_speed = fmax(stats.peak_speed, speed);
+	for (n = 0; n < SIM_AXES; n++) {
+	    double v = fabs(vel[n]);
+	    stats.peak_vel[n] = fmax(stats.peak_vel[n], v);
+	    stats.vel_over[n] += v > axis_vel[n] * SIM_OVER;
+	}
+    }
+    if (samples > 1) {
+	stats.peak_accel = fmax(stats.peak_accel, fabs(accel));
+	for (n = 0; n < SIM_AXES; n++) {
+	    double a = fabs(vel[n] - last_vel[n]) / period;
+	    stats.peak_acc[n] = fmax(stats.peak_acc[n], a);
+	    stats.acc_over[n] += a > axis_acc[n] * SIM_OVER;
+	}
+    }
+    if (profile && stats.cycles % every == 0) {
+	fprintf(profile, "%.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f\n",
+	    stats.cycles * period + stats.dwell, pos[0], pos[1], pos[2],
+	    pos[3], pos[4], speed, samples > 1 ? accel : 0.0);
+    }
+    samples++;
+    memcpy(last, pos, sizeof(last));
+    memcpy(last_vel, vel, sizeof(last_vel));
+    last_speed = speed;
+}
+
+static int set_limits(char *arg)
+{
+    char *eq = strchr(arg, '=');
+    double vel, acc;
+    char *p;
+
+    if (!eq || sscanf(eq + 1, "%lf,%lf", &vel, &acc) != 2 || vel <= 0.0
+	    || acc <= 0.0) {
+	return -1;
+    }
+    for (p = arg; p < eq; p++) {
+	const char *a = strchr(axis_names, toupper((unsigned char) *p));
+	if (!a) {
+	    return -1;
+	}
+	axis_vel[a - axis_names] = vel;
+	axis_acc[a - axis_names] = acc;
+    }
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+	"usage: tpsim [-t period] [-u mm|inch] [-l axes=vel,acc]... [-V vel] [-A acc]\n"
+	"             [-d depth] [-n] [-g cycles] [-r freq] [-a] [-o profile [-s n]]\n"
+	"             [canon-file]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin, *profile = NULL;
+    double traj_vel = 0.0, traj_acc = 0.0, start, elapsed, total;
+    double pos[SIM_AXES], want[SIM_AXES];
+    EmcPose end;
+    int opt, n, every = 1, more = 1, failed = 0;
+
+    emcmotConfig->arcBlendEnable = 1;
+    emcmotConfig->arcBlendFallbackEnable = 0;
+    emcmotConfig->arcBlendOptDepth = 50;
+    emcmotConfig->arcBlendGapCycles = 4;
+    emcmotConfig->arcBlendRampFreq = 100.0;
+    emcmotConfig->arcBlendTangentKinkRatio = 0.1;
+    emcmotConfig->maxFeedScale = 1.0;
+    emcmotConfig->numSpindles = 1;
+    emcmotStatus->net_feed_scale = 1.0;
+    emcmotStatus->enables_new = FS_ENABLED | SS_ENABLED | FH_ENABLED;
+    period = 0.001;
+    chain.path.lines_only = 0;
+    for (n = 0; n < SIM_AXES; n++) {
+	axis_vel[n] = 100.0;
+	axis_acc[n] = 1000.0;
+    }
+
+    while ((opt = getopt(argc, argv, "t:u:l:V:A:d:ng:r:Lo:s:")) != -1) {
+	switch (opt) {
+	case 't': period = atof(optarg); break;
+	case 'u':
+	    if (!strcmp(optarg, "inch")) {
+		machine_per_mm = 1.0 / 25.4;
+	    } else if (strcmp(optarg, "mm")) {
+		usage();
+	    }
+	    break;
+	case 'l':
+	    if (set_limits(optarg) < 0) {
+		usage();
+	    }
+	    break;
+	case 'V': traj_vel = atof(optarg); break;
+	case 'A': traj_acc = atof(optarg); break;
+	case 'd': emcmotConfig->arcBlendOptDepth = atoi(optarg); break;
+	case 'n': emcmotConfig->arcBlendEnable = 0; break;
+	case 'g': emcmotConfig->arcBlendGapCycles = atoi(optarg); break;
+	case 'r': emcmotConfig->arcBlendRampFreq = atof(optarg); break;
+	case 'L': chain.path.lines_only = 1; break;
+	case 'o':
+	    profile = fopen(optarg, "w");
+	    if (!profile) {
+		perror(optarg);
+		return 1;
+	    }
+	    break;
+	case 's': every = atoi(optarg); break;
+	default: usage();
+	}
+    }
+    if (optind < argc) {
+	in = fopen(argv[optind], "r");
+	if (!in) {
+	    perror(argv[optind]);
+	    return 1;
+	}
+    }
+    if (period <= 0.0 || every < 1) {
+	usage();
+    }
+    for (n = 0; n < SIM_AXES; n++) {
+	traj_vel = traj_vel > 0.0 ? traj_vel : fmax(traj_vel, axis_vel[n]);
+	traj_acc = traj_acc > 0.0 ? traj_acc : fmax(traj_acc, axis_acc[n]);
+	emcmotDebug->axes[n].vel_limit = axis_vel[n];
+	emcmotDebug->axes[n].acc_limit = axis_acc[n];
+    }
+    canon.units = 1.0;
+    canon.term_cond = TC_TERM_COND_PARABOLIC;
+
+    tp = &emcmotDebug->coord_tp;
+    period_ns = period * 1e9 + 0.5;
+    if (tpCreate(tp, DEFAULT_TC_QUEUE_SIZE, emcmotDebug->queueTcSpace) < 0) {
+	fprintf(stderr, "tpsim: can't create planner\n");
+	return 1;
+    }
+    tpSetCycleTime(tp, period);
+    tpSetPos(tp, &canon.pos);
+    tpSetVmax(tp, traj_vel, traj_vel);
+    tpSetVlimit(tp, traj_vel);
+    tpSetAmax(tp, traj_acc);
+
+    start = now();
+    while (more || !tpIsDone(tp)) {
+	/* keep the queue topped up the way task does */
+	while (more && !canon.sync && !tcqFull(&tp->queue)) {
+	    more = read_canon(in);
+	}
+	if (canon.sync && tpIsDone(tp)) {
+	    stats.dwell += canon.wait;
+	    canon.wait = 0.0;
+	    canon.sync = 0;
+	    continue;
+	}
+	tpRunCycle(tp, period_ns);
+	stats.cycles++;
+	sample(profile, every);
+    }
+    elapsed = now() - start;
+    total = stats.cycles * period + stats.dwell;
+    tpGetPos(tp, &end);
+    pose_to_array(&end, pos);
+    pose_to_array(&canon.pos, want);
+    for (n = 0; n < SIM_AXES; n++) {
+	if (fabs(pos[n] - want[n]) > 1e-6) {
+	    fprintf(stderr, "tpsim: %c ended at %.6f instead of %.6f\n",
+		axis_names[n], pos[n], want[n]);
+	    failed = 1;
+	}
+    }
+
+    printf("program time   %.3f s (%ld periods of %g s, %.3f s dwell)\n",
+	total, stats.cycles, period, stats.dwell);
+    printf("moves          %ld traverse, %ld feed, %ld arc",
+	stats.queued[0], stats.queued[1], stats.queued[2] - stats.splines);
+    if (stats.splines) {
+	printf(", %ld spline", stats.splines);
+    }
+    if (stats.skipped) {
+	printf(", %ld not simulated", stats.skipped);
+    }
+    if (stats.joined[0] || stats.joined[1]) {
+	printf("\njoined         %ld feeds into lines, %ld into arcs",
+	    stats.joined[0], stats.joined[1]);
+    }
+    printf("\nsegment ends   %ld stop, %ld exact, %ld parabolic, %ld tangent\n",
+	stats.ended[TC_TERM_COND_STOP], stats.ended[TC_TERM_COND_EXACT],
+	stats.ended[TC_TERM_COND_PARABOLIC], stats.ended[TC_TERM_COND_TANGENT]);
+    printf("arc blends     %ld\n", stats.arc_blends);
+    printf("peak speed     %.4f/s, acceleration %.4f/s^2\n",
+	stats.peak_speed, stats.peak_accel);
+    printf("axis  peak vel     limit  peak acc     limit  periods over\n");
+    for (n = 0; n < SIM_AXES; n++) {
+	if (stats.peak_vel[n] == 0.0) {
+	    continue;
+	}
+	printf("%c    %9.4f %9.4f %9.4f %9.4f  %ld\n", axis_names[n],
+	    stats.peak_vel[n], axis_vel[n], stats.peak_acc[n], axis_acc[n],
+	    stats.vel_over[n] + stats.acc_over[n]);
+    }
+    printf("simulated in   %.3f s (%.2f us per period)\n", elapsed,
+	stats.cycles ? elapsed / stats.cycles * 1e6 : 0.0);
+    if (profile) {
+	fclose(profile);
+    }
+    return failed;
+}